@@ -128,6 +128,7 @@ DistanceToFeatures(int AnnoFileID,				// annotated file identifer
 				   char FiltStrand,				// only interested in distances to nearest feature which is on this strand
 				   int ROIChromID,				// ROI is on this chromosome
 				   char *pszROIChrom,			// ROI chrom name
+				   CBEDSweep *pSweep,			// sweeping features on ROI chromosome
 				    tsROI *pROI);
 
 
@@ -1026,6 +1027,8 @@ tsChromCnts *pChrom;
 int ChromID;
 int ROIidx;
 tsROI *pROI;
+int SweepChromID;
+CBEDSweep DistSweep;				// ROIs are ordered by chromosome and start so features are merge swept against the ROIs
 
 if(m_pDistBEDFile != NULL)
 	{
@@ -1062,6 +1065,7 @@ if(bFirst == true && FMode == eFMbed)
 	}
 
 BuffIdx = 0;
+SweepChromID = 0;
 pROI = m_pROIs;
 for(ROIidx = 0; ROIidx < m_NumOfROIs; ROIidx++,pROI++)
 	{
@@ -1074,7 +1078,17 @@ for(ROIidx = 0; ROIidx < m_NumOfROIs; ROIidx++,pROI++)
 	switch(FMode) {
 		case eFMsumCSV:
 		case eFMallCSV:
-			DistanceToFeatures(AnnoFileID,FeatDistStrand,ChromID,pChrom->szChrom,pROI);
+			if(ChromID > 0 && ChromID != SweepChromID)
+				{
+				if((Rslt = DistSweep.Init(m_pDistBEDFile,ChromID)) != eBSFSuccess)
+					{
+					gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to initialise feature sweep on '%s'",pChrom->szChrom);
+					Reset();
+					return(Rslt);
+					}
+				SweepChromID = ChromID;
+				}
+			DistanceToFeatures(AnnoFileID,FeatDistStrand,ChromID,pChrom->szChrom,&DistSweep,pROI);
 			if(FMode == eFMallCSV)
 				{
 				BuffIdx+=sprintf(&szLineBuff[BuffIdx],"%d,\"ROI\",\"%s\",\"%s\",%d,%d,%d,\"%c\",\"%s\",\"%c\",%d,\"%s\",\"%s\",\"%c\",%d,\"%s\",%1.3f\n",
@@ -1422,6 +1436,7 @@ DistanceToFeatures(int AnnoFileID,				// annotated file identifer
 				   char FiltStrand,				// only interested in distances to nearest feature which is on this strand
 				   int ROIChromID,				// ROI is on this chromosome
 				   char *pszROIChrom,			// ROI chrom name
+				   CBEDSweep *pSweep,			// sweeping features on ROI chromosome
 				   tsROI *pROI)
 {
 int Rslt;
@@ -1431,7 +1446,6 @@ int FeatEnd;
 char FeatStrand;
 char szFeatChrom[cMaxDatasetSpeciesChrom+1];
 char szFeatName[cMaxGeneNameLen+1];
-int Nth;
 
 // assume unable to locate a nearby feature
 if(pROI->USFeatDist < 0)
@@ -1452,12 +1466,10 @@ if(m_pDistBEDFile == NULL || ROIChromID < 1)
 	return(false);
 
 // check if contained or even partially overlapping a feature
-Nth = 0;
-while((FeatID = m_pDistBEDFile->LocateFeatureIDinRangeOnChrom(ROIChromID,pROI->StartOfRegion,pROI->EndOfRegion,++Nth)) > 0)
+if(pSweep->Overlaps(pROI->StartOfRegion,pROI->EndOfRegion,FiltStrand) > 0)
 	{
+	FeatID = pSweep->OverlapIDs()[0];
 	Rslt = m_pDistBEDFile->GetFeature(FeatID,szFeatName,szFeatChrom,&FeatStart,&FeatEnd,NULL,&FeatStrand);
-	if(FiltStrand != '*' && FeatStrand != FiltStrand)
-		continue;
 	pROI->DSFeatFileID = AnnoFileID;
 	pROI->USFeatFileID = AnnoFileID;
 	pROI->USFeatDist = 0;
@@ -1471,7 +1483,7 @@ while((FeatID = m_pDistBEDFile->LocateFeatureIDinRangeOnChrom(ROIChromID,pROI->S
 
 // now check for feature which is on strand and downstream of the ROI
 Rslt = -1;
-if((FeatID = m_pDistBEDFile->LocateFeatureAfter(ROIChromID,pROI->EndOfRegion)) > 0)
+if((FeatID = pSweep->FeatureAfter(pROI->EndOfRegion)) > 0)
 	{
 	// determine feature strand and start loci
 	while((Rslt = m_pDistBEDFile->GetFeature(FeatID,szFeatName,szFeatChrom,&FeatStart,NULL,NULL,&FeatStrand))==0)
@@ -1505,7 +1517,8 @@ if(FeatID < 0 || Rslt < 0)
 	return(false);
 
 // now check for feature which is upstream of ROI
-if((FeatID = m_pDistBEDFile->LocateFeatureBefore(ROIChromID,pROI->StartOfRegion)) > 0)
+FeatID = pROI->StartOfRegion > 0 ? pSweep->FeatureBefore(pROI->StartOfRegion) : eBSFerrFeature;
+if(FeatID > 0)
 	{
 	// determine feature strand and end loci
 	while(FeatID > 0 && (Rslt = m_pDistBEDFile->GetFeature(FeatID,szFeatName,szFeatChrom,NULL,&FeatEnd,NULL,&FeatStrand))==0)
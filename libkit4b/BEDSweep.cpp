@@ -0,0 +1,323 @@
+/*
+This toolkit is a source base clone of 'BioKanga' release 4.4.2 (https://github.com/csiro-crop-informatics/biokanga) and contains
+significant source code changes enabling new functionality and resulting process parameterisation changes. These changes have resulted in
+incompatibility with 'BioKanga'.
+
+Because of the potential for confusion by users unaware of functionality and process parameterisation changes then the modified source base
+and resultant compiled executables have been renamed to 'kit4b' - K-mer Informed Toolkit for Bioinformatics.
+The renaming will force users of the 'BioKanga' toolkit to examine scripting which is dependent on existing 'BioKanga'
+parameterisations so as to make appropriate changes if wishing to utilise 'kit4b' parameterisations and functionality.
+
+'kit4b' is being released under the Opensource Software License Agreement (GPLv3)
+'kit4b' is Copyright (c) 2019, 2020
+Please contact Dr Stuart Stephen < stuartjs@g3web.com > if you have any questions regarding 'kit4b'.
+
+Original 'BioKanga' copyright notice has been retained and immediately follows this notice..
+*/
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+// Merge sweep of query ranges against the features on a single CBEDfile chromosome
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include "./commhdrs.h"
+#else
+#include "./commhdrs.h"
+#endif
+
+CBEDSweep::CBEDSweep(void)
+{
+m_pActive = NULL;
+m_pOverlaps = NULL;
+Reset();
+}
+
+CBEDSweep::~CBEDSweep(void)
+{
+Reset();
+}
+
+void
+CBEDSweep::Reset(void)
+{
+if(m_pActive != NULL)
+	{
+	delete []m_pActive;
+	m_pActive = NULL;
+	}
+if(m_pOverlaps != NULL)
+	{
+	delete []m_pOverlaps;
+	m_pOverlaps = NULL;
+	}
+m_pBED = NULL;
+m_ChromID = 0;
+m_FirstFeatID = 0;
+m_LastFeatID = -1;
+m_MaxFeatLen = 0;
+m_MinScore = 0;
+m_MaxScore = 0;
+m_NxtFeatID = 0;
+m_PrevStartOfs = INT_MAX;
+m_NumActive = 0;
+m_AllocActive = 0;
+m_NumOverlaps = 0;
+m_AllocOverlaps = 0;
+}
+
+teBSFrsltCodes
+CBEDSweep::Init(CBEDfile *pBED,		// sweep features from this loaded BED file
+				int ChromID)		// which are on this chromosome
+{
+teBSFrsltCodes Rslt;
+int NumFeatures;
+
+m_pBED = NULL;
+m_NumActive = 0;
+m_NumOverlaps = 0;
+m_PrevStartOfs = INT_MAX;			// forces a restart on first query
+if(pBED == NULL)
+	return(eBSFerrParams);
+if((Rslt = pBED->GetChromosome(ChromID,NULL,&NumFeatures,&m_FirstFeatID,&m_LastFeatID,&m_MaxFeatLen)) != eBSFSuccess)
+	return(Rslt);
+if(NumFeatures < 1)					// no features on this chromosome, sweep will never return any features
+	{
+	m_FirstFeatID = 1;
+	m_LastFeatID = 0;
+	}
+m_pBED = pBED;
+m_ChromID = ChromID;
+m_MinScore = pBED->GetMinScore();
+m_MaxScore = pBED->GetMaxScore();
+m_NxtFeatID = m_FirstFeatID;
+
+if(m_pActive == NULL)
+	{
+	if((m_pActive = new tsBEDSweepActive [cAllocBEDSweepActive]) == NULL)
+		return(eBSFerrMem);
+	m_AllocActive = cAllocBEDSweepActive;
+	}
+if(m_pOverlaps == NULL)
+	{
+	if((m_pOverlaps = new int [cAllocBEDSweepActive]) == NULL)
+		return(eBSFerrMem);
+	m_AllocOverlaps = cAllocBEDSweepActive;
+	}
+return(eBSFSuccess);
+}
+
+// Accepted
+// Features are accepted using the same score and filter flag criteria as the CBEDfile overlap cursor defaults
+bool
+CBEDSweep::Accepted(int FeatID,		// returns true if feature is accepted by sweep
+				int *pStart,		// returned feature start
+				int *pEnd,			// returned feature end
+				char *pStrand)		// returned feature strand
+{
+int Score;
+if(m_pBED->GetFeature(FeatID,NULL,NULL,pStart,pEnd,&Score,pStrand) != eBSFSuccess)
+	return(false);
+if(Score < m_MinScore || Score > m_MaxScore)
+	return(false);
+return(m_pBED->Filter(FeatID,cFeatFiltIn) && !m_pBED->Filter(FeatID,cFeatFiltOut));
+}
+
+// LocateStartAfter
+// Binary search for first feature, accepted or not, which starts after Ofs
+int
+CBEDSweep::LocateStartAfter(int Ofs)
+{
+int LoFeatID;
+int HiFeatID;
+int MidFeatID;
+int Start;
+
+LoFeatID = m_FirstFeatID;
+HiFeatID = m_LastFeatID + 1;
+while(LoFeatID < HiFeatID)
+	{
+	MidFeatID = LoFeatID + (HiFeatID - LoFeatID) / 2;
+	m_pBED->GetFeature(MidFeatID,NULL,NULL,&Start);
+	if(Start > Ofs)
+		HiFeatID = MidFeatID;
+	else
+		LoFeatID = MidFeatID + 1;
+	}
+return(LoFeatID);
+}
+
+// Restart
+// Clears active set and restarts the sweep at the first feature which could overlap StartOfs
+// Features starting more than the maximum feature length before StartOfs must end before StartOfs
+void
+CBEDSweep::Restart(int StartOfs)
+{
+m_NumActive = 0;
+if(StartOfs <= m_MaxFeatLen)
+	m_NxtFeatID = m_FirstFeatID;
+else
+	m_NxtFeatID = LocateStartAfter(StartOfs - m_MaxFeatLen - 1);
+}
+
+bool
+CBEDSweep::PushActive(tsBEDSweepActive *pFeat)
+{
+tsBEDSweepActive *pTmp;
+int Idx;
+int ParentIdx;
+
+if(m_NumActive == m_AllocActive)
+	{
+	if((pTmp = new tsBEDSweepActive [m_AllocActive + cAllocBEDSweepActive]) == NULL)
+		return(false);
+	memcpy(pTmp,m_pActive,sizeof(tsBEDSweepActive) * m_NumActive);
+	delete []m_pActive;
+	m_pActive = pTmp;
+	m_AllocActive += cAllocBEDSweepActive;
+	}
+
+Idx = m_NumActive++;
+while(Idx > 0)
+	{
+	ParentIdx = (Idx - 1) / 2;
+	if(m_pActive[ParentIdx].End <= pFeat->End)
+		break;
+	m_pActive[Idx] = m_pActive[ParentIdx];
+	Idx = ParentIdx;
+	}
+m_pActive[Idx] = *pFeat;
+return(true);
+}
+
+void
+CBEDSweep::PopActive(void)
+{
+tsBEDSweepActive *pLast;
+int Idx;
+int ChildIdx;
+
+if(m_NumActive == 0)
+	return;
+pLast = &m_pActive[--m_NumActive];
+Idx = 0;
+while((ChildIdx = (Idx * 2) + 1) < m_NumActive)
+	{
+	if(ChildIdx + 1 < m_NumActive && m_pActive[ChildIdx + 1].End < m_pActive[ChildIdx].End)
+		ChildIdx += 1;
+	if(pLast->End <= m_pActive[ChildIdx].End)
+		break;
+	m_pActive[Idx] = m_pActive[ChildIdx];
+	Idx = ChildIdx;
+	}
+m_pActive[Idx] = *pLast;
+}
+
+int
+CBEDSweep::Overlaps(int StartOfs,	// query starts at this offset, queries should be in ascending start order
+				int EndOfs,			// query ends at this offset
+				char Strand)		// features must be on this strand, '*' if either strand
+{
+tsBEDSweepActive Feat;
+tsBEDSweepActive *pActive;
+int *pTmp;
+int Idx;
+int InsIdx;
+int FeatID;
+
+m_NumOverlaps = 0;
+if(m_pBED == NULL)
+	return(eBSFerrInternal);
+if(StartOfs > EndOfs)
+	return(eBSFerrParams);
+
+if(StartOfs < m_PrevStartOfs)
+	Restart(StartOfs);
+m_PrevStartOfs = StartOfs;
+
+// add features starting on or before the query end, features which have already ended can never overlap this or any subsequent query
+while(m_NxtFeatID <= m_LastFeatID)
+	{
+	m_pBED->GetFeature(m_NxtFeatID,NULL,NULL,&Feat.Start);
+	if(Feat.Start > EndOfs)
+		break;
+	Feat.FeatID = m_NxtFeatID++;
+	if(!Accepted(Feat.FeatID,&Feat.Start,&Feat.End,&Feat.Strand) || Feat.End < StartOfs)
+		continue;
+	if(!PushActive(&Feat))
+		return(eBSFerrMem);
+	}
+
+// retire features ending before the query start
+while(m_NumActive > 0 && m_pActive[0].End < StartOfs)
+	PopActive();
+
+// active features may have been added by a previous query extending past this query end
+if(m_NumActive > m_AllocOverlaps)
+	{
+	if((pTmp = new int [m_NumActive + cAllocBEDSweepActive]) == NULL)
+		return(eBSFerrMem);
+	delete []m_pOverlaps;
+	m_pOverlaps = pTmp;
+	m_AllocOverlaps = m_NumActive + cAllocBEDSweepActive;
+	}
+pActive = m_pActive;
+for(Idx = 0; Idx < m_NumActive; Idx++, pActive++)
+	{
+	if(pActive->Start > EndOfs || (Strand != '*' && Strand != pActive->Strand))
+		continue;
+	FeatID = pActive->FeatID;
+	for(InsIdx = m_NumOverlaps; InsIdx > 0 && m_pOverlaps[InsIdx - 1] > FeatID; InsIdx--)
+		m_pOverlaps[InsIdx] = m_pOverlaps[InsIdx - 1];
+	m_pOverlaps[InsIdx] = FeatID;
+	m_NumOverlaps += 1;
+	}
+return(m_NumOverlaps);
+}
+
+int *
+CBEDSweep::OverlapIDs(void)
+{
+return(m_pOverlaps);
+}
+
+int
+CBEDSweep::FeatureAfter(int Ofs,		// feature starts after this offset
+				char Strand)			// feature must be on this strand, '*' if either strand
+{
+int FeatID;
+int Start;
+int End;
+char FeatStrand;
+
+if(m_pBED == NULL)
+	return(0);
+for(FeatID = LocateStartAfter(Ofs); FeatID <= m_LastFeatID; FeatID++)
+	if(Accepted(FeatID,&Start,&End,&FeatStrand) && (Strand == '*' || Strand == FeatStrand))
+		return(FeatID);
+return(0);
+}
+
+int
+CBEDSweep::FeatureBefore(int Ofs,		// feature starts on or before this offset
+				char Strand)			// feature must be on this strand, '*' if either strand
+{
+int FeatID;
+int Start;
+int End;
+char FeatStrand;
+
+if(m_pBED == NULL)
+	return(0);
+for(FeatID = LocateStartAfter(Ofs) - 1; FeatID >= m_FirstFeatID; FeatID--)
+	if(Accepted(FeatID,&Start,&End,&FeatStrand) && (Strand == '*' || Strand == FeatStrand))
+		return(FeatID);
+return(0);
+}
@@ -0,0 +1,75 @@
+#pragma once
+// Merge sweep of query ranges against the features on a single CBEDfile chromosome
+// Features are walked in chromosome start order together with the queries, features which could overlap the current query are held in an
+// active set ordered as a min heap on feature end so features are retired as soon as a query starts past their end
+// Queries should be presented in ascending start order, a query starting before the previous query restarts the sweep at the earliest feature
+// which could overlap that query
+// Features are accepted by the sweep if their score is within the CBEDfile score thresholds, they have cFeatFiltIn and do not have cFeatFiltOut set
+// Only read only CBEDfile accessors are used so multiple instances can sweep concurrently, one instance per thread, over the same CBEDfile
+
+const int cAllocBEDSweepActive = 1000;		// active set allocation increments
+
+#pragma pack(4)
+typedef struct TAG_sBEDSweepActive {
+	int32_t End;						// feature ends at this chromosome offset, active set heap is ordered on this
+	int32_t Start;						// feature starts at this chromosome offset
+	int32_t FeatID;						// feature identifier
+	char Strand;						// feature is on this strand
+	} tsBEDSweepActive;
+#pragma pack()
+
+class CBEDSweep
+{
+	CBEDfile *m_pBED;					// features from this BED file
+	int m_ChromID;						// are on this chromosome
+	int m_FirstFeatID;					// identifier of first feature on chromosome
+	int m_LastFeatID;					// identifier of last feature on chromosome
+	int m_MaxFeatLen;					// maximum length of any feature on chromosome
+	int m_MinScore;						// features accepted if score at least this
+	int m_MaxScore;						// and no more than this
+
+	int m_NxtFeatID;					// next feature, in start order, to be considered for the active set
+	int m_PrevStartOfs;					// start of previous query
+
+	int m_NumActive;					// number of features in active set
+	int m_AllocActive;					// active set allocated to hold this many features
+	tsBEDSweepActive *m_pActive;		// active set
+
+	int m_NumOverlaps;					// number of features overlapping last query
+	int m_AllocOverlaps;				// m_pOverlaps allocated to hold this many identifiers
+	int *m_pOverlaps;					// identifiers of features overlapping last query
+
+	bool Accepted(int FeatID,			// returns true if feature is accepted by sweep
+				int *pStart,			// returned feature start
+				int *pEnd,				// returned feature end
+				char *pStrand);			// returned feature strand
+
+	int LocateStartAfter(int Ofs);		// returns identifier of first feature on chromosome starting after Ofs, m_LastFeatID+1 if none
+	void Restart(int StartOfs);			// restart sweep at earliest feature which could overlap StartOfs
+	bool PushActive(tsBEDSweepActive *pFeat);	// add feature to active set
+	void PopActive(void);				// remove feature with lowest end from active set
+
+public:
+	CBEDSweep(void);
+	~CBEDSweep(void);
+
+	void Reset(void);					// release active set and overlap memory
+
+	teBSFrsltCodes Init(CBEDfile *pBED,	// sweep features from this loaded BED file
+				int ChromID);			// which are on this chromosome
+
+	int									// returns number of features overlapping StartOfs..EndOfs, < 0 if errors
+		Overlaps(int StartOfs,			// query starts at this offset, queries should be in ascending start order
+				int EndOfs,				// query ends at this offset
+				char Strand = '*');		// features must be on this strand, '*' if either strand
+
+	int *OverlapIDs(void);				// identifiers, ascending, of the features overlapping last Overlaps() query
+
+	int									// returns identifier of first feature starting after Ofs, 0 if none
+		FeatureAfter(int Ofs,			// feature starts after this offset
+				char Strand = '*');		// feature must be on this strand, '*' if either strand
+
+	int									// returns identifier of last feature starting on or before Ofs, 0 if none
+		FeatureBefore(int Ofs,			// feature starts on or before this offset
+				char Strand = '*');		// feature must be on this strand, '*' if either strand
+};
@@ -29,6 +29,42 @@ Original 'BioKanga' copyright notice has been retained and immediately follows t
 #include "./commhdrs.h"
 #endif
 
+// cursor retained between consecutive LocateFeatureIDinRangeOnChrom() calls so that callers incrementing Ith continue,
+// rather than restart, the iteration; thread local as instances may be concurrently queried by multiple threads
+typedef struct TAG_sBEDIthCursor {
+	uint32_t OverlapIdxGen;				// cursor was initialised against this overlap index generation, 0 if cursor not initialised
+	int32_t MinScore;					// score and strand filtering when cursor was initialised
+	int32_t MaxScore;
+	char OnStrand;
+	int32_t Ith;						// number of overlapping features returned from cursor
+	int32_t FeatID;						// feature identifier of the Ith overlapping feature
+	bool bNoMore;						// true if cursor has no more overlapping features
+	tsBEDOverlapCursor Cursor;			// iteration cursor
+} tsBEDIthCursor;
+
+#ifdef _WIN32
+static __declspec(thread) tsBEDIthCursor gIthCursor = {0};
+#else
+static __thread tsBEDIthCursor gIthCursor = {0};
+#endif
+
+static uint32_t gNxtOverlapIdxGen = 0;		// overlap index generations are unique over all instances
+
+static uint32_t
+NxtOverlapIdxGen(void)
+{
+uint32_t Gen;
+do {
+#ifdef _WIN32
+	Gen = (uint32_t)InterlockedIncrement((volatile unsigned int *)&gNxtOverlapIdxGen);
+#else
+	Gen = __sync_add_and_fetch(&gNxtOverlapIdxGen,1);
+#endif
+	}
+while(Gen == 0);
+return(Gen);
+}
+
 tsGFF3FeatureType GFF3FeatureTypes[] = { // GFF3 file gene feature regions which will be parsed and accepted for subsequent processing 
 	{eGFF3FTgene,"gene"},
 	{eGFF3FTmRNA,"mRNA"},
@@ -53,6 +89,8 @@ m_pChromNames = NULL;		// pts to array of tsBEDchromname's sorted by chromid
 m_pFeatures = NULL;			// pts to array of tsBEDfeature's sorted by name-->chromid-->start-->end
 m_ppFeatureNames = NULL; // sorted (by name->chrom->start->end) array of ptrs into m_pFeatures
 m_ppFeatureChromStarts = NULL; // sorted (by chrom->start->end) array of ptrs into m_pFeatures
+m_pFeatMaxEnds = NULL;		// overlap index
+m_OverlapIdxGen = 0;
 m_pChromHashes = NULL;
 m_pFeatBM = nullptr;
 m_hFile = -1;
@@ -74,7 +112,9 @@ if(_lseeki64(m_hFile,0,SEEK_SET)!=0)			// read in header..
 	return(eBSFerrFileAccess);
 	}
 
-if(sizeof(tsBEDFileHdr) != read(m_hFile,&m_FileHdr,sizeof(tsBEDFileHdr)))
+// files prior to version 13 have a shorter header, without FeatureMaxEndsOfs, so accept a short read of that header
+memset(&m_FileHdr,0,sizeof(tsBEDFileHdr));
+if((int)offsetof(tsBEDFileHdr,FeatureMaxEndsOfs) > read(m_hFile,&m_FileHdr,sizeof(tsBEDFileHdr)))
 	{
 	AddErrMsg("CBEDfile::Disk2Hdr","Read of file header failed on %s - %s",pszBioBed,strerror(errno));
 	Reset(false);			// closes opened file..
@@ -111,6 +151,7 @@ if(m_bIsBigEndian)	// file was written with little-endian ordering
 	m_FileHdr.FeatType  = SwapUI32Endians(m_FileHdr.FeatType);				// what type of features are in this file
 	m_FileHdr.FeaturesSize  = SwapUI32Endians(m_FileHdr.FeaturesSize);		// disk/memory space required to hold concatenated Features
 	m_FileHdr.ChromNamesSize  = SwapUI32Endians(m_FileHdr.ChromNamesSize);	// disk/memory space required to hold concatenated chromosome names
+	m_FileHdr.FeatureMaxEndsOfs = SwapUI64Endians(m_FileHdr.FeatureMaxEndsOfs);	// file offset to overlap index max ends
 	}
 
 	// check bioseq file is the type we are expecting
@@ -136,6 +177,10 @@ if(m_FileHdr.Version > cBSFeatVersion || m_FileHdr.Version < cBSFFeatVersionBack
 	Reset(false);			// closes opened file..
 	return(eBSFerrFileVer);
 	}
+
+// earlier versions have no overlap index, it will be built after the features are loaded
+if(m_FileHdr.Version < cMinBEDOverlapIdxVersion)
+	m_FileHdr.FeatureMaxEndsOfs = 0;
 return(eBSFSuccess);
 }
 
@@ -166,6 +211,7 @@ if(m_bIsBigEndian)	// if on a big-endian machine then need to make little endian
 	FileHdr.FeatType  = SwapUI32Endians(m_FileHdr.FeatType);				// what type of features are in this file
 	FileHdr.FeaturesSize  = SwapUI32Endians(m_FileHdr.FeaturesSize);		// disk/memory space required to hold concatenated Features
 	FileHdr.ChromNamesSize  = SwapUI32Endians(m_FileHdr.ChromNamesSize);	// disk/memory space required to hold concatenated chromosome names
+	FileHdr.FeatureMaxEndsOfs = SwapUI64Endians(m_FileHdr.FeatureMaxEndsOfs);	// file offset to overlap index max ends
 	pHdr = &FileHdr;
 	}
 else
@@ -231,6 +277,13 @@ if(m_ppFeatureChromStarts != NULL)
 	m_ppFeatureChromStarts = NULL;
 	}
 
+if(m_pFeatMaxEnds != NULL)
+	{
+	delete []m_pFeatMaxEnds;
+	m_pFeatMaxEnds = NULL;
+	}
+m_OverlapIdxGen = 0;
+
 if(m_pFeatBM != nullptr)
 	{
 	delete []m_pFeatBM;
@@ -1542,6 +1595,12 @@ if(m_ppFeatureChromStarts != NULL)
 	delete []m_ppFeatureChromStarts;
 	m_ppFeatureChromStarts = NULL;
 	}
+if(m_pFeatMaxEnds != NULL)
+	{
+	delete []m_pFeatMaxEnds;
+	m_pFeatMaxEnds = NULL;
+	}
+m_OverlapIdxGen = 0;
 
 
 #ifdef _WIN32
@@ -1553,6 +1612,7 @@ NumThreads = sysconf(_SC_NPROCESSORS_CONF);
 #endif
 NumThreads = min(8,NumThreads);
 m_mtqsort.SetMaxThreads(NumThreads);
+m_MTRadixSort.SetMaxThreads(NumThreads);
 
 // sort chromosome names into ascending order
 m_mtqsort.qsort(m_pChromNames,m_FileHdr.NumChroms,sizeof(tsBEDchromname),SortChromNames);
@@ -1603,7 +1663,8 @@ for(FeatureID = 0; FeatureID < m_FileHdr.NumFeatures; FeatureID++)
 	m_ppFeatureNames[FeatureID] = pFeature;
 	pFeature = (tsBEDfeature *)(((char *)pFeature) + pFeature->Size);
 	}
-m_mtqsort.qsort(m_ppFeatureNames,m_FileHdr.NumFeatures,sizeof(tsBEDfeature *),SortFeatureNames);
+if(m_MTRadixSort.MergeSort(m_ppFeatureNames,m_FileHdr.NumFeatures,sizeof(tsBEDfeature *),SortFeatureNames) < eBSFSuccess)
+	m_mtqsort.qsort(m_ppFeatureNames,m_FileHdr.NumFeatures,sizeof(tsBEDfeature *),SortFeatureNames);
 
 // now that they are sorted then determine the number of name instances
 NameInst = 1;
@@ -1640,7 +1701,10 @@ for(FeatureID = 0; FeatureID < m_FileHdr.NumFeatures; FeatureID++)
 	m_ppFeatureChromStarts[FeatureID] = pFeature;
 	pFeature = (tsBEDfeature *)(((char *)pFeature) + pFeature->Size);
 	}
-m_mtqsort.qsort(m_ppFeatureChromStarts,m_FileHdr.NumFeatures,sizeof(tsBEDfeature *),SortChromStarts);
+// radix sort is stable so sort on least significant key first, if unable to allocate radix sort working memory then fall back to qsort
+if(m_MTRadixSort.Sort(m_ppFeatureChromStarts,m_FileHdr.NumFeatures,sizeof(tsBEDfeature *),RadixKeyEndNameInst) < eBSFSuccess ||
+	m_MTRadixSort.Sort(m_ppFeatureChromStarts,m_FileHdr.NumFeatures,sizeof(tsBEDfeature *),RadixKeyChromStart) < eBSFSuccess)
+	m_mtqsort.qsort(m_ppFeatureChromStarts,m_FileHdr.NumFeatures,sizeof(tsBEDfeature *),SortChromStarts);
 
 
 // make the feature ids map to the chrom start indexes, determine per chromosome maximum feature lengths/number of features
@@ -1661,10 +1725,111 @@ for(Idx = 0; Idx < m_FileHdr.NumFeatures; Idx++)
 	if(FeatLen > pChrom->MaxFeatLen)
 		pChrom->MaxFeatLen = FeatLen;
 	}
+
+if(BuildOverlapIndex() != eBSFSuccess)
+	{
+	delete []m_ppFeatureNames;
+	m_ppFeatureNames = NULL;
+	delete []m_ppFeatureChromStarts;
+	m_ppFeatureChromStarts = NULL;
+	return(eBSFerrMem);
+	}
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Sort optimisation completed");
 return(eBSFSuccess);
 }
 
+// OverlapIndexLevels
+// Returns the level of the root node in the implicit interval tree over a chromosome's NumFeatures start sorted features
+// Tree nodes at level K are those features at indexes with the lowest K bits set and bit K clear, the root being at index (1 << K) - 1
+int
+CBEDfile::OverlapIndexLevels(int NumFeatures)
+{
+int Level;
+for(Level = 0; (2 << Level) <= NumFeatures && Level < 30; Level++);
+return(Level);
+}
+
+// BuildOverlapIndex
+// Builds the overlap index as an implicit augmented interval tree, separately for each chromosome, over the features sorted by chrom->start->end
+// For each feature the index holds the maximum feature end over the subtree rooted at that feature
+// Subtrees with a max end before the query start can then be skipped so overlap queries are O(log(n) + number of overlaps)
+teBSFrsltCodes
+CBEDfile::BuildOverlapIndex(void)
+{
+int ChromIdx;
+int Idx;
+int Level;
+int NodeIdx;
+int Step;
+int NumFeats;
+int LastIdx;
+int32_t LastMaxEnd;
+int32_t MaxEnd;
+int32_t *pMaxEnds;
+tsBEDfeature **ppFeats;
+tsBEDchromname *pChrom;
+
+if(m_pFeatMaxEnds != NULL)
+	{
+	delete []m_pFeatMaxEnds;
+	m_pFeatMaxEnds = NULL;
+	}
+m_OverlapIdxGen = 0;
+if(!m_FileHdr.NumFeatures || m_ppFeatureChromStarts == NULL)
+	return(eBSFerrNoFeatures);
+
+if((m_pFeatMaxEnds = new int32_t [m_FileHdr.NumFeatures])==NULL)
+	{
+	AddErrMsg("CBEDfile::BuildOverlapIndex","Unable to alloc memory to hold %d feature max ends",m_FileHdr.NumFeatures);
+	return(eBSFerrMem);
+	}
+m_OverlapIdxGen = NxtOverlapIdxGen();
+
+pChrom = m_pChromNames;
+for(ChromIdx = 0; ChromIdx < m_FileHdr.NumChroms; ChromIdx++, pChrom++)
+	{
+	if((NumFeats = pChrom->NumFeatures) == 0)
+		continue;
+	ppFeats = &m_ppFeatureChromStarts[pChrom->FirstStartID - 1];
+	pMaxEnds = &m_pFeatMaxEnds[pChrom->FirstStartID - 1];
+
+	// leaves, at even indexes, have no children
+	LastIdx = 0;
+	LastMaxEnd = 0;
+	for(Idx = 0; Idx < NumFeats; Idx += 2)
+		{
+		LastIdx = Idx;
+		LastMaxEnd = pMaxEnds[Idx] = ppFeats[Idx]->End;
+		}
+
+	// internal nodes, level by level, with missing right children in an incomplete tree taking the max end of the rightmost node
+	for(Level = 1; (1 << Level) <= NumFeats; Level++)
+		{
+		NodeIdx = 1 << (Level - 1);
+		Step = NodeIdx << 2;
+		for(Idx = (NodeIdx << 1) - 1; Idx < NumFeats; Idx += Step)
+			{
+			MaxEnd = ppFeats[Idx]->End;
+			if(pMaxEnds[Idx - NodeIdx] > MaxEnd)
+				MaxEnd = pMaxEnds[Idx - NodeIdx];
+			if(Idx + NodeIdx < NumFeats)
+				{
+				if(pMaxEnds[Idx + NodeIdx] > MaxEnd)
+					MaxEnd = pMaxEnds[Idx + NodeIdx];
+				}
+			else
+				if(LastMaxEnd > MaxEnd)
+					MaxEnd = LastMaxEnd;
+			pMaxEnds[Idx] = MaxEnd;
+			}
+		LastIdx = ((LastIdx >> Level) & 0x01) ? LastIdx - NodeIdx : LastIdx + NodeIdx;
+		if(LastIdx < NumFeats && pMaxEnds[LastIdx] > LastMaxEnd)
+			LastMaxEnd = pMaxEnds[LastIdx];
+		}
+	}
+return(eBSFSuccess);
+}
+
 bool 
 CBEDfile::SetStrand(char Strand)	// sets globally which strand features must be on in subsequent processing '+'/'-' or '*' for either
 {
@@ -2219,6 +2384,22 @@ if(m_hFile != -1 && m_bCreate)		// if file opened for write
 			}
 		m_FileHdr.FeatureChromStartsOfs = m_FileHdr.FileLen;
 		m_FileHdr.FileLen += WrtLen;
+
+		if(m_bIsBigEndian)
+			{
+			for(Idx = 0; Idx < m_FileHdr.NumFeatures; Idx++)
+				m_pFeatMaxEnds[Idx] = SwapUI32Endians(m_pFeatMaxEnds[Idx]);
+			}
+		WrtLen = m_FileHdr.NumFeatures * sizeof(int32_t);
+		if(_lseeki64(m_hFile,m_FileHdr.FileLen,SEEK_SET) != (int64_t)m_FileHdr.FileLen ||
+			write(m_hFile,m_pFeatMaxEnds,WrtLen)!=WrtLen)
+			{
+			AddErrMsg("CBEDfile::Flush2Disk","Unable to write feature overlap index to disk on file %s - error %s",m_szFile,strerror(errno));
+			Reset(false);
+			return(eBSFerrFileAccess);
+			}
+		m_FileHdr.FeatureMaxEndsOfs = m_FileHdr.FileLen;
+		m_FileHdr.FileLen += WrtLen;
 		}
 
 		// now write the header to disk
@@ -2470,6 +2651,33 @@ if(Rslt == eBSFSuccess)
 			}
 		}
 #pragma warning(pop)
+
+// overlap index is loaded if present, otherwise built from the chrom->start->end sorted features
+if(Rslt == eBSFSuccess)
+	{
+	if(m_FileHdr.FeatureMaxEndsOfs != 0)
+		{
+		if(m_pFeatMaxEnds != NULL)
+			delete []m_pFeatMaxEnds;
+		m_OverlapIdxGen = 0;
+		if((m_pFeatMaxEnds = new int32_t [m_FileHdr.NumFeatures])==NULL)
+			{
+			AddErrMsg("CBEDfile::LoadFeatures","Unable to alloc memory to hold %d feature max ends - %s",m_FileHdr.NumFeatures,m_szFile);
+			Rslt = eBSFerrMem;
+			}
+		else
+			{
+			m_OverlapIdxGen = NxtOverlapIdxGen();
+			Rslt = ReadDisk(m_FileHdr.FeatureMaxEndsOfs,m_FileHdr.NumFeatures * sizeof(int32_t),m_pFeatMaxEnds);
+			if(Rslt == eBSFSuccess && m_bIsBigEndian)
+				for(Idx = 0; Idx < m_FileHdr.NumFeatures; Idx++)
+					m_pFeatMaxEnds[Idx] = SwapUI32Endians(m_pFeatMaxEnds[Idx]);
+			}
+		}
+	else
+		Rslt = BuildOverlapIndex();
+	}
+
 if(bCloseFile)
 	{
 	close(m_hFile);
@@ -3041,7 +3249,8 @@ CBEDfile::GetChromosome(int ChromID,		// chromosome identifier
 					 char *pszChrom,		// where to return chromosome name
 					 int *pNumFeatures,		// where to return number of features on this chromosome
 					 int *pFirstStartID,		// where to return identifier of first feature on this chromosome
-					 int *pLastStartID)		// where to return identifier of last feature on this chromosome
+					 int *pLastStartID,		// where to return identifier of last feature on this chromosome
+					 int *pMaxFeatLen)		// where to return maximum length of any feature on this chromosome
 {
 if(!m_bFeaturesAvail)
 	return(eBSFerrFeature);
@@ -3059,6 +3268,8 @@ if(pFirstStartID != NULL)
 	*pFirstStartID = pChrom->FirstStartID; // start indexes are same as feature identifiers 
 if(pLastStartID != NULL)
 	*pLastStartID = pChrom->LastStartID;
+if(pMaxFeatLen != NULL)
+	*pMaxFeatLen = pChrom->MaxFeatLen;
 return(eBSFSuccess);
 }
 
@@ -3183,130 +3394,220 @@ CBEDfile::LocateFeatureIDonChrom(int ChromID, // feature is on which chromosome
 							 int FiltInFlags, // filter out any features which do not have at least one of the specified filter flags set
 							 int FiltOutFlags) // filter out any features which have at least one of the specified filter flags set
 {
-int StartIdx;
-int EndIdx;
-int StartID;
-tsBEDchromname *pChrom;
-tsBEDfeature *pProbe;
-
 //sanity checks whilst debugging
 #ifdef _DEBUG
 if(OverLapsOfs < 0 || Ith < 1 || ChromID < 1 || ChromID > m_FileHdr.NumChroms)
 	return(eBSFerrParams);
-if(!m_bFeaturesAvail)
-	return(eBSFerrFeature);
-if(ChromID > m_FileHdr.NumChroms)
-	return(eBSFerrChrom);
 #endif
+return(LocateFeatureIDinRangeOnChrom(ChromID,OverLapsOfs,OverLapsOfs,Ith,FiltInFlags,FiltOutFlags));
+}
 
+// LocateFeatureIDinRangeOnChrom
+// Returns the Ith feature, in chrom->start->end order, overlapping the range StartOfs..EndOfs
+// The cursor is retained (per thread) between calls so callers incrementing Ith over the same range continue the iteration
+// instead of restarting it; any other Ith, range, filtering or overlap index change restarts the iteration
+int											  // returned feature identifier
+CBEDfile::LocateFeatureIDinRangeOnChrom(int ChromID, // feature is on which chromosome
+							 int StartOfs,       // feature must end on or after Start
+							 int EndOfs,		  // and start on or before End 
+							 int Ith,		  // Ith instance to return (1..n)
+							 int FiltInFlags, // filter out any features which do not have at least one of the specified filter flags set
+							 int FiltOutFlags) // filter out any features which have at least one of the specified filter flags set
+{
+int Rslt;
+int FeatID;
+tsBEDIthCursor *pIth;
 
-pChrom = LocateChromName(ChromID);
-if(pChrom == NULL)
-	return(eBSFerrChrom);
-if(!pChrom->NumFeatures)
-	return(0);
+// sanity checks whilst debug
+#ifdef _DEBUG
+if(StartOfs < 0 || StartOfs > EndOfs || Ith < 1)
+	return(eBSFerrParams);
+#endif
 
-// determine initial lower limit to start linear search from which is a feature ending before OverLapsOfs
-// search terminates when start > OverLapsOfs
-if(pChrom->NumFeatures > 50 && OverLapsOfs > pChrom->MaxFeatLen) 
+pIth = &gIthCursor;
+if(m_OverlapIdxGen == 0 || pIth->OverlapIdxGen != m_OverlapIdxGen || Ith < pIth->Ith ||
+	pIth->Cursor.ChromID != ChromID || pIth->Cursor.StartOfs != StartOfs || pIth->Cursor.EndOfs != EndOfs ||
+	pIth->Cursor.FiltInFlags != FiltInFlags || pIth->Cursor.FiltOutFlags != FiltOutFlags ||
+	pIth->MinScore != m_MinScore || pIth->MaxScore != m_MaxScore || pIth->OnStrand != m_OnStrand)
 	{
-	StartID = LocateStart(ChromID,OverLapsOfs - pChrom->MaxFeatLen,FiltInFlags,FiltOutFlags);
-	if(StartID == 0)
-		StartIdx = pChrom->FirstStartID - 1;
-	else
-		StartIdx = StartID - 1;
+	pIth->OverlapIdxGen = 0;
+	if((Rslt = InitOverlapCursor(&pIth->Cursor,ChromID,StartOfs,EndOfs,FiltInFlags,FiltOutFlags)) != eBSFSuccess)
+		return(Rslt);
+	pIth->OverlapIdxGen = m_OverlapIdxGen;
+	pIth->MinScore = m_MinScore;
+	pIth->MaxScore = m_MaxScore;
+	pIth->OnStrand = m_OnStrand;
+	pIth->Ith = 0;
+	pIth->FeatID = 0;
+	pIth->bNoMore = false;
 	}
 else
-	StartIdx = pChrom->FirstStartID - 1;
-EndIdx = pChrom->LastStartID - 1;
-while(StartIdx <= EndIdx)
 	{
-	pProbe = m_ppFeatureChromStarts[StartIdx];
-	if(pProbe->Start <= OverLapsOfs &&
-	   pProbe->End >= OverLapsOfs)
-		{
-		if(pProbe->Score < m_MinScore || pProbe->Score > m_MaxScore)
-			continue;
-		if((m_OnStrand != '*' && m_OnStrand != pProbe->Strand) || !(pProbe->FiltFlags & FiltInFlags) || pProbe->FiltFlags & FiltOutFlags)
-			continue;
-		if(--Ith)
-			{
-			return(pProbe->FeatureID);
-			}
-		continue;
-		}
-	if(pProbe->Start > OverLapsOfs)
-		break;
+	if(Ith == pIth->Ith)					// same feature as last returned
+		return(pIth->FeatID);
+	if(pIth->bNoMore)
+		return(0);
 	}
 
-return(0);
+while((FeatID = NextOverlap(&pIth->Cursor)) > 0)
+	{
+	pIth->FeatID = FeatID;
+	if(++pIth->Ith == Ith)
+		break;
+	}
+if(FeatID < 0)
+	pIth->OverlapIdxGen = 0;
+else
+	if(FeatID == 0)
+		pIth->bNoMore = true;
+return(FeatID);
 }
 
-
-int											  // returned feature identifier
-CBEDfile::LocateFeatureIDinRangeOnChrom(int ChromID, // feature is on which chromosome
-							 int StartOfs,       // feature must end on or after Start
-							 int EndOfs,		  // and start on or before End 
-							 int Ith,		  // Ith instance to return (1..n)
+// InitOverlapCursor
+// Initialise cursor ready for iterating, with NextOverlap(), over all features overlapping the range StartOfs..EndOfs
+// Iteration is in a single pass over the overlap index, visiting only those subtrees containing at least one feature ending on or after StartOfs
+teBSFrsltCodes
+CBEDfile::InitOverlapCursor(tsBEDOverlapCursor *pCursor, // cursor to initialise
+							 int ChromID,	  // features are on which chromosome
+							 int StartOfs,    // features must end on or after StartOfs
+							 int EndOfs,	  // and start on or before EndOfs
 							 int FiltInFlags, // filter out any features which do not have at least one of the specified filter flags set
 							 int FiltOutFlags) // filter out any features which have at least one of the specified filter flags set
 {
-int StartIdx;
-int EndIdx;
-int StartID;
-tsBEDfeature *pProbe;
+tsBEDchromname *pChrom;
+int Level;
+
+if(pCursor == NULL)
+	return(eBSFerrParams);
+pCursor->Depth = 0;
+pCursor->ScanIdx = 0;
+pCursor->ScanEndIdx = 0;
+pCursor->NumFeatures = 0;
 
 // sanity checks whilst debug
 #ifdef _DEBUG
-if(StartOfs < 0 || StartOfs > EndOfs || Ith < 1)
+if(StartOfs < 0 || StartOfs > EndOfs)
 	return(eBSFerrParams);
-if(!m_bFeaturesAvail)
+#endif
+if(m_pFeatMaxEnds == NULL)				// index is only available after features have been sorted or loaded
 	return(eBSFerrFeature);
 if(ChromID < 1 || ChromID > m_FileHdr.NumChroms)
 	return(eBSFerrChrom);
-#endif
 
-tsBEDchromname *pChrom = LocateChromName(ChromID);
+pChrom = LocateChromName(ChromID);
 if(pChrom == NULL)
 	return(eBSFerrChrom);
 
-// determine initial lower limit to start linear search from which is a feature ending before StartOfs
-// search terminates when start > StartOfs
-if(pChrom->NumFeatures > 20 && StartOfs > pChrom->MaxFeatLen) 
+pCursor->ChromID = ChromID;
+pCursor->StartOfs = StartOfs;
+pCursor->EndOfs = EndOfs;
+pCursor->FiltInFlags = FiltInFlags;
+pCursor->FiltOutFlags = FiltOutFlags;
+pCursor->FirstIdx = pChrom->FirstStartID - 1;
+pCursor->NumFeatures = pChrom->NumFeatures;
+if(pChrom->NumFeatures > 0)
 	{
-	StartID = LocateStart(ChromID,StartOfs - pChrom->MaxFeatLen,FiltInFlags,FiltOutFlags);
-	if(StartID == 0)
-		StartIdx = pChrom->FirstStartID - 1;
-	else
-		StartIdx = StartID - 1;
+	Level = OverlapIndexLevels(pChrom->NumFeatures);
+	pCursor->Nodes[0].NodeIdx = (1 << Level) - 1;
+	pCursor->Nodes[0].Level = Level;
+	pCursor->Nodes[0].bLeftDone = 0;
+	pCursor->Depth = 1;
 	}
-else
-	StartIdx = pChrom->FirstStartID - 1;
-EndIdx = pChrom->LastStartID - 1;
-while(StartIdx <= EndIdx)
+return(eBSFSuccess);
+}
+
+// NextOverlap
+// Returns next feature, in chrom->start->end order, overlapping the range with which the cursor was initialised
+// Returns:
+// <0	Error
+// 0    No more overlapping features
+// >0   Feature identifier
+int
+CBEDfile::NextOverlap(tsBEDOverlapCursor *pCursor) // cursor as initialised by InitOverlapCursor()
+{
+int Idx;
+int NodeIdx;
+int ChildIdx;
+int Level;
+tsBEDfeature *pProbe;
+tsBEDfeature **ppFeats;
+int32_t *pMaxEnds;
+tsBEDOverlapNode *pNode;
+
+if(pCursor == NULL)
+	return(eBSFerrParams);
+if(pCursor->NumFeatures == 0)
+	return(0);
+ppFeats = &m_ppFeatureChromStarts[pCursor->FirstIdx];
+pMaxEnds = &m_pFeatMaxEnds[pCursor->FirstIdx];
+
+for(;;)
 	{
-	pProbe = m_ppFeatureChromStarts[StartIdx++];
-	if(pProbe->Start <= EndOfs &&
-	   pProbe->End >= StartOfs)
+	// continue any linear scan of a leaf subtree
+	while(pCursor->ScanIdx < pCursor->ScanEndIdx)
 		{
-		if(pProbe->Score < m_MinScore || pProbe->Score > m_MaxScore)
-			continue;
-		if((m_OnStrand != '*' && m_OnStrand != pProbe->Strand) || !(pProbe->FiltFlags & FiltInFlags) || pProbe->FiltFlags & FiltOutFlags)
-			continue;
-		if(--Ith == 0)
+		pProbe = ppFeats[pCursor->ScanIdx++];
+		if(pProbe->Start > pCursor->EndOfs)		// features are start sorted so no more in this subtree can overlap
 			{
+			pCursor->ScanEndIdx = pCursor->ScanIdx;
+			break;
+			}
+		if(pProbe->End >= pCursor->StartOfs &&
+		   pProbe->Score >= m_MinScore && pProbe->Score <= m_MaxScore &&
+		   (m_OnStrand == '*' || m_OnStrand == pProbe->Strand) &&
+		   (pProbe->FiltFlags & pCursor->FiltInFlags) && !(pProbe->FiltFlags & pCursor->FiltOutFlags))
 			return(pProbe->FeatureID);
+		}
+
+	if(pCursor->Depth == 0)
+		return(0);
+
+	pNode = &pCursor->Nodes[--pCursor->Depth];
+	NodeIdx = pNode->NodeIdx;
+	Level = pNode->Level;
+	if(Level <= cBEDOverlapLeafLevel)		// small subtree so linearly scan all features in that subtree
+		{
+		Idx = (NodeIdx >> Level) << Level;
+		pCursor->ScanIdx = Idx;
+		Idx += (1 << (Level + 1)) - 1;
+		pCursor->ScanEndIdx = Idx < pCursor->NumFeatures ? Idx : pCursor->NumFeatures;
+		continue;
+		}
+
+	if(!pNode->bLeftDone)		// left subtree to be processed before this node
+		{
+		pNode->bLeftDone = 1;
+		pCursor->Depth += 1;
+		ChildIdx = NodeIdx - (1 << (Level - 1));
+		if(ChildIdx >= pCursor->NumFeatures || pMaxEnds[ChildIdx] >= pCursor->StartOfs)
+			{
+			pNode = &pCursor->Nodes[pCursor->Depth++];
+			pNode->NodeIdx = ChildIdx;
+			pNode->Level = Level - 1;
+			pNode->bLeftDone = 0;
 			}
 		continue;
 		}
-	if(pProbe->Start > EndOfs)
-		break;
+
+	// left subtree has been processed, check this node and then the right subtree
+	if(NodeIdx >= pCursor->NumFeatures)		// node not present in an incomplete tree, only its left subtree can be present
+		continue;
+	pProbe = ppFeats[NodeIdx];
+	if(pProbe->Start > pCursor->EndOfs)		// this node, and all in its right subtree, start after the range
+		continue;
+	pNode = &pCursor->Nodes[pCursor->Depth++];
+	pNode->NodeIdx = NodeIdx + (1 << (Level - 1));
+	pNode->Level = Level - 1;
+	pNode->bLeftDone = 0;
+	if(pProbe->End >= pCursor->StartOfs &&
+	   pProbe->Score >= m_MinScore && pProbe->Score <= m_MaxScore &&
+	   (m_OnStrand == '*' || m_OnStrand == pProbe->Strand) &&
+	   (pProbe->FiltFlags & pCursor->FiltInFlags) && !(pProbe->FiltFlags & pCursor->FiltOutFlags))
+		return(pProbe->FeatureID);
 	}
-return(0);
 }
 
 
-
 // returns the number of chromosomes
 int 
 CBEDfile::GetNumChromosomes(void)
@@ -3361,11 +3662,10 @@ CBEDfile::GetNumFeatures(int ChromID,	  // features are on which chromosome
 					 int FiltInFlags, // filter out any features which do not have at least one of the specified filter flags set
 					 int FiltOutFlags) // filter out any features which have at least one of the specified filter flags set
 {
+int Rslt;
+int FeatID;
 int NumFeatures;
-int StartIdx;
-int EndIdx;
-int StartID;
-tsBEDfeature *pProbe;
+tsBEDOverlapCursor Cursor;
 
 // sanity checks whilst debug
 #ifdef _DEBUG
@@ -3373,44 +3673,14 @@ if(!m_bFeaturesAvail || !m_FileHdr.NumFeatures)
 	return(eBSFerrFeature);
 if(StartOfs < 0 || StartOfs > EndOfs)
 	return(eBSFerrParams);
-if(ChromID < 1 || ChromID > m_FileHdr.NumChroms)
-	return(eBSFerrChrom);
 #endif
 
-tsBEDchromname *pChrom = LocateChromName(ChromID);
-if(pChrom == NULL)
-	return(eBSFerrChrom);
-
-// determine initial lower limit to start linear search from which is a feature ending before StartOfs
-// search terminates when start > StartOfs
-if(pChrom->NumFeatures > 20 && StartOfs > pChrom->MaxFeatLen) 
-	{
-	StartID = LocateStart(ChromID,StartOfs - pChrom->MaxFeatLen,FiltInFlags,FiltOutFlags);
-	if(StartID == 0)
-		StartIdx = pChrom->FirstStartID - 1;
-	else
-		StartIdx = StartID - 1;
-	}
-else
-	StartIdx = pChrom->FirstStartID - 1;
-EndIdx = pChrom->LastStartID - 1;
+if((Rslt = InitOverlapCursor(&Cursor,ChromID,StartOfs,EndOfs,FiltInFlags,FiltOutFlags)) != eBSFSuccess)
+	return(Rslt);
 NumFeatures = 0;
-while(StartIdx <= EndIdx)
-	{
-	pProbe = m_ppFeatureChromStarts[StartIdx];
-	if((m_OnStrand == '*' || m_OnStrand == pProbe->Strand) &&
-		pProbe->FiltFlags & FiltInFlags && !(pProbe->FiltFlags & FiltOutFlags) &&
-			pProbe->Start <= EndOfs &&
-			pProbe->End >= StartOfs)
-		{
-		if(pProbe->Score >= m_MinScore && pProbe->Score <= m_MaxScore)
-			NumFeatures++;
-		continue;
-		}
-	if(pProbe->Start > EndOfs)
-		break;
-	}
-return(NumFeatures);
+while((FeatID = NextOverlap(&Cursor)) > 0)
+	NumFeatures++;
+return(FeatID < 0 ? FeatID : NumFeatures);
 }
 
 // returns start of the Ith (1..n) feature on chromosome 
@@ -3485,6 +3755,24 @@ return(0);
 }
 
 
+// RadixKeyChromStart
+// Radix sort key with ChromID in bits 63..32 and Start in bits 31..0, signed values are offset so they order as unsigned
+uint64_t
+CBEDfile::RadixKeyChromStart(const void *pEl)
+{
+tsBEDfeature *pFeature = *(tsBEDfeature **)pEl;
+return(((uint64_t)((uint32_t)pFeature->ChromID ^ 0x80000000) << 32) | ((uint32_t)pFeature->Start ^ 0x80000000));
+}
+
+// RadixKeyEndNameInst
+// Radix sort key with End in bits 63..32 and NameInst in bits 31..0, signed values are offset so they order as unsigned
+uint64_t
+CBEDfile::RadixKeyEndNameInst(const void *pEl)
+{
+tsBEDfeature *pFeature = *(tsBEDfeature **)pEl;
+return(((uint64_t)((uint32_t)pFeature->End ^ 0x80000000) << 32) | ((uint32_t)pFeature->NameInst ^ 0x80000000));
+}
+
 // SortFeatureNames
 // Used to sort by feature names --> ChromID ---> Start ---> End
 int 
@@ -4250,8 +4538,8 @@ bool
 CBEDfile::InInternFeat(int FeatBits,int ChromID,int StartOfs,int EndOfs)
 {
 int FeatID;
-int FeatNxt;
 int OverLaps;
+tsBEDOverlapCursor Cursor;
 
 // sanity checks only whilst debugging
 #ifdef _DEBUG
@@ -4265,8 +4553,9 @@ if(!(FeatBits & cAnyFeatBits))
 	return(false);
 #endif
 
-FeatNxt = 1;
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,StartOfs,EndOfs,FeatNxt++,cFeatFiltIn,cFeatFiltOut))>0)
+if(InitOverlapCursor(&Cursor,ChromID,StartOfs,EndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(false);
+while((FeatID = NextOverlap(&Cursor))>0)
 	{
 	OverLaps = GetFeatureOverlaps(FeatBits,FeatID,StartOfs,EndOfs);
 	if(OverLaps & FeatBits)
@@ -4279,8 +4568,8 @@ int
 CBEDfile::GetFeatureBits(int ChromID,int StartOfs,int EndOfs,int FeatBits,int Updnstream)
 {
 int FeatID;
-int FeatNxt;
 int Overlaps;
+tsBEDOverlapCursor Cursor;
 int OverlapStartOfs;
 int OverlapEndOfs;
 
@@ -4303,9 +4592,10 @@ else
 	OverlapEndOfs = EndOfs;
 	}
 
-FeatNxt = 1;
 Overlaps = 0;
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,OverlapStartOfs,OverlapEndOfs,FeatNxt++,cFeatFiltIn,cFeatFiltOut))>0)
+if(InitOverlapCursor(&Cursor,ChromID,OverlapStartOfs,OverlapEndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(0);
+while((FeatID = NextOverlap(&Cursor))>0)
 	Overlaps |= GetFeatureOverlaps(FeatBits,FeatID,StartOfs,EndOfs,Updnstream);
 return(Overlaps);
 }
@@ -4314,8 +4604,8 @@ int
 CBEDfile::GetSpliceSiteBits(int ChromID,int StartOfs,int EndOfs,int OverlapDistance)
 {
 int FeatID;
-int FeatNxt;
 int Overlaps;
+tsBEDOverlapCursor Cursor;
 int OverlapStartOfs;
 int OverlapEndOfs;
 
@@ -4332,9 +4622,10 @@ if(!ChromID || ChromID > m_FileHdr.NumChroms || OverlapDistance < 1 ||
 OverlapStartOfs = StartOfs;
 OverlapEndOfs = EndOfs;
 
-FeatNxt = 1;
 Overlaps = 0;
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,OverlapStartOfs,OverlapEndOfs,FeatNxt++,cFeatFiltIn,cFeatFiltOut))>0)
+if(InitOverlapCursor(&Cursor,ChromID,OverlapStartOfs,OverlapEndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(0);
+while((FeatID = NextOverlap(&Cursor))>0)
 	Overlaps |= GetFeatureBitsSpliceOverlaps(FeatID,StartOfs,EndOfs,OverlapDistance);
 return(Overlaps);
 }
@@ -4379,7 +4670,7 @@ return(InInternFeat(cFeatBit3UTR,ChromID,StartOfs,EndOfs));
 bool CBEDfile::InAny5Upstream(int ChromID,int StartOfs,int EndOfs,int Distance)
 {
 int FeatID;
-int CurIth;
+tsBEDOverlapCursor Cursor;
 int RelStartOfs;
 int RelEndOfs;
 if(!m_bFeaturesAvail || !m_FileHdr.NumFeatures)
@@ -4397,8 +4688,9 @@ if(StartOfs >= Distance)
 else
 	RelStartOfs = 0;
 RelEndOfs = EndOfs + Distance;
-CurIth = 1;
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,RelStartOfs,RelEndOfs,CurIth++,cFeatFiltIn,cFeatFiltOut))>0)
+if(InitOverlapCursor(&Cursor,ChromID,RelStartOfs,RelEndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(false);
+while((FeatID = NextOverlap(&Cursor))>0)
 	{
 	if(In5Upstream(FeatID,StartOfs,EndOfs,Distance)==true)
 		return(true);
@@ -4412,7 +4704,7 @@ return(false);
 bool CBEDfile::InAny3Dnstream(int ChromID,int StartOfs,int EndOfs,int Distance)
 {
 int FeatID;
-int CurIth;
+tsBEDOverlapCursor Cursor;
 int RelStartOfs;
 int RelEndOfs;
 if(!m_bFeaturesAvail || !m_FileHdr.NumFeatures)
@@ -4432,16 +4724,11 @@ if(StartOfs >= Distance)
 else
 	RelStartOfs = 0;
 RelEndOfs = EndOfs + Distance;
-CurIth = 1;
 
-// try from gene starts
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,RelStartOfs,RelEndOfs,CurIth++,cFeatFiltIn,cFeatFiltOut))>0)
-	if(In3Dnstream(FeatID,StartOfs,EndOfs,Distance)==true)
-		return(true);
-
-// try from gene ends
-CurIth = 1;
-while((FeatID = LocateFeatureIDinRangeOnChrom(ChromID,RelStartOfs,RelEndOfs,CurIth++,cFeatFiltIn,cFeatFiltOut))>0)
+// single pass over all genes within Distance, both gene starts and ends are covered by the overlap range
+if(InitOverlapCursor(&Cursor,ChromID,RelStartOfs,RelEndOfs,cFeatFiltIn,cFeatFiltOut) != eBSFSuccess)
+	return(false);
+while((FeatID = NextOverlap(&Cursor))>0)
 	if(In3Dnstream(FeatID,StartOfs,EndOfs,Distance)==true)
 		return(true);
 return(false);
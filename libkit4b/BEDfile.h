@@ -1,7 +1,7 @@
 #pragma once
 #include "./commdefs.h"
 
-const uint32_t cBSFeatVersion = 12;		// increment each time the file structure is changed
+const uint32_t cBSFeatVersion = 13;		// increment each time the file structure is changed
 const uint32_t cBSFFeatVersionBack = 11;	// can handle all versions starting from this minimum supported version
 
 const int cMaxNumChroms   = 50000000;		 // maximum number of chromosomes or contigs supported
@@ -19,6 +19,9 @@ const int cMinRegLen  = 0;			// min regulatory length
 const int cDfltRegLen = 0;			// default regulatory region length
 const int cMaxRegLen  = 1000000;	// max regulatory region length
 const int cMinSpliceOverlap = 2;	 // overlaps of features between introns and exons must be at least this to count as a splice site overlap
+const int cMinBEDOverlapIdxVersion = 13; // biobed files starting with this version contain the feature overlap (max end) index
+const int cBEDOverlapLeafLevel = 3;	 // overlap index subtrees at or below this level are linearly scanned
+const int cMaxBEDOverlapDepth = 64;	 // overlap cursor node stack depth, index depth is at most 31 levels
 
 const int cBFSessionSyncTimeout = 10000L;// 10 second timeout on synchronising access to session instance data
 const int cMinNumBFSessions = 50;		 // minimum number of sessions supported
@@ -159,14 +162,39 @@ typedef struct TAG_sBEDFileHdr {
 	int32_t ChromNamesSize;				// disk/memory space required to hold concatenated chromosome names
 	char szDescription[cMBSFFileDescrLen];// describes contents of file
 	char szTitle[cMBSFShortFileDescrLen];	// short title by which this file can be distingished from other files in dropdown lists etc
+	int64_t FeatureMaxEndsOfs;			// file offset to overlap index max ends, aligned with features sorted by (chrom->start->end), 0 if not present (pre-version 13 files)
 }tsBEDFileHdr;
 
+// overlap index nodes pending processing by an overlap cursor
+typedef struct TAG_sBEDOverlapNode {
+	int32_t NodeIdx;					// node index, relative to first feature on chromosome
+	int32_t Level;						// node is at this level in the implicit interval tree, leaves are at level 0
+	int32_t bLeftDone;					// 0 if left subtree still to be processed
+} tsBEDOverlapNode;
+
+// caller owned cursor for iterating all features overlapping a range, features are returned in chrom->start->end order
+// use a separate cursor for each concurrent iteration
+typedef struct TAG_sBEDOverlapCursor {
+	int32_t ChromID;					// features are on this chromosome
+	int32_t StartOfs;					// features must end on or after StartOfs
+	int32_t EndOfs;						// and start on or before EndOfs
+	int32_t FiltInFlags;				// filter out any features which do not have at least one of the specified filter flags set
+	int32_t FiltOutFlags;				// filter out any features which have at least one of the specified filter flags set
+	int32_t FirstIdx;					// index of first feature on chromosome in features sorted by (chrom->start->end)
+	int32_t NumFeatures;				// number of features on chromosome
+	int32_t ScanIdx;					// currently scanning leaf subtree at this chromosome relative feature index
+	int32_t ScanEndIdx;					// leaf subtree scan ends before this index
+	int32_t Depth;						// number of nodes in Nodes[]
+	tsBEDOverlapNode Nodes[cMaxBEDOverlapDepth];	// nodes pending processing
+} tsBEDOverlapCursor;
+
 #pragma pack()
 
 
 class CBEDfile  : protected CEndian, public CErrorCodes
 {	
 	CMTqsort m_mtqsort;					// muti-threaded qsort
+	CMTRadixSort m_MTRadixSort;			// muti-threaded radix and merge sorts
 	int m_hFile;						// opened/created file handle
 	char m_szFile[_MAX_PATH+1];			// file name as opened/created
 	bool m_bCreate;					    // TRUE if file opened for create 
@@ -190,6 +218,8 @@ class CBEDfile  : protected CEndian, public CErrorCodes
 
 	tsBEDfeature **m_ppFeatureNames;        // sorted (by name->chrom->start->end) array of ptrs into m_pFeatures
 	tsBEDfeature **m_ppFeatureChromStarts;  // sorted (by chrom->start->end) array of ptrs into m_pFeatures
+	int32_t *m_pFeatMaxEnds;				// overlap index, implicit interval tree per chromosome over m_ppFeatureChromStarts holding max feature end in each subtree
+	uint32_t m_OverlapIdxGen;				// unique generation of current overlap index, 0 if no index; identifies the index against which a retained cursor was initialised
 
 	 int m_MinScore;					// current score cutoffs
 	 int m_MaxScore;					// scores on any feature must be between these scores
@@ -223,6 +253,8 @@ class CBEDfile  : protected CEndian, public CErrorCodes
 	teBSFrsltCodes ReadDisk(int64_t DiskOfs,int Len,void *pTo);
 	teBSFrsltCodes Flush2Disk(void);
 	teBSFrsltCodes SortFeatures(void);
+	teBSFrsltCodes BuildOverlapIndex(void);	// build overlap index (m_pFeatMaxEnds) from features sorted by chrom->start->end
+	static int OverlapIndexLevels(int NumFeatures); // returns level of root node in overlap index for chromosome with NumFeatures
 	int	LocateStart(int ChromID, // feature is on which chromosome
 					int OverLapsOfs, // a point on the chromosome which returned feature starts above chrom.ofs
 					 int FiltInFlags, // filter out any features which do not have at least one of the specified filter flags set
@@ -237,6 +269,8 @@ class CBEDfile  : protected CEndian, public CErrorCodes
 
 	static int SortFeatureNames(const void *arg1, const void *arg2); // used to sort by feature name->chromid->start->end
 	static int SortChromStarts(const void *arg1, const void *arg2);  // used to sort by feature chromid->start->end
+	static uint64_t RadixKeyChromStart(const void *pEl);	// radix sort key for SortChromStarts ordering, most significant chromid->start
+	static uint64_t RadixKeyEndNameInst(const void *pEl);	// radix sort key for SortChromStarts ordering, least significant end->nameinst
 	static int SortChromNames( const void *arg1, const void *arg2);  // used to sort chromosome names
 	static int SortU2S( const void *arg1, const void *arg2);	// used to sort chrom ids when mapping features on to chrom initialisation
 
@@ -358,7 +392,8 @@ public:
 					 char *pszChrom = NULL,		// where to return chromosome name
 					 int *pNumFeatures = NULL,		// where to return number of features on this chromosome
 					 int *pFirstStartID = NULL,		// where to return identifier of first feature on this chromosome
-					 int *pLastStartID = NULL);		// where to return identifier of last feature on this chromosome
+					 int *pLastStartID = NULL,		// where to return identifier of last feature on this chromosome
+					 int *pMaxFeatLen = NULL);		// where to return maximum length of any feature on this chromosome
 
 	int											    // returned chromosome identifer
 		LocateChromIDbyName(char *pszChromName);	// chromosome name to locate
@@ -380,6 +415,17 @@ public:
 							 int FiltInFlags=cFeatFiltIn, // filter out any features which do not have at least one of the specified filter flags set
 							 int FiltOutFlags=cFeatFiltOut); // filter out any features which have at least one of the specified filter flags set
 
+	teBSFrsltCodes							  // initialise cursor for iterating all features overlapping a range using the overlap index
+		InitOverlapCursor(tsBEDOverlapCursor *pCursor, // cursor to initialise
+							 int ChromID,	  // features are on which chromosome
+							 int StartOfs,    // features must end on or after StartOfs
+							 int EndOfs,	  // and start on or before EndOfs
+							 int FiltInFlags=cFeatFiltIn, // filter out any features which do not have at least one of the specified filter flags set
+							 int FiltOutFlags=cFeatFiltOut); // filter out any features which have at least one of the specified filter flags set
+
+	int										  // returned next overlapping feature identifier (chrom->start->end order), 0 if no more overlaps, < 0 if errors
+		NextOverlap(tsBEDOverlapCursor *pCursor); // cursor as initialised by InitOverlapCursor()
+
 	int										  // returned number of features
 		GetNumFeatures(int ChromID,			  // features are on which chromosome
 					   int Start,			  // features must end on or after Start
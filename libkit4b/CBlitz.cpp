@@ -50,6 +50,7 @@ m_pszInputFilePE2 = NULL;
 m_pszSfxFile = NULL;
 m_pszOutFile = NULL;
 m_pSfxArray = NULL;
+m_pMzIdx = NULL;
 m_pszLineBuff = NULL;
 m_bMutexesCreated = false;
 Init();
@@ -93,6 +94,8 @@ m_pszInputFilePE2 = NULL;
 m_pszSfxFile = NULL;		
 m_pszOutFile = NULL;		
 m_pSfxArray = NULL;
+m_SeedMode = eBLZSeedSfx;
+m_pMzIdx = NULL;
 m_pszLineBuff = NULL;
 m_szLineBuffIdx = 0;
 m_ReportedPaths = 0;
@@ -170,6 +173,12 @@ if(m_pszLineBuff != NULL)
 	m_pszLineBuff = NULL;
 	}
 
+if(m_pMzIdx != NULL)
+	{
+	delete m_pMzIdx;
+	m_pMzIdx = NULL;
+	}
+
 if(m_pSfxArray != NULL)
 	{
 	delete m_pSfxArray;
@@ -364,7 +373,8 @@ CBlitz::Process(char* pszProcessName,	// name of process requesting blitz alignm
 		char *pszInputFilePE2,			// name of input file containing PE2 query sequences (only applies if output format is SAM)		
 		char *pszSfxFile,				// target as suffix array
 		char *pszOutFile,				// where to write alignments
-		int NumThreads)					// number of worker threads to use
+		int NumThreads,					// number of worker threads to use
+		etBLZSeedMode SeedMode)			// seed from suffix array cores or minimizer index
 {
 int Rslt;
 Init();
@@ -389,6 +399,7 @@ m_pszInputFilePE2 = pszInputFilePE2;
 m_pszSfxFile = pszSfxFile;		
 m_pszOutFile = pszOutFile;		
 m_NumThreads = NumThreads;
+m_SeedMode = SeedMode;
 m_FiltMinLen = FiltMinLen;
 m_FiltMaxLen = FiltMaxLen;
 
@@ -549,6 +560,25 @@ if(CoreLen <= cMaxKmerLen)
 		}
 	}
 
+// minimizer k-mers are the core length, clamped to be no longer than can be indexed, and are sampled over windows of core delta k-mers
+// index is built excluding only minimizers occurring more than the maximum depth which could be requested so the same index can be used at any sensitivity
+if(SeedMode == eBLZSeedMzIdx)
+	{
+	if((m_pMzIdx = new CMinimizerIdx) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to instantiate CMinimizerIdx");
+		Reset(false);
+		return(eBSFerrObj);
+		}
+	if((Rslt = m_pMzIdx->Open(m_pSfxArray,pszSfxFile,min(m_CoreLen,cMaxMzIdxKMerLen),max(cMinMzIdxWinLen,min(m_CoreDelta,cMaxMzIdxWinLen)),cMaxBlitzOccKMerDepth,NumThreads)) != eBSFSuccess)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Failed to open minimizer index for suffix array file '%s'",pszSfxFile);
+		Reset(false);
+		return(Rslt);
+		}
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Seeding from minimizer index, k-mer length : %d, window : %d",m_pMzIdx->GetKMerLen(),m_pMzIdx->GetWinLen());
+	}
+
 if(KMerDist == true)
 	{
 	if ((m_pKmerOccsDist = new uint32_t[m_MaxIter + 1]) == NULL)				// allocated to hold Kmer count distributions (up to cMaxOccKMerDepth counts)
@@ -850,31 +880,54 @@ return(Rslt);
 
 
 
-#ifdef _WIN32
-unsigned __stdcall AlignQuerySeqsThread(void * pThreadPars)
-#else
-void *AlignQuerySeqsThread(void * pThreadPars)
-#endif
+// called by work pool threads, each item is a batch of already queued query sequences which is aligned using the worker's aligner instance
+static int
+AlignQuerySeqsChunk(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
 {
 int Rslt;
-tsThreadQuerySeqsPars *pPars = (tsThreadQuerySeqsPars *)pThreadPars;			// makes it easier not having to deal with casts!
-CBlitz *pBlitzer = (CBlitz *)pPars->pThis;
-if(pPars->bIsSAMOutput)
+int64_t Idx;
+tsThreadQuerySeqsPars *pPars;
+CBlitz *pBlitzer;
+pPars = &((tsThreadQuerySeqsPars *)pCtx)[WorkerIdx];
+pBlitzer = (CBlitz *)pPars->pThis;
+for(Idx = StartIdx; Idx < EndIdx; Idx++)
 	{
-	if(pPars->bIsSAMPE)
-		Rslt = pBlitzer->ProcAlignSAMQuerySeqsPE(pPars);
+	if(pPars->bIsSAMOutput)
+		{
+		if(pPars->bIsSAMPE)
+			Rslt = pBlitzer->ProcAlignSAMQuerySeqsPE(pPars,cBlitzQueryBatch);
+		else
+			Rslt = pBlitzer->ProcAlignSAMQuerySeqsSE(pPars,cBlitzQueryBatch);
+		}
 	else
-		Rslt = pBlitzer->ProcAlignSAMQuerySeqsSE(pPars);
+		Rslt = pBlitzer->ProcAlignQuerySeqs(pPars,cBlitzQueryBatch);
+	if(Rslt < 0)
+		pPars->Rslt = Rslt;
+	}
+return(eBSFSuccess);
+}
+
+void
+CBlitz::AlignQuerySeqsProgress(void *pProgressCtx)	// reports alignment progress whilst aligners are still processing query sequences
+{
+uint32_t ReportedPaths;
+uint32_t QueriesPaths;
+uint32_t NumQueriesProc;
+tsBlitzAlignProgress *pProgress = (tsBlitzAlignProgress *)pProgressCtx;
+CBlitz *pThis = pProgress->pThis;
+
+pThis->AcquireSerialise();
+ReportedPaths = pThis->m_ReportedPaths;
+QueriesPaths = pThis->m_QueriesPaths;
+NumQueriesProc = pThis->m_NumQueriesProc;
+pThis->ReleaseSerialise();
+if(ReportedPaths > pProgress->PrevReportedPaths || QueriesPaths > pProgress->PrevQueriesPaths || NumQueriesProc > pProgress->PrevNumQueriesProc)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: Generated %u alignment paths for %u query %s sequences from %d processed",ReportedPaths,QueriesPaths, pProgress->bIsSAMPE ? "paired" : "single",NumQueriesProc);
+	pProgress->PrevReportedPaths = ReportedPaths;
+	pProgress->PrevQueriesPaths = QueriesPaths;
+	pProgress->PrevNumQueriesProc = NumQueriesProc;
 	}
-else
-	Rslt = pBlitzer->ProcAlignQuerySeqs(pPars);
-pPars->Rslt = Rslt;
-#ifdef _WIN32
-_endthreadex(0);
-return(eBSFSuccess); // unreached, but keeps compilers happy!
-#else
-pthread_exit(&pPars->Rslt);
-#endif
 }
 
 int
@@ -882,8 +935,17 @@ CBlitz::InitQuerySeqThreads(int NumThreads,			// use this many threads
 							int AlignNodes)			// each thread is allocatd this many subsequence alignment nodes
 {
 bool bIsSAMPE;
+bool bAllQuerySeqsLoaded;
+bool bTermBackgoundThreads;
+int BackoffMS;
+int NumQueued;
+int QueuedPerQuery;
+int BatchesTarget;
+int NumBatches;
 tsThreadQuerySeqsPars *pThreads;
 tsThreadQuerySeqsPars *pThread;
+tsBlitzAlignProgress Progress;
+CWorkPool *pWorkPool;
 m_QueriesPaths = 0;
 m_ReportedPaths = 0;
 bIsSAMPE = (m_pszInputFilePE2 == NULL || m_pszInputFilePE2[0] == 0) ? false : true;
@@ -918,71 +980,61 @@ for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThread++)
 		pThread->ppFirst2RptsPE2 = NULL;
 		pThread->NumAllocdAlignNodesPE2 = 0;
 		}
-
-#ifdef _WIN32
-	pThread->threadHandle = (HANDLE)_beginthreadex(NULL, 0x0fffff, AlignQuerySeqsThread, pThread, 0, &pThread->threadID);
-#else
-	pThread->threadRslt = pthread_create(&pThread->threadID, NULL, AlignQuerySeqsThread, pThread);
-#endif
 	}
 
-// allow threads a few seconds to startup
-#ifdef _WIN32
-Sleep(2000);
-#else
-sleep(2);
-#endif
-uint32_t ReportedPaths;
-uint32_t PrevReportedPaths = 0;
-uint32_t QueriesPaths;
-uint32_t PrevQueriesPaths = 0;
-uint32_t NumQueriesProc;
-uint32_t PrevNumQueriesProc = 0;
-
-
+// whilst query sequences are being loaded then those already queued are aligned as batches of cBlitzQueryBatch sequences on the shared work pool,
+// each batch is a separate work item so workers completing batches of shorter or unaligned queries steal batches from workers with longer running queries
+// each worker aligns it's batches using the aligner instance indexed by it's WorkerIdx
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: Generated 0 alignment paths for 0 query %s sequences from 0 processed", bIsSAMPE ? "paired" : "single");
-pThread = pThreads;
-for (ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++, pThread++)
-	{
-#ifdef _WIN32
-	while (WAIT_TIMEOUT == WaitForSingleObject(pThread->threadHandle, 60000))
+memset(&Progress,0,sizeof(Progress));
+Progress.pThis = this;
+Progress.bIsSAMPE = bIsSAMPE;
+pWorkPool = CWorkPool::Shared(NumThreads);
+QueuedPerQuery = bIsSAMPE ? 2 : 1;
+BatchesTarget = NumThreads * cWorkPoolChunksPerThread;
+if((BatchesTarget * cBlitzQueryBatch * QueuedPerQuery) > cMaxBlitzReadAheadQuerySeqs / 2)
+	BatchesTarget = max(1,cMaxBlitzReadAheadQuerySeqs / (2 * cBlitzQueryBatch * QueuedPerQuery));
+while(1)
+	{
+	// wait until enough query sequences have been queued to provide all workers with multiple batches, or all query sequences have been loaded
+	BackoffMS = 1;
+	while(1)
 		{
-		AcquireSerialise();
-		ReportedPaths = m_ReportedPaths;
-		QueriesPaths = m_QueriesPaths;
-		NumQueriesProc = m_NumQueriesProc;
-		if(ReportedPaths > PrevReportedPaths || QueriesPaths > PrevQueriesPaths || NumQueriesProc > PrevNumQueriesProc)
-			{
-			gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: Generated %u alignment paths for %u query %s sequences from %d processed",ReportedPaths,QueriesPaths, bIsSAMPE ? "paired" : "single",NumQueriesProc);
-			PrevReportedPaths = ReportedPaths;
-			PrevQueriesPaths = QueriesPaths;
-			PrevNumQueriesProc = NumQueriesProc;
-			}
-		ReleaseSerialise();
-		};
-	CloseHandle(pThread->threadHandle);
-#else
-	struct timespec ts;
-	int JoinRlt;
-	clock_gettime(CLOCK_REALTIME, &ts);
-	ts.tv_sec += 60;
-	while ((JoinRlt = pthread_timedjoin_np(pThread->threadID, NULL, &ts)) != 0)
+		AcquireLock(true);
+		NumQueued = m_NumQuerySeqs;
+		bAllQuerySeqsLoaded = m_bAllQuerySeqsLoaded;
+		bTermBackgoundThreads = m_TermBackgoundThreads != 0 ? true : false;
+		ReleaseLock(true);
+		if(bTermBackgoundThreads || bAllQuerySeqsLoaded || NumQueued >= (BatchesTarget * cBlitzQueryBatch * QueuedPerQuery))
+			break;
+		CUtility::SleepMillisecs(BackoffMS);
+		if(BackoffMS < 256)
+			BackoffMS *= 2;
+		}
+	if(bTermBackgoundThreads)
+		break;
+	// a partial batch is only submitted once all query sequences have been loaded, otherwise it is deferred until more have been queued
+	NumQueued /= QueuedPerQuery;
+	if(bAllQuerySeqsLoaded)
+		NumBatches = (NumQueued + cBlitzQueryBatch - 1) / cBlitzQueryBatch;
+	else
+		NumBatches = NumQueued / cBlitzQueryBatch;
+	if(NumBatches == 0)
 		{
-		AcquireSerialise();
-		ReportedPaths = m_ReportedPaths;
-		QueriesPaths = m_QueriesPaths;
-		NumQueriesProc = m_NumQueriesProc;
-		if(ReportedPaths > PrevReportedPaths || QueriesPaths > PrevQueriesPaths || NumQueriesProc > PrevNumQueriesProc)
-			{
-			gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: Generated %u alignment paths for %u query %s sequences from %d processed",ReportedPaths,QueriesPaths, bIsSAMPE ? "paired" : "single", NumQueriesProc);
-			PrevReportedPaths = ReportedPaths;
-			PrevQueriesPaths = QueriesPaths;
-			PrevNumQueriesProc = NumQueriesProc;
-			}
-		ReleaseSerialise();
-		ts.tv_sec += 60;
+		if(bAllQuerySeqsLoaded)
+			break;
+		continue;
 		}
-#endif
+	if(pWorkPool != NULL)
+		pWorkPool->ParallelFor(NumBatches,1,AlignQuerySeqsChunk,pThreads,60,NULL,AlignQuerySeqsProgress,&Progress,NumThreads);
+	else
+		AlignQuerySeqsChunk(pThreads,0,NumBatches,0);
+	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: Completed aligning %u query sequences",m_NumQueriesProc);
+
+pThread = pThreads;
+for (ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++, pThread++)
+	{
 	if(pThread->pAllocdAlignNodes != NULL)
 		{
 		delete pThread->pAllocdAlignNodes;
@@ -1005,6 +1057,7 @@ for (ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++, pThread++)
 		pThread->ppFirst2RptsPE2 = NULL;
 		}
 	pThread->NumAllocdAlignNodesPE2 = 0;
+	CMinimizerIdx::FreeScratch(&pThread->MzScratch);
 	}
 
 if (m_hOutFile)
@@ -1127,9 +1180,11 @@ return(0);
 }
 
 int
-CBlitz::ProcAlignSAMQuerySeqsSE(tsThreadQuerySeqsPars *pPars) // single ended processing only
+CBlitz::ProcAlignSAMQuerySeqsSE(tsThreadQuerySeqsPars *pPars, // single ended processing only
+								int MaxQueries)				// align at most this many query sequences
 {
 int Rslt;
+int NumDequeued;
 int MaxIter;
 int NumQueryPathsRprtd;
 int NumMatches;
@@ -1154,8 +1209,10 @@ uint32_t TargSeqLen;
 char szTargName[100];
 int MinPathScore;
 
-while((Rslt = DequeueQuerySeq(cMaxBlitzQuerySeqIdentLen + 1, &SeqID, szQuerySeqIdent, &QuerySeqLen, &pQuerySeq)) == 1)
+NumDequeued = 0;
+while(NumDequeued < MaxQueries && (Rslt = DequeueQuerySeq(cMaxBlitzQuerySeqIdentLen + 1, &SeqID, szQuerySeqIdent, &QuerySeqLen, &pQuerySeq)) == 1)
 	{
+	NumDequeued += 1;
 	AcquireSerialise();
 	m_NumQueriesProc += 1;
 	ReleaseSerialise();
@@ -1163,7 +1220,7 @@ while((Rslt = DequeueQuerySeq(cMaxBlitzQuerySeqIdentLen + 1, &SeqID, szQuerySeqI
 	NumQueryPathsRprtd = 0;
 	MaxIter = m_MaxIter;
 
-	NumMatches = m_pSfxArray->LocateQuerySeqs(SeqID, pQuerySeq, QuerySeqLen, m_CoreLen, m_CoreDelta, m_AlignStrand, pPars->NumAllocdAlignNodes, pPars->pAllocdAlignNodes, MaxIter, m_ExactMatchScore,m_MismatchScore);
+	NumMatches = LocateCores(pPars, SeqID, pQuerySeq, QuerySeqLen, m_CoreDelta, pPars->NumAllocdAlignNodes, pPars->pAllocdAlignNodes, MaxIter);
 	if(NumMatches >= 1)
 		{
 		if (NumMatches > 1)	// sorting by TargSeqID.QueryID.FlgStrand.TargStartOfs.QueryStartOfs
@@ -1236,15 +1293,15 @@ while((Rslt = DequeueQuerySeq(cMaxBlitzQuerySeqIdentLen + 1, &SeqID, szQuerySeqI
 		ReportNonAligned(szQuerySeqIdent, QuerySeqLen, pQuerySeq);
 	delete pQuerySeq;
 	}
-
-gDiagnostics.DiagOut(eDLInfo, gszProcName, "Progress: Thread %d completed", pPars->ThreadIdx);
 return(0);
 }
 
 int
-CBlitz::ProcAlignSAMQuerySeqsPE(tsThreadQuerySeqsPars *pPars)
+CBlitz::ProcAlignSAMQuerySeqsPE(tsThreadQuerySeqsPars *pPars,
+								int MaxQueries)				// align at most this many query sequence pairs
 {
 int Rslt;
+int NumDequeued;
 int MaxIter;
 int NumQueryPathsRprtdPE1;
 int NumMatchesPE1;
@@ -1306,8 +1363,10 @@ MaxIter = m_MaxIter;
 int CoreDelta = m_CoreDelta;
 
 // getting 2 reads at a time, PE1 and PE2
-while((Rslt = DequeueQuerySeq(cMaxBlitzQuerySeqIdentLen + 1, &SeqIDPE1, szQuerySeqIdent, &QuerySeqLenPE1, &pQuerySeqPE1, &SeqIDPE2, szQuerySeqIdentPE2, &QuerySeqLenPE2, &pQuerySeqPE2))==2)
+NumDequeued = 0;
+while(NumDequeued < MaxQueries && (Rslt = DequeueQuerySeq(cMaxBlitzQuerySeqIdentLen + 1, &SeqIDPE1, szQuerySeqIdent, &QuerySeqLenPE1, &pQuerySeqPE1, &SeqIDPE2, szQuerySeqIdentPE2, &QuerySeqLenPE2, &pQuerySeqPE2))==2)
 	{
+	NumDequeued += 1;
 	AcquireSerialise();
 	m_NumQueriesProc += 1;
 	ReleaseSerialise();
@@ -1322,7 +1381,7 @@ while((Rslt = DequeueQuerySeq(cMaxBlitzQuerySeqIdentLen + 1, &SeqIDPE1, szQueryS
 		NumQueryPathsRprtdPE1 = 0;
 		NumHeadNodesPE1 = 0;
 		NumHeadNodesPE2 = 0;
-		NumMatchesPE1 = m_pSfxArray->LocateQuerySeqs(SeqIDPE1, pQuerySeqPE1, QuerySeqLenPE1, m_CoreLen, CoreDelta, m_AlignStrand, pPars->NumAllocdAlignNodes, pPars->pAllocdAlignNodes, MaxIter, m_ExactMatchScore, m_MismatchScore);
+		NumMatchesPE1 = LocateCores(pPars, SeqIDPE1, pQuerySeqPE1, QuerySeqLenPE1, CoreDelta, pPars->NumAllocdAlignNodes, pPars->pAllocdAlignNodes, MaxIter);
 		if (NumMatchesPE1)
 			{
 			if (NumMatchesPE1 > 1)	// sorting by TargSeqID.QueryID.FlgStrand.TargStartOfs.QueryStartOfs
@@ -1339,7 +1398,7 @@ while((Rslt = DequeueQuerySeq(cMaxBlitzQuerySeqIdentLen + 1, &SeqIDPE1, szQueryS
 
 		if(NumHeadNodesPE1 > 0)		// can't have a pair if no PE1's !
 			{
-			NumMatchesPE2 = m_pSfxArray->LocateQuerySeqs(SeqIDPE2, pQuerySeqPE2, QuerySeqLenPE2, m_CoreLen, CoreDelta, m_AlignStrand, pPars->NumAllocdAlignNodesPE2, pPars->pAllocdAlignNodesPE2, MaxIter, m_ExactMatchScore, m_MismatchScore);
+			NumMatchesPE2 = LocateCores(pPars, SeqIDPE2, pQuerySeqPE2, QuerySeqLenPE2, CoreDelta, pPars->NumAllocdAlignNodesPE2, pPars->pAllocdAlignNodesPE2, MaxIter);
 			if (NumMatchesPE2)
 				{
 				if (NumMatchesPE2 > 1)	// sorting by TargSeqID.QueryID.FlgStrand.TargStartOfs.QueryStartOfs
@@ -1504,13 +1563,38 @@ while((Rslt = DequeueQuerySeq(cMaxBlitzQuerySeqIdentLen + 1, &SeqIDPE1, szQueryS
 	delete pQuerySeqPE1;
 	delete pQuerySeqPE2;
 	}
-gDiagnostics.DiagOut(eDLInfo, gszProcName, "Progress: Thread %d completed", pPars->ThreadIdx);
 return(0);
 }
 
 
+// LocateCores
+// Locate seed alignment nodes for query, either suffix array cores or minimizer index diagonal runs, both 5' and 3' flank extended
+int
+CBlitz::LocateCores(tsThreadQuerySeqsPars *pPars,	// calling thread
+				int SeqID,					// identifies query sequence
+				uint8_t *pQuerySeq,			// query sequence
+				int QuerySeqLen,			// query sequence length
+				int CoreDelta,				// if seeding from suffix array then offset cores by this many bp
+				uint32_t MaxHits,			// return at most this many alignment nodes
+				tsQueryAlignNodes *pHits,	// where to return alignment nodes
+				int MaxIter)				// max allowed iterations (depth) per core, or occurrences per minimizer
+{
+int Rslt;
+if(m_pMzIdx != NULL)
+	Rslt = m_pMzIdx->LocateQuerySeqs(SeqID,pQuerySeq,QuerySeqLen,m_CoreLen,m_AlignStrand,MaxIter,MaxHits,pHits,m_ExactMatchScore,m_MismatchScore,&pPars->MzScratch);
+else
+	Rslt = m_pSfxArray->LocateQuerySeqs(SeqID,pQuerySeq,QuerySeqLen,m_CoreLen,CoreDelta,m_AlignStrand,MaxHits,pHits,MaxIter,m_ExactMatchScore,m_MismatchScore);
+if(Rslt < 0)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"Thread %d: error %d locating seeds for query sequence %d, treating as unaligned",pPars->ThreadIdx,Rslt,SeqID);
+	Rslt = 0;
+	}
+return(Rslt);
+}
+
 int
-CBlitz::ProcAlignQuerySeqs(tsThreadQuerySeqsPars *pPars) 
+CBlitz::ProcAlignQuerySeqs(tsThreadQuerySeqsPars *pPars,
+						int MaxQueries)				// align at most this many query sequences
 {
 int Rslt;
 int MaxIter;
@@ -1523,7 +1607,7 @@ uint8_t* pQuerySeq;
 char szQuerySeqIdent[cMaxBlitzQuerySeqIdentLen + 1];
 int MinPathScore;
 NumQueriesProc = 0;
-while((Rslt = DequeueQuerySeq(sizeof(szQuerySeqIdent),&SeqID,szQuerySeqIdent,&QuerySeqLen,&pQuerySeq))==1)
+while(NumQueriesProc < MaxQueries && (Rslt = DequeueQuerySeq(sizeof(szQuerySeqIdent),&SeqID,szQuerySeqIdent,&QuerySeqLen,&pQuerySeq))==1)
 	{
 	AcquireSerialise();
 	m_NumQueriesProc += 1;
@@ -1531,7 +1615,7 @@ while((Rslt = DequeueQuerySeq(sizeof(szQuerySeqIdent),&SeqID,szQuerySeqIdent,&Qu
 	NumQueriesProc += 1;
 	NumQueryPathsRprtd = 0;
 	MaxIter = m_MaxIter;
-	NumMatches = m_pSfxArray->LocateQuerySeqs(SeqID,pQuerySeq,QuerySeqLen,m_CoreLen,m_CoreDelta,m_AlignStrand,pPars->NumAllocdAlignNodes,pPars->pAllocdAlignNodes,m_MaxIter, m_ExactMatchScore, m_MismatchScore);
+	NumMatches = LocateCores(pPars,SeqID,pQuerySeq,QuerySeqLen,m_CoreDelta,pPars->NumAllocdAlignNodes,pPars->pAllocdAlignNodes,m_MaxIter);
 	if(NumMatches)
 		{
 		if(NumMatches > 1)	// sorting by TargSeqID.QueryID.FlgStrand.TargStartOfs.QueryStartOfs
@@ -1549,7 +1633,6 @@ while((Rslt = DequeueQuerySeq(sizeof(szQuerySeqIdent),&SeqID,szQuerySeqIdent,&Qu
 		}
 	delete pQuerySeq;
 	}
-gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: Thread %d completed, processed %d query sequences",pPars->ThreadIdx,NumQueriesProc);
 return(0);
 }
 
@@ -78,6 +78,7 @@ const int cDfltMaxBlitzQuerySeqLen = 100000;    // default: filter out sequences
 
 
 const int cMaxBlitzReadAheadQuerySeqs = 50000;	// read ahead and enqueue up to at most this many query sequences
+const int cBlitzQueryBatch = 16;				// each work pool item aligns a batch of at most this many queued query sequences, or pairs if PE
 
 const int cNumBlitzAllocdAlignNodes = 200000;  // allow each query sequence to have up to this many aligned subsequences
 
@@ -100,6 +101,12 @@ typedef enum TAG_eBLZSensitivity {
 }etBLZSensitivity;
 
 
+typedef enum TAG_eBLZSeedMode {
+	eBLZSeedSfx = 0,	// default is to seed with suffix array cores
+	eBLZSeedMzIdx,		// seed with diagonal runs of hits from a sampled minimizer k-mer index
+	eBLZSeedplaceholder	// used as a placeholder and flags the range of these enumerations
+}etBLZSeedMode;
+
 typedef enum TAG_eBLZRsltsFomat {
 	eBLZRsltsPSL = 0,	// default results format is PSL
 	eBLZRsltsPSLX,		// results format is PSLX
@@ -136,16 +143,8 @@ typedef struct TAG_sLoadQuerySeqsThreadPars {
 } tsLoadQuerySeqsThreadPars;
 
 typedef struct TAG_sThreadQuerySeqsPars {
-	int ThreadIdx;					// uniquely identifies this thread
+	int ThreadIdx;					// uniquely identifies this aligner instance
 	void *pThis;					// will be initialised to pt to CBlitz instance
-
-#ifdef _WIN32
-	HANDLE threadHandle;			// handle as returned by _beginthreadex()
-	unsigned int threadID;			// identifier as set by _beginthreadex()
-#else
-	int threadRslt;					// result as returned by pthread_create ()
-	pthread_t threadID;				// identifier as set by pthread_create ()
-#endif
 	bool bIsSAMOutput;				// will be true if aligning for SAM output format with PE processing capability
 	bool bIsSAMPE;					// will be true if aligning SAM PE
 	uint32_t NumAllocdAlignNodes;				// number of allocated alignment nodes
@@ -154,10 +153,19 @@ typedef struct TAG_sThreadQuerySeqsPars {
 	uint32_t NumAllocdAlignNodesPE2;				// number of allocated alignment nodes
 	tsQueryAlignNodes *pAllocdAlignNodesPE2;	// allocated to hold aligned PE2 subsequences
 	tsQueryAlignNodes **ppFirst2RptsPE2;		// allocated to hold ptrs to PE2 alignment nodes which are marked as being FlgFirst2tRpt
+	tsMzIdxScratch MzScratch;		// working memory used when seeding from the shared minimizer index
 	int *pRslt;						// write intermediate result codes to this location
 	int Rslt;						// returned result code
 } tsThreadQuerySeqsPars;
 
+typedef struct TAG_sBlitzAlignProgress {
+	class CBlitz *pThis;			// CBlitz instance
+	bool bIsSAMPE;					// true if aligning SAM PE
+	uint32_t PrevReportedPaths;		// alignment paths as last reported
+	uint32_t PrevQueriesPaths;		// query sequences with at least one path as last reported
+	uint32_t PrevNumQueriesProc;	// query sequences processed as last reported
+} tsBlitzAlignProgress;
+
 #pragma pack()
 
 
@@ -205,6 +213,8 @@ class CBlitz
 	int m_szLineBuffIdx;			// offset into m_pszLineBuff at which to next write
 	char *m_pszLineBuff;			// allocated to hold output line buffering
 	CSfxArray *m_pSfxArray;			// suffix array holds genome of interest
+	etBLZSeedMode m_SeedMode;		// seeding from suffix array cores or minimizer index
+	CMinimizerIdx *m_pMzIdx;		// if seeding from minimizer index then index over m_pSfxArray sequences, read only once opened so shared by all alignment threads
 	char m_szTargSpecies[cMaxDatasetSpeciesChrom+1]; // suffix array was generated over this targeted species
 
 	int m_TotSeqIDs;				// total number of query sequences which have been parsed and enqueued
@@ -237,10 +247,21 @@ class CBlitz
 
 	int InitQuerySeqThreads(int NumThreads,			// use this many threads
 							int AlignNodes);			// each thread is allocatd this many subsequence alignment nodes
+	static void AlignQuerySeqsProgress(void *pProgressCtx);	// reports alignment progress whilst aligners are still processing query sequences
 
 
 	int InitLoadQuerySeqs(void);		// query sequences are loaded asynchronously to the alignments
 
+	int									// returned number of alignment nodes
+		LocateCores(tsThreadQuerySeqsPars *pPars,	// calling thread
+				int SeqID,					// identifies query sequence
+				uint8_t *pQuerySeq,			// query sequence
+				int QuerySeqLen,			// query sequence length
+				int CoreDelta,				// if seeding from suffix array then offset cores by this many bp
+				uint32_t MaxHits,			// return at most this many alignment nodes
+				tsQueryAlignNodes *pHits,	// where to return alignment nodes
+				int MaxIter);				// max allowed iterations (depth) per core, or occurrences per minimizer
+
 	bool m_bMutexesCreated;			// will be set true if synchronisation mutexes have been created
 	int CreateMutexes(void);
 	void DeleteMutexes(void);
@@ -296,13 +317,14 @@ public:
 			char *pszInputFilePE2,			// name of input file containing PE2 query sequences (only applies if output format is SAM)
 			char *pszSfxFile,				// target as suffix array
 			char *pszOutFile,				// where to write alignments
-			int NumThreads);				// number of worker threads to use
+			int NumThreads,					// number of worker threads to use
+			etBLZSeedMode SeedMode = eBLZSeedSfx);	// seed from suffix array cores or minimizer index
 
 	int ProcLoadQuerySeqsFile(tsLoadQuerySeqsThreadPars *pPars);
 	int ProcLoadSAMQuerySeqsFile(tsLoadQuerySeqsThreadPars *pPars);
-	int ProcAlignQuerySeqs(tsThreadQuerySeqsPars *pPars);
-	int ProcAlignSAMQuerySeqsSE(tsThreadQuerySeqsPars *pPars);	// align as SE only reporting alignments in SAM file format
-	int ProcAlignSAMQuerySeqsPE(tsThreadQuerySeqsPars *pPars);	// align as PE only reporting alignments in SAM file format
+	int ProcAlignQuerySeqs(tsThreadQuerySeqsPars *pPars,int MaxQueries);		// align at most MaxQueries dequeued query sequences
+	int ProcAlignSAMQuerySeqsSE(tsThreadQuerySeqsPars *pPars,int MaxQueries);	// align as SE only reporting alignments in SAM file format
+	int ProcAlignSAMQuerySeqsPE(tsThreadQuerySeqsPars *pPars,int MaxQueries);	// align as PE only reporting alignments in SAM file format
 	int	ReportNonAligned(char *pszDescPE1, int LenSeqPE1, uint8_t *pSeqPE1, char *pszDescPE2 = NULL, int LenSeqPE2 = 0, uint8_t *pSeqPE2 = NULL);
 
 	teBSFrsltCodes // When SAM aligning then will be aligning sequencing reads which are length truncated to be no longer than cSAMtruncSeqLen bases
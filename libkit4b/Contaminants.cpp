@@ -1152,7 +1152,8 @@ int			// 0 if no Contaminant contains this target sequence
 CContaminants::MatchVectContams(bool bIsPE2,		// true if target sequence is a PE2, else if false then target is either a SE or PE1
 					int AllowSubsRate,			// if non-zero then allow substitutions in the overlapping Contaminants at this rate per 25bp of overlap length if overlap >= 10bp
 					int QueryLen,			// query sequence length
-					etSeqBase *pQuerySeq)	// attempt to locate a maximal overlap onto this query read sequence
+					etSeqBase *pQuerySeq,	// attempt to locate a maximal overlap onto this query read sequence
+					tsContamHitCnts *pHitCnts)	// if not NULL then accumulate hit counts into these per thread counts instead of serialising updates to this instance's counts
 {
 etSeqBase QuerySeq[cMaxContamQuerySeqLen+1];
 etSeqBase RevCplQuerySeq[cMaxContamQuerySeqLen+1];
@@ -1183,19 +1184,32 @@ for(VectIdx = 0; VectIdx < m_NumVectContaminates; VectIdx++, pVectContam++)
 		continue;
 
 	// attempt to find a match
-	AcquireSerialise();
-	m_ContaminantTypes[eAOFVector].NumChecks += 1;
-	ReleaseSerialise();
+	if(pHitCnts != NULL)
+		pHitCnts->NumChecks[eAOFVector] += 1;
+	else
+		{
+		AcquireSerialise();
+		m_ContaminantTypes[eAOFVector].NumChecks += 1;
+		ReleaseSerialise();
+		}
 	if(!bIsPE2 && pVectContam->FlgPE1Sense || bIsPE2 && pVectContam->FlgPE2Sense)
 		{
 		if((NumSubs = MatchVectContam(AllowSubsRate,QueryLen,QuerySeq,pVectContam)) >= 0)
 			{
 			if(NumSubs == 0)
 				{
-				AcquireSerialise();
-				m_ContaminantTypes[eAOFVector].HitTot += 1;
-				pVectContam->HitTot += 1;
-				ReleaseSerialise();
+				if(pHitCnts != NULL)
+					{
+					pHitCnts->HitTot[eAOFVector] += 1;
+					pHitCnts->VectHitTot[VectIdx] += 1;
+					}
+				else
+					{
+					AcquireSerialise();
+					m_ContaminantTypes[eAOFVector].HitTot += 1;
+					pVectContam->HitTot += 1;
+					ReleaseSerialise();
+					}
 				return(QueryLen);
 				}
 			if(pBestVectContam == NULL || NumSubs < LowestNumSubs)
@@ -1213,10 +1227,18 @@ for(VectIdx = 0; VectIdx < m_NumVectContaminates; VectIdx++, pVectContam++)
 			{
 			if(NumSubs == 0)
 				{
-				AcquireSerialise();
-				m_ContaminantTypes[eAOFVector].HitTot += 1;
-				pVectContam->HitTot += 1;
-				ReleaseSerialise();
+				if(pHitCnts != NULL)
+					{
+					pHitCnts->HitTot[eAOFVector] += 1;
+					pHitCnts->VectHitTot[VectIdx] += 1;
+					}
+				else
+					{
+					AcquireSerialise();
+					m_ContaminantTypes[eAOFVector].HitTot += 1;
+					pVectContam->HitTot += 1;
+					ReleaseSerialise();
+					}
 				return(QueryLen);
 				}
 			if(pBestVectContam == NULL || NumSubs < LowestNumSubs)
@@ -1229,10 +1251,18 @@ for(VectIdx = 0; VectIdx < m_NumVectContaminates; VectIdx++, pVectContam++)
 	}
 if(pBestVectContam != NULL)
 	{
-	AcquireSerialise();
-	m_ContaminantTypes[eAOFVector].HitTot += 1;
-	pBestVectContam->HitTot += 1;
-	ReleaseSerialise();
+	if(pHitCnts != NULL)
+		{
+		pHitCnts->HitTot[eAOFVector] += 1;
+		pHitCnts->VectHitTot[pBestVectContam - m_ContaminantVectors] += 1;
+		}
+	else
+		{
+		AcquireSerialise();
+		m_ContaminantTypes[eAOFVector].HitTot += 1;
+		pBestVectContam->HitTot += 1;
+		ReleaseSerialise();
+		}
 	return(QueryLen);
 	}
 return(0);
@@ -1244,7 +1274,8 @@ CContaminants::MatchContaminants(teContamType Type,	// process for this overlay
 					int AllowSubsRate,		// if non-zero then allow substitutions in the overlapping Contaminants at this rate per 25bp of overlap length with a minimum of 1 subs allowed
 					int MinOverlap,			// minimum required overlap
 					int QueryLen,			// query sequence length
-					etSeqBase *pQuerySeq)	// attempt to locate a contaminate flanking sequence which overlays onto this query read sequence
+					etSeqBase *pQuerySeq,	// attempt to locate a contaminate flanking sequence which overlays onto this query read sequence
+					tsContamHitCnts *pHitCnts)	// if not NULL then accumulate hit counts into these per thread counts instead of serialising updates to this instance's counts
 {
 int Rslt;
 bool bSuffixOverlaps;
@@ -1271,7 +1302,7 @@ if (m_TotNumContaminants == 0)	// nothing to do?
 // any vector contaminates are processed for containment of this target sequence before processing for contaminate overlays
 if(m_NumVectContaminates)
 	{
-	if((Rslt = MatchVectContams((Type == eAOF5PE1Targ || Type == eAOF5PE1Targ) ? false : true,AllowSubsRate,QueryLen,pQuerySeq)) != 0)
+	if((Rslt = MatchVectContams((Type == eAOF5PE1Targ || Type == eAOF5PE1Targ) ? false : true,AllowSubsRate,QueryLen,pQuerySeq,pHitCnts)) != 0)
 		return(Rslt);
 	}
 
@@ -1284,9 +1315,14 @@ if (pContaminantType->NumContaminants == 0 || pContaminantType->RootContamSeqNod
 CurOverlapLen = min(QueryLen, pContaminantType->MaxContamSeqLen);
 if (CurOverlapLen < MinOverlap)
 	return(0);
-AcquireSerialise();
-pContaminantType->NumChecks += 1;		
-ReleaseSerialise();
+if(pHitCnts != NULL)
+	pHitCnts->NumChecks[Type] += 1;
+else
+	{
+	AcquireSerialise();
+	pContaminantType->NumChecks += 1;
+	ReleaseSerialise();
+	}
 bSuffixOverlaps = (Type == eAOF5PE1Targ || Type == eAOF5PE2Targ) ? true : false;
 if(bSuffixOverlaps)
 	pTargBase = &pQuerySeq[CurOverlapLen-1];
@@ -1311,12 +1347,22 @@ for (OverlapIdx = CurOverlapLen; OverlapIdx >= MinOverlap; OverlapIdx--,bSuffixO
 	if((Rslt=RecursiveMatch(bSuffixOverlaps,MaxAcceptedSubs,OverlapIdx,pTargBase,pTypeRootNode,&ContamID)) >= 0)
 		{
 		pContaminant = &m_pContaminants[ContamID - 1];
-		AcquireSerialise();
-		pContaminantType->HitTot += 1;
-		pContaminantType->HitDist[OverlapIdx] += 1;
-		pContaminant->HitTot += 1;
-		pContaminant->HitDist[OverlapIdx] += 1;
-		ReleaseSerialise();
+		if(pHitCnts != NULL && ContamID <= pHitCnts->NumFlankContams)
+			{
+			pHitCnts->HitTot[Type] += 1;
+			pHitCnts->HitDist[Type][OverlapIdx] += 1;
+			pHitCnts->pFlankHitTot[ContamID - 1] += 1;
+			pHitCnts->pFlankHitDist[((ContamID - 1) * (cMaxContaminantLen+1)) + OverlapIdx] += 1;
+			}
+		else
+			{
+			AcquireSerialise();
+			pContaminantType->HitTot += 1;
+			pContaminantType->HitDist[OverlapIdx] += 1;
+			pContaminant->HitTot += 1;
+			pContaminant->HitDist[OverlapIdx] += 1;
+			ReleaseSerialise();
+			}
 		return(OverlapIdx);
 		}
 	}
@@ -1324,6 +1370,79 @@ for (OverlapIdx = CurOverlapLen; OverlapIdx >= MinOverlap; OverlapIdx--,bSuffixO
 return(0);
 }
 
+tsContamHitCnts *						// returned per thread hit counts, NULL if unable to allocate
+CContaminants::AllocHitCnts(void)		// allocate per thread hit counts for the currently loaded contaminants
+{
+tsContamHitCnts *pHitCnts;
+if((pHitCnts = new tsContamHitCnts) == NULL)
+	return(NULL);
+memset(pHitCnts,0,sizeof(tsContamHitCnts));
+if(m_NumFlankContaminates > 0)
+	{
+	if((pHitCnts->pFlankHitTot = new uint32_t [m_NumFlankContaminates]) == NULL ||
+		(pHitCnts->pFlankHitDist = new uint32_t [m_NumFlankContaminates * (cMaxContaminantLen+1)]) == NULL)
+		{
+		FreeHitCnts(pHitCnts);
+		return(NULL);
+		}
+	memset(pHitCnts->pFlankHitTot,0,sizeof(uint32_t) * m_NumFlankContaminates);
+	memset(pHitCnts->pFlankHitDist,0,sizeof(uint32_t) * m_NumFlankContaminates * (cMaxContaminantLen+1));
+	pHitCnts->NumFlankContams = m_NumFlankContaminates;
+	}
+return(pHitCnts);
+}
+
+void
+CContaminants::MergeHitCnts(tsContamHitCnts *pHitCnts)	// merge per thread hit counts into this instance's counts, pHitCnts are then reset to 0
+{
+int Idx;
+int OverlapIdx;
+tsFlankContam *pContaminant;
+uint32_t *pFlankHitDist;
+if(pHitCnts == NULL)
+	return;
+AcquireSerialise();
+for(Idx = 0; Idx < eAOFPlaceholder; Idx++)
+	{
+	m_ContaminantTypes[Idx].NumChecks += pHitCnts->NumChecks[Idx];
+	m_ContaminantTypes[Idx].HitTot += pHitCnts->HitTot[Idx];
+	for(OverlapIdx = 0; OverlapIdx <= cMaxContaminantLen; OverlapIdx++)
+		m_ContaminantTypes[Idx].HitDist[OverlapIdx] += pHitCnts->HitDist[Idx][OverlapIdx];
+	}
+for(Idx = 0; Idx < m_NumVectContaminates; Idx++)
+	m_ContaminantVectors[Idx].HitTot += pHitCnts->VectHitTot[Idx];
+pContaminant = m_pContaminants;
+pFlankHitDist = pHitCnts->pFlankHitDist;
+for(Idx = 0; Idx < pHitCnts->NumFlankContams && Idx < m_NumFlankContaminates; Idx++, pContaminant++)
+	{
+	pContaminant->HitTot += pHitCnts->pFlankHitTot[Idx];
+	for(OverlapIdx = 0; OverlapIdx <= cMaxContaminantLen; OverlapIdx++, pFlankHitDist++)
+		pContaminant->HitDist[OverlapIdx] += *pFlankHitDist;
+	}
+ReleaseSerialise();
+
+memset(pHitCnts->NumChecks,0,sizeof(pHitCnts->NumChecks));
+memset(pHitCnts->HitTot,0,sizeof(pHitCnts->HitTot));
+memset(pHitCnts->HitDist,0,sizeof(pHitCnts->HitDist));
+memset(pHitCnts->VectHitTot,0,sizeof(pHitCnts->VectHitTot));
+if(pHitCnts->NumFlankContams > 0)
+	{
+	memset(pHitCnts->pFlankHitTot,0,sizeof(uint32_t) * pHitCnts->NumFlankContams);
+	memset(pHitCnts->pFlankHitDist,0,sizeof(uint32_t) * pHitCnts->NumFlankContams * (cMaxContaminantLen+1));
+	}
+}
+
+void
+CContaminants::FreeHitCnts(tsContamHitCnts *pHitCnts)	// free per thread hit counts as allocated by AllocHitCnts()
+{
+if(pHitCnts == NULL)
+	return;
+if(pHitCnts->pFlankHitTot != NULL)
+	delete []pHitCnts->pFlankHitTot;
+if(pHitCnts->pFlankHitDist != NULL)
+	delete []pHitCnts->pFlankHitDist;
+delete pHitCnts;
+}
 
 int 
 CContaminants::NumOfContaminants(teContamClass ComtamClass)			// returns number of contaminants loaded 
@@ -91,6 +91,18 @@ typedef struct TAG_sContamSeqNode {
 
 #pragma pack()
 
+// Loaded contaminant sequences and their index are read only once loaded, only the hit counts are updated when matching
+// Callers matching from multiple threads can provide their own per thread hit counts, these are updated without serialisation and later merged with MergeHitCnts()
+typedef struct TAG_sContamHitCnts {
+	uint32_t NumChecks[eAOFPlaceholder];		// number of times each type was checked for an overlap onto a target sequence
+	uint32_t HitTot[eAOFPlaceholder];			// number of times each type was overlapping onto a target sequence
+	uint32_t HitDist[eAOFPlaceholder][cMaxContaminantLen+1];	// overlap length hit count distribution for all contaminants of each type
+	uint32_t VectHitTot[cMaxNumVectors];		// number of times each vector sequence contained a query read sequence
+	int NumFlankContams;					// pFlankHitTot and pFlankHitDist are allocated for this many flank contaminants
+	uint32_t *pFlankHitTot;					// number of times each flank contaminant was overlapping onto a target sequence
+	uint32_t *pFlankHitDist;				// overlap length hit count distribution for each flank contaminant, cMaxContaminantLen+1 counts per contaminant
+} tsContamHitCnts;
+
 
 class CContaminants
 {
@@ -220,15 +232,21 @@ public:
 		MatchVectContams(bool bIsPE2,		// true if target sequence is a PE2, else if false then target is either a SE or PE1
 					int AllowSubsRate,		// if non-zero then allow substitutions in the overlapping Contaminants at this rate per 25bp of overlap length if overlap >= 10bp
 					int QueryLen,			// query sequence length
-					etSeqBase *pQuerySeq);	// attempt to locate a contaminate vector sequence containing this query read sequence
+					etSeqBase *pQuerySeq,	// attempt to locate a contaminate vector sequence containing this query read sequence
+					tsContamHitCnts *pHitCnts = NULL);	// if not NULL then accumulate hit counts into these per thread counts instead of serialising updates to this instance's counts
 
 	int			// 0 if no Contaminant overlap, 1..N number of Contaminant suffix bases overlaping onto target pTargSeq
 		MatchContaminants(teContamType Type,		// process for this overlay type
 					int AllowSubsRate,		// if non-zero then allow substitutions in the overlapping Contaminants at this rate per 25bp of overlap length with a minimum of 1 subs allowed
 					int MinOverlap,			// minimum required overlap
 					int QueryLen,			// query sequence length
-					etSeqBase *pQuerySeq);	// attempt to locate a contaminate flanking sequence which overlays onto this query read sequence
+					etSeqBase *pQuerySeq,	// attempt to locate a contaminate flanking sequence which overlays onto this query read sequence
+					tsContamHitCnts *pHitCnts = NULL);	// if not NULL then accumulate hit counts into these per thread counts instead of serialising updates to this instance's counts
 
+	tsContamHitCnts *						// returned per thread hit counts, NULL if unable to allocate
+		AllocHitCnts(void);					// allocate per thread hit counts for the currently loaded contaminants
+	void MergeHitCnts(tsContamHitCnts *pHitCnts);	// merge per thread hit counts into this instance's counts, pHitCnts are then reset to 0
+	static void FreeHitCnts(tsContamHitCnts *pHitCnts);	// free per thread hit counts as allocated by AllocHitCnts()
 
 
 	int NumOfContaminants(teContamClass ComtamClass= eCCAllContam);				// returns total number of both flank and vector contaminants
@@ -0,0 +1,1004 @@
+/*
+This toolkit is a source base clone of 'BioKanga' release 4.4.2 (https://github.com/csiro-crop-informatics/biokanga) and contains
+significant source code changes enabling new functionality and resulting process parameterisation changes. These changes have resulted in
+incompatibility with 'BioKanga'.
+
+Because of the potential for confusion by users unaware of functionality and process parameterisation changes then the modified source base
+and resultant compiled executables have been renamed to 'kit4b' - K-mer Informed Toolkit for Bioinformatics.
+The renaming will force users of the 'BioKanga' toolkit to examine scripting which is dependent on existing 'BioKanga'
+parameterisations so as to make appropriate changes if wishing to utilise 'kit4b' parameterisations and functionality.
+
+'kit4b' is being released under the Opensource Software License Agreement (GPLv3)
+'kit4b' is Copyright (c) 2019, 2020
+Please contact Dr Stuart Stephen < stuartjs@g3web.com > if you have any questions regarding 'kit4b'.
+
+Original 'BioKanga' copyright notice has been retained and immediately follows this notice..
+*/
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+// Memory bounded per-cultivar prefix K-mer counting, super K-mers are spilled into minimizer partitions which are then counted in parallel
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include "./commhdrs.h"
+#else
+#include <pthread.h>
+#include "./commhdrs.h"
+#endif
+
+// need for speed rather than space...
+#pragma optimize("t", on)
+
+static int gExtKMerSortWords = 0;		// number of words, K-mer words plus tag, compared when sorting expanded K-mers
+
+// work pool thread functions, context is the CExtKMerCounts instance
+static int ExtKMerSpillSegs(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CExtKMerCounts *)pCtx)->SpillSegs(StartIdx, EndIdx, WorkerIdx));
+}
+
+static int ExtKMerMergeParts(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CExtKMerCounts *)pCtx)->MergeParts(StartIdx, EndIdx, WorkerIdx));
+}
+
+// sort expanded K-mers by packed words then tag ascending
+static int SortExtKMers(const void *arg1, const void *arg2)
+{
+int Idx;
+uint64_t *pEl1 = (uint64_t *)arg1;
+uint64_t *pEl2 = (uint64_t *)arg2;
+for(Idx = 0; Idx < gExtKMerSortWords; Idx++, pEl1++, pEl2++)
+	{
+	if(*pEl1 < *pEl2)
+		return(-1);
+	if(*pEl1 > *pEl2)
+		return(1);
+	}
+return(0);
+}
+
+CExtKMerCounts::CExtKMerCounts(void)
+{
+m_ppEntrySeqs = NULL;
+m_pEntrySeqLens = NULL;
+m_pSegs = NULL;
+m_pWorkers = NULL;
+m_pPartChunks = NULL;
+m_pChunks = NULL;
+m_NumWorkers = 0;
+Reset();
+}
+
+CExtKMerCounts::~CExtKMerCounts(void)
+{
+Reset();
+}
+
+void
+CExtKMerCounts::ResetWorkers(void)
+{
+int WorkerIdx;
+tsExtKMerWorker *pWorker;
+if(m_pWorkers != NULL)
+	{
+	pWorker = m_pWorkers;
+	for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++, pWorker++)
+		{
+		if(pWorker->hSpillFile != -1)
+			{
+			close(pWorker->hSpillFile);
+			remove(pWorker->szSpillFile);
+			}
+		if(pWorker->pPartBuffLens != NULL)
+			delete []pWorker->pPartBuffLens;
+		if(pWorker->pPartBuffs != NULL)
+			free(pWorker->pPartBuffs);
+		if(pWorker->pChunks != NULL)
+			free(pWorker->pChunks);
+		if(pWorker->pRaw != NULL)
+			free(pWorker->pRaw);
+		if(pWorker->pKMers != NULL)
+			free(pWorker->pKMers);
+		if(pWorker->pCultsCnts != NULL)
+			delete pWorker->pCultsCnts;
+		}
+	delete []m_pWorkers;
+	m_pWorkers = NULL;
+	}
+m_NumWorkers = 0;
+}
+
+void
+CExtKMerCounts::Reset(void)
+{
+ResetWorkers();
+if(m_ppEntrySeqs != NULL)
+	{
+	delete []m_ppEntrySeqs;
+	m_ppEntrySeqs = NULL;
+	}
+if(m_pEntrySeqLens != NULL)
+	{
+	delete []m_pEntrySeqLens;
+	m_pEntrySeqLens = NULL;
+	}
+if(m_pSegs != NULL)
+	{
+	delete []m_pSegs;
+	m_pSegs = NULL;
+	}
+if(m_pPartChunks != NULL)
+	{
+	delete []m_pPartChunks;
+	m_pPartChunks = NULL;
+	}
+if(m_pChunks != NULL)
+	{
+	free(m_pChunks);
+	m_pChunks = NULL;
+	}
+m_pSfxArray = NULL;
+m_NumEntries = 0;
+m_NumSegs = 0;
+m_NumParts = 0;
+m_PartBuffSize = 0;
+m_PartBudget = 0;
+m_bSenseOnly = false;
+m_PrefixLen = 0;
+m_SuffixLen = 0;
+m_MinCultivars = 0;
+m_MMerLen = 0;
+m_MMerMsk = 0;
+m_KMerWords = 0;
+m_LastWordShf = 0;
+m_LastWordMsk = 0;
+m_pThis = NULL;
+m_pCallback = NULL;
+}
+
+// RunChunks
+// Process NumItems, one item per chunk, on the shared work pool unless only a single worker
+int
+CExtKMerCounts::RunChunks(int64_t NumItems,		// number of items to process
+				WorkPoolFunc pFunc,				// processing function
+				const char *pszProgress)		// progress message
+{
+int Rslt;
+int64_t StartIdx;
+CWorkPool *pWorkPool;
+
+if(NumItems <= 0)
+	return(eBSFSuccess);
+if(m_NumWorkers > 1 && NumItems > 1 && (pWorkPool = CWorkPool::Shared(m_NumWorkers)) != NULL)
+	return(pWorkPool->ParallelFor(NumItems,1,pFunc,this,60,pszProgress,NULL,NULL,m_NumWorkers));
+
+for(StartIdx = 0; StartIdx < NumItems; StartIdx++)
+	if((Rslt = pFunc(this,StartIdx,StartIdx + 1,0)) < eBSFSuccess)
+		return(Rslt);
+return(eBSFSuccess);
+}
+
+// SpillPart
+// Append worker's buffered super K-mers for partition to the worker's spill file, spill file is created on first use
+int
+CExtKMerCounts::SpillPart(tsExtKMerWorker *pWorker,	// worker
+				int PartIdx)						// spilling this partition
+{
+tsExtKMerChunk *pChunk;
+uint32_t BuffLen;
+
+if((BuffLen = pWorker->pPartBuffLens[PartIdx]) == 0)
+	return(eBSFSuccess);
+
+if(pWorker->hSpillFile == -1)
+	{
+#ifdef _WIN32
+	pWorker->hSpillFile = open(pWorker->szSpillFile,O_CREATETRUNC);
+#else
+	if((pWorker->hSpillFile = open(pWorker->szSpillFile,O_CREATETRUNC))!=-1)
+		if(ftruncate(pWorker->hSpillFile,0)!=0)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to truncate spill file %s - %s",pWorker->szSpillFile,strerror(errno));
+			close(pWorker->hSpillFile);
+			pWorker->hSpillFile = -1;
+			return(eBSFerrCreateFile);
+			}
+#endif
+	if(pWorker->hSpillFile == -1)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to create/truncate spill file '%s'",pWorker->szSpillFile);
+		return(eBSFerrCreateFile);
+		}
+	pWorker->SpillOfs = 0;
+	}
+
+if(pWorker->NumChunks == pWorker->AllocdChunks)
+	{
+	tsExtKMerChunk *pRealloc;
+	if((pRealloc = (tsExtKMerChunk *)realloc(pWorker->pChunks,sizeof(tsExtKMerChunk) * (size_t)(pWorker->AllocdChunks + cAllocExtKMerChunks))) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"SpillPart: unable to allocate memory for spill chunks");
+		return(eBSFerrMem);
+		}
+	pWorker->pChunks = pRealloc;
+	pWorker->AllocdChunks += cAllocExtKMerChunks;
+	}
+
+if(!CUtility::RetryWrites(pWorker->hSpillFile,&pWorker->pPartBuffs[(size_t)PartIdx * m_PartBuffSize],BuffLen))
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"SpillPart: write to spill file '%s' failed",pWorker->szSpillFile);
+	return(eBSFerrFileAccess);
+	}
+pChunk = &pWorker->pChunks[pWorker->NumChunks++];
+pChunk->PartIdx = PartIdx;
+pChunk->WorkerIdx = (int32_t)(pWorker - m_pWorkers);
+pChunk->FileOfs = pWorker->SpillOfs;
+pChunk->Len = BuffLen;
+pWorker->SpillOfs += BuffLen;
+pWorker->pPartBuffLens[PartIdx] = 0;
+return(eBSFSuccess);
+}
+
+// AddSKMer
+// Pack super K-mer bases, 4 per byte with the first base in the high bits, into the buffer for the partition selected by the minimizer hash
+int
+CExtKMerCounts::AddSKMer(tsExtKMerWorker *pWorker,	// worker
+				uint32_t EntryIdx,				// super K-mer is in this entry
+				uint32_t Hash,					// having this minimizer hash
+				etSeqBase *pSeq,				// super K-mer sequence
+				int NumKMers)					// containing this many K-mers
+{
+int Rslt;
+int PartIdx;
+int NumBases;
+int RecLen;
+int Idx;
+uint8_t Packed;
+uint8_t *pBuff;
+tsExtSKMerHdr *pHdr;
+
+NumBases = NumKMers + m_PrefixLen - 1;
+RecLen = (int)sizeof(tsExtSKMerHdr) + ((NumBases + 3) / 4);
+PartIdx = (int)(((uint64_t)Hash * (uint64_t)m_NumParts) >> (2 * m_MMerLen));
+if((pWorker->pPartBuffLens[PartIdx] + RecLen) > m_PartBuffSize)
+	if((Rslt = SpillPart(pWorker,PartIdx)) < eBSFSuccess)
+		return(Rslt);
+
+pBuff = &pWorker->pPartBuffs[((size_t)PartIdx * m_PartBuffSize) + pWorker->pPartBuffLens[PartIdx]];
+pHdr = (tsExtSKMerHdr *)pBuff;
+pHdr->EntryIdx = (uint16_t)EntryIdx;
+pHdr->NumKMers = (uint16_t)NumKMers;
+pBuff += sizeof(tsExtSKMerHdr);
+Packed = 0;
+for(Idx = 0; Idx < NumBases; Idx++, pSeq++)
+	{
+	Packed = (Packed << 2) | (*pSeq & 0x03);
+	if((Idx & 0x03) == 0x03)
+		{
+		*pBuff++ = Packed;
+		Packed = 0;
+		}
+	}
+if(Idx & 0x03)
+	*pBuff = Packed << (2 * (4 - (Idx & 0x03)));
+pWorker->pPartBuffLens[PartIdx] += RecLen;
+pWorker->NumSKMers += 1;
+pWorker->NumKMers += NumKMers;
+return(eBSFSuccess);
+}
+
+// SpillRegion
+// Region contains only canonical bases, each K-mer's minimizer is the lowest hash of the canonical m-mers contained in that K-mer
+// Consecutive K-mers sharing the same minimizer hash are spilled as a single super K-mer
+int
+CExtKMerCounts::SpillRegion(tsExtKMerWorker *pWorker,	// worker
+				uint32_t EntryIdx,				// region is in this entry
+				etSeqBase *pSeq,				// region sequence, all bases canonical
+				uint32_t RegionLen)				// region length, at least m_PrefixLen
+{
+int Rslt;
+uint32_t Ring[cExtKMerRingSize];
+uint32_t WinLen;
+uint32_t Idx;
+uint32_t MMerIdx;
+uint32_t KMerIdx;
+uint32_t ScanIdx;
+uint32_t FwdMMer;
+uint32_t RevMMer;
+uint32_t Hash;
+uint32_t MinHash;
+uint32_t MinIdx;
+uint32_t SKMerHash;
+uint32_t SKMerStart;
+int RevShf;
+etSeqBase Base;
+
+WinLen = (uint32_t)(m_PrefixLen - m_MMerLen + 1);	// each K-mer contains this many m-mers
+RevShf = 2 * (m_MMerLen - 1);
+FwdMMer = 0;
+RevMMer = 0;
+MinHash = 0xffffffff;
+MinIdx = 0;
+SKMerHash = 0;
+SKMerStart = 0;
+for(Idx = 0; Idx < RegionLen; Idx++)
+	{
+	Base = pSeq[Idx] & 0x03;
+	FwdMMer = ((FwdMMer << 2) | Base) & m_MMerMsk;
+	RevMMer = (RevMMer >> 2) | ((uint32_t)(0x03 - Base) << RevShf);
+	if(Idx < (uint32_t)m_MMerLen - 1)
+		continue;
+	MMerIdx = Idx - (m_MMerLen - 1);
+	Hash = HashMMer(FwdMMer < RevMMer ? FwdMMer : RevMMer);
+	Ring[MMerIdx & (cExtKMerRingSize - 1)] = Hash;
+	if(Hash <= MinHash)
+		{
+		MinHash = Hash;
+		MinIdx = MMerIdx;
+		}
+	if(MMerIdx < WinLen - 1)
+		continue;
+	KMerIdx = MMerIdx - (WinLen - 1);
+	if(MinIdx < KMerIdx)		// minimizer no longer in window, rescan window
+		{
+		MinHash = 0xffffffff;
+		for(ScanIdx = KMerIdx; ScanIdx <= MMerIdx; ScanIdx++)
+			if(Ring[ScanIdx & (cExtKMerRingSize - 1)] <= MinHash)
+				{
+				MinHash = Ring[ScanIdx & (cExtKMerRingSize - 1)];
+				MinIdx = ScanIdx;
+				}
+		}
+	if(KMerIdx == 0)
+		SKMerHash = MinHash;
+	else
+		if(MinHash != SKMerHash || (KMerIdx - SKMerStart) == cMaxExtSKMerKMers)
+			{
+			if((Rslt = AddSKMer(pWorker,EntryIdx,SKMerHash,&pSeq[SKMerStart],KMerIdx - SKMerStart)) < eBSFSuccess)
+				return(Rslt);
+			SKMerHash = MinHash;
+			SKMerStart = KMerIdx;
+			}
+	}
+return(AddSKMer(pWorker,EntryIdx,SKMerHash,&pSeq[SKMerStart],RegionLen - m_PrefixLen + 1 - SKMerStart));
+}
+
+// SpillSegs
+// K-mers are counted at positions where the prefix + suffix bases are all canonical, so each maximal canonical run contributes
+// those K-mers fully contained within the run less it's final m_SuffixLen bases
+int
+CExtKMerCounts::SpillSegs(int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+int Rslt;
+tsExtKMerSeg *pSeg;
+tsExtKMerWorker *pWorker;
+etSeqBase *pSeq;
+uint32_t ScanEnd;
+uint32_t RunStart;
+uint32_t RunEnd;
+uint32_t RegionEnd;
+int TargSeqLen;
+
+pWorker = &m_pWorkers[WorkerIdx];
+TargSeqLen = m_PrefixLen + m_SuffixLen;
+for(; StartIdx < EndIdx; StartIdx++)
+	{
+	pSeg = &m_pSegs[StartIdx];
+	pSeq = m_ppEntrySeqs[pSeg->EntryID-1];
+	ScanEnd = (uint32_t)min((uint64_t)pSeg->EndOfs + TargSeqLen - 1,(uint64_t)m_pEntrySeqLens[pSeg->EntryID-1]);
+	RunStart = pSeg->StartOfs;
+	while(RunStart < pSeg->EndOfs)		// runs starting at or after EndOfs contain no K-mers for this segment
+		{
+		if((pSeq[RunStart] & 0x0f) > eBaseT)
+			{
+			RunStart += 1;
+			continue;
+			}
+		for(RunEnd = RunStart + 1; RunEnd < ScanEnd; RunEnd++)
+			if((pSeq[RunEnd] & 0x0f) > eBaseT)
+				break;
+		if((RunEnd - RunStart) >= (uint32_t)TargSeqLen)
+			{
+			RegionEnd = min(RunEnd - m_SuffixLen,pSeg->EndOfs + m_PrefixLen - 1);
+			if((Rslt = SpillRegion(pWorker,pSeg->EntryID-1,&pSeq[RunStart],RegionEnd - RunStart)) < eBSFSuccess)
+				return(Rslt);
+			}
+		RunStart = RunEnd;
+		}
+	}
+return(eBSFSuccess);
+}
+
+// LoadPart
+// Load super K-mers for partition from all workers' spill files followed by all workers' residual partition buffers
+int
+CExtKMerCounts::LoadPart(tsExtKMerWorker *pWorker,	// loading into this worker's pRaw
+				int PartIdx,						// partition to load
+				size_t *pRawLen)					// returned number of bytes loaded
+{
+int64_t ChunkIdx;
+int WorkerIdx;
+size_t RawLen;
+size_t RdLen;
+int NumRead;
+uint8_t *pDst;
+tsExtKMerChunk *pChunk;
+tsExtKMerWorker *pSrc;
+
+*pRawLen = 0;
+RawLen = 0;
+for(ChunkIdx = m_pPartChunks[PartIdx]; ChunkIdx < m_pPartChunks[PartIdx+1]; ChunkIdx++)
+	RawLen += (size_t)m_pChunks[ChunkIdx].Len;
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+	RawLen += m_pWorkers[WorkerIdx].pPartBuffLens[PartIdx];
+if(RawLen == 0)
+	return(eBSFSuccess);
+
+if(RawLen > pWorker->AllocdRaw)
+	{
+	uint8_t *pRealloc;
+	size_t AllocRaw = RawLen + (RawLen / 4);
+	if((pRealloc = (uint8_t *)realloc(pWorker->pRaw,AllocRaw)) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"LoadPart: unable to allocate %zd bytes for partition %d",(int64_t)AllocRaw,PartIdx);
+		return(eBSFerrMem);
+		}
+	pWorker->pRaw = pRealloc;
+	pWorker->AllocdRaw = AllocRaw;
+	}
+
+pDst = pWorker->pRaw;
+for(ChunkIdx = m_pPartChunks[PartIdx]; ChunkIdx < m_pPartChunks[PartIdx+1]; ChunkIdx++)
+	{
+	pChunk = &m_pChunks[ChunkIdx];
+	pSrc = &m_pWorkers[pChunk->WorkerIdx];
+	// other merging workers may be concurrently reading from the same spill file
+#ifdef _WIN32
+	while(InterlockedCompareExchange(&pSrc->CASLock,1,0)!=0)
+		SwitchToThread();
+#else
+	while(__sync_val_compare_and_swap(&pSrc->CASLock,0,1)!=0)
+		sched_yield();
+#endif
+	if(_lseeki64(pSrc->hSpillFile,pChunk->FileOfs,SEEK_SET) != pChunk->FileOfs)
+		NumRead = -1;
+	else
+		{
+		RdLen = (size_t)pChunk->Len;
+		while(RdLen > 0 && (NumRead = read(pSrc->hSpillFile,pDst,(int)min(RdLen,(size_t)0x03fffffff))) > 0)
+			{
+			pDst += NumRead;
+			RdLen -= NumRead;
+			}
+		if(RdLen > 0)
+			NumRead = -1;
+		}
+#ifdef _WIN32
+	InterlockedCompareExchange(&pSrc->CASLock,0,1);
+#else
+	__sync_val_compare_and_swap(&pSrc->CASLock,1,0);
+#endif
+	if(NumRead < 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"LoadPart: failed reading from spill file '%s'",pSrc->szSpillFile);
+		return(eBSFerrFileAccess);
+		}
+	}
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+	{
+	pSrc = &m_pWorkers[WorkerIdx];
+	if(pSrc->pPartBuffLens[PartIdx])
+		{
+		memcpy(pDst,&pSrc->pPartBuffs[(size_t)PartIdx * m_PartBuffSize],pSrc->pPartBuffLens[PartIdx]);
+		pDst += pSrc->pPartBuffLens[PartIdx];
+		}
+	}
+*pRawLen = RawLen;
+return(eBSFSuccess);
+}
+
+// ExpandPart
+// Each K-mer in the loaded super K-mers is packed left aligned, 2 bits per base, into m_KMerWords words in both sense and antisense and
+// the lexicographically lower retained as the canonical K-mer. K-mer is tagged with it's entry and whether it was the antisense
+// Partitions whose expanded K-mers would exceed m_PartBudget are expanded in multiple passes, each pass retaining only those canonical
+// K-mers hashing to that pass so all instances of a canonical K-mer are expanded, and counted, in the same pass
+int64_t
+CExtKMerCounts::ExpandPart(tsExtKMerWorker *pWorker,	// expanding pWorker->pRaw into pWorker->pKMers
+				size_t RawLen,						// loaded bytes
+				int64_t NumKMers,					// loaded super K-mers contain this many K-mers
+				int Pass,							// only expanding K-mers belonging to this pass
+				int NumPasses)						// partition is being expanded in this many passes
+{
+int64_t NumExpanded;
+size_t AllocKMers;
+size_t RawOfs;
+tsExtSKMerHdr *pHdr;
+uint8_t *pPacked;
+uint64_t Fwd[(cMaxCultivarPreSufLen + 31) / 32];
+uint64_t Rev[(cMaxCultivarPreSufLen + 31) / 32];
+uint64_t *pKMer;
+uint64_t *pCanon;
+int NumBases;
+int BaseIdx;
+int WordIdx;
+int Cmp;
+int Stride;
+uint64_t Base;
+uint64_t PassHash;
+uint64_t *pRealloc;
+
+// when multiple passes then initially allocate for the expected number of K-mers per pass, extending if that pass has more
+Stride = m_KMerWords + 1;
+NumExpanded = 0;
+if(NumPasses > 1)
+	NumKMers = (NumKMers + NumPasses - 1) / NumPasses;
+if((size_t)NumKMers > pWorker->AllocdKMers)
+	{
+	AllocKMers = (size_t)NumKMers + ((size_t)NumKMers / 4);
+	if((pRealloc = (uint64_t *)realloc(pWorker->pKMers,AllocKMers * Stride * sizeof(uint64_t))) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"ExpandPart: unable to allocate memory for %zd K-mers",NumKMers);
+		return(eBSFerrMem);
+		}
+	pWorker->pKMers = pRealloc;
+	pWorker->AllocdKMers = AllocKMers;
+	}
+
+pKMer = pWorker->pKMers;
+for(RawOfs = 0; RawOfs < RawLen; RawOfs += sizeof(tsExtSKMerHdr) + ((NumBases + 3) / 4))
+	{
+	pHdr = (tsExtSKMerHdr *)&pWorker->pRaw[RawOfs];
+	pPacked = (uint8_t *)&pHdr[1];
+	NumBases = pHdr->NumKMers + m_PrefixLen - 1;
+	memset(Fwd,0,sizeof(uint64_t) * m_KMerWords);
+	memset(Rev,0,sizeof(uint64_t) * m_KMerWords);
+	for(BaseIdx = 0; BaseIdx < NumBases; BaseIdx++)
+		{
+		Base = (pPacked[BaseIdx >> 2] >> (2 * (3 - (BaseIdx & 0x03)))) & 0x03;
+		// sense shifts left with base appended as last base
+		for(WordIdx = 0; WordIdx < m_KMerWords - 1; WordIdx++)
+			Fwd[WordIdx] = (Fwd[WordIdx] << 2) | (Fwd[WordIdx+1] >> 62);
+		Fwd[WordIdx] = ((Fwd[WordIdx] << 2) & m_LastWordMsk) | (Base << m_LastWordShf);
+		// antisense shifts right with complement base prepended as first base
+		for(WordIdx = m_KMerWords - 1; WordIdx > 0; WordIdx--)
+			Rev[WordIdx] = (Rev[WordIdx] >> 2) | (Rev[WordIdx-1] << 62);
+		Rev[0] = (Rev[0] >> 2) | ((0x03 - Base) << 62);
+		Rev[m_KMerWords - 1] &= m_LastWordMsk;
+		if(BaseIdx < m_PrefixLen - 1)
+			continue;
+
+		Cmp = 0;
+		for(WordIdx = 0; WordIdx < m_KMerWords; WordIdx++)
+			if(Fwd[WordIdx] != Rev[WordIdx])
+				{
+				Cmp = Fwd[WordIdx] < Rev[WordIdx] ? -1 : 1;
+				break;
+				}
+		pCanon = Cmp <= 0 ? Fwd : Rev;
+		if(NumPasses > 1)
+			{
+			PassHash = 0;
+			for(WordIdx = 0; WordIdx < m_KMerWords; WordIdx++)
+				{
+				PassHash = (PassHash ^ pCanon[WordIdx]) * 0x9e3779b97f4a7c15;
+				PassHash ^= PassHash >> 29;
+				}
+			if((int)(PassHash % (uint64_t)NumPasses) != Pass)
+				continue;
+			if((size_t)NumExpanded == pWorker->AllocdKMers)
+				{
+				AllocKMers = pWorker->AllocdKMers + (pWorker->AllocdKMers / 4) + 1;
+				if((pRealloc = (uint64_t *)realloc(pWorker->pKMers,AllocKMers * Stride * sizeof(uint64_t))) == NULL)
+					{
+					gDiagnostics.DiagOut(eDLFatal,gszProcName,"ExpandPart: unable to allocate memory for %zd K-mers",(int64_t)AllocKMers);
+					return(eBSFerrMem);
+					}
+				pWorker->pKMers = pRealloc;
+				pWorker->AllocdKMers = AllocKMers;
+				pKMer = &pRealloc[NumExpanded * Stride];
+				}
+			}
+		for(WordIdx = 0; WordIdx < m_KMerWords; WordIdx++)
+			*pKMer++ = pCanon[WordIdx];
+		*pKMer++ = ((uint64_t)pHdr->EntryIdx << 1) | (Cmp > 0 ? 1 : 0);
+		NumExpanded += 1;
+		}
+	}
+return(NumExpanded);
+}
+
+// CountPart
+// Expanded K-mers are sorted so all instances of a canonical K-mer are adjacent and ordered by entry, then for each canonical K-mer
+// counts are returned for both the canonical K-mer and, if not palindromic, for it's reverse complement
+int
+CExtKMerCounts::CountPart(tsExtKMerWorker *pWorker,	// counting pWorker->pKMers
+				int64_t NumKMers)					// number of expanded K-mers
+{
+int Rslt;
+int Stride;
+int BaseIdx;
+int64_t KMerIdx;
+int64_t EndIdx;
+uint64_t *pKMer;
+uint64_t *pGroup;
+uint64_t Tag;
+uint32_t EntryIdx;
+uint32_t PrevEntryIdx;
+bool bEntryFwd;
+bool bEntryRev;
+uint64_t FwdCnts;
+uint64_t RevCnts;
+uint32_t FwdCults;
+uint32_t RevCults;
+uint32_t AnyCults;
+bool bPalindrome;
+etSeqBase *pSeq;
+tsKMerCultsCnts *pCultsCnts;
+
+Stride = m_KMerWords + 1;
+if(NumKMers > 1)
+	qsort(pWorker->pKMers,(size_t)NumKMers,sizeof(uint64_t) * Stride,SortExtKMers);
+
+pCultsCnts = pWorker->pCultsCnts;
+for(KMerIdx = 0; KMerIdx < NumKMers; KMerIdx = EndIdx)
+	{
+	pGroup = &pWorker->pKMers[KMerIdx * Stride];
+	FwdCnts = RevCnts = 0;
+	FwdCults = RevCults = AnyCults = 0;
+	PrevEntryIdx = 0xffffffff;
+	bEntryFwd = bEntryRev = false;
+	for(EndIdx = KMerIdx; EndIdx < NumKMers; EndIdx++)
+		{
+		pKMer = &pWorker->pKMers[EndIdx * Stride];
+		if(EndIdx > KMerIdx && memcmp(pKMer,pGroup,sizeof(uint64_t) * m_KMerWords))
+			break;
+		Tag = pKMer[m_KMerWords];
+		EntryIdx = (uint32_t)(Tag >> 1);
+		if(EntryIdx != PrevEntryIdx)
+			{
+			bEntryFwd = bEntryRev = false;
+			AnyCults += 1;
+			PrevEntryIdx = EntryIdx;
+			}
+		if(Tag & 0x01)
+			{
+			RevCnts += 1;
+			if(!bEntryRev)
+				{
+				RevCults += 1;
+				bEntryRev = true;
+				}
+			}
+		else
+			{
+			FwdCnts += 1;
+			if(!bEntryFwd)
+				{
+				FwdCults += 1;
+				bEntryFwd = true;
+				}
+			}
+		}
+
+	// unpack canonical K-mer, palindromic if identical to it's reverse complement
+	pSeq = pCultsCnts->KMerSeq;
+	for(BaseIdx = 0; BaseIdx < m_PrefixLen; BaseIdx++)
+		*pSeq++ = (etSeqBase)((pGroup[BaseIdx >> 5] >> (62 - (2 * (BaseIdx & 0x1f)))) & 0x03);
+	*pSeq = eBaseEOS;
+	bPalindrome = true;
+	for(BaseIdx = 0; BaseIdx < m_PrefixLen / 2; BaseIdx++)
+		if(pCultsCnts->KMerSeq[BaseIdx] != (0x03 - pCultsCnts->KMerSeq[m_PrefixLen - 1 - BaseIdx]))
+			{
+			bPalindrome = false;
+			break;
+			}
+	if(m_PrefixLen & 0x01)		// odd length K-mers can never be palindromic
+		bPalindrome = false;
+
+	if(FwdCnts)
+		{
+		pWorker->NumLocated += 1;
+		pCultsCnts->SenseCnts = FwdCnts;
+		if(m_bSenseOnly)
+			{
+			pCultsCnts->AntisenseCnts = 0;
+			pCultsCnts->NumCultivars = FwdCults;
+			}
+		else
+			{
+			pCultsCnts->AntisenseCnts = bPalindrome ? FwdCnts : RevCnts;
+			pCultsCnts->NumCultivars = AnyCults;
+			}
+		if(pCultsCnts->NumCultivars >= (uint32_t)m_MinCultivars)
+			if((Rslt = (*m_pCallback)(m_pThis,pCultsCnts)) < 0)
+				return(Rslt);
+		}
+
+	if(RevCnts)
+		{
+		pWorker->NumLocated += 1;
+		CSeqTrans::ReverseComplement(m_PrefixLen,pCultsCnts->KMerSeq);
+		pCultsCnts->SenseCnts = RevCnts;
+		if(m_bSenseOnly)
+			{
+			pCultsCnts->AntisenseCnts = 0;
+			pCultsCnts->NumCultivars = RevCults;
+			}
+		else
+			{
+			pCultsCnts->AntisenseCnts = FwdCnts;
+			pCultsCnts->NumCultivars = AnyCults;
+			}
+		if(pCultsCnts->NumCultivars >= (uint32_t)m_MinCultivars)
+			if((Rslt = (*m_pCallback)(m_pThis,pCultsCnts)) < 0)
+				return(Rslt);
+		}
+	}
+return(eBSFSuccess);
+}
+
+// MergeParts
+// Count K-mers in partitions, all K-mers and their reverse complements are in the same partition
+int
+CExtKMerCounts::MergeParts(int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+int Rslt;
+int Pass;
+int NumPasses;
+size_t RawLen;
+size_t RawOfs;
+int64_t NumKMers;
+int64_t NumExpanded;
+tsExtSKMerHdr *pHdr;
+tsExtKMerWorker *pWorker;
+
+pWorker = &m_pWorkers[WorkerIdx];
+if(pWorker->pCultsCnts == NULL)
+	{
+	if((pWorker->pCultsCnts = new tsKMerCultsCnts) == NULL)
+		return(eBSFerrMem);
+	memset(pWorker->pCultsCnts,0,sizeof(tsKMerCultsCnts));
+	}
+for(; StartIdx < EndIdx; StartIdx++)
+	{
+	if((Rslt = LoadPart(pWorker,(int)StartIdx,&RawLen)) < eBSFSuccess)
+		return(Rslt);
+	if(RawLen == 0)
+		continue;
+
+	// count K-mers so the number of passes required to keep expanded K-mers within the worker's share of the budget is known
+	NumKMers = 0;
+	for(RawOfs = 0; RawOfs < RawLen; RawOfs += sizeof(tsExtSKMerHdr) + ((pHdr->NumKMers + m_PrefixLen - 1 + 3) / 4))
+		{
+		pHdr = (tsExtSKMerHdr *)&pWorker->pRaw[RawOfs];
+		NumKMers += pHdr->NumKMers;
+		}
+	NumPasses = (int)max((int64_t)1,((NumKMers * (m_KMerWords + 1) * (int64_t)sizeof(uint64_t)) + m_PartBudget - 1) / m_PartBudget);
+	for(Pass = 0; Pass < NumPasses; Pass++)
+		{
+		if((NumExpanded = ExpandPart(pWorker,RawLen,NumKMers,Pass,NumPasses)) < 0)
+			return((int)NumExpanded);
+		if((Rslt = CountPart(pWorker,NumExpanded)) < eBSFSuccess)
+			return(Rslt);
+		}
+	}
+return(eBSFSuccess);
+}
+
+int64_t
+CExtKMerCounts::GenKMerCultsCnts(CSfxArray *pSfxArray,	// count K-mers in sequences of this suffix array, suffix block containing sequences must have been loaded
+				bool bSenseOnly,				// true if sense strand only processing, default is to process both sense and antisense
+				int PrefixKMerLen,				// report on K-Mers having this prefix sequence length
+				int SuffixKMerLen,				// and allow for the K-mers containing suffixes of this length (can be 0)
+				int MinCultivars,				// only report if K-Mers present in at least this many different cultivars (0 if must be present in all cultivars)
+				int MemBudgetMB,				// target memory budget in MB, at least cMinExtKMerMemMB
+				char *pszSpillPrefix,			// spill files are named with this prefix
+				int NumThreads,					// use at most this many threads
+				void *pThis,					// callers class instance
+				int (* pCallback)(void *pThis,tsKMerCultsCnts *pCultsCnts)) // callback on K-Mers
+{
+int Rslt;
+uint32_t EntryID;
+uint32_t StartOfs;
+uint64_t TotSeqsLen;
+int64_t Budget;
+int64_t NumParts;
+int64_t MaxPartBuffs;
+int64_t ExpandedLen;
+int ReqWorkers;
+int64_t NumChunks;
+int64_t NumSKMers;
+int64_t NumKMers;
+int64_t NumSpilled;
+int64_t NumLocated;
+int64_t ChunkIdx;
+int PartIdx;
+int WorkerIdx;
+tsExtKMerWorker *pWorker;
+CWorkPool *pWorkPool;
+CRunPhase Phase;
+
+Reset();
+if(pSfxArray == NULL || pCallback == NULL || pszSpillPrefix == NULL || pszSpillPrefix[0] == '\0' ||
+   PrefixKMerLen < cMinCultivarPreSufLen || SuffixKMerLen < 0 ||
+   PrefixKMerLen > cMaxCultivarPreSufLen || SuffixKMerLen > cMaxCultivarPreSufLen ||
+   (PrefixKMerLen + SuffixKMerLen) > cTotCultivarKMerLen ||
+   MinCultivars < 0 || MemBudgetMB < cMinExtKMerMemMB)
+	return(eBSFerrParams);
+
+m_NumEntries = (uint32_t)pSfxArray->GetNumEntries();
+if(m_NumEntries == 0)
+	return(eBSFerrNoEntries);
+if(m_NumEntries > cMaxCultivars || (uint32_t)MinCultivars > m_NumEntries)
+	return(eBSFerrParams);
+if(MinCultivars == 0)
+	MinCultivars = m_NumEntries;
+
+m_pSfxArray = pSfxArray;
+m_bSenseOnly = bSenseOnly;
+m_PrefixLen = PrefixKMerLen;
+m_SuffixLen = SuffixKMerLen;
+m_MinCultivars = MinCultivars;
+m_pThis = pThis;
+m_pCallback = pCallback;
+m_MMerLen = min(PrefixKMerLen,cExtKMerMMerLen);
+m_MMerMsk = ((uint32_t)1 << (2 * m_MMerLen)) - 1;
+m_KMerWords = (PrefixKMerLen + 31) / 32;
+m_LastWordShf = 64 - (2 * (PrefixKMerLen - (32 * (m_KMerWords - 1))));
+m_LastWordMsk = ~(uint64_t)0 << m_LastWordShf;
+gExtKMerSortWords = m_KMerWords + 1;
+
+// only sequences in the currently loaded suffix block are counted, other entries are treated as being zero length
+if((m_ppEntrySeqs = new etSeqBase *[m_NumEntries]) == NULL ||
+	(m_pEntrySeqLens = new uint32_t [m_NumEntries]) == NULL)
+	{
+	Reset();
+	return(eBSFerrMem);
+	}
+TotSeqsLen = 0;
+m_NumSegs = 0;
+for(EntryID = 1; EntryID <= m_NumEntries; EntryID++)
+	{
+	if((m_ppEntrySeqs[EntryID-1] = pSfxArray->GetLoadedSeqPtr(EntryID)) != NULL)
+		m_pEntrySeqLens[EntryID-1] = pSfxArray->GetSeqLen(EntryID);
+	else
+		m_pEntrySeqLens[EntryID-1] = 0;
+	TotSeqsLen += m_pEntrySeqLens[EntryID-1];
+	m_NumSegs += (m_pEntrySeqLens[EntryID-1] + cExtKMerSegLen - 1) / cExtKMerSegLen;
+	}
+if((m_pSegs = new tsExtKMerSeg [max(m_NumSegs,(int64_t)1)]) == NULL)
+	{
+	Reset();
+	return(eBSFerrMem);
+	}
+m_NumSegs = 0;
+for(EntryID = 1; EntryID <= m_NumEntries; EntryID++)
+	for(StartOfs = 0; StartOfs < m_pEntrySeqLens[EntryID-1]; StartOfs += cExtKMerSegLen)
+		{
+		m_pSegs[m_NumSegs].EntryID = EntryID;
+		m_pSegs[m_NumSegs].StartOfs = StartOfs;
+		m_pSegs[m_NumSegs++].EndOfs = m_pEntrySeqLens[EntryID-1] - StartOfs > cExtKMerSegLen ? StartOfs + cExtKMerSegLen : m_pEntrySeqLens[EntryID-1];
+		}
+
+m_NumWorkers = 1;
+if(NumThreads > 1 && (pWorkPool = CWorkPool::Shared(NumThreads)) != NULL)
+	m_NumWorkers = pWorkPool->JobWorkers(NumThreads);
+
+// half the budget is for merging, with each concurrently merged partition's expanded K-mers sized to fit within a worker's share,
+// the other half is for the workers' partition buffers whilst spilling
+// partition buffers are at least cMinExtKMerPartBuff so if workers * partitions buffers would exceed their half then first reduce the
+// number of partitions, and if still exceeding then reduce the number of workers
+Budget = (int64_t)MemBudgetMB * 0x0100000;
+MaxPartBuffs = (Budget / 2) / cMinExtKMerPartBuff;
+ReqWorkers = m_NumWorkers;
+m_PartBudget = max((int64_t)1,(Budget / 2) / m_NumWorkers);
+ExpandedLen = (int64_t)(TotSeqsLen * sizeof(uint64_t) * (m_KMerWords + 1));
+NumParts = (ExpandedLen + m_PartBudget - 1) / m_PartBudget;
+m_NumParts = (int)min((int64_t)cMaxExtKMerParts,max((int64_t)cMinExtKMerParts,NumParts));
+if((int64_t)m_NumWorkers * m_NumParts > MaxPartBuffs)
+	m_NumParts = (int)max((int64_t)cMinExtKMerParts,MaxPartBuffs / m_NumWorkers);
+if((int64_t)m_NumWorkers * m_NumParts > MaxPartBuffs)
+	{
+	m_NumWorkers = (int)max((int64_t)1,MaxPartBuffs / m_NumParts);
+	m_PartBudget = max((int64_t)1,(Budget / 2) / m_NumWorkers);
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"External K-mer counting: memory budget of %dMB only allows for %d of %d requested workers",MemBudgetMB,m_NumWorkers,ReqWorkers);
+	}
+if((int64_t)m_NumParts * m_PartBudget < ExpandedLen)
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"External K-mer counting: memory budget of %dMB is insufficient for %d partitions, partitions will be counted in multiple passes",MemBudgetMB,m_NumParts);
+m_PartBuffSize = (uint32_t)min((int64_t)0x01000000,max((int64_t)cMinExtKMerPartBuff,(Budget / 2) / ((int64_t)m_NumWorkers * m_NumParts)));
+
+if((m_pWorkers = new tsExtKMerWorker [m_NumWorkers]) == NULL)
+	{
+	Reset();
+	return(eBSFerrMem);
+	}
+memset(m_pWorkers,0,sizeof(tsExtKMerWorker) * m_NumWorkers);
+pWorker = m_pWorkers;
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++, pWorker++)
+	{
+	pWorker->hSpillFile = -1;
+	sprintf(pWorker->szSpillFile,"%s.kmc%d.tmp",pszSpillPrefix,WorkerIdx + 1);
+	if((pWorker->pPartBuffLens = new uint32_t [m_NumParts]) == NULL ||
+		(pWorker->pPartBuffs = (uint8_t *)malloc((size_t)m_NumParts * m_PartBuffSize)) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"GenKMerCultsCnts: unable to allocate memory for partition buffers");
+		Reset();
+		return(eBSFerrMem);
+		}
+	memset(pWorker->pPartBuffLens,0,sizeof(uint32_t) * m_NumParts);
+	}
+
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"External K-mer counting: %zd bases in %zd segments over %u sequences, %d partitions, %d workers, %u byte partition buffers",
+						(int64_t)TotSeqsLen,m_NumSegs,m_NumEntries,m_NumParts,m_NumWorkers,m_PartBuffSize);
+
+Phase.Begin("kmc_spill");
+if((Rslt = RunChunks(m_NumSegs,ExtKMerSpillSegs,"Progress: spilling super K-mers")) < eBSFSuccess)
+	{
+	Reset();
+	return(Rslt);
+	}
+
+// index spilled chunks by partition
+NumChunks = 0;
+NumSKMers = 0;
+NumKMers = 0;
+NumSpilled = 0;
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+	{
+	pWorker = &m_pWorkers[WorkerIdx];
+	NumChunks += pWorker->NumChunks;
+	NumSKMers += pWorker->NumSKMers;
+	NumKMers += pWorker->NumKMers;
+	NumSpilled += pWorker->SpillOfs;
+	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"External K-mer counting: %zd K-mers in %zd super K-mers, %zd bytes spilled in %zd chunks",NumKMers,NumSKMers,NumSpilled,NumChunks);
+
+if((m_pPartChunks = new int64_t [m_NumParts + 1]) == NULL ||
+	(m_pChunks = (tsExtKMerChunk *)malloc(sizeof(tsExtKMerChunk) * (size_t)max(NumChunks,(int64_t)1))) == NULL)
+	{
+	Reset();
+	return(eBSFerrMem);
+	}
+memset(m_pPartChunks,0,sizeof(int64_t) * (m_NumParts + 1));
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+	for(ChunkIdx = 0; ChunkIdx < m_pWorkers[WorkerIdx].NumChunks; ChunkIdx++)
+		m_pPartChunks[m_pWorkers[WorkerIdx].pChunks[ChunkIdx].PartIdx + 1] += 1;
+for(PartIdx = 0; PartIdx < m_NumParts; PartIdx++)
+	m_pPartChunks[PartIdx + 1] += m_pPartChunks[PartIdx];
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+	{
+	pWorker = &m_pWorkers[WorkerIdx];
+	for(ChunkIdx = 0; ChunkIdx < pWorker->NumChunks; ChunkIdx++)
+		m_pChunks[m_pPartChunks[pWorker->pChunks[ChunkIdx].PartIdx]++] = pWorker->pChunks[ChunkIdx];
+	free(pWorker->pChunks);
+	pWorker->pChunks = NULL;
+	pWorker->NumChunks = pWorker->AllocdChunks = 0;
+	}
+for(PartIdx = m_NumParts; PartIdx > 0; PartIdx--)
+	m_pPartChunks[PartIdx] = m_pPartChunks[PartIdx - 1];
+m_pPartChunks[0] = 0;
+
+Phase.Begin("kmc_merge");
+if((Rslt = RunChunks(m_NumParts,ExtKMerMergeParts,"Progress: counting K-mer partitions")) < eBSFSuccess)
+	{
+	Reset();
+	return(Rslt);
+	}
+Phase.End();
+
+NumLocated = 0;
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+	NumLocated += m_pWorkers[WorkerIdx].NumLocated;
+Reset();
+return(NumLocated);
+}
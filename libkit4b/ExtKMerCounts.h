@@ -0,0 +1,162 @@
+#pragma once
+// Memory bounded, disk spilling, per-cultivar counting of prefix K-mers over the sequences in a loaded CSfxArray suffix block
+// An alternative to CSfxArray::GenKMerCultsCnts() which iterates the suffix array, here only the entry sequences are accessed so the suffix block
+// can be memory mapped and the suffix array pages are never touched
+// Counting is in two phases, both processed on the shared CWorkPool:
+// Spill - entry sequences are segmented, K-mers in each segment are grouped into super K-mers (runs of consecutive K-mers sharing the same canonical
+//         minimizer) and each super K-mer is packed 2 bits per base into the calling worker's buffer for the partition selected by that minimizer.
+//         Full partition buffers are appended to the worker's spill file so workers never contend
+// Merge - partitions are processed in parallel, the super K-mers for a partition are loaded from all workers' spill files and residual buffers,
+//         expanded into canonical K-mers, sorted and then the sense and antisense per-cultivar counts for each K-mer are returned via callback
+// As minimizers are canonical a K-mer and it's reverse complement are always in the same partition, so sense and antisense counts are resolved
+// without reference to any other partition
+// K-mer prefixes are counted at positions where the prefix plus suffix bases are all canonical, as counted by GenKMerCultsCnts(); the
+// homozygotic suffix check of GenKMerCultsCnts() requires suffix array ordering and is not supported
+
+const int cMinExtKMerMemMB = 256;				// memory budget must be at least this many MB
+const int cExtKMerMMerLen = 15;					// minimizers are canonical m-mers of this length, or the K-mer length if shorter
+const int cExtKMerRingSize = 256;				// minimizer window hashes are held in a ring buffer of this size, must be a power of 2 larger than any window
+const int cMaxExtSKMerKMers = 1024;				// super K-mers contain at most this many K-mers
+const uint32_t cExtKMerSegLen = 0x0100000;		// entry sequences are spilled in segments of at most this many K-mer starts
+const int cMinExtKMerParts = 16;				// at least this many partitions
+const int cMaxExtKMerParts = 4096;				// at most this many partitions
+const int cMinExtKMerPartBuff = 0x04000;		// each worker's partition buffers are at least this many bytes
+const int cAllocExtKMerChunks = 0x010000;		// spill chunk descriptors are allocated in this many increments
+
+#pragma pack(1)
+typedef struct TAG_sExtSKMerHdr {				// each super K-mer is prefixed by this header, packed bases immediately follow
+	uint16_t EntryIdx;							// super K-mer is in this cultivar (suffix array EntryID - 1)
+	uint16_t NumKMers;							// and contains this many K-mers, so NumKMers + KMerLen - 1 bases
+	} tsExtSKMerHdr;
+#pragma pack()
+
+#pragma pack(8)
+typedef struct TAG_sExtKMerSeg {
+	uint32_t EntryID;							// segment is in this entry
+	uint32_t StartOfs;							// K-mers starting from this offset
+	uint32_t EndOfs;							// until immediately before this offset
+	} tsExtKMerSeg;
+
+typedef struct TAG_sExtKMerChunk {
+	int32_t PartIdx;							// chunk contains super K-mers for this partition
+	int32_t WorkerIdx;							// spilled by this worker
+	int64_t FileOfs;							// starting at this offset in the worker's spill file
+	int64_t Len;								// chunk is this many bytes
+	} tsExtKMerChunk;
+
+typedef struct TAG_sExtKMerWorker {
+	volatile unsigned int CASLock;				// serialises merge phase reads of this worker's spill file
+	int hSpillFile;							// spill file handle, -1 if not yet created
+	char szSpillFile[_MAX_PATH];				// spill file name
+	int64_t SpillOfs;							// next chunk will be spilled at this file offset
+	uint32_t *pPartBuffLens;					// number of bytes currently buffered for each partition
+	uint8_t *pPartBuffs;						// partition buffers, each m_PartBuffSize bytes
+	int64_t NumChunks;							// number of chunks spilled
+	int64_t AllocdChunks;						// pChunks allocated to hold this many chunks
+	tsExtKMerChunk *pChunks;					// spilled chunks
+	size_t AllocdRaw;							// merge: pRaw allocated to hold this many bytes
+	uint8_t *pRaw;								// merge: super K-mers for current partition
+	size_t AllocdKMers;							// merge: pKMers allocated to hold this many K-mers
+	uint64_t *pKMers;							// merge: expanded canonical K-mers, each m_KMerWords packed words followed by a (EntryIdx << 1 | antisense) tag
+	tsKMerCultsCnts *pCultsCnts;				// merge: returned to caller
+	int64_t NumSKMers;							// number of super K-mers spilled or buffered
+	int64_t NumKMers;							// number of K-mers in those super K-mers
+	int64_t NumLocated;							// merge: number of distinct K-mers with sense counts
+	} tsExtKMerWorker;
+#pragma pack()
+
+class CExtKMerCounts
+{
+	CSfxArray *m_pSfxArray;						// counting K-mers in sequences of this suffix array
+	uint32_t m_NumEntries;						// number of suffix array entries
+	etSeqBase **m_ppEntrySeqs;					// ptrs to each entry sequence in the loaded suffix block
+	uint32_t *m_pEntrySeqLens;					// length of each entry sequence
+
+	bool m_bSenseOnly;							// true if sense only counts
+	int m_PrefixLen;							// counting prefix K-mers of this length
+	int m_SuffixLen;							// which are followed by at least this many canonical bases
+	int m_MinCultivars;							// only return K-mers present in at least this many cultivars
+	int m_MMerLen;								// minimizer m-mer length
+	uint32_t m_MMerMsk;							// m-mers and their hashes are masked to 2 * m_MMerLen bits
+	int m_KMerWords;							// K-mers are packed into this many 64bit words
+	int m_LastWordShf;							// last K-mer base is at this bit offset in last word
+	uint64_t m_LastWordMsk;						// bits used in last word
+	void *m_pThis;								// callers instance
+	int (*m_pCallback)(void *pThis,tsKMerCultsCnts *pCultsCnts);	// callback on counted K-mers
+
+	int m_NumParts;								// number of partitions
+	uint32_t m_PartBuffSize;					// each worker partition buffer is this many bytes
+	int64_t m_PartBudget;						// each merging worker's expanded K-mers should fit within this many bytes
+	int64_t m_NumSegs;							// number of entry segments
+	tsExtKMerSeg *m_pSegs;						// entry segments
+	int m_NumWorkers;							// number of workers
+	tsExtKMerWorker *m_pWorkers;				// per worker state
+	int64_t *m_pPartChunks;						// chunks for partition N are m_pChunks[m_pPartChunks[N]] up to m_pChunks[m_pPartChunks[N+1]]
+	tsExtKMerChunk *m_pChunks;					// all workers' chunks ordered by partition
+
+	void ResetWorkers(void);					// delete spill files and release per worker state
+	int RunChunks(int64_t NumItems,				// process NumItems on work pool, or on calling thread if only single chunk or single worker
+				WorkPoolFunc pFunc,				// processing function
+				const char *pszProgress);		// progress message
+
+	inline uint32_t HashMMer(uint32_t MMer)		// invertible hash of m-mer packed 2 bits per base
+		{
+		MMer = (~MMer + (MMer << 15)) & m_MMerMsk;
+		MMer = MMer ^ (MMer >> 12);
+		MMer = (MMer + (MMer << 2)) & m_MMerMsk;
+		MMer = MMer ^ (MMer >> 4);
+		MMer = (MMer * 2057) & m_MMerMsk;
+		MMer = MMer ^ (MMer >> 16);
+		return(MMer);
+		}
+
+	int SpillPart(tsExtKMerWorker *pWorker,		// append worker's buffered super K-mers for this partition to the worker's spill file
+				int PartIdx);
+
+	int AddSKMer(tsExtKMerWorker *pWorker,		// buffer super K-mer
+				uint32_t EntryIdx,				// in this entry
+				uint32_t Hash,					// having this minimizer hash
+				etSeqBase *pSeq,				// super K-mer sequence
+				int NumKMers);					// containing this many K-mers
+
+	int SpillRegion(tsExtKMerWorker *pWorker,	// group K-mers in canonical region into super K-mers
+				uint32_t EntryIdx,				// region is in this entry
+				etSeqBase *pSeq,				// region sequence, all bases canonical
+				uint32_t RegionLen);			// region length, at least m_PrefixLen
+
+	int LoadPart(tsExtKMerWorker *pWorker,		// load all super K-mers for partition into pWorker->pRaw
+				int PartIdx,
+				size_t *pRawLen);				// returned number of bytes loaded
+
+	int64_t										// returned number of K-mers, < 0 if errors
+		ExpandPart(tsExtKMerWorker *pWorker,	// expand loaded super K-mers into canonical K-mers
+				size_t RawLen,					// loaded bytes
+				int64_t NumKMers,				// loaded super K-mers contain this many K-mers
+				int Pass,						// only expanding K-mers belonging to this pass
+				int NumPasses);					// partition is being expanded in this many passes
+
+	int CountPart(tsExtKMerWorker *pWorker,		// sort expanded canonical K-mers and return counts for each K-mer
+				int64_t NumKMers);
+
+public:
+	CExtKMerCounts(void);
+	~CExtKMerCounts(void);
+
+	void Reset(void);							// delete any spill files and release all memory
+
+	int64_t						// < 0 if errors, otherwise the number of distinct prefix K-mers located (could be more than reported if MinCultivars > 1)
+		GenKMerCultsCnts(CSfxArray *pSfxArray,	// count K-mers in sequences of this suffix array, suffix block containing sequences must have been loaded
+				bool bSenseOnly,				// true if sense strand only processing, default is to process both sense and antisense
+				int PrefixKMerLen,				// report on K-Mers having this prefix sequence length
+				int SuffixKMerLen,				// and allow for the K-mers containing suffixes of this length (can be 0)
+				int MinCultivars,				// only report if K-Mers present in at least this many different cultivars (0 if must be present in all cultivars)
+				int MemBudgetMB,				// target memory budget in MB, at least cMinExtKMerMemMB
+				char *pszSpillPrefix,			// spill files are named with this prefix
+				int NumThreads,					// use at most this many threads
+				void *pThis,					// callers class instance
+				int (* pCallback)(void *pThis,tsKMerCultsCnts *pCultsCnts)); // callback on K-Mers, may be concurrently called from multiple threads, per cultivar CultCnts[] are not populated
+
+	// work pool processing, public only so they are accessible to the pool thread functions
+	int SpillSegs(int64_t StartIdx, int64_t EndIdx, int WorkerIdx);		// spill super K-mers for entry segments
+	int MergeParts(int64_t StartIdx, int64_t EndIdx, int WorkerIdx);	// count K-mers in partitions
+};
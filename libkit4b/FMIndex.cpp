@@ -6,12 +6,15 @@
 
 #include "stdafx.h"
 #ifdef _WIN32
+#include <process.h>
 #include "./commhdrs.h"
 #else
-#include "../hdrs/commhdrs.h"
+#include <pthread.h>
+#include "./commhdrs.h"
 #endif
 
 
+#include "./FMIndex.h"
 #include "./fmindexpriv.h"
 
 #define BZ_RUNA 0
@@ -26,6 +29,13 @@ CFMIndex::CFMIndex(void)
 {
 pmtf_start = NULL;
 gmtflen = 0;
+__Fm_Verbose = 0;
+m_NumThreads = 1;
+m_bBucCache = false;
+m_bCachedBuc = false;
+m_CachedBuc = 0;
+m_NxtSuperbucket = 0;
+m_pCompressedSBs = NULL;
 m_pIndex = new fm_index;
 if(m_pIndex != NULL)
 	memset(m_pIndex,0,sizeof(fm_index));
@@ -38,6 +48,19 @@ if(m_pIndex != NULL)
 	free_index();
 	delete m_pIndex;
 	}
+if(pmtf_start != NULL)
+	free(pmtf_start);
+}
+
+void
+CFMIndex::SetNumThreads(int NumThreads)		// fm_build will use at most this many threads (1..cMaxFMIThreads) when compressing superbuckets
+{
+if(NumThreads < 1)
+	NumThreads = 1;
+else
+	if(NumThreads > cMaxFMIThreads)
+		NumThreads = cMaxFMIThreads;
+m_NumThreads = NumThreads;
 }
 
 
@@ -51,14 +74,14 @@ return((char *)error_index(error));
 int
 CFMIndex::CreateIndex(char *pszInFile,				// create from contents of this file
 					char *pszOutFile,				// write index into this file
-					unsigned int *pText_len,		// returned file content length before index created	
-					unsigned int *pIndex_len,		// created index length
+					uint64_t *pText_len,			// returned file content length before index created	
+					uint64_t *pIndex_len,			// created index length
 					int bsl1,						// bucket size level 1 (in 1K increments) must be a multiple of bsl2
 					int bsl2,						// bucket size level 2 (in 1K  increments)
 					double Freq)					// marker frequency 0.0-1.0
 {
 unsigned char *text;
-UINT32 text_len, index_len;
+uint64_t text_len, index_len;
 int error;
 
 if(pText_len != NULL)
@@ -119,17 +142,25 @@ return(0);
  * order. 
  */
 int
-CFMIndex::locate (unsigned char * pattern, UINT32 length, UINT32 ** occ,UINT32 * numocc)
+CFMIndex::locate (unsigned char * pattern, uint32_t length, uint64_t ** occ,uint64_t * numocc)
 {
 
 	multi_count *groups;
 	int i, num_groups = 0, state;
-	UINT32 *occs = NULL;
+	uint64_t *occs = NULL;
 	*numocc = 0;
 	*occ = NULL;
 
-	if(m_pIndex->smalltext)  //uses Boyer-Moore algorithm
-		return fm_boyermoore(pattern, length, occ, numocc);
+	if(m_pIndex->smalltext) { //uses Boyer-Moore algorithm
+		uint64_t *bmocc;
+		state = fm_boyermoore(pattern, length, &bmocc, numocc);
+		if(state < 0 || *numocc == 0)
+			return state;
+		*occ = new uint64_t [*numocc];	// callers release occ with delete []
+		memcpy(*occ, bmocc, sizeof(uint64_t) * (*numocc));
+		free(bmocc);
+		return FM_OK;
+	}
 	
 	/* count */
 	num_groups = fm_multi_count (pattern, length, &groups);
@@ -140,10 +171,11 @@ CFMIndex::locate (unsigned char * pattern, UINT32 length, UINT32 ** occ,UINT32 *
 	for (i = 0; i < num_groups; i++)
 		*numocc += groups[i].elements;
 
-	occs = *occ = (UINT32 *)new  UINT32 [sizeof (UINT32) * (*numocc)];
+	occs = *occ = new  uint64_t [*numocc];
 	if (*occ == NULL)
 		{
 		*numocc = 0;
+		free (groups);
 		return FM_OUTMEM;
 		}
 
@@ -152,7 +184,8 @@ CFMIndex::locate (unsigned char * pattern, UINT32 length, UINT32 ** occ,UINT32 *
 		state = multi_locate (groups[i].first_row, groups[i].elements, occs);
 		if (state < 0)
 		{
-			delete *occ;
+			free (groups);
+			delete []*occ;
 			*occ = NULL;
 			*numocc = 0;
 			return state;
@@ -171,7 +204,7 @@ CFMIndex::locate (unsigned char * pattern, UINT32 length, UINT32 ** occ,UINT32 *
  * index. 
  */
 int
-CFMIndex::count (unsigned char * pattern, UINT32 length, UINT32 * numocc)
+CFMIndex::count (unsigned char * pattern, uint32_t length, uint64_t * numocc)
 {
 	multi_count *groups;
 	int i, num_groups = 0;
@@ -179,7 +212,7 @@ CFMIndex::count (unsigned char * pattern, UINT32 length, UINT32 * numocc)
 	*numocc = 0;
 
 	if(m_pIndex->smalltext) { //uses Boyer-Moore algorithm
-		UINT32 *occ;
+		uint64_t *occ;
 		int error = fm_boyermoore(pattern, length, &occ, numocc);
 		if(error < 0)
 			*numocc = 0;
@@ -203,6 +236,110 @@ CFMIndex::count (unsigned char * pattern, UINT32 length, UINT32 * numocc)
 
 
 
+/*
+ * Batched locate. Patterns are ordered on their reversed sequences so that patterns
+ * sharing suffixes are searched consecutively, backward searches of these patterns
+ * then visit the same rows and level 2 buckets which are decompressed once only
+ * whilst m_bBucCache is set.
+ */
+typedef struct TAG_sFMIBatchPat {
+	uint8_t *pPat;			// pattern
+	uint32_t Len;			// pattern length
+	uint32_t PatIdx;		// original index of pattern
+} tsFMIBatchPat;
+
+static int
+CompareBatchPats(const void *arg1, const void *arg2)
+{
+tsFMIBatchPat *pP1 = (tsFMIBatchPat *)arg1;
+tsFMIBatchPat *pP2 = (tsFMIBatchPat *)arg2;
+uint8_t *pS1 = &pP1->pPat[pP1->Len];
+uint8_t *pS2 = &pP2->pPat[pP2->Len];
+uint32_t Len = MIN(pP1->Len,pP2->Len);
+while(Len--)
+	{
+	pS1--; pS2--;
+	if(*pS1 != *pS2)
+		return(*pS1 < *pS2 ? -1 : 1);
+	}
+if(pP1->Len != pP2->Len)
+	return(pP1->Len < pP2->Len ? -1 : 1);
+return(0);
+}
+
+int
+CFMIndex::locate_batch(uint32_t NumPatterns,		// number of patterns
+					uint8_t **ppPatterns,		// patterns to locate
+					uint32_t *pLengths,			// pattern lengths
+					uint64_t ***pppOccs,		// returned array of pattern occurrence positions
+					uint64_t **ppNumOccs)		// returned array of pattern occurrence counts
+{
+	tsFMIBatchPat *pPats;
+	uint64_t **ppOccs;
+	uint64_t *pNumOccs;
+	uint32_t Idx;
+	int state = FM_OK;
+
+	*pppOccs = NULL;
+	*ppNumOccs = NULL;
+	if(NumPatterns == 0)
+		return FM_OK;
+
+	ppOccs = new uint64_t * [NumPatterns];
+	pNumOccs = new uint64_t [NumPatterns];
+	pPats = new tsFMIBatchPat [NumPatterns];
+	memset(ppOccs,0,sizeof(uint64_t *) * NumPatterns);
+	memset(pNumOccs,0,sizeof(uint64_t) * NumPatterns);
+	for(Idx = 0; Idx < NumPatterns; Idx++)
+		{
+		pPats[Idx].pPat = ppPatterns[Idx];
+		pPats[Idx].Len = pLengths[Idx];
+		pPats[Idx].PatIdx = Idx;
+		}
+	if(NumPatterns > 1)
+		qsort(pPats,NumPatterns,sizeof(tsFMIBatchPat),CompareBatchPats);
+
+	m_bBucCache = m_pIndex->smalltext ? false : true;
+	m_bCachedBuc = false;
+	for(Idx = 0; Idx < NumPatterns; Idx++)
+		{
+		if(pPats[Idx].Len == 0)
+			continue;
+		if((state = locate(pPats[Idx].pPat,pPats[Idx].Len,&ppOccs[pPats[Idx].PatIdx],&pNumOccs[pPats[Idx].PatIdx])) < 0)
+			break;
+		}
+	m_bBucCache = false;
+	m_bCachedBuc = false;
+	delete []pPats;
+
+	if(state < 0)
+		{
+		free_batch(NumPatterns,ppOccs,pNumOccs);
+		return state;
+		}
+	*pppOccs = ppOccs;
+	*ppNumOccs = pNumOccs;
+	return FM_OK;
+}
+
+void
+CFMIndex::free_batch(uint32_t NumPatterns,		// number of patterns as used in locate_batch()
+					uint64_t **ppOccs,			// as returned by locate_batch()
+					uint64_t *pNumOccs)			// as returned by locate_batch()
+{
+	uint32_t Idx;
+	if(ppOccs != NULL)
+		{
+		for(Idx = 0; Idx < NumPatterns; Idx++)
+			if(ppOccs[Idx] != NULL)
+				delete []ppOccs[Idx];
+		delete []ppOccs;
+		}
+	if(pNumOccs != NULL)
+		delete []pNumOccs;
+}
+
+
 #define ADD_LIST(_first_row, _elements) {\
 	if ((used+1) == allocated) {\
 		allocated += 5000;\
@@ -219,13 +356,13 @@ CFMIndex::count (unsigned char * pattern, UINT32 length, UINT32 * numocc)
  * di subchar allora devo dividere la ricerca con due rami distinti. 
  */
 int
-CFMIndex::count_row_mu (unsigned char * pattern, UINT32 len, UINT32 sp,UINT32 ep)
+CFMIndex::count_row_mu (unsigned char * pattern, uint32_t len, uint64_t sp,uint64_t ep)
 {
 	unsigned char chars_in[ALPHASIZE];
-	UINT32 occsp[ALPHASIZE], occep[ALPHASIZE];
+	uint64_t occsp[ALPHASIZE], occep[ALPHASIZE];
 	int num_char, i, find = 0;
 	unsigned char c;
-	UINT32 ssp, sep;
+	uint64_t ssp, sep;
 	/*
 	 * Versione semplice - possibile fare meglio 
 	 */
@@ -279,10 +416,11 @@ CFMIndex::count_row_mu (unsigned char * pattern, UINT32 len, UINT32 sp,UINT32 ep
  * non molto efficiente. 
  */
 int
-CFMIndex::fm_multi_count (unsigned char * pattern, UINT32 len,multi_count ** list)
+CFMIndex::fm_multi_count (unsigned char * pattern, uint32_t len,multi_count ** list)
 {
 
-	UINT32 sp, ep, i, j;
+	uint64_t sp, ep;
+	uint32_t i, j;
 	unsigned char c;
 
 	*list = NULL;
@@ -355,10 +493,10 @@ CFMIndex::fm_multi_count (unsigned char * pattern, UINT32 len,multi_count ** lis
  * posizione. 
  */
 void
-CFMIndex::get_pos (UINT32 first_row, UINT32 element, UINT16 step, UINT32 * pos)
+CFMIndex::get_pos (uint64_t first_row, uint64_t element, uint16_t step, uint64_t * pos)
 {
-	int offset, skipbits;
-	UINT32 postext, i;
+	uint64_t offset, postext, i;
+	int skipbits;
 	offset = first_row * m_pIndex->log2textsize;
 	fm_init_bit_reader (m_pIndex->start_prologue_occ + (offset >> 3));
 	skipbits = offset % 8;	// bits are to be skipped 
@@ -369,7 +507,7 @@ CFMIndex::get_pos (UINT32 first_row, UINT32 element, UINT16 step, UINT32 * pos)
 
 	for (i = 0; i < element; i++, pos++)
 	{			// cerca tutto il gruppo
-		postext = fm_bit_read (m_pIndex->log2textsize);	// read text pos 
+		postext = fm_bit_read64 (m_pIndex->log2textsize);	// read text pos 
 		*pos = postext + step;
 	}
 
@@ -380,7 +518,7 @@ CFMIndex::get_pos (UINT32 first_row, UINT32 element, UINT16 step, UINT32 * pos)
  * Multilocate 
  */
 int
-CFMIndex::multi_locate (UINT32 sp, UINT32 element, UINT32 * positions)
+CFMIndex::multi_locate (uint64_t sp, uint64_t element, uint64_t * positions)
 {
 
 	if(element == 0) return FM_OK;
@@ -390,18 +528,19 @@ CFMIndex::multi_locate (UINT32 sp, UINT32 element, UINT32 * positions)
 		return element;
 	}
 
-	UINT32 curr_row, used, recurs, elements, diff;
-	UINT32 *elem_array;	// contiene il numero di elementi del sottogruppo
-	UINT32 occsp[ALPHASIZE];
-	UINT32 occep[ALPHASIZE];
-	UINT16 *step_array, step;	// come sopra ma passi
+	uint64_t curr_row, used, recurs, elements, diff;
+	uint64_t *elem_array;	// contiene il numero di elementi del sottogruppo
+	uint64_t occsp[ALPHASIZE];
+	uint64_t occep[ALPHASIZE];
+	uint16_t *step_array, step;	// come sopra ma passi
 	unsigned char chars_in[ALPHASIZE];
 	int j, state, num_char;
 	/*
 	 * per singola locate 
 	 */
-	UINT32 occ_sb[ALPHASIZE], occ_b[ALPHASIZE];
-	UINT16 localstep;
+	uint64_t occ_sb[ALPHASIZE];
+	uint32_t occ_b[ALPHASIZE];
+	uint16_t localstep;
 	unsigned char c, c_sb, cb;
 
 	/* Caso in cui l'ultimo carattere e' m_pIndex->specialchar 
@@ -413,10 +552,16 @@ CFMIndex::multi_locate (UINT32 sp, UINT32 element, UINT32 * positions)
 		return element;
 	}
 	
-	step_array = (UINT16 *)malloc (sizeof (UINT32) * element);
-	elem_array = (UINT32 *)malloc (sizeof (UINT32) * element);
+	step_array = (uint16_t *)malloc (sizeof (uint16_t) * element);
+	elem_array = (uint64_t *)malloc (sizeof (uint64_t) * element);
 	if ((step_array ==NULL) || (elem_array == NULL))
+		{
+		if(step_array != NULL)
+			free(step_array);
+		if(elem_array != NULL)
+			free(elem_array);
 		return FM_OUTMEM;
+		}
 	
 	used = 0;
 	recurs = element - 1;
@@ -557,12 +702,12 @@ void CFMIndex::preBmGs(unsigned char *x, int m, int bmGs[])
    free(suff);
 }
 
-int CFMIndex::fm_boyermoore(unsigned char * pattern, UINT32 length, UINT32 ** occ, UINT32 * numocc) 
+int CFMIndex::fm_boyermoore(unsigned char * pattern, uint32_t length, uint64_t ** occ, uint64_t * numocc) 
 {
    
-   UINT32 j;
+   uint64_t j;
    int i, *bmGs, bmBc[ALPHASIZE];
-   UINT32 alloc = 10;
+   uint64_t alloc = 10;
    *numocc = 0;
 	if(m_pIndex->text_size < length)
 		{
@@ -570,7 +715,7 @@ int CFMIndex::fm_boyermoore(unsigned char * pattern, UINT32 length, UINT32 ** oc
 		return(FM_OK);
 		}
 
-   *occ = (UINT32 *)malloc(sizeof(UINT32)*alloc);
+   *occ = (uint64_t *)malloc(sizeof(uint64_t)*alloc);
    if(*occ == NULL) 
 	return FM_OUTMEM;   
 
@@ -594,7 +739,7 @@ int CFMIndex::fm_boyermoore(unsigned char * pattern, UINT32 length, UINT32 ** oc
 		 (*numocc)++;
 		 if(*numocc == alloc) {
 				alloc = MIN(alloc*2,m_pIndex->text_size);
-			 	*occ = (UINT32 *)realloc(*occ, sizeof(UINT32)*alloc);
+			 	*occ = (uint64_t *)realloc(*occ, sizeof(uint64_t)*alloc);
    				if(*occ == NULL)
 					{
 					free(bmGs);
@@ -605,10 +750,10 @@ int CFMIndex::fm_boyermoore(unsigned char * pattern, UINT32 length, UINT32 ** oc
          j += bmGs[0];
       }
       else
-         j += MAX((UINT32) bmGs[i], bmBc[m_pIndex->text[i + j]] - length + 1 + i);
+         j += MAX((uint64_t) bmGs[i], (uint64_t)(bmBc[m_pIndex->text[i + j]] - length + 1 + i));
    }
    if(*numocc>0) 
-	   *occ = (UINT32 *)realloc(*occ, sizeof(UINT32)*(*numocc));
+	   *occ = (uint64_t *)realloc(*occ, sizeof(uint64_t)*(*numocc));
    else
 		{
 		free(*occ);
@@ -665,7 +810,7 @@ CFMIndex::load_index (char * filename)
 	if(m_pIndex->smalltext) {
 		m_pIndex->skip = 0;
 		if(m_pIndex->text_size<SMALLSMALLFILESIZE) {
-			m_pIndex->text = m_pIndex->compress+4;
+			m_pIndex->text = m_pIndex->compress+sizeof(uint64_t);
 			return FM_OK;
 		}
 		m_pIndex->owner = 1;
@@ -705,7 +850,7 @@ CFMIndex::load_index (char * filename)
 }
 
 int
-CFMIndex::load_index_mem(unsigned char *compress, UINT32 size)
+CFMIndex::load_index_mem(unsigned char *compress, uint64_t size)
 {
 
 	int error;
@@ -724,7 +869,7 @@ CFMIndex::load_index_mem(unsigned char *compress, UINT32 size)
 	if(m_pIndex->smalltext) {
 		m_pIndex->skip = 0;
 		if(m_pIndex->text_size<SMALLSMALLFILESIZE) {
-			m_pIndex->text = m_pIndex->compress+4;
+			m_pIndex->text = m_pIndex->compress+sizeof(uint64_t);
 			return FM_OK;
 		}
 		m_pIndex->smalltext = 2;
@@ -765,20 +910,20 @@ CFMIndex::load_index_mem(unsigned char *compress, UINT32 size)
  * Open and Read .fmi file (whitout mmap()) 
  */
 int
-CFMIndex::open_file (char * filename, unsigned char ** file, UINT32 * size)
+CFMIndex::open_file (char * filename, unsigned char ** file, uint64_t * size)
 {
 
 	char *outfilename;
 	FILE *outfile = NULL;
 
 	outfilename =
-		(char *) malloc ((strlen (filename) + strlen (EXT) + 1) *
+		(char *) malloc ((strlen (filename) + strlen (cszFMIExt) + 1) *
 				 sizeof (char));
 	if (outfilename == NULL)
 		return FM_OUTMEM;
 
 	outfilename = strcpy (outfilename, filename);
-	outfilename = strcat (outfilename, EXT);
+	outfilename = strcat (outfilename, cszFMIExt);
 
 	outfile = fopen (outfilename, "rb");	// b is for binary: required by
 	// DOS
@@ -788,9 +933,15 @@ CFMIndex::open_file (char * filename, unsigned char ** file, UINT32 * size)
 	/*
 	 * store input file length 
 	 */
-	if (fseek (outfile, 0, SEEK_END) != 0)
+#ifdef _WIN32
+	if (_fseeki64 (outfile, 0, SEEK_END) != 0)
+		return FM_READERR;
+	*size = _ftelli64 (outfile);
+#else
+	if (fseeko64 (outfile, 0, SEEK_END) != 0)
 		return FM_READERR;
-	*size = ftell (outfile);
+	*size = ftello64 (outfile);
+#endif
 
 	if (*size < 1)
 		return FM_READERR;
@@ -799,12 +950,12 @@ CFMIndex::open_file (char * filename, unsigned char ** file, UINT32 * size)
 	/*
 	 * alloc memory for text 
 	 */
-	*file = (unsigned char *)malloc ((*size) * sizeof (unsigned char));
+	*file = (unsigned char *)malloc ((size_t)(*size) * sizeof (unsigned char));
 	if ((*file) == NULL)
 		return FM_OUTMEM;
 
-	UINT32 t =
-		(UINT32) fread (*file, sizeof (unsigned char), (size_t) * size,
+	uint64_t t =
+		(uint64_t) fread (*file, sizeof (unsigned char), (size_t) * size,
 			       outfile);
 	if (t != *size)
 		return FM_READERR;
@@ -823,10 +974,10 @@ CFMIndex::fm_read_basic_prologue (void)
 {
 
 	int i;
-	UINT32 size;
+	uint32_t size;
 
 	fm_init_bit_reader (m_pIndex->compress);
-	m_pIndex->text_size = fm_uint_read ();
+	m_pIndex->text_size = fm_uint64_read ();
 	if(m_pIndex->text_size< SMALLFILESIZE){
 			m_pIndex->smalltext=1; 
 			return FM_OK;
@@ -834,7 +985,7 @@ CFMIndex::fm_read_basic_prologue (void)
 	m_pIndex->smalltext = 0;
 	m_pIndex->type_compression = fm_bit_read (8);
 	m_pIndex->log2textsize = int_log2 (m_pIndex->text_size - 1);
-	m_pIndex->bwt_eof_pos = fm_uint_read ();
+	m_pIndex->bwt_eof_pos = fm_uint64_read ();
 	if (m_pIndex->bwt_eof_pos > m_pIndex->text_size)
 		return FM_COMPNOTCORR;
 
@@ -856,10 +1007,10 @@ CFMIndex::fm_read_basic_prologue (void)
 	/* read Mark mode & starting position of occ list */
 	m_pIndex->specialchar = (unsigned char) fm_bit_read (8);
 	m_pIndex->skip =  fm_bit_read (32);
-	unsigned int start = fm_uint_read();
+	uint64_t start = fm_uint64_read();
 
 	m_pIndex->start_prologue_occ = m_pIndex->compress + start;
-	m_pIndex->start_prologue_info_sb = fm_uint_read ();
+	m_pIndex->start_prologue_info_sb = fm_uint64_read ();
 	m_pIndex->subchar = (unsigned char) fm_bit_read (8);	/* remapped cmpress alphabet */
 
 	/* some information for the user */
@@ -898,7 +1049,7 @@ CFMIndex::fm_read_basic_prologue (void)
 	for (i = 0; i < m_pIndex->alpha_size; i++)
 	{			// legge somme occorrenze
 		// caratteri
-		m_pIndex->bwt_occ[i] = fm_bit_read (m_pIndex->log2textsize);
+		m_pIndex->bwt_occ[i] = fm_bit_read64 (m_pIndex->log2textsize);
 	}
 
 	/*
@@ -917,7 +1068,7 @@ CFMIndex::fm_read_basic_prologue (void)
 	
 	m_pIndex->start_prologue_info_b = m_pIndex->start_prologue_info_sb + 
 		(m_pIndex->sb_bitmap_size*m_pIndex->num_bucs_lev1)
-		+ (m_pIndex->alpha_size * sizeof(UINT32) * (m_pIndex->num_bucs_lev1 - 1));
+		+ (m_pIndex->alpha_size * sizeof(uint64_t) * (m_pIndex->num_bucs_lev1 - 1));
 
 	return FM_OK;
 }
@@ -980,7 +1131,7 @@ CFMIndex::free_index (void)
  * Obtains the length of the text represented by index. 
  */
 int
-CFMIndex::get_length (UINT32 * length)
+CFMIndex::get_length (uint64_t * length)
 {
 *length = m_pIndex->text_size - m_pIndex->num_marked_rows;
 return FM_OK;
@@ -991,7 +1142,7 @@ return FM_OK;
 	needed by the index to perform any of the operations it implements.
 */
 int 
-CFMIndex::index_size(UINT32 *size) {
+CFMIndex::index_size(uint64_t *size) {
 
 	*size = m_pIndex->compress_size;
 	return FM_OK;
@@ -1013,13 +1164,13 @@ CFMIndex::index_size(UINT32 *size) {
  * bucket e' presente un solo carattere 
  */
 int 
-CFMIndex::occ_all (UINT32 sp, UINT32 ep, UINT32 * occsp, UINT32 * occep,unsigned char * char_in)
+CFMIndex::occ_all (uint64_t sp, uint64_t ep, uint64_t * occsp, uint64_t * occep,unsigned char * char_in)
 {
 
 	int i, state, diff, mod, b2end, remap;
-	UINT32 occ_sb[ALPHASIZE], occ_b[ALPHASIZE];
-	UINT32 occ_sb2[ALPHASIZE], occ_b2[ALPHASIZE];
-	UINT32 num_buc_ep = ep / m_pIndex->bucket_size_lev2;
+	uint64_t occ_sb[ALPHASIZE], occ_sb2[ALPHASIZE];
+	uint32_t occ_b[ALPHASIZE], occ_b2[ALPHASIZE];
+	uint64_t num_buc_ep = ep / m_pIndex->bucket_size_lev2;
 	int char_present = 0;	// numero caratteri distinti presenti nel bucket 
 	unsigned char *c, d;
 
@@ -1044,8 +1195,8 @@ CFMIndex::occ_all (UINT32 sp, UINT32 ep, UINT32 * occsp, UINT32 * occep,unsigned
 			&& (num_buc_ep != m_pIndex->num_bucs_lev2-1) ) 
 			{        // bucket dispari
 			state = get_info_b ('\0', sp, occ_b, WHAT_CHAR_IS);
-			mod =  m_pIndex->bucket_size_lev2 - (ep % m_pIndex->bucket_size_lev2) - 1;
-			diff = ep - sp;
+			mod =  (int)(m_pIndex->bucket_size_lev2 - (ep % m_pIndex->bucket_size_lev2) - 1);
+			diff = (int)(ep - sp);
 
 		
 			for (i = 0; i < m_pIndex->alpha_size_sb; i++)
@@ -1075,8 +1226,8 @@ CFMIndex::occ_all (UINT32 sp, UINT32 ep, UINT32 * occsp, UINT32 * occep,unsigned
 			return char_present;
 		} else {
 			
-		mod = sp % m_pIndex->bucket_size_lev2;
-		diff = ep - sp;
+		mod = (int)(sp % m_pIndex->bucket_size_lev2);
+		diff = (int)(ep - sp);
 		b2end = mod + diff;	// posizione di ep nel bucket > 1023 => bucket diverso
 
 		state = get_info_b ('\0', ep, occ_b2, WHAT_CHAR_IS);
@@ -1171,10 +1322,11 @@ CFMIndex::occ_all (UINT32 sp, UINT32 ep, UINT32 * occsp, UINT32 * occep,unsigned
  * sb-occurences in the index are stored with log2textsize bits. 
  */
 int
-CFMIndex::get_info_sb (UINT32 pos, UINT32 * occ)
+CFMIndex::get_info_sb (uint64_t pos, uint64_t * occ)
 {
 
-	UINT32 size, sb, *occpoint = occ, offset, i;
+	uint64_t sb, *occpoint = occ, offset;
+	uint32_t size, i;
 
 	if (pos >= m_pIndex->text_size)
 		return FM_SEARCHERR;	// Invalid pos
@@ -1190,7 +1342,7 @@ CFMIndex::get_info_sb (UINT32 pos, UINT32 * occ)
 	{
 		// skip bool map in previous superbuckets
 		// skip occ in previous superbuckets (except the first one)
-		offset += (sb - 1) * (m_pIndex->alpha_size * sizeof(UINT32)) + (sb * m_pIndex->sb_bitmap_size);
+		offset += (sb - 1) * (m_pIndex->alpha_size * sizeof(uint64_t)) + (sb * m_pIndex->sb_bitmap_size);
 	} 
 
 	fm_init_bit_reader (m_pIndex->compress + offset);	// position of sb header
@@ -1223,7 +1375,7 @@ CFMIndex::get_info_sb (UINT32 pos, UINT32 * occ)
 	else
 	{
 		/* otherwise copy # occ_map in previous superbuckets */
-		memcpy(occ, m_pIndex->compress + offset + m_pIndex->sb_bitmap_size, m_pIndex->alpha_size*sizeof(UINT32));
+		memcpy(occ, m_pIndex->compress + offset + m_pIndex->sb_bitmap_size, m_pIndex->alpha_size*sizeof(uint64_t));
 
 	}
 
@@ -1249,26 +1401,27 @@ CFMIndex::get_info_sb (UINT32 pos, UINT32 * occ)
  */
 
 int
-CFMIndex::get_info_b (unsigned char ch, UINT32 pos, UINT32 *occ, int flag)
+CFMIndex::get_info_b (unsigned char ch, uint64_t pos, uint32_t *occ, int flag)
 {
 
-	UINT32 buc_start_pos, buc, size, nextbuc = 0;
-	int i, offset, is_odd = 0, isnotfirst;
+	uint64_t buc_start_pos, buc, nextbuc = 0, offset;
+	uint32_t size;
+	int i, is_odd = 0, isnotfirst;
 	unsigned char ch_in_pos = 0;
 
 	buc = pos / m_pIndex->bucket_size_lev2;	// bucket containing pos
 	assert (buc < (m_pIndex->text_size + m_pIndex->bucket_size_lev2 - 1)
 		/ m_pIndex->bucket_size_lev2);
-	isnotfirst = buc % (m_pIndex->bucket_size_lev1 / m_pIndex->bucket_size_lev2);
+	isnotfirst = (int)(buc % (m_pIndex->bucket_size_lev1 / m_pIndex->bucket_size_lev2));
 
 	/* read bucket starting position */
 	offset = m_pIndex->start_prologue_info_b + m_pIndex->var_byte_rappr/8 * buc;
 	fm_init_bit_reader ((m_pIndex->compress) + offset);
-	buc_start_pos = fm_bit_read (m_pIndex->var_byte_rappr);
+	buc_start_pos = fm_bit_read64 (m_pIndex->var_byte_rappr);
 
 	if((buc%2 == 0) && (isnotfirst)  && (buc != m_pIndex->num_bucs_lev2-1)) {
 		is_odd = 1; // bucket per il quale non sono memorizzate le occorrenze
-		nextbuc = fm_bit_read (m_pIndex->var_byte_rappr);	
+		nextbuc = fm_bit_read64 (m_pIndex->var_byte_rappr);	
 	}
 	
 	/* move to the beginning of the bucket */
@@ -1338,15 +1491,45 @@ CFMIndex::get_info_b (unsigned char ch, UINT32 pos, UINT32 *occ, int flag)
  * position k. Note that ch is a bucket-remapped char. 
  */
 unsigned char
-CFMIndex::get_b_multihuf(UINT32 k, UINT32 * occ, int is_odd)
+CFMIndex::get_b_multihuf(uint64_t k, uint32_t * occ, int is_odd)
 {
-	UINT32 bpos, i, j, mtf_seq_len;
+	uint32_t bpos, i, j, mtf_seq_len;
 	unsigned char char_returned;
 
-	bpos = k % m_pIndex->bucket_size_lev2;
+	bpos = (uint32_t)(k % m_pIndex->bucket_size_lev2);
 
 	if (is_odd) bpos = m_pIndex->bucket_size_lev2 - bpos - 1;
 
+	if (m_bBucCache)
+	{			/* decode the complete bucket once and reuse it while requests stay within this bucket */
+		uint64_t buc = k / m_pIndex->bucket_size_lev2;
+		if (!m_bCachedBuc || m_CachedBuc != buc)
+		{
+			uint32_t buc_len = (uint32_t)MIN((uint64_t)m_pIndex->bucket_size_lev2, m_pIndex->text_size - buc * m_pIndex->bucket_size_lev2);
+			if (m_pIndex->alpha_size_b == 1)
+				memset(m_pIndex->mtf_seq, m_pIndex->inv_map_b[0], buc_len);
+			else
+			{
+				for (i = 0; i < m_pIndex->alpha_size_b; i++)
+					m_pIndex->mtf[i] = (unsigned char)i;
+				mtf_seq_len = fm_multihuf_decompr (m_pIndex->mtf_seq, m_pIndex->alpha_size_b, buc_len);
+				assert (mtf_seq_len >= buc_len);
+				unmtf_unmap (m_pIndex->mtf_seq, buc_len);
+			}
+			m_CachedBuc = buc;
+			m_bCachedBuc = true;
+		}
+		char_returned = m_pIndex->mtf_seq[bpos];
+		if (is_odd) {
+			for (i=0; i < bpos; i++)
+				occ[m_pIndex->mtf_seq[i]]--;
+		} else {
+			for (i = 0; i <= bpos; i++)
+				occ[m_pIndex->mtf_seq[i]]++;
+		}
+		return char_returned;
+	}
+
 	if (m_pIndex->alpha_size_b == 1)
 	{			/* special case bucket with only one char */
 		char_returned = m_pIndex->inv_map_b[0];
@@ -1437,9 +1620,9 @@ CFMIndex::unmtf_unmap (unsigned char * mtf_seq, int len_mtf)
    in a single bucket) then we use mtf and we compress. 
 */ 
 int 
-CFMIndex::compress_bucket(unsigned char *in, UINT32 len, UINT16 alphasize) {
+CFMIndex::compress_bucket(unsigned char *in, uint32_t len, uint16_t alphasize) {
 	
-  UINT16 local_alpha_size, j;
+  uint16_t local_alpha_size, j;
   unsigned char c, local_bool_map[256], local_map[256]; 
  
   /* ---------- compute and write local boolean map ------ */
@@ -1490,11 +1673,11 @@ CFMIndex::compress_bucket(unsigned char *in, UINT32 len, UINT16 alphasize) {
 /* Compute Move to Front for string */
 
 void 
-CFMIndex::mtf_string(unsigned char *in, unsigned char *out, UINT32 len, UINT16 mtflen)
+CFMIndex::mtf_string(unsigned char *in, unsigned char *out, uint32_t len, uint16_t mtflen)
 {
 	
-  UINT32 i,o,m;
-  UINT16 j,h;
+  uint32_t i,o,m;
+  uint16_t j,h;
   unsigned char c;
 
   if(pmtf_start == NULL || gmtflen < mtflen)
@@ -1545,20 +1728,20 @@ CFMIndex::fm_bwt_compress(void)
 
 	m_pIndex->compress_size = 0;
 	fm_init_bit_writer(m_pIndex->compress, &m_pIndex->compress_size);
-	fm_uint_write(m_pIndex->text_size);
-	fm_uint_write(m_pIndex->bwt_eof_pos);
+	fm_uint64_write(m_pIndex->text_size);
+	fm_uint64_write(m_pIndex->bwt_eof_pos);
 	
 	/* MTF */
 	m_pIndex->mtf_seq = (unsigned char *) malloc (m_pIndex->text_size * sizeof (unsigned char));
 	if (m_pIndex->mtf_seq == NULL)
 		return FM_OUTMEM;
 	
-	mtf_string(m_pIndex->bwt, m_pIndex->mtf_seq, m_pIndex->text_size, ALPHASIZE);
+	mtf_string(m_pIndex->bwt, m_pIndex->mtf_seq, (uint32_t)m_pIndex->text_size, ALPHASIZE);
 	
 	free(m_pIndex->bwt);
 	m_pIndex->bwt = NULL;
 	/* compress rle + huffman */
-	error = fm_multihuf_compr(m_pIndex->mtf_seq, m_pIndex->text_size, ALPHASIZE);
+	error = fm_multihuf_compr(m_pIndex->mtf_seq, (int)m_pIndex->text_size, ALPHASIZE);
 	if ( error < 0 ) return error;
 
 	fm_bit_flush(); 
@@ -1590,19 +1773,19 @@ CFMIndex::fm_unmtf(unsigned char *in, unsigned char *out, int length)
 int 
 CFMIndex::fm_bwt_uncompress(void) 
 {
-	UINT32 i;
+	uint64_t i;
 	int error;
-	m_pIndex->bwt_eof_pos = fm_uint_read();
+	m_pIndex->bwt_eof_pos = fm_uint64_read();
 	
 	m_pIndex->mtf_seq = (unsigned char *)malloc(sizeof(unsigned char) * m_pIndex->text_size);
 	if (m_pIndex->mtf_seq == NULL) return FM_OUTMEM;
 	
-	fm_multihuf_decompr (m_pIndex->mtf_seq, ALPHASIZE, m_pIndex->text_size);
+	fm_multihuf_decompr (m_pIndex->mtf_seq, ALPHASIZE, (int)m_pIndex->text_size);
 	m_pIndex->bwt = (unsigned char *)malloc(sizeof(unsigned char) * m_pIndex->text_size);
 	if (m_pIndex->bwt == NULL) return FM_OUTMEM;
 		
 	/* The chars in the unmtf_bucket are already un-mapped */
-	fm_unmtf(m_pIndex->mtf_seq, m_pIndex->bwt, m_pIndex->text_size );
+	fm_unmtf(m_pIndex->mtf_seq, m_pIndex->bwt, (int)m_pIndex->text_size );
 	free(m_pIndex->mtf_seq);
 	m_pIndex->mtf_seq = NULL;
 	
@@ -1655,12 +1838,12 @@ CFMIndex::fm_multihuf_compr (unsigned char * in, int len, int alpha_size)
 int v, t, i, j, gs, ge, totc, bt, bc, iter;
 int nSelectors, minLen, maxLen, new_len;
 int nGroups;
-UINT16 cost[BZ_N_GROUPS];
+uint16_t cost[BZ_N_GROUPS];
 int fave[BZ_N_GROUPS];
-UINT16 * mtfv;
+uint16_t * mtfv;
 unsigned char * selector;
 
-mtfv = (UINT16 *) malloc ((len + 1) * sizeof (UINT16));
+mtfv = (uint16_t *) malloc ((len + 1) * sizeof (uint16_t));
 if (mtfv == NULL)
 	return FM_OUTMEM;
 	
@@ -1692,7 +1875,7 @@ new_len = 0;
 					}
 				z = 0;
 				}
-			mtfv[new_len++] = (UINT16) c + 1;
+			mtfv[new_len++] = (uint16_t) c + 1;
 			}
 		}
 		
@@ -1827,11 +2010,11 @@ for (iter = 0; iter < BZ_N_ITERS; iter++)
 			cost[t] = 0;
 		if (nGroups == 6)
 			{
-			register UINT16 cost0,cost1, cost2, cost3, cost4, cost5;
+			uint16_t cost0,cost1, cost2, cost3, cost4, cost5;
 			cost0 = cost1 = cost2 = cost3 = cost4 =	cost5 = 0;
 			for (i = gs; i <= ge; i++)
 				{
-				UINT16 icv = mtfv[i];
+				uint16_t icv = mtfv[i];
 				cost0 += huf_len[0][icv];
 				cost1 += huf_len[1][icv];
 				cost2 += huf_len[2][icv];
@@ -1850,7 +2033,7 @@ for (iter = 0; iter < BZ_N_ITERS; iter++)
 			{
 			for (i = gs; i <= ge; i++)
 				{
-				UINT16 icv = mtfv[i];
+				uint16_t icv = mtfv[i];
 				for (t = 0; t < nGroups; t++)
 					cost[t] += huf_len[t][icv];
 				}
@@ -1900,7 +2083,7 @@ fprintf (stderr, "\n");
       --*/ 
 			for (t = 0; t < nGroups; t++)
 			
-hbMakeCodeLengths (&(huf_len[t][0]), (UINT32 *)&(rfreq[t][0]),
+hbMakeCodeLengths (&(huf_len[t][0]), (uint32_t *)&(rfreq[t][0]),
 					    alpha_size, 20);
 	
 }
@@ -1929,7 +2112,7 @@ assert (!(maxLen > 20));
 		
 assert (!(minLen < 1));
 		
-hbAssignCodes ((UINT32 *)&(huf_code[t][0]), &(huf_len[t][0]), 
+hbAssignCodes ((uint32_t *)&(huf_code[t][0]), &(huf_len[t][0]), 
 minLen,
 				maxLen, alpha_size);
 	
@@ -2170,7 +2353,7 @@ if (huf_len[t][i] < minLen)
 			
 }
 			
-hbCreateDecodeTables ((UINT32 *)&(huf_limit[t][0]),(UINT32 *)&(huf_base[t][0]),(UINT32 *)&(huf_perm[t][0]),&(huf_len[t][0]),minLen,maxLen, alpha_size);
+hbCreateDecodeTables ((uint32_t *)&(huf_limit[t][0]),(uint32_t *)&(huf_base[t][0]),(uint32_t *)&(huf_perm[t][0]),&(huf_len[t][0]),minLen,maxLen, alpha_size);
 			
 huf_minLens[t] = minLen;
 		
@@ -2392,7 +2575,7 @@ return FM_OK;
  */
 
 void
-CFMIndex::fm_init_bit_writer (unsigned char * mem, UINT32 * pos_mem)
+CFMIndex::fm_init_bit_writer (unsigned char * mem, uint64_t * pos_mem)
 {
 	__MemAddress = mem;
 	__Num_Bytes = pos_mem;
@@ -2416,9 +2599,9 @@ CFMIndex::fm_init_bit_reader (unsigned char * mem)
 
 // ****** Write in Bit_buffer n bits taken from vv (possibly n > 24) 
 void
-CFMIndex::fm_bit_write (int n, UINT32 vv)
+CFMIndex::fm_bit_write (int n, uint32_t vv)
 {
-	UINT32 v = (UINT32) vv;
+	uint32_t v = (uint32_t) vv;
 
 	assert (n <= 32);
 	if (n > 24)
@@ -2436,7 +2619,7 @@ CFMIndex::fm_bit_write (int n, UINT32 vv)
 int
 CFMIndex::fm_bit_read (int n)
 {
-	UINT32 u = 0;
+	uint32_t u = 0;
 	int i;
 	assert (n <= 32);
 	if (n > 24)
@@ -2454,7 +2637,42 @@ CFMIndex::fm_bit_read (int n)
 	}
 }
 
-void CFMIndex::fm_bit_write24(int bits, UINT32 num) {
+// ****** Write in Bit_buffer n bits taken from vv (n <= 64), written as 24 bit groups most significant first
+void
+CFMIndex::fm_bit_write64 (int n, uint64_t vv)
+{
+	assert (n <= 64);
+	while (n > 24)
+	{
+		n -= 24;
+		fm_bit_write24 (24, (uint32_t)((vv >> n) & 0xffffffL));
+	}
+	if (n > 0)
+		fm_bit_write24 (n, (uint32_t)(vv & ((1u << n) - 1)));
+}
+
+// ****** Read n bits (n <= 64) from Bit_buffer 
+uint64_t
+CFMIndex::fm_bit_read64 (int n)
+{
+	uint64_t u = 0;
+	int i;
+	assert (n <= 64);
+	while (n > 24)
+	{
+		n -= 24;
+		fm_bit_read24 (24, i);
+		u = (u << 24) | (uint32_t)i;
+	}
+	if (n > 0)
+	{
+		fm_bit_read24 (n, i);
+		u = (u << n) | (uint32_t)i;
+	}
+	return u;
+}
+
+void CFMIndex::fm_bit_write24(int bits, uint32_t num) {
 					
   	assert(__Bit_buffer_size<8); 
   	assert(bits>0 && bits<=24);
@@ -2478,9 +2696,9 @@ void CFMIndex::fm_bit_write24(int bits, UINT32 num) {
 
 // ****** Write in Bit_buffer four bytes 
 void
-CFMIndex::fm_uint_write (UINT32 uu)
+CFMIndex::fm_uint_write (uint32_t uu)
 {
-	UINT32 u = (UINT32) uu;
+	uint32_t u = (uint32_t) uu;
 	fm_bit_write24 (8, ((u >> 24) & 0xffL));
 	fm_bit_write24 (8, ((u >> 16) & 0xffL));
 	fm_bit_write24 (8, ((u >> 8) & 0xffL));
@@ -2488,12 +2706,30 @@ CFMIndex::fm_uint_write (UINT32 uu)
 
 }
 
+// ****** Write in Bit_buffer eight bytes 
+void
+CFMIndex::fm_uint64_write (uint64_t uu)
+{
+	fm_uint_write ((uint32_t)(uu >> 32));
+	fm_uint_write ((uint32_t)(uu & 0xffffffffL));
+}
+
+// ***** Return 64 bits taken from Bit_buffer
+uint64_t
+CFMIndex::fm_uint64_read (void)
+{
+	uint64_t u;
+	u = (uint64_t)fm_uint_read () << 32;
+	u |= fm_uint_read ();
+	return u;
+}
+
 // ***** Return 32 bits taken from Bit_buffer
-UINT32
+uint32_t
 CFMIndex::fm_uint_read (void)
 {
 
-	UINT32 u;
+	uint32_t u;
 	int i;
 	fm_bit_read24 (8, i);
 	u = i << 24;
@@ -2523,7 +2759,7 @@ CFMIndex::fm_bit_flush (void)
 }
 
 
-UINT32
+uint32_t
 CFMIndex::fm_integer_decode (unsigned short int headbits)
 {
 	int k, i;
@@ -2629,7 +2865,7 @@ CFMIndex::fm_integer_decode (unsigned short int headbits)
 
 #define UPHEAP(z)                                     \
 {                                                     \
-   UINT32 zz, tmp;                                     \
+   uint32_t zz, tmp;                                     \
    zz = z; tmp = heap[zz];                            \
    while (weight[tmp] < weight[heap[zz >> 1]]) {      \
       heap[zz] = heap[zz >> 1];                       \
@@ -2640,7 +2876,7 @@ CFMIndex::fm_integer_decode (unsigned short int headbits)
 
 #define DOWNHEAP(z)                                   \
 {                                                     \
-   UINT32 zz, yy, tmp;                                 \
+   uint32_t zz, yy, tmp;                                 \
    zz = z; tmp = heap[zz];                            \
    while (true) {                                     \
       yy = zz << 1;                                   \
@@ -2659,20 +2895,20 @@ CFMIndex::fm_integer_decode (unsigned short int headbits)
 /*---------------------------------------------------*/
 void 
 CFMIndex::hbMakeCodeLengths ( unsigned char *len, 
-                         UINT32 *freq,
-                         UINT32 alphaSize,
-                         UINT32 maxLen )
+                         uint32_t *freq,
+                         uint32_t alphaSize,
+                         uint32_t maxLen )
 {
    /*--
       Nodes and heap entries run from 1.  Entry 0
       for both the heap and nodes is a sentinel.
    --*/
-   UINT32 nNodes, nHeap, n1, n2, i, j, k;
+   uint32_t nNodes, nHeap, n1, n2, i, j, k;
    bool  tooLong;
 
-   INT32 heap   [ BZ_MAX_ALPHA_SIZE + 2 ];
-   INT32 weight [ BZ_MAX_ALPHA_SIZE * 2 ];
-   INT32 parent [ BZ_MAX_ALPHA_SIZE * 2 ]; 
+   int32_t heap   [ BZ_MAX_ALPHA_SIZE + 2 ];
+   int32_t weight [ BZ_MAX_ALPHA_SIZE * 2 ];
+   int32_t parent [ BZ_MAX_ALPHA_SIZE * 2 ]; 
 
    for (i = 0; i < alphaSize; i++)
       weight[i+1] = (freq[i] == 0 ? 1 : freq[i]) << 8;
@@ -2731,13 +2967,13 @@ CFMIndex::hbMakeCodeLengths ( unsigned char *len,
 
 /*---------------------------------------------------*/
 void 
-CFMIndex::hbAssignCodes ( UINT32 *code,
+CFMIndex::hbAssignCodes ( uint32_t *code,
                      unsigned char *length,
-                     UINT32 minLen,
-                     UINT32 maxLen,
-                     UINT32 alphaSize )
+                     uint32_t minLen,
+                     uint32_t maxLen,
+                     uint32_t alphaSize )
 {
-   UINT32 n, vec, i;
+   uint32_t n, vec, i;
 
    vec = 0;
    for (n = minLen; n <= maxLen; n++) {
@@ -2750,15 +2986,15 @@ CFMIndex::hbAssignCodes ( UINT32 *code,
 
 /*---------------------------------------------------*/
 void 
-CFMIndex::hbCreateDecodeTables ( UINT32 *limit,
-                            UINT32 *base,
-                            UINT32 *perm,
+CFMIndex::hbCreateDecodeTables ( uint32_t *limit,
+                            uint32_t *base,
+                            uint32_t *perm,
                             unsigned char *length,
-                            UINT32 minLen,
-                            UINT32 maxLen,
-                            UINT32 alphaSize )
+                            uint32_t minLen,
+                            uint32_t maxLen,
+                            uint32_t alphaSize )
 {
-   UINT32 pp, i, j, vec;
+   uint32_t pp, i, j, vec;
 
    pp = 0;
    for (i = minLen; i <= maxLen; i++)
@@ -2799,15 +3035,15 @@ CFMIndex::hbCreateDecodeTables ( UINT32 *limit,
 #define NEARCLOSE (200) // valore da testare
 
 int 
-CFMIndex::extract(UINT32 from, UINT32 to, unsigned char **dest, 
-			UINT32 *snippet_length) {
+CFMIndex::extract(uint64_t from, uint64_t to, unsigned char **dest, 
+			uint64_t *snippet_length) {
 
-	UINT32 written, numchar;
-	UINT32 row = 0; /* numero di riga corrispondente all'ultima position */
-	UINT32 scarto = 0;  	/* lo scarto tra la posizione richiesta e la posizione 
+	uint64_t written, numchar;
+	uint64_t row = 0; /* numero di riga corrispondente all'ultima position */
+	uint64_t scarto = 0;  	/* lo scarto tra la posizione richiesta e la posizione 
 			    	       successiva divisibile per m_pIndex->skip */
-	UINT32 i,j;
-	UINT32 pos_text = 0; /* last readen position */
+	uint64_t i,j;
+	uint64_t pos_text = 0; /* last readen position */
 	unsigned char * text;
 
 	*dest = NULL; 
@@ -2830,7 +3066,7 @@ CFMIndex::extract(UINT32 from, UINT32 to, unsigned char **dest,
 		return FM_OK;
 	}
 	
-	UINT32 real_text_size;
+	uint64_t real_text_size;
 	if(m_pIndex->skip>1) real_text_size = m_pIndex->text_size-m_pIndex->num_marked_rows; 
 	else real_text_size = m_pIndex->text_size;
 		
@@ -2854,7 +3090,7 @@ CFMIndex::extract(UINT32 from, UINT32 to, unsigned char **dest,
 	scarto = m_pIndex->skip - (to%m_pIndex->skip);
 	//if (scarto == m_pIndex->skip) scarto = 0;
 	
-	UINT32 to_new = to + scarto-1;
+	uint64_t to_new = to + scarto-1;
 	if (to_new >= real_text_size-m_pIndex->skip-1) { // vicina alla fine del testo la riga e' la 0
 			row = m_pIndex->bwt_eof_pos;
 			scarto = real_text_size - to-1;
@@ -2862,10 +3098,10 @@ CFMIndex::extract(UINT32 from, UINT32 to, unsigned char **dest,
 	/* Inizia a leggere le posizioni finche non trova to_new */
 	fm_init_bit_reader(m_pIndex->start_prologue_occ);
 	for(i=0; i<m_pIndex->num_marked_rows; i++) { 
-		pos_text = fm_bit_read(m_pIndex->log2textsize);
+		pos_text = fm_bit_read64(m_pIndex->log2textsize);
 
 		if((pos_text >= to_new) &&(pos_text < to_new+NEARCLOSE)){
-							scarto += pos_text-to_new;
+							scarto = pos_text - to + 1;	// also correct if near the end of text and scarto was initialised for going back from the eof row
 							row = i + m_pIndex->occcharinf;
 				  			break;
 		}
@@ -2909,10 +3145,11 @@ CFMIndex::extract(UINT32 from, UINT32 to, unsigned char **dest,
    stop if the beginning of the file is encountered
    return the number of chars actually read 
 */
-UINT32 
-CFMIndex::go_back(UINT32 row, UINT32 len, unsigned char *dest) {
+uint64_t 
+CFMIndex::go_back(uint64_t row, uint64_t len, unsigned char *dest) {
 	
-  UINT32 written, curr_row, n, occ_sb[256], occ_b[256];
+  uint64_t written, curr_row, n, occ_sb[256];
+  uint32_t occ_b[256];
   unsigned char c, c_sb, cs;
  
   if (row != m_pIndex->bwt_eof_pos) curr_row = EOF_shift(row);
@@ -2952,11 +3189,11 @@ CFMIndex::go_back(UINT32 row, UINT32 len, unsigned char *dest) {
    the EOF is encountered).
    return the number of chars actually read 
 */
-UINT32 
-CFMIndex::go_forw(UINT32 row, UINT32 len, unsigned char *dest) {
+uint64_t 
+CFMIndex::go_forw(uint64_t row, uint64_t len, unsigned char *dest) {
 	
 
-  UINT32 written;
+  uint64_t written;
   unsigned char c,cs;
 
   for(written=0;written<len; ) {
@@ -2980,11 +3217,13 @@ CFMIndex::go_forw(UINT32 row, UINT32 len, unsigned char *dest) {
 /*
 	compute the first-to-last map using binary search
 */
-UINT32 
-CFMIndex::fl_map(UINT32 row, unsigned char ch) {
+uint64_t 
+CFMIndex::fl_map(uint64_t row, unsigned char ch) {
 
-  UINT32 i, n, rank, first, last, middle;
-  UINT32 occ_sb[ALPHASIZE], occ_b[ALPHASIZE];
+  uint64_t n, rank, first, last, middle;
+  uint32_t i;
+  uint64_t occ_sb[ALPHASIZE];
+  uint32_t occ_b[ALPHASIZE];
   unsigned char c_b,c_sb;              // char returned by get_info
   unsigned char ch_b;
 
@@ -3039,7 +3278,7 @@ CFMIndex::fl_map(UINT32 row, unsigned char ch) {
    This routine can be improved using binary search!
 */
 unsigned char 
-CFMIndex::get_firstcolumn_char(UINT32 row)
+CFMIndex::get_firstcolumn_char(uint64_t row)
 {
   int i;
 
@@ -3051,14 +3290,14 @@ CFMIndex::get_firstcolumn_char(UINT32 row)
 
 
 int 
-CFMIndex::display(unsigned char *pattern, UINT32 length, UINT32 nums, UINT32 *numocc, 
-			unsigned char **snippet_text, UINT32 **snippet_len) 
+CFMIndex::display(unsigned char *pattern, uint32_t length, uint32_t nums, uint64_t *numocc, 
+			unsigned char **snippet_text, uint64_t **snippet_len) 
 {
 
 	multi_count *groups;
 	int i, num_groups = 0, error;
 	unsigned char *snippets;
-	UINT32 *snip_len, j, h, len;
+	uint64_t *snip_len, j, h, len;
 
 	*numocc = 0;
 	*snippet_text = NULL;
@@ -3067,11 +3306,11 @@ CFMIndex::display(unsigned char *pattern, UINT32 length, UINT32 nums, UINT32 *nu
 	len = length + 2*nums;
 
 	if(m_pIndex->smalltext) { //uses Boyer-Moore algorithm
-		UINT32 *occ, to, numch, k;
+		uint64_t *occ, to, numch, k;
 		int error = fm_boyermoore(pattern, length, &occ, numocc);
 		if(error<0 || *numocc <= 0) 
 			return error;
-		snip_len = (UINT32 *) malloc (sizeof (UINT32) * (*numocc));
+		snip_len = (uint64_t *) malloc (sizeof (uint64_t) * (*numocc));
 		if (snip_len == NULL)
 			{
 			*numocc = 0;
@@ -3118,7 +3357,7 @@ CFMIndex::display(unsigned char *pattern, UINT32 length, UINT32 nums, UINT32 *nu
 	for (i = 0; i < num_groups; i++)
 		*numocc += groups[i].elements;
 
-	snip_len = (UINT32 *) new UINT32 [sizeof (UINT32) * (*numocc)];
+	snip_len = new uint64_t [*numocc];
 	if (snip_len == NULL)
 		{
 		*numocc = 0;
@@ -3142,8 +3381,9 @@ CFMIndex::display(unsigned char *pattern, UINT32 length, UINT32 nums, UINT32 *nu
 		
 			if (error < 0)
 				{
-				delete snippets;
-				delete snip_len;
+				delete []snippets;
+				delete []snip_len;
+				free (groups);
 				*numocc = 0;
 				return error;
 				}
@@ -3166,10 +3406,10 @@ CFMIndex::display(unsigned char *pattern, UINT32 length, UINT32 nums, UINT32 *nu
 */
    
 int 
-CFMIndex::fm_snippet(UINT32 row, UINT32 plen, UINT32 clen, unsigned char *dest, 
-			   UINT32 *snippet_length) {
+CFMIndex::fm_snippet(uint64_t row, uint32_t plen, uint32_t clen, unsigned char *dest, 
+			   uint64_t *snippet_length) {
 
-  UINT32 back, forw, i;
+  uint64_t back, forw, i;
   unsigned char * temptext;
 			   
   temptext = (unsigned char *)malloc(sizeof(unsigned char) * clen);
@@ -3206,7 +3446,7 @@ int
 CFMIndex::read_prologue(void)
 {
   bucket_lev1 *sb;  
-  UINT32 i, k, offset;
+  uint64_t i, k, offset;
 	  
   /* alloc superbuckets */
   m_pIndex->buclist_lev1 = (bucket_lev1 *) malloc(m_pIndex->num_bucs_lev1 * sizeof(bucket_lev1));
@@ -3217,7 +3457,7 @@ CFMIndex::read_prologue(void)
     sb = &(m_pIndex->buclist_lev1[i]);
 
     /* allocate space for array of occurrences */
-    sb->occ = (UINT32 *) malloc((m_pIndex->alpha_size)* sizeof(UINT32));
+    sb->occ = (uint64_t *) malloc((m_pIndex->alpha_size)* sizeof(uint64_t));
 	if(sb->occ==NULL) return FM_OUTMEM;
 
     /* allocate space for array of boolean char map */
@@ -3235,22 +3475,21 @@ CFMIndex::read_prologue(void)
       sb->bool_char_map[k] = fm_bit_read(1);
 
    	if(i>0)   {                         // read prefix-occ 
-      	for(k=0;k<m_pIndex->alpha_size;k++) 
-	  		memcpy(sb->occ, m_pIndex->compress + offset + m_pIndex->sb_bitmap_size, m_pIndex->alpha_size*sizeof(UINT32));
-		offset += (m_pIndex->alpha_size * sizeof(UINT32) + m_pIndex->sb_bitmap_size);
+	  	memcpy(sb->occ, m_pIndex->compress + offset + m_pIndex->sb_bitmap_size, m_pIndex->alpha_size*sizeof(uint64_t));
+		offset += (m_pIndex->alpha_size * sizeof(uint64_t) + m_pIndex->sb_bitmap_size);
 	} else offset += m_pIndex->sb_bitmap_size;
 	  
   }
 
   /* alloc array for the starting positions of the buckets */
-  m_pIndex->start_lev2 =  (UINT32 *) malloc((m_pIndex->num_bucs_lev2)* sizeof(UINT32));
+  m_pIndex->start_lev2 =  (uint64_t *) malloc((m_pIndex->num_bucs_lev2)* sizeof(uint64_t));
   if(m_pIndex->start_lev2 == NULL) return FM_OUTMEM;
  
   fm_init_bit_reader(m_pIndex->compress + m_pIndex->start_prologue_info_b);
   
   /* read the start positions of the buckets */
   for(i=0;i<m_pIndex->num_bucs_lev2;i++) 
-    m_pIndex->start_lev2[i] = fm_bit_read(m_pIndex->var_byte_rappr);
+    m_pIndex->start_lev2[i] = fm_bit_read64(m_pIndex->var_byte_rappr);
   
   return FM_OK;
 }  
@@ -3264,7 +3503,7 @@ CFMIndex::read_prologue(void)
 int 
 CFMIndex::uncompress_data(void)
 {
-  UINT32 i;
+  uint64_t i;
   int error;
 
   m_pIndex->bwt = (unsigned char *) malloc(m_pIndex->text_size);
@@ -3286,12 +3525,13 @@ CFMIndex::uncompress_data(void)
    (i.e. m_pIndex->bucket_size_lev1 unless num is the last superbucket) 
 */
 int 
-CFMIndex::uncompress_superbucket(UINT32 numsb, unsigned char *out)
+CFMIndex::uncompress_superbucket(uint64_t numsb, unsigned char *out)
 {
   bucket_lev1 sb;  
   unsigned char *dest, c;
-  UINT32 sb_start, sb_end, start,  b2, temp_occ[ALPHASIZE];
-  int i, k, error, len, is_odd, temp_len;
+  uint64_t sb_start, sb_end, start,  b2;
+  uint32_t temp_occ[ALPHASIZE];
+  int i, k, len, is_odd, temp_len;
  
   assert(numsb<m_pIndex->num_bucs_lev1);
   sb = m_pIndex->buclist_lev1[numsb];    	/* current superbucket */
@@ -3306,7 +3546,7 @@ CFMIndex::uncompress_superbucket(UINT32 numsb, unsigned char *out)
 
   for(start=sb_start; start < sb_end; start += m_pIndex->bucket_size_lev2, b2++) {
    
-	len = MIN(m_pIndex->bucket_size_lev2, sb_end-start); // length of bucket
+	len = (int)MIN(m_pIndex->bucket_size_lev2, sb_end-start); // length of bucket
     dest = out + (start - sb_start);                       
 	
 	fm_init_bit_reader((m_pIndex->compress) + m_pIndex->start_lev2[b2]); // go to start of bucket
@@ -3316,7 +3556,7 @@ CFMIndex::uncompress_superbucket(UINT32 numsb, unsigned char *out)
 	
     if((start != sb_start) && (!is_odd)) // if not the first bucket and not odd skip occ
       for(k=0; k<m_pIndex->alpha_size_sb; k++) 
-         error = fm_integer_decode(m_pIndex->int_dec_bits); /* non servono se non mtf2 */
+         fm_integer_decode(m_pIndex->int_dec_bits); /* non servono se non mtf2, decoded only to advance the bit reader */
 	
 	/* Compute bucket inv map */
   	m_pIndex->alpha_size_b = 0;
@@ -3369,10 +3609,10 @@ CFMIndex::uncompress_superbucket(UINT32 numsb, unsigned char *out)
 int 
 CFMIndex::fm_compute_lf(void)
 {
-  UINT32 i, occ_tmp[ALPHASIZE];
+  uint64_t i, occ_tmp[ALPHASIZE];
 
   /* alloc memory */
-  m_pIndex->lf = (UINT32 *) malloc(m_pIndex->text_size*sizeof(UINT32));
+  m_pIndex->lf = (uint64_t *) malloc(m_pIndex->text_size*sizeof(uint64_t));
   if(m_pIndex->lf == NULL)
     return FM_OUTMEM;
 
@@ -3398,8 +3638,8 @@ CFMIndex::fm_compute_lf(void)
 int 
 CFMIndex::fm_invert_bwt(void)
 {
-  UINT32 j;
-  UINT32 i, real_text_size;
+  uint64_t j;
+  uint64_t i, real_text_size;
 	
   if(m_pIndex->skip>1) real_text_size = m_pIndex->text_size-m_pIndex->num_marked_rows;
   else  
@@ -3442,7 +3682,7 @@ CFMIndex::fm_invert_bwt(void)
 
 void 
 CFMIndex::free_unbuild_mem(void) { 
-	UINT32 i;
+	uint64_t i;
 	bucket_lev1 *sb;
 	
 	free(m_pIndex->start_lev2);
@@ -3461,10 +3701,10 @@ CFMIndex::free_unbuild_mem(void) {
 
 
 int 
-CFMIndex::fm_unbuild(unsigned char ** text, UINT32 *length) {
+CFMIndex::fm_unbuild(unsigned char ** text, uint64_t *length) {
 	
 	int error;
-	UINT32  i;
+	uint64_t  i;
 	if ((error = read_prologue()) < 0 ) {
 			free_unbuild_mem();
 			return error;
@@ -3483,7 +3723,7 @@ CFMIndex::fm_unbuild(unsigned char ** text, UINT32 *length) {
 			return error;
 	}
 
-	UINT32 real_text_size;
+	uint64_t real_text_size;
     if(m_pIndex->skip>1) real_text_size = m_pIndex->text_size-m_pIndex->num_marked_rows;
   	else real_text_size = m_pIndex->text_size;
 		
@@ -3555,7 +3795,7 @@ switch (e)
  * devo passargli (u-1) 
  */
 int
-CFMIndex::int_log2 (int u)
+CFMIndex::int_log2 (uint64_t u)
 {
 	/*
 	 * codifica con if i casi piu frequenti un if costa meno di una
@@ -3603,7 +3843,7 @@ CFMIndex::int_log2 (int u)
 	if (u < 1048576)
 		return 20;
 	int i = 20;
-	int r = 1048575;
+	uint64_t r = 1048575;
 
 	while (r < u)
 	{
@@ -3633,21 +3873,21 @@ CFMIndex::int_pow2 (int u)		// compute 2^u
  */
 
 
-#define POINTPROLOGUE (19);
+#define POINTPROLOGUE (27);
 
 #if TESTINFO
 typedef struct { // Solo per i test: memorizza spazio occupato
-	UINT32 bucket_compr; 
-	UINT32 bucket_occ;
-	UINT32 bucket_alphasize;
-	UINT32 bucket_pointer;		
-	UINT32 sbucket_occ;       	
-	UINT32 sbucket_alphasize; 	
-	UINT32 prologue_size;
-	UINT32 sbucket_bitmap;
-	UINT32 bucket_bitmap;
-	UINT32 marked_pos;
-	UINT32 temp;
+	uint32_t bucket_compr; 
+	uint32_t bucket_occ;
+	uint32_t bucket_alphasize;
+	uint32_t bucket_pointer;		
+	uint32_t sbucket_occ;       	
+	uint32_t sbucket_alphasize; 	
+	uint32_t prologue_size;
+	uint32_t sbucket_bitmap;
+	uint32_t bucket_bitmap;
+	uint32_t marked_pos;
+	uint32_t temp;
 } measures;
 
 measures Test;
@@ -3655,9 +3895,9 @@ measures Test;
 
 int 
 CFMIndex::fm_build_config (double freq, 
-							UINT32 bsl1, 
-							UINT32 bsl2, 
-							UINT16 owner)	// 0==caller retains ownership of text to prcess, 1 == CFMIndex becomes owner and will delete this memory 
+							uint32_t bsl1, 
+							uint32_t bsl2, 
+							uint16_t owner)	// 0==caller retains ownership of text to prcess, 1 == CFMIndex becomes owner and will delete this memory 
 {
 // instead of returning errors on paparameters force parameters to be reasonable values
 // freq must be between 0.0 and 1.0 inclusive
@@ -3696,7 +3936,7 @@ m_pIndex->bucket_size_lev1 = bsl1  << 10;
 m_pIndex->bucket_size_lev2 = bsl2  << 10;					
 if (freq >= 0.5) { m_pIndex->skip = 1; return FM_OK;}
 if(freq == 0) { m_pIndex->skip = 0; return FM_OK;}
-m_pIndex->skip = (UINT16) (1.0/freq);	/* 1/Mark_freq 2% text size */
+m_pIndex->skip = (uint16_t) (1.0/freq);	/* 1/Mark_freq 2% text size */
 return FM_OK;
 }
 
@@ -3707,9 +3947,9 @@ CFMIndex::parse_options(char *optionz) {
 	int i, numtoken = 1;
   	
 	/* default */
-	UINT32 bsl1 = cDfltL1BlockSize;
-	UINT32 bsl2 = cDfltL2BlockSize;
-	UINT16 owner = 1;
+	uint32_t bsl1 = cDfltL1BlockSize;
+	uint32_t bsl2 = cDfltL2BlockSize;
+	uint16_t owner = 1;
 	double freq = cDfltMarkerFreq;	
 
 	if (optionz == NULL) 
@@ -3799,7 +4039,7 @@ CFMIndex::parse_options(char *optionz) {
 	The returned index is ready to be queried. 
 */
 int 
-CFMIndex::build_index(unsigned char *text, UINT32 length, char *build_options) {
+CFMIndex::build_index(unsigned char *text, uint64_t length, char *build_options) {
 	
 	int error;
 
@@ -3818,7 +4058,7 @@ CFMIndex::build_index(unsigned char *text, UINT32 length, char *build_options) {
 
 /* Build */
 int 
-CFMIndex::fm_build(unsigned char *text, UINT32 length) {
+CFMIndex::fm_build(unsigned char *text, uint64_t length) {
 
 	int error;	
 	m_pIndex->compress = NULL;
@@ -3855,13 +4095,13 @@ CFMIndex::fm_build(unsigned char *text, UINT32 length) {
 		
 		m_pIndex->smalltext = 1;
 		m_pIndex->compress_size = 0;
-		m_pIndex->compress = (unsigned char *)malloc((4+m_pIndex->text_size)*sizeof(unsigned char));
+		m_pIndex->compress = (unsigned char *)malloc((sizeof(uint64_t)+m_pIndex->text_size)*sizeof(unsigned char));
 		if (m_pIndex->compress == NULL) 
 			return FM_OUTMEM;
 		m_pIndex->compress_size = 0;
 		fm_init_bit_writer(m_pIndex->compress, &m_pIndex->compress_size);
-		fm_uint_write(m_pIndex->text_size);
-		memcpy(m_pIndex->compress+4,m_pIndex->text, sizeof(unsigned char)*m_pIndex->text_size);
+		fm_uint64_write(m_pIndex->text_size);
+		memcpy(m_pIndex->compress+sizeof(uint64_t),m_pIndex->text, sizeof(unsigned char)*m_pIndex->text_size);
 		m_pIndex->compress_size += m_pIndex->text_size;	
 		
 		return FM_OK;
@@ -3919,7 +4159,7 @@ CFMIndex::fm_build(unsigned char *text, UINT32 length) {
 		m_pIndex->text = NULL;
 		}
 	
-	UINT32 i;
+	uint64_t i;
 	/* Remap bwt */
 	for(i=0; i<m_pIndex->text_size; i++) 
    		m_pIndex->bwt[i] = m_pIndex->char_map[m_pIndex->bwt[i]];
@@ -3945,9 +4185,9 @@ CFMIndex::fm_build(unsigned char *text, UINT32 length) {
 			m_pIndex->lf = NULL;
 		}
 
-	UINT32 stima_len_compress = (UINT32)(100 + m_pIndex->text_size*1.5);
+	uint64_t stima_len_compress = (uint64_t)(100 + m_pIndex->text_size*1.5);
 	
-	stima_len_compress += m_pIndex->num_marked_rows*sizeof(UINT32); 
+	stima_len_compress += m_pIndex->num_marked_rows*sizeof(uint64_t); 
 	
 	m_pIndex->compress = (unsigned char *)malloc(stima_len_compress*sizeof(unsigned char));
 	if (m_pIndex->compress == NULL) 
@@ -3960,7 +4200,13 @@ CFMIndex::fm_build(unsigned char *text, UINT32 length) {
 	if(TESTINFO) fprintf(stderr,"Write prologue done\n");
 			
 	/* Compress each bucket in all superbuckets */	
-	for(i=0; i<m_pIndex->num_bucs_lev1; i++) { /* comprimi ogni bucket */
+	if(m_NumThreads > 1 && m_pIndex->num_bucs_lev1 > 1) {
+		error = compress_superbuckets_mt();
+		if (error < 0 ) 
+			return errore( error);
+		}
+	else
+		for(i=0; i<m_pIndex->num_bucs_lev1; i++) { /* comprimi ogni bucket */
              error = compress_superbucket( i);
 			 if (error < 0 ) 
 					return errore( error);	
@@ -4021,8 +4267,8 @@ CFMIndex::fm_build(unsigned char *text, UINT32 length) {
 */
 int
 CFMIndex::select_subchar(void) {
-	UINT32 i, newtextsize, pos;
-	UINT16 mappa[ALPHASIZE];
+	uint64_t i, newtextsize, pos;
+	uint16_t mappa[ALPHASIZE];
 	m_pIndex->subchar = 0; // inutile in questa versione
 	if (m_pIndex->text_size <= m_pIndex->skip) m_pIndex->skip=1;
 	m_pIndex->oldtext = NULL;
@@ -4067,7 +4313,7 @@ CFMIndex::select_subchar(void) {
 		memcpy(text+pos, m_pIndex->text+pos-i, m_pIndex->skip);		
 		}
 
-	UINT32 offset = m_pIndex->text_size - (pos - i)-1;
+	uint64_t offset = m_pIndex->text_size - (pos - i)-1;
 	if(offset){
 		if (pos) text[pos++] = m_pIndex->specialchar;
 		memcpy(text+pos, m_pIndex->text+pos-i, offset);
@@ -4096,12 +4342,27 @@ CFMIndex::select_subchar(void) {
 int 
 CFMIndex::build_sa(void) { 
 	
-  m_pIndex->lf = (UINT32 *)malloc(m_pIndex->text_size * sizeof(UINT32));
+  m_pIndex->lf = (uint64_t *)malloc(m_pIndex->text_size * sizeof(uint64_t));
   if (m_pIndex->lf == NULL) 
 	  	return FM_OUTMEM;
 
   /* compute Suffix Array with library */  
-  SAIS.sais(m_pIndex->text, (INT32 *)m_pIndex->lf, m_pIndex->text_size);
+  CSAIS SAIS;
+  SAIS.SetNumThreads(m_NumThreads);
+  if(m_pIndex->text_size >= 0x07fffffff)
+	{
+	if(SAIS.sais_msk(m_pIndex->text, (int64_t *)m_pIndex->lf, (int64_t)m_pIndex->text_size, ALPHASIZE, 0x0ff) < 0)
+		return FM_OUTMEM;
+	return FM_OK;
+	}
+
+  /* smaller texts use 32 bit suffixes, sorted into the low half of lf and then widened in place from the top down */
+  int32_t *sa32 = (int32_t *)m_pIndex->lf;
+  int64_t i;
+  if(SAIS.sais_msk(m_pIndex->text, sa32, (int32_t)m_pIndex->text_size, ALPHASIZE, 0x0ff) < 0)
+	return FM_OUTMEM;
+  for(i = (int64_t)m_pIndex->text_size - 1; i >= 0; i--)
+	m_pIndex->lf[i] = (uint64_t)sa32[i];
   return FM_OK;
 
 }
@@ -4115,7 +4376,7 @@ void
 CFMIndex::count_occ(void) {
 	
 	/* count occurences */
-	UINT32 i;
+	uint64_t i;
 	unsigned char curchar;
 
 	m_pIndex->alpha_size = 0;
@@ -4135,7 +4396,7 @@ CFMIndex::count_occ(void) {
 	}
 	
 	/* remap dell'alfabeto */
-	UINT16 cfree = 0; /* primo posto libero in m_pIndex->char_map */
+	uint16_t cfree = 0; /* primo posto libero in m_pIndex->char_map */
 	for (i =0; i < ALPHASIZE; i++) {
 		if ( m_pIndex->bool_char_map[i] == 1 ) {
 			m_pIndex->char_map[i] = (unsigned char)cfree;
@@ -4146,7 +4407,7 @@ CFMIndex::count_occ(void) {
 	assert(cfree == m_pIndex->alpha_size);
 	
 	/* Compute prefix sum of char occ */
-	UINT32 temp, sum = 0;
+	uint64_t temp, sum = 0;
     for(i=0; i<m_pIndex->alpha_size; i++) {
     	temp = m_pIndex->pfx_char_occ[i];
     	m_pIndex->pfx_char_occ[i] = sum; 
@@ -4170,7 +4431,7 @@ CFMIndex::count_occ(void) {
 int 
 CFMIndex::build_bwt(void) {
   
-  UINT32 i;
+  uint64_t i;
   
   /* alloc memory for bwt */
   m_pIndex->bwt = (unsigned char *)malloc(m_pIndex->text_size*sizeof(unsigned char));
@@ -4183,7 +4444,7 @@ CFMIndex::build_bwt(void) {
   	 dopo gli indici di sa e bwt ritornano uguali. 
   */
   
-  UINT32 *sa = m_pIndex->lf;		 	 // punta al primo elemento 
+  uint64_t *sa = m_pIndex->lf;		 	 // punta al primo elemento 
   unsigned char *bwt = &(m_pIndex->bwt[1]);  	 // punta al secondo 
   for(i=0; i<m_pIndex->text_size; i++) {  // non leggibile ma piu' performante 
     if(*sa !=0 ){		     	 // al posto di *bwt c'era m_pIndex->bwt[j++] con j=1
@@ -4203,15 +4464,15 @@ CFMIndex::build_bwt(void) {
 int 
 CFMIndex::compute_locations(void) { 
 
-	UINT32 i,j; /* numero posizioni marcate */
+	uint64_t i,j; /* numero posizioni marcate */
 	unsigned char spchar = m_pIndex->char_map[m_pIndex->specialchar];
-	UINT32 firstrow = m_pIndex->pfx_char_occ[spchar];
+	uint64_t firstrow = m_pIndex->pfx_char_occ[spchar];
 
   	if( (m_pIndex->skip==0)|| (m_pIndex->skip == 1)) 
     	return FM_OK;
 	
 	/* alloc m_pIndex->loc_occ */
-  	m_pIndex->loc_occ = (UINT32 *)malloc(sizeof(UINT32) * m_pIndex->num_marked_rows);
+  	m_pIndex->loc_occ = (uint64_t *)malloc(sizeof(uint64_t) * m_pIndex->num_marked_rows);
 	if (m_pIndex->loc_occ == NULL) return FM_OUTMEM;
 		
 	for(i=firstrow,j=firstrow; i<(m_pIndex->num_marked_rows+firstrow); i++,j++) {
@@ -4235,7 +4496,8 @@ CFMIndex::compute_locations(void) {
 int 
 CFMIndex::compute_info_superbuckets(void)
 {
-  UINT32 b, temp, occ, k, i;
+  uint64_t b, temp, occ, i;
+  uint32_t k;
   bucket_lev1 * sb;
   
   /* compute number of superbuckets  */
@@ -4250,11 +4512,11 @@ CFMIndex::compute_info_superbuckets(void)
     sb = &(m_pIndex->buclist_lev1[i]);   // sb points to current superbucket
 
     /* Allocate space for data structures */
-    sb->occ = (UINT32 *)malloc((m_pIndex->alpha_size)* sizeof(UINT32));
+    sb->occ = (uint64_t *)malloc((m_pIndex->alpha_size)* sizeof(uint64_t));
     if(sb->occ == NULL) 
 			return FM_OUTMEM;
 	
-    sb->bool_char_map = (unsigned char *)malloc((m_pIndex->alpha_size)*sizeof(UINT16));
+    sb->bool_char_map = (unsigned char *)malloc((m_pIndex->alpha_size)*sizeof(uint16_t));
     if(sb->bool_char_map == NULL) 
 			return FM_OUTMEM;
 
@@ -4268,8 +4530,8 @@ CFMIndex::compute_info_superbuckets(void)
   
   /* scan bwt and gather information */
   
-  UINT32 currentBuck = 0;  // indice superbuckets
-  UINT32 dim = m_pIndex->bucket_size_lev1; // per non dividere
+  uint64_t currentBuck = 0;  // indice superbuckets
+  uint64_t dim = m_pIndex->bucket_size_lev1; // per non dividere
   
   sb =  &m_pIndex->buclist_lev1[0];
   for(i=0; i<m_pIndex->text_size; i++) {
@@ -4320,7 +4582,7 @@ CFMIndex::compute_info_buckets(void)
   m_pIndex->num_bucs_lev2 = (m_pIndex->text_size + m_pIndex->bucket_size_lev2 - 1) / m_pIndex->bucket_size_lev2;
 
   /* alloc array for buckets starting positions */
-  m_pIndex->start_lev2 =  (UINT32 *)malloc((m_pIndex->num_bucs_lev2)* sizeof(UINT32));
+  m_pIndex->start_lev2 =  (uint64_t *)malloc((m_pIndex->num_bucs_lev2)* sizeof(uint64_t));
   if(m_pIndex->start_lev2==NULL) 
 	  	return FM_OUTMEM;
   return FM_OK;	  
@@ -4329,16 +4591,16 @@ CFMIndex::compute_info_buckets(void)
 
 /* ---------------------------------------------------------
    The current format of the prologue is the following:
+   64 bits 	size of input file (text)
 	8 bits	type of compression (4=Multi Table Huff 5=gamma 6=mtf2)
-   32 bits 	size of input file (text)
-   32 bits  position of eof in m_pIndex->bwt
+   64 bits  position of eof in m_pIndex->bwt
    16 bits  size of a super bucket divided by 1024
    16 bits  size of a bucket divided (divides the previous)
 	8 bits  size-1 of the compacted alphabet of the text
 	8 bits 	m_pIndex->specialchar remapped eith m_pIndex->char_map
    32 bits	m_pIndex->skip expected # of chars between 2 marked positions 
-   32 bits  occ-explicit list
-   32 bits  m_pIndex->start_prologue_info_sb
+   64 bits  occ-explicit list
+   64 bits  m_pIndex->start_prologue_info_sb
     8 bits  m_pIndex->char_map[m_pIndex->subchar]
   256 bits  m_pIndex->bool_char_map: bit i is 1 iff char i occurs in the text
 
@@ -4350,7 +4612,7 @@ CFMIndex::compute_info_buckets(void)
 			- m_pIndex->alpha_size bits to store the Sb bitmap
 			- for each char c that occurs in te text 
 			  stores the sb.occ[c] (prefix sum of character occurrences) 
-			  with m_pIndex->log2textsize (except for the first sbucket)
+			  as 64 bit values (except for the first sbucket)
 	x bits  bit_flush() in order to be aligned to byte 
 	
 			Stores starting position of each bucket in the compressed file 
@@ -4362,13 +4624,14 @@ void
 CFMIndex::write_prologue(void) {
 
   bucket_lev1 sb;
-  UINT32 i,k;
+  uint64_t i;
+  uint32_t k;
 
   /* write file and bucket size */
   fm_init_bit_writer(m_pIndex->compress, &m_pIndex->compress_size);
-  fm_uint_write(m_pIndex->text_size);
+  fm_uint64_write(m_pIndex->text_size);
   fm_bit_write24(8, m_pIndex->type_compression);
-  fm_uint_write(m_pIndex->bwt_eof_pos);
+  fm_uint64_write(m_pIndex->bwt_eof_pos);
 
   assert(m_pIndex->bucket_size_lev1 >> 10 < 65536);
   assert((m_pIndex->bucket_size_lev1 & 0x3ff) == 0);
@@ -4385,8 +4648,8 @@ CFMIndex::write_prologue(void) {
   /* write starting byte of occ-list */
   fm_bit_write24(8, m_pIndex->char_map[m_pIndex->specialchar]); /* carattere speciale */
   fm_bit_write(32, m_pIndex->skip);
-  fm_uint_write(0); /* spazio libero per occ-explicit list 20esimo byte--*/
-  fm_uint_write(0); /* spazio libero per mettere inizio sb info 25esimo byte */
+  fm_uint64_write(0); /* spazio libero per occ-explicit list 28esimo byte--*/
+  fm_uint64_write(0); /* spazio libero per mettere inizio sb info 36esimo byte */
   fm_bit_write24(8, m_pIndex->char_map[m_pIndex->subchar]); /* carattere sostituito */
   
   /* boolean alphabet char map */
@@ -4396,7 +4659,7 @@ CFMIndex::write_prologue(void) {
 
   /* write prefix sum of char occ  Da valutare vantaggi in compressione vs tempo */
   for(i=0; i < m_pIndex->alpha_size; i++) {
-   	fm_bit_write(m_pIndex->log2textsize, m_pIndex->pfx_char_occ[i]);   
+   	fm_bit_write64(m_pIndex->log2textsize, m_pIndex->pfx_char_occ[i]);   
 	}
   fm_bit_flush(); 
  
@@ -4413,8 +4676,8 @@ CFMIndex::write_prologue(void) {
   	if(i>0) // write prefix-occ
 		{ 
 		unsigned char *dest = m_pIndex->compress+m_pIndex->compress_size;
-		dest = (unsigned char *)memcpy(dest, sb.occ, sizeof(UINT32) * m_pIndex->alpha_size);
-	  	m_pIndex->compress_size += sizeof(UINT32) * m_pIndex->alpha_size;
+		dest = (unsigned char *)memcpy(dest, sb.occ, sizeof(uint64_t) * m_pIndex->alpha_size);
+	  	m_pIndex->compress_size += sizeof(uint64_t) * m_pIndex->alpha_size;
 	  	fm_init_bit_writer(m_pIndex->compress+m_pIndex->compress_size, &m_pIndex->compress_size);
 	 }
   }
@@ -4423,7 +4686,7 @@ CFMIndex::write_prologue(void) {
   m_pIndex->var_byte_rappr = ((m_pIndex->log2textsize+7)/8)*8;   // it's byte-aligned
  
   for(i=0;i<m_pIndex->num_bucs_lev2;i++)
-  	fm_bit_write(m_pIndex->var_byte_rappr,0);
+  	fm_bit_write64(m_pIndex->var_byte_rappr,0);
   
   #if TESTINFO
   Test.bucket_pointer = (m_pIndex->var_byte_rappr)*m_pIndex->num_bucs_lev2/8;
@@ -4445,12 +4708,13 @@ CFMIndex::write_prologue(void) {
    integer_encode.
 */
 int 
-CFMIndex::compress_superbucket(UINT32 num)
+CFMIndex::compress_superbucket(uint64_t num)
 {
   
   bucket_lev1 sb;  
   unsigned char *in, c, char_map[ALPHASIZE];
-  UINT32 k, temp, sb_start, sb_end, start,len, bocc[ALPHASIZE], b2,i,j;
+  uint64_t sb_start, sb_end, start, b2;
+  uint32_t k, temp, len, bocc[ALPHASIZE], i, j;
   int is_odd;
 
   assert(num<m_pIndex->num_bucs_lev1);
@@ -4474,7 +4738,7 @@ CFMIndex::compress_superbucket(UINT32 num)
 
 	m_pIndex->start_lev2[b2] = m_pIndex->compress_size; // start of bucket in compr file
 
-    len = MIN(m_pIndex->bucket_size_lev2, sb_end-start);    // length of bucket
+    len = (uint32_t)MIN(m_pIndex->bucket_size_lev2, sb_end-start);    // length of bucket
     in = m_pIndex->bwt + start;  // start of bucket
 	
 	is_odd = 0;
@@ -4530,6 +4794,164 @@ CFMIndex::compress_superbucket(UINT32 num)
   return FM_OK;
 }
 
+/*
+   Superbuckets are compressed independently of each other and every bucket starts byte aligned,
+   so superbuckets can be compressed concurrently into per thread buffers and then concatenated
+   in superbucket order giving the same compressed content as compressing sequentially.
+   Each thread uses it's own CFMIndex instance for the bit writer, huffman tables and mtf buffers,
+   the bwt, superbucket info and bucket start array are shared with each thread only accessing
+   the superbuckets it has claimed.
+*/
+#ifdef _WIN32
+unsigned __stdcall CFMIndex::CompressThread(void * pThreadPars)
+#else
+void *CFMIndex::CompressThread(void * pThreadPars)
+#endif
+{
+tsFMICompressThread *pPars = (tsFMICompressThread *)pThreadPars;
+pPars->Rslt = pPars->pThis->CompressSuperbuckets(pPars);
+#ifdef _WIN32
+_endthreadex(0);
+return(0);
+#else
+pthread_exit(NULL);
+#endif
+}
+
+int
+CFMIndex::CompressSuperbuckets(tsFMICompressThread *pPars)
+{
+  CFMIndex *pWorker = pPars->pWorker;
+  fm_index *pIdx = pWorker->m_pIndex;
+  uint64_t num, sb_len, req_size, new_size;
+  uint8_t *pTmp;
+  int error;
+
+  while(1) {
+#ifdef _WIN32
+	num = InterlockedIncrement((volatile unsigned int *)&m_NxtSuperbucket) - 1;
+#else
+	num = __sync_fetch_and_add(&m_NxtSuperbucket,1);
+#endif
+	if(num >= m_pIndex->num_bucs_lev1)
+		break;
+
+	/* allow the same compressed size per input char as fm_build does for the whole text */
+	sb_len = MIN((uint64_t)m_pIndex->bucket_size_lev1, m_pIndex->text_size - num * m_pIndex->bucket_size_lev1);
+	req_size = 100 + (uint64_t)(sb_len * 1.5);
+	if((pPars->BuffUsed + req_size) > pPars->BuffSize) {
+		new_size = (pPars->BuffUsed + req_size) * 2;
+		if((pTmp = (uint8_t *)realloc(pPars->pBuff, (size_t)new_size)) == NULL)
+			return FM_OUTMEM;
+		pPars->pBuff = pTmp;
+		pPars->BuffSize = new_size;
+	}
+
+	pIdx->compress = pPars->pBuff;
+	pIdx->compress_size = pPars->BuffUsed;
+	pWorker->fm_init_bit_writer(pPars->pBuff + pPars->BuffUsed, &pIdx->compress_size);
+	if((error = pWorker->compress_superbucket(num)) < 0)
+		return error;
+
+	m_pCompressedSBs[num].ThreadIdx = pPars->ThreadIdx;
+	m_pCompressedSBs[num].BuffOfs = pPars->BuffUsed;
+	m_pCompressedSBs[num].Len = pIdx->compress_size - pPars->BuffUsed;
+	pPars->BuffUsed = pIdx->compress_size;
+  }
+  return FM_OK;
+}
+
+int
+CFMIndex::compress_superbuckets_mt(void)
+{
+  tsFMICompressThread *pThreads, *pThread;
+  tsFMICompressedSB *pSB;
+  int ThreadIdx, NumThreads, NumStarted, error = FM_OK;
+  uint64_t num, b2, first_b2, last_b2, bucs_per_sb;
+
+  NumThreads = (int)MIN((uint64_t)m_NumThreads, m_pIndex->num_bucs_lev1);
+  if((m_pCompressedSBs = new tsFMICompressedSB [m_pIndex->num_bucs_lev1]) == NULL)
+	return FM_OUTMEM;
+  if((pThreads = new tsFMICompressThread [NumThreads]) == NULL) {
+	delete []m_pCompressedSBs;
+	m_pCompressedSBs = NULL;
+	return FM_OUTMEM;
+  }
+  memset(pThreads,0,sizeof(tsFMICompressThread) * NumThreads);
+
+  /* each worker shares the index being built but has it's own mtf buffer and output */
+  for(ThreadIdx = 0, pThread = pThreads; ThreadIdx < NumThreads; ThreadIdx++, pThread++) {
+	pThread->pThis = this;
+	pThread->ThreadIdx = ThreadIdx;
+	pThread->Rslt = FM_OK;
+	if((pThread->pWorker = new CFMIndex) == NULL) {
+		error = FM_OUTMEM;
+		break;
+	}
+	*pThread->pWorker->m_pIndex = *m_pIndex;
+	pThread->pWorker->m_pIndex->compress = NULL;
+	pThread->pWorker->m_pIndex->mtf_seq = (unsigned char *)malloc(m_pIndex->bucket_size_lev2 * sizeof(unsigned char));
+	if(pThread->pWorker->m_pIndex->mtf_seq == NULL) {
+		error = FM_OUTMEM;
+		break;
+	}
+  }
+
+  /* superbuckets are claimed dynamically so if not all threads could be started then those started will compress all superbuckets */
+  if(error == FM_OK) {
+	m_NxtSuperbucket = 0;
+	for(NumStarted = 0, pThread = pThreads; NumStarted < NumThreads; NumStarted++, pThread++) {
+#ifdef _WIN32
+		if((pThread->threadHandle = (HANDLE)_beginthreadex(NULL,0x0fffff,CompressThread,pThread,0,&pThread->threadID)) == 0)
+			break;
+#else
+		if((pThread->threadRslt = pthread_create(&pThread->threadID,NULL,CompressThread,pThread)) != 0)
+			break;
+#endif
+	}
+	if(NumStarted == 0)
+		error = FM_GENERR;
+	for(ThreadIdx = 0, pThread = pThreads; ThreadIdx < NumStarted; ThreadIdx++, pThread++) {
+#ifdef _WIN32
+		WaitForSingleObject(pThread->threadHandle,INFINITE);
+		CloseHandle(pThread->threadHandle);
+#else
+		pthread_join(pThread->threadID,NULL);
+#endif
+		if(pThread->Rslt < 0)
+			error = pThread->Rslt;
+	}
+  }
+
+  /* concatenate the compressed superbuckets and rebase their bucket starts */
+  if(error == FM_OK) {
+	bucs_per_sb = m_pIndex->bucket_size_lev1 / m_pIndex->bucket_size_lev2;
+	for(num = 0, pSB = m_pCompressedSBs; num < m_pIndex->num_bucs_lev1; num++, pSB++) {
+		memcpy(m_pIndex->compress + m_pIndex->compress_size, pThreads[pSB->ThreadIdx].pBuff + pSB->BuffOfs, (size_t)pSB->Len);
+		first_b2 = num * bucs_per_sb;
+		last_b2 = MIN(first_b2 + bucs_per_sb, m_pIndex->num_bucs_lev2);
+		for(b2 = first_b2; b2 < last_b2; b2++)
+			m_pIndex->start_lev2[b2] = m_pIndex->start_lev2[b2] - pSB->BuffOfs + m_pIndex->compress_size;
+		m_pIndex->compress_size += pSB->Len;
+	}
+  }
+
+  for(ThreadIdx = 0, pThread = pThreads; ThreadIdx < NumThreads; ThreadIdx++, pThread++) {
+	if(pThread->pBuff != NULL)
+		free(pThread->pBuff);
+	if(pThread->pWorker != NULL) {
+		if(pThread->pWorker->m_pIndex->mtf_seq != NULL)
+			free(pThread->pWorker->m_pIndex->mtf_seq);
+		memset(pThread->pWorker->m_pIndex,0,sizeof(fm_index));	// shared allocations are owned by this instance
+		delete pThread->pWorker;
+	}
+  }
+  delete []pThreads;
+  delete []m_pCompressedSBs;
+  m_pCompressedSBs = NULL;
+  return error;
+}
+
 /*
    write the starting position (in the output file) of each one 
    of the m_pIndex->num_bucs_lev2 buckets. These values are written at the
@@ -4539,15 +4961,15 @@ CFMIndex::compress_superbucket(UINT32 num)
 void 
 CFMIndex::write_susp_infos(void) {
   	 
-  	UINT32 i, offset, unuseful = 0;
+  	uint64_t i, offset, unuseful = 0;
 	unsigned char *write;
 
   	/* write starting position of points to positions  marked and sb occ list */
   	// warning! the constant POINTPROLOGUE depends on the structure of the prologue!!!
 	write = m_pIndex->compress + POINTPROLOGUE;
   	fm_init_bit_writer(write, &unuseful); // vado a scrivere dove avevo lasciato spazio
-  	fm_uint_write(m_pIndex->start_positions);
-	fm_uint_write(m_pIndex->start_prologue_info_sb); // inizio sbuckets info
+  	fm_uint64_write(m_pIndex->start_positions);
+	fm_uint64_write(m_pIndex->start_prologue_info_sb); // inizio sbuckets info
 		
   	// Warning: the offset heavily depends on the structure of prologue.
   	//          The value of start_level2[0] has been initialized in
@@ -4557,7 +4979,7 @@ CFMIndex::write_susp_infos(void) {
 	write = m_pIndex->compress + offset;
  	fm_init_bit_writer(write, &unuseful);
   	for(i=0;i<m_pIndex->num_bucs_lev2;i++)
-          fm_bit_write(m_pIndex->var_byte_rappr, m_pIndex->start_lev2[i]);
+          fm_bit_write64(m_pIndex->var_byte_rappr, m_pIndex->start_lev2[i]);
 
 	fm_bit_flush();
 	write = m_pIndex->compress + m_pIndex->start_positions;
@@ -4573,11 +4995,11 @@ CFMIndex::write_susp_infos(void) {
 void 
 CFMIndex::write_locations(void) {
 
- 	UINT32 i;
+ 	uint64_t i;
 	fm_init_bit_buffer();
 	if(m_pIndex->skip == 1) { // marcamento completo file 	
 		for(i=0; i<m_pIndex->text_size; i++) 
-			fm_bit_write(m_pIndex->log2textsize, (UINT32)m_pIndex->lf[i]);
+			fm_bit_write64(m_pIndex->log2textsize, m_pIndex->lf[i]);
 		fm_bit_flush();
 		#if TESTINFO
 		Test.marked_pos = m_pIndex->log2textsize*m_pIndex->num_marked_rows/8;
@@ -4587,7 +5009,7 @@ CFMIndex::write_locations(void) {
 	
 	/* Marcamento sostituisci char bit log2 text_size*/
 	for(i=0; i<m_pIndex->num_marked_rows;i++) 
-		fm_bit_write(m_pIndex->log2textsize, (UINT32)(m_pIndex->loc_occ[i]-(m_pIndex->loc_occ[i]/(m_pIndex->skip+1)))-1);
+		fm_bit_write64(m_pIndex->log2textsize, (m_pIndex->loc_occ[i]-(m_pIndex->loc_occ[i]/(m_pIndex->skip+1)))-1);
 		
 	fm_bit_flush();
 
@@ -4622,7 +5044,7 @@ CFMIndex::dealloc(void) {
 void 
 CFMIndex::dealloc_bucketinfo(void)
 {
-	UINT32 i;
+	uint64_t i;
 	bucket_lev1 *sb;
 
 	free(m_pIndex->bwt);
@@ -4662,7 +5084,8 @@ int
 CFMIndex::save_index(char *filename) {
 
 	FILE *outfile;
-	char *outfile_name, *ext = EXT;
+	char *outfile_name;
+	const char *ext = cszFMIExt;
 	
 	outfile_name = (char *) malloc(strlen(filename)+strlen(ext)+1);
 	if (outfile_name == NULL) return FM_OUTMEM;
@@ -4677,7 +5100,7 @@ CFMIndex::save_index(char *filename) {
 
     	free(outfile_name);
 
-	UINT32 t = (UINT32)fwrite(m_pIndex->compress, sizeof(unsigned char), m_pIndex->compress_size, outfile);
+	uint64_t t = (uint64_t)fwrite(m_pIndex->compress, sizeof(unsigned char), (size_t)m_pIndex->compress_size, outfile);
 	if(t != m_pIndex->compress_size) {
 		fclose(outfile);
 		return FM_FILEERR;
@@ -4700,27 +5123,32 @@ return FM_OK;
 */
 int CFMIndex::fm_read_file(char *filename,		// file to read from 
 				 unsigned char **textt,			// returned buffer allocated using malloc() containing contents of file + space for suffix sorting 
-				 UINT32 *length)		// returned content length, excludes suffix sort length
+				 uint64_t *length)		// returned content length, excludes suffix sort length
 {
 
   unsigned char *text;
-  UINT32 t;
+  uint64_t t;
   FILE *infile;
   
   infile = fopen(filename, "rb"); // b is for binary: required by DOS
   if(infile == NULL) return FM_FILEERR;
   
   /* store input file length */
-  if(fseek(infile,0,SEEK_END) !=0 ) return FM_FILEERR;
-  *length = ftell(infile);
+#ifdef _WIN32
+  if(_fseeki64(infile,0,SEEK_END) !=0 ) return FM_FILEERR;
+  *length = _ftelli64(infile);
+#else
+  if(fseeko64(infile,0,SEEK_END) !=0 ) return FM_FILEERR;
+  *length = ftello64(infile);
+#endif
   
   /* alloc memory for text  */
-  text = (unsigned char *)malloc(((*length))*sizeof(*text)); 
+  text = (unsigned char *)malloc((size_t)((*length))*sizeof(*text)); 
   if(text == NULL) return FM_OUTMEM;  
   
   /* read text in one sweep */
   rewind(infile);
-  t = (UINT32)fread(text, sizeof(*text), (size_t) *length, infile);
+  t = (uint64_t)fread(text, sizeof(*text), (size_t) *length, infile);
   if(t!=*length) return FM_READERR;
   *textt = text;
   fclose(infile);
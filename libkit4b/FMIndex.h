@@ -7,6 +7,7 @@ const int cMinL1BlockSize  = cMinL2BlockSize * 4;	// minimum accepted level 1 bl
 const int cDfltL1BlockSize = cMinL1BlockSize * 4;	// default level 1 block size (in 1K increments)
 const int cMaxL1BlockSize  = 0x7fff;				// maximum accepted level 1 block size (in 1K increments)
 const double cDfltMarkerFreq = 0.02;				// marker frequency (0.0 <= Freq <= 1.0)
+const int cMaxFMIThreads = 64;						// fm_build will use at most this many threads when compressing superbuckets
 
 const int BZ_N_GROUPS = 6;
 const int BZ_MAX_CODE_LEN = 23;
@@ -14,14 +15,14 @@ const int BZ_MAX_ALPHA_SIZE = 258;
 const int ALPHASIZE = 256;
 
 		
-#define EXT ".fmi"
+const char cszFMIExt[] = ".fmi";					// index files are saved/loaded with this extension
 
 
 
 class CFMIndex
 {
 	typedef struct TAG_sBucket_lev1 {
-	  uint32_t *occ;             /* occ chars of compact alph in prev. superbuc */
+	  uint64_t *occ;             /* occ chars of compact alph in prev. superbuc */
 	  uint16_t alpha_size;
 	  uint8_t *bool_char_map;   /* boolean map of chars occurring in this superbucket */
 	} bucket_lev1;
@@ -31,17 +32,17 @@ class CFMIndex
 	  uint8_t *oldtext;				/* A copy of the input text */
 	  uint8_t *compress;				/* compress text */
 	  uint8_t *bwt;					/* BWT of input text */
-	  uint32_t *lf;					/* lf-mapping or suffix-array*/
-	  uint32_t compress_size;			/* size of compressed file */
-	  uint32_t text_size;				/* size of text */
+	  uint64_t *lf;					/* lf-mapping or suffix-array*/
+	  uint64_t compress_size;			/* size of compressed file */
+	  uint64_t text_size;				/* size of text */
 	  bucket_lev1 *buclist_lev1; 	/* array of num_bucs buckets */
 		
 	  /* Info readed/writed on index prologue */
 	  uint32_t bucket_size_lev1;		/* size of level 1 buckets */	
 	  uint32_t bucket_size_lev2;		/* size of level 2 buckets */
-	  uint32_t num_bucs_lev1;			/* number buckets lev 1 */
-	  uint32_t num_bucs_lev2;			/* number buckets lev 2 */
-	  uint32_t bwt_eof_pos;			/* position of EOF within BWT */
+	  uint64_t num_bucs_lev1;			/* number buckets lev 1 */
+	  uint64_t num_bucs_lev2;			/* number buckets lev 2 */
+	  uint64_t bwt_eof_pos;			/* position of EOF within BWT */
 	  uint16_t alpha_size;				/* actual size of alphabet in input text */
 	  uint16_t type_compression;		/* buckets lev 1 type of compression */
 	  double freq;					/* frequency of marked chars */
@@ -50,11 +51,11 @@ class CFMIndex
 	  uint16_t smalltext;				/* If == 1 stores plain text without compression */
 
 	  /* Starting position (in byte) of each group of info */
-	  uint32_t start_prologue_info_sb;	/* byte inizio info sui superbuckets */
-	  uint32_t start_prologue_info_b;	/* byte inizio posizioni buckets */
+	  uint64_t start_prologue_info_sb;	/* byte inizio info sui superbuckets */
+	  uint64_t start_prologue_info_b;	/* byte inizio posizioni buckets */
 	  uint8_t *start_prologue_occ;	/* byte inizio posizioni marcate */
-	  uint32_t start_positions;        /* byte inizio posizioni marcate per build */
-	  uint32_t *start_lev2;			/* starting position of each buckets in compr file */
+	  uint64_t start_positions;        /* byte inizio posizioni marcate per build */
+	  uint64_t *start_lev2;			/* starting position of each buckets in compr file */
 
 	  /* Chars remap info */
 	  uint16_t bool_char_map[ALPHASIZE];/* is 1 if char i appears on text */
@@ -67,7 +68,7 @@ class CFMIndex
 
 	  // Da spostare in una struct working_space
 	  /* Running temp info of actual superbucket and bucket */
-	  uint32_t pfx_char_occ[ALPHASIZE];	/* i stores # of occ of chars 0.. i-1 in the text */
+	  uint64_t pfx_char_occ[ALPHASIZE];	/* i stores # of occ of chars 0.. i-1 in the text */
 	  uint16_t	bool_map_sb[ALPHASIZE]; 	/* info alphabet for superbucket to be read */
 	  uint8_t inv_map_sb[ALPHASIZE]; 	/* inverse map for the current superbucket */
 	  uint16_t alpha_size_sb;	  					/* current superbucket alphasize */
@@ -82,16 +83,16 @@ class CFMIndex
 	  uint16_t int_dec_bits; 			/* log2(log2(text_size)) */
 	  uint16_t log2textsize; 			/* int_log2(s.text_size-1) */
 	  uint16_t var_byte_rappr;   		/* variable byte-length repr. (log2textsize+7)/8;*/
-	  uint32_t num_marked_rows;		/* number of marked rows */
-	  uint32_t bwt_occ[ALPHASIZE];     /* entry i stores # of occ of chars 0..i-1 */
-	  uint32_t char_occ[ALPHASIZE];	/* (useful for mtf2) entry i stores # of occ of char i == bwt_occ[i]-bwt_occ[i-1] */
+	  uint64_t num_marked_rows;		/* number of marked rows */
+	  uint64_t bwt_occ[ALPHASIZE];     /* entry i stores # of occ of chars 0..i-1 */
+	  uint64_t char_occ[ALPHASIZE];	/* (useful for mtf2) entry i stores # of occ of char i == bwt_occ[i]-bwt_occ[i-1] */
 	  uint16_t skip;			/* 0 no marked pos, 1 all pos are marked, 2 only a char is marked*/
 	  uint16_t sb_bitmap_size;			/* size in bytes of the bitmap of superbuckets */	
-	  uint32_t occcharinf; 			/* Number occs of the chars  < index->specialchar */
-	  uint32_t occcharsup; 			/* Number occs of the chars  <= index->specialchar */
+	  uint64_t occcharinf; 			/* Number occs of the chars  < index->specialchar */
+	  uint64_t occcharsup; 			/* Number occs of the chars  <= index->specialchar */
 	  
 	  /* Needed by fm_build */
-	  uint32_t *loc_occ;				/* Positions of marked rows */
+	  uint64_t *loc_occ;				/* Positions of marked rows */
 	  
 	} fm_index;
 
@@ -101,8 +102,8 @@ class CFMIndex
 
 	/* Report rows from mulri_count */
 	typedef struct TYPE_sMulti_count {
-		uint32_t first_row; 			/* riga inizio occorrenza */
-		uint32_t elements;   			/* numero occorrenze */	
+		uint64_t first_row; 			/* riga inizio occorrenza */
+		uint64_t elements;   			/* numero occorrenze */	
 		} multi_count;
 
 
@@ -110,10 +111,10 @@ class CFMIndex
 
 	fm_index *m_pIndex;							// contains complete context for compressed index
 
-	uint32_t * __Num_Bytes;				/* numero byte letti/scritti */
+	uint64_t * __Num_Bytes;				/* numero byte letti/scritti */
 	uint8_t * __MemAddress;				/* indirizzo della memoria dove scrivere */
 	int __Bit_buffer_size;						/* number of unread/unwritten bits in Bit_buffer */
-	uint32_t __pos_read;
+	uint64_t __pos_read;
 	uint32_t __Bit_buffer;
 
 	uint8_t *pmtf_start;
@@ -123,22 +124,65 @@ class CFMIndex
 	int used;	/* var usate dalla count multipla */
 	multi_count *lista;
 
-
-	int count_row_mu (uint8_t * pattern, uint32_t len, uint32_t sp,uint32_t ep);
-	inline void get_pos (uint32_t first_row, uint32_t element, uint16_t step, uint32_t * pos);
-	int multi_locate (uint32_t sp, uint32_t element, uint32_t * positions);
+	int m_NumThreads;							// fm_build compresses superbuckets using at most this many threads
+
+	// when m_bBucCache is set then get_info_b() decodes complete level 2 buckets and retains the decoded bucket
+	// so that subsequent requests into the same bucket need not decompress it again; only set by locate_batch()
+	bool m_bBucCache;
+	uint64_t m_CachedBuc;						// bucket currently decoded into m_pIndex->mtf_seq, valid only if m_bCachedBuc
+	bool m_bCachedBuc;
+
+	// superbucket compression is distributed over worker threads, each thread has it's own CFMIndex instance
+	// holding a private bit writer, huffman tables and output buffer
+	typedef struct TAG_sFMICompressThread {
+		CFMIndex *pThis;						// instance whose index is being built
+		CFMIndex *pWorker;						// private instance used by this thread
+		int ThreadIdx;							// uniquely identifies this thread
+		int Rslt;								// FM_OK if all claimed superbuckets compressed
+		uint8_t *pBuff;							// compressed superbuckets are appended into this buffer
+		uint64_t BuffSize;						// allocated size of pBuff
+		uint64_t BuffUsed;						// bytes used in pBuff
+	#ifdef _WIN32
+		HANDLE threadHandle;					// handle as returned by _beginthreadex()
+		unsigned int threadID;					// identifier as set by _beginthreadex()
+	#else
+		int threadRslt;							// result as returned by pthread_create ()
+		pthread_t threadID;						// identifier as set by pthread_create ()
+	#endif
+	} tsFMICompressThread;
+
+	typedef struct TAG_sFMICompressedSB {
+		int ThreadIdx;							// superbucket was compressed by this thread
+		uint64_t BuffOfs;						// starting offset of compressed superbucket in that threads buffer
+		uint64_t Len;							// compressed length
+	} tsFMICompressedSB;
+
+	volatile unsigned int m_NxtSuperbucket;		// next superbucket to be claimed by a compression thread
+	tsFMICompressedSB *m_pCompressedSBs;		// where each superbucket was compressed into
+
+#ifdef _WIN32
+	static unsigned __stdcall CompressThread(void * pThreadPars);
+#else
+	static void *CompressThread(void * pThreadPars);
+#endif
+	int CompressSuperbuckets(tsFMICompressThread *pPars);	// claim and compress superbuckets until all claimed
+	int compress_superbuckets_mt(void);		// compress all superbuckets using m_NumThreads threads
+
+	int count_row_mu (uint8_t * pattern, uint32_t len, uint64_t sp,uint64_t ep);
+	inline void get_pos (uint64_t first_row, uint64_t element, uint16_t step, uint64_t * pos);
+	int multi_locate (uint64_t sp, uint64_t element, uint64_t * positions);
 	void preBmBc(uint8_t *x, int m, int bmBc[]);
 	void suffixes(uint8_t *x, int m, int *suff);
 	void preBmGs(uint8_t *x, int m, int bmGs[]);
-	int fm_boyermoore(uint8_t * pattern, uint32_t length, uint32_t ** occ, uint32_t * numocc);
-	int open_file(char * filename, uint8_t ** file, uint32_t * size);
+	int fm_boyermoore(uint8_t * pattern, uint32_t length, uint64_t ** occ, uint64_t * numocc);
+	int open_file(char * filename, uint8_t ** file, uint64_t * size);
 	int fm_read_basic_prologue (void);
 	int fm_multi_count (uint8_t * pattern, uint32_t len,multi_count ** list);
 
-	int occ_all (uint32_t sp, uint32_t ep, uint32_t * occsp, uint32_t * occep,uint8_t * char_in);
-	int get_info_sb (uint32_t pos, uint32_t * occ);
-	int get_info_b (uint8_t ch, uint32_t pos, uint32_t *occ, int flag);
-	uint8_t get_b_multihuf(uint32_t k, uint32_t * occ,int is_odd);
+	int occ_all (uint64_t sp, uint64_t ep, uint64_t * occsp, uint64_t * occep,uint8_t * char_in);
+	int get_info_sb (uint64_t pos, uint64_t * occ);
+	int get_info_b (uint8_t ch, uint64_t pos, uint32_t *occ, int flag);
+	uint8_t get_b_multihuf(uint64_t k, uint32_t * occ,int is_odd);
 	inline void unmtf_unmap (uint8_t * mtf_seq, int len_mtf);
 	int compress_bucket(uint8_t *in, uint32_t len, uint16_t alphasize);
 	void mtf_string(uint8_t *in, uint8_t *out, uint32_t len, uint16_t mtflen);
@@ -161,18 +205,22 @@ class CFMIndex
 	int huf_base[BZ_N_GROUPS][BZ_MAX_CODE_LEN];	// decoding
 	int huf_perm[BZ_N_GROUPS][BZ_MAX_ALPHA_SIZE];	// decoding
 
-	void fm_init_bit_writer (uint8_t * mem, uint32_t * pos_mem);
+	void fm_init_bit_writer (uint8_t * mem, uint64_t * pos_mem);
 	void fm_bit_write (int n, uint32_t vv);
 	int fm_bit_read (int n);
+	void fm_bit_write64 (int n, uint64_t vv);	// n can be up to 64 bits
+	uint64_t fm_bit_read64 (int n);				// n can be up to 64 bits
 	void fm_bit_write24(int bits, uint32_t num);
 	void fm_uint_write (uint32_t uu);
 	uint32_t fm_uint_read (void);
+	void fm_uint64_write (uint64_t uu);
+	uint64_t fm_uint64_read (void);
 	void fm_init_bit_reader (uint8_t * mem);
 	void fm_bit_flush (void);
 	uint32_t fm_integer_decode (unsigned short int headbits);
 
 	int parse_options(char *optionz);
-	int build_index(uint8_t *text, uint32_t length, char *build_options);
+	int build_index(uint8_t *text, uint64_t length, char *build_options);
 	int build_sa(void);
 	void count_occ(void);
 	int build_bwt(void);
@@ -180,7 +228,7 @@ class CFMIndex
 	int compute_info_superbuckets(void);
 	int compute_info_buckets(void);
 	void write_prologue(void);
-	int compress_superbucket(uint32_t num);
+	int compress_superbucket(uint64_t num);
 	void write_susp_infos(void);
 	void write_locations(void);
 	int select_subchar(void);
@@ -190,26 +238,26 @@ class CFMIndex
 	int save_index(char *filename);
 	int fm_read_file(char *filename,		// file to read from 
 				 uint8_t **textt,			// returned buffer allocated using malloc() containing contents of file + space for suffix sorting 
-				 uint32_t *length);
+				 uint64_t *length);
 
 	const char *error_index(int e);
-	int int_log2(int u);
+	int int_log2(uint64_t u);
 	int int_pow2(int u);
 
-	uint32_t go_back(uint32_t row, uint32_t len, uint8_t *dest);
-	uint32_t go_forw(uint32_t row, uint32_t len, uint8_t *dest);
-	uint32_t fl_map(uint32_t row, uint8_t ch);
-	uint8_t get_firstcolumn_char(uint32_t row);
+	uint64_t go_back(uint64_t row, uint64_t len, uint8_t *dest);
+	uint64_t go_forw(uint64_t row, uint64_t len, uint8_t *dest);
+	uint64_t fl_map(uint64_t row, uint8_t ch);
+	uint8_t get_firstcolumn_char(uint64_t row);
 
-	int fm_snippet(uint32_t row, uint32_t plen, uint32_t clen, uint8_t *dest, 
-			   uint32_t *snippet_length);
+	int fm_snippet(uint64_t row, uint32_t plen, uint32_t clen, uint8_t *dest, 
+			   uint64_t *snippet_length);
 	int read_prologue(void);
 	int uncompress_data(void);
-	int uncompress_superbucket(uint32_t numsb, uint8_t *out);
+	int uncompress_superbucket(uint64_t numsb, uint8_t *out);
 	int fm_compute_lf(void);
 	int fm_invert_bwt(void);
 	void free_unbuild_mem(void);
-	int fm_unbuild(uint8_t ** text, uint32_t *length);
+	int fm_unbuild(uint8_t ** text, uint64_t *length);
 
 	void hbMakeCodeLengths(uint8_t *len,uint32_t *freq,uint32_t alphaSize,uint32_t maxLen);
 	void hbAssignCodes(uint32_t *code,uint8_t *length,uint32_t minLen,uint32_t maxLen,uint32_t alphaSize);
@@ -221,30 +269,44 @@ public:
 	~CFMIndex(void);
 	int CreateIndex(char *pszInFile,		// create from contents of this file
 					char *pszOutFile,		// write index into this file
-					unsigned int *pText_len = NULL, // returned file content length before index created	
-					unsigned int *pIndex_len = NULL, // created index length
+					uint64_t *pText_len = NULL, // returned file content length before index created	
+					uint64_t *pIndex_len = NULL, // created index length
 					int bsl1 = cDfltL1BlockSize,	// level 1 block size (in 1K increments) will be forced to be multiple of bsl2
 					int bsl2 = cDfltL2BlockSize,	// level 2 block size (in byte increments) will be forced to be multiple of 256
 					double Freq = cDfltMarkerFreq);	// marker frequency (0.0 <= Freq <= 1.0)
 
 	int load_index (char * filename);
-	int extract(uint32_t from, uint32_t to, uint8_t **dest,uint32_t *snippet_length);
+	int extract(uint64_t from, uint64_t to, uint8_t **dest,uint64_t *snippet_length);
 	int free_index (void);
-	int display(uint8_t *pattern, uint32_t length, uint32_t nums, uint32_t *numocc, 
-			uint8_t **snippet_text, uint32_t **snippet_len);
-	int locate (uint8_t * pattern, uint32_t length, uint32_t ** occ,uint32_t * numocc);
-	int count (uint8_t * pattern, uint32_t length, uint32_t * numocc);
-	int get_length (uint32_t * length);
+	int display(uint8_t *pattern, uint32_t length, uint32_t nums, uint64_t *numocc, 
+			uint8_t **snippet_text, uint64_t **snippet_len);
+	int locate (uint8_t * pattern, uint32_t length, uint64_t ** occ,uint64_t * numocc);
+	int count (uint8_t * pattern, uint32_t length, uint64_t * numocc);
+	int get_length (uint64_t * length);
+
+	// locate all occurrences of each of NumPatterns patterns
+	// patterns are processed in an order which maximises reuse of decompressed buckets between patterns
+	// returned ppOccs[PatIdx] (allocated with new []) contains pNumOccs[PatIdx] text positions for pattern PatIdx
+	// caller must release with free_batch()
+	int locate_batch(uint32_t NumPatterns,		// number of patterns
+					uint8_t **ppPatterns,		// patterns to locate
+					uint32_t *pLengths,			// pattern lengths
+					uint64_t ***pppOccs,		// returned array of pattern occurrence positions
+					uint64_t **ppNumOccs);		// returned array of pattern occurrence counts
+	void free_batch(uint32_t NumPatterns,		// number of patterns as used in locate_batch()
+					uint64_t **ppOccs,			// as returned by locate_batch()
+					uint64_t *pNumOccs);		// as returned by locate_batch()
+
+	void SetNumThreads(int NumThreads);			// fm_build will use at most this many threads (1..cMaxFMIThreads) when compressing superbuckets
 
 	int fm_build_config(double freq, uint32_t bsl1, uint32_t bsl2, uint16_t owner);
-	int fm_build(uint8_t *text, uint32_t length);
-	int index_size(uint32_t *size);
+	int fm_build(uint8_t *text, uint64_t length);
+	int index_size(uint64_t *size);
 
 
-	int load_index_mem(uint8_t *compress, uint32_t size);		// loads compressed content from user supplied memory
+	int load_index_mem(uint8_t *compress, uint64_t size);		// loads compressed content from user supplied memory
 	int save_index_mem(uint8_t *compress);					// saves compressed content into user supplied memory	
 
 	char *GetErrText(int error);
 
 };
-
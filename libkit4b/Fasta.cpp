@@ -30,23 +30,50 @@ Original 'BioKanga' copyright notice has been retained and immediately follows t
 
 CFasta::CFasta(void)
 {
+int32_t Idx;
+const char *pszBases;
 m_hFile = -1;
 m_gzFile = NULL;
+m_pBGZF = NULL;
 m_pszFastqSeq = NULL;
 m_pszFastqSeqQ = NULL;
 memset(m_FastaBlocks, 0, sizeof(m_FastaBlocks));
+memset(&m_EOFBlock, 0, sizeof(m_EOFBlock));
 m_pCurFastaBlock = NULL;
+m_bReadAheadActive = false;
+#ifdef _WIN32
+InitializeCriticalSection(&m_ReadAheadMutex);
+InitializeConditionVariable(&m_BlockFreeEvent);
+InitializeConditionVariable(&m_BlockFilledEvent);
+#else
+pthread_mutex_init(&m_ReadAheadMutex,NULL);
+pthread_cond_init(&m_BlockFreeEvent,NULL);
+pthread_cond_init(&m_BlockFilledEvent,NULL);
+#endif
+
+for(Idx = 0; Idx < 256; Idx++)
+	{
+	m_SeqChrs[Idx] = (Idx == '-' || (Idx < 0x80 && isalpha(Idx))) ? 1 : 0;
+	m_FastqBases[Idx] = 0;
+	}
+for(pszBases = "acgtnACGTN"; *pszBases != '\0'; pszBases++)
+	m_FastqBases[(uint8_t)*pszBases] = 1;
 Cleanup();
 }
 
 CFasta::~CFasta(void)
 {
+StopReadAhead();
+
 if (m_hFile >= 0)
 	close(m_hFile);
 
 if (m_gzFile != NULL)
 	gzclose(m_gzFile);
 
+if (m_pBGZF != NULL)
+	bgzf_close(m_pBGZF);
+
 if (m_pszFastqSeq != NULL)
 	delete[]m_pszFastqSeq;
 
@@ -58,11 +85,19 @@ for (int32_t Idx = 0; Idx < cNumFastaBlocks; Idx++)
 	if (m_FastaBlocks[Idx].pBlock != NULL)
 		delete[]m_FastaBlocks[Idx].pBlock;
 	}
+#ifdef _WIN32
+DeleteCriticalSection(&m_ReadAheadMutex);
+#else
+pthread_cond_destroy(&m_BlockFreeEvent);
+pthread_cond_destroy(&m_BlockFilledEvent);
+pthread_mutex_destroy(&m_ReadAheadMutex);
+#endif
 }
 
 void
 CFasta::Cleanup(void)
 {
+StopReadAhead();
 if(m_hFile >= 0)
 	{
 	if(!m_bRead)
@@ -81,6 +116,11 @@ if(m_gzFile != NULL)
 	gzclose(m_gzFile);
 	m_gzFile = NULL;
 	}
+if(m_pBGZF != NULL)
+	{
+	bgzf_close(m_pBGZF);
+	m_pBGZF = NULL;
+	}
 if (m_pszFastqSeq != NULL)
 	{
 	delete []m_pszFastqSeq;
@@ -97,7 +137,11 @@ for (int32_t Idx = 0; Idx < cNumFastaBlocks; Idx++)
 		delete []m_FastaBlocks[Idx].pBlock;
 	}
 memset(m_FastaBlocks, 0, sizeof(m_FastaBlocks));
+memset(&m_EOFBlock, 0, sizeof(m_EOFBlock));
 m_pCurFastaBlock = NULL;
+m_NumBlocks = 0;
+m_bHoldingBlock = false;
+m_ReadFileOfs = 0;
 m_FileDescrOfs = 0;
 m_FileReadDescrOfs = 0;
 m_szDescriptor[0] = '\0';
@@ -124,7 +168,8 @@ return(m_StatFileSize);
 int32_t
 CFasta::Open(char *pszFile,						// fasta or fastq file path+name to open
 			 bool Read,							// TRUE if opening for read, FALSE for write
-			 uint32_t BufferSize)			// use this size buffer for staging
+			 uint32_t BufferSize,			// use this size buffer for staging
+			 int32_t NumInflateThreads)		// BGZF compressed files are inflated by this many threads
 {
 int32_t Rslt;
 if(pszFile == NULL || *pszFile == '\0')
@@ -215,6 +260,20 @@ if(Read)		// read
 		return(Rslt);
 		}
 
+	// BGZF compressed files are independently compressed blocks which can be inflated in parallel
+	if(m_bIsGZ && bgzf_is_bgzf(pszFile))
+		{
+		gzclose(m_gzFile);
+		m_gzFile = NULL;
+		if((m_pBGZF = bgzf_open(pszFile,"r"))==NULL)
+			{
+			AddErrMsg("CFasta::Open","Unable to open %s as a BGZF file - %s",pszFile,strerror(errno));
+			Cleanup();
+			return(eBSFerrOpnFile);
+			}
+		if(NumInflateThreads > 1)
+			bgzf_mt(m_pBGZF,NumInflateThreads,cFastaInflateSubBlks);	// if unable to start threads then blocks will be inflated serially
+		}
 	}
 else			// write
 	{
@@ -241,35 +300,33 @@ else			// write
 if((uint64_t)BufferSize > (m_StatFileSize+100))			// a little additional never hurts!
 	BufferSize = (uint32_t)(m_StatFileSize + 100);
 
+// if reading a compressed file, or file is larger than a read-ahead block, then multiple smaller blocks are read (and inflated if compressed) by
+// a read-ahead thread whilst the current block is being parsed; otherwise a single block is synchronously read as and when required
 memset(m_FastaBlocks, 0, sizeof(m_FastaBlocks));
-
-m_pCurFastaBlock = &m_FastaBlocks[0];
-m_pCurFastaBlock->pBlock = new uint8_t[BufferSize];
-if (m_pCurFastaBlock->pBlock == NULL)
+m_NumBlocks = 1;
+if(Read && (m_bIsGZ || m_StatFileSize > cFastaReadAheadBlockSize))
 	{
-	AddErrMsg("CFasta::Open", "Memory allocation of %d bytes for %s- %s", BufferSize, pszFile, strerror(errno));
-	Cleanup();			// closes opened file..
-	return(eBSFerrMem);
+	m_NumBlocks = cNumFastaBlocks;
+	if(BufferSize > cFastaReadAheadBlockSize)
+		BufferSize = cFastaReadAheadBlockSize;
 	}
-m_pCurFastaBlock->AllocSize = BufferSize;
-if (m_bRead && cNumFastaBlocks > 1)
+
+for (int32_t Idx = 0; Idx < m_NumBlocks; Idx++)
 	{
-	for (int32_t Idx = 1; Idx < cNumFastaBlocks; Idx++)
+	m_FastaBlocks[Idx].pBlock = new uint8_t[BufferSize];
+	if (m_FastaBlocks[Idx].pBlock == NULL)
 		{
-		m_FastaBlocks[Idx].pBlock = new uint8_t[BufferSize];
-		if (m_FastaBlocks[Idx].pBlock == NULL)
-			{
-			AddErrMsg("CFasta::Open", "Memory allocation of %d bytes for %s- %s", BufferSize, pszFile, strerror(errno));
-			Cleanup();			// closes opened file..
-			return(eBSFerrMem);
-			}
-		m_FastaBlocks[Idx].AllocSize = BufferSize;
+		AddErrMsg("CFasta::Open", "Memory allocation of %d bytes for %s- %s", BufferSize, pszFile, strerror(errno));
+		Cleanup();			// closes opened file..
+		return(eBSFerrMem);
 		}
+	m_FastaBlocks[Idx].AllocSize = BufferSize;
 	}
-
+m_pCurFastaBlock = &m_FastaBlocks[0];
+m_EOFBlock.pBlock = m_FastaBlocks[0].pBlock;		// never accessed as EOF block is always empty
+m_bRead = Read;
 if((Rslt=Reset())!=eBSFSuccess)
 	return(Rslt);
-m_bRead = Read;
 return(eBSFSuccess);
 }
 
@@ -912,25 +969,16 @@ return(m_bIscsfasta);
 int32_t
 CFasta::Reset(int64_t FileOfs)
 {
-if(m_hFile == -1 && m_gzFile == NULL)
+int32_t Rslt;
+if(m_hFile == -1 && m_gzFile == NULL && m_pBGZF == NULL)
 	return(eBSFerrClosed);		
-int64_t SeekPsn;
-if(m_hFile != -1)
-	SeekPsn = _lseeki64(m_hFile,FileOfs,SEEK_SET);
-else
-	SeekPsn = gzseek(m_gzFile,(long)FileOfs,SEEK_SET);
-if(SeekPsn != FileOfs)
+if((Rslt = SeekTo(FileOfs)) != eBSFSuccess)
 	{
-	AddErrMsg("CFasta::Reset","Seek failed to offset %d on %s - %s",FileOfs,m_szFile,strerror(errno));
+	AddErrMsg("CFasta::Reset","Seek failed to offset %lld on %s - %s",FileOfs,m_szFile,strerror(errno));
 	Cleanup();
-	return(eBSFerrFileAccess);
+	return(Rslt);
 	}
 
-m_pCurFastaBlock = &m_FastaBlocks[0];
-m_pCurFastaBlock->FileOfs = 0;
-m_pCurFastaBlock->BuffCnt = 0;
-m_pCurFastaBlock->BuffIdx = 0;
-
 m_FileReadDescrOfs = 0;
 m_FileDescrOfs = 0;
 m_CurLineLen = 0;
@@ -942,6 +990,271 @@ m_CurFastQParseLine = 0;
 return(eBSFSuccess);
 }
 
+// SeekTo
+// Terminates any read-ahead, seeks to FileOfs, discards all buffered blocks and then restarts read-ahead from FileOfs
+// BGZF seeks are by virtual file offset so if seeking to other than the start of file then the file is reopened for gzip library seeks on uncompressed offsets
+int32_t
+CFasta::SeekTo(int64_t FileOfs)
+{
+int64_t SeekPsn;
+StopReadAhead();
+if(m_pBGZF != NULL)
+	{
+	if(FileOfs == 0)
+		SeekPsn = bgzf_seek(m_pBGZF,0,SEEK_SET) == 0 ? 0 : -1;
+	else
+		{
+		bgzf_close(m_pBGZF);
+		m_pBGZF = NULL;
+		if((m_gzFile = gzopen(m_szFile,"r"))==NULL)
+			return(eBSFerrOpnFile);
+		if(gzbuffer(m_gzFile,cgzAllocInBuffer)!=0)
+			return(eBSFerrMem);
+		SeekPsn = gzseek(m_gzFile,(long)FileOfs,SEEK_SET);
+		}
+	}
+else
+	{
+	if(m_hFile != -1)
+		SeekPsn = _lseeki64(m_hFile,FileOfs,SEEK_SET);
+	else
+		SeekPsn = gzseek(m_gzFile,(long)FileOfs,SEEK_SET);
+	}
+if(SeekPsn != FileOfs)
+	return(eBSFerrFileAccess);
+
+m_ReadFileOfs = FileOfs;
+m_pCurFastaBlock = &m_FastaBlocks[0];
+m_pCurFastaBlock->FileOfs = FileOfs;
+m_pCurFastaBlock->BuffCnt = 0;
+m_pCurFastaBlock->BuffIdx = 0;
+m_bHoldingBlock = false;
+if(m_bRead && m_NumBlocks > 1)
+	StartReadAhead();
+return(eBSFSuccess);
+}
+
+// ReadBlock
+// Reads, inflating if compressed, the next block of file content into pBlock
+// Called by the read-ahead thread if active, otherwise by the parsing thread
+int32_t				// returns number of chars read, 0 if EOF, < 0 if errors
+CFasta::ReadBlock(tsFastaBlock *pBlock)
+{
+int32_t NumRead;
+z_off_t RawFileOfs;
+if(m_pBGZF != NULL)			// compressed bytes read are counted as BGZF blocks are read
+	{
+	NumRead = (int32_t)bgzf_read(m_pBGZF, pBlock->pBlock, pBlock->AllocSize);
+	if(NumRead > 0)
+		CRunProfile::Count(eRPCBytesInflated,NumRead);
+	}
+else
+	{
+	if(m_gzFile != NULL)
+		{
+		RawFileOfs = CRunProfile::Enabled() ? gzoffset(m_gzFile) : 0;
+		NumRead = gzread(m_gzFile, pBlock->pBlock, pBlock->AllocSize);
+		if(NumRead > 0 && CRunProfile::Enabled())
+			{
+			CRunProfile::Count(eRPCBytesRead,gzoffset(m_gzFile) - RawFileOfs);
+			CRunProfile::Count(eRPCBytesInflated,NumRead);
+			}
+		}
+	else
+		{
+		NumRead = read(m_hFile, pBlock->pBlock, pBlock->AllocSize);
+		if(NumRead > 0)
+			CRunProfile::Count(eRPCBytesRead,NumRead);
+		}
+	}
+pBlock->FileOfs = m_ReadFileOfs;
+pBlock->BuffIdx = 0;
+pBlock->BuffCnt = NumRead;
+if(NumRead > 0)
+	m_ReadFileOfs += NumRead;
+return(NumRead);
+}
+
+// NextBlock
+// Makes the next block of file content current, releasing the previously current block back to the read-ahead thread for refilling
+// If no read-ahead thread then the single block is synchronously refilled
+int32_t				// returns number of chars available in block, 0 if EOF, < 0 if errors
+CFasta::NextBlock(void)
+{
+if(!m_bReadAheadActive)
+	{
+	m_pCurFastaBlock = &m_FastaBlocks[0];
+	return(ReadBlock(m_pCurFastaBlock));
+	}
+
+#ifdef _WIN32
+EnterCriticalSection(&m_ReadAheadMutex);
+#else
+pthread_mutex_lock(&m_ReadAheadMutex);
+#endif
+if(m_bHoldingBlock)			// current block has been completely parsed so can be refilled
+	{
+	m_bHoldingBlock = false;
+	m_NumFilled -= 1;
+#ifdef _WIN32
+	WakeConditionVariable(&m_BlockFreeEvent);
+#else
+	pthread_cond_signal(&m_BlockFreeEvent);
+#endif
+	}
+while(m_NumFilled == 0 && !m_bReadAheadEOF)
+#ifdef _WIN32
+	SleepConditionVariableCS(&m_BlockFilledEvent,&m_ReadAheadMutex,INFINITE);
+#else
+	pthread_cond_wait(&m_BlockFilledEvent,&m_ReadAheadMutex);
+#endif
+if(m_NumFilled == 0)		// read-ahead has completed, no more blocks will be filled
+	{
+	m_EOFBlock.FileOfs = m_ReadFileOfs;
+	m_EOFBlock.BuffIdx = 0;
+	m_EOFBlock.BuffCnt = m_ReadAheadRslt;
+	m_pCurFastaBlock = &m_EOFBlock;
+	}
+else
+	{
+	m_pCurFastaBlock = &m_FastaBlocks[m_NxtParseBlock];
+	m_NxtParseBlock = (m_NxtParseBlock + 1) % m_NumBlocks;
+	m_bHoldingBlock = true;
+	}
+#ifdef _WIN32
+LeaveCriticalSection(&m_ReadAheadMutex);
+#else
+pthread_mutex_unlock(&m_ReadAheadMutex);
+#endif
+return(m_pCurFastaBlock->BuffCnt);
+}
+
+// StartReadAhead
+// Starts read-ahead thread filling blocks from the current file offset
+// If the thread can't be started then blocks will be synchronously read by NextBlock()
+void
+CFasta::StartReadAhead(void)
+{
+m_NxtFillBlock = 0;
+m_NxtParseBlock = 0;
+m_NumFilled = 0;
+m_bHoldingBlock = false;
+m_bReadAheadTerm = false;
+m_bReadAheadEOF = false;
+m_ReadAheadRslt = 0;
+#ifdef _WIN32
+if((m_hReadAheadThread = (HANDLE)_beginthreadex(NULL,0x0fffff,ReadAheadThread,this,0,&m_ReadAheadThreadID))!=NULL)
+	m_bReadAheadActive = true;
+#else
+if(pthread_create(&m_ReadAheadThreadID,NULL,ReadAheadThread,this)==0)
+	m_bReadAheadActive = true;
+#endif
+}
+
+// StopReadAhead
+// Terminates read-ahead thread, any blocks filled but not yet parsed are discarded
+void
+CFasta::StopReadAhead(void)
+{
+if(!m_bReadAheadActive)
+	return;
+#ifdef _WIN32
+EnterCriticalSection(&m_ReadAheadMutex);
+m_bReadAheadTerm = true;
+WakeAllConditionVariable(&m_BlockFreeEvent);
+LeaveCriticalSection(&m_ReadAheadMutex);
+WaitForSingleObject(m_hReadAheadThread,INFINITE);
+CloseHandle(m_hReadAheadThread);
+#else
+pthread_mutex_lock(&m_ReadAheadMutex);
+m_bReadAheadTerm = true;
+pthread_cond_broadcast(&m_BlockFreeEvent);
+pthread_mutex_unlock(&m_ReadAheadMutex);
+pthread_join(m_ReadAheadThreadID,NULL);
+#endif
+m_bReadAheadActive = false;
+m_bHoldingBlock = false;
+m_NumFilled = 0;
+}
+
+#ifdef _WIN32
+unsigned int __stdcall
+CFasta::ReadAheadThread(void *pThis)
+{
+((CFasta *)pThis)->ReadAhead();
+return(0);
+}
+#else
+void *
+CFasta::ReadAheadThread(void *pThis)
+{
+((CFasta *)pThis)->ReadAhead();
+return(NULL);
+}
+#endif
+
+// ReadAhead
+// Read-ahead thread fills, inflating if compressed, blocks in ring order whilst there are blocks available to be filled
+// Terminates on EOF, read errors or when requested by StopReadAhead()
+void
+CFasta::ReadAhead(void)
+{
+int32_t NumRead;
+tsFastaBlock *pBlock;
+
+#ifdef _WIN32
+EnterCriticalSection(&m_ReadAheadMutex);
+#else
+pthread_mutex_lock(&m_ReadAheadMutex);
+#endif
+while(!m_bReadAheadTerm)
+	{
+	if(m_NumFilled == m_NumBlocks)			// wait for parser to release a block
+		{
+#ifdef _WIN32
+		SleepConditionVariableCS(&m_BlockFreeEvent,&m_ReadAheadMutex,INFINITE);
+#else
+		pthread_cond_wait(&m_BlockFreeEvent,&m_ReadAheadMutex);
+#endif
+		continue;
+		}
+	pBlock = &m_FastaBlocks[m_NxtFillBlock];
+#ifdef _WIN32
+	LeaveCriticalSection(&m_ReadAheadMutex);
+#else
+	pthread_mutex_unlock(&m_ReadAheadMutex);
+#endif
+	NumRead = ReadBlock(pBlock);
+#ifdef _WIN32
+	EnterCriticalSection(&m_ReadAheadMutex);
+#else
+	pthread_mutex_lock(&m_ReadAheadMutex);
+#endif
+	if(NumRead <= 0)
+		{
+		m_ReadAheadRslt = NumRead;
+		m_bReadAheadEOF = true;
+		}
+	else
+		{
+		m_NxtFillBlock = (m_NxtFillBlock + 1) % m_NumBlocks;
+		m_NumFilled += 1;
+		}
+#ifdef _WIN32
+	WakeConditionVariable(&m_BlockFilledEvent);
+#else
+	pthread_cond_signal(&m_BlockFilledEvent);
+#endif
+	if(m_bReadAheadEOF)
+		break;
+	}
+#ifdef _WIN32
+LeaveCriticalSection(&m_ReadAheadMutex);
+#else
+pthread_mutex_unlock(&m_ReadAheadMutex);
+#endif
+}
+
 
 // ReadSequence
 // Returns upto Max2Read bases from fasta or fastq input file
@@ -972,14 +1285,16 @@ CFasta::ReadSequence(void *pRetSeq,		// where to return sequence, can be NULL if
 bool bInDescriptor;		// true whilst processing descriptor or fastq sequence identifier characters
 bool bMoreToDo;
 char Chr;
-int64_t FileOfs;			// will contain file offset corresponding to last buffer read from file
 int32_t SeqLen = 0;
 char *pAscii = (char *)pRetSeq;
 int32_t Rslt;
 bool bSloughEOL;	// if true then skip to end of current line
 int32_t PrevSOLiDbase;
+uint8_t *pRun;			// run of sequence chars starting at this char
+int32_t RunLen;			// run is at most this long
+int32_t NumSeqChrs;		// run actually contains this many sequence chars
 
-if (m_gzFile == NULL && m_hFile == -1 || m_pCurFastaBlock == NULL || m_pCurFastaBlock->pBlock == NULL)
+if ((m_gzFile == NULL && m_hFile == -1 && m_pBGZF == NULL) || m_pCurFastaBlock == NULL || m_pCurFastaBlock->pBlock == NULL)
 	return(eBSFerrClosed);
 if(!m_bRead)
 	return(eBSFerrRead);
@@ -1025,27 +1340,42 @@ bSloughEOL = false;
 PrevSOLiDbase = 0;
 
 while(bMoreToDo) {
-	if (m_pCurFastaBlock->BuffIdx >= m_pCurFastaBlock->BuffCnt)	// time to refill m_pBuffer with another (up to) m_BuffSize chars?
+	if (m_pCurFastaBlock->BuffIdx >= m_pCurFastaBlock->BuffCnt)	// time to move onto the next block?
 		{
-		if(m_gzFile != NULL)
-			{
-			FileOfs = gztell(m_gzFile);
-			m_pCurFastaBlock->BuffCnt = gzread(m_gzFile, m_pCurFastaBlock->pBlock, m_pCurFastaBlock->AllocSize);
-			}
-		else
-			{
-			FileOfs = _lseeki64(m_hFile,0,SEEK_CUR);
-			m_pCurFastaBlock->BuffCnt = read(m_hFile, m_pCurFastaBlock->pBlock, m_pCurFastaBlock->AllocSize);
-			}
-
-		if (m_pCurFastaBlock->BuffCnt <= 0)
+		if (NextBlock() <= 0)
 			break;
-		m_pCurFastaBlock->BuffIdx = 0;
-		m_pCurFastaBlock->FileOfs = FileOfs;
 		}
 
 	while (m_pCurFastaBlock->BuffIdx < m_pCurFastaBlock->BuffCnt)
 		{
+		// runs of sequence chars are copied in bulk, only line endings and other chars need to be individually processed
+		if(!bInDescriptor && !bSloughEOL && !m_bIscsfasta)
+			{
+			pRun = &m_pCurFastaBlock->pBlock[m_pCurFastaBlock->BuffIdx];
+			RunLen = m_pCurFastaBlock->BuffCnt - m_pCurFastaBlock->BuffIdx;
+			if(pRetSeq != NULL && RunLen > Max2Ret - SeqLen)
+				RunLen = Max2Ret - SeqLen;
+			for(NumSeqChrs = 0; NumSeqChrs < RunLen && m_SeqChrs[pRun[NumSeqChrs]]; NumSeqChrs++);
+			if(NumSeqChrs > 0)
+				{
+				m_pCurFastaBlock->BuffIdx += NumSeqChrs;
+				SeqLen += NumSeqChrs;
+				if(pRetSeq == NULL)
+					continue;
+				memcpy(pAscii,pRun,NumSeqChrs);
+				pAscii += NumSeqChrs;
+				if(SeqLen < Max2Ret)
+					{
+					*pAscii = '\0';
+					continue;
+					}
+				m_bForceRetSeq = false;
+				if(bSeqBase)
+					return(Ascii2Sense((char *)pRetSeq,SeqLen,(etSeqBase *)pRetSeq,RptMskUpperCase));
+				return(SeqLen);
+				}
+			}
+
 		Chr = m_pCurFastaBlock->pBlock[m_pCurFastaBlock->BuffIdx++];
 		// ensure reading an ascii text file - only allow whitespace and chrs >= 0x20 and <= 0x7f
 		// note that if within a descriptor line then chars > 0x7f are tolerated but will be substituted with '?' 
@@ -1223,9 +1553,8 @@ CFasta::LocateDescriptor(char *pszPrefixToMatch,	// prefix to match or NULL if m
 char Buffer[16000];
 int32_t Cnt;
 int32_t CmpLen;
-int32_t FilePsn;
 
-if(m_gzFile == NULL && m_hFile == -1 )
+if(m_gzFile == NULL && m_hFile == -1 && m_pBGZF == NULL)
 	return(eBSFerrClosed);
 if(!m_bRead)
 	return(eBSFerrRead);
@@ -1239,11 +1568,7 @@ if(bFromStart)
 	m_FastqSeqIdx = 0;
 	m_FastqSeqQLen = 0;
 
-	if(m_gzFile != NULL)
-		FilePsn = gzseek(m_gzFile,0,SEEK_SET);
-	else
-		FilePsn = (int32_t)_lseeki64(m_hFile,0,SEEK_SET);
-	if(FilePsn != 0)
+	if(SeekTo(0) != eBSFSuccess)
 		{
 		AddErrMsg("CFasta::LocateDescriptor","Seek failed to offset 0 on %s - %s",m_szFile,strerror(errno));
 		return(eBSFerrFileAccess);
@@ -1280,12 +1605,12 @@ int32_t
 CFasta::ParseFastQblockQ(void)	
 {
 char Chr;
-int64_t FileOfs;			// will contain file offset corresponding to last buffer read from file
 int32_t ParseState;
 int32_t SeqLen = 0;
 bool bIsFastQSOLiD;	// some fastq files (from NCBA SRA SRP000191) have SOLiD sequences
+bool bCRLF;			// true if duplicate sequence identifier was terminated by '\r' so any immediately following '\n' is part of the same line ending
 char PrvBase;		// used if decoding SOLiD sequences
-if (m_gzFile == NULL && m_hFile == -1 || m_pCurFastaBlock == NULL || m_pCurFastaBlock->pBlock == NULL)
+if ((m_gzFile == NULL && m_hFile == -1 && m_pBGZF == NULL) || m_pCurFastaBlock == NULL || m_pCurFastaBlock->pBlock == NULL)
 	return(eBSFerrClosed);
 if(!m_bRead)
 	return(eBSFerrRead);
@@ -1294,26 +1619,16 @@ m_FastqSeqLen = 0;
 m_FastqSeqIdx = 0;
 m_FastqSeqQLen = 0;
 bIsFastQSOLiD = false;
+bCRLF = false;
 ParseState = 0;
 while(ParseState < 6) {
 	if (m_pCurFastaBlock->BuffIdx >= m_pCurFastaBlock->BuffCnt)
 		{
-		if(m_gzFile != NULL)
-			{
-			FileOfs = gztell(m_gzFile);
-			m_pCurFastaBlock->BuffCnt = gzread(m_gzFile, m_pCurFastaBlock->pBlock, m_pCurFastaBlock->AllocSize);
-			}
-		else
-			{
-			FileOfs = _lseeki64(m_hFile,0,SEEK_CUR);
-			m_pCurFastaBlock->BuffCnt = read(m_hFile, m_pCurFastaBlock->pBlock, m_pCurFastaBlock->AllocSize);
-			}
-
-		if (m_pCurFastaBlock->BuffCnt <= 0)
+		if (NextBlock() <= 0)
 			break;
-		m_pCurFastaBlock->BuffIdx = 0;
-		m_pCurFastaBlock->FileOfs = FileOfs;
 		}
+	if(ParseState == 0 && ParseFastQrecord())	// if a complete regular record is in current block then no need for per char parsing
+		return(eBSFFastaDescr);
 	while (ParseState < 6 && m_pCurFastaBlock->BuffIdx < m_pCurFastaBlock->BuffCnt)
 		{
 		Chr = m_pCurFastaBlock->pBlock[m_pCurFastaBlock->BuffIdx++];
@@ -1475,6 +1790,7 @@ while(ParseState < 6) {
 				if(!(Chr == '\n' || Chr == '\r'))	// slough duplicate, end of identifier?
 					continue;
 				ParseState = 5;			// next should be the quality scores
+				bCRLF = Chr == '\r';
 				continue;
 
 			case 5:		// parsing quality scores
@@ -1482,8 +1798,11 @@ while(ParseState < 6) {
 					{
 					if(m_FastqSeqQLen == 0)
 						{
-						if(m_FastqSeqLen > 1)
+						if(m_FastqSeqLen > 1 || (bCRLF && Chr == '\n'))
+							{
+							bCRLF = false;
 							continue;
+							}
 						m_pszFastqSeqQ[m_FastqSeqQLen++] = 'a';
 						}
 
@@ -1531,7 +1850,7 @@ if(ParseState == 5)
 	}
 
 // check all elements were present and not empty
-if(ParseState != 6 || m_DescriptorLen == 0 || m_FastqSeqLen == 0 && m_FastqSeqQLen == 0)
+if(ParseState != 6 || m_DescriptorLen == 0 || (m_FastqSeqLen == 0 && m_FastqSeqQLen == 0))
 	{
 	AddErrMsg("CFasta::ParseFastQblockQ","Errors whilst reading fastq file block, empty elements - '%s' near line %d", m_szFile,m_CurFastQParseLine+1);
 	AddErrMsg("CFasta::ParseFastQblockQ","Parse state: %d, Descriptor length: %d, Seq length: %d, Qual length: %d", ParseState,m_DescriptorLen,m_FastqSeqLen,m_FastqSeqQLen);
@@ -1547,6 +1866,92 @@ return(eBSFFastaDescr);
 
 
 
+// FastQLineLen
+// Returns length of line, excluding any trailing '\r', starting at pLine and terminated by '\n' at pEOL
+// Returns -1 if line contains any chars which are not printable ascii, such lines are left for ParseFastQblockQ() to process
+static inline int32_t
+FastQLineLen(uint8_t *pLine,uint8_t *pEOL)
+{
+uint8_t *pChr;
+if(pEOL > pLine && pEOL[-1] == '\r')
+	pEOL--;
+for(pChr = pLine; pChr < pEOL; pChr++)
+	if(*pChr < 0x20 || *pChr > 0x7f)
+		return(-1);
+return((int32_t)(pEOL - pLine));
+}
+
+// ParseFastQrecord
+// Fast path parsing of the usual 4 line fastq record when the complete record is contained within the current block
+// Line endings are located with memchr() and the record is copied in bulk
+// Returns false, with the current block unchanged, if the record is not completely contained in the current block or is in any way irregular
+// (SOLiD, missing sequence, multiple or empty lines, overlength, non-printable chars) in which case ParseFastQblockQ() char by char parsing is required
+bool
+CFasta::ParseFastQrecord(void)
+{
+uint8_t *pChr;
+uint8_t *pEnd;
+uint8_t *pDescr;
+uint8_t *pSeq;
+uint8_t *pQual;
+uint8_t *pEOL;
+int32_t NumLines;
+int32_t DescrLen;
+int32_t SeqLen;
+int32_t Idx;
+
+pChr = &m_pCurFastaBlock->pBlock[m_pCurFastaBlock->BuffIdx];
+pEnd = &m_pCurFastaBlock->pBlock[m_pCurFastaBlock->BuffCnt];
+NumLines = 0;
+while(pChr < pEnd && (*pChr == '\n' || *pChr == '\r'))	// slough line endings preceding record
+	if(*pChr++ == '\n')
+		NumLines += 1;
+if(pChr == pEnd || *pChr != '@')
+	return(false);
+
+// sequence identifier
+pDescr = pChr + 1;
+if((pEOL = (uint8_t *)memchr(pDescr,'\n',pEnd - pDescr)) == NULL || (DescrLen = FastQLineLen(pDescr,pEOL)) <= 0)
+	return(false);
+
+// sequence, must be a single line of acgtn's
+pSeq = pEOL + 1;
+if((pEOL = (uint8_t *)memchr(pSeq,'\n',pEnd - pSeq)) == NULL)
+	return(false);
+SeqLen = (int32_t)(pEOL - pSeq);
+if(SeqLen > 0 && pSeq[SeqLen-1] == '\r')
+	SeqLen -= 1;
+if(SeqLen == 0 || SeqLen > (int32_t)cMaxFastQSeqLen)
+	return(false);
+for(Idx = 0; Idx < SeqLen; Idx++)
+	if(!m_FastqBases[pSeq[Idx]])
+		return(false);
+
+// '+' duplicate sequence identifier
+pChr = pEOL + 1;
+if(pChr == pEnd || *pChr != '+' || (pEOL = (uint8_t *)memchr(pChr,'\n',pEnd - pChr)) == NULL || FastQLineLen(pChr,pEOL) < 0)
+	return(false);
+
+// quality scores, must be same length as sequence
+pQual = pEOL + 1;
+if((pEOL = (uint8_t *)memchr(pQual,'\n',pEnd - pQual)) == NULL || FastQLineLen(pQual,pEOL) != SeqLen)
+	return(false);
+
+m_FileDescrOfs = m_pCurFastaBlock->FileOfs + (pDescr - 1 - m_pCurFastaBlock->pBlock); // note file offset at which descriptor starts
+m_DescriptorLen = min(DescrLen,(int32_t)cMaxFastaDescrLen);
+memcpy(m_szDescriptor,pDescr,m_DescriptorLen);
+m_szDescriptor[m_DescriptorLen] = '\0';
+memcpy(m_pszFastqSeq,pSeq,SeqLen);
+m_pszFastqSeq[SeqLen] = '\0';
+m_FastqSeqLen = SeqLen;
+memcpy(m_pszFastqSeqQ,pQual,SeqLen);
+m_pszFastqSeqQ[SeqLen] = '\0';
+m_FastqSeqQLen = SeqLen;
+m_CurFastQParseLine += NumLines + 4;
+m_pCurFastaBlock->BuffIdx = (int32_t)(pEOL + 1 - m_pCurFastaBlock->pBlock);
+return(true);
+}
+
 // ReadSubsequence
 // Reads a subsubsequence from fasta starting at SeqOfs within the next sequence to be located in the fasta file
 int32_t										// number actually read
@@ -1562,7 +1967,7 @@ int32_t Cnt;
 int32_t CpyLen;
 int32_t CpyFromIdx;
 
-if (m_gzFile == NULL && m_hFile == -1 || m_pCurFastaBlock == NULL || m_pCurFastaBlock->pBlock == NULL)
+if ((m_gzFile == NULL && m_hFile == -1 && m_pBGZF == NULL) || m_pCurFastaBlock == NULL || m_pCurFastaBlock->pBlock == NULL)
 	return(eBSFerrClosed);
 
 if(!m_bRead)
@@ -1570,16 +1975,10 @@ if(!m_bRead)
 
 if(bFromStart) // if from start of source Fasta file
 	{
-	int32_t FileOfs;
 	m_pCurFastaBlock->BuffCnt = 0;
 	m_pCurFastaBlock->BuffIdx = 0;
 	m_bDescrAvail = false;
-	if(m_gzFile != NULL)
-		FileOfs = gzseek(m_gzFile,0,SEEK_SET);
-	else
-		FileOfs = (int32_t)_lseeki64(m_hFile,0,SEEK_SET);
-
-	if(FileOfs!=0)
+	if(SeekTo(0) != eBSFSuccess)
 		{
 		AddErrMsg("CFasta::ReadSubsequence","Seek failed to offset 0 on %s - %s",m_szFile,strerror(errno));
 		return(eBSFerrFileAccess);
@@ -1654,6 +2053,29 @@ return(eBaseN);
 // Ascii2Sense
 // Translates ascii into etSeqBase's
 // Caller can override assumption that lowercase represents softmasked repeats
+static uint8_t gAscii2Sense[2][256];	// etSeqBase for each ascii chr, [0] if lowercase represents softmasked repeats, [1] if uppercase represents softmasked repeats
+
+static bool
+InitAscii2Sense(void)
+{
+int32_t Idx;
+memset(gAscii2Sense,eBaseN,sizeof(gAscii2Sense));
+for(Idx = 0; Idx < 2; Idx++)
+	{
+	gAscii2Sense[Idx]['a'] = eBaseA | (Idx ? 0 : cRptMskFlg);
+	gAscii2Sense[Idx]['A'] = eBaseA | (Idx ? cRptMskFlg : 0);
+	gAscii2Sense[Idx]['c'] = eBaseC | (Idx ? 0 : cRptMskFlg);
+	gAscii2Sense[Idx]['C'] = eBaseC | (Idx ? cRptMskFlg : 0);
+	gAscii2Sense[Idx]['g'] = eBaseG | (Idx ? 0 : cRptMskFlg);
+	gAscii2Sense[Idx]['G'] = eBaseG | (Idx ? cRptMskFlg : 0);
+	gAscii2Sense[Idx]['t'] = gAscii2Sense[Idx]['u'] = eBaseT | (Idx ? 0 : cRptMskFlg);
+	gAscii2Sense[Idx]['T'] = gAscii2Sense[Idx]['U'] = eBaseT | (Idx ? cRptMskFlg : 0);
+	gAscii2Sense[Idx]['-'] = eBaseInDel;
+	}
+return(true);
+}
+static bool gbAscii2SenseInit = InitAscii2Sense();
+
 int32_t
 CFasta::Ascii2Sense(char *pAscii,		// expected to be '\0' terminated, or SeqLen long
 					int32_t MaxSeqLen,		// maximal sized sequence that pSeq can hold				
@@ -1662,45 +2084,12 @@ CFasta::Ascii2Sense(char *pAscii,		// expected to be '\0' terminated, or SeqLen
 {
 char Base;
 int32_t SeqLen = 0;
+uint8_t *pMap = gAscii2Sense[RptMskUpperCase ? 1 : 0];
 while(MaxSeqLen-- && (Base = *pAscii++)!='\0')
 	{
 	SeqLen++;
-	switch(Base) {
-		case 'a':
-			*pSeq++ = eBaseA | (RptMskUpperCase ? 0 : cRptMskFlg);
-			continue;
-		case 'A':
-			*pSeq++ = eBaseA  | (RptMskUpperCase ? cRptMskFlg : 0);
-			continue;
-		case 'c':
-			*pSeq++ = eBaseC  | (RptMskUpperCase ? 0 : cRptMskFlg);
-			continue;
-		case 'C':
-			*pSeq++ =  eBaseC | (RptMskUpperCase ? cRptMskFlg : 0);
-			continue;
-		case 'g':
-			*pSeq++ =  eBaseG  | (RptMskUpperCase ? 0 : cRptMskFlg);
-			continue;
-		case 'G':
-			*pSeq++ =  eBaseG | (RptMskUpperCase ? cRptMskFlg : 0);
-			continue;
-		case 't': case 'u': 
-			*pSeq++ =  eBaseT  | (RptMskUpperCase ? 0 : cRptMskFlg);
-			continue;
-		case 'T': case 'U':
-			*pSeq++ =  eBaseT | (RptMskUpperCase ? cRptMskFlg : 0);
-			continue;
-
-		case '-':
-			*pSeq++ =  eBaseInDel;
-			continue;
-
-		default: // 'N'
-			*pSeq++ = eBaseN;
-			continue;
-		}
+	*pSeq++ = pMap[(uint8_t)Base];
 	}
-
 return(SeqLen);
 }
 
@@ -1712,7 +2101,7 @@ return(SeqLen);
 int32_t							// returns strlen of available descriptor or 0 if none
 CFasta::ReadDescriptor(char *pszDescriptor,int32_t MaxLen)
 {
-if(m_gzFile == NULL && m_hFile == -1)
+if(m_gzFile == NULL && m_hFile == -1 && m_pBGZF == NULL)
 	return(eBSFerrClosed);
 
 if(!m_bRead)
@@ -1721,7 +2110,7 @@ if(!m_bRead)
 if(!m_DescriptorLen || !m_bDescrAvail)
 	return(eBSFerrParams);
 
-strncpy(pszDescriptor,m_szDescriptor,MaxLen);
+memcpy(pszDescriptor,m_szDescriptor,min(m_DescriptorLen + 1,(uint32_t)MaxLen));	// no need to '\0' pad as strncpy() would
 if(m_DescriptorLen >= (uint32_t)MaxLen)
 	{
 	pszDescriptor[MaxLen-1] = '\0';
@@ -1737,7 +2126,7 @@ return(m_DescriptorLen);
 int32_t							// returns strlen of available quality scores or 0 if none
 CFasta::ReadQValues(char *pszValues,int32_t MaxLen)
 {
-if(m_gzFile == NULL && m_hFile == -1)
+if(m_gzFile == NULL && m_hFile == -1 && m_pBGZF == NULL)
 	return(eBSFerrClosed);
 
 if(!m_bRead)
@@ -1748,7 +2137,7 @@ if(!m_bDescrAvail)
 
 if(m_FastqSeqQLen)
 	{
-	strncpy(pszValues,m_pszFastqSeqQ,MaxLen);
+	memcpy(pszValues,m_pszFastqSeqQ,min(m_FastqSeqQLen + 1,MaxLen));	// no need to '\0' pad as strncpy() would
 	if(m_FastqSeqQLen >= MaxLen)
 		{
 		pszValues[MaxLen-1] = '\0';
@@ -1,5 +1,6 @@
 #pragma once
 #include "./commdefs.h"
+#include "./bgzf.h"
 
 /*
 Fastq scoring schema (from http://en.wikipedia.org/wiki/FASTQ_format )
@@ -31,7 +32,10 @@ const uint32_t cDfltStageBuffSize = 0x03ffffff;  // 64M buffer as default
 const uint32_t cMaxStageBuffSize = 0x03fffffff;	 // 1GB buffer as maximum
 const uint32_t cMinStageBuffSize = 0x0fffff;	 // 1M buffer as minimum
 
-const int32_t cNumFastaBlocks = 1;						 // when readahead disk buffering implemented then set to be 2 or more
+const int32_t cNumFastaBlocks = 4;						 // when reading then up to this many blocks are buffered, filled by a read-ahead thread whilst the current block is being parsed
+const uint32_t cFastaReadAheadBlockSize = 0x0ffffff;	 // read-ahead blocks are at most 16M so the parser is not kept waiting for a full staging buffer to be read
+const int32_t cFastaInflateThreads = 4;					 // BGZF compressed files are by default inflated by this many threads
+const int32_t cFastaInflateSubBlks = 16;				 // with each thread inflating batches of this many BGZF blocks
 
 const uint32_t cMaxGenFastaLineLen = 79;		// limit generated Fasta lines to this length
 const uint32_t cMaxFastaDescrLen   = 8192;	    // Fasta descriptor lines can be concatenated..
@@ -55,6 +59,7 @@ class CFasta : public CErrorCodes
 {
 	int32_t m_hFile;				// opened for write fasta
 	gzFile m_gzFile;			// opened for read (could be compressed) fasta or fastq
+	BGZF *m_pBGZF;				// opened for read if fasta or fastq was BGZF compressed, blocks are inflated in parallel
 	char m_szFile[_MAX_PATH];	// to hold fasta file path+name
 	uint64_t m_StatFileSize;		// file size as returned by stat() when file initially opened
 	bool m_bIsGZ;				// true if processing a gz compressed file
@@ -64,7 +69,37 @@ class CFasta : public CErrorCodes
 	bool m_bRead;				// TRUE if reading fasta file, FALSE if write to fasta file
 
 	tsFastaBlock *m_pCurFastaBlock;    // buffered fasta block currently being processed
-	tsFastaBlock m_FastaBlocks[cNumFastaBlocks];    // allow for at most cNumFastaBlocks buffered fasta file blocks; currently not implemented but in future will allow for readahead of blocks
+	tsFastaBlock m_FastaBlocks[cNumFastaBlocks];    // allow for at most cNumFastaBlocks buffered fasta file blocks, used as a ring of read-ahead blocks when reading
+	tsFastaBlock m_EOFBlock;	// empty block made current once all blocks have been parsed, BuffCnt < 0 if read errors
+
+	// read-ahead thread fills blocks m_NxtFillBlock onwards whilst blocks m_NxtParseBlock onwards are parsed
+	int32_t m_NumBlocks;			// number of allocated blocks, read-ahead is only used if 2 or more
+	int32_t m_NxtFillBlock;		// next block to be filled by read-ahead thread
+	int32_t m_NxtParseBlock;		// next filled block to be parsed
+	int32_t m_NumFilled;			// number of blocks filled, includes block currently being parsed
+	bool m_bHoldingBlock;		// true if m_pCurFastaBlock is a ring block which must be released back to read-ahead thread when parsed
+	bool m_bReadAheadActive;	// true whilst read-ahead thread is running
+	bool m_bReadAheadTerm;		// set true to request read-ahead thread to terminate
+	bool m_bReadAheadEOF;		// set true by read-ahead thread when no more blocks will be filled
+	int32_t m_ReadAheadRslt;		// < 0 if read-ahead thread encountered read errors
+	int64_t m_ReadFileOfs;		// (uncompressed) file offset at which next block will be read
+#ifdef _WIN32
+	CRITICAL_SECTION m_ReadAheadMutex;		// serialises access to read-ahead state
+	CONDITION_VARIABLE m_BlockFreeEvent;	// read-ahead thread waits on this for a block to become available to be filled
+	CONDITION_VARIABLE m_BlockFilledEvent;	// parser waits on this for a block to be filled
+	HANDLE m_hReadAheadThread;				// handle as returned by _beginthreadex()
+	unsigned int m_ReadAheadThreadID;		// identifier as set by _beginthreadex()
+	static unsigned int __stdcall ReadAheadThread(void *pThis);
+#else
+	pthread_mutex_t m_ReadAheadMutex;		// serialises access to read-ahead state
+	pthread_cond_t m_BlockFreeEvent;		// read-ahead thread waits on this for a block to become available to be filled
+	pthread_cond_t m_BlockFilledEvent;		// parser waits on this for a block to be filled
+	pthread_t m_ReadAheadThreadID;			// identifier as set by pthread_create()
+	static void *ReadAheadThread(void *pThis);
+#endif
+	uint8_t m_SeqChrs[256];		// non-zero for chars which are accepted as fasta sequence chars
+	uint8_t m_FastqBases[256];	// non-zero for chars which are accepted as fastq sequence bases by the fast path parser
+
 
 	bool m_bForceRetSeq;        // true if 1bp dummy sequence is to be returned even if no sequence is actually available
 	bool m_bDescrAvail;			// true if NEW descriptor available, reset by ReadDescriptor()
@@ -84,6 +119,14 @@ class CFasta : public CErrorCodes
 
 	int32_t CheckIsFasta(void);		// checks if file contents are likely to be fasta or fastq format
 	int32_t	ParseFastQblockQ(void); // Parses a fastq block (seq identifier + sequence + quality scores)
+	bool ParseFastQrecord(void);	// fast path parse of a complete fastq record contained in the current block, false if slower ParseFastQblockQ() parsing required
+
+	int32_t ReadBlock(tsFastaBlock *pBlock);	// read next block of file content into pBlock, returns number of chars read, 0 if EOF, < 0 if errors
+	int32_t NextBlock(void);		// make next block of file content current, returns number of chars available, 0 if EOF, < 0 if errors
+	int32_t SeekTo(int64_t FileOfs);	// stop any read-ahead, seek to FileOfs and restart read-ahead
+	void StartReadAhead(void);		// start read-ahead thread filling blocks from current file offset
+	void StopReadAhead(void);		// terminate read-ahead thread, any filled blocks are discarded
+	void ReadAhead(void);			// read-ahead thread processing loop
 
 public:
 	CFasta(void);
@@ -92,7 +135,7 @@ public:
 	int32_t Reset(int64_t FileOfs = 0l);				// reset context to that following an Open() with option to start processing at FileOfs
 												// NOTE: gzip library can't handle file offsets which are greater than 2^31 - 1
 
-	int32_t Open(char *pszFile,bool Read = true,uint32_t BufferSize = cMaxStageBuffSize);
+	int32_t Open(char *pszFile,bool Read = true,uint32_t BufferSize = cMaxStageBuffSize,int32_t NumInflateThreads = cFastaInflateThreads);
 	bool IsFastq(void);							// true if opened file is in fastq format
 	bool IsSOLiD(void);							// true if opened file is in SOLiD or colorspace format
 	uint64_t InitialFileSize(void);				// file size when initially opened for reading
@@ -0,0 +1,600 @@
+/*
+This toolkit is a source base clone of 'BioKanga' release 4.4.2 (https://github.com/csiro-crop-informatics/biokanga) and contains
+significant source code changes enabling new functionality and resulting process parameterisation changes. These changes have resulted in
+incompatibility with 'BioKanga'.
+
+Because of the potential for confusion by users unaware of functionality and process parameterisation changes then the modified source base
+and resultant compiled executables have been renamed to 'kit4b' - K-mer Informed Toolkit for Bioinformatics.
+The renaming will force users of the 'BioKanga' toolkit to examine scripting which is dependent on existing 'BioKanga'
+parameterisations so as to make appropriate changes if wishing to utilise 'kit4b' parameterisations and functionality.
+
+'kit4b' is being released under the Opensource Software License Agreement (GPLv3)
+'kit4b' is Copyright (c) 2019, 2020
+Please contact Dr Stuart Stephen < stuartjs@g3web.com > if you have any questions regarding 'kit4b'.
+
+Original 'BioKanga' copyright notice has been retained and immediately follows this notice..
+*/
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+// Multithreaded stable radix sort on 64bit keys, and stable merge sort for elements only ordered by a comparison function
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include "./commhdrs.h"
+#else
+#include <pthread.h>
+#include "./commhdrs.h"
+#endif
+
+#include "MTRadixSort.h"
+
+// need for speed rather than space...
+#pragma optimize("t", on)
+
+// work pool thread functions, context is the CMTRadixSort instance
+static int MTRadixGenKeys(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMTRadixSort *)pCtx)->GenKeys(StartIdx, EndIdx));
+}
+
+static int MTRadixCountDigits(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMTRadixSort *)pCtx)->CountDigits(StartIdx, EndIdx));
+}
+
+static int MTRadixScatterKeys(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMTRadixSort *)pCtx)->ScatterKeys(StartIdx, EndIdx));
+}
+
+static int MTRadixGatherEls(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMTRadixSort *)pCtx)->GatherEls(StartIdx, EndIdx));
+}
+
+static int MTRadixCopyEls(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMTRadixSort *)pCtx)->CopyEls(StartIdx, EndIdx));
+}
+
+static int MTRadixSortRuns(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMTRadixSort *)pCtx)->SortRuns(StartIdx, EndIdx));
+}
+
+static int MTRadixMergeSegs(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMTRadixSort *)pCtx)->MergeSegs(StartIdx, EndIdx));
+}
+
+CMTRadixSort::CMTRadixSort(void)
+{
+m_MaxThreads = cDfltSortThreads;
+m_pKeys = NULL;
+m_pTmpKeys = NULL;
+m_pChunkDigits = NULL;
+m_pChunkKeyBits = NULL;
+m_pTmpEls = NULL;
+m_pMergeSegs = NULL;
+Reset();
+}
+
+CMTRadixSort::~CMTRadixSort(void)
+{
+Reset();
+}
+
+void
+CMTRadixSort::Reset(void)
+{
+if(m_pKeys != NULL)
+	{
+	free(m_pKeys);
+	m_pKeys = NULL;
+	}
+if(m_pTmpKeys != NULL)
+	{
+	free(m_pTmpKeys);
+	m_pTmpKeys = NULL;
+	}
+if(m_pChunkDigits != NULL)
+	{
+	delete []m_pChunkDigits;
+	m_pChunkDigits = NULL;
+	}
+if(m_pChunkKeyBits != NULL)
+	{
+	delete []m_pChunkKeyBits;
+	m_pChunkKeyBits = NULL;
+	}
+if(m_pTmpEls != NULL)
+	{
+	free(m_pTmpEls);
+	m_pTmpEls = NULL;
+	}
+if(m_pMergeSegs != NULL)
+	{
+	delete []m_pMergeSegs;
+	m_pMergeSegs = NULL;
+	}
+m_pEls = NULL;
+m_NumEls = 0;
+m_ElSize = 0;
+m_pKeyFunc = NULL;
+m_pCmpFunc = NULL;
+m_ChunkEls = 0;
+m_NumChunks = 0;
+m_DigitShf = 0;
+m_pMergeSrc = NULL;
+m_pMergeDst = NULL;
+m_NumMergeSegs = 0;
+}
+
+// SetMaxThreads
+// Sets maximum number of threads to use, if 0 then cDfltSortThreads
+void
+CMTRadixSort::SetMaxThreads(int MaxThreads)
+{
+if(MaxThreads <= 0)
+	MaxThreads = cDfltSortThreads;
+if(MaxThreads > cMaxWorkPoolThreads)
+	MaxThreads = cMaxWorkPoolThreads;
+m_MaxThreads = MaxThreads;
+}
+
+// RunChunks
+// Process NumItems in chunks of ChunkSize, chunks are processed on the shared work pool unless single threaded or only a single chunk
+int
+CMTRadixSort::RunChunks(int64_t NumItems,	// number of items to process
+				int64_t ChunkSize,			// in chunks of this many items
+				WorkPoolFunc pFunc)			// processing function
+{
+int Rslt;
+int64_t StartIdx;
+CWorkPool *pWorkPool;
+
+if(NumItems <= 0)
+	return(eBSFSuccess);
+if(m_MaxThreads > 1 && NumItems > ChunkSize && (pWorkPool = CWorkPool::Shared(m_MaxThreads)) != NULL)
+	return(pWorkPool->ParallelFor(NumItems,ChunkSize,pFunc,this,0,NULL,NULL,NULL,m_MaxThreads));
+
+for(StartIdx = 0; StartIdx < NumItems; StartIdx += ChunkSize)
+	if((Rslt = pFunc(this,StartIdx,min(StartIdx + ChunkSize,NumItems),0)) < eBSFSuccess)
+		return(Rslt);
+return(eBSFSuccess);
+}
+
+int
+CMTRadixSort::Sort(void *pArray,			// array containing elements to be sorted
+				int64_t NumEls,				// number of elements in array
+				size_t ElSize,				// size in bytes of each element
+				RadixKeyFunc pKeyFunc)		// returns sort key for each element
+{
+int Rslt;
+int64_t ChunkIdx;
+int64_t DigitIdx;
+int64_t Ofs;
+int64_t Cnt;
+int64_t *pCnt;
+uint64_t KeysOR;
+uint64_t KeysAND;
+uint64_t DiffBits;
+tsRadixKey *pSwapKeys;
+
+if(pArray == NULL || NumEls < 2 || ElSize < 1 || pKeyFunc == NULL)
+	return(eBSFSuccess);
+
+Reset();
+m_pEls = (uint8_t *)pArray;
+m_NumEls = NumEls;
+m_ElSize = ElSize;
+m_pKeyFunc = pKeyFunc;
+if(NumEls < cMinMTSortEls)
+	m_ChunkEls = NumEls;
+else
+	m_ChunkEls = max(cMinMTRadixChunkEls,(NumEls + ((int64_t)m_MaxThreads * cWorkPoolChunksPerThread) - 1) / ((int64_t)m_MaxThreads * cWorkPoolChunksPerThread));
+m_NumChunks = (NumEls + m_ChunkEls - 1) / m_ChunkEls;
+
+if((m_pKeys = (tsRadixKey *)malloc(sizeof(tsRadixKey) * (size_t)NumEls)) == NULL ||
+	(m_pTmpKeys = (tsRadixKey *)malloc(sizeof(tsRadixKey) * (size_t)NumEls)) == NULL ||
+	(ElSize > sizeof(uint64_t) && (m_pTmpEls = (uint8_t *)malloc(ElSize * (size_t)NumEls)) == NULL) ||
+	(m_pChunkDigits = new int64_t [m_NumChunks * cMTRadixDigits]) == NULL ||
+	(m_pChunkKeyBits = new uint64_t [m_NumChunks * 2]) == NULL)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"CMTRadixSort::Sort: unable to allocate working memory for sorting %lld elements",(long long)NumEls);
+	Reset();
+	return(eBSFerrMem);
+	}
+
+if((Rslt = RunChunks(NumEls,m_ChunkEls,MTRadixGenKeys)) < eBSFSuccess)
+	{
+	Reset();
+	return(Rslt);
+	}
+
+// only need radix passes over digits with bits which differ between at least two keys
+KeysOR = 0;
+KeysAND = ~(uint64_t)0;
+for(ChunkIdx = 0; ChunkIdx < m_NumChunks; ChunkIdx++)
+	{
+	KeysOR |= m_pChunkKeyBits[ChunkIdx * 2];
+	KeysAND &= m_pChunkKeyBits[(ChunkIdx * 2) + 1];
+	}
+DiffBits = KeysOR ^ KeysAND;
+if(DiffBits == 0)				// all keys identical, a stable sort leaves elements unchanged
+	{
+	Reset();
+	return(eBSFSuccess);
+	}
+
+for(m_DigitShf = 0; m_DigitShf < 64; m_DigitShf += cMTRadixDigitBits)
+	{
+	if(!((DiffBits >> m_DigitShf) & (cMTRadixDigits - 1)))
+		continue;
+	if((Rslt = RunChunks(NumEls,m_ChunkEls,MTRadixCountDigits)) < eBSFSuccess)
+		{
+		Reset();
+		return(Rslt);
+		}
+
+	// chunk counts become chunk scatter offsets, digits are ordered before chunks so scattering is stable
+	Ofs = 0;
+	for(DigitIdx = 0; DigitIdx < cMTRadixDigits; DigitIdx++)
+		{
+		pCnt = &m_pChunkDigits[DigitIdx];
+		for(ChunkIdx = 0; ChunkIdx < m_NumChunks; ChunkIdx++, pCnt += cMTRadixDigits)
+			{
+			Cnt = *pCnt;
+			*pCnt = Ofs;
+			Ofs += Cnt;
+			}
+		}
+
+	if((Rslt = RunChunks(NumEls,m_ChunkEls,MTRadixScatterKeys)) < eBSFSuccess)
+		{
+		Reset();
+		return(Rslt);
+		}
+	pSwapKeys = m_pKeys;
+	m_pKeys = m_pTmpKeys;
+	m_pTmpKeys = pSwapKeys;
+	}
+
+if((Rslt = RunChunks(NumEls,m_ChunkEls,MTRadixGatherEls)) >= eBSFSuccess && m_pTmpEls != NULL)
+	Rslt = RunChunks(NumEls,m_ChunkEls,MTRadixCopyEls);
+Reset();
+return(Rslt < eBSFSuccess ? Rslt : eBSFSuccess);
+}
+
+int
+CMTRadixSort::GenKeys(int64_t StartIdx, int64_t EndIdx)
+{
+int64_t Idx;
+uint64_t Key;
+uint64_t KeysOR;
+uint64_t KeysAND;
+uint8_t *pEl;
+tsRadixKey *pKey;
+
+KeysOR = 0;
+KeysAND = ~(uint64_t)0;
+pEl = &m_pEls[StartIdx * m_ElSize];
+pKey = &m_pKeys[StartIdx];
+for(Idx = StartIdx; Idx < EndIdx; Idx++, pEl += m_ElSize, pKey++)
+	{
+	Key = m_pKeyFunc(pEl);
+	pKey->Key = Key;
+	KeysOR |= Key;
+	KeysAND &= Key;
+	if(m_ElSize <= sizeof(uint64_t))
+		{
+		pKey->El = 0;
+		memcpy(&pKey->El,pEl,m_ElSize);
+		}
+	else
+		pKey->El = (uint64_t)Idx;
+	}
+m_pChunkKeyBits[(StartIdx / m_ChunkEls) * 2] = KeysOR;
+m_pChunkKeyBits[((StartIdx / m_ChunkEls) * 2) + 1] = KeysAND;
+return(eBSFSuccess);
+}
+
+int
+CMTRadixSort::CountDigits(int64_t StartIdx, int64_t EndIdx)
+{
+int Shf;
+int64_t *pCnts;
+tsRadixKey *pKey;
+tsRadixKey *pEndKey;
+
+Shf = m_DigitShf;
+pCnts = &m_pChunkDigits[(StartIdx / m_ChunkEls) * cMTRadixDigits];
+memset(pCnts,0,sizeof(int64_t) * cMTRadixDigits);
+pEndKey = &m_pKeys[EndIdx];
+for(pKey = &m_pKeys[StartIdx]; pKey < pEndKey; pKey++)
+	pCnts[(pKey->Key >> Shf) & (cMTRadixDigits - 1)] += 1;
+return(eBSFSuccess);
+}
+
+int
+CMTRadixSort::ScatterKeys(int64_t StartIdx, int64_t EndIdx)
+{
+int Shf;
+int64_t *pOfs;
+tsRadixKey *pKey;
+tsRadixKey *pEndKey;
+tsRadixKey *pTmpKeys;
+
+Shf = m_DigitShf;
+pTmpKeys = m_pTmpKeys;
+pOfs = &m_pChunkDigits[(StartIdx / m_ChunkEls) * cMTRadixDigits];
+pEndKey = &m_pKeys[EndIdx];
+for(pKey = &m_pKeys[StartIdx]; pKey < pEndKey; pKey++)
+	pTmpKeys[pOfs[(pKey->Key >> Shf) & (cMTRadixDigits - 1)]++] = *pKey;
+return(eBSFSuccess);
+}
+
+int
+CMTRadixSort::GatherEls(int64_t StartIdx, int64_t EndIdx)
+{
+int64_t Idx;
+tsRadixKey *pKey;
+uint8_t *pEl;
+
+pKey = &m_pKeys[StartIdx];
+if(m_ElSize <= sizeof(uint64_t))
+	{
+	pEl = &m_pEls[StartIdx * m_ElSize];
+	for(Idx = StartIdx; Idx < EndIdx; Idx++, pKey++, pEl += m_ElSize)
+		memcpy(pEl,&pKey->El,m_ElSize);
+	}
+else
+	{
+	pEl = &m_pTmpEls[StartIdx * m_ElSize];
+	for(Idx = StartIdx; Idx < EndIdx; Idx++, pKey++, pEl += m_ElSize)
+		memcpy(pEl,&m_pEls[pKey->El * m_ElSize],m_ElSize);
+	}
+return(eBSFSuccess);
+}
+
+int
+CMTRadixSort::CopyEls(int64_t StartIdx, int64_t EndIdx)
+{
+memcpy(&m_pEls[StartIdx * m_ElSize],&m_pTmpEls[StartIdx * m_ElSize],(size_t)(EndIdx - StartIdx) * m_ElSize);
+return(eBSFSuccess);
+}
+
+int
+CMTRadixSort::MergeSort(void *pArray,		// array containing elements to be sorted
+				int64_t NumEls,				// number of elements in array
+				size_t ElSize,				// size in bytes of each element
+				comparer CompareFunc)		// function to compare pairs of elements
+{
+int Rslt;
+int64_t Width;
+int64_t SegEls;
+int64_t MaxSegs;
+int64_t LeftStart;
+int64_t OutStart;
+tsMergeSeg *pSeg;
+uint8_t *pSwap;
+
+if(pArray == NULL || NumEls < 2 || ElSize < 1 || CompareFunc == NULL)
+	return(eBSFSuccess);
+
+Reset();
+m_pEls = (uint8_t *)pArray;
+m_NumEls = NumEls;
+m_ElSize = ElSize;
+m_pCmpFunc = CompareFunc;
+if(NumEls < cMinMTSortEls)
+	m_ChunkEls = NumEls;
+else
+	m_ChunkEls = max(cMinMTSortEls / 4,(NumEls + ((int64_t)m_MaxThreads * 4) - 1) / ((int64_t)m_MaxThreads * 4));
+m_NumChunks = (NumEls + m_ChunkEls - 1) / m_ChunkEls;
+SegEls = max(cMinMTMergeSegEls,(NumEls + ((int64_t)m_MaxThreads * 4) - 1) / ((int64_t)m_MaxThreads * 4));
+MaxSegs = ((NumEls + SegEls - 1) / SegEls) + m_NumChunks;
+
+if((m_pTmpEls = (uint8_t *)malloc(ElSize * (size_t)NumEls)) == NULL ||
+	(m_NumChunks > 1 && (m_pMergeSegs = new tsMergeSeg [MaxSegs]) == NULL))
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"CMTRadixSort::MergeSort: unable to allocate working memory for sorting %lld elements",(long long)NumEls);
+	Reset();
+	return(eBSFerrMem);
+	}
+
+// initially each chunk is independently sorted as a run
+if((Rslt = RunChunks(NumEls,m_ChunkEls,MTRadixSortRuns)) < eBSFSuccess)
+	{
+	Reset();
+	return(Rslt);
+	}
+
+// then pairs of runs are merged, each merge is split into output segments so all threads participate even when only a few runs remain
+m_pMergeSrc = m_pEls;
+m_pMergeDst = m_pTmpEls;
+for(Width = m_ChunkEls; Width < NumEls; Width *= 2)
+	{
+	m_NumMergeSegs = 0;
+	pSeg = m_pMergeSegs;
+	for(LeftStart = 0; LeftStart < NumEls; LeftStart += Width * 2)
+		{
+		for(OutStart = LeftStart; OutStart < min(LeftStart + (Width * 2),NumEls); OutStart += SegEls, pSeg++, m_NumMergeSegs++)
+			{
+			pSeg->LeftStart = LeftStart;
+			pSeg->RightStart = min(LeftStart + Width,NumEls);
+			pSeg->RightEnd = min(LeftStart + (Width * 2),NumEls);
+			pSeg->OutStart = OutStart;
+			pSeg->OutEnd = min(OutStart + SegEls,pSeg->RightEnd);
+			}
+		}
+	if((Rslt = RunChunks(m_NumMergeSegs,1,MTRadixMergeSegs)) < eBSFSuccess)
+		{
+		Reset();
+		return(Rslt);
+		}
+	pSwap = m_pMergeSrc;
+	m_pMergeSrc = m_pMergeDst;
+	m_pMergeDst = pSwap;
+	}
+
+Rslt = eBSFSuccess;
+if(m_pMergeSrc != m_pEls)		// merged elements need to be copied back into the array
+	Rslt = RunChunks(NumEls,m_ChunkEls,MTRadixCopyEls);
+Reset();
+return(Rslt < eBSFSuccess ? Rslt : eBSFSuccess);
+}
+
+// SortRuns
+// Stable sort of elements StartIdx..EndIdx-1, insertion sorts short runs then merges runs using the same range of m_pTmpEls
+int
+CMTRadixSort::SortRuns(int64_t StartIdx, int64_t EndIdx)
+{
+int64_t NumEls;
+int64_t RunStart;
+int64_t Width;
+size_t ElSize;
+uint8_t *pRunStart;
+uint8_t *pRunEnd;
+uint8_t *pProbe;
+uint8_t *pIns;
+uint8_t *pHold;
+uint8_t *pSrc;
+uint8_t *pDst;
+uint8_t *pSwap;
+
+ElSize = m_ElSize;
+NumEls = EndIdx - StartIdx;
+pHold = &m_pTmpEls[StartIdx * ElSize];		// tmp elements are not used until runs are merged so can hold the element being inserted
+
+for(RunStart = 0; RunStart < NumEls; RunStart += cMTMergeInsertEls)
+	{
+	pRunStart = &m_pEls[(StartIdx + RunStart) * ElSize];
+	pRunEnd = &m_pEls[(StartIdx + min(RunStart + cMTMergeInsertEls,NumEls)) * ElSize];
+	for(pProbe = pRunStart + ElSize; pProbe < pRunEnd; pProbe += ElSize)
+		{
+		for(pIns = pProbe; pIns > pRunStart && m_pCmpFunc(pIns - ElSize,pProbe) > 0; pIns -= ElSize);
+		if(pIns == pProbe)
+			continue;
+		memcpy(pHold,pProbe,ElSize);
+		memmove(pIns + ElSize,pIns,pProbe - pIns);
+		memcpy(pIns,pHold,ElSize);
+		}
+	}
+
+pSrc = &m_pEls[StartIdx * ElSize];
+pDst = &m_pTmpEls[StartIdx * ElSize];
+for(Width = cMTMergeInsertEls; Width < NumEls; Width *= 2)
+	{
+	for(RunStart = 0; RunStart < NumEls; RunStart += Width * 2)
+		MergeRuns(&pSrc[RunStart * ElSize],&pSrc[min(RunStart + Width,NumEls) * ElSize],
+				&pSrc[min(RunStart + Width,NumEls) * ElSize],&pSrc[min(RunStart + (Width * 2),NumEls) * ElSize],
+				&pDst[RunStart * ElSize],min(Width * 2,NumEls - RunStart));
+	pSwap = pSrc;
+	pSrc = pDst;
+	pDst = pSwap;
+	}
+if(pSrc != &m_pEls[StartIdx * ElSize])
+	memcpy(&m_pEls[StartIdx * ElSize],pSrc,(size_t)NumEls * ElSize);
+return(eBSFSuccess);
+}
+
+int
+CMTRadixSort::MergeSegs(int64_t StartIdx, int64_t EndIdx)
+{
+int64_t SegIdx;
+int64_t LeftOfs0;
+int64_t LeftOfs1;
+int64_t RightOfs0;
+int64_t RightOfs1;
+int64_t NumLeft;
+int64_t NumRight;
+size_t ElSize;
+uint8_t *pLeft;
+uint8_t *pRight;
+tsMergeSeg *pSeg;
+
+ElSize = m_ElSize;
+for(SegIdx = StartIdx; SegIdx < EndIdx; SegIdx++)
+	{
+	pSeg = &m_pMergeSegs[SegIdx];
+	pLeft = &m_pMergeSrc[pSeg->LeftStart * ElSize];
+	pRight = &m_pMergeSrc[pSeg->RightStart * ElSize];
+	NumLeft = pSeg->RightStart - pSeg->LeftStart;
+	NumRight = pSeg->RightEnd - pSeg->RightStart;
+	LeftOfs0 = MergeCoRank(pLeft,NumLeft,pRight,NumRight,pSeg->OutStart - pSeg->LeftStart);
+	LeftOfs1 = MergeCoRank(pLeft,NumLeft,pRight,NumRight,pSeg->OutEnd - pSeg->LeftStart);
+	RightOfs0 = (pSeg->OutStart - pSeg->LeftStart) - LeftOfs0;
+	RightOfs1 = (pSeg->OutEnd - pSeg->LeftStart) - LeftOfs1;
+	MergeRuns(&pLeft[LeftOfs0 * ElSize],&pLeft[LeftOfs1 * ElSize],&pRight[RightOfs0 * ElSize],&pRight[RightOfs1 * ElSize],
+				&m_pMergeDst[pSeg->OutStart * ElSize],pSeg->OutEnd - pSeg->OutStart);
+	}
+return(eBSFSuccess);
+}
+
+// MergeCoRank
+// Binary search for the number of left run elements in the first K elements output by a stable merge, left elements are output before equal right elements
+int64_t
+CMTRadixSort::MergeCoRank(uint8_t *pLeft,	// left run
+				int64_t NumLeft,			// left run has this many elements
+				uint8_t *pRight,			// right run
+				int64_t NumRight,			// right run has this many elements
+				int64_t K)					// number of merged elements
+{
+int64_t Lo;
+int64_t Hi;
+int64_t Mid;
+
+Lo = max((int64_t)0,K - NumRight);
+Hi = min(K,NumLeft);
+while(Lo < Hi)
+	{
+	Mid = (Lo + Hi + 1) / 2;
+	if(m_pCmpFunc(&pLeft[(Mid - 1) * m_ElSize],&pRight[(K - Mid) * m_ElSize]) <= 0)
+		Lo = Mid;
+	else
+		Hi = Mid - 1;
+	}
+return(Lo);
+}
+
+void
+CMTRadixSort::MergeRuns(uint8_t *pLeft,		// stable merge of left run
+				uint8_t *pLeftEnd,			// ending immediately before this element
+				uint8_t *pRight,			// with right run
+				uint8_t *pRightEnd,			// ending immediately before this element
+				uint8_t *pDst,				// into this buffer
+				int64_t NumEls)				// merging at most this many elements
+{
+size_t ElSize;
+ElSize = m_ElSize;
+while(NumEls > 0 && pLeft < pLeftEnd && pRight < pRightEnd)
+	{
+	if(m_pCmpFunc(pRight,pLeft) < 0)
+		{
+		memcpy(pDst,pRight,ElSize);
+		pRight += ElSize;
+		}
+	else
+		{
+		memcpy(pDst,pLeft,ElSize);
+		pLeft += ElSize;
+		}
+	pDst += ElSize;
+	NumEls -= 1;
+	}
+if(NumEls > 0 && pLeft < pLeftEnd)
+	memcpy(pDst,pLeft,min((size_t)(pLeftEnd - pLeft),(size_t)NumEls * ElSize));
+else
+	if(NumEls > 0 && pRight < pRightEnd)
+		memcpy(pDst,pRight,min((size_t)(pRightEnd - pRight),(size_t)NumEls * ElSize));
+}
@@ -0,0 +1,103 @@
+#pragma once
+// Multithreaded stable sorting of arrays of fixed size elements, processing is distributed over the process wide CWorkPool
+// Sort() is a least significant digit radix sort on 64bit keys. The caller supplied key function is called once per element, rather than a
+// comparison function being called for every compare, and (key,element) pairs are sorted so elements of any size are only moved once
+// Radix passes are only made over those 8bit key digits which differ between at least two keys
+// Sorting is stable so composite keys wider than 64bits can be sorted by successive Sort() calls, least significant key first
+// MergeSort() is a stable merge sort for elements which can only be ordered with a comparison function, e.g. elements with string keys
+// Sort() requires 32 bytes per element of working memory plus, if elements are larger than 8 bytes, a copy of the array; MergeSort() requires a copy of the array
+
+const int cMTRadixDigitBits = 8;				// radix digits are this many bits
+const int cMTRadixDigits = (1 << cMTRadixDigitBits);	// so each digit has this many values
+const int64_t cMinMTRadixChunkEls = 0x010000;	// each radix sort chunk, with it's own digit counts, contains at least this many elements
+const int64_t cMinMTSortEls = 0x020000;			// sort on the calling thread if fewer than this many elements
+const int cMTMergeInsertEls = 16;				// merge sort initially insertion sorts runs of this many elements
+const int64_t cMinMTMergeSegEls = 0x08000;		// parallel merges are split into output segments of at least this many elements
+
+typedef uint64_t (*RadixKeyFunc)(const void *pEl);	// returns the 64bit sort key for element pEl
+
+#pragma pack(8)
+typedef struct TAG_sRadixKey {
+	uint64_t Key;							// sort key for element
+	uint64_t El;							// if element size is no more than 8 bytes then the element itself, otherwise the element index
+} tsRadixKey;
+
+typedef struct TAG_sMergeSeg {
+	int64_t LeftStart;						// left run starts at this element
+	int64_t RightStart;						// right run, immediately following the left run, starts at this element
+	int64_t RightEnd;						// right run ends immediately before this element
+	int64_t OutStart;						// this segment of the merged output starts at this element
+	int64_t OutEnd;							// and ends immediately before this element
+} tsMergeSeg;
+#pragma pack()
+
+class CMTRadixSort
+{
+	int m_MaxThreads;						// use at most this many work pool threads
+
+	// current sort
+	uint8_t *m_pEls;						// elements being sorted
+	int64_t m_NumEls;						// number of elements
+	size_t m_ElSize;						// each element is this many bytes
+	RadixKeyFunc m_pKeyFunc;				// radix sort key function
+	comparer m_pCmpFunc;					// merge sort comparison function
+
+	int64_t m_ChunkEls;						// elements are processed in chunks of this many elements
+	int64_t m_NumChunks;					// number of chunks
+	tsRadixKey *m_pKeys;					// (key,element) pairs
+	tsRadixKey *m_pTmpKeys;					// radix passes alternate between m_pKeys and m_pTmpKeys
+	int64_t *m_pChunkDigits;				// per chunk digit counts, then scatter offsets, for current radix pass; m_NumChunks * cMTRadixDigits
+	uint64_t *m_pChunkKeyBits;				// per chunk bitwise OR and AND of keys, used to identify digits which differ between keys; m_NumChunks * 2
+	int m_DigitShf;							// current radix pass digit is at this key bit offset
+
+	uint8_t *m_pTmpEls;						// merge sort runs, and radix sort element gather, use this copy of the elements
+	uint8_t *m_pMergeSrc;					// current merge pass is from this buffer
+	uint8_t *m_pMergeDst;					// into this buffer
+	int64_t m_NumMergeSegs;					// number of merge output segments in current merge pass
+	tsMergeSeg *m_pMergeSegs;				// merge output segments
+
+	void Reset(void);						// release all working memory
+	int RunChunks(int64_t NumItems,			// process NumItems on work pool, or on calling thread if only single chunk or single thread
+				int64_t ChunkSize,			// in chunks of this many items
+				WorkPoolFunc pFunc);		// processing function
+
+	int64_t MergeCoRank(uint8_t *pLeft,		// returns number of elements from left run in the first K elements of stable merge of left and right runs
+				int64_t NumLeft,			// left run has this many elements
+				uint8_t *pRight,			// right run
+				int64_t NumRight,			// right run has this many elements
+				int64_t K);					// number of merged elements
+
+	void MergeRuns(uint8_t *pLeft,			// stable merge of left run
+				uint8_t *pLeftEnd,			// ending immediately before this element
+				uint8_t *pRight,			// with right run
+				uint8_t *pRightEnd,			// ending immediately before this element
+				uint8_t *pDst,				// into this buffer
+				int64_t NumEls);			// merging at most this many elements
+
+public:
+	CMTRadixSort(void);
+	~CMTRadixSort(void);
+
+	void SetMaxThreads(int MaxThreads);		// use at most this many threads, if 0 then cDfltSortThreads
+
+	// stable radix sort into ascending key order; returns eBSFSuccess, or eBSFerrMem if working memory could not be allocated in which case the array is unchanged
+	int Sort(void *pArray,					// array containing elements to be sorted
+				int64_t NumEls,				// number of elements in array
+				size_t ElSize,				// size in bytes of each element
+				RadixKeyFunc pKeyFunc);		// returns sort key for each element
+
+	// stable merge sort; returns eBSFSuccess, or eBSFerrMem if working memory could not be allocated in which case the array is unchanged
+	int MergeSort(void *pArray,				// array containing elements to be sorted
+				int64_t NumEls,				// number of elements in array
+				size_t ElSize,				// size in bytes of each element
+				comparer CompareFunc);		// function to compare pairs of elements
+
+	// work pool processing, public only so they are accessible to the pool thread functions
+	int GenKeys(int64_t StartIdx, int64_t EndIdx);		// generate (key,element) pairs
+	int CountDigits(int64_t StartIdx, int64_t EndIdx);	// count current digit in each chunk of keys
+	int ScatterKeys(int64_t StartIdx, int64_t EndIdx);	// scatter keys into their digit buckets
+	int GatherEls(int64_t StartIdx, int64_t EndIdx);	// copy sorted elements back into the array, or if elements larger than 8 bytes then into m_pTmpEls
+	int CopyEls(int64_t StartIdx, int64_t EndIdx);		// copy elements from m_pTmpEls back into the array
+	int SortRuns(int64_t StartIdx, int64_t EndIdx);		// merge sort chunks of elements
+	int MergeSegs(int64_t StartIdx, int64_t EndIdx);	// merge output segments
+};
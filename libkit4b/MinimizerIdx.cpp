@@ -0,0 +1,1291 @@
+/*
+This toolkit is a source base clone of 'BioKanga' release 4.4.2 (https://github.com/csiro-crop-informatics/biokanga) and contains
+significant source code changes enabling new functionality and resulting process parameterisation changes. These changes have resulted in
+incompatibility with 'BioKanga'.
+
+Because of the potential for confusion by users unaware of functionality and process parameterisation changes then the modified source base
+and resultant compiled executables have been renamed to 'kit4b' - K-mer Informed Toolkit for Bioinformatics.
+The renaming will force users of the 'BioKanga' toolkit to examine scripting which is dependent on existing 'BioKanga'
+parameterisations so as to make appropriate changes if wishing to utilise 'kit4b' parameterisations and functionality.
+
+'kit4b' is being released under the Opensource Software License Agreement (GPLv3)
+'kit4b' is Copyright (c) 2019, 2020
+Please contact Dr Stuart Stephen < stuartjs@g3web.com > if you have any questions regarding 'kit4b'.
+
+Original 'BioKanga' copyright notice has been retained and immediately follows this notice..
+*/
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+// Sampled minimizer k-mer index over suffix array sequences, seeds are gathered for a whole query as diagonal runs
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include "./commhdrs.h"
+#else
+#include <pthread.h>
+#include "./commhdrs.h"
+#endif
+
+// need for speed rather than space...
+#pragma optimize("t", on)
+
+const uint64_t cMzIdxNoHash = 0x0100000000;	// k-mers containing non-canonical bases are given this hash so they are never sampled
+
+// work pool thread functions, context is the CMinimizerIdx instance
+static int MzIdxCountBuckets(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMinimizerIdx *)pCtx)->CountBuckets(StartIdx, EndIdx, WorkerIdx));
+}
+
+static int MzIdxFillBuckets(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMinimizerIdx *)pCtx)->FillBuckets(StartIdx, EndIdx, WorkerIdx));
+}
+
+static int MzIdxSortBuckets(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMinimizerIdx *)pCtx)->SortBuckets(StartIdx, EndIdx));
+}
+
+// sort indexed minimizers by Hash.EntryID.Loci ascending
+static int SortMzIdxEntries(const void *arg1, const void *arg2)
+{
+tsMzIdxEntry *pEl1 = (tsMzIdxEntry *)arg1;
+tsMzIdxEntry *pEl2 = (tsMzIdxEntry *)arg2;
+if(pEl1->Hash < pEl2->Hash)
+	return(-1);
+if(pEl1->Hash > pEl2->Hash)
+	return(1);
+if(pEl1->EntryID < pEl2->EntryID)
+	return(-1);
+if(pEl1->EntryID > pEl2->EntryID)
+	return(1);
+if(pEl1->Loci < pEl2->Loci)
+	return(-1);
+if(pEl1->Loci > pEl2->Loci)
+	return(1);
+return(0);
+}
+
+// sort query hits by TargSeqID.Diag.QueryOfs ascending
+static int SortMzIdxHits(const void *arg1, const void *arg2)
+{
+tsMzIdxHit *pEl1 = (tsMzIdxHit *)arg1;
+tsMzIdxHit *pEl2 = (tsMzIdxHit *)arg2;
+if(pEl1->TargSeqID < pEl2->TargSeqID)
+	return(-1);
+if(pEl1->TargSeqID > pEl2->TargSeqID)
+	return(1);
+if(pEl1->Diag < pEl2->Diag)
+	return(-1);
+if(pEl1->Diag > pEl2->Diag)
+	return(1);
+if(pEl1->QueryOfs < pEl2->QueryOfs)
+	return(-1);
+if(pEl1->QueryOfs > pEl2->QueryOfs)
+	return(1);
+return(0);
+}
+
+// sort candidate targets by NumShared descending then TargSeqID ascending
+static int SortMzIdxCands(const void *arg1, const void *arg2)
+{
+tsMzIdxCand *pEl1 = (tsMzIdxCand *)arg1;
+tsMzIdxCand *pEl2 = (tsMzIdxCand *)arg2;
+if(pEl1->NumShared > pEl2->NumShared)
+	return(-1);
+if(pEl1->NumShared < pEl2->NumShared)
+	return(1);
+if(pEl1->TargSeqID < pEl2->TargSeqID)
+	return(-1);
+if(pEl1->TargSeqID > pEl2->TargSeqID)
+	return(1);
+return(0);
+}
+
+CMinimizerIdx::CMinimizerIdx(void)
+{
+m_pSfxArray = NULL;
+m_ppEntrySeqs = NULL;
+m_pEntrySeqLens = NULL;
+m_SfxFileSize = 0;
+m_SfxModTime = 0;
+m_pBuckets = NULL;
+m_pMinimizers = NULL;
+m_pSegs = NULL;
+m_ppWorkerMinimizers = NULL;
+m_pBucketFill = NULL;
+m_NumWorkers = 0;
+Reset();
+}
+
+CMinimizerIdx::~CMinimizerIdx(void)
+{
+Reset();
+}
+
+void
+CMinimizerIdx::ResetBuild(void)
+{
+int WorkerIdx;
+if(m_ppWorkerMinimizers != NULL)
+	{
+	for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+		if(m_ppWorkerMinimizers[WorkerIdx] != NULL)
+			delete []m_ppWorkerMinimizers[WorkerIdx];
+	delete []m_ppWorkerMinimizers;
+	m_ppWorkerMinimizers = NULL;
+	}
+m_NumWorkers = 0;
+if(m_pSegs != NULL)
+	{
+	delete []m_pSegs;
+	m_pSegs = NULL;
+	}
+m_NumSegs = 0;
+if(m_pBucketFill != NULL)
+	{
+	delete [](int64_t *)m_pBucketFill;
+	m_pBucketFill = NULL;
+	}
+}
+
+void
+CMinimizerIdx::Reset(void)
+{
+ResetBuild();
+if(m_ppEntrySeqs != NULL)
+	{
+	delete []m_ppEntrySeqs;
+	m_ppEntrySeqs = NULL;
+	}
+if(m_pEntrySeqLens != NULL)
+	{
+	delete []m_pEntrySeqLens;
+	m_pEntrySeqLens = NULL;
+	}
+if(m_pBuckets != NULL)
+	{
+	delete []m_pBuckets;
+	m_pBuckets = NULL;
+	}
+if(m_pMinimizers != NULL)
+	{
+	free(m_pMinimizers);
+	m_pMinimizers = NULL;
+	}
+m_pSfxArray = NULL;
+m_NumEntries = 0;
+m_SfxFileSize = 0;
+m_SfxModTime = 0;
+m_KMerMsk = 0;
+m_BucketShf = 0;
+memset(&m_Hdr,0,sizeof(m_Hdr));
+}
+
+void
+CMinimizerIdx::FreeScratch(tsMzIdxScratch *pScratch)
+{
+if(pScratch == NULL)
+	return;
+if(pScratch->pMinimizers != NULL)
+	free(pScratch->pMinimizers);
+if(pScratch->pHits != NULL)
+	free(pScratch->pHits);
+if(pScratch->pCands != NULL)
+	free(pScratch->pCands);
+memset(pScratch,0,sizeof(tsMzIdxScratch));
+}
+
+int
+CMinimizerIdx::GetKMerLen(void)
+{
+return(m_Hdr.KMerLen);
+}
+
+int
+CMinimizerIdx::GetWinLen(void)
+{
+return(m_Hdr.WinLen);
+}
+
+int64_t
+CMinimizerIdx::GetNumMinimizers(void)
+{
+return(m_Hdr.NumMinimizers);
+}
+
+// InitEntries
+// Only sequences in the currently loaded suffix block are indexed, other entries are treated as being zero length
+int
+CMinimizerIdx::InitEntries(CSfxArray *pSfxArray)
+{
+uint32_t EntryID;
+m_pSfxArray = pSfxArray;
+m_NumEntries = (uint32_t)pSfxArray->GetNumEntries();
+if(m_NumEntries == 0)
+	return(eBSFerrNoEntries);
+if((m_ppEntrySeqs = new etSeqBase *[m_NumEntries]) == NULL ||
+	(m_pEntrySeqLens = new uint32_t [m_NumEntries]) == NULL)
+	return(eBSFerrMem);
+for(EntryID = 1; EntryID <= m_NumEntries; EntryID++)
+	{
+	if((m_ppEntrySeqs[EntryID-1] = pSfxArray->GetLoadedSeqPtr(EntryID)) != NULL)
+		m_pEntrySeqLens[EntryID-1] = pSfxArray->GetSeqLen(EntryID);
+	else
+		m_pEntrySeqLens[EntryID-1] = 0;
+	}
+return(eBSFSuccess);
+}
+
+// SeqsSampleHash
+// FNV-1a over entry lengths and evenly spaced bases of each entry, detects targets regenerated with different bases but the same lengths
+uint64_t
+CMinimizerIdx::SeqsSampleHash(void)
+{
+uint32_t EntryIdx;
+uint32_t SeqLen;
+int Idx;
+uint64_t Hash;
+etSeqBase *pSeq;
+
+Hash = 0x0cbf29ce484222325;
+for(EntryIdx = 0; EntryIdx < m_NumEntries; EntryIdx++)
+	{
+	SeqLen = m_pEntrySeqLens[EntryIdx];
+	Hash ^= (uint64_t)SeqLen;
+	Hash *= 0x0100000001b3;
+	if(SeqLen == 0 || (pSeq = m_ppEntrySeqs[EntryIdx]) == NULL)
+		continue;
+	for(Idx = 0; Idx < cMzIdxHashSamples; Idx++)
+		{
+		Hash ^= (uint64_t)(pSeq[((uint64_t)(SeqLen - 1) * Idx) / (cMzIdxHashSamples - 1)] & 0x07);
+		Hash *= 0x0100000001b3;
+		}
+	}
+return(Hash);
+}
+
+int
+CMinimizerIdx::Open(CSfxArray *pSfxArray,		// index sequences in this suffix array, suffix block containing sequences must have been loaded
+				char *pszSfxFile,				// suffix array was loaded from this file, index file is this name with cpszMzIdxFileExtn appended
+				int KMerLen,					// index k-mers of this length
+				int WinLen,						// minimizers sampled over windows of this many k-mers
+				int MaxOccs,					// minimizers occurring more than this many times are not indexed
+				int NumThreads)					// if index file does not exist, or was built with different parameters, then build with this many threads
+{
+int Rslt;
+char szIdxFile[_MAX_PATH];
+
+Reset();
+if(pSfxArray == NULL ||
+	KMerLen < cMinMzIdxKMerLen || KMerLen > cMaxMzIdxKMerLen || WinLen < cMinMzIdxWinLen || WinLen > cMaxMzIdxWinLen || MaxOccs < 1)
+	return(eBSFerrParams);
+
+if((Rslt = InitEntries(pSfxArray)) != eBSFSuccess)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"CMinimizerIdx::Open: unable to initialise index entries");
+	Reset();
+	return(Rslt);
+	}
+
+if(pszSfxFile == NULL || pszSfxFile[0] == '\0')		// in-memory suffix array, index is built but not saved
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Building in-memory minimizer index k=%d w=%d...",KMerLen,WinLen);
+	if((Rslt = Build(KMerLen,WinLen,MaxOccs,NumThreads)) != eBSFSuccess)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"CMinimizerIdx::Open: unable to build minimizer index");
+		Reset();
+		return(Rslt);
+		}
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Built in-memory minimizer index containing %zd minimizers",m_Hdr.NumMinimizers);
+	return(eBSFSuccess);
+	}
+
+#ifdef _WIN32
+struct _stat64 st;
+if(!_stat64(pszSfxFile,&st))
+#else
+struct stat64 st;
+if(!stat64(pszSfxFile,&st))
+#endif
+	{
+	m_SfxFileSize = (int64_t)st.st_size;
+	m_SfxModTime = (int64_t)st.st_mtime;
+	}
+
+snprintf(szIdxFile,sizeof(szIdxFile),"%s%s",pszSfxFile,cpszMzIdxFileExtn);
+if((Rslt = ReadIdx(szIdxFile,KMerLen,WinLen,MaxOccs)) == eBSFSuccess)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Loaded minimizer index '%s' containing %zd k=%d w=%d minimizers",szIdxFile,m_Hdr.NumMinimizers,m_Hdr.KMerLen,m_Hdr.WinLen);
+	return(eBSFSuccess);
+	}
+if(Rslt == eBSFerrMem)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"CMinimizerIdx::Open: unable to allocate memory for minimizer index '%s'",szIdxFile);
+	Reset();
+	return(Rslt);
+	}
+
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Building minimizer index k=%d w=%d...",KMerLen,WinLen);
+if((Rslt = Build(KMerLen,WinLen,MaxOccs,NumThreads)) != eBSFSuccess)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"CMinimizerIdx::Open: unable to build minimizer index");
+	Reset();
+	return(Rslt);
+	}
+
+// failing to save only means the index will need to be rebuilt on next use
+if((Rslt = WriteIdx(szIdxFile)) != eBSFSuccess)
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"Unable to save minimizer index to '%s', index will be rebuilt when next used",szIdxFile);
+else
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Saved minimizer index to '%s'",szIdxFile);
+return(eBSFSuccess);
+}
+
+// WriteIdx
+// File layout is the header, then bucket table, then minimizers
+// Index is written to a process specific temporary file in the same directory which is then renamed, so other processes concurrently
+// loading the index see either the previous or the complete new index, if processes are concurrently building then the last rename wins
+int
+CMinimizerIdx::WriteIdx(char *pszIdxFile)
+{
+int hFile;
+bool bOK;
+char szTmpFile[_MAX_PATH];
+#ifdef _WIN32
+snprintf(szTmpFile,sizeof(szTmpFile),"%s.%d.tmp",pszIdxFile,_getpid());
+hFile = open(szTmpFile,O_CREATETRUNC);
+#else
+snprintf(szTmpFile,sizeof(szTmpFile),"%s.%d.tmp",pszIdxFile,(int)getpid());
+if((hFile = open(szTmpFile,O_CREATETRUNC))!=-1)
+	if(ftruncate(hFile,0)!=0)
+		{
+		close(hFile);
+		remove(szTmpFile);
+		return(eBSFerrCreateFile);
+		}
+#endif
+if(hFile == -1)
+	return(eBSFerrCreateFile);
+
+bOK = CUtility::RetryWrites(hFile,&m_Hdr,sizeof(m_Hdr));
+if(bOK)
+	bOK = CUtility::RetryWrites(hFile,m_pBuckets,sizeof(int64_t) * (((size_t)1 << m_Hdr.BucketBits) + 1));
+if(bOK && m_Hdr.NumMinimizers)
+	bOK = CUtility::RetryWrites(hFile,m_pMinimizers,sizeof(tsMzIdxEntry) * (size_t)m_Hdr.NumMinimizers);
+if(bOK)
+	{
+#ifdef _WIN32
+	_commit(hFile);
+#else
+	fsync(hFile);
+#endif
+	}
+close(hFile);
+if(bOK)
+	{
+#ifdef _WIN32
+	remove(pszIdxFile);			// windows rename() will not replace an existing file
+#endif
+	bOK = rename(szTmpFile,pszIdxFile) == 0;
+	}
+if(!bOK)
+	{
+	remove(szTmpFile);
+	return(eBSFerrFileAccess);
+	}
+return(eBSFSuccess);
+}
+
+// ReadIdx
+// Index is only accepted if built with the requested parameters over the currently loaded suffix array entries
+int
+CMinimizerIdx::ReadIdx(char *pszIdxFile,	// read index from file
+				int KMerLen,				// index must have been built with this k-mer length
+				int WinLen,					// and window length
+				int MaxOccs)				// and maximum occurrences
+{
+int hFile;
+int Rslt;
+uint32_t EntryIdx;
+uint64_t TotSeqsLen;
+int64_t RdLen;
+uint32_t BlockLen;
+uint8_t *pData;
+size_t BucketsSize;
+
+if((hFile = open(pszIdxFile,O_READSEQ)) == -1)
+	return(eBSFerrOpnFile);
+
+if(read(hFile,&m_Hdr,sizeof(m_Hdr)) != sizeof(m_Hdr) || memcmp(m_Hdr.Magic,"mzix",4))
+	{
+	close(hFile);
+	memset(&m_Hdr,0,sizeof(m_Hdr));
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Existing '%s' is not a minimizer index, will be rebuilt",pszIdxFile);
+	return(eBSFerrNotBioseq);
+	}
+
+TotSeqsLen = 0;
+for(EntryIdx = 0; EntryIdx < m_NumEntries; EntryIdx++)
+	TotSeqsLen += m_pEntrySeqLens[EntryIdx];
+if(m_Hdr.Version != cMzIdxVersion || m_Hdr.KMerLen != KMerLen || m_Hdr.WinLen != WinLen || m_Hdr.MaxOccs != MaxOccs ||
+	m_Hdr.NumEntries != m_NumEntries || m_Hdr.TotSeqsLen != TotSeqsLen ||
+	m_Hdr.SfxFileSize != m_SfxFileSize || m_Hdr.SfxModTime != m_SfxModTime || m_Hdr.SeqsHash != SeqsSampleHash() ||
+	m_Hdr.BucketBits < 1 || m_Hdr.BucketBits > min(cMaxMzIdxBucketBits,2 * KMerLen) || m_Hdr.NumMinimizers < 0)
+	{
+	close(hFile);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Existing minimizer index '%s' (k=%d w=%d) was built with different parameters or targets, will be rebuilt",pszIdxFile,m_Hdr.KMerLen,m_Hdr.WinLen);
+	memset(&m_Hdr,0,sizeof(m_Hdr));
+	return(eBSFerrFileVer);
+	}
+
+BucketsSize = sizeof(int64_t) * (((size_t)1 << m_Hdr.BucketBits) + 1);
+if((m_pBuckets = new int64_t [((size_t)1 << m_Hdr.BucketBits) + 1]) == NULL ||
+	(m_pMinimizers = (tsMzIdxEntry *)malloc(sizeof(tsMzIdxEntry) * (size_t)max(m_Hdr.NumMinimizers,(int64_t)1))) == NULL)
+	{
+	close(hFile);
+	return(eBSFerrMem);
+	}
+
+Rslt = eBSFSuccess;
+for(int Part = 0; Rslt == eBSFSuccess && Part < 2; Part++)
+	{
+	if(Part == 0)
+		{
+		pData = (uint8_t *)m_pBuckets;
+		RdLen = (int64_t)BucketsSize;
+		}
+	else
+		{
+		pData = (uint8_t *)m_pMinimizers;
+		RdLen = (int64_t)sizeof(tsMzIdxEntry) * m_Hdr.NumMinimizers;
+		}
+	while(RdLen)
+		{
+		BlockLen = RdLen > (int64_t)(INT_MAX/2) ? (INT_MAX/2) : (uint32_t)RdLen;
+		if((uint32_t)read(hFile,pData,BlockLen) != BlockLen)
+			{
+			Rslt = eBSFerrFileAccess;
+			break;
+			}
+		RdLen -= BlockLen;
+		pData += BlockLen;
+		}
+	}
+close(hFile);
+if(Rslt == eBSFSuccess && m_pBuckets[(size_t)1 << m_Hdr.BucketBits] != m_Hdr.NumMinimizers)
+	Rslt = eBSFerrFileAccess;
+if(Rslt != eBSFSuccess)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Existing minimizer index '%s' is truncated, will be rebuilt",pszIdxFile);
+	delete []m_pBuckets;
+	m_pBuckets = NULL;
+	free(m_pMinimizers);
+	m_pMinimizers = NULL;
+	memset(&m_Hdr,0,sizeof(m_Hdr));
+	return(Rslt);
+	}
+m_KMerMsk = KMerLen == 16 ? 0xffffffff : ((uint32_t)1 << (2 * KMerLen)) - 1;
+m_BucketShf = (2 * KMerLen) - m_Hdr.BucketBits;
+return(eBSFSuccess);
+}
+
+// NumWins
+// Window N contains the k-mers starting at offsets N..N+WinLen-1, sequences with fewer than WinLen k-mers have a single window over all k-mers
+uint32_t
+CMinimizerIdx::NumWins(uint32_t SeqLen)
+{
+uint32_t NumKMers;
+if(SeqLen < (uint32_t)m_Hdr.KMerLen)
+	return(0);
+NumKMers = SeqLen - m_Hdr.KMerLen + 1;
+if(NumKMers < (uint32_t)m_Hdr.WinLen)
+	return(1);
+return(NumKMers - m_Hdr.WinLen + 1);
+}
+
+// Minimizers
+// Each window's minimizer is the leftmost k-mer having the lowest hash in that window, a minimizer is returned for the first window
+// in which it is the minimizer so consecutive windows sharing the same minimizer only return it once
+// Windows are independent so sequences can be processed as multiple segments and the concatenated segment minimizers are the same as if the
+// whole sequence had been processed as a single segment
+uint32_t
+CMinimizerIdx::Minimizers(etSeqBase *pSeq,	// sequence
+					uint32_t SeqLen,		// sequence length
+					uint32_t FirstWin,		// minimizers for windows starting from this window
+					uint32_t EndWin,		// until immediately before this window
+					tsMinimizer *pMinimizers)	// returned minimizers, must be able to hold at least EndWin - FirstWin minimizers
+{
+uint32_t KMerLen;
+uint32_t WinLen;
+uint32_t NumKMers;
+uint32_t StartKMer;
+uint32_t EndKMer;
+uint32_t KMerIdx;
+uint32_t WinIdx;
+uint32_t Idx;
+uint32_t KMer;
+uint32_t ValidLen;
+uint32_t NumMinimizers;
+uint64_t Hash;
+uint64_t MinHash;
+int64_t MinKMer;
+int64_t PrevMinKMer;
+etSeqBase Base;
+uint64_t Hashes[cMaxMzIdxWinLen];
+
+KMerLen = (uint32_t)m_Hdr.KMerLen;
+WinLen = (uint32_t)m_Hdr.WinLen;
+if(EndWin > NumWins(SeqLen))
+	EndWin = NumWins(SeqLen);
+if(FirstWin >= EndWin)
+	return(0);
+NumKMers = SeqLen - KMerLen + 1;
+
+// previous window's minimizer is needed to determine if the first window's minimizer is to be returned
+StartKMer = FirstWin > 0 ? FirstWin - 1 : 0;
+EndKMer = min(EndWin - 1 + WinLen, NumKMers);
+
+KMer = 0;
+ValidLen = 0;
+pSeq += StartKMer;
+for(Idx = 0; Idx < KMerLen - 1; Idx++)
+	{
+	Base = *pSeq++ & 0x07;
+	if(Base > eBaseT)
+		{
+		KMer = 0;
+		ValidLen = 0;
+		}
+	else
+		{
+		KMer = (KMer << 2) | Base;
+		ValidLen += 1;
+		}
+	}
+
+NumMinimizers = 0;
+MinHash = cMzIdxNoHash;
+MinKMer = -1;
+PrevMinKMer = -1;
+for(KMerIdx = StartKMer; KMerIdx < EndKMer; KMerIdx++)
+	{
+	Base = *pSeq++ & 0x07;
+	if(Base > eBaseT)
+		{
+		KMer = 0;
+		ValidLen = 0;
+		}
+	else
+		{
+		KMer = ((KMer << 2) | Base) & m_KMerMsk;
+		ValidLen += 1;
+		}
+	Hash = ValidLen >= KMerLen ? (uint64_t)HashKMer(KMer) : cMzIdxNoHash;
+	Hashes[KMerIdx % WinLen] = Hash;
+	if(Hash < MinHash)
+		{
+		MinHash = Hash;
+		MinKMer = KMerIdx;
+		}
+
+	// window ending with this k-mer complete?
+	if((KMerIdx + 1) < (StartKMer + WinLen) && (KMerIdx + 1) < NumKMers)
+		continue;
+	WinIdx = (KMerIdx + 1) >= WinLen ? (KMerIdx + 1 - WinLen) : 0;
+
+	if(MinKMer < (int64_t)WinIdx)		// previous minimizer no longer in window, rescan window for leftmost lowest
+		{
+		MinHash = cMzIdxNoHash;
+		MinKMer = -1;
+		for(Idx = WinIdx; Idx <= KMerIdx; Idx++)
+			if(Hashes[Idx % WinLen] < MinHash)
+				{
+				MinHash = Hashes[Idx % WinLen];
+				MinKMer = Idx;
+				}
+		}
+
+	if(MinKMer == -1)					// no k-mers in window were free of non-canonical bases
+		{
+		PrevMinKMer = -1;
+		continue;
+		}
+	if(MinKMer != PrevMinKMer && WinIdx >= FirstWin)
+		{
+		pMinimizers[NumMinimizers].Hash = (uint32_t)MinHash;
+		pMinimizers[NumMinimizers++].Ofs = (uint32_t)MinKMer;
+		}
+	PrevMinKMer = MinKMer;
+	}
+return(NumMinimizers);
+}
+
+// RunChunks
+// Process NumItems in chunks of ChunkSize, chunks are processed on the shared work pool unless only a single build worker
+int
+CMinimizerIdx::RunChunks(int64_t NumItems,		// number of items to process
+				int64_t ChunkSize,				// in chunks of this many items
+				WorkPoolFunc pFunc,				// processing function
+				const char *pszProgress)		// progress message
+{
+int Rslt;
+int64_t StartIdx;
+CWorkPool *pWorkPool;
+
+if(NumItems <= 0)
+	return(eBSFSuccess);
+if(m_NumWorkers > 1 && NumItems > ChunkSize && (pWorkPool = CWorkPool::Shared(m_NumWorkers)) != NULL)
+	return(pWorkPool->ParallelFor(NumItems,ChunkSize,pFunc,this,60,pszProgress,NULL,NULL,m_NumWorkers));
+
+for(StartIdx = 0; StartIdx < NumItems; StartIdx += ChunkSize)
+	if((Rslt = pFunc(this,StartIdx,min(StartIdx + ChunkSize,NumItems),0)) < eBSFSuccess)
+		return(Rslt);
+return(eBSFSuccess);
+}
+
+// CountBuckets
+// Count segment minimizers into their buckets
+int
+CMinimizerIdx::CountBuckets(int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+uint32_t NumMinimizers;
+uint32_t Idx;
+tsMzIdxSeg *pSeg;
+tsMinimizer *pMinimizers = m_ppWorkerMinimizers[WorkerIdx];
+
+for(; StartIdx < EndIdx; StartIdx++)
+	{
+	pSeg = &m_pSegs[StartIdx];
+	NumMinimizers = Minimizers(m_ppEntrySeqs[pSeg->EntryID-1],m_pEntrySeqLens[pSeg->EntryID-1],pSeg->FirstWin,pSeg->EndWin,pMinimizers);
+	for(Idx = 0; Idx < NumMinimizers; Idx++)
+#ifdef _WIN32
+		InterlockedIncrement64((volatile LONG64 *)&m_pBucketFill[pMinimizers[Idx].Hash >> m_BucketShf]);
+#else
+		__sync_fetch_and_add(&m_pBucketFill[pMinimizers[Idx].Hash >> m_BucketShf],1);
+#endif
+	}
+return(eBSFSuccess);
+}
+
+// FillBuckets
+// Fill buckets with segment minimizers, order within buckets is arbitrary until buckets are sorted
+int
+CMinimizerIdx::FillBuckets(int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+uint32_t NumMinimizers;
+uint32_t Idx;
+int64_t FillIdx;
+tsMzIdxSeg *pSeg;
+tsMzIdxEntry *pEntry;
+tsMinimizer *pMinimizers = m_ppWorkerMinimizers[WorkerIdx];
+
+for(; StartIdx < EndIdx; StartIdx++)
+	{
+	pSeg = &m_pSegs[StartIdx];
+	NumMinimizers = Minimizers(m_ppEntrySeqs[pSeg->EntryID-1],m_pEntrySeqLens[pSeg->EntryID-1],pSeg->FirstWin,pSeg->EndWin,pMinimizers);
+	for(Idx = 0; Idx < NumMinimizers; Idx++)
+		{
+#ifdef _WIN32
+		FillIdx = InterlockedIncrement64((volatile LONG64 *)&m_pBucketFill[pMinimizers[Idx].Hash >> m_BucketShf]) - 1;
+#else
+		FillIdx = __sync_fetch_and_add(&m_pBucketFill[pMinimizers[Idx].Hash >> m_BucketShf],1);
+#endif
+		pEntry = &m_pMinimizers[FillIdx];
+		pEntry->Hash = pMinimizers[Idx].Hash;
+		pEntry->EntryID = pSeg->EntryID;
+		pEntry->Loci = pMinimizers[Idx].Ofs;
+		}
+	}
+return(eBSFSuccess);
+}
+
+// SortBuckets
+// Sort minimizers within each bucket so index content is independent of the order in which buckets were filled
+int
+CMinimizerIdx::SortBuckets(int64_t StartIdx, int64_t EndIdx)
+{
+int64_t NumEls;
+for(; StartIdx < EndIdx; StartIdx++)
+	if((NumEls = m_pBuckets[StartIdx+1] - m_pBuckets[StartIdx]) > 1)
+		qsort(&m_pMinimizers[m_pBuckets[StartIdx]],(size_t)NumEls,sizeof(tsMzIdxEntry),SortMzIdxEntries);
+return(eBSFSuccess);
+}
+
+// Build
+// Counting sort of minimizers into hash buckets, entry sequences are processed as segments so work is balanced over threads
+// regardless of the distribution of entry sequence lengths
+int
+CMinimizerIdx::Build(int KMerLen,			// index k-mers of this length
+				int WinLen,					// minimizers sampled over windows of this many k-mers
+				int MaxOccs,				// minimizers occurring more than this many times are not indexed
+				int NumThreads)				// use at most this many threads
+{
+int Rslt;
+uint32_t EntryIdx;
+uint32_t EntryWins;
+uint32_t FirstWin;
+uint64_t TotSeqsLen;
+int64_t EstMinimizers;
+int64_t NumBuckets;
+int64_t BucketIdx;
+int64_t Cnt;
+int64_t TotMinimizers;
+int64_t SrcIdx;
+int64_t RunEnd;
+int64_t DstIdx;
+int64_t NumOverOccs;
+int WorkerIdx;
+CWorkPool *pWorkPool;
+
+memcpy(m_Hdr.Magic,"mzix",4);
+m_Hdr.Version = cMzIdxVersion;
+m_Hdr.KMerLen = KMerLen;
+m_Hdr.WinLen = WinLen;
+m_Hdr.MaxOccs = MaxOccs;
+m_Hdr.NumEntries = m_NumEntries;
+m_KMerMsk = KMerLen == 16 ? 0xffffffff : ((uint32_t)1 << (2 * KMerLen)) - 1;
+
+// segment entries
+TotSeqsLen = 0;
+m_NumSegs = 0;
+for(EntryIdx = 0; EntryIdx < m_NumEntries; EntryIdx++)
+	{
+	TotSeqsLen += m_pEntrySeqLens[EntryIdx];
+	EntryWins = NumWins(m_pEntrySeqLens[EntryIdx]);
+	m_NumSegs += (EntryWins + cMzIdxBuildSegWins - 1) / cMzIdxBuildSegWins;
+	}
+m_Hdr.TotSeqsLen = TotSeqsLen;
+m_Hdr.SfxFileSize = m_SfxFileSize;
+m_Hdr.SfxModTime = m_SfxModTime;
+m_Hdr.SeqsHash = SeqsSampleHash();
+
+// on average there will be 2/(WinLen+1) minimizers per k-mer, size bucket table so there are a few minimizers per bucket
+EstMinimizers = (int64_t)((TotSeqsLen * 2) / (WinLen + 1));
+m_Hdr.BucketBits = 10;
+while(m_Hdr.BucketBits < min(cMaxMzIdxBucketBits,2 * KMerLen) && ((int64_t)1 << m_Hdr.BucketBits) < EstMinimizers)
+	m_Hdr.BucketBits += 1;
+m_BucketShf = (2 * KMerLen) - m_Hdr.BucketBits;
+NumBuckets = (int64_t)1 << m_Hdr.BucketBits;
+
+if((m_pSegs = new tsMzIdxSeg [max(m_NumSegs,(int64_t)1)]) == NULL)
+	return(eBSFerrMem);
+m_NumSegs = 0;
+for(EntryIdx = 0; EntryIdx < m_NumEntries; EntryIdx++)
+	{
+	EntryWins = NumWins(m_pEntrySeqLens[EntryIdx]);
+	for(FirstWin = 0; FirstWin < EntryWins; FirstWin += cMzIdxBuildSegWins)
+		{
+		m_pSegs[m_NumSegs].EntryID = EntryIdx + 1;
+		m_pSegs[m_NumSegs].FirstWin = FirstWin;
+		m_pSegs[m_NumSegs++].EndWin = EntryWins - FirstWin > cMzIdxBuildSegWins ? FirstWin + cMzIdxBuildSegWins : EntryWins;
+		}
+	}
+
+m_NumWorkers = 1;
+if(NumThreads > 1 && m_NumSegs > 1 && (pWorkPool = CWorkPool::Shared(NumThreads)) != NULL)
+	m_NumWorkers = pWorkPool->JobWorkers(NumThreads);
+if((m_ppWorkerMinimizers = new tsMinimizer *[m_NumWorkers]) == NULL)
+	{
+	ResetBuild();
+	return(eBSFerrMem);
+	}
+memset(m_ppWorkerMinimizers,0,sizeof(tsMinimizer *) * m_NumWorkers);
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+	if((m_ppWorkerMinimizers[WorkerIdx] = new tsMinimizer [cMzIdxBuildSegWins]) == NULL)
+		{
+		ResetBuild();
+		return(eBSFerrMem);
+		}
+
+if((m_pBucketFill = new int64_t [NumBuckets + 1]) == NULL ||
+	(m_pBuckets = new int64_t [NumBuckets + 1]) == NULL)
+	{
+	ResetBuild();
+	return(eBSFerrMem);
+	}
+memset((void *)m_pBucketFill,0,sizeof(int64_t) * (NumBuckets + 1));
+
+if((Rslt = RunChunks(m_NumSegs,1,MzIdxCountBuckets,"Progress: counting minimizers")) < eBSFSuccess)
+	{
+	ResetBuild();
+	return(Rslt);
+	}
+
+TotMinimizers = 0;
+for(BucketIdx = 0; BucketIdx < NumBuckets; BucketIdx++)
+	{
+	Cnt = m_pBucketFill[BucketIdx];
+	m_pBuckets[BucketIdx] = TotMinimizers;
+	m_pBucketFill[BucketIdx] = TotMinimizers;
+	TotMinimizers += Cnt;
+	}
+m_pBuckets[NumBuckets] = TotMinimizers;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Minimizer index: %zd minimizers sampled from %zd bases over %u sequences",TotMinimizers,(int64_t)TotSeqsLen,m_NumEntries);
+
+if((m_pMinimizers = (tsMzIdxEntry *)malloc(sizeof(tsMzIdxEntry) * (size_t)max(TotMinimizers,(int64_t)1))) == NULL)
+	{
+	ResetBuild();
+	return(eBSFerrMem);
+	}
+if((Rslt = RunChunks(m_NumSegs,1,MzIdxFillBuckets,"Progress: filling minimizer buckets")) < eBSFSuccess)
+	{
+	ResetBuild();
+	return(Rslt);
+	}
+ResetBuild();
+
+m_NumWorkers = 1;
+if(NumThreads > 1 && (pWorkPool = CWorkPool::Shared(NumThreads)) != NULL)
+	m_NumWorkers = pWorkPool->JobWorkers(NumThreads);
+Rslt = RunChunks(NumBuckets,max((int64_t)1,NumBuckets / ((int64_t)m_NumWorkers * cWorkPoolChunksPerThread)),MzIdxSortBuckets,"Progress: sorting minimizer buckets");
+m_NumWorkers = 0;
+if(Rslt < eBSFSuccess)
+	return(Rslt);
+
+// remove over occurring minimizers, these would only contribute hits which can't be distinguished from repeats
+DstIdx = 0;
+NumOverOccs = 0;
+for(BucketIdx = 0; BucketIdx < NumBuckets; BucketIdx++)
+	{
+	SrcIdx = m_pBuckets[BucketIdx];
+	m_pBuckets[BucketIdx] = DstIdx;
+	for(; SrcIdx < m_pBuckets[BucketIdx+1]; SrcIdx = RunEnd)
+		{
+		for(RunEnd = SrcIdx + 1; RunEnd < m_pBuckets[BucketIdx+1] && m_pMinimizers[RunEnd].Hash == m_pMinimizers[SrcIdx].Hash; RunEnd++);
+		if(RunEnd - SrcIdx > MaxOccs)
+			{
+			NumOverOccs += 1;
+			continue;
+			}
+		if(DstIdx != SrcIdx)
+			memmove(&m_pMinimizers[DstIdx],&m_pMinimizers[SrcIdx],sizeof(tsMzIdxEntry) * (size_t)(RunEnd - SrcIdx));
+		DstIdx += RunEnd - SrcIdx;
+		}
+	}
+m_pBuckets[NumBuckets] = DstIdx;
+m_Hdr.NumMinimizers = DstIdx;
+if(DstIdx < TotMinimizers && DstIdx > 0)
+	{
+	tsMzIdxEntry *pRealloc;
+	if((pRealloc = (tsMzIdxEntry *)realloc(m_pMinimizers,sizeof(tsMzIdxEntry) * (size_t)DstIdx)) != NULL)
+		m_pMinimizers = pRealloc;
+	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Minimizer index: %zd minimizers retained, %zd distinct minimizers occurring more than %d times removed",DstIdx,NumOverOccs,MaxOccs);
+return(eBSFSuccess);
+}
+
+// ExtendFlank
+// Flanks are extended as when extending suffix array cores: mismatches are heavily penalised down to a floor, and the extension
+// accepted is that with the highest score whilst the mismatch rate over the extended run is no more than 15%
+uint32_t
+CMinimizerIdx::ExtendFlank(etSeqBase *pProbe,	// extend from this probe base, outwards from an aligned run
+				etSeqBase *pTarg,			// and this target base
+				uint32_t MaxExtn,			// extend for at most this many bases
+				int Dirn,					// 1 if extending 3', -1 if extending 5'
+				uint32_t RunLen,			// run being extended is this length
+				int BaseMatchPts,			// award this many points for matching bases
+				int BaseMismatchPts,		// penalise this many points for mismatching bases
+				uint32_t *pNumMMs)			// returned number of mismatches in accepted extension
+{
+int ExtnScore;
+int ExtnFloor;
+int HiScore;
+uint32_t HiScoreExtnLen;
+uint32_t HiScoreMMs;
+uint32_t ExtnLen;
+uint32_t NumMMs;
+etSeqBase ProbeBase;
+etSeqBase TargBase;
+
+ExtnScore = RunLen * BaseMatchPts;
+ExtnFloor = ExtnScore - (4 * BaseMatchPts);	// when floor is reached then at least 4 exact matches required to recover back to a potential new high scoring extension
+HiScore = ExtnScore;
+HiScoreExtnLen = 0;
+HiScoreMMs = 0;
+NumMMs = 0;
+for(ExtnLen = 0; ExtnLen < MaxExtn; pProbe += Dirn, pTarg += Dirn)
+	{
+	ProbeBase = *pProbe & 0x07;
+	TargBase = *pTarg & 0x07;
+	if(TargBase > eBaseN || ProbeBase > eBaseN)		// mustn't match inter targ or probe sequences
+		break;
+	if(TargBase == eBaseN || ProbeBase == eBaseN || ProbeBase != TargBase)
+		{
+		if(ExtnScore > ExtnFloor)
+			ExtnScore -= BaseMismatchPts;
+		if(ExtnScore < ExtnFloor)
+			ExtnScore = ExtnFloor;
+		NumMMs += 1;
+		}
+	else
+		ExtnScore += BaseMatchPts;
+	ExtnLen += 1;
+	if(ExtnScore >= HiScore && ((NumMMs * 100) / (ExtnLen + RunLen)) <= 15)
+		{
+		HiScore = ExtnScore;
+		HiScoreExtnLen = ExtnLen;
+		HiScoreMMs = NumMMs;
+		ExtnFloor = HiScore - (4 * BaseMatchPts);
+		}
+	}
+*pNumMMs = HiScoreMMs;
+return(HiScoreExtnLen);
+}
+
+// GatherHits
+// Hits for all query minimizers are gathered in a single batch so they can be sorted into diagonal runs
+int
+CMinimizerIdx::GatherHits(uint32_t NumMinimizers,	// gather target hits for this many query minimizers
+					uint32_t MaxOccs,			// skipping minimizers occurring more than this many times
+					tsMzIdxScratch *pScratch)	// query minimizers and returned hits
+{
+uint32_t Idx;
+uint32_t Hash;
+int64_t BucketEnd;
+int64_t Lo;
+int64_t Hi;
+int64_t Mid;
+int64_t Cnt;
+uint32_t NumHits;
+uint32_t AllocHits;
+tsMinimizer *pMinimizer;
+tsMzIdxEntry *pEntry;
+tsMzIdxHit *pHit;
+tsMzIdxHit *pRealloc;
+
+NumHits = 0;
+pMinimizer = pScratch->pMinimizers;
+for(Idx = 0; Idx < NumMinimizers; Idx++, pMinimizer++)
+	{
+	Hash = pMinimizer->Hash;
+	Lo = m_pBuckets[Hash >> m_BucketShf];
+	BucketEnd = Hi = m_pBuckets[(Hash >> m_BucketShf) + 1];
+	while(Lo < Hi)
+		{
+		Mid = (Lo + Hi) / 2;
+		if(m_pMinimizers[Mid].Hash < Hash)
+			Lo = Mid + 1;
+		else
+			Hi = Mid;
+		}
+	for(Hi = Lo; Hi < BucketEnd && m_pMinimizers[Hi].Hash == Hash; Hi++);
+	if((Cnt = Hi - Lo) == 0 || Cnt > (int64_t)MaxOccs)
+		continue;
+
+	if((NumHits + Cnt) > pScratch->AllocdHits)
+		{
+		AllocHits = pScratch->AllocdHits + (uint32_t)max(Cnt,(int64_t)cAllocMzIdxScratch);
+		if((pRealloc = (tsMzIdxHit *)realloc(pScratch->pHits,sizeof(tsMzIdxHit) * AllocHits)) == NULL)
+			return(eBSFerrMem);
+		pScratch->pHits = pRealloc;
+		pScratch->AllocdHits = AllocHits;
+		}
+	pHit = &pScratch->pHits[NumHits];
+	for(pEntry = &m_pMinimizers[Lo]; Cnt--; pEntry++, pHit++)
+		{
+		pHit->TargSeqID = pEntry->EntryID;
+		pHit->Diag = (int64_t)pEntry->Loci - pMinimizer->Ofs;
+		pHit->QueryOfs = pMinimizer->Ofs;
+		NumHits += 1;
+		}
+	}
+return((int)NumHits);
+}
+
+// LocateQuerySeqs
+// Alternative to CSfxArray::LocateQuerySeqs() returning alignment nodes for all hits of the query onto targets
+// All query minimizers are located in a single batch, hits are then sorted by target and diagonal and combined into runs of hits
+// on the same diagonal, runs are then 5' and 3' flank extended as for suffix array cores
+int
+CMinimizerIdx::LocateQuerySeqs(uint32_t QuerySeqID,	// identifies this query sequence
+				etSeqBase *pProbeSeq,			// probe
+				uint32_t ProbeLen,				// probe length
+				uint32_t MinAlignLen,			// accept runs extended to at least this length
+				eALStrand Align2Strand,			// align to this strand
+				uint32_t MaxOccs,				// skip minimizers occurring more than this many times
+				uint32_t MaxHits,				// return at most this number of alignment nodes
+				tsQueryAlignNodes *pHits,		// where to return alignment nodes
+				int BaseMatchPts,				// award this many points for matching bases when extending 5' and 3' flanks
+				int BaseMismatchPts,			// penalise this many points for mismatching bases when extending 5' and 3' flanks
+				tsMzIdxScratch *pScratch)		// calling thread's working memory
+{
+int Rslt;
+uint32_t KMerLen;
+uint32_t QueryWins;
+uint32_t NumMinimizers;
+uint32_t NumMzHits;
+uint32_t HitIdx;
+uint32_t NumNodes;
+uint32_t RunQStart;
+uint32_t RunQEnd;
+uint32_t RunMMs;
+uint32_t GapMMs;
+uint32_t Ofs;
+uint32_t TargStart;
+uint32_t TargEnd;
+uint32_t TargLen;
+uint32_t Flank5Len;
+uint32_t Flank3Len;
+uint32_t Flank5MMs;
+uint32_t Flank3MMs;
+uint32_t CovTargSeqID;
+int64_t CovDiag;
+uint32_t CovQueryEnd;
+char CurStrand;
+etSeqBase ProbeBase;
+etSeqBase TargBase;
+etSeqBase *pTargSeq;
+tsMzIdxHit *pRunHit;
+tsMzIdxHit *pHit;
+tsQueryAlignNodes *pCurHit;
+tsMinimizer *pRealloc;
+
+if(m_pMinimizers == NULL || pScratch == NULL || pHits == NULL || MaxHits == 0)
+	return(eBSFerrInternal);
+KMerLen = (uint32_t)m_Hdr.KMerLen;
+if((QueryWins = NumWins(ProbeLen)) == 0)
+	return(0);
+if(QueryWins > pScratch->AllocdMinimizers)
+	{
+	if((pRealloc = (tsMinimizer *)realloc(pScratch->pMinimizers,sizeof(tsMinimizer) * (QueryWins + cAllocMzIdxScratch))) == NULL)
+		return(eBSFerrMem);
+	pScratch->pMinimizers = pRealloc;
+	pScratch->AllocdMinimizers = QueryWins + cAllocMzIdxScratch;
+	}
+
+NumNodes = 0;
+Rslt = 0;
+if(Align2Strand == eALSCrick)
+	{
+	CSeqTrans::ReverseComplement(ProbeLen, pProbeSeq);
+	CurStrand = '-';
+	}
+else
+	CurStrand = '+';
+
+do
+	{
+	NumMinimizers = Minimizers(pProbeSeq,ProbeLen,0,QueryWins,pScratch->pMinimizers);
+	CRunProfile::Count(eRPCSeedsTried,NumMinimizers);
+	if((Rslt = GatherHits(NumMinimizers,MaxOccs,pScratch)) < 0)
+		break;
+	NumMzHits = (uint32_t)Rslt;
+	if(NumMzHits > 1)
+		qsort(pScratch->pHits,NumMzHits,sizeof(tsMzIdxHit),SortMzIdxHits);
+
+	CovTargSeqID = 0;
+	CovDiag = 0;
+	CovQueryEnd = 0;
+	for(HitIdx = 0; HitIdx < NumMzHits && NumNodes < MaxHits;)
+		{
+		pRunHit = &pScratch->pHits[HitIdx++];
+		if(pRunHit->TargSeqID != CovTargSeqID || pRunHit->Diag != CovDiag)
+			{
+			CovTargSeqID = pRunHit->TargSeqID;
+			CovDiag = pRunHit->Diag;
+			CovQueryEnd = 0;
+			}
+		if(pRunHit->QueryOfs < CovQueryEnd)		// already covered by an extended run on this diagonal
+			continue;
+
+		pTargSeq = m_ppEntrySeqs[pRunHit->TargSeqID - 1];
+		TargLen = m_pEntrySeqLens[pRunHit->TargSeqID - 1];
+		RunQStart = pRunHit->QueryOfs;
+		RunQEnd = RunQStart + KMerLen;
+		RunMMs = 0;
+
+		// combine following hits on same diagonal into this run whilst the gaps between hits are not too long or too divergent
+		for(; HitIdx < NumMzHits; HitIdx++)
+			{
+			pHit = &pScratch->pHits[HitIdx];
+			if(pHit->TargSeqID != pRunHit->TargSeqID || pHit->Diag != pRunHit->Diag)
+				break;
+			if(pHit->QueryOfs < RunQEnd)
+				{
+				if((pHit->QueryOfs + KMerLen) > RunQEnd)
+					RunQEnd = pHit->QueryOfs + KMerLen;
+				continue;
+				}
+			if(pHit->QueryOfs > (RunQEnd + cMzIdxMaxRunGap))
+				break;
+			GapMMs = 0;
+			for(Ofs = RunQEnd; Ofs < pHit->QueryOfs; Ofs++)
+				{
+				ProbeBase = pProbeSeq[Ofs] & 0x07;
+				TargBase = pTargSeq[(int64_t)Ofs + pHit->Diag] & 0x07;
+				if(TargBase >= eBaseN || ProbeBase >= eBaseN || ProbeBase != TargBase)
+					GapMMs += 1;
+				}
+			if(((RunMMs + GapMMs) * 100) / (pHit->QueryOfs + KMerLen - RunQStart) > 15)
+				break;
+			RunMMs += GapMMs;
+			RunQEnd = pHit->QueryOfs + KMerLen;
+			}
+
+		TargStart = (uint32_t)(pRunHit->Diag + RunQStart);
+		TargEnd = (uint32_t)(pRunHit->Diag + RunQEnd);
+		Flank5Len = Flank5MMs = 0;
+		if(RunQStart > 0 && TargStart > 0)
+			Flank5Len = ExtendFlank(&pProbeSeq[RunQStart - 1],&pTargSeq[TargStart - 1],min(RunQStart,TargStart),-1,RunQEnd - RunQStart,BaseMatchPts,BaseMismatchPts,&Flank5MMs);
+		Flank3Len = Flank3MMs = 0;
+		if(RunQEnd < ProbeLen && TargEnd < TargLen)
+			Flank3Len = ExtendFlank(&pProbeSeq[RunQEnd],&pTargSeq[TargEnd],min(ProbeLen - RunQEnd,TargLen - TargEnd),1,RunQEnd - RunQStart,BaseMatchPts,BaseMismatchPts,&Flank3MMs);
+		CovQueryEnd = RunQEnd + Flank3Len;
+
+		if((Flank5Len + (RunQEnd - RunQStart) + Flank3Len) < MinAlignLen)
+			continue;
+
+		pCurHit = &pHits[NumNodes];
+		pCurHit->AlignNodeID = NumNodes;
+		pCurHit->QueryID = QuerySeqID;
+		pCurHit->QueryStartOfs = RunQStart - Flank5Len;
+		pCurHit->TargSeqLoci = TargStart - Flank5Len;
+		pCurHit->AlignLen = Flank5Len + (RunQEnd - RunQStart) + Flank3Len;
+		pCurHit->NumMismatches = Flank5MMs + RunMMs + Flank3MMs;
+		pCurHit->FlgStrand = CurStrand == '+' ? 0 : 1;
+		pCurHit->TargSeqID = pRunHit->TargSeqID;
+		pCurHit->Flg2Rpt = 0;
+		pCurHit->FlgFirst2tRpt = 0;
+		pCurHit->FlgScored = 0;
+		pCurHit->FlgRedundant = 0;
+		pCurHit->HiScorePathNextIdx = 0;
+		pCurHit->HiScore = 0;
+		pCurHit->NxtHashMatch = 0;
+		NumNodes += 1;
+		}
+
+	if(CurStrand == '+' && Align2Strand == eALSboth && NumNodes < MaxHits)	// if just processed watson '+' strand then will need to process crick or '-' strand if processing both strands
+		{
+		CSeqTrans::ReverseComplement(ProbeLen, pProbeSeq);
+		CurStrand = '-';
+		Align2Strand = eALSCrick;
+		}
+	else
+		Align2Strand = eALSnone;
+	}
+while(Align2Strand != eALSnone);
+
+if(CurStrand == '-')									// restore probe sequence if had started processing '-' strand
+	CSeqTrans::ReverseComplement(ProbeLen, pProbeSeq);
+if(Rslt < 0)
+	return(Rslt);
+return((int)NumNodes);
+}
+
+// LocateCandidates
+// Minimizer sketch shortlisting of targets likely to overlap the probe, used to avoid the cost of exploring all suffix array cores onto targets
+// which only share repetitive or chance k-mers with the probe
+// Query minimizer hits are sorted by target and diagonal, then for each target a window of DiagBand diagonals is slid along the sorted
+// hits and the maximum number of hits within any window is that target's shared count. Allowing a band, rather than requiring exactly the
+// same diagonal, is needed as indels (PacBio) progressively shift the diagonal along an overlap
+int
+CMinimizerIdx::LocateCandidates(etSeqBase *pProbeSeq,	// probe, only the sense strand is processed
+				uint32_t ProbeLen,				// probe length
+				uint32_t SloughSeqID,			// if > 0 then hits onto this target sequence (normally the probe itself) are sloughed
+				uint32_t MinTargLen,			// candidate targets must be at least this length
+				uint32_t MaxTargLen,			// if > 0 then candidate targets must be no longer than this length
+				uint32_t MaxOccs,				// skip minimizers occurring more than this many times
+				uint32_t DiagBand,				// minimizer hits are diagonally consistent if within a band of this many diagonals
+				uint32_t MinShared,				// candidates must have at least this many diagonally consistent minimizer hits
+				uint32_t MaxCands,				// return at most this many candidates
+				tsMzIdxScratch *pScratch)		// calling thread's working memory
+{
+int Rslt;
+uint32_t QueryWins;
+uint32_t NumMinimizers;
+uint32_t NumMzHits;
+uint32_t TargStartIdx;
+uint32_t TargEndIdx;
+uint32_t LoIdx;
+uint32_t HiIdx;
+uint32_t NumShared;
+uint32_t BestShared;
+int64_t BestDiag;
+uint32_t TargSeqID;
+uint32_t TargLen;
+uint32_t NumCands;
+uint32_t AllocCands;
+tsMzIdxHit *pHits;
+tsMzIdxCand *pCand;
+tsMinimizer *pRealloc;
+tsMzIdxCand *pReallocCands;
+
+if(m_pMinimizers == NULL || pScratch == NULL || pProbeSeq == NULL || MaxCands == 0)
+	return(eBSFerrInternal);
+if(MinShared < 1)
+	MinShared = 1;
+if((QueryWins = NumWins(ProbeLen)) == 0)
+	return(0);
+if(QueryWins > pScratch->AllocdMinimizers)
+	{
+	if((pRealloc = (tsMinimizer *)realloc(pScratch->pMinimizers,sizeof(tsMinimizer) * (QueryWins + cAllocMzIdxScratch))) == NULL)
+		return(eBSFerrMem);
+	pScratch->pMinimizers = pRealloc;
+	pScratch->AllocdMinimizers = QueryWins + cAllocMzIdxScratch;
+	}
+
+NumMinimizers = Minimizers(pProbeSeq,ProbeLen,0,QueryWins,pScratch->pMinimizers);
+CRunProfile::Count(eRPCSeedsTried,NumMinimizers);
+if((Rslt = GatherHits(NumMinimizers,MaxOccs,pScratch)) < 0)
+	return(Rslt);
+if((NumMzHits = (uint32_t)Rslt) < MinShared)
+	return(0);
+pHits = pScratch->pHits;
+qsort(pHits,NumMzHits,sizeof(tsMzIdxHit),SortMzIdxHits);
+
+NumCands = 0;
+for(TargStartIdx = 0; TargStartIdx < NumMzHits; TargStartIdx = TargEndIdx)
+	{
+	TargSeqID = pHits[TargStartIdx].TargSeqID;
+	for(TargEndIdx = TargStartIdx + 1; TargEndIdx < NumMzHits && pHits[TargEndIdx].TargSeqID == TargSeqID; TargEndIdx++);
+	if((TargEndIdx - TargStartIdx) < MinShared || TargSeqID == SloughSeqID)
+		continue;
+	TargLen = m_pEntrySeqLens[TargSeqID - 1];
+	if(TargLen < MinTargLen || (MaxTargLen > 0 && TargLen > MaxTargLen))
+		continue;
+
+	BestShared = 0;
+	BestDiag = 0;
+	LoIdx = TargStartIdx;
+	for(HiIdx = TargStartIdx; HiIdx < TargEndIdx; HiIdx++)
+		{
+		while((pHits[HiIdx].Diag - pHits[LoIdx].Diag) > (int64_t)DiagBand)
+			LoIdx += 1;
+		if((NumShared = HiIdx - LoIdx + 1) > BestShared)
+			{
+			BestShared = NumShared;
+			BestDiag = (pHits[LoIdx].Diag + pHits[HiIdx].Diag) / 2;
+			}
+		}
+	if(BestShared < MinShared)
+		continue;
+
+	if(NumCands == pScratch->AllocdCands)
+		{
+		AllocCands = pScratch->AllocdCands + cAllocMzIdxCands;
+		if((pReallocCands = (tsMzIdxCand *)realloc(pScratch->pCands,sizeof(tsMzIdxCand) * AllocCands)) == NULL)
+			return(eBSFerrMem);
+		pScratch->pCands = pReallocCands;
+		pScratch->AllocdCands = AllocCands;
+		}
+	pCand = &pScratch->pCands[NumCands++];
+	pCand->TargSeqID = TargSeqID;
+	pCand->NumShared = BestShared;
+	pCand->Diag = BestDiag;
+	}
+
+if(NumCands > 1)
+	qsort(pScratch->pCands,NumCands,sizeof(tsMzIdxCand),SortMzIdxCands);
+return((int)min(NumCands,MaxCands));
+}
@@ -0,0 +1,207 @@
+#pragma once
+// Sampled k-mer index over the sequences in a loaded CSfxArray suffix block, used as an alternative to suffix array core seeding by CBlitz
+// Only (w,k) minimizers are indexed: for every window of w consecutive k-mers the k-mer with the lowest hash is sampled, so identical
+// subsequences of at least w+k-1 bases in target and query are guaranteed to share a sampled k-mer
+// K-mers are hashed with an invertible hash so equal hashes are equal k-mers, indexed k-mers are held in hash order and located through a
+// bucket table on the hash high bits; lookups are then a short scan within a single bucket rather than a binary search over the suffix array
+// The index is saved to, and subsequently loaded from, a file next to the suffix array file (cpszMzIdxFileExtn appended), or if there is
+// no suffix array file (in-memory suffix arrays) then the index is built in memory only
+// A saved index is only reused if the suffix array file size and modification time, and a hash over sampled target bases, are unchanged
+// Saved indexes are written to a temporary file which is then renamed, so concurrent processes never load a partially written index
+// Index can alternatively be used as a sketch, shortlisting those targets sharing most query minimizers on a consistent diagonal band
+// Once built or loaded the index is read only and can be shared by any number of query threads, each thread providing it's own tsMzIdxScratch
+
+const char cpszMzIdxFileExtn[] = ".mzi";		// index file name is the suffix array file name with this extension appended
+const uint32_t cMzIdxVersion = 2;				// current index file version, version 2 added the suffix array file fingerprint
+const int cMinMzIdxKMerLen = 8;					// minimum indexed k-mer length
+const int cMaxMzIdxKMerLen = 16;				// maximum indexed k-mer length, k-mers are packed 2 bits per base into 32bits
+const int cMinMzIdxWinLen = 1;					// minimum window, in k-mers, over which minimizers are sampled (1 indexes every k-mer)
+const int cMaxMzIdxWinLen = 50;					// maximum window, in k-mers, over which minimizers are sampled
+const int cMaxMzIdxBucketBits = 24;				// bucket table is indexed by at most this many hash high bits
+const int cDfltMzIdxMaxOccs = 20000;			// minimizers occurring more than this many times over all targets are not indexed
+const int cMzIdxMaxRunGap = 100;				// hits on same diagonal separated by at most this many query bases are combined into a single run
+const int cAllocMzIdxScratch = 100000;			// scratch minimizers and hits are allocated in these increments
+const int cAllocMzIdxCands = 10000;				// scratch candidate targets are allocated in these increments
+const uint32_t cMzIdxBuildSegWins = 0x100000;	// index build processes entry sequences in segments of at most this many minimizer windows
+const int cMzIdxHashSamples = 64;				// fingerprint hashes this many evenly spaced bases from each target sequence
+
+#pragma pack(4)
+typedef struct TAG_sMzIdxHdr {
+	uint8_t Magic[4];							// always 'm','z','i','x'
+	uint32_t Version;							// file version, cMzIdxVersion
+	int32_t KMerLen;							// indexed k-mer length
+	int32_t WinLen;								// minimizers sampled over windows of this many k-mers
+	int32_t MaxOccs;							// minimizers occurring more than this many times were not indexed
+	int32_t BucketBits;							// bucket table is indexed by this many hash high bits
+	uint32_t NumEntries;						// number of suffix array entries at time of index build
+	uint64_t TotSeqsLen;						// total length of suffix array entry sequences at time of index build
+	int64_t SfxFileSize;						// suffix array file size at time of index build
+	int64_t SfxModTime;							// suffix array file modification time at time of index build
+	uint64_t SeqsHash;							// hash over sampled entry sequence bases at time of index build
+	int64_t NumMinimizers;						// number of indexed minimizers
+	} tsMzIdxHdr;
+
+typedef struct TAG_sMzIdxEntry {
+	uint32_t Hash;								// minimizer k-mer hash
+	uint32_t EntryID;							// minimizer is in this suffix array entry
+	uint32_t Loci;								// starting at this offset
+	} tsMzIdxEntry;
+
+typedef struct TAG_sMinimizer {
+	uint32_t Hash;								// minimizer k-mer hash
+	uint32_t Ofs;								// starting at this sequence offset
+	} tsMinimizer;
+
+typedef struct TAG_sMzIdxHit {
+	uint32_t TargSeqID;							// query minimizer hit this target sequence
+	int64_t Diag;								// on this diagonal (target loci - query offset)
+	uint32_t QueryOfs;							// at this query offset
+	} tsMzIdxHit;
+
+typedef struct TAG_sMzIdxCand {
+	uint32_t TargSeqID;							// candidate target sequence
+	uint32_t NumShared;							// sharing this many query minimizer hits within a single diagonal band
+	int64_t Diag;								// band was centred on this diagonal (target loci - query offset)
+	} tsMzIdxCand;
+
+typedef struct TAG_sMzIdxSeg {
+	uint32_t EntryID;							// segment is in this entry
+	uint32_t FirstWin;							// and starts with this window
+	uint32_t EndWin;							// ending immediately before this window
+	} tsMzIdxSeg;
+
+typedef struct TAG_sMzIdxScratch {				// per query thread working memory
+	uint32_t AllocdMinimizers;					// pMinimizers allocated to hold this many minimizers
+	tsMinimizer *pMinimizers;					// query sequence minimizers
+	uint32_t AllocdHits;						// pHits allocated to hold this many hits
+	tsMzIdxHit *pHits;							// hits of query minimizers onto targets
+	uint32_t AllocdCands;						// pCands allocated to hold this many candidates
+	tsMzIdxCand *pCands;						// candidate targets returned by LocateCandidates()
+	} tsMzIdxScratch;
+#pragma pack()
+
+class CMinimizerIdx
+{
+	CSfxArray *m_pSfxArray;						// index is over the sequences in this suffix array
+	uint32_t m_NumEntries;						// number of suffix array entries
+	etSeqBase **m_ppEntrySeqs;					// ptrs to each entry sequence in the loaded suffix block
+	uint32_t *m_pEntrySeqLens;					// length of each entry sequence
+	int64_t m_SfxFileSize;						// suffix array file size, 0 if in-memory suffix array
+	int64_t m_SfxModTime;						// suffix array file modification time, 0 if in-memory suffix array
+
+	tsMzIdxHdr m_Hdr;							// index header
+	uint32_t m_KMerMsk;							// k-mers and their hashes are masked to 2 * KMerLen bits
+	int m_BucketShf;							// hash right shift giving bucket
+	int64_t *m_pBuckets;						// bucket table, minimizers for bucket N are at m_pMinimizers[m_pBuckets[N]] up to m_pMinimizers[m_pBuckets[N+1]]
+	tsMzIdxEntry *m_pMinimizers;				// indexed minimizers, ordered by hash then entry and loci
+
+	int64_t m_NumSegs;							// build: number of entry segments
+	tsMzIdxSeg *m_pSegs;						// build: entry segments
+	int m_NumWorkers;							// build: number of workers
+	tsMinimizer **m_ppWorkerMinimizers;			// build: per worker segment minimizers, each allocated to hold cMzIdxBuildSegWins
+	volatile int64_t *m_pBucketFill;			// build: count of minimizers in each bucket, then next fill offset for each bucket
+
+	void ResetBuild(void);						// release build working memory
+	int RunChunks(int64_t NumItems,				// process NumItems on work pool, or on calling thread if only single chunk or single thread
+				int64_t ChunkSize,				// in chunks of this many items
+				WorkPoolFunc pFunc,				// processing function
+				const char *pszProgress);		// progress message
+
+	int InitEntries(CSfxArray *pSfxArray);		// initialise entry sequence ptrs and lengths
+	uint64_t SeqsSampleHash(void);				// returns hash over entry lengths and sampled entry sequence bases
+	int WriteIdx(char *pszIdxFile);				// write index to file
+	int ReadIdx(char *pszIdxFile,				// read index from file
+				int KMerLen,					// index must have been built with this k-mer length
+				int WinLen,						// and window length
+				int MaxOccs);					// and maximum occurrences
+
+	int Build(int KMerLen,						// index k-mers of this length
+				int WinLen,						// minimizers sampled over windows of this many k-mers
+				int MaxOccs,					// minimizers occurring more than this many times are not indexed
+				int NumThreads);				// use at most this many threads
+
+	inline uint32_t HashKMer(uint32_t KMer)		// invertible hash of k-mer packed 2 bits per base
+		{
+		KMer = (~KMer + (KMer << 15)) & m_KMerMsk;
+		KMer = KMer ^ (KMer >> 12);
+		KMer = (KMer + (KMer << 2)) & m_KMerMsk;
+		KMer = KMer ^ (KMer >> 4);
+		KMer = (KMer * 2057) & m_KMerMsk;
+		KMer = KMer ^ (KMer >> 16);
+		return(KMer);
+		}
+
+	uint32_t NumWins(uint32_t SeqLen);			// returns number of minimizer windows in sequence of length SeqLen
+
+	uint32_t									// returned number of minimizers
+		Minimizers(etSeqBase *pSeq,				// sequence
+					uint32_t SeqLen,			// sequence length
+					uint32_t FirstWin,			// minimizers for windows starting from this window
+					uint32_t EndWin,			// until immediately before this window
+					tsMinimizer *pMinimizers);	// returned minimizers, must be able to hold at least EndWin - FirstWin minimizers
+
+	uint32_t								// returned number of bases accepted as extending the flank
+		ExtendFlank(etSeqBase *pProbe,		// extend from this probe base, outwards from an aligned run
+				etSeqBase *pTarg,			// and this target base
+				uint32_t MaxExtn,			// extend for at most this many bases
+				int Dirn,					// 1 if extending 3', -1 if extending 5'
+				uint32_t RunLen,			// run being extended is this length
+				int BaseMatchPts,			// award this many points for matching bases
+				int BaseMismatchPts,		// penalise this many points for mismatching bases
+				uint32_t *pNumMMs);			// returned number of mismatches in accepted extension
+
+	int											// returned number of hits, < 0 if errors
+		GatherHits(uint32_t NumMinimizers,		// gather target hits for this many query minimizers
+					uint32_t MaxOccs,			// skipping minimizers occurring more than this many times
+					tsMzIdxScratch *pScratch);	// query minimizers and returned hits
+
+public:
+	CMinimizerIdx(void);
+	~CMinimizerIdx(void);
+
+	void Reset(void);							// release index
+
+	int											// eBSFSuccess or error code
+		Open(CSfxArray *pSfxArray,				// index sequences in this suffix array, suffix block containing sequences must have been loaded
+				char *pszSfxFile,				// suffix array was loaded from this file, index file is this name with cpszMzIdxFileExtn appended, NULL if index only to be built in memory
+				int KMerLen,					// index k-mers of this length
+				int WinLen,						// minimizers sampled over windows of this many k-mers
+				int MaxOccs,					// minimizers occurring more than this many times are not indexed
+				int NumThreads);				// if index file does not exist, or was built with different parameters, then build with this many threads
+
+	int GetKMerLen(void);						// returns indexed k-mer length
+	int GetWinLen(void);						// returns minimizer window length
+	int64_t GetNumMinimizers(void);				// returns number of indexed minimizers
+
+	static void FreeScratch(tsMzIdxScratch *pScratch);	// release per thread working memory
+
+	int											// < 0 if errors, otherwise number of alignment nodes returned
+		LocateQuerySeqs(uint32_t QuerySeqID,	// identifies this query sequence
+				etSeqBase *pProbeSeq,			// probe
+				uint32_t ProbeLen,				// probe length
+				uint32_t MinAlignLen,			// accept runs extended to at least this length
+				eALStrand Align2Strand,			// align to this strand
+				uint32_t MaxOccs,				// skip minimizers occurring more than this many times
+				uint32_t MaxHits,				// return at most this number of alignment nodes
+				tsQueryAlignNodes *pHits,		// where to return alignment nodes
+				int BaseMatchPts,				// award this many points for matching bases when extending 5' and 3' flanks
+				int BaseMismatchPts,			// penalise this many points for mismatching bases when extending 5' and 3' flanks
+				tsMzIdxScratch *pScratch);		// calling thread's working memory
+
+	int											// < 0 if errors, otherwise number of candidate targets returned in pScratch->pCands ordered by descending NumShared
+		LocateCandidates(etSeqBase *pProbeSeq,	// probe, only the sense strand is processed
+				uint32_t ProbeLen,				// probe length
+				uint32_t SloughSeqID,			// if > 0 then hits onto this target sequence (normally the probe itself) are sloughed
+				uint32_t MinTargLen,			// candidate targets must be at least this length
+				uint32_t MaxTargLen,			// if > 0 then candidate targets must be no longer than this length
+				uint32_t MaxOccs,				// skip minimizers occurring more than this many times
+				uint32_t DiagBand,				// minimizer hits are diagonally consistent if within a band of this many diagonals
+				uint32_t MinShared,				// candidates must have at least this many diagonally consistent minimizer hits
+				uint32_t MaxCands,				// return at most this many candidates
+				tsMzIdxScratch *pScratch);		// calling thread's working memory
+
+	// work pool processing, public only so they are accessible to the pool thread functions
+	int CountBuckets(int64_t StartIdx, int64_t EndIdx, int WorkerIdx);	// count minimizers in each bucket
+	int FillBuckets(int64_t StartIdx, int64_t EndIdx, int WorkerIdx);	// fill buckets with minimizers
+	int SortBuckets(int64_t StartIdx, int64_t EndIdx);		// sort minimizers within buckets
+};
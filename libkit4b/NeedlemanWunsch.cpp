@@ -236,6 +236,7 @@ if(m_ProbeLen < cNWMinProbeOrTargLen || m_TargLen < cNWMinProbeOrTargLen || ((in
 	return(eBSFerrMaxEntries);	
 
 NumCells = m_ProbeLen * m_TargLen;
+CRunProfile::Count(eRPCSWCells,NumCells);
 
 if(m_pTrcBckCells == NULL || m_TrcBckCellsAllocd < NumCells || ((uint64_t)m_TrcBckCellsAllocd > (uint64_t)NumCells * 2))
 	{
@@ -0,0 +1,542 @@
+/*
+This toolkit is a source base clone of 'BioKanga' release 4.4.2 (https://github.com/csiro-crop-informatics/biokanga) and contains
+significant source code changes enabling new functionality and resulting process parameterisation changes. These changes have resulted in
+incompatibility with 'BioKanga'.
+
+Because of the potential for confusion by users unaware of functionality and process parameterisation changes then the modified source base
+and resultant compiled executables have been renamed to 'kit4b' - K-mer Informed Toolkit for Bioinformatics.
+The renaming will force users of the 'BioKanga' toolkit to examine scripting which is dependent on existing 'BioKanga'
+parameterisations so as to make appropriate changes if wishing to utilise 'kit4b' parameterisations and functionality.
+
+'kit4b' is being released under the Opensource Software License Agreement (GPLv3)
+'kit4b' is Copyright (c) 2019, 2020
+Please contact Dr Stuart Stephen < stuartjs@g3web.com > if you have any questions regarding 'kit4b'.
+
+Original 'BioKanga' copyright notice has been retained and immediately follows this notice..
+*/
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+// Kernels comparing packed base alleles (PBAs) over runs of loci, see PBAcmp.h
+// Vector kernels use byte-wise compares over 16, 32 or 64 loci at a time with per-lane byte counters being summed (_mm_sad_epu8) at most every 255 iterations
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "./commhdrs.h"
+
+#include "PBAcmp.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define _PBA_X86_ 1
+#define PBA_TARGET_SSE2 __attribute__((target("sse2")))
+#define PBA_TARGET_AVX2 __attribute__((target("avx2")))
+#define PBA_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,popcnt")))
+#define PBA_POPCNT64(x) __builtin_popcountll(x)
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define _PBA_X86_ 1
+#define PBA_TARGET_SSE2
+#define PBA_TARGET_AVX2
+#define PBA_TARGET_AVX512
+#define PBA_POPCNT64(x) __popcnt64(x)
+#endif
+
+#ifdef _PBA_X86_
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+ePBAcmpISA CPBAcmp::m_ISA = ePBAISAScalar;
+bool CPBAcmp::m_bISAInit = false;
+
+// biallelic if exactly two alleles each of maximal abundance and no other alleles
+static inline bool
+IsBiallelicPBA(uint8_t PBA)
+{
+return(PBA == 0xf0 || PBA == 0xcc || PBA == 0xc3 || PBA == 0x3c || PBA == 0x33 || PBA == 0x0f);
+}
+
+static void
+MatchCntsScalar(const uint8_t *pSrc, const uint8_t *pRef, int32_t NumLoci, tsPBAMatchCnts *pCnts)
+{
+uint8_t SrcPBA;
+uint8_t RefPBA;
+for(; NumLoci > 0; NumLoci--)
+	{
+	SrcPBA = *pSrc++;
+	RefPBA = *pRef++;
+	if(RefPBA == 0 || SrcPBA == 0)		// both source and reference must have coverage at loci
+		continue;
+	if(SrcPBA == RefPBA)
+		{
+		pCnts->NumExactMatches++;
+		if(IsBiallelicPBA(RefPBA))
+			pCnts->NumBiallelicExactMatches++;
+		}
+	else
+		if(SrcPBA & RefPBA)				// at least one of the reference alleles present?
+			{
+			if(~RefPBA & SrcPBA)
+				pCnts->NumNonRefAlleles++;
+			else
+				pCnts->NumPartialMatches++;
+			}
+	pCnts->AlignLen++;
+	}
+}
+
+static uint32_t
+NumDiffsScalar(const uint8_t *pA, const uint8_t *pB, int32_t NumLoci)
+{
+uint32_t NumDiffs = 0;
+for(; NumLoci > 0; NumLoci--)
+	if(*pA++ != *pB++)
+		NumDiffs++;
+return(NumDiffs);
+}
+
+// set bits in masks for NumBits (1..64) loci, bits above NumBits are reset
+static void
+AlleleMaskScalar(const uint8_t *pPBA, int32_t NumBits, uint64_t *pNone, uint64_t *pDirac, uint64_t *pAlleles[4], int32_t WordIdx)
+{
+uint64_t None = 0;
+uint64_t Dirac = 0;
+uint64_t Alleles[4] = {0,0,0,0};
+uint8_t MaxAlleles;
+int32_t AlleleIdx;
+for(int32_t Bit = 0; Bit < NumBits; Bit++, pPBA++)
+	{
+	if(*pPBA == 0)
+		{
+		None |= (uint64_t)1 << Bit;
+		continue;
+		}
+	MaxAlleles = *pPBA & (*pPBA >> 1) & 0x55;		// bit AlleleIdx*2 set if allele at AlleleIdx has maximal abundance
+	if(MaxAlleles != 0 && (MaxAlleles & (MaxAlleles - 1)) == 0)
+		Dirac |= (uint64_t)1 << Bit;
+	for(AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
+		if(MaxAlleles & (0x01 << (AlleleIdx * 2)))
+			Alleles[AlleleIdx] |= (uint64_t)1 << Bit;
+	}
+if(pNone != NULL)
+	pNone[WordIdx] = None;
+if(pDirac != NULL)
+	pDirac[WordIdx] = Dirac;
+if(pAlleles != NULL)
+	for(AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
+		if(pAlleles[AlleleIdx] != NULL)
+			pAlleles[AlleleIdx][WordIdx] = Alleles[AlleleIdx];
+}
+
+static void
+AlleleMasksScalar(const uint8_t *pPBA, int32_t NumLoci, uint64_t *pNone, uint64_t *pDirac, uint64_t *pAlleles[4])
+{
+int32_t WordIdx;
+for(WordIdx = 0; NumLoci > 0; WordIdx++, NumLoci -= 64, pPBA += 64)
+	AlleleMaskScalar(pPBA, NumLoci > 64 ? 64 : NumLoci, pNone, pDirac, pAlleles, WordIdx);
+}
+
+#ifdef _PBA_X86_
+static inline void
+StoreMaskWords(uint64_t None, uint64_t Dirac, uint64_t Alleles[4], uint64_t *pNone, uint64_t *pDirac, uint64_t *pAlleles[4], int32_t WordIdx)
+{
+if(pNone != NULL)
+	pNone[WordIdx] = None;
+if(pDirac != NULL)
+	pDirac[WordIdx] = Dirac;
+if(pAlleles != NULL)
+	for(int AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
+		if(pAlleles[AlleleIdx] != NULL)
+			pAlleles[AlleleIdx][WordIdx] = Alleles[AlleleIdx];
+}
+
+PBA_TARGET_SSE2 static uint64_t
+SumBytesSSE2(__m128i Acc)
+{
+uint64_t Sums[2];
+_mm_storeu_si128((__m128i *)Sums, _mm_sad_epu8(Acc, _mm_setzero_si128()));
+return(Sums[0] + Sums[1]);
+}
+
+PBA_TARGET_SSE2 static void
+MatchCntsSSE2(const uint8_t *pSrc, const uint8_t *pRef, int32_t NumLoci, tsPBAMatchCnts *pCnts)
+{
+const __m128i Zero = _mm_setzero_si128();
+const __m128i Ones = _mm_set1_epi8((char)0xff);
+const __m128i Bi0 = _mm_set1_epi8((char)0xf0), Bi1 = _mm_set1_epi8((char)0xcc), Bi2 = _mm_set1_epi8((char)0xc3);
+const __m128i Bi3 = _mm_set1_epi8((char)0x3c), Bi4 = _mm_set1_epi8((char)0x33), Bi5 = _mm_set1_epi8((char)0x0f);
+__m128i Src, Ref, NoAlign, Exact, Bi, Share, NoNonRef;
+__m128i AccAlign, AccExact, AccBi, AccPartial, AccNonRef;
+int32_t Blocks;
+
+while(NumLoci >= 16)
+	{
+	Blocks = min(NumLoci / 16, 255);		// byte counters can't overflow
+	NumLoci -= Blocks * 16;
+	AccAlign = AccExact = AccBi = AccPartial = AccNonRef = Zero;
+	for(; Blocks > 0; Blocks--, pSrc += 16, pRef += 16)
+		{
+		Src = _mm_loadu_si128((const __m128i *)pSrc);
+		Ref = _mm_loadu_si128((const __m128i *)pRef);
+		NoAlign = _mm_or_si128(_mm_cmpeq_epi8(Src, Zero), _mm_cmpeq_epi8(Ref, Zero));
+		Exact = _mm_andnot_si128(NoAlign, _mm_cmpeq_epi8(Src, Ref));
+		Bi = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Ref, Bi0), _mm_cmpeq_epi8(Ref, Bi1)), _mm_or_si128(_mm_cmpeq_epi8(Ref, Bi2), _mm_cmpeq_epi8(Ref, Bi3)));
+		Bi = _mm_and_si128(Exact, _mm_or_si128(Bi, _mm_or_si128(_mm_cmpeq_epi8(Ref, Bi4), _mm_cmpeq_epi8(Ref, Bi5))));
+		Share = _mm_xor_si128(_mm_or_si128(_mm_or_si128(NoAlign, Exact), _mm_cmpeq_epi8(_mm_and_si128(Src, Ref), Zero)), Ones);
+		NoNonRef = _mm_cmpeq_epi8(_mm_andnot_si128(Ref, Src), Zero);
+		AccAlign = _mm_sub_epi8(AccAlign, _mm_xor_si128(NoAlign, Ones));
+		AccExact = _mm_sub_epi8(AccExact, Exact);
+		AccBi = _mm_sub_epi8(AccBi, Bi);
+		AccPartial = _mm_sub_epi8(AccPartial, _mm_and_si128(Share, NoNonRef));
+		AccNonRef = _mm_sub_epi8(AccNonRef, _mm_andnot_si128(NoNonRef, Share));
+		}
+	pCnts->AlignLen += (uint32_t)SumBytesSSE2(AccAlign);
+	pCnts->NumExactMatches += (uint32_t)SumBytesSSE2(AccExact);
+	pCnts->NumBiallelicExactMatches += (uint32_t)SumBytesSSE2(AccBi);
+	pCnts->NumPartialMatches += (uint32_t)SumBytesSSE2(AccPartial);
+	pCnts->NumNonRefAlleles += (uint32_t)SumBytesSSE2(AccNonRef);
+	}
+MatchCntsScalar(pSrc, pRef, NumLoci, pCnts);
+}
+
+PBA_TARGET_SSE2 static uint32_t
+NumDiffsSSE2(const uint8_t *pA, const uint8_t *pB, int32_t NumLoci)
+{
+uint32_t NumDiffs = 0;
+__m128i AccEqual;
+int32_t Blocks;
+while(NumLoci >= 16)
+	{
+	Blocks = min(NumLoci / 16, 255);
+	NumLoci -= Blocks * 16;
+	NumDiffs += Blocks * 16;
+	AccEqual = _mm_setzero_si128();
+	for(; Blocks > 0; Blocks--, pA += 16, pB += 16)
+		AccEqual = _mm_sub_epi8(AccEqual, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)pA), _mm_loadu_si128((const __m128i *)pB)));
+	NumDiffs -= (uint32_t)SumBytesSSE2(AccEqual);
+	}
+return(NumDiffs + NumDiffsScalar(pA, pB, NumLoci));
+}
+
+PBA_TARGET_SSE2 static void
+AlleleMasksSSE2(const uint8_t *pPBA, int32_t NumLoci, uint64_t *pNone, uint64_t *pDirac, uint64_t *pAlleles[4])
+{
+const __m128i Zero = _mm_setzero_si128();
+const __m128i OneBits = _mm_set1_epi8(0x01);
+const __m128i Msk55 = _mm_set1_epi8(0x55);
+__m128i AlleleBit[4];
+__m128i PBAs, MaxAlleles;
+uint64_t None, Dirac, Alleles[4];
+int32_t WordIdx, Ofs, AlleleIdx;
+
+for(AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
+	AlleleBit[AlleleIdx] = _mm_set1_epi8((char)(0x01 << (AlleleIdx * 2)));
+for(WordIdx = 0; NumLoci >= 64; WordIdx++, NumLoci -= 64)
+	{
+	None = Dirac = Alleles[0] = Alleles[1] = Alleles[2] = Alleles[3] = 0;
+	for(Ofs = 0; Ofs < 64; Ofs += 16, pPBA += 16)
+		{
+		PBAs = _mm_loadu_si128((const __m128i *)pPBA);
+		MaxAlleles = _mm_and_si128(_mm_and_si128(PBAs, _mm_srli_epi16(PBAs, 1)), Msk55);	// 16bit shift, bits shifted across bytes are in bit 7 which is then masked out
+		None |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(PBAs, Zero)) << Ofs;
+		Dirac |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_andnot_si128(_mm_cmpeq_epi8(MaxAlleles, Zero), _mm_cmpeq_epi8(_mm_and_si128(MaxAlleles, _mm_sub_epi8(MaxAlleles, OneBits)), Zero))) << Ofs;
+		for(AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
+			Alleles[AlleleIdx] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(MaxAlleles, AlleleBit[AlleleIdx]), AlleleBit[AlleleIdx])) << Ofs;
+		}
+	StoreMaskWords(None, Dirac, Alleles, pNone, pDirac, pAlleles, WordIdx);
+	}
+if(NumLoci > 0)
+	AlleleMaskScalar(pPBA, NumLoci, pNone, pDirac, pAlleles, WordIdx);
+}
+
+PBA_TARGET_AVX2 static uint64_t
+SumBytesAVX2(__m256i Acc)
+{
+uint64_t Sums[4];
+_mm256_storeu_si256((__m256i *)Sums, _mm256_sad_epu8(Acc, _mm256_setzero_si256()));
+return(Sums[0] + Sums[1] + Sums[2] + Sums[3]);
+}
+
+PBA_TARGET_AVX2 static void
+MatchCntsAVX2(const uint8_t *pSrc, const uint8_t *pRef, int32_t NumLoci, tsPBAMatchCnts *pCnts)
+{
+const __m256i Zero = _mm256_setzero_si256();
+const __m256i Ones = _mm256_set1_epi8((char)0xff);
+const __m256i Bi0 = _mm256_set1_epi8((char)0xf0), Bi1 = _mm256_set1_epi8((char)0xcc), Bi2 = _mm256_set1_epi8((char)0xc3);
+const __m256i Bi3 = _mm256_set1_epi8((char)0x3c), Bi4 = _mm256_set1_epi8((char)0x33), Bi5 = _mm256_set1_epi8((char)0x0f);
+__m256i Src, Ref, NoAlign, Exact, Bi, Share, NoNonRef;
+__m256i AccAlign, AccExact, AccBi, AccPartial, AccNonRef;
+int32_t Blocks;
+
+while(NumLoci >= 32)
+	{
+	Blocks = min(NumLoci / 32, 255);
+	NumLoci -= Blocks * 32;
+	AccAlign = AccExact = AccBi = AccPartial = AccNonRef = Zero;
+	for(; Blocks > 0; Blocks--, pSrc += 32, pRef += 32)
+		{
+		Src = _mm256_loadu_si256((const __m256i *)pSrc);
+		Ref = _mm256_loadu_si256((const __m256i *)pRef);
+		NoAlign = _mm256_or_si256(_mm256_cmpeq_epi8(Src, Zero), _mm256_cmpeq_epi8(Ref, Zero));
+		Exact = _mm256_andnot_si256(NoAlign, _mm256_cmpeq_epi8(Src, Ref));
+		Bi = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(Ref, Bi0), _mm256_cmpeq_epi8(Ref, Bi1)), _mm256_or_si256(_mm256_cmpeq_epi8(Ref, Bi2), _mm256_cmpeq_epi8(Ref, Bi3)));
+		Bi = _mm256_and_si256(Exact, _mm256_or_si256(Bi, _mm256_or_si256(_mm256_cmpeq_epi8(Ref, Bi4), _mm256_cmpeq_epi8(Ref, Bi5))));
+		Share = _mm256_xor_si256(_mm256_or_si256(_mm256_or_si256(NoAlign, Exact), _mm256_cmpeq_epi8(_mm256_and_si256(Src, Ref), Zero)), Ones);
+		NoNonRef = _mm256_cmpeq_epi8(_mm256_andnot_si256(Ref, Src), Zero);
+		AccAlign = _mm256_sub_epi8(AccAlign, _mm256_xor_si256(NoAlign, Ones));
+		AccExact = _mm256_sub_epi8(AccExact, Exact);
+		AccBi = _mm256_sub_epi8(AccBi, Bi);
+		AccPartial = _mm256_sub_epi8(AccPartial, _mm256_and_si256(Share, NoNonRef));
+		AccNonRef = _mm256_sub_epi8(AccNonRef, _mm256_andnot_si256(NoNonRef, Share));
+		}
+	pCnts->AlignLen += (uint32_t)SumBytesAVX2(AccAlign);
+	pCnts->NumExactMatches += (uint32_t)SumBytesAVX2(AccExact);
+	pCnts->NumBiallelicExactMatches += (uint32_t)SumBytesAVX2(AccBi);
+	pCnts->NumPartialMatches += (uint32_t)SumBytesAVX2(AccPartial);
+	pCnts->NumNonRefAlleles += (uint32_t)SumBytesAVX2(AccNonRef);
+	}
+MatchCntsScalar(pSrc, pRef, NumLoci, pCnts);
+}
+
+PBA_TARGET_AVX2 static uint32_t
+NumDiffsAVX2(const uint8_t *pA, const uint8_t *pB, int32_t NumLoci)
+{
+uint32_t NumDiffs = 0;
+__m256i AccEqual;
+int32_t Blocks;
+while(NumLoci >= 32)
+	{
+	Blocks = min(NumLoci / 32, 255);
+	NumLoci -= Blocks * 32;
+	NumDiffs += Blocks * 32;
+	AccEqual = _mm256_setzero_si256();
+	for(; Blocks > 0; Blocks--, pA += 32, pB += 32)
+		AccEqual = _mm256_sub_epi8(AccEqual, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)pA), _mm256_loadu_si256((const __m256i *)pB)));
+	NumDiffs -= (uint32_t)SumBytesAVX2(AccEqual);
+	}
+return(NumDiffs + NumDiffsScalar(pA, pB, NumLoci));
+}
+
+PBA_TARGET_AVX2 static void
+AlleleMasksAVX2(const uint8_t *pPBA, int32_t NumLoci, uint64_t *pNone, uint64_t *pDirac, uint64_t *pAlleles[4])
+{
+const __m256i Zero = _mm256_setzero_si256();
+const __m256i OneBits = _mm256_set1_epi8(0x01);
+const __m256i Msk55 = _mm256_set1_epi8(0x55);
+__m256i AlleleBit[4];
+__m256i PBAs, MaxAlleles;
+uint64_t None, Dirac, Alleles[4];
+int32_t WordIdx, Ofs, AlleleIdx;
+
+for(AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
+	AlleleBit[AlleleIdx] = _mm256_set1_epi8((char)(0x01 << (AlleleIdx * 2)));
+for(WordIdx = 0; NumLoci >= 64; WordIdx++, NumLoci -= 64)
+	{
+	None = Dirac = Alleles[0] = Alleles[1] = Alleles[2] = Alleles[3] = 0;
+	for(Ofs = 0; Ofs < 64; Ofs += 32, pPBA += 32)
+		{
+		PBAs = _mm256_loadu_si256((const __m256i *)pPBA);
+		MaxAlleles = _mm256_and_si256(_mm256_and_si256(PBAs, _mm256_srli_epi16(PBAs, 1)), Msk55);
+		None |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(PBAs, Zero)) << Ofs;
+		Dirac |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_andnot_si256(_mm256_cmpeq_epi8(MaxAlleles, Zero), _mm256_cmpeq_epi8(_mm256_and_si256(MaxAlleles, _mm256_sub_epi8(MaxAlleles, OneBits)), Zero))) << Ofs;
+		for(AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
+			Alleles[AlleleIdx] |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(MaxAlleles, AlleleBit[AlleleIdx]), AlleleBit[AlleleIdx])) << Ofs;
+		}
+	StoreMaskWords(None, Dirac, Alleles, pNone, pDirac, pAlleles, WordIdx);
+	}
+if(NumLoci > 0)
+	AlleleMaskScalar(pPBA, NumLoci, pNone, pDirac, pAlleles, WordIdx);
+}
+
+PBA_TARGET_AVX512 static void
+MatchCntsAVX512(const uint8_t *pSrc, const uint8_t *pRef, int32_t NumLoci, tsPBAMatchCnts *pCnts)
+{
+const __m512i Bi0 = _mm512_set1_epi8((char)0xf0), Bi1 = _mm512_set1_epi8((char)0xcc), Bi2 = _mm512_set1_epi8((char)0xc3);
+const __m512i Bi3 = _mm512_set1_epi8((char)0x3c), Bi4 = _mm512_set1_epi8((char)0x33), Bi5 = _mm512_set1_epi8((char)0x0f);
+__m512i Src, Ref, NonRefAlleles;
+__mmask64 Align, Exact, Bi, Share, NonRef;
+
+for(; NumLoci >= 64; NumLoci -= 64, pSrc += 64, pRef += 64)
+	{
+	Src = _mm512_loadu_si512((const void *)pSrc);
+	Ref = _mm512_loadu_si512((const void *)pRef);
+	Align = _mm512_test_epi8_mask(Src, Src) & _mm512_test_epi8_mask(Ref, Ref);
+	Exact = Align & _mm512_cmpeq_epi8_mask(Src, Ref);
+	Bi = _mm512_cmpeq_epi8_mask(Ref, Bi0) | _mm512_cmpeq_epi8_mask(Ref, Bi1) | _mm512_cmpeq_epi8_mask(Ref, Bi2) |
+			_mm512_cmpeq_epi8_mask(Ref, Bi3) | _mm512_cmpeq_epi8_mask(Ref, Bi4) | _mm512_cmpeq_epi8_mask(Ref, Bi5);
+	Share = Align & ~Exact & _mm512_test_epi8_mask(Src, Ref);
+	NonRefAlleles = _mm512_andnot_si512(Ref, Src);
+	NonRef = Share & _mm512_test_epi8_mask(NonRefAlleles, NonRefAlleles);
+	pCnts->AlignLen += (uint32_t)PBA_POPCNT64(Align);
+	pCnts->NumExactMatches += (uint32_t)PBA_POPCNT64(Exact);
+	pCnts->NumBiallelicExactMatches += (uint32_t)PBA_POPCNT64(Exact & Bi);
+	pCnts->NumPartialMatches += (uint32_t)PBA_POPCNT64(Share & ~NonRef);
+	pCnts->NumNonRefAlleles += (uint32_t)PBA_POPCNT64(NonRef);
+	}
+MatchCntsScalar(pSrc, pRef, NumLoci, pCnts);
+}
+
+PBA_TARGET_AVX512 static uint32_t
+NumDiffsAVX512(const uint8_t *pA, const uint8_t *pB, int32_t NumLoci)
+{
+uint32_t NumDiffs = 0;
+for(; NumLoci >= 64; NumLoci -= 64, pA += 64, pB += 64)
+	NumDiffs += (uint32_t)PBA_POPCNT64(_mm512_cmpneq_epi8_mask(_mm512_loadu_si512((const void *)pA), _mm512_loadu_si512((const void *)pB)));
+return(NumDiffs + NumDiffsScalar(pA, pB, NumLoci));
+}
+
+PBA_TARGET_AVX512 static void
+AlleleMasksAVX512(const uint8_t *pPBA, int32_t NumLoci, uint64_t *pNone, uint64_t *pDirac, uint64_t *pAlleles[4])
+{
+const __m512i OneBits = _mm512_set1_epi8(0x01);
+const __m512i Msk55 = _mm512_set1_epi8(0x55);
+__m512i PBAs, MaxAlleles;
+uint64_t Alleles[4];
+int32_t WordIdx, AlleleIdx;
+
+for(WordIdx = 0; NumLoci >= 64; WordIdx++, NumLoci -= 64, pPBA += 64)
+	{
+	PBAs = _mm512_loadu_si512((const void *)pPBA);
+	MaxAlleles = _mm512_and_si512(_mm512_and_si512(PBAs, _mm512_srli_epi16(PBAs, 1)), Msk55);
+	for(AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
+		Alleles[AlleleIdx] = _mm512_test_epi8_mask(MaxAlleles, _mm512_set1_epi8((char)(0x01 << (AlleleIdx * 2))));
+	StoreMaskWords(~(uint64_t)_mm512_test_epi8_mask(PBAs, PBAs),
+				_mm512_test_epi8_mask(MaxAlleles, MaxAlleles) & ~(uint64_t)_mm512_test_epi8_mask(MaxAlleles, _mm512_sub_epi8(MaxAlleles, OneBits)),
+				Alleles, pNone, pDirac, pAlleles, WordIdx);
+	}
+if(NumLoci > 0)
+	AlleleMaskScalar(pPBA, NumLoci, pNone, pDirac, pAlleles, WordIdx);
+}
+#endif
+
+ePBAcmpISA
+CPBAcmp::DetectISA(void)
+{
+#if defined(_PBA_X86_) && defined(__GNUC__)
+__builtin_cpu_init();
+if(__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt"))
+	return(ePBAISAAVX512);
+if(__builtin_cpu_supports("avx2"))
+	return(ePBAISAAVX2);
+if(__builtin_cpu_supports("sse2"))
+	return(ePBAISASSE2);
+return(ePBAISAScalar);
+#elif defined(_PBA_X86_)
+int CPUInfo[4];
+uint64_t XCR0 = 0;
+__cpuid(CPUInfo, 0);
+if(CPUInfo[0] < 7)
+	return(ePBAISASSE2);
+__cpuid(CPUInfo, 1);
+if((CPUInfo[2] & (1 << 27)) && (CPUInfo[2] & (1 << 28)))	// OS uses XSAVE and AVX supported
+	XCR0 = _xgetbv(0);
+__cpuidex(CPUInfo, 7, 0);
+if((XCR0 & 0xe6) == 0xe6 && (CPUInfo[1] & (1 << 16)) && (CPUInfo[1] & (1 << 30)))	// OS saves ZMM state, AVX512F and AVX512BW
+	return(ePBAISAAVX512);
+if((XCR0 & 0x06) == 0x06 && (CPUInfo[1] & (1 << 5)))		// OS saves YMM state and AVX2
+	return(ePBAISAAVX2);
+return(ePBAISASSE2);
+#else
+return(ePBAISAScalar);
+#endif
+}
+
+ePBAcmpISA
+CPBAcmp::ISA(void)
+{
+if(!m_bISAInit)			// benign race, all threads would detect the same capabilities
+	{
+	m_ISA = DetectISA();
+	m_bISAInit = true;
+	}
+return(m_ISA);
+}
+
+ePBAcmpISA
+CPBAcmp::LimitISA(ePBAcmpISA MaxISA)
+{
+if(ISA() > MaxISA)
+	m_ISA = MaxISA;
+return(m_ISA);
+}
+
+void
+CPBAcmp::MatchCnts(const uint8_t *pSrc,	// source PBAs
+				const uint8_t *pRef,		// reference PBAs
+				int32_t NumLoci,			// number of loci to compare
+				tsPBAMatchCnts *pCnts)		// accumulate counts into this
+{
+if(NumLoci < 1)
+	return;
+switch(ISA()) {
+#ifdef _PBA_X86_
+	case ePBAISAAVX512:
+		MatchCntsAVX512(pSrc, pRef, NumLoci, pCnts);
+		return;
+	case ePBAISAAVX2:
+		MatchCntsAVX2(pSrc, pRef, NumLoci, pCnts);
+		return;
+	case ePBAISASSE2:
+		MatchCntsSSE2(pSrc, pRef, NumLoci, pCnts);
+		return;
+#endif
+	default:
+		MatchCntsScalar(pSrc, pRef, NumLoci, pCnts);
+		return;
+	}
+}
+
+uint32_t
+CPBAcmp::NumDiffs(const uint8_t *pA,	// PBAs
+				const uint8_t *pB,		// compared against these PBAs
+				int32_t NumLoci)		// number of loci to compare
+{
+if(NumLoci < 1)
+	return(0);
+switch(ISA()) {
+#ifdef _PBA_X86_
+	case ePBAISAAVX512:
+		return(NumDiffsAVX512(pA, pB, NumLoci));
+	case ePBAISAAVX2:
+		return(NumDiffsAVX2(pA, pB, NumLoci));
+	case ePBAISASSE2:
+		return(NumDiffsSSE2(pA, pB, NumLoci));
+#endif
+	default:
+		return(NumDiffsScalar(pA, pB, NumLoci));
+	}
+}
+
+void
+CPBAcmp::AlleleMasks(const uint8_t *pPBA,	// PBAs
+				int32_t NumLoci,			// number of loci
+				uint64_t *pNone,			// returned no allele masks, (NumLoci+63)/64 words
+				uint64_t *pDirac,			// returned single maximal allele masks
+				uint64_t *pAlleles[4])		// returned per allele maximal abundance masks
+{
+if(NumLoci < 1)
+	return;
+switch(ISA()) {
+#ifdef _PBA_X86_
+	case ePBAISAAVX512:
+		AlleleMasksAVX512(pPBA, NumLoci, pNone, pDirac, pAlleles);
+		return;
+	case ePBAISAAVX2:
+		AlleleMasksAVX2(pPBA, NumLoci, pNone, pDirac, pAlleles);
+		return;
+	case ePBAISASSE2:
+		AlleleMasksSSE2(pPBA, NumLoci, pNone, pDirac, pAlleles);
+		return;
+#endif
+	default:
+		AlleleMasksScalar(pPBA, NumLoci, pNone, pDirac, pAlleles);
+		return;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+// Kernels comparing packed base alleles (PBAs) over runs of loci
+// Each PBA byte packs the alleles at a single loci, A in bits 7..6, C in bits 5..4, G in bits 3..2 and T in bits 1..0, with 0 if no alignment at that loci
+// Kernels are selected on first use according to CPU capabilities, AVX-512BW then AVX2 then SSE2, with a scalar fallback for non-x86 targets
+
+typedef enum TAG_ePBAcmpISA {
+	ePBAISAScalar = 0,			// portable scalar
+	ePBAISASSE2,				// 16 loci per instruction
+	ePBAISAAVX2,				// 32 loci per instruction
+	ePBAISAAVX512				// 64 loci per instruction
+	} ePBAcmpISA;
+
+#pragma pack(4)
+typedef struct TAG_sPBAMatchCnts {
+	uint32_t AlignLen;					// number of loci at which both PBAs have alleles
+	uint32_t NumExactMatches;			// number of loci at which alleles were exactly matching
+	uint32_t NumBiallelicExactMatches;	// number of exact matches which were biallelic
+	uint32_t NumPartialMatches;			// number of loci not exactly matching but with all source alleles present in the reference
+	uint32_t NumNonRefAlleles;			// number of loci not exactly matching, at least one allele shared, but with source alleles not present in the reference
+} tsPBAMatchCnts;
+#pragma pack()
+
+class CPBAcmp
+{
+	static ePBAcmpISA m_ISA;			// kernels in use
+	static bool m_bISAInit;				// set true after m_ISA initialised
+
+	static ePBAcmpISA DetectISA(void);	// returns most capable kernels supported by CPU and OS
+
+public:
+	static ePBAcmpISA ISA(void);		// returns kernels which will be used
+	static ePBAcmpISA LimitISA(ePBAcmpISA MaxISA);	// limit kernels to be no more capable than MaxISA, returns kernels which will be used
+
+	// accumulate into pCnts the allele matches of source PBAs pSrc against reference PBAs pRef over NumLoci
+	static void MatchCnts(const uint8_t *pSrc,	// source PBAs
+					const uint8_t *pRef,		// reference PBAs
+					int32_t NumLoci,			// number of loci to compare
+					tsPBAMatchCnts *pCnts);		// accumulate counts into this
+
+	// returns number of loci over NumLoci at which PBAs in pA differ from those in pB
+	static uint32_t NumDiffs(const uint8_t *pA,	// PBAs
+					const uint8_t *pB,			// compared against these PBAs
+					int32_t NumLoci);			// number of loci to compare
+
+	// bit-sliced allele masks, bit N of word N/64 corresponds to pPBA[N]; bits beyond NumLoci in the final word are reset
+	// pNone: loci has no alleles, pDirac: loci has exactly one allele of maximal (3) abundance, pAlleles[AlleleIdx]: loci has maximal abundance in allele at bits (AlleleIdx*2)+1..AlleleIdx*2
+	// any of the mask arrays may be NULL if not required
+	static void AlleleMasks(const uint8_t *pPBA,	// PBAs
+					int32_t NumLoci,			// number of loci
+					uint64_t *pNone,			// returned no allele masks, (NumLoci+63)/64 words
+					uint64_t *pDirac,			// returned single maximal allele masks
+					uint64_t *pAlleles[4]);		// returned per allele maximal abundance masks
+};
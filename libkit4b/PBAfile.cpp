@@ -0,0 +1,794 @@
+/*
+This toolkit is a source base clone of 'BioKanga' release 4.4.2 (https://github.com/csiro-crop-informatics/biokanga) and contains
+significant source code changes enabling new functionality and resulting process parameterisation changes. These changes have resulted in
+incompatibility with 'BioKanga'.
+
+Because of the potential for confusion by users unaware of functionality and process parameterisation changes then the modified source base
+and resultant compiled executables have been renamed to 'kit4b' - K-mer Informed Toolkit for Bioinformatics.
+The renaming will force users of the 'BioKanga' toolkit to examine scripting which is dependent on existing 'BioKanga'
+parameterisations so as to make appropriate changes if wishing to utilise 'kit4b' parameterisations and functionality.
+
+'kit4b' is being released under the Opensource Software License Agreement (GPLv3)
+'kit4b' is Copyright (c) 2019, 2020
+Please contact Dr Stuart Stephen < stuartjs@g3web.com > if you have any questions regarding 'kit4b'.
+
+Original 'BioKanga' copyright notice has been retained and immediately follows this notice..
+*/
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+// Packed base allele (PBA) file access, see PBAfile.h for version 1 and version 2 file formats
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "./commhdrs.h"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include "PBAfile.h"
+
+CPBAfile::CPBAfile(void)
+{
+m_hFile = -1;
+m_pChroms = nullptr;
+m_pPad = nullptr;
+Reset();
+}
+
+CPBAfile::~CPBAfile(void)
+{
+Reset();
+}
+
+void
+CPBAfile::Reset(void)
+{
+Close();
+if(m_pChroms != nullptr)
+	{
+	delete []m_pChroms;
+	m_pChroms = nullptr;
+	}
+if(m_pPad != nullptr)
+	{
+	delete []m_pPad;
+	m_pPad = nullptr;
+	}
+m_szFile[0] = '\0';
+m_FileSize = 0;
+m_Version = 0;
+m_szExperimentID[0] = '\0';
+m_szReferenceID[0] = '\0';
+m_szReadsetID[0] = '\0';
+m_EndFileOfs = 0;
+m_NumChroms = 0;
+m_AllocChroms = 0;
+m_FileOfsDir = 0;
+m_MaxDirLen = 0;
+m_DirLen = 0;
+}
+
+void
+CPBAfile::Close(void)
+{
+if(m_hFile != -1)
+	{
+	close(m_hFile);
+	m_hFile = -1;
+	}
+m_bCreate = false;
+}
+
+int
+CPBAfile::Version(void)
+{
+return(m_Version);
+}
+
+char *
+CPBAfile::ExperimentID(void)
+{
+return(m_szExperimentID);
+}
+
+char *
+CPBAfile::ReferenceID(void)
+{
+return(m_szReferenceID);
+}
+
+char *
+CPBAfile::ReadsetID(void)
+{
+return(m_szReadsetID);
+}
+
+int64_t
+CPBAfile::EndFileOfs(void)
+{
+return(m_EndFileOfs);
+}
+
+int32_t
+CPBAfile::NumChroms(void)
+{
+return(m_NumChroms);
+}
+
+tsPBAChrom *
+CPBAfile::Chrom(int32_t ChromIdx)
+{
+if(m_pChroms == nullptr || ChromIdx < 0 || ChromIdx >= m_NumChroms)
+	return(nullptr);
+return(&m_pChroms[ChromIdx]);
+}
+
+int
+CPBAfile::AddChrom(char *pszChromName,		// chromosome name
+				int32_t ChromLen,			// number of PBAs
+				int64_t FileOfsPBA)			// PBAs start at this file offset
+{
+tsPBAChrom *pChrom;
+if(m_pChroms == nullptr || m_NumChroms == m_AllocChroms)
+	{
+	tsPBAChrom *pRealloc;
+	if((pRealloc = new tsPBAChrom[(size_t)m_AllocChroms + cAllocPBAChroms]) == nullptr)
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "CPBAfile::AddChrom: Memory allocation for %d chromosomes failed", m_AllocChroms + cAllocPBAChroms);
+		return(eBSFerrMem);
+		}
+	if(m_pChroms != nullptr)
+		{
+		if(m_NumChroms)
+			memcpy(pRealloc, m_pChroms, sizeof(tsPBAChrom) * m_NumChroms);
+		delete []m_pChroms;
+		}
+	m_pChroms = pRealloc;
+	m_AllocChroms += cAllocPBAChroms;
+	}
+pChrom = &m_pChroms[m_NumChroms++];
+pChrom->FileOfsPBA = FileOfsPBA;
+pChrom->ChromLen = ChromLen;
+strncpy(pChrom->szChromName, pszChromName, cMaxPBAChromNameLen);
+pChrom->szChromName[cMaxPBAChromNameLen] = '\0';
+if(FileOfsPBA + ChromLen > m_EndFileOfs)
+	m_EndFileOfs = FileOfsPBA + ChromLen;
+return(eBSFSuccess);
+}
+
+bool
+CPBAfile::ReadAt(int hFile,				// read from this file
+				int64_t FileOfs,		// starting at this offset
+				uint8_t *pBuff,			// into this buffer
+				int64_t Len)			// exactly this many bytes
+{
+int NumRead;
+if(_lseeki64(hFile, FileOfs, SEEK_SET) != FileOfs)
+	return(false);
+while(Len > 0)
+	{
+	if((NumRead = (int)read(hFile, pBuff, (unsigned int)min(Len, (int64_t)0x40000000))) <= 0)
+		return(false);
+	pBuff += NumRead;
+	Len -= NumRead;
+	CRunProfile::Count(eRPCBytesRead,NumRead);
+	}
+return(true);
+}
+
+int
+CPBAfile::Open(char *pszFile)		// open PBA file, parse header and load chromosome directory
+{
+int Rslt;
+int NumTags;
+int ScanLen;
+int64_t HdrLen;
+uint8_t Hdr[cMaxPBAHdrLen + 1];
+
+Reset();
+strncpy(m_szFile, pszFile, _MAX_PATH);
+m_szFile[_MAX_PATH - 1] = '\0';
+#ifdef _WIN32
+m_hFile = open(pszFile, O_READSEQ);
+#else
+m_hFile = open64(pszFile, O_READSEQ);
+#endif
+if(m_hFile == -1)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to open input file '%s' : %s", pszFile, strerror(errno));
+	Reset();
+	return(eBSFerrOpnFile);
+	}
+m_FileSize = _lseeki64(m_hFile, 0, SEEK_END);
+HdrLen = min(m_FileSize, (int64_t)cMaxPBAHdrLen);
+memset(Hdr, 0, sizeof(Hdr));
+if(HdrLen < 9 || !ReadAt(m_hFile, 0, Hdr, HdrLen))
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to read at least a partial header from input file '%s'", pszFile);
+	Reset();
+	return(eBSFerrOpnFile);
+	}
+
+// check file type is PBA
+if(strncmp((char *)Hdr, "Type:PbA", 8))
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists, unable to parse file type header tag as being a packed base allele file", pszFile);
+	Reset();
+	return(eBSFerrOpnFile);
+	}
+// file type in header expected to be followed by a new line, not carriage return then a new line!
+if(Hdr[8] != '\n' && Hdr[9] != 'V')
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists, file type header tag is for a PBA type but this tag is incorrectly terminated. Has file been transformed into ascii?", pszFile);
+	Reset();
+	return(eBSFerrOpnFile);
+	}
+
+// parse out tagnames and associated values
+NumTags = sscanf((char *)&Hdr[9], "Version:%d\nExperimentID:%99[^\n]\nReferenceID:%99[^\n]\nReadsetID:%99[^\n]%n", &m_Version, m_szExperimentID, m_szReferenceID, m_szReadsetID, &ScanLen);
+if(NumTags != 4 || (m_Version != cPBAFileVersion1 && m_Version != cPBAFileVersion2) || m_szExperimentID[0] == '\0' || m_szReferenceID[0] == '\0' || m_szReadsetID[0] == '\0' || Hdr[9 + ScanLen] != '\0')
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists as a packed base allele file but inconsistencies in header tag values", pszFile);
+	Reset();
+	return(eBSFerrOpnFile);
+	}
+HdrLen = (int64_t)9 + ScanLen + 1;		// header tags were '\n' terminated except for final which was '\0' terminated
+m_EndFileOfs = HdrLen;
+
+if(m_Version == cPBAFileVersion1)
+	Rslt = LoadDirV1(HdrLen);
+else
+	Rslt = LoadDirV2(HdrLen);
+if(Rslt != eBSFSuccess)
+	{
+	Reset();
+	return(Rslt);
+	}
+return(eBSFSuccess);
+}
+
+// version 1 files have no directory, each chromosome's metadata immediately precedes it's PBAs so skip from chromosome to chromosome
+int
+CPBAfile::LoadDirV1(int64_t FileOfs)
+{
+int Rslt;
+int ChromNameLen;
+int32_t ChromLen;
+int64_t FileOfsPBA;
+int64_t MetaLen;
+uint8_t ChromMeta[cMaxPBAChromNameLen + 6];
+
+while(FileOfs < m_FileSize)
+	{
+	MetaLen = min(m_FileSize - FileOfs, (int64_t)sizeof(ChromMeta));
+	if(MetaLen < 6 || !ReadAt(m_hFile, FileOfs, ChromMeta, MetaLen))
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' truncated or errors reading chromosome metadata at file offset %lld", m_szFile, (long long)FileOfs);
+		return(eBSFerrFileAccess);
+		}
+	ChromNameLen = (int)ChromMeta[0];
+	if((int64_t)ChromNameLen + 6 > MetaLen || ChromMeta[1 + ChromNameLen] != '\0')
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' has inconsistent chromosome metadata at file offset %lld", m_szFile, (long long)FileOfs);
+		return(eBSFerrParse);
+		}
+	memcpy(&ChromLen, &ChromMeta[2 + ChromNameLen], sizeof(int32_t));
+	FileOfsPBA = FileOfs + ChromNameLen + 6;
+	if(ChromLen < 0 || FileOfsPBA + ChromLen > m_FileSize)
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' truncated, chromosome '%s' PBAs extend past end of file", m_szFile, (char *)&ChromMeta[1]);
+		return(eBSFerrFileAccess);
+		}
+	if((Rslt = AddChrom((char *)&ChromMeta[1], ChromLen, FileOfsPBA)) != eBSFSuccess)
+		return(Rslt);
+	FileOfs = FileOfsPBA + ChromLen;
+	}
+return(eBSFSuccess);
+}
+
+int
+CPBAfile::LoadDirV2(int64_t FileOfs)
+{
+int Rslt;
+int32_t ChromIdx;
+int32_t NumChroms;
+int32_t DirLen;
+int ChromNameLen;
+int32_t ChromLen;
+int64_t FileOfsPBA;
+int32_t DirHdr[2];
+uint8_t *pDir;
+uint8_t *pEntry;
+uint8_t *pDirEnd;
+
+if(FileOfs + (int64_t)sizeof(DirHdr) > m_FileSize || !ReadAt(m_hFile, FileOfs, (uint8_t *)DirHdr, sizeof(DirHdr)))
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' truncated or errors reading chromosome directory", m_szFile);
+	return(eBSFerrFileAccess);
+	}
+NumChroms = DirHdr[0];
+DirLen = DirHdr[1];
+FileOfs += sizeof(DirHdr);
+if(NumChroms < 0 || DirLen < NumChroms * 14 || FileOfs + DirLen > m_FileSize)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' has an inconsistent chromosome directory", m_szFile);
+	return(eBSFerrParse);
+	}
+m_EndFileOfs = FileOfs + DirLen;
+if(NumChroms == 0)
+	return(eBSFSuccess);
+if((pDir = new uint8_t[DirLen]) == nullptr)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' memory allocation of %d bytes for chromosome directory failed", m_szFile, DirLen);
+	return(eBSFerrMem);
+	}
+if(!ReadAt(m_hFile, FileOfs, pDir, DirLen))
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' errors reading chromosome directory", m_szFile);
+	delete []pDir;
+	return(eBSFerrFileAccess);
+	}
+pEntry = pDir;
+pDirEnd = &pDir[DirLen];
+Rslt = eBSFSuccess;
+for(ChromIdx = 0; ChromIdx < NumChroms; ChromIdx++)
+	{
+	ChromNameLen = (int)*pEntry;
+	if(&pEntry[ChromNameLen + 14] > pDirEnd || pEntry[1 + ChromNameLen] != '\0')
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' has an inconsistent chromosome directory", m_szFile);
+		Rslt = eBSFerrParse;
+		break;
+		}
+	memcpy(&ChromLen, &pEntry[2 + ChromNameLen], sizeof(int32_t));
+	memcpy(&FileOfsPBA, &pEntry[6 + ChromNameLen], sizeof(int64_t));
+	if(ChromLen < 0 || (FileOfsPBA % cPBAv2AlignPBAs) != 0 || FileOfsPBA < m_EndFileOfs || FileOfsPBA + ChromLen > m_FileSize)
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' truncated or chromosome '%s' has inconsistent PBA file offset", m_szFile, (char *)&pEntry[1]);
+		Rslt = eBSFerrFileAccess;
+		break;
+		}
+	if((Rslt = AddChrom((char *)&pEntry[1], ChromLen, FileOfsPBA)) != eBSFSuccess)
+		break;
+	pEntry += ChromNameLen + 14;
+	}
+delete []pDir;
+return(Rslt);
+}
+
+uint8_t *
+CPBAfile::MapPBAs(int hFile,			// map or load PBAs from this opened file
+				int64_t FileOfsPBA,		// PBAs start at this file offset
+				int32_t ChromLen)		// this many PBAs
+{
+uint8_t *pPBAs;
+if(hFile == -1 || ChromLen <= 0)
+	return(nullptr);
+#ifdef _WIN32
+if((pPBAs = (uint8_t *)malloc((size_t)ChromLen)) == nullptr)
+	return(nullptr);
+if(!ReadAt(hFile, FileOfsPBA, pPBAs, ChromLen))
+	{
+	free(pPBAs);
+	return(nullptr);
+	}
+#else
+// private mapping so callers can continue to validate and trim PBAs in-place, only those pages actually updated are copied
+// mapping remains valid after the file is closed
+if((FileOfsPBA % sysconf(_SC_PAGESIZE)) == 0)
+	{
+	pPBAs = (uint8_t *)mmap64(nullptr, (size_t)ChromLen, PROT_READ | PROT_WRITE, MAP_PRIVATE, hFile, FileOfsPBA);
+	if(pPBAs != MAP_FAILED)
+		{
+		madvise(pPBAs, (size_t)ChromLen, MADV_SEQUENTIAL);
+		CRunProfile::Count(eRPCBytesRead,ChromLen);		// mapped PBAs are expected to be read in full
+		return(pPBAs);
+		}
+	}
+// not page aligned, as with version 1 files, so read into anonymous mapping
+pPBAs = (uint8_t *)mmap(nullptr, (size_t)ChromLen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+if(pPBAs == MAP_FAILED)
+	return(nullptr);
+if(!ReadAt(hFile, FileOfsPBA, pPBAs, ChromLen))
+	{
+	munmap(pPBAs, (size_t)ChromLen);
+	return(nullptr);
+	}
+#endif
+return(pPBAs);
+}
+
+uint8_t *
+CPBAfile::LoadChromPBAs(int32_t ChromIdx)
+{
+tsPBAChrom *pChrom;
+uint8_t *pPBAs;
+if((pChrom = Chrom(ChromIdx)) == nullptr)
+	return(nullptr);
+if((pPBAs = MapPBAs(m_hFile, pChrom->FileOfsPBA, pChrom->ChromLen)) == nullptr)
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to load %d PBAs for chromosome '%s' from file '%s' : %s", pChrom->ChromLen, pChrom->szChromName, m_szFile, strerror(errno));
+return(pPBAs);
+}
+
+uint8_t *
+CPBAfile::LoadPBAs(char *pszFile,		// PBA file
+				int64_t FileOfsPBA,		// PBAs start at this file offset
+				int32_t ChromLen)		// this many PBAs
+{
+int hFile;
+uint8_t *pPBAs;
+#ifdef _WIN32
+hFile = open(pszFile, O_READSEQ);
+#else
+hFile = open64(pszFile, O_READSEQ);
+#endif
+if(hFile == -1)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "LoadPBAs: Unable to open input file '%s' : %s", pszFile, strerror(errno));
+	return(nullptr);
+	}
+// guard against the file having been truncated since it's directory was loaded, accesses to mapped pages past end of file would fault
+if(_lseeki64(hFile, 0, SEEK_END) < FileOfsPBA + ChromLen)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "LoadPBAs: Input file '%s' is truncated, expected PBAs up to file offset %lld", pszFile, (long long)(FileOfsPBA + ChromLen));
+	close(hFile);
+	return(nullptr);
+	}
+if((pPBAs = MapPBAs(hFile, FileOfsPBA, ChromLen)) == nullptr)
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "LoadPBAs: Unable to load %d PBAs at file offset %lld from file '%s' : %s", ChromLen, (long long)FileOfsPBA, pszFile, strerror(errno));
+close(hFile);
+return(pPBAs);
+}
+
+void
+CPBAfile::FreePBAs(uint8_t *pPBAs,		// release PBAs as returned by LoadPBAs() or LoadChromPBAs()
+				int32_t ChromLen)		// containing this many PBAs
+{
+if(pPBAs == nullptr)
+	return;
+#ifdef _WIN32
+free(pPBAs);
+#else
+if(pPBAs != MAP_FAILED)
+	munmap(pPBAs, (size_t)ChromLen);
+#endif
+}
+
+int						// returns header length, including terminating '\0', or < 0 if errors
+CPBAfile::WriteHdr(int hFile,			// write header to this file
+				int Version,			// file format version
+				char *pszExperimentID,	// header tag values
+				char *pszReferenceID,
+				char *pszReadsetID)
+{
+int HdrLen;
+char szHdr[cMaxPBAHdrLen + 1];
+HdrLen = snprintf(szHdr, sizeof(szHdr), "Type:%s\nVersion:%d\nExperimentID:%s\nReferenceID:%s\nReadsetID:%s", "PbA", Version, pszExperimentID, pszReferenceID, pszReadsetID);
+if(HdrLen < 0 || HdrLen >= cMaxPBAHdrLen)
+	return(eBSFerrParams);
+HdrLen += 1;
+if(!CUtility::RetryWrites(hFile, szHdr, HdrLen))
+	return(eBSFerrWrite);
+return(HdrLen);
+}
+
+int32_t
+CPBAfile::DirEntryLen(char *pszChromName)
+{
+return((int32_t)min(strlen(pszChromName), (size_t)cMaxPBAChromNameLen) + 14);
+}
+
+bool
+CPBAfile::WritePad(int64_t PadLen)
+{
+int64_t WrtLen;
+while(PadLen > 0)
+	{
+	WrtLen = min(PadLen, cPBAv2AlignPBAs);
+	if(!CUtility::RetryWrites(m_hFile, m_pPad, (size_t)WrtLen))
+		return(false);
+	PadLen -= WrtLen;
+	}
+return(true);
+}
+
+int
+CPBAfile::Create(char *pszFile,			// create this file
+				char *pszExperimentID,	// header tag values
+				char *pszReferenceID,
+				char *pszReadsetID,
+				int32_t MaxDirLen)		// reserve this many bytes for the chromosome directory, sum of DirEntryLen() over all chromosomes which may be written
+{
+int Rslt;
+
+Reset();
+if(pszFile == nullptr || pszFile[0] == '\0' || MaxDirLen < 0)
+	return(eBSFerrParams);
+strncpy(m_szFile, pszFile, _MAX_PATH);
+m_szFile[_MAX_PATH - 1] = '\0';
+if((m_pPad = new uint8_t[cPBAv2AlignPBAs]) == nullptr)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "CPBAfile::Create: Memory allocation of %lld bytes failed", (long long)cPBAv2AlignPBAs);
+	Reset();
+	return(eBSFerrMem);
+	}
+memset(m_pPad, 0, cPBAv2AlignPBAs);
+
+#ifdef _WIN32
+m_hFile = open(pszFile, (O_WRONLY | _O_BINARY | _O_SEQUENTIAL | _O_CREAT | _O_TRUNC), (_S_IREAD | _S_IWRITE));
+#else
+if((m_hFile = open64(pszFile, O_WRONLY | O_CREAT, S_IREAD | S_IWRITE)) != -1)
+	if(ftruncate(m_hFile, 0) != 0)
+		{
+		close(m_hFile);
+		m_hFile = -1;
+		}
+#endif
+if(m_hFile < 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "CPBAfile::Create: Unable to create/truncate %s - %s", pszFile, strerror(errno));
+	Reset();
+	return(eBSFerrCreateFile);
+	}
+m_bCreate = true;
+m_Version = cPBAFileVersion2;
+strncpy(m_szExperimentID, pszExperimentID, cMaxPBAHdrTagLen);
+m_szExperimentID[cMaxPBAHdrTagLen] = '\0';
+strncpy(m_szReferenceID, pszReferenceID, cMaxPBAHdrTagLen);
+m_szReferenceID[cMaxPBAHdrTagLen] = '\0';
+strncpy(m_szReadsetID, pszReadsetID, cMaxPBAHdrTagLen);
+m_szReadsetID[cMaxPBAHdrTagLen] = '\0';
+if((Rslt = WriteHdr(m_hFile, cPBAFileVersion2, m_szExperimentID, m_szReferenceID, m_szReadsetID)) < 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "CPBAfile::Create: Errors writing header to '%s'", pszFile);
+	Reset();
+	return(Rslt);
+	}
+
+// chromosome directory is only known after all chromosomes have been written so reserve space for it, the reserved space is overwritten by CloseCreate()
+m_FileOfsDir = Rslt;
+m_MaxDirLen = MaxDirLen;
+if(!WritePad((int64_t)sizeof(int32_t) * 2 + MaxDirLen))
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "CPBAfile::Create: Errors writing to '%s'", pszFile);
+	Reset();
+	return(eBSFerrWrite);
+	}
+m_EndFileOfs = m_FileOfsDir + sizeof(int32_t) * 2 + MaxDirLen;
+return(eBSFSuccess);
+}
+
+int
+CPBAfile::WriteChromPBAs(char *pszChromName,	// chromosome name
+				int32_t ChromLen,			// number of PBAs
+				uint8_t *pPBAs)				// chromosome PBAs
+{
+int Rslt;
+int64_t FileOfsPBA;
+
+if(m_hFile == -1 || !m_bCreate || pszChromName == nullptr || pszChromName[0] == '\0' || ChromLen < 0 || (ChromLen > 0 && pPBAs == nullptr))
+	return(eBSFerrParams);
+if(m_DirLen + DirEntryLen(pszChromName) > m_MaxDirLen)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "CPBAfile::WriteChromPBAs: Reserved chromosome directory space in '%s' exhausted at chromosome '%s'", m_szFile, pszChromName);
+	return(eBSFerrParams);
+	}
+
+// PBAs start on aligned file offsets so can be directly memory mapped when loaded
+FileOfsPBA = ((m_EndFileOfs + cPBAv2AlignPBAs - 1) / cPBAv2AlignPBAs) * cPBAv2AlignPBAs;
+if(!WritePad(FileOfsPBA - m_EndFileOfs) || (ChromLen > 0 && !CUtility::RetryWrites(m_hFile, pPBAs, (size_t)ChromLen)))
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "CPBAfile::WriteChromPBAs: Errors writing to '%s'", m_szFile);
+	return(eBSFerrWrite);
+	}
+m_EndFileOfs = FileOfsPBA;
+if((Rslt = AddChrom(pszChromName, ChromLen, FileOfsPBA)) != eBSFSuccess)
+	return(Rslt);
+m_DirLen += DirEntryLen(pszChromName);
+return(eBSFSuccess);
+}
+
+int
+CPBAfile::CloseCreate(bool bSync)	// write chromosome directory, optionally sync, and close the created file
+{
+int Rslt;
+int32_t ChromIdx;
+int ChromNameLen;
+int32_t DirHdr[2];
+uint8_t *pDir;
+uint8_t *pEntry;
+tsPBAChrom *pChrom;
+
+if(m_hFile == -1 || !m_bCreate)
+	return(eBSFerrParams);
+DirHdr[0] = m_NumChroms;
+DirHdr[1] = m_DirLen;
+if((pDir = new uint8_t[(size_t)m_DirLen + 1]) == nullptr)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "CPBAfile::CloseCreate: Memory allocation of %d bytes for chromosome directory failed", m_DirLen);
+	Close();
+	return(eBSFerrMem);
+	}
+pEntry = pDir;
+for(ChromIdx = 0; ChromIdx < m_NumChroms; ChromIdx++)
+	{
+	pChrom = &m_pChroms[ChromIdx];
+	ChromNameLen = (int)strlen(pChrom->szChromName);
+	*pEntry = (uint8_t)ChromNameLen;
+	memcpy(&pEntry[1], pChrom->szChromName, (size_t)ChromNameLen + 1);
+	memcpy(&pEntry[2 + ChromNameLen], &pChrom->ChromLen, sizeof(int32_t));
+	memcpy(&pEntry[6 + ChromNameLen], &pChrom->FileOfsPBA, sizeof(int64_t));
+	pEntry += ChromNameLen + 14;
+	}
+Rslt = eBSFSuccess;
+if(_lseeki64(m_hFile, m_FileOfsDir, SEEK_SET) != m_FileOfsDir ||
+	!CUtility::RetryWrites(m_hFile, DirHdr, sizeof(DirHdr)) || !CUtility::RetryWrites(m_hFile, pDir, m_DirLen))
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "CPBAfile::CloseCreate: Errors writing chromosome directory to '%s'", m_szFile);
+	Rslt = eBSFerrWrite;
+	}
+delete []pDir;
+if(Rslt == eBSFSuccess && bSync)
+	{
+#ifdef _WIN32
+	_commit(m_hFile);
+#else
+	fsync(m_hFile);
+#endif
+	}
+Close();
+return(Rslt);
+}
+
+int
+CPBAfile::Convert(char *pszInFile,		// existing PBA file
+				char *pszOutFile,		// write to this file
+				int Version)			// using this format version (cPBAFileVersion1 or cPBAFileVersion2)
+{
+int Rslt;
+int hOutFile;
+int32_t ChromIdx;
+int ChromNameLen;
+int32_t DirHdr[2];
+int64_t FileOfs;
+int64_t FileOfsPBA;
+int64_t PadLen;
+uint8_t *pDir;
+uint8_t *pEntry;
+uint8_t *pPad;
+uint8_t *pPBAs;
+tsPBAChrom *pChrom;
+uint8_t ChromMeta[cMaxPBAChromNameLen + 6];
+CPBAfile InFile;
+
+if(Version != cPBAFileVersion1 && Version != cPBAFileVersion2)
+	return(eBSFerrParams);
+if((Rslt = InFile.Open(pszInFile)) != eBSFSuccess)
+	return(Rslt);
+gDiagnostics.DiagOut(eDLInfo, gszProcName, "Converting '%s' (version %d, %d chromosomes) to version %d PBA file '%s'", pszInFile, InFile.Version(), InFile.NumChroms(), Version, pszOutFile);
+
+#ifdef _WIN32
+hOutFile = open(pszOutFile, (O_WRONLY | _O_BINARY | _O_SEQUENTIAL | _O_CREAT | _O_TRUNC), (_S_IREAD | _S_IWRITE));
+#else
+if((hOutFile = open64(pszOutFile, O_WRONLY | O_CREAT, S_IREAD | S_IWRITE)) != -1)
+	if(ftruncate(hOutFile, 0) != 0)
+		{
+		close(hOutFile);
+		hOutFile = -1;
+		}
+#endif
+if(hOutFile < 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Convert: Unable to create/truncate %s - %s", pszOutFile, strerror(errno));
+	return(eBSFerrCreateFile);
+	}
+
+if((Rslt = WriteHdr(hOutFile, Version, InFile.ExperimentID(), InFile.ReferenceID(), InFile.ReadsetID())) < 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Convert: Errors writing header to '%s'", pszOutFile);
+	close(hOutFile);
+	return(Rslt);
+	}
+FileOfs = Rslt;
+Rslt = eBSFSuccess;
+pDir = nullptr;
+pPad = nullptr;
+
+if(Version == cPBAFileVersion2)
+	{
+	// directory size is known in advance so the aligned file offset for each chromosome can be determined before any PBAs are written
+	DirHdr[0] = InFile.NumChroms();
+	DirHdr[1] = 0;
+	for(ChromIdx = 0; ChromIdx < InFile.NumChroms(); ChromIdx++)
+		DirHdr[1] += (int32_t)strlen(InFile.Chrom(ChromIdx)->szChromName) + 14;
+	if((pDir = new uint8_t[(size_t)DirHdr[1] + 1]) == nullptr || (pPad = new uint8_t[cPBAv2AlignPBAs]) == nullptr)
+		Rslt = eBSFerrMem;
+	else
+		{
+		memset(pPad, 0, cPBAv2AlignPBAs);
+		FileOfsPBA = FileOfs + sizeof(DirHdr) + DirHdr[1];
+		pEntry = pDir;
+		for(ChromIdx = 0; ChromIdx < InFile.NumChroms(); ChromIdx++)
+			{
+			pChrom = InFile.Chrom(ChromIdx);
+			FileOfsPBA = ((FileOfsPBA + cPBAv2AlignPBAs - 1) / cPBAv2AlignPBAs) * cPBAv2AlignPBAs;
+			ChromNameLen = (int)strlen(pChrom->szChromName);
+			*pEntry = (uint8_t)ChromNameLen;
+			memcpy(&pEntry[1], pChrom->szChromName, (size_t)ChromNameLen + 1);
+			memcpy(&pEntry[2 + ChromNameLen], &pChrom->ChromLen, sizeof(int32_t));
+			memcpy(&pEntry[6 + ChromNameLen], &FileOfsPBA, sizeof(int64_t));
+			pEntry += ChromNameLen + 14;
+			FileOfsPBA += pChrom->ChromLen;
+			}
+		if(!CUtility::RetryWrites(hOutFile, DirHdr, sizeof(DirHdr)) || !CUtility::RetryWrites(hOutFile, pDir, DirHdr[1]))
+			Rslt = eBSFerrWrite;
+		FileOfs += sizeof(DirHdr) + DirHdr[1];
+		}
+	}
+
+for(ChromIdx = 0; Rslt == eBSFSuccess && ChromIdx < InFile.NumChroms(); ChromIdx++)
+	{
+	pChrom = InFile.Chrom(ChromIdx);
+	ChromNameLen = (int)strlen(pChrom->szChromName);
+	if(Version == cPBAFileVersion2)
+		{
+		PadLen = (((FileOfs + cPBAv2AlignPBAs - 1) / cPBAv2AlignPBAs) * cPBAv2AlignPBAs) - FileOfs;
+		if(PadLen && !CUtility::RetryWrites(hOutFile, pPad, (size_t)PadLen))
+			{
+			Rslt = eBSFerrWrite;
+			break;
+			}
+		FileOfs += PadLen;
+		}
+	else
+		{
+		ChromMeta[0] = (uint8_t)ChromNameLen;
+		memcpy(&ChromMeta[1], pChrom->szChromName, (size_t)ChromNameLen + 1);
+		memcpy(&ChromMeta[2 + ChromNameLen], &pChrom->ChromLen, sizeof(int32_t));
+		if(!CUtility::RetryWrites(hOutFile, ChromMeta, (size_t)ChromNameLen + 6))
+			{
+			Rslt = eBSFerrWrite;
+			break;
+			}
+		FileOfs += ChromNameLen + 6;
+		}
+	if(pChrom->ChromLen == 0)
+		continue;
+	if((pPBAs = InFile.LoadChromPBAs(ChromIdx)) == nullptr)
+		{
+		Rslt = eBSFerrFileAccess;
+		break;
+		}
+	if(!CUtility::RetryWrites(hOutFile, pPBAs, pChrom->ChromLen))
+		Rslt = eBSFerrWrite;
+	FreePBAs(pPBAs, pChrom->ChromLen);
+	FileOfs += pChrom->ChromLen;
+	}
+
+if(pDir != nullptr)
+	delete []pDir;
+if(pPad != nullptr)
+	delete []pPad;
+InFile.Reset();
+
+if(Rslt == eBSFSuccess)
+	{
+#ifdef _WIN32
+	_commit(hOutFile);
+#else
+	fsync(hOutFile);
+#endif
+	}
+else
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Convert: Errors writing to '%s'", pszOutFile);
+close(hOutFile);
+return(Rslt);
+}
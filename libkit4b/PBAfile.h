@@ -0,0 +1,118 @@
+#pragma once
+// Packed base allele (PBA) file access
+// Both versions start with a '\0' terminated text header of '\n' separated tags: "Type:PbA\nVersion:<n>\nExperimentID:<id>\nReferenceID:<id>\nReadsetID:<id>"
+// Version 1: header is followed by a series of chromosomes, each as a 1 byte name length, '\0' terminated name, int32 number of PBAs, then the PBAs
+// Version 2: header is followed by a chromosome directory, an int32 number of chromosomes and int32 directory length in bytes, then for each chromosome
+//            a 1 byte name length, '\0' terminated name, int32 number of PBAs and int64 file offset of the PBAs
+//            Chromosome PBAs start at file offsets which are multiples of cPBAv2AlignPBAs so they can be memory mapped directly from the file
+// Loaded PBAs are returned in memory which the caller releases as with other PBA allocations, munmap(pPBAs,ChromLen) on Linux or free(pPBAs) on Windows
+
+const int cPBAFileVersion1 = 1;					// chromosomes inline with PBAs, must be sequentially scanned to locate chromosomes
+const int cPBAFileVersion2 = 2;					// chromosome directory with aligned PBAs
+const int cMaxPBAChromNameLen = 255;			// chromosome names are limited in length by the 1 byte name length
+const int cMaxPBAHdrTagLen = 99;				// header tag values can be at most this length
+const int cMaxPBAHdrLen = 500;					// header, including all tags, will be no longer than this
+const int64_t cPBAv2AlignPBAs = 0x010000;		// v2 chromosome PBAs start at file offsets which are multiples of this, 64K is the Windows allocation granularity and a multiple of all commonly used page sizes
+const int cAllocPBAChroms = 1000;				// allocate chromosome directory entries in increments of this many
+
+#pragma pack(8)
+typedef struct TAG_sPBAChrom {
+	int64_t FileOfsPBA;							// chromosome PBAs start at this file offset
+	int32_t ChromLen;							// chromosome has this many PBAs
+	char szChromName[cMaxPBAChromNameLen + 1];	// chromosome name
+} tsPBAChrom;
+#pragma pack()
+
+class CPBAfile
+{
+	int m_hFile;								// opened PBA file
+	char m_szFile[_MAX_PATH];					// name of opened PBA file
+	int64_t m_FileSize;							// PBA file is this size
+	int m_Version;								// file format version
+	char m_szExperimentID[cMaxPBAHdrTagLen + 1];	// header tag values
+	char m_szReferenceID[cMaxPBAHdrTagLen + 1];
+	char m_szReadsetID[cMaxPBAHdrTagLen + 1];
+	int64_t m_EndFileOfs;						// file offset immediately following the last chromosome PBAs
+	int32_t m_NumChroms;						// number of chromosomes in m_pChroms
+	int32_t m_AllocChroms;						// m_pChroms allocated to hold this many chromosomes
+	tsPBAChrom *m_pChroms;						// chromosome directory
+
+	bool m_bCreate;								// true if file was created for writing with Create()
+	int64_t m_FileOfsDir;						// created file chromosome directory starts at this file offset
+	int32_t m_MaxDirLen;						// created file has this many bytes reserved for the chromosome directory
+	int32_t m_DirLen;							// chromosome directory entries for written chromosomes total this many bytes
+	uint8_t *m_pPad;							// zeroed, used when padding created file to aligned file offsets
+
+	int AddChrom(char *pszChromName,			// chromosome name
+				int32_t ChromLen,				// number of PBAs
+				int64_t FileOfsPBA);			// PBAs start at this file offset
+
+	int LoadDirV1(int64_t FileOfs);				// build chromosome directory by scanning over chromosomes starting at FileOfs
+	int LoadDirV2(int64_t FileOfs);				// load chromosome directory starting at FileOfs
+
+	bool WritePad(int64_t PadLen);				// write PadLen zeroed bytes to created file
+
+	static bool ReadAt(int hFile,				// read from this file
+				int64_t FileOfs,				// starting at this offset
+				uint8_t *pBuff,					// into this buffer
+				int64_t Len);					// exactly this many bytes
+
+	static uint8_t *MapPBAs(int hFile,			// map or load PBAs from this opened file
+				int64_t FileOfsPBA,				// PBAs start at this file offset
+				int32_t ChromLen);				// this many PBAs
+
+	static int WriteHdr(int hFile,				// write header to this file, returns header length including terminating '\0' or < 0 if errors
+				int Version,					// file format version
+				char *pszExperimentID,			// header tag values
+				char *pszReferenceID,
+				char *pszReadsetID);
+
+public:
+	CPBAfile(void);
+	~CPBAfile(void);
+
+	void Reset(void);							// close any opened file and release chromosome directory
+
+	int Open(char *pszFile);					// open PBA file, parse header and load chromosome directory; returns eBSFSuccess or error code
+	void Close(void);							// close file, chromosome directory is retained until Reset()
+
+	// create, or truncate, a version 2 PBA file with MaxDirLen bytes reserved for the chromosome directory
+	// chromosome PBAs are then written with WriteChromPBAs(), and the chromosome directory is written by CloseCreate()
+	int Create(char *pszFile,					// create this file
+				char *pszExperimentID,			// header tag values
+				char *pszReferenceID,
+				char *pszReadsetID,
+				int32_t MaxDirLen);				// reserve this many bytes for the chromosome directory, sum of DirEntryLen() over all chromosomes which may be written
+
+	int WriteChromPBAs(char *pszChromName,		// chromosome name
+				int32_t ChromLen,				// number of PBAs
+				uint8_t *pPBAs);				// chromosome PBAs
+
+	int CloseCreate(bool bSync = true);			// write chromosome directory, optionally sync, and close the created file
+
+	static int32_t DirEntryLen(char *pszChromName);	// version 2 chromosome directory entry for chromosome pszChromName requires this many bytes
+
+	int Version(void);							// file format version of opened file
+	char *ExperimentID(void);					// header tag values
+	char *ReferenceID(void);
+	char *ReadsetID(void);
+	int64_t EndFileOfs(void);					// file offset immediately following the last chromosome PBAs
+	int32_t NumChroms(void);					// number of chromosomes in directory
+	tsPBAChrom *Chrom(int32_t ChromIdx);		// chromosome directory entry (ChromIdx 0..NumChroms()-1)
+
+	uint8_t *LoadChromPBAs(int32_t ChromIdx);	// returns PBAs for chromosome (ChromIdx 0..NumChroms()-1) in the opened file, nullptr if errors
+
+	// returns PBAs starting at FileOfsPBA in pszFile, nullptr if errors
+	// PBAs are privately memory mapped (copy on write) if FileOfsPBA is page aligned - always the case for v2 files - otherwise read into allocated memory
+	static uint8_t *LoadPBAs(char *pszFile,		// PBA file
+				int64_t FileOfsPBA,				// PBAs start at this file offset
+				int32_t ChromLen);				// this many PBAs
+
+	static void FreePBAs(uint8_t *pPBAs,		// release PBAs as returned by LoadPBAs() or LoadChromPBAs()
+				int32_t ChromLen);				// containing this many PBAs
+
+	// convert existing PBA file, either version, into a new PBA file with format Version
+	static int Convert(char *pszInFile,			// existing PBA file
+				char *pszOutFile,				// write to this file
+				int Version);					// using this format version (cPBAFileVersion1 or cPBAFileVersion2)
+};
@@ -0,0 +1,528 @@
+/*
+This toolkit is a source base clone of 'BioKanga' release 4.4.2 (https://github.com/csiro-crop-informatics/biokanga) and contains
+significant source code changes enabling new functionality and resulting process parameterisation changes. These changes have resulted in
+incompatibility with 'BioKanga'.
+
+Because of the potential for confusion by users unaware of functionality and process parameterisation changes then the modified source base
+and resultant compiled executables have been renamed to 'kit4b' - K-mer Informed Toolkit for Bioinformatics.
+The renaming will force users of the 'BioKanga' toolkit to examine scripting which is dependent on existing 'BioKanga'
+parameterisations so as to make appropriate changes if wishing to utilise 'kit4b' parameterisations and functionality.
+
+'kit4b' is being released under the Opensource Software License Agreement (GPLv3)
+'kit4b' is Copyright (c) 2019, 2020
+Please contact Dr Stuart Stephen < stuartjs@g3web.com > if you have any questions regarding 'kit4b'.
+
+Original 'BioKanga' copyright notice has been retained and immediately follows this notice..
+*/
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+// Run profiling of phase timings, work counters and resident memory
+// Profiles are intended for sizing cluster jobs and for comparing runs to detect performance regressions
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include <psapi.h>
+#include "./commhdrs.h"
+#pragma comment(lib, "psapi.lib")
+#else
+#include <pthread.h>
+#include <sys/resource.h>
+#include "./commhdrs.h"
+#endif
+
+#include "RunProfile.h"
+
+// counter names as reported, ordered as teRunProfCounter
+static const char *RunProfCounterNames[eRPCNumCounters] = {
+	"reads_loaded",
+	"reads_aligned",
+	"seeds_tried",
+	"sw_cells",
+	"sw_prefilter_cells",
+	"bytes_read",
+	"bytes_inflated"
+	};
+
+// calling thread's counter slot, 0 if yet to be claimed, -1 if sharing slot 0
+#ifdef _WIN32
+static __declspec(thread) int tRunProfSlot = 0;
+#else
+static __thread int tRunProfSlot = 0;
+#endif
+
+bool CRunProfile::m_bEnabled = false;
+char CRunProfile::m_szProfileFile[_MAX_PATH];
+char CRunProfile::m_szProcess[_MAX_FNAME];
+char CRunProfile::m_szSubProcess[_MAX_FNAME];
+double CRunProfile::m_StartWallSecs = 0.0;
+double CRunProfile::m_StartCPUSecs = 0.0;
+int64_t CRunProfile::m_PeakRSS = 0;
+volatile unsigned int CRunProfile::m_CASLock = 0;
+int CRunProfile::m_NumPhases = 0;
+int CRunProfile::m_NumActivePhases = 0;
+tsRunProfPhase CRunProfile::m_Phases[cMaxRunProfPhases];
+volatile int CRunProfile::m_NumSlots = 0;
+tsRunProfSlot CRunProfile::m_Slots[cMaxRunProfSlots];
+volatile int CRunProfile::m_bTermSampler = 0;
+bool CRunProfile::m_bSamplerActive = false;
+#ifdef _WIN32
+HANDLE CRunProfile::m_hSampler = NULL;
+#else
+pthread_t CRunProfile::m_SamplerID;
+#endif
+
+double
+CRunProfile::WallSecs(void)
+{
+#ifdef _WIN32
+int64_t Freq;
+int64_t Now;
+if(!QueryPerformanceFrequency((LARGE_INTEGER *)&Freq) || Freq == 0)
+	return(0.0);
+QueryPerformanceCounter((LARGE_INTEGER *)&Now);
+return((double)Now / (double)Freq);
+#else
+struct timespec Now;
+clock_gettime(CLOCK_MONOTONIC, &Now);
+return((double)Now.tv_sec + (double)Now.tv_nsec / 1000000000.0);
+#endif
+}
+
+double
+CRunProfile::CPUSecs(void)
+{
+#ifdef _WIN32
+FILETIME CreationTime;
+FILETIME ExitTime;
+FILETIME KernelTime;
+FILETIME UserTime;
+if(!GetProcessTimes(GetCurrentProcess(), &CreationTime, &ExitTime, &KernelTime, &UserTime))
+	return(0.0);
+return((double)(((uint64_t)KernelTime.dwHighDateTime << 32) | KernelTime.dwLowDateTime) / 10000000.0 +
+		(double)(((uint64_t)UserTime.dwHighDateTime << 32) | UserTime.dwLowDateTime) / 10000000.0);
+#else
+struct rusage Usage;
+if(getrusage(RUSAGE_SELF, &Usage) != 0)
+	return(0.0);
+return((double)Usage.ru_utime.tv_sec + (double)Usage.ru_utime.tv_usec / 1000000.0 +
+		(double)Usage.ru_stime.tv_sec + (double)Usage.ru_stime.tv_usec / 1000000.0);
+#endif
+}
+
+int64_t
+CRunProfile::CurrentRSS(void)
+{
+#ifdef _WIN32
+PROCESS_MEMORY_COUNTERS MemCounters;
+if(!GetProcessMemoryInfo(GetCurrentProcess(), &MemCounters, sizeof(MemCounters)))
+	return(0);
+return((int64_t)MemCounters.WorkingSetSize);
+#else
+int hFile;
+int NumRead;
+int64_t Pages;
+int64_t ResidentPages;
+char szStatm[128];
+// /proc/self/statm contains the total program size followed by the resident size, both in pages
+if((hFile = open("/proc/self/statm", O_RDONLY)) == -1)
+	return(0);
+NumRead = (int)read(hFile, szStatm, sizeof(szStatm) - 1);
+close(hFile);
+if(NumRead <= 0)
+	return(0);
+szStatm[NumRead] = '\0';
+if(sscanf(szStatm, "%zd %zd", &Pages, &ResidentPages) != 2)
+	return(0);
+return(ResidentPages * (int64_t)sysconf(_SC_PAGESIZE));
+#endif
+}
+
+int64_t
+CRunProfile::MaxRSS(void)
+{
+#ifdef _WIN32
+PROCESS_MEMORY_COUNTERS MemCounters;
+if(!GetProcessMemoryInfo(GetCurrentProcess(), &MemCounters, sizeof(MemCounters)))
+	return(0);
+return((int64_t)MemCounters.PeakWorkingSetSize);
+#else
+struct rusage Usage;
+if(getrusage(RUSAGE_SELF, &Usage) != 0)
+	return(0);
+return((int64_t)Usage.ru_maxrss * 1024);		// Linux reports in KB
+#endif
+}
+
+void
+CRunProfile::AcquireLock(void)
+{
+int SpinCnt = 100;
+#ifdef _WIN32
+while(InterlockedCompareExchange(&m_CASLock,1,0)!=0)
+	{
+	if(SpinCnt -= 1)
+		continue;
+	SwitchToThread();
+	SpinCnt = 100;
+	}
+#else
+while(__sync_val_compare_and_swap(&m_CASLock,0,1)!=0)
+	{
+	if(SpinCnt -= 1)
+		continue;
+	sched_yield();
+	SpinCnt = 100;
+	}
+#endif
+}
+
+void
+CRunProfile::ReleaseLock(void)
+{
+#ifdef _WIN32
+InterlockedCompareExchange(&m_CASLock,0,1);
+#else
+__sync_val_compare_and_swap(&m_CASLock,1,0);
+#endif
+}
+
+void
+CRunProfile::AddCount(teRunProfCounter Counter,	// accumulate into calling thread's slot
+					int64_t Incr)
+{
+int SlotIdx;
+if((SlotIdx = tRunProfSlot) == 0)	// first count by this thread so claim a slot
+	{
+#ifdef _WIN32
+	SlotIdx = (int)InterlockedIncrement((volatile LONG *)&m_NumSlots);
+#else
+	SlotIdx = __sync_add_and_fetch(&m_NumSlots,1);
+#endif
+	if(SlotIdx >= cMaxRunProfSlots)	// all slots claimed so share slot 0
+		SlotIdx = -1;
+	tRunProfSlot = SlotIdx;
+	}
+if(SlotIdx > 0)
+	m_Slots[SlotIdx].Counts[Counter] += Incr;
+else
+	{
+#ifdef _WIN32
+	InterlockedExchangeAdd64((volatile LONG64 *)&m_Slots[0].Counts[Counter],Incr);
+#else
+	__sync_fetch_and_add(&m_Slots[0].Counts[Counter],Incr);
+#endif
+	}
+}
+
+void
+CRunProfile::SumCounts(int64_t *pCounts)	// sum counts over all slots
+{
+int SlotIdx;
+int NumSlots;
+int Counter;
+memset(pCounts,0,sizeof(int64_t) * eRPCNumCounters);
+NumSlots = min((int)m_NumSlots + 1, cMaxRunProfSlots);
+for(SlotIdx = 0; SlotIdx < NumSlots; SlotIdx++)
+	for(Counter = 0; Counter < eRPCNumCounters; Counter++)
+		pCounts[Counter] += m_Slots[SlotIdx].Counts[Counter];
+}
+
+void
+CRunProfile::SampleRSS(void)			// sample current RSS, updating peak RSS for run and all active phases
+{
+int PhaseIdx;
+int64_t RSS;
+tsRunProfPhase *pPhase;
+if((RSS = CurrentRSS()) <= 0)
+	return;
+AcquireLock();
+if(RSS > m_PeakRSS)
+	m_PeakRSS = RSS;
+pPhase = m_Phases;
+for(PhaseIdx = 0; PhaseIdx < m_NumPhases; PhaseIdx++, pPhase++)
+	if(pPhase->NumActive > 0 && RSS > pPhase->PeakRSS)
+		pPhase->PeakRSS = RSS;
+ReleaseLock();
+}
+
+#ifdef _WIN32
+unsigned __stdcall CRunProfile::SamplerThread(void *pPars)
+#else
+void *CRunProfile::SamplerThread(void *pPars)
+#endif
+{
+while(!m_bTermSampler)
+	{
+	SampleRSS();
+	CUtility::SleepMillisecs(cRunProfSampleMS);
+	}
+#ifdef _WIN32
+_endthreadex(0);
+return(0);
+#else
+pthread_exit(NULL);
+return(NULL);
+#endif
+}
+
+int
+CRunProfile::Enable(char *pszProfileFile,	// start profiling, run profile to be written to this file
+					char *pszProcess,		// profiling this process
+					char *pszSubProcess)	// and subprocess
+{
+if(m_bEnabled || pszProfileFile == NULL || pszProfileFile[0] == '\0')
+	return(eBSFerrParams);
+
+strncpy(m_szProfileFile,pszProfileFile,sizeof(m_szProfileFile)-1);
+m_szProfileFile[sizeof(m_szProfileFile)-1] = '\0';
+strncpy(m_szProcess,pszProcess == NULL ? "" : pszProcess,sizeof(m_szProcess)-1);
+m_szProcess[sizeof(m_szProcess)-1] = '\0';
+strncpy(m_szSubProcess,pszSubProcess == NULL ? "" : pszSubProcess,sizeof(m_szSubProcess)-1);
+m_szSubProcess[sizeof(m_szSubProcess)-1] = '\0';
+
+m_NumPhases = 0;
+m_NumActivePhases = 0;
+memset(m_Phases,0,sizeof(m_Phases));
+memset(m_Slots,0,sizeof(m_Slots));
+m_PeakRSS = CurrentRSS();
+m_StartWallSecs = WallSecs();
+m_StartCPUSecs = CPUSecs();
+
+m_bTermSampler = 0;
+#ifdef _WIN32
+m_hSampler = (HANDLE)_beginthreadex(NULL,0x0fffff,SamplerThread,NULL,0,NULL);
+m_bSamplerActive = m_hSampler != NULL;
+#else
+m_bSamplerActive = pthread_create(&m_SamplerID,NULL,SamplerThread,NULL) == 0;
+#endif
+if(!m_bSamplerActive)
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"Run profile: unable to start RSS sampler thread, phase peak RSS will only be sampled on phase entry and exit");
+m_bEnabled = true;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Run profile will be written to '%s'",m_szProfileFile);
+return(eBSFSuccess);
+}
+
+int
+CRunProfile::EnableFromEnv(char *pszProcess,	// start profiling if cpszRunProfileEnv environment variable names a profile file
+					char *pszSubProcess)
+{
+char *pszProfileFile;
+if((pszProfileFile = getenv(cpszRunProfileEnv)) == NULL || pszProfileFile[0] == '\0')
+	return(0);
+return(Enable(pszProfileFile,pszProcess,pszSubProcess));
+}
+
+int
+CRunProfile::BeginPhase(const char *pszPhase,	// enter this named phase
+					tsRunProfMark *pMark)		// phase entry mark to be passed to EndPhase()
+{
+int PhaseIdx;
+int64_t RSS;
+tsRunProfPhase *pPhase;
+if(!m_bEnabled)
+	return(-1);
+RSS = CurrentRSS();
+AcquireLock();
+pPhase = m_Phases;
+for(PhaseIdx = 0; PhaseIdx < m_NumPhases; PhaseIdx++, pPhase++)
+	if(!strncmp(pPhase->szName,pszPhase,cMaxRunProfPhaseNameLen))
+		break;
+if(PhaseIdx == m_NumPhases)
+	{
+	if(m_NumPhases == cMaxRunProfPhases)
+		{
+		ReleaseLock();
+		return(-1);
+		}
+	strncpy(pPhase->szName,pszPhase,cMaxRunProfPhaseNameLen);
+	pPhase->szName[cMaxRunProfPhaseNameLen] = '\0';
+	pPhase->Depth = m_NumActivePhases;
+	pPhase->StartRSS = RSS;
+	m_NumPhases += 1;
+	}
+pPhase->NumActive += 1;
+pPhase->NumEntered += 1;
+if(RSS > pPhase->PeakRSS)
+	pPhase->PeakRSS = RSS;
+m_NumActivePhases += 1;
+ReleaseLock();
+
+SumCounts(pMark->Counts);
+pMark->CPUSecs = CPUSecs();
+pMark->WallSecs = WallSecs();
+return(PhaseIdx);
+}
+
+void
+CRunProfile::EndPhase(int PhaseIdx,		// exit phase as returned by BeginPhase()
+					tsRunProfMark *pMark)	// phase entry mark
+{
+int Counter;
+double Wall;
+double CPU;
+int64_t RSS;
+int64_t Counts[eRPCNumCounters];
+tsRunProfPhase *pPhase;
+if(!m_bEnabled || PhaseIdx < 0 || PhaseIdx >= m_NumPhases)
+	return;
+Wall = WallSecs();
+CPU = CPUSecs();
+SumCounts(Counts);
+RSS = CurrentRSS();
+AcquireLock();
+pPhase = &m_Phases[PhaseIdx];
+pPhase->WallSecs += Wall - pMark->WallSecs;
+pPhase->CPUSecs += CPU - pMark->CPUSecs;
+for(Counter = 0; Counter < eRPCNumCounters; Counter++)
+	pPhase->Counts[Counter] += Counts[Counter] - pMark->Counts[Counter];
+pPhase->EndRSS = RSS;
+if(RSS > pPhase->PeakRSS)
+	pPhase->PeakRSS = RSS;
+if(pPhase->NumActive > 0)
+	pPhase->NumActive -= 1;
+if(m_NumActivePhases > 0)
+	m_NumActivePhases -= 1;
+ReleaseLock();
+}
+
+int
+CRunProfile::WriteJSON(int hFile)
+{
+int Len;
+int PhaseIdx;
+int Counter;
+int64_t Counts[eRPCNumCounters];
+tsRunProfPhase *pPhase;
+char szBuff[4096];
+
+SumCounts(Counts);
+Len = sprintf(szBuff,"{\n  \"process\": \"%s\",\n  \"subprocess\": \"%s\",\n  \"version\": \"%s\",\n",m_szProcess,m_szSubProcess,kit4bversion);
+Len += sprintf(&szBuff[Len],"  \"wall_secs\": %.3f,\n  \"cpu_secs\": %.3f,\n  \"peak_rss_bytes\": %zd,\n  \"max_rss_bytes\": %zd,\n  \"counter_threads\": %d,\n  \"counters\": {",
+			WallSecs() - m_StartWallSecs,CPUSecs() - m_StartCPUSecs,m_PeakRSS,MaxRSS(),min((int)m_NumSlots,cMaxRunProfSlots - 1));
+for(Counter = 0; Counter < eRPCNumCounters; Counter++)
+	Len += sprintf(&szBuff[Len],"%s\"%s\": %zd",Counter == 0 ? "" : ", ",RunProfCounterNames[Counter],Counts[Counter]);
+Len += sprintf(&szBuff[Len],"},\n  \"phases\": [");
+if(!CUtility::RetryWrites(hFile,szBuff,Len))
+	return(eBSFerrWrite);
+
+pPhase = m_Phases;
+for(PhaseIdx = 0; PhaseIdx < m_NumPhases; PhaseIdx++, pPhase++)
+	{
+	Len = sprintf(szBuff,"%s\n    {\"name\": \"%s\", \"depth\": %d, \"entered\": %zd, \"wall_secs\": %.3f, \"cpu_secs\": %.3f, \"start_rss_bytes\": %zd, \"end_rss_bytes\": %zd, \"peak_rss_bytes\": %zd, \"counters\": {",
+				PhaseIdx == 0 ? "" : ",",pPhase->szName,pPhase->Depth,pPhase->NumEntered,pPhase->WallSecs,pPhase->CPUSecs,pPhase->StartRSS,pPhase->EndRSS,pPhase->PeakRSS);
+	for(Counter = 0; Counter < eRPCNumCounters; Counter++)
+		Len += sprintf(&szBuff[Len],"%s\"%s\": %zd",Counter == 0 ? "" : ", ",RunProfCounterNames[Counter],pPhase->Counts[Counter]);
+	Len += sprintf(&szBuff[Len],"}}");
+	if(!CUtility::RetryWrites(hFile,szBuff,Len))
+		return(eBSFerrWrite);
+	}
+Len = sprintf(szBuff,"\n  ]\n}\n");
+if(!CUtility::RetryWrites(hFile,szBuff,Len))
+	return(eBSFerrWrite);
+return(eBSFSuccess);
+}
+
+int
+CRunProfile::WriteCSV(int hFile)
+{
+int Len;
+int PhaseIdx;
+int Counter;
+int64_t Counts[eRPCNumCounters];
+tsRunProfPhase *pPhase;
+char szBuff[4096];
+
+// one row for the run as a whole, with depth of -1, followed by a row for each phase
+Len = sprintf(szBuff,"\"Process\",\"SubProcess\",\"Phase\",\"Depth\",\"Entered\",\"WallSecs\",\"CPUSecs\",\"StartRSS\",\"EndRSS\",\"PeakRSS\"");
+for(Counter = 0; Counter < eRPCNumCounters; Counter++)
+	Len += sprintf(&szBuff[Len],",\"%s\"",RunProfCounterNames[Counter]);
+SumCounts(Counts);
+Len += sprintf(&szBuff[Len],"\n\"%s\",\"%s\",\"run\",-1,1,%.3f,%.3f,0,%zd,%zd",
+			m_szProcess,m_szSubProcess,WallSecs() - m_StartWallSecs,CPUSecs() - m_StartCPUSecs,CurrentRSS(),max(m_PeakRSS,MaxRSS()));
+for(Counter = 0; Counter < eRPCNumCounters; Counter++)
+	Len += sprintf(&szBuff[Len],",%zd",Counts[Counter]);
+Len += sprintf(&szBuff[Len],"\n");
+if(!CUtility::RetryWrites(hFile,szBuff,Len))
+	return(eBSFerrWrite);
+
+pPhase = m_Phases;
+for(PhaseIdx = 0; PhaseIdx < m_NumPhases; PhaseIdx++, pPhase++)
+	{
+	Len = sprintf(szBuff,"\"%s\",\"%s\",\"%s\",%d,%zd,%.3f,%.3f,%zd,%zd,%zd",
+				m_szProcess,m_szSubProcess,pPhase->szName,pPhase->Depth,pPhase->NumEntered,pPhase->WallSecs,pPhase->CPUSecs,pPhase->StartRSS,pPhase->EndRSS,pPhase->PeakRSS);
+	for(Counter = 0; Counter < eRPCNumCounters; Counter++)
+		Len += sprintf(&szBuff[Len],",%zd",pPhase->Counts[Counter]);
+	Len += sprintf(&szBuff[Len],"\n");
+	if(!CUtility::RetryWrites(hFile,szBuff,Len))
+		return(eBSFerrWrite);
+	}
+return(eBSFSuccess);
+}
+
+int
+CRunProfile::Report(void)		// stop profiling and write run profile to file
+{
+int Rslt;
+int hFile;
+size_t NameLen;
+if(!m_bEnabled)
+	return(0);
+
+if(m_bSamplerActive)
+	{
+	m_bTermSampler = 1;
+#ifdef _WIN32
+	WaitForSingleObject(m_hSampler,INFINITE);
+	CloseHandle(m_hSampler);
+	m_hSampler = NULL;
+#else
+	pthread_join(m_SamplerID,NULL);
+#endif
+	m_bSamplerActive = false;
+	}
+SampleRSS();
+m_bEnabled = false;
+
+#ifdef _WIN32
+hFile = open(m_szProfileFile,O_CREATETRUNC);
+#else
+if((hFile = open64(m_szProfileFile,O_WRONLY | O_CREAT,S_IREAD | S_IWRITE))!=-1)
+	if(ftruncate(hFile,0)!=0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Run profile: unable to truncate %s - %s",m_szProfileFile,strerror(errno));
+		close(hFile);
+		return(eBSFerrCreateFile);
+		}
+#endif
+if(hFile == -1)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Run profile: unable to create/truncate %s - %s",m_szProfileFile,strerror(errno));
+	return(eBSFerrCreateFile);
+	}
+
+NameLen = strlen(m_szProfileFile);
+if(NameLen > 4 && !stricmp(&m_szProfileFile[NameLen-4],".csv"))
+	Rslt = WriteCSV(hFile);
+else
+	Rslt = WriteJSON(hFile);
+#ifdef _WIN32
+_commit(hFile);
+#else
+fsync(hFile);
+#endif
+close(hFile);
+if(Rslt < eBSFSuccess)
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Run profile: errors writing to %s",m_szProfileFile);
+else
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Run profile written to '%s'",m_szProfileFile);
+return(Rslt);
+}
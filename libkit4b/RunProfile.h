@@ -0,0 +1,160 @@
+#pragma once
+// Process wide run profiling of named processing phase timings, work counters and resident memory (RSS)
+// Profiling is disabled by default and then Count() and CRunPhase reduce to a test of a static flag
+// When enabled, either by Enable() or by EnableFromEnv() with the cpszRunProfileEnv environment variable set to the profile file name, then
+// Report() writes the run profile as JSON, or as CSV if the profile file name has a '.csv' extension
+// Counters are accumulated into per-thread slots so worker threads never contend when counting
+// Phases are accumulated by name so a phase entered multiple times, e.g. once per chromosome, is reported once with the number of entries
+// Phase timings and counter increments are those between phase entry and exit, phase peak RSS is the maximum sampled, every cRunProfSampleMS
+// by a background thread, whilst the phase was active
+
+const char cpszRunProfileEnv[] = "KIT4B_PROFILE";	// environment variable naming the run profile file
+const int cMaxRunProfPhases = 256;				// at most this many uniquely named phases
+const int cMaxRunProfPhaseNameLen = 63;			// phase names truncated to at most this length
+const int cMaxRunProfSlots = 1024;				// at most this many per-thread counter slots, subsequent threads share slot 0
+const int cRunProfSampleMS = 100;				// RSS is sampled at this interval in milliseconds
+
+typedef enum TAG_eRunProfCounter {
+	eRPCReadsLoaded = 0,						// reads parsed and accepted for processing
+	eRPCReadsAligned,							// reads accepted as aligned
+	eRPCSeedsTried,								// alignment seeds, or cores, located in an index
+	eRPCSWCells,								// dynamic programming cells processed by Smith-Waterman or Needleman-Wunsch alignments
+	eRPCSWPrefilterCells,						// cells processed by score-only prefiltering before any Smith-Waterman alignment
+	eRPCBytesRead,								// bytes read from input files, compressed bytes if file is compressed
+	eRPCBytesInflated,							// bytes inflated from compressed input files
+	eRPCNumCounters								// placeholder, number of counters
+	} teRunProfCounter;
+
+#pragma pack(8)
+typedef struct TAG_sRunProfSlot {
+	int64_t Counts[eRPCNumCounters];			// counts accumulated by thread owning this slot
+	uint8_t Pad[64 - ((sizeof(int64_t) * eRPCNumCounters) % 64)];	// keep slots in separate cache lines
+	} tsRunProfSlot;
+
+typedef struct TAG_sRunProfMark {
+	double WallSecs;							// wall clock seconds at phase entry
+	double CPUSecs;								// process CPU seconds at phase entry
+	int64_t Counts[eRPCNumCounters];			// counter totals at phase entry
+	} tsRunProfMark;
+
+typedef struct TAG_sRunProfPhase {
+	char szName[cMaxRunProfPhaseNameLen + 1];	// phase name
+	int Depth;									// number of other phases active when this phase was first entered
+	int NumActive;								// number of current entries into this phase which have yet to exit
+	int64_t NumEntered;							// number of times phase has been entered
+	double WallSecs;							// accumulated wall clock seconds
+	double CPUSecs;								// accumulated process CPU seconds
+	int64_t StartRSS;							// RSS in bytes when first entered
+	int64_t EndRSS;								// RSS in bytes when last exited
+	int64_t PeakRSS;							// peak sampled RSS in bytes whilst active
+	int64_t Counts[eRPCNumCounters];			// accumulated counter increments whilst active
+	} tsRunProfPhase;
+#pragma pack()
+
+class CRunProfile
+{
+	static bool m_bEnabled;						// true if profiling
+	static char m_szProfileFile[_MAX_PATH];		// run profile to be written to this file
+	static char m_szProcess[_MAX_FNAME];		// profiling this process
+	static char m_szSubProcess[_MAX_FNAME];		// and subprocess
+	static double m_StartWallSecs;				// wall clock seconds when profiling was enabled
+	static double m_StartCPUSecs;				// process CPU seconds when profiling was enabled
+	static int64_t m_PeakRSS;					// peak sampled RSS in bytes
+
+	static volatile unsigned int m_CASLock;		// serialises access to phases
+	static int m_NumPhases;						// number of phases in m_Phases
+	static int m_NumActivePhases;				// number of phase entries yet to exit
+	static tsRunProfPhase m_Phases[cMaxRunProfPhases];	// phases in order of first entry
+
+	static volatile int m_NumSlots;				// number of per-thread slots claimed, slot 0 is shared by all threads after cMaxRunProfSlots claimed
+	static tsRunProfSlot m_Slots[cMaxRunProfSlots];	// per-thread counter slots
+
+	static volatile int m_bTermSampler;			// set to request sampler thread terminate
+	static bool m_bSamplerActive;				// true if sampler thread was started
+#ifdef _WIN32
+	static HANDLE m_hSampler;					// RSS sampler thread
+	static unsigned __stdcall SamplerThread(void *pPars);
+#else
+	static pthread_t m_SamplerID;				// RSS sampler thread
+	static void *SamplerThread(void *pPars);
+#endif
+
+	static void AcquireLock(void);				// serialise access to phases
+	static void ReleaseLock(void);
+	static void SumCounts(int64_t *pCounts);	// sum counts over all slots into pCounts[eRPCNumCounters]
+	static void SampleRSS(void);				// sample current RSS, updating peak RSS for run and all active phases
+	static void AddCount(teRunProfCounter Counter, int64_t Incr);	// accumulate into calling thread's slot
+	static int WriteJSON(int hFile);			// write profile as JSON
+	static int WriteCSV(int hFile);				// write profile as CSV
+
+public:
+	static double WallSecs(void);				// monotonic wall clock seconds
+	static double CPUSecs(void);				// process user + system CPU seconds
+	static int64_t CurrentRSS(void);			// current process RSS in bytes, 0 if unknown
+	static int64_t MaxRSS(void);				// process high water RSS in bytes, 0 if unknown
+
+	static int Enable(char *pszProfileFile,		// start profiling, run profile to be written to this file
+					char *pszProcess,			// profiling this process
+					char *pszSubProcess);		// and subprocess
+
+	static int EnableFromEnv(char *pszProcess,	// start profiling if cpszRunProfileEnv environment variable names a profile file; returns 0 if not enabled
+					char *pszSubProcess);
+
+	static int Report(void);					// stop profiling and write run profile to file; returns eBSFSuccess, or 0 if profiling was not enabled
+
+	static inline bool Enabled(void)			// true if profiling
+		{
+		return(m_bEnabled);
+		}
+
+	static inline void Count(teRunProfCounter Counter,	// increment this counter
+					int64_t Incr)				// by this amount
+		{
+		if(m_bEnabled)
+			AddCount(Counter, Incr);
+		}
+
+	static int BeginPhase(const char *pszPhase,	// enter this named phase; returns phase index, or -1 if not profiling
+					tsRunProfMark *pMark);		// phase entry mark to be passed to EndPhase()
+	static void EndPhase(int PhaseIdx,			// exit phase as returned by BeginPhase()
+					tsRunProfMark *pMark);		// phase entry mark
+};
+
+// Scoped phase, any phase active on an instance is exited when the instance goes out of scope or when Begin() enters the next phase
+class CRunPhase
+{
+	int m_PhaseIdx;								// currently active phase, -1 if none
+	tsRunProfMark m_Mark;						// currently active phase entry mark
+
+public:
+	CRunPhase(void)
+		{
+		m_PhaseIdx = -1;
+		}
+	CRunPhase(const char *pszPhase)
+		{
+		m_PhaseIdx = -1;
+		Begin(pszPhase);
+		}
+	~CRunPhase(void)
+		{
+		End();
+		}
+
+	inline void Begin(const char *pszPhase)		// exit any active phase and enter this named phase
+		{
+		if(m_PhaseIdx >= 0)
+			End();
+		if(CRunProfile::Enabled())
+			m_PhaseIdx = CRunProfile::BeginPhase(pszPhase, &m_Mark);
+		}
+
+	inline void End(void)						// exit any active phase
+		{
+		if(m_PhaseIdx >= 0)
+			{
+			CRunProfile::EndPhase(m_PhaseIdx, &m_Mark);
+			m_PhaseIdx = -1;
+			}
+		}
+};
@@ -84,6 +84,7 @@ m_pRefSeqs = NULL;
 m_pBAIChunks = NULL;
 m_pChunkBins = NULL;
 m_p16KOfsVirtAddrs = NULL;
+m_pProvVARanges = NULL;
 Reset(false);
 }
 
@@ -198,6 +199,14 @@ if(m_pRefSeqs != NULL)
 	m_pRefSeqs = NULL;
 	}
 
+if(m_pProvVARanges != NULL)
+	{
+	free(m_pProvVARanges);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
+	m_pProvVARanges = NULL;
+	}
+m_NumProvVARanges = 0;
+m_AllocProvVARanges = 0;
+
 m_ComprLev = 0;
 m_AllocBAMSize = 0;
 m_CurBAMLen = 0;
@@ -364,7 +373,8 @@ return(SAMType);
 
 
 int					// open and initiate processing for SAM/BAM reads processing
-CSAMfile::Open(char *pszSAMFile)	// SAM(gz) or BAM file name
+CSAMfile::Open(char *pszSAMFile,	// SAM(gz) or BAM file name
+				int NumThreads)		// if BAM then BGZF inflate using this many threads
 {
 if(pszSAMFile == NULL || pszSAMFile[0] == '\0')
 	return(eBSFerrParams);
@@ -437,6 +447,8 @@ if(m_SAMFileType >= eSFTBAM)
 		return(eBSFerrOpnFile);
 		}
 	m_hInSAMfile = -1;
+	if(NumThreads > 1 && bgzf_mt(m_pInBGZF,NumThreads,cBGZFMTSubBlks) != 0)
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Open: unable to initialise for multithreaded BGZF processing on file '%s', continuing single threaded",m_szSAMfileName);
 
 	// try reading the header, bgzf_read will confirm it does start with "BAM\1" ....
 	if((m_CurBAMLen = (int)bgzf_read(m_pInBGZF,m_pBAM,100)) < 100)		// will be -1 if errors ...
@@ -1477,7 +1489,8 @@ int										// create and initiate processing for SAM or BAM - with optional in
 CSAMfile::Create(eSAMFileType SAMType,	// file type, expected to be either eSFTSAM or eSFTBAM_BAI or eSFTBAM_CSI 
 				char *pszSAMFile,		// SAM(gz) or BAM file name
 				int ComprLev,			// if BAM then BGZF compress at this requested level (0..9)
-				char *pszVer)			// version text to use in generated SAM/BAM headers - if NULL then defaults to cszProgVer
+				char *pszVer,			// version text to use in generated SAM/BAM headers - if NULL then defaults to cszProgVer
+				int NumThreads)			// if BAM then BGZF compress using this many threads
 {
 if(SAMType < eSFTSAM || SAMType > eSFTBAM_CSI || pszSAMFile == NULL || pszSAMFile[0] == '\0')
 	return(eBSFerrParams);
@@ -1604,6 +1617,8 @@ if(SAMType >= eSFTBAM)
 		return(eBSFerrMem);
 		}
 	m_hOutSAMfile = -1;
+	if(NumThreads > 1 && bgzf_mt(m_pBGZF,NumThreads,cBGZFMTSubBlks) != 0)
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Create: unable to initialise for multithreaded BGZF compression on file '%s', continuing single threaded",m_szSAMfileName);
 	m_pBAM[0] = (uint8_t)'B';
 	m_pBAM[1] = (uint8_t)'A';
 	m_pBAM[2] = (uint8_t)'M';
@@ -1906,6 +1921,30 @@ if(m_CurBAILen == 0 || m_SAMFileType < eSFTBAM_BAI)
 if((m_hOutBAIfile == -1 && m_SAMFileType == eSFTBAM_BAI) || (m_pgzOutCSIfile == NULL && m_SAMFileType == eSFTBAM_CSI) || m_pBAI == NULL)
 	return(eBSFerrFileClosed);
 
+// if multithreaded BGZF then index virtual addresses are provisional, all referenced blocks will have been queued so
+// write the queued blocks and then resolve - the block currently being filled resolves to the current file length
+if(m_NumProvVARanges > 0)
+	{
+	uint32_t RangeIdx;
+	uint32_t VAIdx;
+	uint64_t *pVA;
+	tsProvVARange *pRange;
+	if(bgzf_mt_flush_queued(m_pBGZF) != 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"WriteIdxToDisk: write to '%s' failed",m_szSAMfileName);
+		Reset();
+		return(eBSFerrWrite);
+		}
+	pRange = m_pProvVARanges;
+	for(RangeIdx = 0; RangeIdx < m_NumProvVARanges; RangeIdx++,pRange++)
+		{
+		pVA = (uint64_t *)&m_pBAI[pRange->Ofs];
+		for(VAIdx = 0; VAIdx < pRange->NumVAs; VAIdx++,pVA++)
+			*pVA = bgzf_mt_vaddr(m_pBGZF,*pVA);
+		}
+	m_NumProvVARanges = 0;
+	}
+
 if(m_SAMFileType == eSFTBAM_BAI)
 	{
 	if(!CUtility::RetryWrites(m_hOutBAIfile,m_pBAI,m_CurBAILen))
@@ -1939,6 +1978,8 @@ uint32_t *pSAI;
 tsBAIbin *pBAIbin;
 tsBAIChunk *pBAIChunks;
 
+// if multithreaded BGZF then virtual addresses are provisional until their blocks have been written, the offsets of these
+// provisional addresses are recorded and resolved when the index is written to disk so BAM blocks need not be flushed here
 if((m_CurBAILen + 1000) > m_AllocBAISize)
 	{
 	if((Rslt = WriteIdxToDisk()) < eBSFSuccess)
@@ -1963,6 +2004,8 @@ if(m_NumBinsWithChunks > 0)
 			pBAIChunks = &m_pBAIChunks[pBAIbin->FirstChunk];
 			if(m_SAMFileType == eSFTBAM_CSI)
 				{
+				if(m_pBGZF->mt != NULL && (Rslt = AddProvVARange((uint32_t)m_CurBAILen,1)) < eBSFSuccess)
+					return(Rslt);
 				*(uint64_t *)pSAI = pBAIbin->StartVA;
 				pSAI += 2;
 				m_CurBAILen += 8;
@@ -1971,6 +2014,8 @@ if(m_NumBinsWithChunks > 0)
 			m_CurBAILen += 4;
 			for(ChunkIdx =0;ChunkIdx < (int)pBAIbin->NumChunks;ChunkIdx++)
 				{
+				if(m_pBGZF->mt != NULL && (Rslt = AddProvVARange((uint32_t)m_CurBAILen,2)) < eBSFSuccess)
+					return(Rslt);
 				*(uint64_t *)pSAI = pBAIChunks->StartVA;
 				pSAI += 2;
 				*(uint64_t *)pSAI = pBAIChunks->EndVA;
@@ -2000,6 +2045,8 @@ if(m_NumBinsWithChunks > 0)
 		{
 		*pSAI++ = m_NumOf16Kbps;
 		m_CurBAILen += 4;
+		if(m_pBGZF->mt != NULL && m_NumOf16Kbps > 0 && (Rslt = AddProvVARange((uint32_t)m_CurBAILen,m_NumOf16Kbps)) < eBSFSuccess)
+			return(Rslt);
 		memcpy(pSAI,m_p16KOfsVirtAddrs,m_NumOf16Kbps * sizeof(uint64_t));
 		pSAI += m_NumOf16Kbps * 2;
 		m_CurBAILen += m_NumOf16Kbps * sizeof(uint64_t);
@@ -2021,6 +2068,39 @@ if(bFinal || (m_CurBAILen + 1000) > m_AllocBAISize)
 return(eBSFSuccess);
 }
 
+// AddProvVARange
+// Record a range of provisional virtual addresses in m_pBAI which are to be resolved when the index is written to disk
+int
+CSAMfile::AddProvVARange(uint32_t Ofs,		// m_pBAI byte offset of first provisional virtual address
+					uint32_t NumVAs)		// number of consecutive provisional virtual addresses
+{
+tsProvVARange *pRange;
+if(m_NumProvVARanges > 0)						// extend previous range if contiguous
+	{
+	pRange = &m_pProvVARanges[m_NumProvVARanges-1];
+	if((pRange->Ofs + (pRange->NumVAs * sizeof(uint64_t))) == Ofs)
+		{
+		pRange->NumVAs += NumVAs;
+		return(eBSFSuccess);
+		}
+	}
+if(m_pProvVARanges == NULL || m_NumProvVARanges == m_AllocProvVARanges)
+	{
+	if((pRange = (tsProvVARange *)realloc(m_pProvVARanges,sizeof(tsProvVARange) * (m_AllocProvVARanges + cAllocProvVARanges))) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"AddProvVARange: Memory re-allocation to %zd bytes - %s",sizeof(tsProvVARange) * (m_AllocProvVARanges + cAllocProvVARanges),strerror(errno));
+		Reset();
+		return(eBSFerrMem);
+		}
+	m_pProvVARanges = pRange;
+	m_AllocProvVARanges += cAllocProvVARanges;
+	}
+pRange = &m_pProvVARanges[m_NumProvVARanges++];
+pRange->Ofs = Ofs;
+pRange->NumVAs = NumVAs;
+return(eBSFSuccess);
+}
+
 int
 CSAMfile::AddChunk(uint64_t StartVA,		// start alignment BAM record is at this virtual address
 				uint32_t Start,			// chunk starts at this loci
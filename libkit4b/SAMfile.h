@@ -31,6 +31,8 @@ const size_t cMaxCSIRefSeqLen = 0x7fffffff; // CSI indexes have no inherient lim
 
 const int cMaxRptSAMSeqsThres = 10000;	// default number of chroms to report if SAM output
 const int cDfltComprLev = 6;			// default compression level if BAM output
+const int cAllocProvVARanges = 10000;		// allocate provisional virtual address ranges in increments of this many ranges
+const int cBGZFMTSubBlks = 64;			// if multithreaded BGZF then each thread processes batches of this many blocks
 
 const size_t cAllocBAMSize = (size_t)0x003ffffff;	// initial allocation for  to hold BAM header which includes the sequence names + sequence lengths
 const size_t cAllocSAMSize = (size_t)0x01fffffff;	// initial allocation for holding SAM header and subsequently the alignments 
@@ -132,6 +134,11 @@ typedef struct TAG_sBAIbin {
 	uint64_t StartVA;			// first overlapping start alignment BAM record is at this virtual address
 	} tsBAIbin;
 
+typedef struct TAG_sProvVARange {
+	uint32_t Ofs;				// m_pBAI byte offset at which the first of a range of provisional virtual addresses is located
+	uint32_t NumVAs;			// number of consecutive provisional virtual addresses in this range
+	} tsProvVARange;
+
 #pragma pack()
 
 
@@ -178,6 +185,9 @@ class CSAMfile
 	uint32_t m_NumOf16Kbps;					// number of virtual addresses in m_p16KOfsVirtAddrs 
 	size_t m_Alloc16KOfsVirtAddrsSize;       // currently allocated size, in bytes, of m_p16KOfsVirtAddrs 
 	uint64_t *m_p16KOfsVirtAddrs;				// allocated to hold SAI 16Kbp linear virtual addresses
+	uint32_t m_NumProvVARanges;				// number of ranges of provisional virtual addresses currently in m_pBAI
+	uint32_t m_AllocProvVARanges;				// m_pProvVARanges allocated to hold this many ranges
+	tsProvVARange *m_pProvVARanges;			// if multithreaded BGZF then ranges of m_pBAI virtual addresses which are provisional until resolved in WriteIdxToDisk()
 
 	gzFile m_gzInSAMfile;					// input when reading SAM as gzip
 	int m_hInSAMfile;						// file handle used when reading SAM file
@@ -240,6 +250,8 @@ class CSAMfile
 	
 	int WriteIdxToDisk(void);				 // write index to disk, returns number of bytes written, can be 0 if none attempted to be written, < 0 if errors
 	int UpdateSAIIndex(bool bFinal = false); // alignments to current sequence completed, update SAI file with bins/chunks for this sequence
+	int AddProvVARange(uint32_t Ofs,		// m_pBAI byte offset of first provisional virtual address
+					uint32_t NumVAs);		// number of consecutive provisional virtual addresses
 
 	static char *TrimWhitespace(char *pTxt);	// trim whitespace
 
@@ -263,7 +275,8 @@ public:
 			  int32_t *pEstScoreSchema);		// currently will always return 0: no scoring 
 
 	int										// open and initiate processing for SAM/BAM reads processing
-		Open(char *pszSAMFile);				// expected to be a SAM(gz) or if extension '.BAM' then a BAM file
+		Open(char *pszSAMFile,				// expected to be a SAM(gz) or if extension '.BAM' then a BAM file
+			int NumThreads = 1);			// if BAM then BGZF inflate using this many threads
 
 
 	uint32_t
@@ -301,7 +314,8 @@ public:
 		Create(eSAMFileType SAMType,		// file type, expected to be either eSFTSAM or eSFTBAM_BAI or eSFTBAM_CSI 
 				char *pszSAMFile,			// SAM(gz) or BAM file name
 				int ComprLev = cDfltComprLev,	// if BAM then BGZF compress at this requested level (0..9)
-				char *pszVer = NULL);		// version text to use in generated SAM/BAM headers - if NULL then defaults to cszProgVer
+				char *pszVer = NULL,		// version text to use in generated SAM/BAM headers - if NULL then defaults to cszProgVer
+				int NumThreads = 1);		// if BAM then BGZF compress using this many threads
 
 		// reference sequence names are expected to be presorted in seqname ascending alpha order and then AddRefSeq'd in that ascending order
 	int AddRefSeq(char *pszSpecies,			// sequence from this species
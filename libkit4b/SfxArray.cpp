@@ -40,6 +40,8 @@ static int QSortSeqCmp32(const void *p1,const void *p2);
 static int QSortSeqCmp40(const void *p1,const void *p2);
 static int QSortEntryNames(const void *p1,const void *p2);
 
+etSfxLoadMode CSfxArray::m_DfltLoadMode = eSfxLoadRead;	// suffix blocks loaded with this mode unless SetLoadMode() called on instance
+
 static uint8_t *gpSfxArray = NULL;
 static etSeqBase *gpSeq = NULL;
 
@@ -69,6 +71,16 @@ m_pBisulfateBases = NULL;
 m_pOccKMerClas = NULL;
 m_pCoreKMers = NULL;
 m_pKMerCntDist = NULL;
+m_pMappedSfx = NULL;
+m_MappedSfxLen = 0;
+m_PfxIdxLen = 0;
+m_pPfxIdx = NULL;
+m_pPfxIdxMem = NULL;
+m_PfxIdxMemLen = 0;
+m_bPfxIdxMapped = false;
+m_bPfxIdxChkd = false;
+m_pPfxIdxEnds = NULL;
+m_LoadMode = m_DfltLoadMode;
 m_hFile = -1;
 m_bThreadActive = false;
 m_AllocSfxBlockMem = 0;
@@ -152,8 +164,11 @@ if(m_pSfxBlock != NULL)
 #ifdef _WIN32
 	free(m_pSfxBlock);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
 #else
-	if(m_pSfxBlock != MAP_FAILED)
-		munmap(m_pSfxBlock,m_AllocSfxBlockMem);
+	if(m_pMappedSfx != NULL)		// if file was memory mapped then m_pSfxBlock points into that mapping
+		munmap(m_pMappedSfx,m_MappedSfxLen);
+	else
+		if(m_pSfxBlock != MAP_FAILED)
+			munmap(m_pSfxBlock,m_AllocSfxBlockMem);
 #endif
 	}
 
@@ -197,6 +212,8 @@ if(m_pCoreKMers != NULL)
 #endif
 	}
 
+ReleasePfxIdx();
+
 if(m_hFile != -1)
 	close(m_hFile);
 
@@ -247,11 +264,16 @@ if(m_pSfxBlock != NULL)
 #ifdef _WIN32
 	free(m_pSfxBlock);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
 #else
-	if(m_pSfxBlock != MAP_FAILED)
-		munmap(m_pSfxBlock,m_AllocSfxBlockMem);
+	if(m_pMappedSfx != NULL)		// if file was memory mapped then m_pSfxBlock points into that mapping
+		munmap(m_pMappedSfx,m_MappedSfxLen);
+	else
+		if(m_pSfxBlock != MAP_FAILED)
+			munmap(m_pSfxBlock,m_AllocSfxBlockMem);
 #endif
 	m_pSfxBlock = NULL;
 	}
+m_pMappedSfx = NULL;
+m_MappedSfxLen = 0;
 
 if(m_pEntriesBlock != NULL)
 	{
@@ -297,6 +319,8 @@ if (m_pCoreKMers != NULL)
 	m_pCoreKMers = NULL;
 	}
 
+ReleasePfxIdx();
+
 m_MaxKMerCnts = 0;
 m_pKMerCntDist = NULL;
 m_CASSeqFlags = 0;
@@ -328,6 +352,18 @@ return(eBSFSuccess);
 }
 
 
+void
+CSfxArray::SetDfltLoadMode(etSfxLoadMode LoadMode)	// sets the load mode for subsequently instantiated CSfxArray's
+{
+m_DfltLoadMode = LoadMode;
+}
+
+void
+CSfxArray::SetLoadMode(etSfxLoadMode LoadMode)		// sets the load mode to be used when this instance subsequently opens an existing suffix file
+{
+m_LoadMode = LoadMode;
+}
+
 void
 CSfxArray::SetMaxQSortThreads(int MaxThreads)			// sets maximum number of threads to use in multithreaded qsorts
 {
@@ -504,10 +540,14 @@ uint8_t *pBases;
 uint64_t Idx;
 
 uint64_t WrtLen;
+int64_t SfxArrayBytes;
+int64_t SfxBlockSize;
 // only need to write if something to write!
 if(m_pSfxBlock == NULL || m_pSfxBlock->BlockID == 0 || m_pSfxBlock->ConcatSeqLen == 0 || m_pSfxBlock->NumEntries == 0)
 	return(eBSFSuccess);
 
+SfxArrayBytes = (int64_t)m_AllocSfxBlockMem - (int64_t)((uint8_t *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen] - (uint8_t *)m_pSfxBlock);
+
 // if bisulfite processing then need to map all occurences of eBaseT to be eBaseC, and all occurances of eBaseA to be eBaseG
 // do the sort, and then restore back to original values. Means that the memory requirements are greatly increased....
 //CSAIS SAIS;
@@ -533,20 +573,54 @@ if(m_bBisulfite)
 		TransformToColorspace(m_pSfxBlock->SeqSuffix,m_pSfxBlock->ConcatSeqLen,m_pSfxBlock->SeqSuffix);
 		}
 
-	QSortSeq((int64_t)m_pSfxBlock->ConcatSeqLen,m_pBisulfateBases,m_pSfxBlock->SfxElSize,(void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen]);
+	SortSeq((int64_t)m_pSfxBlock->ConcatSeqLen,m_pBisulfateBases,m_pSfxBlock->SfxElSize,(void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen],SfxArrayBytes);
 	}
 else
 	{
 	if(m_bColorspace)
 		TransformToColorspace(m_pSfxBlock->SeqSuffix,m_pSfxBlock->ConcatSeqLen,m_pSfxBlock->SeqSuffix);
-	QSortSeq(m_pSfxBlock->ConcatSeqLen,m_pSfxBlock->SeqSuffix,m_pSfxBlock->SfxElSize,(void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen]);
+	SortSeq(m_pSfxBlock->ConcatSeqLen,m_pSfxBlock->SeqSuffix,m_pSfxBlock->SfxElSize,(void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen],SfxArrayBytes);
+	}
+
+// release any extension which Flush2Disk() made for SA-IS 64bit indexes now that these have been packed into the suffix elements
+SfxBlockSize = (int64_t)sizeof(tsSfxBlock) + m_pSfxBlock->ConcatSeqLen + (m_pSfxBlock->ConcatSeqLen * m_pSfxBlock->SfxElSize) + cSAISAlignSlack;
+if((int64_t)m_AllocSfxBlockMem > SfxBlockSize)
+	{
+	tsSfxBlock *pRealloc;
+#ifdef _WIN32
+	pRealloc = (tsSfxBlock *)realloc(m_pSfxBlock,(size_t)SfxBlockSize);
+#else
+	pRealloc = (tsSfxBlock *)mremap(m_pSfxBlock,m_AllocSfxBlockMem,(size_t)SfxBlockSize,0);
+	if(pRealloc == MAP_FAILED)
+		pRealloc = NULL;
+#endif
+	if(pRealloc != NULL)		// if unable to shrink then can continue with the existing allocation
+		{
+		m_pSfxBlock = pRealloc;
+		m_AllocSfxBlockMem = SfxBlockSize;
+		}
 	}
 
 if (m_bColorspace)	// set hi nibbles of sequence to be original sequence
 	TransformToBasespace(m_pSfxBlock->SeqSuffix, m_pSfxBlock->ConcatSeqLen, m_pSfxBlock->SeqSuffix, true);
 
+// prefix index is generated whilst the sorted suffix block is resident, bisulfite suffix arrays are sorted on converted bases so are not prefix indexed
+// if not in-memory then prefix index is written to it's own file, and any previously existing prefix index file removed if no prefix index generated
+ReleasePfxIdx();
+if(!m_bBisulfite)
+	GenPfxIdx();
+m_bPfxIdxChkd = true;
+if (!m_bInMemSfx)
+	{
+	PfxIdx2Disk();
+	ReleasePfxIdx();
+	}
+
 if (!m_bInMemSfx)
 	{
+	// suffix block starts on a page boundary so that it can be memory mapped and used in place
+	m_SfxHeader.FileLen = (m_SfxHeader.FileLen + cSfxBlockAlign - 1) & ~((uint64_t)cSfxBlockAlign - 1);
+
 	// set block size and file offset for suffix block into header
 	m_SfxHeader.NumSfxBlocks = 1;
 	m_SfxHeader.SfxBlockSize = sizeof(tsSfxBlock) + m_pSfxBlock->ConcatSeqLen - 1 + ((size_t)m_pSfxBlock->ConcatSeqLen * m_pSfxBlock->SfxElSize);
@@ -893,6 +967,8 @@ CSfxArray::Flush2Disk(void)			// flush and commit to disk
 {
 teBSFrsltCodes Rslt;
 int64_t ReallocSize;
+int64_t SAISReallocSize;
+int64_t AvailMem;
 
 if (!m_bInMemSfx && m_hFile == -1)
 	return(eBSFSuccess);
@@ -908,7 +984,21 @@ if(m_pSfxBlock->ConcatSeqLen)
 	else
 		m_pSfxBlock->SfxElSize = 5;
 
-	ReallocSize = (int64_t)sizeof(tsSfxBlock) + m_pSfxBlock->ConcatSeqLen + (m_pSfxBlock->ConcatSeqLen * m_pSfxBlock->SfxElSize);
+	ReallocSize = (int64_t)sizeof(tsSfxBlock) + m_pSfxBlock->ConcatSeqLen + (m_pSfxBlock->ConcatSeqLen * m_pSfxBlock->SfxElSize) + cSAISAlignSlack;
+
+	// longer concatenations are SA-IS sorted with 64bit indexes generated in place, so the suffix elements are temporarily allocated at 8 bytes each
+	// and SfxBlock2Disk() releases the extension after packing; if the extension can't be backed by currently available physical memory then
+	// it is not made and SortSeq() uses the multithreaded qsort directly into the suffix elements
+	if((int64_t)m_pSfxBlock->ConcatSeqLen > cMaxSAIS32SeqLen)
+		{
+		SAISReallocSize = (int64_t)sizeof(tsSfxBlock) + m_pSfxBlock->ConcatSeqLen + (m_pSfxBlock->ConcatSeqLen * sizeof(int64_t)) + cSAISAlignSlack;
+		AvailMem = CUtility::AvailPhysMem();
+		if(SAISReallocSize - max(ReallocSize,(int64_t)m_AllocSfxBlockMem) <= AvailMem)
+			ReallocSize = SAISReallocSize;
+		else
+			gDiagnostics.DiagOut(eDLWarn,gszProcName,"Flush2Disk: SA-IS 64bit indexes would need %lld bytes more than the %lld bytes of physical memory available, suffix array will be sorted with multithreaded qsort",
+						SAISReallocSize - max(ReallocSize,(int64_t)m_AllocSfxBlockMem) - AvailMem,AvailMem);
+		}
 
 		// m_pSfxBlock almost certainly needs to be extended
 	if(ReallocSize > (int64_t)m_AllocSfxBlockMem) 
@@ -1054,6 +1144,18 @@ else // else opening existing file
 		return(eBSFerrFileAccess);
 		}
 
+#ifndef _WIN32
+	if(m_LoadMode != eSfxLoadRead)		// memory mapping the suffix block, no background readahead thread required
+		{
+		if((Rslt = MapSfxBlock()) != eBSFSuccess)
+			{
+			Reset(false);
+			return(Rslt);
+			}
+		return(eBSFSuccess);
+		}
+#endif
+
 	// allocate suffix block memory
 #ifdef _WIN32
 	m_pSfxBlock = (tsSfxBlock *) malloc((size_t)m_SfxHeader.SfxBlockSize);
@@ -1910,12 +2012,81 @@ pthread_exit(&pSfxArray->m_ReqBlockRslt);
 }
 
 
+#ifndef _WIN32
+// MapSfxBlock
+// Memory maps the suffix block read-only from the opened file, pages are shared through the page cache with any other processes mapping the same file
+// Mapping is copy-on-write so that any base flags subsequently set are private to this process
+teBSFrsltCodes
+CSfxArray::MapSfxBlock(void)
+{
+struct stat64 st;
+uint64_t MapOfs;
+long PageSize;
+int MapFlags;
+uint8_t *pMapped;
+
+if(m_hFile == -1 || m_SfxHeader.NumSfxBlocks != 1 || m_SfxHeader.SfxBlockSize < sizeof(tsSfxBlock))
+	{
+	AddErrMsg("CSfxArray::MapSfxBlock","No suffix block in file %s which can be mapped",m_szFile);
+	return(eBSFerrFileAccess);
+	}
+if(fstat64(m_hFile,&st) != 0 || (uint64_t)st.st_size < (m_SfxHeader.SfxBlockOfs + m_SfxHeader.SfxBlockSize))
+	{
+	AddErrMsg("CSfxArray::MapSfxBlock","File %s is truncated, expected at least %lld bytes",m_szFile,(int64_t)(m_SfxHeader.SfxBlockOfs + m_SfxHeader.SfxBlockSize));
+	return(eBSFerrFileAccess);
+	}
+
+// mappings must start on a page boundary, files created prior to the suffix block being page aligned are mapped from the preceding page
+PageSize = sysconf(_SC_PAGESIZE);
+if(PageSize <= 0)
+	PageSize = cSfxBlockAlign;
+MapOfs = m_SfxHeader.SfxBlockOfs - (m_SfxHeader.SfxBlockOfs % (uint64_t)PageSize);
+m_MappedSfxLen = (size_t)(m_SfxHeader.SfxBlockOfs + m_SfxHeader.SfxBlockSize - MapOfs);
+MapFlags = MAP_PRIVATE;
+if(m_LoadMode == eSfxLoadMmapPopulate)
+	MapFlags |= MAP_POPULATE;
+if((pMapped = (uint8_t *)mmap(NULL,m_MappedSfxLen,PROT_READ | PROT_WRITE,MapFlags,m_hFile,(off_t)MapOfs)) == MAP_FAILED)
+	{
+	AddErrMsg("CSfxArray::MapSfxBlock","Unable to memory map %zd bytes of suffix block from file %s - %s",m_MappedSfxLen,m_szFile,strerror(errno));
+	m_MappedSfxLen = 0;
+	return(eBSFerrMem);
+	}
+switch(m_LoadMode) {
+	case eSfxLoadMmap:			// accesses into suffix array are random so kernel readahead would be wasted
+		madvise(pMapped,m_MappedSfxLen,MADV_RANDOM);
+		break;
+	case eSfxLoadMmapWillNeed:	// kernel to start asynchronous readahead of all pages
+		madvise(pMapped,m_MappedSfxLen,MADV_WILLNEED);
+		break;
+	default:
+		break;
+	}
+m_pMappedSfx = pMapped;
+m_pSfxBlock = (tsSfxBlock *)(pMapped + (m_SfxHeader.SfxBlockOfs - MapOfs));
+m_AllocSfxBlockMem = 0;
+if(m_pSfxBlock->BlockID != 1 || m_pSfxBlock->ConcatSeqLen == 0 || !(m_pSfxBlock->SfxElSize == 4 || m_pSfxBlock->SfxElSize == 5))
+	{
+	AddErrMsg("CSfxArray::MapSfxBlock","Suffix block in file %s is inconsistent with file header",m_szFile);
+	return(eBSFerrFileAccess);
+	}
+return(eBSFSuccess);
+}
+#endif
+
 // Disk2SfxBlock
 teBSFrsltCodes
 CSfxArray::Disk2SfxBlock(int BlockID)
 {
 teBSFrsltCodes Rslt;
 
+if(m_pMappedSfx != NULL)		// if memory mapped then the only block is always available
+	{
+	if(!(BlockID == 1 && m_pSfxBlock->BlockID == 1))
+		return(eBSFerrParams);
+	if(!m_bPfxIdxChkd)
+		Disk2PfxIdx();
+	return(eBSFSuccess);
+	}
 
 if(m_pSfxBlock == NULL || !m_bThreadActive)
 	return(eBSFerrInternal);
@@ -1965,6 +2136,8 @@ ReleaseMutex(m_JobMutex);
 #else
 pthread_mutex_unlock(&m_JobMutex);
 #endif
+if(Rslt == eBSFSuccess && !m_bPfxIdxChkd)
+	Disk2PfxIdx();
 return(Rslt);
 }
 
@@ -2445,6 +2618,21 @@ pSeq = &m_pSfxBlock->SeqSuffix[pEntry->StartOfs];
 return(&pSeq[Loci]);
 }
 
+// GetLoadedSeqPtr
+// Returns a ptr to the start of the sequence at EntryID if that sequence is in the currently loaded suffix block
+// Unlike GetPtrSeq() a suffix block is never loaded so can be called concurrently by multiple threads
+etSeqBase *
+CSfxArray::GetLoadedSeqPtr(uint32_t EntryID)
+{
+tsSfxEntry *pEntry;
+if(m_pEntriesBlock == NULL || EntryID < 1 || EntryID > m_pEntriesBlock->NumEntries)
+	return(NULL);
+pEntry = &m_pEntriesBlock->Entries[EntryID-1];
+if(m_pSfxBlock == NULL || m_pSfxBlock->BlockID != (pEntry->fBlockID & 0x0ff))
+	return(NULL);
+return(&m_pSfxBlock->SeqSuffix[pEntry->StartOfs]);
+}
+
 
 // GetColorspaceSeq
 // Returns a copy of the requested subsequence in color space into pRetSeq from the
@@ -4916,6 +5104,7 @@ do
 		if((CurCoreSegOfs + CoreLen + CurCoreDelta) > ProbeLen)
 			CurCoreDelta = ProbeLen - (CurCoreSegOfs + CoreLen);
 
+		CRunProfile::Count(eRPCSeedsTried,1);
 		TargIdx = LocateFirstExact(&pProbeSeq[CurCoreSegOfs],CoreLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
 		if(TargIdx == 0)        // 0 if no core segment matches
 			continue;			// try for match on next core segment after shifting core to right
@@ -5347,6 +5536,7 @@ do
 		if ((CurCoreSegOfs + CoreLen + CurCoreDelta) > ProbeLen)
 			CurCoreDelta = ProbeLen - (CurCoreSegOfs + CoreLen);
 
+		CRunProfile::Count(eRPCSeedsTried,1);
 		TargIdx = LocateFirstExact(&pProbeSeq[CurCoreSegOfs], CoreLen, pTarg, m_pSfxBlock->SfxElSize, pSfxArray, 0, 0, SfxLen - 1);
 		if (TargIdx == 0)        // 0 if no core segment matches
 			continue;			// try for match on next core segment after shifting core to right
@@ -5961,6 +6151,7 @@ do
 		if (m_pOccKMerClas != NULL && CoreLen == m_OccKMerLen && (OverOccKMerClas(CoreLen, &pProbeSeq[CurCoreSegOfs]) != 1))	// 1 if number of K-mers of CoreLen is within range 1..max
 			continue;
 
+		CRunProfile::Count(eRPCSeedsTried,1);
 		TargIdx = LocateFirstExact(&pProbeSeq[CurCoreSegOfs],CoreLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
 		if(TargIdx == 0)        // 0 if no core segment matches
 			continue;			// try for match on next core segment after shifting core to right
@@ -6947,6 +7138,7 @@ do
 		if((CurCoreSegOfs + CoreLen + CurCoreDelta) > ProbeLen)
 			CurCoreDelta = ProbeLen - (CurCoreSegOfs + CoreLen);
 
+		CRunProfile::Count(eRPCSeedsTried,1);
 		TargIdx = LocateFirstExact(&pProbeSeq[CurCoreSegOfs],CoreLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
 		if(TargIdx == 0)        // 0 if no core segment matches
 			continue;			// try for match on next core segment after shifting core to right
@@ -7308,6 +7500,7 @@ do
 		if (m_pOccKMerClas != NULL && CoreLen == m_OccKMerLen && (OverOccKMerClas(CoreLen, &pProbeSeq[CurCoreSegOfs]) != 1))	// 1 if number of K-mers of CoreLen is within range 1..max
 			continue;
 
+		CRunProfile::Count(eRPCSeedsTried,1);
 		TargIdx = LocateFirstExact(&pProbeSeq[CurCoreSegOfs],CoreLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
 		if(TargIdx == 0)        // 0 if no core segment matches
 			continue;			// try for match on next core segment after shifting core to right
@@ -7620,6 +7813,7 @@ do
 		if (m_pOccKMerClas != NULL && CoreLen == m_OccKMerLen && (OverOccKMerClas(CoreLen, &pProbeSeq[CurCoreSegOfs]) != 1))	// 1 if number of K-mers of CoreLen is within range 1..max
 			continue;
 
+		CRunProfile::Count(eRPCSeedsTried,1);
 		TargIdx = LocateFirstExact(&pProbeSeq[CurCoreSegOfs],CoreLen,pTarg,m_pSfxBlock->SfxElSize,pSfxArray,0,0,SfxLen-1);
 		if(TargIdx == 0)        // 0 if no core segment matches
 			continue;			// try for match on next core segment after shifting core to right
@@ -7954,6 +8148,7 @@ int CmpRslt;
 int Ofs;
 int64_t Mark;
 int64_t TargPsn;
+int64_t NumPfxs;
 
 if(!bIgnoreKMerCores && ProbeLen == m_CoreKMerLen && m_pCoreKMers != NULL)
 	{
@@ -7962,6 +8157,21 @@ if(!bIgnoreKMerCores && ProbeLen == m_CoreKMerLen && m_pCoreKMers != NULL)
 	return(TargPsn);
 	}
 
+// if prefix indexed then the prefix interval bounds the search and all suffixes in the interval are known to match the probe prefix
+if(m_pPfxIdx != NULL && ProbeLen >= m_PfxIdxLen && TargStart == 0 && pSfxArray == (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen] &&
+		(NumPfxs = PfxInterval(pProbe,&TargPsn)) >= 0)
+	{
+	if(NumPfxs == 0)
+		return(0);
+	SfxLo = max(SfxLo,TargPsn);
+	SfxHi = min(SfxHi,TargPsn + NumPfxs - 1);
+	if(SfxLo > SfxHi)
+		return(0);
+	if(ProbeLen == m_PfxIdxLen)
+		return(SfxLo + 1);
+	return(LocateExactLCP(pProbe,ProbeLen,pTarg,SfxElSize,pSfxArray,SfxLo,SfxHi,m_PfxIdxLen,false));
+	}
+
 do {
 	pEl1 = pProbe;
 	TargPsn = ((int64_t)SfxLo + SfxHi) / 2L;
@@ -8245,6 +8455,7 @@ int64_t Mark;
 int64_t TargPsn;
 int64_t SfxHiMax = SfxHi;
 int64_t SfxLoMax = SfxLo;
+int64_t NumPfxs;
 
 if (!bIgnoreKMerCores && ProbeLen == m_CoreKMerLen && m_pCoreKMers != NULL)
 	{
@@ -8255,6 +8466,21 @@ if (!bIgnoreKMerCores && ProbeLen == m_CoreKMerLen && m_pCoreKMers != NULL)
 		return(0);
 	}
 
+// if prefix indexed then the prefix interval bounds the search and all suffixes in the interval are known to match the probe prefix
+if(m_pPfxIdx != NULL && ProbeLen >= m_PfxIdxLen && TargStart == 0 && pSfxArray == (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen] &&
+		(NumPfxs = PfxInterval(pProbe,&TargPsn)) >= 0)
+	{
+	if(NumPfxs == 0)
+		return(0);
+	SfxLo = max(SfxLo,TargPsn);
+	SfxHi = min(SfxHi,TargPsn + NumPfxs - 1);
+	if(SfxLo > SfxHi)
+		return(0);
+	if(ProbeLen == m_PfxIdxLen)
+		return(SfxHi + 1);
+	return(LocateExactLCP(pProbe,ProbeLen,pTarg,SfxElSize,pSfxArray,SfxLo,SfxHi,m_PfxIdxLen,true));
+	}
+
 do {
 	pEl1 = pProbe;
 	TargPsn = ((int64_t)SfxLo + SfxHi) / 2L;
@@ -8351,6 +8577,448 @@ return(0);	// unable to locate any instance of pProbe
 }
 
 
+// LocateExactLCP
+// Binary search within SfxLo..SfxHi for the first, or last, suffix exactly matching the probe
+// The lengths of the common prefixes between probe and the suffixes bounding the search are tracked so that each comparison can
+// start from the shorter of these lengths rather than from the first base, initially all suffixes are known to match MatchedLen bases
+int64_t			// index+1 in pSfxArray of first, or last, exactly matching probe or 0 if no match
+CSfxArray::LocateExactLCP(etSeqBase *pProbe,	// pts to probe sequence
+				  int ProbeLen,					// probe length to exactly match over
+				  etSeqBase *pTarg,				// target sequence
+				  int SfxElSize,				// size in bytes of suffix element - expected to be either 4 or 5
+				  void *pSfxArray,				// target sequence suffix array
+				  int64_t SfxLo,				// low index in pSfxArray
+				  int64_t SfxHi,				// high index in pSfxArray
+				  int MatchedLen,				// all suffixes in SfxLo..SfxHi are known to match the initial MatchedLen probe bases
+				  bool bLast)					// false to locate first, true to locate last, exactly matching
+{
+etSeqBase *pEl2;
+uint8_t El1;
+uint8_t El2;
+int CmpRslt;
+int Ofs;
+int LcpLo;
+int LcpHi;
+int64_t Lo;
+int64_t Hi;
+int64_t TargPsn;
+
+// Lo and Hi bound the search exclusively, initially these are virtual suffixes known to match MatchedLen bases
+Lo = SfxLo - 1;
+Hi = SfxHi + 1;
+LcpLo = MatchedLen;
+LcpHi = MatchedLen;
+while(Hi - Lo > 1)
+	{
+	TargPsn = Lo + ((Hi - Lo) / 2);
+	pEl2 = &pTarg[SfxOfsToLoci(SfxElSize,pSfxArray,TargPsn)];
+	CmpRslt = 0;
+	for(Ofs = min(LcpLo,LcpHi); Ofs < ProbeLen; Ofs++)
+		{
+		El2 = pEl2[Ofs] & 0x0f;
+		if(El2 == eBaseEOS)
+			{
+			CmpRslt = -1;
+			break;
+			}
+		El1 = pProbe[Ofs] & 0x0f;
+		if(El1 != El2)
+			{
+			CmpRslt = El1 > El2 ? 1 : -1;
+			break;
+			}
+		}
+	// locating first then search continues below any match, if locating last then search continues above any match
+	if(CmpRslt > 0 || (bLast && CmpRslt == 0))
+		{
+		Lo = TargPsn;
+		LcpLo = Ofs;
+		}
+	else
+		{
+		Hi = TargPsn;
+		LcpHi = Ofs;
+		}
+	}
+
+if(bLast)
+	return((Lo >= SfxLo && LcpLo == ProbeLen) ? Lo + 1 : 0);
+return((Hi <= SfxHi && LcpHi == ProbeLen) ? Hi + 1 : 0);
+}
+
+int
+CSfxArray::GetPfxIdxLen(void)			// returns prefix length of loaded prefix index, 0 if no prefix index loaded
+{
+return(m_pPfxIdx == NULL ? 0 : m_PfxIdxLen);
+}
+
+// PfxInterval
+// Returns the interval of suffix elements which start with the initial m_PfxIdxLen probe bases
+// Counts are saturated in the index so the end of the interval for very highly repetitive prefixes is located by binary search
+int64_t										// number of suffix elements starting with probe prefix, -1 if no prefix index or prefix not canonical
+CSfxArray::PfxInterval(etSeqBase *pProbe,	// probe, must be at least m_PfxIdxLen long
+				int64_t *pFirstIdx)			// returned first suffix element starting with probe prefix
+{
+int64_t Code;
+int64_t NumSfxs;
+int64_t LastIdx;
+uint64_t PfxIdx;
+
+if(m_pPfxIdx == NULL || (Code = PfxIdxCode(pProbe)) < 0)
+	return(-1);
+PfxIdx = m_pPfxIdx[Code];
+*pFirstIdx = (int64_t)(PfxIdx & 0x0ffffffffff);
+NumSfxs = (int64_t)(PfxIdx >> 40);
+if((uint64_t)NumSfxs == cSfxPfxIdxMaxCnt)
+	{
+	LastIdx = LocateExactLCP(pProbe,m_PfxIdxLen,m_pSfxBlock->SeqSuffix,m_pSfxBlock->SfxElSize,&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen],
+								*pFirstIdx + NumSfxs - 1,m_pSfxBlock->ConcatSeqLen - 1,0,true);
+	NumSfxs = LastIdx - *pFirstIdx;
+	}
+return(NumSfxs);
+}
+
+// PfxIdxCode
+// Prefixes are coded with the first base in the most significant bits so prefix codes are in the same order as the suffix array
+int64_t
+CSfxArray::PfxIdxCode(etSeqBase *pSeq)		// returns prefix index for initial m_PfxIdxLen bases of pSeq, -1 if any are not canonical
+{
+int Idx;
+etSeqBase Base;
+int64_t Code = 0;
+for(Idx = 0; Idx < m_PfxIdxLen; Idx++)
+	{
+	if((Base = *pSeq++ & 0x0f) > eBaseT)
+		return(-1);
+	Code = (Code << 2) | Base;
+	}
+return(Code);
+}
+
+// PfxIdxSampleHash
+// Hash over evenly spaced suffix elements so that a prefix index file can be checked as being consistent with the loaded suffix array
+uint64_t
+CSfxArray::PfxIdxSampleHash(void)
+{
+int Idx;
+uint64_t Hash;
+int64_t SfxLen;
+void *pSfxArray;
+
+SfxLen = (int64_t)m_pSfxBlock->ConcatSeqLen;
+pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[SfxLen];
+Hash = 0x0cbf29ce484222325 ^ (uint64_t)SfxLen;
+for(Idx = 0; Idx < cSfxPfxIdxSamples; Idx++)
+	{
+	Hash ^= (uint64_t)SfxOfsToLoci(m_pSfxBlock->SfxElSize,pSfxArray,((SfxLen - 1) * Idx) / (cSfxPfxIdxSamples - 1));
+	Hash *= 0x0100000001b3;
+	}
+return(Hash);
+}
+
+void
+CSfxArray::ReleasePfxIdx(void)
+{
+if(m_pPfxIdxMem != NULL)
+	{
+#ifdef _WIN32
+	free(m_pPfxIdxMem);
+#else
+	munmap(m_pPfxIdxMem,m_PfxIdxMemLen);		// either memory mapped from file or anonymous allocation
+#endif
+	m_pPfxIdxMem = NULL;
+	}
+if(m_pPfxIdxEnds != NULL)
+	{
+#ifdef _WIN32
+	free(m_pPfxIdxEnds);
+#else
+	munmap(m_pPfxIdxEnds,m_PfxIdxMemLen);
+#endif
+	m_pPfxIdxEnds = NULL;
+	}
+m_pPfxIdx = NULL;
+m_PfxIdxMemLen = 0;
+m_PfxIdxLen = 0;
+m_bPfxIdxMapped = false;
+m_bPfxIdxChkd = false;
+}
+
+static int SfxGenPfxIdxChunk(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CSfxArray *)pCtx)->GenPfxIdxChunk(StartIdx,EndIdx));
+}
+
+// GenPfxIdxChunk
+// Prefixes occupy contiguous suffix elements so only the elements at which the prefix changes are of interest
+// Each prefix start and end is seen by exactly one chunk so no serialisation is required
+int
+CSfxArray::GenPfxIdxChunk(int64_t StartIdx, int64_t EndIdx)
+{
+int64_t Idx;
+int64_t Code;
+int64_t PrevCode;
+int SfxElSize;
+etSeqBase *pTarg;
+void *pSfxArray;
+
+SfxElSize = m_pSfxBlock->SfxElSize;
+pTarg = m_pSfxBlock->SeqSuffix;
+pSfxArray = (void *)&m_pSfxBlock->SeqSuffix[m_pSfxBlock->ConcatSeqLen];
+PrevCode = StartIdx == 0 ? -1 : PfxIdxCode(&pTarg[SfxOfsToLoci(SfxElSize,pSfxArray,StartIdx - 1)]);
+for(Idx = StartIdx; Idx < EndIdx; Idx++)
+	{
+	Code = PfxIdxCode(&pTarg[SfxOfsToLoci(SfxElSize,pSfxArray,Idx)]);
+	if(Code != PrevCode)
+		{
+		if(Code >= 0)
+			m_pPfxIdx[Code] = (uint64_t)Idx;
+		if(PrevCode >= 0 && Idx > StartIdx)
+			m_pPfxIdxEnds[PrevCode] = Idx;
+		PrevCode = Code;
+		}
+	}
+if(PrevCode >= 0)
+	{
+	Code = EndIdx == (int64_t)m_pSfxBlock->ConcatSeqLen ? -1 : PfxIdxCode(&pTarg[SfxOfsToLoci(SfxElSize,pSfxArray,EndIdx)]);
+	if(Code != PrevCode)
+		m_pPfxIdxEnds[PrevCode] = EndIdx;
+	}
+return(eBSFSuccess);
+}
+
+// GenPfxIdx
+// Generate prefix index over the currently loaded, and sorted, suffix array
+// Prefix length is chosen such that there would be on average at least 16 suffixes per prefix
+teBSFrsltCodes
+CSfxArray::GenPfxIdx(void)
+{
+int Rslt;
+int PfxLen;
+int64_t Code;
+int64_t NumPfxs;
+int64_t NumSfxs;
+int64_t NumChunks;
+tsSfxPfxIdxHdr *pHdr;
+CWorkPool *pWorkPool;
+
+ReleasePfxIdx();
+if(m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0)
+	return(eBSFerrInternal);
+for(PfxLen = 0; PfxLen < cMaxSfxPfxIdxLen && ((uint64_t)0x01 << (2 * (PfxLen + 1) + 4)) <= m_pSfxBlock->ConcatSeqLen; PfxLen++);
+if(PfxLen < cMinSfxPfxIdxLen)
+	return(eBSFSuccess);
+
+NumPfxs = (int64_t)0x01 << (2 * PfxLen);
+m_PfxIdxMemLen = sizeof(tsSfxPfxIdxHdr) + (size_t)NumPfxs * sizeof(uint64_t);
+#ifdef _WIN32
+if((m_pPfxIdxMem = (uint8_t *)malloc(m_PfxIdxMemLen)) != NULL)
+	memset(m_pPfxIdxMem,0,m_PfxIdxMemLen);
+if((m_pPfxIdxEnds = (int64_t *)malloc(m_PfxIdxMemLen)) != NULL)
+	memset(m_pPfxIdxEnds,0,m_PfxIdxMemLen);
+#else
+if((m_pPfxIdxMem = (uint8_t *)mmap(NULL,m_PfxIdxMemLen,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0)) == MAP_FAILED)
+	m_pPfxIdxMem = NULL;
+if((m_pPfxIdxEnds = (int64_t *)mmap(NULL,m_PfxIdxMemLen,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0)) == MAP_FAILED)
+	m_pPfxIdxEnds = NULL;
+#endif
+if(m_pPfxIdxMem == NULL || m_pPfxIdxEnds == NULL)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"GenPfxIdx: Unable to allocate %zd bytes for prefix index, suffix array will not be prefix indexed",(int64_t)m_PfxIdxMemLen * 2);
+	ReleasePfxIdx();
+	return(eBSFerrMem);
+	}
+m_pPfxIdx = (uint64_t *)&m_pPfxIdxMem[sizeof(tsSfxPfxIdxHdr)];
+m_PfxIdxLen = PfxLen;
+
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"GenPfxIdx: Generating %d-mer prefix index over %lld suffixes ...",PfxLen,(int64_t)m_pSfxBlock->ConcatSeqLen);
+NumChunks = ((int64_t)m_pSfxBlock->ConcatSeqLen + cSfxPfxIdxChunk - 1) / cSfxPfxIdxChunk;
+if(m_MaxQSortThreads > 1 && NumChunks > 1 && (pWorkPool = CWorkPool::Shared(m_MaxQSortThreads)) != NULL)
+	Rslt = pWorkPool->ParallelFor((int64_t)m_pSfxBlock->ConcatSeqLen,cSfxPfxIdxChunk,SfxGenPfxIdxChunk,this,60,"Progress: generating prefix index",NULL,NULL,m_MaxQSortThreads);
+else
+	Rslt = GenPfxIdxChunk(0,(int64_t)m_pSfxBlock->ConcatSeqLen);
+if(Rslt < eBSFSuccess)
+	{
+	ReleasePfxIdx();
+	return((teBSFrsltCodes)Rslt);
+	}
+
+// pack suffix counts in with the prefix starts
+for(Code = 0; Code < NumPfxs; Code++)
+	{
+	if(m_pPfxIdxEnds[Code] == 0)
+		{
+		m_pPfxIdx[Code] = 0;
+		continue;
+		}
+	NumSfxs = m_pPfxIdxEnds[Code] - (int64_t)m_pPfxIdx[Code];
+	m_pPfxIdx[Code] |= (uint64_t)min((uint64_t)NumSfxs,cSfxPfxIdxMaxCnt) << 40;
+	}
+#ifdef _WIN32
+free(m_pPfxIdxEnds);
+#else
+munmap(m_pPfxIdxEnds,m_PfxIdxMemLen);
+#endif
+m_pPfxIdxEnds = NULL;
+
+pHdr = (tsSfxPfxIdxHdr *)m_pPfxIdxMem;
+pHdr->Magic[0] = 's';
+pHdr->Magic[1] = 'f';
+pHdr->Magic[2] = 'x';
+pHdr->Magic[3] = 'p';
+pHdr->Version = cSfxPfxIdxVersion;
+pHdr->PrefixLen = PfxLen;
+pHdr->SfxElSize = m_pSfxBlock->SfxElSize;
+pHdr->ConcatSeqLen = m_pSfxBlock->ConcatSeqLen;
+pHdr->NumPrefixes = (uint64_t)NumPfxs;
+pHdr->SampleHash = PfxIdxSampleHash();
+m_bPfxIdxChkd = true;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"GenPfxIdx: Completed prefix index generation");
+return(eBSFSuccess);
+}
+
+// PfxIdx2Disk
+// Prefix index is written to it's own file so suffix array files remain readable by previous releases
+teBSFrsltCodes
+CSfxArray::PfxIdx2Disk(void)
+{
+int hFile;
+int WrtLen;
+size_t Ofs;
+char szPfxFile[_MAX_PATH + 10];
+
+if(m_szFile[0] == '\0')
+	return(eBSFerrParams);
+sprintf(szPfxFile,"%s%s",m_szFile,cpszSfxPfxIdxExtn);
+remove(szPfxFile);
+if(m_pPfxIdx == NULL)
+	return(eBSFSuccess);
+
+#ifdef _WIN32
+hFile = open(szPfxFile,O_CREATETRUNC);
+#else
+if((hFile = open64(szPfxFile,O_WRONLY | O_CREAT,S_IREAD | S_IWRITE)) != -1)
+	{
+	if(ftruncate(hFile,0) != 0)
+		{
+		close(hFile);
+		hFile = -1;
+		}
+	}
+#endif
+if(hFile == -1)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"PfxIdx2Disk: Unable to create prefix index file '%s' - %s",szPfxFile,strerror(errno));
+	return(eBSFerrCreateFile);
+	}
+for(Ofs = 0; Ofs < m_PfxIdxMemLen; Ofs += WrtLen)
+	{
+	WrtLen = (int)min(m_PfxIdxMemLen - Ofs,(size_t)0x040000000);
+	if(write(hFile,&m_pPfxIdxMem[Ofs],WrtLen) != WrtLen)
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"PfxIdx2Disk: Write to prefix index file '%s' failed - %s",szPfxFile,strerror(errno));
+		close(hFile);
+		remove(szPfxFile);
+		return(eBSFerrWrite);
+		}
+	}
+close(hFile);
+return(eBSFSuccess);
+}
+
+// Disk2PfxIdx
+// Loads the prefix index generated at the same time as the suffix array, memory mapping if not Windows
+// Suffix arrays are usable without a prefix index so any inconsistent or missing prefix index is not treated as an error
+teBSFrsltCodes
+CSfxArray::Disk2PfxIdx(void)
+{
+int hFile;
+#ifdef _WIN32
+int RdLen;
+size_t Ofs;
+#endif
+int64_t FileLen;
+tsSfxPfxIdxHdr Hdr;
+char szPfxFile[_MAX_PATH + 10];
+teBSFrsltCodes Rslt;
+
+SerialiseBaseFlags();
+if(m_bPfxIdxChkd)
+	{
+	ReleaseBaseFlags();
+	return(eBSFSuccess);
+	}
+ReleasePfxIdx();
+m_bPfxIdxChkd = true;
+if(m_bBisulfite || m_szFile[0] == '\0' || m_pSfxBlock == NULL || m_pSfxBlock->ConcatSeqLen == 0)
+	{
+	ReleaseBaseFlags();
+	return(eBSFSuccess);
+	}
+sprintf(szPfxFile,"%s%s",m_szFile,cpszSfxPfxIdxExtn);
+if((hFile = open(szPfxFile,O_READSEQ)) == -1)
+	{
+	ReleaseBaseFlags();
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Disk2PfxIdx: No prefix index file '%s', suffix array will be searched without prefix index",szPfxFile);
+	return(eBSFSuccess);
+	}
+
+Rslt = eBSFerrFileAccess;
+FileLen = (int64_t)_lseeki64(hFile,0,SEEK_END);
+_lseeki64(hFile,0,SEEK_SET);
+if(read(hFile,&Hdr,sizeof(Hdr)) == sizeof(Hdr) &&
+		Hdr.Magic[0] == 's' && Hdr.Magic[1] == 'f' && Hdr.Magic[2] == 'x' && Hdr.Magic[3] == 'p' && Hdr.Version == cSfxPfxIdxVersion &&
+		Hdr.PrefixLen >= cMinSfxPfxIdxLen && Hdr.PrefixLen <= cMaxSfxPfxIdxLen && Hdr.NumPrefixes == ((uint64_t)0x01 << (2 * Hdr.PrefixLen)) &&
+		Hdr.SfxElSize == (int32_t)m_pSfxBlock->SfxElSize && Hdr.ConcatSeqLen == m_pSfxBlock->ConcatSeqLen &&
+		FileLen == (int64_t)(sizeof(Hdr) + Hdr.NumPrefixes * sizeof(uint64_t)) && Hdr.SampleHash == PfxIdxSampleHash())
+	{
+	m_PfxIdxMemLen = (size_t)FileLen;
+#ifdef _WIN32
+	if((m_pPfxIdxMem = (uint8_t *)malloc(m_PfxIdxMemLen)) != NULL)
+		{
+		memcpy(m_pPfxIdxMem,&Hdr,sizeof(Hdr));
+		for(Ofs = sizeof(Hdr); Ofs < m_PfxIdxMemLen; Ofs += RdLen)
+			{
+			RdLen = (int)min(m_PfxIdxMemLen - Ofs,(size_t)0x040000000);
+			if(read(hFile,&m_pPfxIdxMem[Ofs],RdLen) != RdLen)
+				break;
+			}
+		if(Ofs == m_PfxIdxMemLen)
+			Rslt = eBSFSuccess;
+		}
+	else
+		Rslt = eBSFerrMem;
+#else
+	if((m_pPfxIdxMem = (uint8_t *)mmap(NULL,m_PfxIdxMemLen,PROT_READ,MAP_SHARED | (m_LoadMode == eSfxLoadMmapPopulate ? MAP_POPULATE : 0),hFile,0)) == MAP_FAILED)
+		{
+		m_pPfxIdxMem = NULL;
+		Rslt = eBSFerrMem;
+		}
+	else
+		{
+		madvise(m_pPfxIdxMem,m_PfxIdxMemLen,m_LoadMode == eSfxLoadMmapWillNeed ? MADV_WILLNEED : MADV_RANDOM);
+		m_bPfxIdxMapped = true;
+		Rslt = eBSFSuccess;
+		}
+#endif
+	}
+close(hFile);
+
+if(Rslt != eBSFSuccess)
+	{
+	ReleasePfxIdx();
+	m_bPfxIdxChkd = true;
+	ReleaseBaseFlags();
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"Disk2PfxIdx: Prefix index file '%s' could not be loaded or is inconsistent with suffix array, suffix array will be searched without prefix index",szPfxFile);
+	return(Rslt);
+	}
+m_PfxIdxLen = Hdr.PrefixLen;
+m_pPfxIdx = (uint64_t *)&m_pPfxIdxMem[sizeof(tsSfxPfxIdxHdr)];
+ReleaseBaseFlags();
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Disk2PfxIdx: Loaded %d-mer prefix index from '%s'",m_PfxIdxLen,szPfxFile);
+return(eBSFSuccess);
+}
+
 int CSfxArray::CompareExtdMatches( const void *arg1, const void *arg2 )
 {
 tsSfxMatch *pEl1 = (tsSfxMatch *)arg1;
@@ -9774,6 +10442,78 @@ switch(SfxElSize) {
 return(0);
 }
 
+// SortSeq
+// Generates the suffix array using the linear time SA-IS induced sorting, falling back to the multithreaded qsort if SA-IS fails, or if the
+// concatenated sequence length is longer than cMaxSAIS32SeqLen and pArray was not allocated large enough to hold the 64bit SA-IS indexes
+// 64bit indexes are generated in place at the start of pArray and then packed down into the suffix elements, so no workspace is allocated
+// Note that pArray must have been allocated with at least cSAISAlignSlack bytes beyond the SeqLen suffix elements
+int
+CSfxArray::SortSeq(int64_t SeqLen,		// total concatenated sequence length
+						etSeqBase *pSeq,	// pts to start of concatenated sequences
+						int SfxElSize,		// suffix element size (will be either 4 or 5)
+						void *pArray,		// allocated to hold suffix elements
+						int64_t ArrayBytes)	// number of bytes allocated at pArray
+{
+int Rslt;
+int64_t Idx;
+int64_t SA;
+CSAIS SAIS;
+
+if(SeqLen < 1 || !(SfxElSize == 4 || SfxElSize == 5))
+	return(-1);
+
+if(SfxElSize == 4 && SeqLen <= cMaxSAIS32SeqLen) // 32bit signed indexes can be sorted directly in place 
+	{
+	int32_t *pSA32;
+	SAIS.SetNumThreads(m_MaxQSortThreads);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"SortSeq: Starting SA-IS suffix array generation over %lld bases ...",SeqLen);
+	// SA-IS processes the indexes as 32bit words so sort at the next 4 byte aligned address and then shift down
+	pSA32 = (int32_t *)(((size_t)pArray + 3) & ~(size_t)0x03);
+	if((Rslt = SAIS.sais_msk(pSeq,pSA32,(int32_t)SeqLen,16,0x0f)) == 0)
+		{
+		if((void *)pSA32 != pArray)
+			memmove(pArray,pSA32,(size_t)SeqLen * sizeof(int32_t));
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"SortSeq: Completed SA-IS suffix array generation");
+		return(0);
+		}
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"SortSeq: SA-IS suffix array generation failed (%d), falling back to multithreaded qsort",Rslt);
+	return(QSortSeq(SeqLen,pSeq,SfxElSize,pArray));
+	}
+
+// longer sequences require 64bit indexes, these are generated in place and then packed down into the suffix elements
+if(ArrayBytes < (SeqLen * (int64_t)sizeof(int64_t)) + cSAISAlignSlack)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"SortSeq: %lld bytes allocated is less than the %lld bytes needed for SA-IS 64bit indexes, sorting %lld bases with multithreaded qsort",
+						ArrayBytes,(SeqLen * (int64_t)sizeof(int64_t)) + cSAISAlignSlack,SeqLen);
+	return(QSortSeq(SeqLen,pSeq,SfxElSize,pArray));
+	}
+
+int64_t *pSA64;
+SAIS.SetNumThreads(m_MaxQSortThreads);
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"SortSeq: Starting SA-IS suffix array generation over %lld bases ...",SeqLen);
+pSA64 = (int64_t *)(((size_t)pArray + 7) & ~(size_t)0x07);
+if((Rslt = SAIS.sais_msk(pSeq,pSA64,SeqLen,16,0x0f)) != 0)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"SortSeq: SA-IS suffix array generation failed (%d), falling back to multithreaded qsort",Rslt);
+	return(QSortSeq(SeqLen,pSeq,SfxElSize,pArray));
+	}
+
+// packing is in ascending order, each index is read before its packed element is written and a packed element never extends beyond the
+// start of the next unread index
+uint8_t *pIdx = (uint8_t *)pArray;
+int64_t *pSA = pSA64;
+for(Idx = 0; Idx < SeqLen; Idx++, pSA++)
+	{
+	SA = *pSA;
+	*(uint32_t *)pIdx = (uint32_t)(SA & 0x0ffffffff);
+	pIdx += 4;
+	if(SfxElSize == 5)
+		*pIdx++ = (uint8_t)((SA >> 32) & 0x00ff);
+	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"SortSeq: Completed SA-IS suffix array generation");
+return(0);
+}
+
 // QSortSeqCmp32
 // qsorts suffix elements whereby each element occupies 32bits, 4 bytes, and is an offset into gpSeq[]
 static int QSortSeqCmp32(const void *p1,const void *p2)
@@ -86,6 +86,14 @@ typedef enum etHRslt {
 	eHRFatalError						// fatal error encountered
 } tHRslt;
 
+typedef enum TAG_eSfxLoadMode {
+	eSfxLoadRead = 0,					// suffix block is read into privately allocated memory by a background readahead thread
+	eSfxLoadMmap,						// suffix block is memory mapped, pages are loaded on demand and shared through the page cache with other processes
+	eSfxLoadMmapWillNeed,				// as eSfxLoadMmap but kernel is advised to start asynchronous readahead of all pages
+	eSfxLoadMmapPopulate,				// as eSfxLoadMmap but all pages are faulted in (MAP_POPULATE) before returning from Open()
+	eSfxLoadPlaceholder					// used to set the enumeration range
+} etSfxLoadMode;
+
 typedef enum eRPTMasking {
 	eRPTHignor = 0,						// treat all bases as not being a repeat (ignore any cRptMskFlg)
 	eRPTHmasked,						// treat any base cRptMskFlg as a repeat masked base 
@@ -181,6 +189,16 @@ const uint32_t cMinAllowInMemSeqLen = 0x04;		// minimum allowed length of any in
 const uint32_t cMaxAllowInMemSeqLen = (cMaxAllowSeqLen/2);		// maximum allowed length of any individual sequence allowed when constructing in-memory suffix array
 const uint64_t cMaxAllowConcatSeqLen = 1000000000000; // max supported concatenation length of all sequences (must fit within 40bits)
 const uint64_t cReallocBlockEls = (uint64_t)(cMaxAllowSeqLen/10);  // minimum realloc for sfxblock elements
+const int cSfxBlockAlign = 4096;					// suffix blocks start at file offsets which are multiples of this so they can be memory mapped in place
+const int cSAISAlignSlack = 8;					// suffix array allocations are extended by this many bytes so SA-IS can sort 32bit indexes at an aligned address
+const int64_t cMaxSAIS32SeqLen = 0x07ffffff0;	// concatenated sequences longer than this are SA-IS sorted with 64bit indexes generated in place within a temporarily extended suffix element allocation
+const char cpszSfxPfxIdxExtn[] = ".pfx";		// prefix index file name is the suffix array file name with this extension appended
+const int cSfxPfxIdxVersion = 1;				// current prefix index file version
+const int cMinSfxPfxIdxLen = 8;					// prefix index only generated if suffix array large enough to be indexed by prefixes of at least this length
+const int cMaxSfxPfxIdxLen = 14;				// prefix index is over prefixes of at most this length
+const int cSfxPfxIdxSamples = 64;				// prefix index is checked as consistent with suffix array by hashing this many sampled suffix elements
+const uint64_t cSfxPfxIdxMaxCnt = 0x0ffffff;	// prefix index suffix counts saturate at this count
+const int64_t cSfxPfxIdxChunk = 0x0100000;		// prefix index is generated over chunks of this many suffix elements
 const uint64_t cThres8ByteSfxEls = 4000000000;  // if concatenated sequence length >= this threshold then use 5bytes per suffix element instead of 4 when creating suffix index
 const uint32_t cMaxMemSfxSeqAlloc = 0x03fffffff;  // when constructing in memory suffix array then defaulting max length sequence to this length, will be realloc'd to larger if required
 const int cMaxCultivars = 20000;	// can handle at most this many different cultivars
@@ -207,6 +225,18 @@ typedef struct TAG_sSfxHeaderV3 {
 } tsSfxHeaderV3;
 
 // original fixed size V3 file header with cMaxDatasetSpeciesChrom set to 36
+// prefix index file header, header is immediately followed by the prefix index
+typedef struct TAG_sSfxPfxIdxHdr {
+	uint8_t Magic[4];					// always 's','f','x','p'
+	int32_t Version;					// file version, cSfxPfxIdxVersion
+	int32_t PrefixLen;					// suffixes are indexed by their initial PrefixLen bases
+	int32_t SfxElSize;					// suffix array elements are this many bytes
+	uint64_t ConcatSeqLen;				// number of suffix array elements
+	uint64_t NumPrefixes;				// number of prefixes in index (4^PrefixLen)
+	uint64_t SampleHash;				// hash over sampled suffix array elements
+	uint8_t Pad[24];					// pad header out to 64 bytes
+} tsSfxPfxIdxHdr;
+
 typedef struct TAG_sSfxHeaderVv {
 	uint8_t Magic[4];			 		// magic chars to identify this file as a SfxArray file
 	int32_t Version;					// file structure version
@@ -362,6 +392,14 @@ class CSfxArray : public CErrorCodes, protected CEndian
 	size_t m_AllocdCoreKMersMem;				// memory allocation size for holding core KMers
 	tsCoreKMer *m_pCoreKMers;					// memory preallocd of m_AllocdCoreKMersSize size to hold core KMers
 
+	int m_PfxIdxLen;							// if prefix index available then suffixes are indexed by their initial m_PfxIdxLen bases, 0 if no prefix index
+	uint64_t *m_pPfxIdx;						// prefix index, for each prefix the first suffix element in bits 0..39 and number of suffix elements (saturating at cSfxPfxIdxMaxCnt) in bits 40..63
+	uint8_t *m_pPfxIdxMem;						// prefix index header followed by m_pPfxIdx, either allocated or memory mapped from file
+	size_t m_PfxIdxMemLen;						// m_pPfxIdxMem is this many bytes
+	bool m_bPfxIdxMapped;						// true if m_pPfxIdxMem is memory mapped from file
+	bool m_bPfxIdxChkd;							// true if prefix index has been generated or loaded, or attempted to be loaded, for the current suffix block
+	int64_t *m_pPfxIdxEnds;						// used whilst generating prefix index, suffix element immediately following last element for each prefix
+
 	uint32_t m_MaxKMerCnts;						// max KMer target count
 	uint32_t *m_pKMerCntDist;					// record count distributions into this array sized MaxKMerCnts+1
 
@@ -400,6 +438,11 @@ static	void *ThreadedPrereadBlocks(void * pThreadPars);
 	uint8_t *m_pBisulfateBases;					// used whilst constructing sfx array if bisulfite processing
 	uint64_t m_EstSfxEls;							// estimate of how mant sfx array elements may be required when creating sfx array 
 
+	static etSfxLoadMode m_DfltLoadMode;		// new instances will default to loading suffix blocks with this mode
+	etSfxLoadMode m_LoadMode;					// when opening existing suffix file then load suffix block with this mode
+	uint8_t *m_pMappedSfx;						// if suffix block memory mapped then start of mapping, m_pSfxBlock will be pointing into this mapping
+	size_t m_MappedSfxLen;						// memory mapping is of this length
+
 	teBSFrsltCodes ChunkedWrite(int64_t WrtOfs,uint8_t *pData,int64_t WrtLen); // handles WrtLen > INT_MAX
 	teBSFrsltCodes ChunkedRead(int64_t RdOfs,uint8_t *pData,int64_t RdLen);  // handles RdLen > INT_MAX
 	void InitHdr(void);
@@ -409,9 +452,34 @@ static	void *ThreadedPrereadBlocks(void * pThreadPars);
 	teBSFrsltCodes Entries2Disk(void);			// writes entries to file
 	teBSFrsltCodes SfxBlock2Disk(void);			// writes sfx block to file
 	teBSFrsltCodes Disk2SfxBlock(int BlockID);	// loads specified sfx block from file
+#ifndef _WIN32
+	teBSFrsltCodes MapSfxBlock(void);			// memory maps the sfx block from file
+#endif
 
 	teBSFrsltCodes Flush2Disk(void);			// flush and commit to disk
 
+	void ReleasePfxIdx(void);					// release any prefix index
+	int64_t PfxIdxCode(etSeqBase *pSeq);		// returns prefix index for initial m_PfxIdxLen bases of pSeq, -1 if any are not canonical
+	uint64_t PfxIdxSampleHash(void);			// returns hash over sampled elements of currently loaded suffix array
+	teBSFrsltCodes GenPfxIdx(void);				// generate prefix index over currently loaded suffix array
+	teBSFrsltCodes PfxIdx2Disk(void);			// writes prefix index to file, or removes any previously existing file if no prefix index
+	teBSFrsltCodes Disk2PfxIdx(void);			// loads prefix index from file if it exists and is consistent with currently loaded suffix array
+
+	int64_t										// number of suffix elements starting with probe prefix, -1 if no prefix index or prefix not canonical
+		PfxInterval(etSeqBase *pProbe,			// probe, must be at least m_PfxIdxLen long
+				int64_t *pFirstIdx);			// returned first suffix element starting with probe prefix
+
+	int64_t			// index+1 in pSfxArray of first, or last, exactly matching probe or 0 if no match
+		LocateExactLCP(etSeqBase *pProbe,	// pts to probe sequence
+				  int ProbeLen,					// probe length to exactly match over
+				  etSeqBase *pTarg,				// target sequence
+				  int SfxElSize,				// size in bytes of suffix element - expected to be either 4 or 5
+				  void *pSfxArray,				// target sequence suffix array
+				  int64_t SfxLo,				// low index in pSfxArray
+				  int64_t SfxHi,				// high index in pSfxArray
+				  int MatchedLen,				// all suffixes in SfxLo..SfxHi are known to match the initial MatchedLen probe bases
+				  bool bLast);					// false to locate first, true to locate last, exactly matching
+
 	tsSfxEntry *MapChunkHit2Entry(uint64_t ChunkOfs); // Maps the chunk hit loci to the relevant sequence entry
 
 	int TransformToColorspace(uint8_t *pSrcBases,	// basespace sequence to transform into colorspace (SOLiD)
@@ -994,6 +1062,8 @@ public:
 
 	uint32_t					// returned sequence length (may be shorter than that requested) or 0 if errors
 		GetSeq(int EntryID,uint32_t Loci,etSeqBase *pRetSeq,uint32_t Len);	// get sequence for entry starting at Loci and of length Len
+
+	etSeqBase *GetLoadedSeqPtr(uint32_t EntryID);	// returns ptr to start of entry sequence if in the currently loaded suffix block, NULL if not loaded
 	
 	uint32_t					// returned sequence length (may be shorter than that requested) or 0 if errors
 		GetColorspaceSeq(int EntryID,uint32_t Loci,etSeqBase *pRetSeq,uint32_t Len); // if indexed in colorspace then returns sequence as colorspace
@@ -1002,7 +1072,15 @@ public:
 						etSeqBase *pSeq,	// pts to start of concatenated sequences
 						int SfxElSize,		// suffix element size (will be either 4 or 5)
 						void *pArray);		// allocated to hold suffix elements
-	void SetMaxQSortThreads(int MaxThreads);			// sets maximum number of threads to use in multithreaded qsorts
+	int	SortSeq(int64_t SeqLen,			// total concatenated sequence length
+						etSeqBase *pSeq,	// pts to start of concatenated sequences
+						int SfxElSize,		// suffix element size (will be either 4 or 5)
+						void *pArray,		// allocated to hold suffix elements plus cSAISAlignSlack bytes, sorted with SA-IS
+						int64_t ArrayBytes);	// number of bytes allocated at pArray, SeqLen > cMaxSAIS32SeqLen requires SeqLen * 8 + cSAISAlignSlack for SA-IS
+	void SetMaxQSortThreads(int MaxThreads);			// sets maximum number of threads to use in multithreaded qsorts and SA-IS bucket counting
+
+	static void SetDfltLoadMode(etSfxLoadMode LoadMode);	// sets the load mode for subsequently instantiated CSfxArray's
+	void SetLoadMode(etSfxLoadMode LoadMode);	// sets the load mode to be used when this instance subsequently opens an existing suffix file, memory mapping is not supported on Windows
 
 	int						// returns the previously utilised MaxBaseCmpLen
 		SetMaxBaseCmpLen(int MaxBaseCmpLen);		// sets maximum number of bases which need to be compared for equality in multithreaded qsorts, will be clamped to be in range 10..(5*cMaxReadLen)
@@ -1016,6 +1094,11 @@ public:
 	int
 		InitialiseCoreKMers(int KMerLen);	// initialise for cores of this KMer lengths
 
+	int GetPfxIdxLen(void);					// returns prefix length of loaded prefix index, 0 if no prefix index loaded
+
+	// work pool processing, public only so it is accessible to the pool thread function
+	int GenPfxIdxChunk(int64_t StartIdx, int64_t EndIdx);	// locate prefix starts and ends in a chunk of suffix elements
+
 
 	static int CompareExtdMatches( const void *arg1, const void *arg2);
 
@@ -268,6 +268,7 @@ else
 NumCells = ((uint64_t)m_ProbeLen * m_TargLen);
 if(m_bBanded)
 	NumCells /= 10;
+CRunProfile::Count(eRPCSWCells,(int64_t)NumCells);
 
 if(m_pTrcBckCells == NULL || m_TrcBckCellsAllocd < NumCells || ((uint64_t)m_TrcBckCellsAllocd > (uint64_t)NumCells * 5))
 	{
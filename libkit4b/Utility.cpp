@@ -816,6 +816,41 @@ return(szResourceLimits);
 #endif
 }
 
+// AvailPhysMem
+// Estimate of physical memory available for new allocations; on Linux this is MemAvailable from /proc/meminfo, which includes reclaimable
+// page cache, falling back to the free page count if MemAvailable is not reported
+int64_t
+CUtility::AvailPhysMem(void)
+{
+#ifdef _WIN32
+MEMORYSTATUSEX MemStatus;
+MemStatus.dwLength = sizeof(MemStatus);
+if(!GlobalMemoryStatusEx(&MemStatus))
+	return(0);
+return((int64_t)MemStatus.ullAvailPhys);
+#else
+FILE *pMemInfo;
+char szLine[200];
+long long AvailKB;
+int64_t AvailMem;
+
+AvailMem = 0;
+if((pMemInfo = fopen("/proc/meminfo","r")) != NULL)
+	{
+	while(fgets(szLine,sizeof(szLine),pMemInfo) != NULL)
+		if(sscanf(szLine,"MemAvailable: %lld kB",&AvailKB) == 1)
+			{
+			AvailMem = (int64_t)AvailKB * 1024;
+			break;
+			}
+	fclose(pMemInfo);
+	}
+if(AvailMem == 0)
+	AvailMem = (int64_t)sysconf(_SC_AVPHYS_PAGES) * (int64_t)sysconf(_SC_PAGESIZE);
+return(AvailMem > 0 ? AvailMem : 0);
+#endif
+}
+
 // GetNumSubseqs
 // Returns number of subsequences - no filtering - common w/o InDels
 // between the sequences in pProcParams->pSeq
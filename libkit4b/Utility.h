@@ -138,6 +138,9 @@ public:
 	static char *			// returns current and maximum resource limits ( getrlimit ), returns NULL in WIndows
 		ReportResourceLimits(void);
 
+	static int64_t			// returns estimate of physical memory, in bytes, currently available for allocation without swapping, 0 if unable to determine
+		AvailPhysMem(void);
+
 	static int
 		GetNumSubseqs(int AlignLen,		// alignment length incl InDels
 			   int NumSeqs,				// number of sequences
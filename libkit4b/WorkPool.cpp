@@ -0,0 +1,602 @@
+/*
+This toolkit is a source base clone of 'BioKanga' release 4.4.2 (https://github.com/csiro-crop-informatics/biokanga) and contains
+significant source code changes enabling new functionality and resulting process parameterisation changes. These changes have resulted in
+incompatibility with 'BioKanga'.
+
+Because of the potential for confusion by users unaware of functionality and process parameterisation changes then the modified source base
+and resultant compiled executables have been renamed to 'kit4b' - K-mer Informed Toolkit for Bioinformatics.
+The renaming will force users of the 'BioKanga' toolkit to examine scripting which is dependent on existing 'BioKanga'
+parameterisations so as to make appropriate changes if wishing to utilise 'kit4b' parameterisations and functionality.
+
+'kit4b' is being released under the Opensource Software License Agreement (GPLv3)
+'kit4b' is Copyright (c) 2019, 2020
+Please contact Dr Stuart Stephen < stuartjs@g3web.com > if you have any questions regarding 'kit4b'.
+
+Original 'BioKanga' copyright notice has been retained and immediately follows this notice..
+*/
+/*
+ * CSIRO Open Source Software License Agreement (GPLv3)
+ * Copyright (c) 2017, Commonwealth Scientific and Industrial Research Organisation (CSIRO) ABN 41 687 119 230.
+ * See LICENSE for the complete license information (https://github.com/csiro-crop-informatics/biokanga/LICENSE)
+ * Contact: Alex Whan <alex.whan@csiro.au>
+ */
+// Persistent pool of worker threads with per-worker chunk deques and work stealing
+// Processing phases submit their items (reads, bins, chromosomes...) as a ParallelFor() over chunks of items, each worker is initially
+// allocated a contiguous range of chunks and when its own range is exhausted then steals half of the remaining chunks from another worker
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include "./commhdrs.h"
+#else
+#include <pthread.h>
+#include "./commhdrs.h"
+#endif
+
+#include "WorkPool.h"
+
+CWorkPool *CWorkPool::m_pSharedPool = NULL;
+volatile unsigned int CWorkPool::m_CASShared = 0;
+
+// identifies the pool, and worker within that pool, if the current thread is a pool worker thread
+#ifdef _WIN32
+static __declspec(thread) CWorkPool *gpWorkerPool = NULL;
+static __declspec(thread) int gWorkerIdx = 0;
+#else
+static __thread CWorkPool *gpWorkerPool = NULL;
+static __thread int gWorkerIdx = 0;
+#endif
+
+CWorkPool::CWorkPool(void)
+{
+m_NumWorkers = 0;
+m_pWorkers = NULL;
+m_pDeques = NULL;
+m_CASCaller = 0;
+m_JobGen = 0;
+m_bTerminate = false;
+m_pJobFunc = NULL;
+m_pJobCtx = NULL;
+m_JobNumItems = 0;
+m_JobChunkSize = 0;
+m_JobNumWorkers = 0;
+m_NumActive = 0;
+m_JobChunksDone = 0;
+m_JobRslt = eBSFSuccess;
+m_bJobAbort = 0;
+}
+
+CWorkPool::~CWorkPool(void)
+{
+Stop();
+}
+
+int
+CWorkPool::NumWorkers(void)
+{
+return(m_NumWorkers);
+}
+
+void
+CWorkPool::LockDeque(tsWPDeque *pDeque)
+{
+int SpinCnt = 1000;
+#ifdef _WIN32
+while(InterlockedCompareExchange(&pDeque->CASLock,1,0)!=0)
+	{
+	if(SpinCnt -= 1)
+		continue;
+	SwitchToThread();
+	SpinCnt = 100;
+	}
+#else
+while(__sync_val_compare_and_swap(&pDeque->CASLock,0,1)!=0)
+	{
+	if(SpinCnt -= 1)
+		continue;
+	sched_yield();
+	SpinCnt = 100;
+	}
+#endif
+}
+
+void
+CWorkPool::UnlockDeque(tsWPDeque *pDeque)
+{
+#ifdef _WIN32
+InterlockedCompareExchange(&pDeque->CASLock,0,1);
+#else
+__sync_val_compare_and_swap(&pDeque->CASLock,1,0);
+#endif
+}
+
+void
+CWorkPool::LockCaller(void)
+{
+int BackoffMS = 1;
+#ifdef _WIN32
+while(InterlockedCompareExchange(&m_CASCaller,1,0)!=0)
+#else
+while(__sync_val_compare_and_swap(&m_CASCaller,0,1)!=0)
+#endif
+	{
+	CUtility::SleepMillisecs(BackoffMS);
+	if(BackoffMS < 100)
+		BackoffMS += 1;
+	}
+}
+
+void
+CWorkPool::UnlockCaller(void)
+{
+#ifdef _WIN32
+InterlockedCompareExchange(&m_CASCaller,0,1);
+#else
+__sync_val_compare_and_swap(&m_CASCaller,1,0);
+#endif
+}
+
+#ifdef _WIN32
+unsigned __stdcall CWorkPool::WorkerThread(void * pThreadPars)
+#else
+void *CWorkPool::WorkerThread(void * pThreadPars)
+#endif
+{
+tsWPWorker *pWorker = (tsWPWorker *)pThreadPars;
+pWorker->pThis->RunWorker(pWorker);
+#ifdef _WIN32
+_endthreadex(0);
+return(0);
+#else
+pthread_exit(NULL);
+#endif
+}
+
+int
+CWorkPool::Start(int NumWorkers)		// start pool with this many worker threads (1..cMaxWorkPoolThreads)
+{
+int WorkerIdx;
+tsWPWorker *pWorker;
+
+if(NumWorkers < 1)
+	NumWorkers = 1;
+else
+	if(NumWorkers > cMaxWorkPoolThreads)
+		NumWorkers = cMaxWorkPoolThreads;
+
+if(m_pWorkers != NULL)
+	{
+	if(m_NumWorkers == NumWorkers)
+		return(eBSFSuccess);
+	Stop();
+	}
+
+if((m_pWorkers = new tsWPWorker [NumWorkers])==NULL)
+	return(eBSFerrMem);
+if((m_pDeques = new tsWPDeque [NumWorkers])==NULL)
+	{
+	delete []m_pWorkers;
+	m_pWorkers = NULL;
+	return(eBSFerrMem);
+	}
+memset(m_pWorkers,0,sizeof(tsWPWorker) * NumWorkers);
+memset(m_pDeques,0,sizeof(tsWPDeque) * NumWorkers);
+
+#ifdef _WIN32
+InitializeCriticalSection(&m_JobMutex);
+InitializeConditionVariable(&m_JobReqEvent);
+InitializeConditionVariable(&m_JobDoneEvent);
+#else
+pthread_mutex_init(&m_JobMutex,NULL);
+pthread_cond_init(&m_JobReqEvent,NULL);
+pthread_cond_init(&m_JobDoneEvent,NULL);
+#endif
+m_bTerminate = false;
+m_JobGen = 0;
+m_NumActive = 0;
+m_CASCaller = 0;
+
+m_NumWorkers = 0;
+for(WorkerIdx = 0, pWorker = m_pWorkers; WorkerIdx < NumWorkers; WorkerIdx++, pWorker++)
+	{
+	pWorker->pThis = this;
+	pWorker->WorkerIdx = WorkerIdx;
+	pWorker->RandState = 0x9e3779b9 * (uint32_t)(WorkerIdx + 1);
+#ifdef _WIN32
+	if((pWorker->threadHandle = (HANDLE)_beginthreadex(NULL,0x0fffff,WorkerThread,pWorker,0,&pWorker->threadID))==NULL)
+		break;
+#else
+	if((pWorker->threadRslt = pthread_create(&pWorker->threadID,NULL,WorkerThread,pWorker))!=0)
+		break;
+#endif
+	m_NumWorkers += 1;
+	}
+if(m_NumWorkers == 0)
+	{
+	Stop();
+	return(eBSFerrInternal);
+	}
+return(eBSFSuccess);
+}
+
+void
+CWorkPool::Stop(void)
+{
+int WorkerIdx;
+if(m_pWorkers == NULL)
+	return;
+
+#ifdef _WIN32
+EnterCriticalSection(&m_JobMutex);
+m_bTerminate = true;
+WakeAllConditionVariable(&m_JobReqEvent);
+LeaveCriticalSection(&m_JobMutex);
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+	{
+	WaitForSingleObject(m_pWorkers[WorkerIdx].threadHandle,INFINITE);
+	CloseHandle(m_pWorkers[WorkerIdx].threadHandle);
+	}
+DeleteCriticalSection(&m_JobMutex);
+#else
+pthread_mutex_lock(&m_JobMutex);
+m_bTerminate = true;
+pthread_cond_broadcast(&m_JobReqEvent);
+pthread_mutex_unlock(&m_JobMutex);
+for(WorkerIdx = 0; WorkerIdx < m_NumWorkers; WorkerIdx++)
+	pthread_join(m_pWorkers[WorkerIdx].threadID,NULL);
+pthread_cond_destroy(&m_JobReqEvent);
+pthread_cond_destroy(&m_JobDoneEvent);
+pthread_mutex_destroy(&m_JobMutex);
+#endif
+
+delete []m_pWorkers;
+m_pWorkers = NULL;
+delete []m_pDeques;
+m_pDeques = NULL;
+m_NumWorkers = 0;
+m_bTerminate = false;
+}
+
+// worker threads persist between jobs, sleeping until a new job generation is posted
+void
+CWorkPool::RunWorker(tsWPWorker *pWorker)
+{
+uint32_t LastJobGen = 0;
+gpWorkerPool = this;
+gWorkerIdx = pWorker->WorkerIdx;
+#ifdef _WIN32
+EnterCriticalSection(&m_JobMutex);
+#else
+pthread_mutex_lock(&m_JobMutex);
+#endif
+while(1)
+	{
+	while(!m_bTerminate && m_JobGen == LastJobGen)
+#ifdef _WIN32
+		SleepConditionVariableCS(&m_JobReqEvent,&m_JobMutex,INFINITE);
+#else
+		pthread_cond_wait(&m_JobReqEvent,&m_JobMutex);
+#endif
+	if(m_bTerminate)
+		break;
+	LastJobGen = m_JobGen;
+	if(pWorker->WorkerIdx >= m_JobNumWorkers)	// job capped to fewer workers so this worker sits it out
+		continue;
+#ifdef _WIN32
+	LeaveCriticalSection(&m_JobMutex);
+#else
+	pthread_mutex_unlock(&m_JobMutex);
+#endif
+
+	ProcessJob(pWorker);
+
+#ifdef _WIN32
+	EnterCriticalSection(&m_JobMutex);
+	if(--m_NumActive == 0)
+		WakeAllConditionVariable(&m_JobDoneEvent);
+#else
+	pthread_mutex_lock(&m_JobMutex);
+	if(--m_NumActive == 0)
+		pthread_cond_broadcast(&m_JobDoneEvent);
+#endif
+	}
+#ifdef _WIN32
+LeaveCriticalSection(&m_JobMutex);
+#else
+pthread_mutex_unlock(&m_JobMutex);
+#endif
+}
+
+// take next chunk from own deque, if empty then steal half of the remaining chunks from the back of another worker's deque
+// no chunks are added after a job has been posted so once all deques are seen to be empty the worker has completed its share of the job
+bool
+CWorkPool::NextChunk(tsWPWorker *pWorker,	// worker requesting chunk
+				int64_t *pChunk)			// returned chunk
+{
+int Probe;
+int VictimIdx;
+int64_t NumSteal;
+int64_t StealHi;
+tsWPDeque *pOwn;
+tsWPDeque *pVictim;
+
+pOwn = &m_pDeques[pWorker->WorkerIdx];
+LockDeque(pOwn);
+if(pOwn->LoChunk < pOwn->HiChunk)
+	{
+	*pChunk = pOwn->LoChunk++;
+	UnlockDeque(pOwn);
+	return(true);
+	}
+UnlockDeque(pOwn);
+
+if(m_JobNumWorkers < 2)
+	return(false);
+
+// start probing from a random victim so that thieves are spread over the deques
+pWorker->RandState ^= pWorker->RandState << 13;
+pWorker->RandState ^= pWorker->RandState >> 17;
+pWorker->RandState ^= pWorker->RandState << 5;
+VictimIdx = (int)(pWorker->RandState % (uint32_t)m_JobNumWorkers);
+for(Probe = 0; Probe < m_JobNumWorkers; Probe++, VictimIdx = (VictimIdx + 1) % m_JobNumWorkers)
+	{
+	if(VictimIdx == pWorker->WorkerIdx)
+		continue;
+	pVictim = &m_pDeques[VictimIdx];
+	if(pVictim->LoChunk >= pVictim->HiChunk)		// unlocked peek, rechecked once locked
+		continue;
+	LockDeque(pVictim);
+	if((NumSteal = (pVictim->HiChunk - pVictim->LoChunk + 1) / 2) < 1)
+		{
+		UnlockDeque(pVictim);
+		continue;
+		}
+	StealHi = pVictim->HiChunk;
+	pVictim->HiChunk -= NumSteal;
+	UnlockDeque(pVictim);
+
+	*pChunk = StealHi - NumSteal;
+	if(NumSteal > 1)
+		{
+		LockDeque(pOwn);
+		pOwn->LoChunk = *pChunk + 1;
+		pOwn->HiChunk = StealHi;
+		UnlockDeque(pOwn);
+		}
+	return(true);
+	}
+return(false);
+}
+
+void
+CWorkPool::ProcessJob(tsWPWorker *pWorker)
+{
+int Rslt;
+int64_t Chunk;
+int64_t StartIdx;
+int64_t EndIdx;
+
+while(NextChunk(pWorker,&Chunk))
+	{
+	if(!m_bJobAbort)
+		{
+		StartIdx = Chunk * m_JobChunkSize;
+		EndIdx = min(StartIdx + m_JobChunkSize,m_JobNumItems);
+		if((Rslt = (*m_pJobFunc)(m_pJobCtx,StartIdx,EndIdx,pWorker->WorkerIdx)) < 0)
+			{
+#ifdef _WIN32
+			if(InterlockedCompareExchange((volatile LONG *)&m_JobRslt,Rslt,eBSFSuccess)==eBSFSuccess)
+				m_bJobAbort = 1;
+#else
+			if(__sync_bool_compare_and_swap(&m_JobRslt,eBSFSuccess,Rslt))
+				m_bJobAbort = 1;
+#endif
+			}
+		}
+#ifdef _WIN32
+	InterlockedIncrement64(&m_JobChunksDone);
+#else
+	__sync_fetch_and_add(&m_JobChunksDone,1);
+#endif
+	}
+}
+
+int
+CWorkPool::ParallelFor(int64_t NumItems,	// number of items to process
+				int64_t ChunkSize,			// in chunks of this many items, if 0 then chunk size is chosen by pool
+				WorkPoolFunc pFunc,			// processing function
+				void *pCtx,					// passed into pFunc
+				uint32_t ProgressSecs,		// report progress every this many seconds
+				const char *pszProgress,	// progress message
+				WorkPoolProgressFunc pProgressFunc, // if not NULL then called to report progress instead of pszProgress
+				void *pProgressCtx,			// passed into pProgressFunc
+				int MaxWorkers)				// if > 0 then use at most this many workers
+{
+int Rslt;
+int WorkerIdx;
+int JobNumWorkers;
+int64_t NumChunks;
+int64_t ChunkIdx;
+int64_t ChunksPerWorker;
+int64_t StartIdx;
+tsWPDeque *pDeque;
+
+if(NumItems <= 0)
+	return(eBSFSuccess);
+if(pFunc == NULL)
+	return(eBSFerrParams);
+
+if(m_pWorkers == NULL)		// pool not started so process all items in the callers thread
+	return((Rslt = (*pFunc)(pCtx,0,NumItems,0)) < 0 ? Rslt : eBSFSuccess);
+
+JobNumWorkers = JobWorkers(MaxWorkers);
+if(gpWorkerPool == this)	// called from within one of this pool's workers, other workers may be blocked on this job so process chunks in this worker's thread
+	{
+	if(ChunkSize <= 0)
+		ChunkSize = NumItems;
+	for(StartIdx = 0; StartIdx < NumItems; StartIdx += ChunkSize)
+		if((Rslt = (*pFunc)(pCtx,StartIdx,min(StartIdx + ChunkSize,NumItems),gWorkerIdx % JobNumWorkers)) < 0)
+			return(Rslt);
+	return(eBSFSuccess);
+	}
+
+if(ChunkSize <= 0)
+	ChunkSize = max((int64_t)1,NumItems / ((int64_t)JobNumWorkers * cWorkPoolChunksPerThread));
+NumChunks = (NumItems + ChunkSize - 1) / ChunkSize;
+
+LockCaller();
+#ifdef _WIN32
+EnterCriticalSection(&m_JobMutex);
+#else
+pthread_mutex_lock(&m_JobMutex);
+#endif
+m_pJobFunc = pFunc;
+m_pJobCtx = pCtx;
+m_JobNumItems = NumItems;
+m_JobChunkSize = ChunkSize;
+m_JobNumWorkers = JobNumWorkers;
+m_JobChunksDone = 0;
+m_JobRslt = eBSFSuccess;
+m_bJobAbort = 0;
+
+// seed each participating worker's deque with a contiguous range of chunks so that workers initially process neighbouring items
+ChunkIdx = 0;
+for(WorkerIdx = 0, pDeque = m_pDeques; WorkerIdx < m_NumWorkers; WorkerIdx++, pDeque++)
+	{
+	ChunksPerWorker = WorkerIdx < JobNumWorkers ? (NumChunks - ChunkIdx) / (JobNumWorkers - WorkerIdx) : 0;
+	pDeque->CASLock = 0;
+	pDeque->LoChunk = ChunkIdx;
+	pDeque->HiChunk = ChunkIdx + ChunksPerWorker;
+	ChunkIdx += ChunksPerWorker;
+	}
+m_NumActive = JobNumWorkers;
+m_JobGen += 1;
+
+#ifdef _WIN32
+WakeAllConditionVariable(&m_JobReqEvent);
+while(m_NumActive > 0)
+	{
+	if(!SleepConditionVariableCS(&m_JobDoneEvent,&m_JobMutex,ProgressSecs > 0 ? (DWORD)ProgressSecs * 1000 : INFINITE) && m_NumActive > 0)
+		{
+		if(pProgressFunc != NULL)
+			{
+			LeaveCriticalSection(&m_JobMutex);		// progress reporting may need to serialise with workers so don't hold the job mutex
+			(*pProgressFunc)(pProgressCtx);
+			EnterCriticalSection(&m_JobMutex);
+			}
+		else
+			if(pszProgress != NULL)
+				gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: %s (%lld of %lld chunks completed)",pszProgress,(long long)m_JobChunksDone,(long long)NumChunks);
+		}
+	}
+LeaveCriticalSection(&m_JobMutex);
+#else
+pthread_cond_broadcast(&m_JobReqEvent);
+struct timespec abstime;
+clock_gettime(CLOCK_REALTIME,&abstime);
+abstime.tv_sec += ProgressSecs;
+while(m_NumActive > 0)
+	{
+	if(ProgressSecs == 0)
+		{
+		pthread_cond_wait(&m_JobDoneEvent,&m_JobMutex);
+		continue;
+		}
+	if(pthread_cond_timedwait(&m_JobDoneEvent,&m_JobMutex,&abstime) == ETIMEDOUT)
+		{
+		if(m_NumActive > 0)
+			{
+			if(pProgressFunc != NULL)
+				{
+				pthread_mutex_unlock(&m_JobMutex);		// progress reporting may need to serialise with workers so don't hold the job mutex
+				(*pProgressFunc)(pProgressCtx);
+				pthread_mutex_lock(&m_JobMutex);
+				}
+			else
+				if(pszProgress != NULL)
+					gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: %s (%lld of %lld chunks completed)",pszProgress,(long long)m_JobChunksDone,(long long)NumChunks);
+			}
+		abstime.tv_sec += ProgressSecs;
+		}
+	}
+pthread_mutex_unlock(&m_JobMutex);
+#endif
+Rslt = m_JobRslt;
+UnlockCaller();
+return(Rslt);
+}
+
+int
+CWorkPool::JobWorkers(int MaxWorkers)	// returns number of workers which would participate in a job capped at MaxWorkers
+{
+if(m_NumWorkers < 1)
+	return(1);
+if(MaxWorkers <= 0 || MaxWorkers > m_NumWorkers)
+	return(m_NumWorkers);
+return(MaxWorkers);
+}
+
+// the shared pool is started once and never restarted, restarting would terminate workers whilst other threads may be within ParallelFor()
+// pool is sized for the largest expected request, callers wanting fewer workers cap their jobs with ParallelFor() MaxWorkers
+CWorkPool *
+CWorkPool::Shared(int NumWorkers)
+{
+int NumProcessors;
+int BackoffMS;
+CWorkPool *pPool;
+
+if((pPool = m_pSharedPool) != NULL)
+	return(pPool);
+
+BackoffMS = 1;
+#ifdef _WIN32
+while(InterlockedCompareExchange(&m_CASShared,1,0)!=0)
+#else
+while(__sync_val_compare_and_swap(&m_CASShared,0,1)!=0)
+#endif
+	{
+	CUtility::SleepMillisecs(BackoffMS);
+	if(BackoffMS < 100)
+		BackoffMS += 1;
+	}
+
+if(m_pSharedPool == NULL)		// may have been started by another thread whilst waiting on the lock
+	{
+#ifdef _WIN32
+	SYSTEM_INFO SystemInfo;
+	GetSystemInfo(&SystemInfo);
+	NumProcessors = (int)SystemInfo.dwNumberOfProcessors;
+#else
+	NumProcessors = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if((pPool = new CWorkPool) != NULL)
+		{
+		if(pPool->Start(max(NumWorkers,NumProcessors)) == eBSFSuccess)
+			m_pSharedPool = pPool;
+		else
+			delete pPool;
+		}
+	}
+pPool = m_pSharedPool;
+
+#ifdef _WIN32
+InterlockedCompareExchange(&m_CASShared,0,1);
+#else
+__sync_val_compare_and_swap(&m_CASShared,1,0);
+#endif
+return(pPool);
+}
+
+void
+CWorkPool::ReleaseShared(void)
+{
+if(m_pSharedPool != NULL)
+	{
+	delete m_pSharedPool;
+	m_pSharedPool = NULL;
+	}
+}
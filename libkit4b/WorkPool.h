@@ -0,0 +1,114 @@
+#pragma once
+
+const int cMaxWorkPoolThreads = 128;		// pool can have at most this many worker threads
+const int cWorkPoolChunksPerThread = 16;	// when caller does not specify a chunk size then aim for this many chunks per worker thread
+
+// processing function called by pool worker threads, items in range StartIdx..EndIdx-1 are to be processed by the function
+// WorkerIdx is in the range 0..NumWorkers()-1 and is unique for concurrently executing calls so can be used to index per-worker result slots
+// return >= 0 if no errors, < 0 to terminate processing of the remaining chunks with the first such returned value passed back to the ParallelFor() caller
+typedef int (*WorkPoolFunc)(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx);
+
+// optional progress reporting function called by the ParallelFor() caller's thread every ProgressSecs whilst chunks are still being processed
+typedef void (*WorkPoolProgressFunc)(void *pProgressCtx);
+
+#pragma pack(8)
+// each worker thread owns a deque of contiguous chunks
+// owner takes chunks from the front (LoChunk) whilst idle workers steal half of the remaining chunks from the back (HiChunk)
+typedef struct TAG_sWPDeque {
+	volatile unsigned int CASLock;		// serialises access to this deque
+	int64_t LoChunk;					// next chunk to be processed by owner
+	int64_t HiChunk;					// chunks up to but excluding this are still to be processed
+	uint8_t Pad[64 - sizeof(int64_t) * 3];	// keep deques in separate cache lines
+} tsWPDeque;
+
+typedef struct TAG_sWPWorker {
+	class CWorkPool *pThis;			// pool instance
+	int WorkerIdx;					// uniquely identifies this worker 0..N-1
+	uint32_t RandState;				// used for selecting victims when stealing
+#ifdef _WIN32
+	HANDLE threadHandle;			// handle as returned by _beginthreadex()
+	unsigned int threadID;			// identifier as set by _beginthreadex()
+#else
+	int threadRslt;					// result as returned by pthread_create ()
+	pthread_t threadID;				// identifier as set by pthread_create ()
+#endif
+} tsWPWorker;
+#pragma pack()
+
+class CWorkPool
+{
+	static CWorkPool *m_pSharedPool;	// process wide pool as returned by Shared()
+	static volatile unsigned int m_CASShared;	// serialises creation of the shared pool
+
+	int m_NumWorkers;					// number of worker threads started
+	tsWPWorker *m_pWorkers;				// worker thread parameters
+	tsWPDeque *m_pDeques;				// per worker chunk deques
+
+	volatile unsigned int m_CASCaller;	// serialises ParallelFor() callers
+
+	// current job
+	uint32_t m_JobGen;					// incremented for each new job, workers compare with their last processed job
+	bool m_bTerminate;					// set true when workers are to exit
+	WorkPoolFunc m_pJobFunc;			// job processing function
+	void *m_pJobCtx;					// passed into job processing function
+	int64_t m_JobNumItems;				// total number of items
+	int64_t m_JobChunkSize;				// items per chunk
+	int m_JobNumWorkers;				// only workers 0..m_JobNumWorkers-1 participate in current job
+	int m_NumActive;					// number of workers still processing current job
+	volatile int64_t m_JobChunksDone;	// number of chunks completed
+	volatile int m_JobRslt;				// first error (< 0) returned by job function
+	volatile int m_bJobAbort;			// set non-zero on error so remaining chunks are skipped
+
+#ifdef _WIN32
+	CRITICAL_SECTION m_JobMutex;		// serialises access to job state
+	CONDITION_VARIABLE m_JobReqEvent;	// workers wait on this for a new job
+	CONDITION_VARIABLE m_JobDoneEvent;	// ParallelFor() waits on this for job completion
+	static unsigned int __stdcall WorkerThread(void *pThreadPars);
+#else
+	pthread_mutex_t m_JobMutex;			// serialises access to job state
+	pthread_cond_t m_JobReqEvent;		// workers wait on this for a new job
+	pthread_cond_t m_JobDoneEvent;		// ParallelFor() waits on this for job completion
+	static void *WorkerThread(void *pThreadPars);
+#endif
+
+	void LockDeque(tsWPDeque *pDeque);
+	void UnlockDeque(tsWPDeque *pDeque);
+	void LockCaller(void);
+	void UnlockCaller(void);
+
+	void RunWorker(tsWPWorker *pWorker);	// worker thread loop
+	void ProcessJob(tsWPWorker *pWorker);	// process chunks, stealing from other workers when own deque is empty
+	bool								// false if no chunks remaining in any deque
+		NextChunk(tsWPWorker *pWorker,	// worker requesting chunk
+				int64_t *pChunk);		// returned chunk
+
+public:
+	CWorkPool(void);
+	~CWorkPool(void);
+
+	int Start(int NumWorkers);			// start pool with this many worker threads (1..cMaxWorkPoolThreads)
+	void Stop(void);					// terminate all worker threads
+	int NumWorkers(void);				// returns number of worker threads in pool
+
+	// process NumItems in chunks of ChunkSize items, blocks until all chunks processed
+	// if ProgressSecs > 0 then pProgressFunc is called, or if no pProgressFunc then pszProgress is reported, every ProgressSecs whilst still processing
+	// returns eBSFSuccess or first error (< 0) returned by pFunc
+	// if called from within a WorkPoolFunc then all chunks are processed in the calling worker's thread
+	// if MaxWorkers > 0 then at most MaxWorkers workers, with WorkerIdx 0..MaxWorkers-1, participate in processing the chunks
+	int ParallelFor(int64_t NumItems,		// number of items to process
+				int64_t ChunkSize,			// in chunks of this many items, if 0 then chunk size is chosen by pool
+				WorkPoolFunc pFunc,			// processing function
+				void *pCtx,					// passed into pFunc
+				uint32_t ProgressSecs = 0,	// report progress every this many seconds
+				const char *pszProgress = NULL, // progress message
+				WorkPoolProgressFunc pProgressFunc = NULL, // if not NULL then called to report progress instead of pszProgress
+				void *pProgressCtx = NULL,	// passed into pProgressFunc
+				int MaxWorkers = 0);		// if > 0 then use at most this many workers
+
+	// process wide pool shared between all subprocesses, started once on first call with the larger of NumWorkers or the number of processors
+	// pool is never restarted, callers requiring fewer workers cap each job with ParallelFor() MaxWorkers and size per-worker state with JobWorkers()
+	// threads persist until ReleaseShared() is called
+	static CWorkPool *Shared(int NumWorkers);
+	int JobWorkers(int MaxWorkers);		// returns number of workers which would participate in a job capped at MaxWorkers
+	static void ReleaseShared(void);
+};
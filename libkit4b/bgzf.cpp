@@ -234,34 +234,36 @@ fp->block_offset = 0;
 return comp_size;
 }
 
-// Inflate the block in fp->compressed_block into fp->uncompressed_block
-static size_t inflate_block(BGZF* fp, int block_length)
+// Inflate the BGZF block of length block_length in src into dst, returns inflated length or -1 if errors
+static int inflate_buff(uint8_t *dst, uint8_t *src, int block_length)
 {
 z_stream zs;
 zs.zalloc = NULL;
 zs.zfree = NULL;
-zs.next_in = (Bytef *)fp->compressed_block + 18;
+zs.next_in = (Bytef *)src + 18;
 zs.avail_in = block_length - 16;
-zs.next_out = (Bytef *)fp->uncompressed_block;
+zs.next_out = (Bytef *)dst;
 zs.avail_out = BGZF_MAX_BLOCK_SIZE;
 
 if (inflateInit2(&zs, -15) != Z_OK) 
-	{
-	fp->errcode |= BGZF_ERR_ZLIB;
 	return -1;
-	}
 if (inflate(&zs, Z_FINISH) != Z_STREAM_END) 
 	{
 	inflateEnd(&zs);
-	fp->errcode |= BGZF_ERR_ZLIB;
 	return -1;
 	}
 if (inflateEnd(&zs) != Z_OK) 
-	{
-	fp->errcode |= BGZF_ERR_ZLIB;
 	return -1;
-	}
-return zs.total_out;
+return (int)zs.total_out;
+}
+
+// Inflate the block in fp->compressed_block into fp->uncompressed_block
+static int inflate_block(BGZF* fp, int block_length)
+{
+int inflated_length;
+if((inflated_length = inflate_buff((uint8_t *)fp->uncompressed_block, (uint8_t *)fp->compressed_block, block_length)) < 0)
+	fp->errcode |= BGZF_ERR_ZLIB;
+return inflated_length;
 }
 
 static int check_header(const uint8_t *header)
@@ -332,11 +334,287 @@ static int load_block_from_cache(BGZF *fp, int64_t block_address) {return 0;}
 static void cache_block(BGZF *fp, int size) {}
 #endif
 
+// Multithreaded BGZF
+// When writing, filled blocks are queued into a batch which is deflated by worker threads and then written in the order queued.
+// Whilst multithreaded writing fp->block_address is the number of blocks queued, so bgzf_tell() returns a provisional virtual
+// offset which must be resolved to the actual file virtual offset with bgzf_mt_vaddr() after the referenced block has been written.
+// When reading, a batch of compressed blocks is read ahead and inflated by worker threads, inflated blocks are then returned
+// in file order by bgzf_read_block().
+typedef struct {
+	CWorkPool *pool;		// worker threads
+	BGZF *fp;				// BGZF being processed
+	int n_blks;				// batch holds at most this many blocks
+	int curr;				// number of blocks currently in batch
+	int nxt;				// when reading then next inflated block to be returned
+	uint8_t **ublks;		// uncompressed blocks
+	uint8_t **cblks;		// compressed blocks
+	int *ulen;				// uncompressed block lengths
+	int *clen;				// compressed block lengths
+	int *errcode;			// per block errors, BGZF_ERR_xxx
+	int64_t *baddr;			// when reading then file address of each block in batch
+	int64_t nxt_addr;		// when reading then file address immediately following the last block in batch
+	int64_t n_written;		// when writing then number of blocks written
+	int64_t m_vaddrs;		// when writing then vaddrs allocated to hold this many block addresses
+	int64_t *vaddrs;		// when writing then vaddrs[N] is file address of Nth written block, vaddrs[n_written] is the current file length
+} mtaux_t;
+
+static int mt_deflate_blks(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+mtaux_t *mt = (mtaux_t *)pCtx;
+for(int64_t Idx = StartIdx; Idx < EndIdx; Idx++)
+	{
+	mt->clen[Idx] = BGZF_MAX_BLOCK_SIZE;
+	mt->errcode[Idx] = bgzf_compress(mt->cblks[Idx], &mt->clen[Idx], mt->ublks[Idx], mt->ulen[Idx], mt->fp->compress_level) == 0 ? 0 : BGZF_ERR_ZLIB;
+	}
+return 0;
+}
+
+static int mt_inflate_blks(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+mtaux_t *mt = (mtaux_t *)pCtx;
+for(int64_t Idx = StartIdx; Idx < EndIdx; Idx++)
+	{
+	if(mt->errcode[Idx] != 0)
+		continue;
+	if((mt->ulen[Idx] = inflate_buff(mt->ublks[Idx], mt->cblks[Idx], mt->clen[Idx])) < 0)
+		mt->errcode[Idx] = BGZF_ERR_ZLIB;
+	}
+return 0;
+}
+
+static void mt_destroy(mtaux_t *mt)
+{
+int i;
+if(mt == NULL)
+	return;
+if(mt->pool != NULL)
+	{
+	mt->pool->Stop();
+	delete mt->pool;
+	}
+for(i = 0; i < mt->n_blks; ++i)
+	{
+	if(mt->ublks != NULL)
+		free(mt->ublks[i]);
+	if(mt->cblks != NULL)
+		free(mt->cblks[i]);
+	}
+free(mt->ublks);
+free(mt->cblks);
+free(mt->ulen);
+free(mt->clen);
+free(mt->errcode);
+free(mt->baddr);
+free(mt->vaddrs);
+free(mt);
+}
+
+// deflate and write all blocks queued in batch
+static int mt_flush_batch(BGZF *fp)
+{
+int i;
+mtaux_t *mt = (mtaux_t *)fp->mt;
+if(mt->curr == 0)
+	return 0;
+if((mt->n_written + mt->curr + 1) > mt->m_vaddrs)
+	{
+	int64_t *pTmp;
+	int64_t m_vaddrs = mt->m_vaddrs * 2 + mt->curr + 1;
+	if((pTmp = (int64_t *)realloc(mt->vaddrs, sizeof(int64_t) * m_vaddrs)) == NULL)
+		{
+		fp->errcode |= BGZF_ERR_IO;
+		return -1;
+		}
+	mt->vaddrs = pTmp;
+	mt->m_vaddrs = m_vaddrs;
+	}
+mt->pool->ParallelFor(mt->curr, 1, mt_deflate_blks, mt);
+for(i = 0; i < mt->curr; ++i)
+	{
+	if(mt->errcode[i] != 0)
+		{
+		fp->errcode |= mt->errcode[i];
+		return -1;
+		}
+	if(fwrite(mt->cblks[i], 1, mt->clen[i], (FILE *)fp->fp) != (size_t)mt->clen[i])
+		{
+		fp->errcode |= BGZF_ERR_IO; // possibly truncated file
+		return -1;
+		}
+	mt->vaddrs[mt->n_written + 1] = mt->vaddrs[mt->n_written] + mt->clen[i];
+	mt->n_written += 1;
+	}
+mt->curr = 0;
+return 0;
+}
+
+// queue the current uncompressed block into the batch, deflating and writing the batch when full
+static int mt_queue_block(BGZF *fp)
+{
+mtaux_t *mt = (mtaux_t *)fp->mt;
+memcpy(mt->ublks[mt->curr], fp->uncompressed_block, fp->block_offset);
+mt->ulen[mt->curr] = fp->block_offset;
+mt->curr += 1;
+fp->block_offset = 0;
+fp->block_address += 1;
+if(mt->curr == mt->n_blks)
+	return mt_flush_batch(fp);
+return 0;
+}
+
+// read ahead a batch of compressed blocks and inflate
+static int mt_read_batch(BGZF *fp)
+{
+uint8_t header[BLOCK_HEADER_LENGTH];
+size_t count, block_length, remaining;
+int64_t block_address;
+mtaux_t *mt = (mtaux_t *)fp->mt;
+
+mt->curr = 0;
+mt->nxt = 0;
+block_address = _bgzf_tell((_bgzf_file_t)fp->fp);
+while(mt->curr < mt->n_blks)
+	{
+	mt->baddr[mt->curr] = block_address;
+	mt->errcode[mt->curr] = 0;
+	count = _bgzf_read((FILE *)fp->fp, header, sizeof(header));
+	if (count == 0) 				// no data read
+		break;
+	if (count != sizeof(header) || !check_header(header)) 
+		{
+		mt->errcode[mt->curr++] = BGZF_ERR_HEADER;
+		break;
+		}
+	block_length = unpackInt16((uint8_t*)&header[16]) + 1; // +1 because when writing this number, we used "-1"
+	memcpy(mt->cblks[mt->curr], header, BLOCK_HEADER_LENGTH);
+	remaining = block_length - BLOCK_HEADER_LENGTH;
+	count = _bgzf_read((FILE *)fp->fp, &mt->cblks[mt->curr][BLOCK_HEADER_LENGTH], remaining);
+	mt->clen[mt->curr] = (int)block_length;
+	block_address += BLOCK_HEADER_LENGTH + count;
+	CRunProfile::Count(eRPCBytesRead,BLOCK_HEADER_LENGTH + count);
+	if(count != remaining)
+		{
+		mt->errcode[mt->curr++] = BGZF_ERR_IO;
+		break;
+		}
+	mt->curr += 1;
+	}
+mt->nxt_addr = block_address;
+if(mt->curr > 0)
+	mt->pool->ParallelFor(mt->curr, 1, mt_inflate_blks, mt);
+return 0;
+}
+
+// return next inflated block from batch, reading ahead another batch if all blocks in the current batch have been returned
+static int mt_read_block(BGZF *fp)
+{
+void *pTmp;
+mtaux_t *mt = (mtaux_t *)fp->mt;
+if(mt->nxt >= mt->curr)
+	mt_read_batch(fp);
+if(mt->curr == 0)
+	{ // no data read
+	fp->block_length = 0;
+	return 0;
+	}
+if(mt->errcode[mt->nxt] != 0)
+	{
+	fp->errcode |= mt->errcode[mt->nxt];
+	return -1;
+	}
+pTmp = fp->uncompressed_block;			// swap rather than copy the inflated block
+fp->uncompressed_block = mt->ublks[mt->nxt];
+mt->ublks[mt->nxt] = (uint8_t *)pTmp;
+if (fp->block_length != 0) 
+	fp->block_offset = 0; // Do not reset offset if this read follows a seek.
+fp->block_address = mt->baddr[mt->nxt];
+fp->block_length = mt->ulen[mt->nxt];
+mt->nxt += 1;
+return 0;
+}
+
+// file address of the block following the current block
+static int64_t next_block_address(BGZF *fp)
+{
+mtaux_t *mt = (mtaux_t *)fp->mt;
+if(mt == NULL)
+	return _bgzf_tell((_bgzf_file_t)fp->fp);
+return mt->nxt < mt->curr ? mt->baddr[mt->nxt] : mt->nxt_addr;
+}
+
+int bgzf_mt(BGZF *fp, int n_threads, int n_sub_blks)
+{
+int i;
+mtaux_t *mt;
+if(fp == NULL || fp->mt != NULL || n_threads < 2)
+	return -1;
+if(n_sub_blks < 1)
+	n_sub_blks = 1;
+if(fp->is_write && (fp->block_offset != 0 || fp->block_address != 0))	// must be enabled before any writes
+	return -1;
+if((mt = (mtaux_t *)calloc(1, sizeof(mtaux_t))) == NULL)
+	return -1;
+mt->fp = fp;
+mt->n_blks = n_threads * n_sub_blks;
+mt->ublks = (uint8_t **)calloc(mt->n_blks, sizeof(uint8_t *));
+mt->cblks = (uint8_t **)calloc(mt->n_blks, sizeof(uint8_t *));
+mt->ulen = (int *)calloc(mt->n_blks, sizeof(int));
+mt->clen = (int *)calloc(mt->n_blks, sizeof(int));
+mt->errcode = (int *)calloc(mt->n_blks, sizeof(int));
+mt->baddr = (int64_t *)calloc(mt->n_blks, sizeof(int64_t));
+mt->m_vaddrs = mt->n_blks + 1;
+mt->vaddrs = (int64_t *)calloc((size_t)mt->m_vaddrs, sizeof(int64_t));
+if(mt->ublks == NULL || mt->cblks == NULL || mt->ulen == NULL || mt->clen == NULL || mt->errcode == NULL || mt->baddr == NULL || mt->vaddrs == NULL)
+	{
+	mt_destroy(mt);
+	return -1;
+	}
+for(i = 0; i < mt->n_blks; ++i)
+	{
+	mt->ublks[i] = (uint8_t *)malloc(BGZF_MAX_BLOCK_SIZE);
+	mt->cblks[i] = (uint8_t *)malloc(BGZF_MAX_BLOCK_SIZE);
+	if(mt->ublks[i] == NULL || mt->cblks[i] == NULL)
+		{
+		mt_destroy(mt);
+		return -1;
+		}
+	}
+if((mt->pool = new CWorkPool) == NULL || mt->pool->Start(n_threads) < eBSFSuccess)
+	{
+	mt_destroy(mt);
+	return -1;
+	}
+fp->mt = mt;
+return 0;
+}
+
+int64_t bgzf_mt_vaddr(BGZF *fp, int64_t vaddr)
+{
+mtaux_t *mt = (mtaux_t *)fp->mt;
+int64_t block_num;
+if(mt == NULL || !fp->is_write)
+	return vaddr;
+block_num = vaddr >> 16;
+if(block_num > mt->n_written)		// block not yet written
+	return -1;
+return (mt->vaddrs[block_num] << 16) | (vaddr & 0xFFFF);
+}
+
+int bgzf_mt_flush_queued(BGZF *fp)
+{
+if(fp->mt == NULL || !fp->is_write)
+	return 0;
+return mt_flush_batch(fp);
+}
+
 int bgzf_read_block(BGZF *fp)
 {
 uint8_t header[BLOCK_HEADER_LENGTH], *compressed_block;
 size_t count, size = 0, block_length, remaining;
+int inflated_length;
 int64_t block_address;
+if(fp->mt != NULL)
+	return mt_read_block(fp);
 block_address = _bgzf_tell((_bgzf_file_t)fp->fp);
 if (fp->cache_size && load_block_from_cache(fp, block_address)) 
 	return 0;
@@ -358,12 +636,13 @@ memcpy(compressed_block, header, BLOCK_HEADER_LENGTH);
 remaining = block_length - BLOCK_HEADER_LENGTH;
 count = _bgzf_read((FILE *)fp->fp, &compressed_block[BLOCK_HEADER_LENGTH], remaining);
 size += count;
-if ((count = inflate_block(fp, (int)block_length)) < 0) 
+CRunProfile::Count(eRPCBytesRead,size);
+if ((inflated_length = inflate_block(fp, (int)block_length)) < 0) 
 	return -1;
 if (fp->block_length != 0) 
 	fp->block_offset = 0; // Do not reset offset if this read follows a seek.
 fp->block_address = block_address;
-fp->block_length = (int)count;
+fp->block_length = inflated_length;
 cache_block(fp, (int)size);
 return 0;
 }
@@ -406,7 +685,7 @@ while (bytes_read < length)
 	}
 if (fp->block_offset == fp->block_length) 
 	{
-	fp->block_address = _bgzf_tell((_bgzf_file_t)fp->fp);
+	fp->block_address = next_block_address(fp);
 	fp->block_offset = fp->block_length = 0;
 	}
 return bytes_read;
@@ -417,13 +696,19 @@ int bgzf_flush(BGZF *fp)
 {
 if (!fp->is_write) 
 	return 0;
+if(fp->mt != NULL)
+	{
+	if(fp->block_offset > 0 && mt_queue_block(fp) != 0)
+		return -1;
+	return mt_flush_batch(fp);
+	}
 while (fp->block_offset > 0) 
 	{
 	int block_length;
 	block_length = deflate_block(fp, fp->block_offset);
 	if (block_length < 0) 
 		return -1;
-	if (fwrite(fp->compressed_block, 1, block_length, (FILE *)fp->fp) != block_length) 
+	if (fwrite(fp->compressed_block, 1, block_length, (FILE *)fp->fp) != (size_t)block_length) 
 		{
 		fp->errcode |= BGZF_ERR_IO; // possibly truncated file
 		return -1;
@@ -437,7 +722,7 @@ int
 bgzf_flush_try(BGZF *fp, size_t size)
 {
 if (fp->block_offset + size > BGZF_BLOCK_SIZE)
-	return bgzf_flush(fp);
+	return fp->mt != NULL ? mt_queue_block(fp) : bgzf_flush(fp);
 return -1;
 }
 
@@ -455,7 +740,7 @@ while (bytes_written < length)
 	fp->block_offset += (int)copy_length;
 	input += copy_length;
 	bytes_written += copy_length;
-	if (fp->block_offset == block_length && bgzf_flush(fp)) 
+	if ((size_t)fp->block_offset == block_length && (fp->mt != NULL ? mt_queue_block(fp) : bgzf_flush(fp))) 
 		break;
 	}
 return bytes_written;
@@ -471,6 +756,8 @@ if (fp->is_write)
 	{
 	if (bgzf_flush(fp) != 0) 
 		return -1;
+	mt_destroy((mtaux_t *)fp->mt);		// any queued blocks were written by bgzf_flush(), EOF block is written serially
+	fp->mt = NULL;
 	fp->compress_level = -1;
 	block_length = deflate_block(fp, 0); // write an empty block
 	count = fwrite(fp->compressed_block, 1, block_length, (FILE *)fp->fp);
@@ -480,6 +767,11 @@ if (fp->is_write)
 		return -1;
 		}
 	}
+if(fp->mt != NULL)
+	{
+	mt_destroy((mtaux_t *)fp->mt);
+	fp->mt = NULL;
+	}
 ret = fp->is_write? fclose((FILE *)fp->fp) : _bgzf_close((FILE *)fp->fp);
 if (ret != 0) 
 	return -1;
@@ -529,6 +821,11 @@ if (_bgzf_seek((FILE *)fp->fp, block_address, SEEK_SET) < 0)
 	return -1;
 	}
 
+if(fp->mt != NULL)		// discard any blocks read ahead
+	{
+	((mtaux_t *)fp->mt)->curr = 0;
+	((mtaux_t *)fp->mt)->nxt = 0;
+	}
 fp->block_length = 0;  // indicates current block has not been loaded
 fp->block_address = block_address;
 fp->block_offset = block_offset;
@@ -562,7 +859,7 @@ if (fp->block_offset >= fp->block_length)
 c = ((uint8_t*)fp->uncompressed_block)[fp->block_offset++];
 if (fp->block_offset == fp->block_length) 
 	{
-	fp->block_address = _bgzf_tell((_bgzf_file_t)fp->fp);
+	fp->block_address = next_block_address(fp);
 	fp->block_offset = 0;
 	fp->block_length = 0;
 	}
@@ -607,7 +904,7 @@ do {
 	fp->block_offset += l + 1;
 	if (fp->block_offset >= fp->block_length) 
 		{
-		fp->block_address = _bgzf_tell((_bgzf_file_t)fp->fp);
+		fp->block_address = next_block_address(fp);
 		fp->block_offset = 0;
 		fp->block_length = 0;
 		} 
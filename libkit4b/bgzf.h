@@ -202,14 +202,38 @@ extern "C" {
 	int bgzf_read_block(BGZF *fp);
 
 	/**
-	 * Enable multi-threading (only effective on writing)
+	 * Enable multi-threading
 	 *
-	 * @param fp          BGZF file handler; must be opened for writing
-	 * @param n_threads   #threads used for writing
+	 * When writing, blocks are deflated in batches of n_threads*n_sub_blks and written in order. Until a
+	 * block has been written bgzf_tell() returns a provisional virtual offset which must be resolved with
+	 * bgzf_mt_vaddr() after bgzf_flush() or bgzf_mt_flush_queued(). When reading, batches of blocks are read ahead and inflated.
+	 *
+	 * @param fp          BGZF file handler; if writing then must be enabled before any data written
+	 * @param n_threads   #threads used for deflating or inflating, must be at least 2
 	 * @param n_sub_blks  #blocks processed by each thread; a value 64-256 is recommended
+	 * @return            0 on success and -1 otherwise
 	 */
 	int bgzf_mt(BGZF *fp, int n_threads, int n_sub_blks);
 
+	/**
+	 * Resolve a virtual offset returned by bgzf_tell() whilst multithreaded writing to the actual file virtual offset
+	 *
+	 * @param fp     BGZF file handler
+	 * @param vaddr  virtual offset as returned by bgzf_tell()
+	 * @return       actual virtual offset, or -1 if the block containing vaddr has not yet been written;
+	 *               vaddr is returned unchanged if fp is not multithreaded writing
+	 */
+	int64_t bgzf_mt_vaddr(BGZF *fp, int64_t vaddr);
+
+	/**
+	 * Whilst multithreaded writing then deflate and write all queued blocks, the block currently being filled is not
+	 * written so after this call all virtual offsets returned by bgzf_tell() can be resolved with bgzf_mt_vaddr()
+	 *
+	 * @param fp     BGZF file handler
+	 * @return       0 on success and -1 on error; 0 if fp is not multithreaded writing
+	 */
+	int bgzf_mt_flush_queued(BGZF *fp);
+
 #ifdef __cplusplus
 }
 #endif
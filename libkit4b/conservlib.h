@@ -11,8 +11,14 @@
 #include "./SeqTrans.h"
 #include "./Diagnostics.h"
 #include "./MTqsort.h"
+#include "./WorkPool.h"
+#include "./MTRadixSort.h"
+#include "./RunProfile.h"
+#include "./PBAcmp.h"
+#include "./PBAfile.h"
 #include "./Fasta.h"
 #include "./BEDfile.h"
+#include "./BEDSweep.h"
 #include "./BioSeqFile.h"
 #include "./HashFile.h"
 #include "./RsltsFile.h"
@@ -40,6 +46,7 @@
 #include "./Centroid.h"
 #include "./CSVFile.h"
 #include "./sais.h"
+#include "./FMIndex.h"
 #include "./HyperEls.h"
 #include "./FilterRefIDs.h"
 #include "./FilterLoci.h"
@@ -52,6 +59,8 @@
 #include "./GFFFile.h"
 #include "./sqlite3.h"
 #include "./CSQLitePSL.h"
+#include "./MinimizerIdx.h"
+#include "./ExtKMerCounts.h"
 #include "./CBlitz.h"
 #include "./CPBASfxArray.h"
 
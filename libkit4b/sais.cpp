@@ -23,7 +23,9 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
  * OTHER DEALINGS IN THE SOFTWARE.
  */
-// Changes made to original source code are purely to make function scope within the CSAIS class framework
+// Changes made to original source code are to make function scope within the CSAIS class framework,
+// to template the index type so that texts of 2^31 or longer can be processed with 64bit indexes,
+// to allow masking of flag bits in the initial text symbols, and to count the initial text bucket sizes with multiple threads
 #include "stdafx.h"
 
 #ifdef HAVE_CONFIG_H
@@ -39,59 +41,124 @@
 #include "./commhdrs.h"
 #endif
 
-//#include <stdlib.h>
-#ifdef _OPENMP
-# include <omp.h>
-#endif
 #include "sais.h"
 
+// initial text symbols are uint8_t (cs == 1) and masked with m_SymMsk, reduced problem texts are IDX
+#define chr(i) (cs == 1 ? (IDX)(((const uint8_t *)T)[i] & m_SymMsk) : ((const IDX *)T)[i])
 
-#define chr(i) (cs == sizeof(int) ? ((const int *)T)[i]:((const uint8_t *)T)[i])
+typedef struct TAG_sSAISCountsThread {
+	CSAIS *pThis;				// class instance
+	const uint8_t *T;			// initial text
+	uint8_t SymMsk;				// symbols masked with this
+	int64_t Start;				// count symbols starting from this offset
+	int64_t End;				// up to but excluding this offset
+	int64_t Counts[256];		// returned symbol counts
+	bool bStarted;				// true if thread was started, otherwise symbols are counted by the calling thread
+#ifdef _WIN32
+	HANDLE threadHandle;		// handle as returned by _beginthreadex()
+	unsigned int threadID;		// identifier as set by _beginthreadex()
+#else
+	int threadRslt;				// result as returned by pthread_create ()
+	pthread_t threadID;			// identifier as set by pthread_create ()
+#endif
+} tsSAISCountsThread;
 
-/* find the start or end of each bucket */
 void
-CSAIS::getCounts(const uint8_t *T, int *C, int n, int k, int cs) {
-#ifdef _OPENMP
-  int *D;
-  int i, j, p, sum, first, last;
-  int thnum, maxthreads = omp_get_max_threads();
-#pragma omp parallel default(shared) private(D, i, thnum, first, last)
-  {
-    thnum = omp_get_thread_num();
-    D = C + thnum * k;
-    first = n / maxthreads * thnum;
-    last = (thnum < (maxthreads - 1)) ? n / maxthreads * (thnum + 1) : n;
-    for(i = 0; i < k; ++i) { D[i] = 0; }
-    for(i = first; i < last; ++i) { ++D[chr(i)]; }
-  }
-  if(1 < maxthreads) {
-#pragma omp parallel for default(shared) private(i, j, p, sum)
-    for(i = 0; i < k; ++i) {
-      for(j = 1, p = i + k, sum = C[i]; j < maxthreads; ++j, p += k) {
-        sum += C[p];
-      }
-      C[i] = sum;
-    }
-  }
+CSAIS::SetNumThreads(int NumThreads)		// use at most this many threads (1..cMaxSAISThreads) when counting bucket sizes
+{
+if(NumThreads < 1)
+	NumThreads = 1;
+else
+	if(NumThreads > cMaxSAISThreads)
+		NumThreads = cMaxSAISThreads;
+m_NumThreads = NumThreads;
+}
+
+void
+CSAIS::CountSymbols(tsSAISCountsThread *pPars)	// count symbols over the thread's range of the initial text
+{
+const uint8_t *pT = &pPars->T[pPars->Start];
+int64_t Idx;
+memset(pPars->Counts,0,sizeof(pPars->Counts));
+for(Idx = pPars->Start; Idx < pPars->End; Idx++)
+	pPars->Counts[*pT++ & pPars->SymMsk] += 1;
+}
+
+#ifdef _WIN32
+unsigned __stdcall CSAIS::CountsThread(void * pThreadPars)
+#else
+void *CSAIS::CountsThread(void * pThreadPars)
+#endif
+{
+tsSAISCountsThread *pPars = (tsSAISCountsThread *)pThreadPars;
+CountSymbols(pPars);
+#ifdef _WIN32
+_endthreadex(0);
+return(0);
 #else
-  int i;
+pthread_exit(NULL);
+#endif
+}
+
+/* find the start or end of each bucket */
+template<typename IDX> void
+CSAIS::getCounts(const uint8_t *T, IDX *C, IDX n, IDX k, int cs) {
+  IDX i;
+  if(cs == 1 && k <= 256 && m_NumThreads > 1 && (int64_t)n >= cMinSAISThreadedLen) {
+	int ThreadIdx;
+	int64_t ThreadLen;
+	tsSAISCountsThread *pThreads;
+	tsSAISCountsThread *pThread;
+	if((pThreads = new tsSAISCountsThread [m_NumThreads]) != NULL) {
+		ThreadLen = ((int64_t)n + m_NumThreads - 1) / m_NumThreads;
+		for(ThreadIdx = 0, pThread = pThreads; ThreadIdx < m_NumThreads; ThreadIdx++, pThread++) {
+			pThread->pThis = this;
+			pThread->T = T;
+			pThread->SymMsk = m_SymMsk;
+			pThread->Start = ThreadLen * ThreadIdx;
+			pThread->End = min(pThread->Start + ThreadLen,(int64_t)n);
+#ifdef _WIN32
+			pThread->threadHandle = (HANDLE)_beginthreadex(NULL,0x0fffff,CountsThread,pThread,0,&pThread->threadID);
+			pThread->bStarted = pThread->threadHandle != 0 ? true : false;
+#else
+			pThread->threadRslt = pthread_create(&pThread->threadID,NULL,CountsThread,pThread);
+			pThread->bStarted = pThread->threadRslt == 0 ? true : false;
+#endif
+			}
+		for(i = 0; i < k; ++i) { C[i] = 0; }
+		for(ThreadIdx = 0, pThread = pThreads; ThreadIdx < m_NumThreads; ThreadIdx++, pThread++) {
+			if(!pThread->bStarted)		// thread could not be started so count it's range in this thread
+				CountSymbols(pThread);
+			else {
+#ifdef _WIN32
+				WaitForSingleObject(pThread->threadHandle,INFINITE);
+				CloseHandle(pThread->threadHandle);
+#else
+				pthread_join(pThread->threadID,NULL);
+#endif
+				}
+			for(i = 0; i < k; ++i) { C[i] += (IDX)pThread->Counts[i]; }
+			}
+		delete []pThreads;
+		return;
+		}
+	}
   for(i = 0; i < k; ++i) { C[i] = 0; }
   for(i = 0; i < n; ++i) { ++C[chr(i)]; }
-#endif
 }
 
-void
-CSAIS::getBuckets(const int *C, int *B, int k, int end) {
-  int i, sum = 0;
+template<typename IDX> void
+CSAIS::getBuckets(const IDX *C, IDX *B, IDX k, int end) {
+  IDX i, sum = 0;
   if(end) { for(i = 0; i < k; ++i) { sum += C[i]; B[i] = sum; } }
   else { for(i = 0; i < k; ++i) { sum += C[i]; B[i] = sum - C[i]; } }
 }
 
 /* compute SA and BWT */
-void
-CSAIS::induceSA(const uint8_t *T, int *SA, int *C, int *B, int n, int k, int cs) {
-  int *b, i, j;
-  int c0, c1;
+template<typename IDX> void
+CSAIS::induceSA(const uint8_t *T, IDX *SA, IDX *C, IDX *B, IDX n, IDX k, int cs) {
+  IDX *b, i, j;
+  IDX c0, c1;
   /* compute SAl */
   if(C == B) { getCounts(T, C, n, k, cs); }
   getBuckets(C, B, k, 0); /* find starts of buckets */
@@ -104,7 +171,7 @@ CSAIS::induceSA(const uint8_t *T, int *SA, int *C, int *B, int n, int k, int cs)
       --j;
       if((c0 = chr(j)) != c1) 
 		{ 
-		B[c1] = (int)(b - SA); 
+		B[c1] = (IDX)(b - SA); 
 		b = SA + B[c1 = c0]; 
 	    }
       *b++ = ((0 < j) && (chr(j - 1) < c1)) ? ~j : j;
@@ -118,7 +185,7 @@ CSAIS::induceSA(const uint8_t *T, int *SA, int *C, int *B, int n, int k, int cs)
       --j;
       if((c0 = chr(j)) != c1) 
 		{ 
-		B[c1] = (int)(b - SA); 
+		B[c1] = (IDX)(b - SA); 
 		b = SA + B[c1 = c0]; 
 		}
       *--b = ((j == 0) || (chr(j - 1) > c1)) ? ~j : j;
@@ -130,6 +197,7 @@ CSAIS::induceSA(const uint8_t *T, int *SA, int *C, int *B, int n, int k, int cs)
 
 int
 CSAIS::computeBWT(const uint8_t *T, int *SA, int *C, int *B, int n, int k, int cs) {
+  typedef int IDX;
   int *b, i, j, pidx = -1;
   int c0, c1;
   /* compute SAl */
@@ -177,52 +245,33 @@ CSAIS::computeBWT(const uint8_t *T, int *SA, int *C, int *B, int n, int k, int c
 
 /* find the suffix array SA of T[0..n-1] in {0..k-1}^n
    use a working space (excluding T and SA) of at most 2n+O(1) for a constant alphabet */
-int
-CSAIS::sais_main(const uint8_t *T, int *SA, int fs, int n, int k, int cs, int isbwt) {
-  int *C, *B, *RA;
-  int i, j, c, m, p, q, plen, qlen, name, pidx = 0;
-  int c0, c1;
+template<typename IDX> IDX
+CSAIS::sais_main(const uint8_t *T, IDX *SA, IDX fs, IDX n, IDX k, int cs, int isbwt) {
+  IDX *C, *B, *RA;
+  IDX i, j, c, m, p, q, plen, qlen, name, pidx = 0;
+  IDX c0, c1;
   int diff;
-#ifdef _OPENMP
-  int maxthreads = omp_get_max_threads();
-#else
-# define maxthreads 1
-#endif
 
   /* stage 1: reduce the problem by at least 1/2
      sort all the S-substrings */
-  if((maxthreads * k) <= fs) {
+  if(k <= fs) {
     C = SA + n;
-    B = ((1 < maxthreads) || (k <= (fs - k))) ? C + k : C;
+    B = (k <= (fs - k)) ? C + k : C;
   } else {
-    if((C = (int *)malloc(maxthreads * k * sizeof(int))) == NULL) { return -2; }
-    B = (1 < maxthreads) ? C + k : C;
+    if((C = (IDX *)malloc((size_t)k * sizeof(IDX))) == NULL) { return -2; }
+    B = C;
   }
   getCounts(T, C, n, k, cs); getBuckets(C, B, k, 1); /* find ends of buckets */
-#ifdef _OPENMP
-#pragma omp parallel for default(shared) private(i)
-#endif
   for(i = 0; i < n; ++i) { SA[i] = 0; }
   for(i = n - 2, c = 0, c1 = chr(n - 1); 0 <= i; --i, c1 = c0) {
     if((c0 = chr(i)) < (c1 + c)) { c = 1; }
     else if(c != 0) { SA[--B[c1]] = i + 1, c = 0; }
   }
   induceSA(T, SA, C, B, n, k, cs);
-  if(fs < (maxthreads * k)) { free(C); }
+  if(fs < k) { free(C); }
 
   /* compact all the sorted substrings into the first m items of SA
      2*m must be not larger than n (proveable) */
-#ifdef _OPENMP
-#pragma omp parallel for default(shared) private(i, j, p, c0, c1)
-  for(i = 0; i < n; ++i) {
-    p = SA[i];
-    if((0 < p) && (chr(p - 1) > (c0 = chr(p)))) {
-      for(j = p + 1; (j < n) && (c0 == (c1 = chr(j))); ++j) { }
-      if((j < n) && (c0 < c1)) { SA[i] = ~p; }
-    }
-  }
-  for(i = 0, m = 0; i < n; ++i) { if((p = SA[i]) < 0) { SA[m++] = ~p; } }
-#else
   for(i = 0, m = 0; i < n; ++i) {
     p = SA[i];
     if((0 < p) && (chr(p - 1) > (c0 = chr(p)))) {
@@ -230,11 +279,7 @@ CSAIS::sais_main(const uint8_t *T, int *SA, int fs, int n, int k, int cs, int is
       if((j < n) && (c0 < c1)) { SA[m++] = p; }
     }
   }
-#endif
   j = m + (n >> 1);
-#ifdef _OPENMP
-#pragma omp parallel for default(shared) private(i)
-#endif
   for(i = m; i < j; ++i) { SA[i] = 0; } /* init the name array buffer */
   /* store the length of all substrings */
   for(i = n - 2, j = n, c = 0, c1 = chr(n - 1); 0 <= i; --i, c1 = c0) {
@@ -259,57 +304,49 @@ CSAIS::sais_main(const uint8_t *T, int *SA, int fs, int n, int k, int cs, int is
     for(i = m + (n >> 1) - 1, j = m - 1; m <= i; --i) {
       if(SA[i] != 0) { RA[j--] = SA[i] - 1; }
     }
-    if(sais_main((uint8_t *)RA, SA, fs + n - m * 2, m, name, sizeof(int), 0) != 0) { return -2; }
+    if(sais_main((uint8_t *)RA, SA, fs + n - m * 2, m, name, (int)sizeof(IDX), 0) != 0) { return -2; }
     for(i = n - 2, j = m - 1, c = 0, c1 = chr(n - 1); 0 <= i; --i, c1 = c0) {
       if((c0 = chr(i)) < (c1 + c)) { c = 1; }
       else if(c != 0) { RA[j--] = i + 1, c = 0; } /* get p1 */
     }
-#ifdef _OPENMP
-#pragma omp parallel for default(shared) private(i)
-#endif
     for(i = 0; i < m; ++i) { SA[i] = RA[SA[i]]; } /* get index */
   }
 
   /* stage 3: induce the result for the original problem */
-  if((maxthreads * k) <= fs) {
+  if(k <= fs) {
     C = SA + n;
-    B = ((1 < maxthreads) || (k <= (fs - k))) ? C + k : C;
+    B = (k <= (fs - k)) ? C + k : C;
   } else {
-    if((C = (int *)malloc(maxthreads * k * sizeof(int))) == NULL) { return -2; }
-    B = (1 < maxthreads) ? C + k : C;
+    if((C = (IDX *)malloc((size_t)k * sizeof(IDX))) == NULL) { return -2; }
+    B = C;
   }
   /* put all left-most S characters into their buckets */
   getCounts(T, C, n, k, cs); getBuckets(C, B, k, 1); /* find ends of buckets */
-#ifdef _OPENMP
-#pragma omp parallel for default(shared) private(i)
-#endif
   for(i = m; i < n; ++i) { SA[i] = 0; } /* init SA[m..n-1] */
   for(i = m - 1; 0 <= i; --i) {
     j = SA[i], SA[i] = 0;
     SA[--B[chr(j)]] = j;
   }
   if(isbwt == 0) { induceSA(T, SA, C, B, n, k, cs); }
-  else { pidx = computeBWT(T, SA, C, B, n, k, cs); }
-  if(fs < (maxthreads * k)) { free(C); }
+  else { pidx = (IDX)computeBWT(T, (int *)SA, (int *)C, (int *)B, (int)n, (int)k, cs); }
+  if(fs < k) { free(C); }
 
   return pidx;
-#ifndef _OPENMP
-# undef maxthreads
-#endif
 }
 
 int
 CSAIS::sais(const uint8_t *T, int *SA, int n) {
   if((T == NULL) || (SA == NULL) || (n < 0)) { return -1; }
   if(n <= 1) { if(n == 1) { SA[0] = 0; } return 0; }
-  return sais_main(T, SA, 0, n, 256, sizeof(uint8_t), 0);
+  m_SymMsk = 0x0ff;
+  return sais_main<int>(T, SA, 0, n, 256, 1, 0);
 }
 
 int
 CSAIS::sais_int(const int *T, int *SA, int n, int k) {
   if((T == NULL) || (SA == NULL) || (n < 0) || (k <= 0)) { return -1; }
   if(n <= 1) { if(n == 1) { SA[0] = 0; } return 0; }
-  return sais_main((const uint8_t *)T, SA, 0, n, k, sizeof(int), 0);
+  return sais_main<int>((const uint8_t *)T, SA, 0, n, k, (int)sizeof(int), 0);
 }
 
 int
@@ -317,7 +354,8 @@ CSAIS::sais_bwt(const uint8_t *T, uint8_t *U, int *A, int n) {
   int i, pidx;
   if((T == NULL) || (U == NULL) || (A == NULL) || (n < 0)) { return -1; }
   if(n <= 1) { if(n == 1) { U[0] = T[0]; } return n; }
-  pidx = sais_main(T, A, 0, n, 256, sizeof(uint8_t), 1);
+  m_SymMsk = 0x0ff;
+  pidx = sais_main<int>(T, A, 0, n, 256, 1, 1);
   if(pidx < 0) { return pidx; }
   U[0] = T[n - 1];
   for(i = 0; i < pidx; ++i) { U[i + 1] = (uint8_t)A[i]; }
@@ -331,7 +369,7 @@ CSAIS::sais_int_bwt(const int *T, int *U, int *A, int n, int k) {
   int i, pidx;
   if((T == NULL) || (U == NULL) || (A == NULL) || (n < 0)) { return -1; }
   if(n <= 1) { if(n == 1) { U[0] = T[0]; } return n; }
-  pidx = sais_main((const uint8_t *)T, A, 0, n, k, sizeof(int), 1);
+  pidx = sais_main<int>((const uint8_t *)T, A, 0, n, k, (int)sizeof(int), 1);
   if(pidx < 0) { return pidx; }
   U[0] = T[n - 1];
   for(i = 0; i < pidx; ++i) { U[i + 1] = A[i]; }
@@ -339,3 +377,19 @@ CSAIS::sais_int_bwt(const int *T, int *U, int *A, int n, int k) {
   pidx += 1;
   return pidx;
 }
+
+int
+CSAIS::sais_msk(const uint8_t *T, int32_t *SA, int32_t n, int k, uint8_t SymMsk) {
+  if((T == NULL) || (SA == NULL) || (n < 0) || (k <= 0) || (k > 256)) { return -1; }
+  if(n <= 1) { if(n == 1) { SA[0] = 0; } return 0; }
+  m_SymMsk = SymMsk;
+  return sais_main<int32_t>(T, SA, 0, n, k, 1, 0);
+}
+
+int
+CSAIS::sais_msk(const uint8_t *T, int64_t *SA, int64_t n, int k, uint8_t SymMsk) {
+  if((T == NULL) || (SA == NULL) || (n < 0) || (k <= 0) || (k > 256)) { return -1; }
+  if(n <= 1) { if(n == 1) { SA[0] = 0; } return 0; }
+  m_SymMsk = SymMsk;
+  return (int)sais_main<int64_t>(T, SA, 0, n, k, 1, 0);
+}
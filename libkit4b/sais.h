@@ -1,23 +1,44 @@
 #pragma once
 
+const int cMaxSAISThreads = 64;				// bucket counting over the initial text can use at most this many threads
+const int64_t cMinSAISThreadedLen = 0x0ffffff;	// only worth using multiple threads for bucket counting if text is at least this length
+
+typedef struct TAG_sSAISCountsThread tsSAISCountsThread;
+
 class CSAIS
 {
-	void getCounts(const uint8_t *T, int *C, int n, int k, int cs); // find the start or end of each bucket
-	void getBuckets(const int *C, int *B, int k, int end);
-	void induceSA(const uint8_t *T, int *SA, int *C, int *B, int n, int k, int cs); // compute SA and BWT
+	int m_NumThreads;						// use at most this many threads when counting bucket sizes over the initial text
+	uint8_t m_SymMsk;						// symbols in the initial uint8_t text are masked with this before being sorted
+
+	template<typename IDX> void getCounts(const uint8_t *T, IDX *C, IDX n, IDX k, int cs); // find the start or end of each bucket
+	template<typename IDX> void getBuckets(const IDX *C, IDX *B, IDX k, int end);
+	template<typename IDX> void induceSA(const uint8_t *T, IDX *SA, IDX *C, IDX *B, IDX n, IDX k, int cs); // compute SA and BWT
 	int computeBWT(const uint8_t *T, int *SA, int *C, int *B, int n, int k, int cs);
 
 	/* find the suffix array SA of T[0..n-1] in {0..k-1}^n
 		use a working space (excluding T and SA) of at most 2n+O(1) for a constant alphabet */
-	int sais_main(const uint8_t *T, int *SA, int fs, int n, int k, int cs, int isbwt);
+	template<typename IDX> IDX sais_main(const uint8_t *T, IDX *SA, IDX fs, IDX n, IDX k, int cs, int isbwt);
+
+	static void CountSymbols(tsSAISCountsThread *pPars);	// count symbols over the thread's range of the initial text
+#ifdef _WIN32
+	static unsigned __stdcall CountsThread(void * pThreadPars);
+#else
+	static void *CountsThread(void * pThreadPars);
+#endif
 
 public:
-	CSAIS(void){};
+	CSAIS(void){ m_NumThreads = 1; m_SymMsk = 0x0ff; };
 	~CSAIS(void){};
 
+	void SetNumThreads(int NumThreads);		// use at most this many threads (1..cMaxSAISThreads) when counting bucket sizes
+
 	int sais(const uint8_t *T, int *SA, int n);
 	int sais_int(const int *T, int *SA, int n, int k);
 	int sais_bwt(const uint8_t *T, uint8_t *U, int *A, int n);
 	int sais_int_bwt(const int *T, int *U, int *A, int n, int k);
 
+	// suffix array over T[0..n-1] with each symbol masked by SymMsk before being sorted, symbols after masking must be in range 0..k-1
+	// used when T contains sequence bases which may have flags in the bits not used for comparisons
+	int sais_msk(const uint8_t *T, int32_t *SA, int32_t n, int k, uint8_t SymMsk);		// n must be < 2^31
+	int sais_msk(const uint8_t *T, int64_t *SA, int64_t n, int k, uint8_t SymMsk);		// for texts of 2^31 or longer
 };
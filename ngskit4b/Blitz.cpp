@@ -65,7 +65,8 @@ Process(etBLZPMode PMode,				// processing mode
 		char *pszInputFilePE2,			// name of input file containing PE2 query sequences (only applies if output format is SAM)
 		char *pszSfxFile,				// target as suffix array
 		char *pszOutFile,				// where to write alignments
-		int NumThreads);				// number of worker threads to use
+		int NumThreads,					// number of worker threads to use
+		etBLZSeedMode SeedMode);		// seed from suffix array cores or minimizer index
 
 
 #ifdef _WIN32
@@ -93,6 +94,7 @@ bool KMerDist;				// true if K_mer counts distributions to be reported
 
 int NumberOfProcessors;		// number of installed CPUs
 int NumThreads;				// number of threads (0 defaults to number of CPUs)
+int SfxLoadMode;				// suffix array load mode: 0 - read into process memory, 1 - memory mapped, 2 - memory mapped with readahead, 3 - memory mapped and prefetched
 int SampleNthRawRead;		// sample every Nth raw read (or read pair) for processing (1..10000)
 int Sensitivity;			// sensitivity 0 - standard, 1 - high, 2 - very high, 3 - low sensitivity (default is 0)
 
@@ -103,6 +105,7 @@ int GapOpenScore;			// decrease score by this for each gap open
 int CoreLen;				// use this core length as the exactly matching seed length to be 5' and 3' extended whilst no more than m_MaxSubRate
 int CoreDelta;				// offset cores by this many bp
 int MaxOccKMerDepth;		// maximum depth to explore over-occurring core K-mers
+int SeedMode;				// seeding: 0 - suffix array cores, 1 - minimizer index
 int MaxInsertLen;			// SAM output, accept observed insert sizes of at most this (default = 100000)
 
 int FiltMinLen;				// filter out input sequences less than this length
@@ -161,6 +164,8 @@ struct arg_int *filtminlen = arg_int0("l","minlen","<int>",	"filter out input se
 struct arg_int *filtmaxlen = arg_int0("L","maxlen","<int>",	"filter out input sequences more than this length (default is 100000, range 100..16Mbp)");
 
 struct arg_int *threads = arg_int0("T","threads","<int>",			"number of processing threads 0..128 (defaults to 0 which sets threads to number of CPU cores)");
+struct arg_int *sfxmmap = arg_int0(NULL,"sfxmmap","<int>",		"suffix array loading: 0 - read into process memory, 1 - memory map shared with other processes, 2 - memory map with readahead, 3 - memory map and prefetch all (default 0)");
+struct arg_int *seedidx = arg_int0(NULL,"seedidx","<int>",		"seeding: 0 - suffix array cores, 1 - minimizer k-mer index loaded from, or if not present built and saved to, suffix array file name with '.mzi' appended (default 0)");
 
 struct arg_file *summrslts = arg_file0("q","sumrslts","<file>",		"Output results summary to this SQLite3 database file");
 struct arg_str *experimentname = arg_str0("w","experimentname","<str>",		"experiment name SQLite3 database file");
@@ -172,7 +177,7 @@ void *argtable[] = {help,version,FileLogLevel,LogFile,
 					kmerdist,
 					summrslts,experimentname,experimentdescr,
 					pmode,samplenthrawread,filtminlen,filtmaxlen,sensitivity,alignstrand,mismatchscore,exactmatchscore,gapopenscore,coredelta,corelen,maxinsertlen,maxocckmerdepth,minpathscore,querylendpct,maxpathstoreport,format,
-					inputfile,inputfilepe2,sfxfile,outfile,threads,
+					inputfile,inputfilepe2,sfxfile,outfile,threads,sfxmmap,seedidx,
 					end};
 
 char **pAllArgs;
@@ -423,6 +428,13 @@ if (!argerrors)
 		exit(1);
 		}
 
+	SeedMode = seedidx->count ? seedidx->ival[0] : (int)eBLZSeedSfx;
+	if(SeedMode < (int)eBLZSeedSfx || SeedMode >= (int)eBLZSeedplaceholder)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: seeding '--seedidx=%d' specified outside of range %d..%d\n",SeedMode,(int)eBLZSeedSfx,(int)eBLZSeedplaceholder-1);
+		exit(1);
+		}
+
 	MinPathScore = minpathscore->count ?  minpathscore->ival[0] : MinPathScore;
 	if(MinPathScore != 0 && (MinPathScore < cMinBlitzPathScore) || MinPathScore > cMaxBlitzPathScore)
 		{
@@ -459,6 +471,14 @@ if (!argerrors)
 		NumThreads = MaxAllowedThreads;
 		}
 
+	SfxLoadMode = sfxmmap->count ? sfxmmap->ival[0] : (int)eSfxLoadRead;
+	if(SfxLoadMode < (int)eSfxLoadRead || SfxLoadMode >= (int)eSfxLoadPlaceholder)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Suffix array load mode '--sfxmmap=%d' specified outside of range %d..%d\n",SfxLoadMode,(int)eSfxLoadRead,(int)eSfxLoadPlaceholder-1);
+		exit(1);
+		}
+	CSfxArray::SetDfltLoadMode((etSfxLoadMode)SfxLoadMode);
+
 	strcpy(szTargFile,sfxfile->filename[0]);
 	strcpy(szInputFile,inputfile->filename[0]);
 	if(FMode != eBLZRsltsSAM && inputfilepe2->count)
@@ -533,6 +553,7 @@ if (!argerrors)
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Maximum depth to explore over-occurring seed K-mers : Auto");
 	else
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Maximum depth to explore over-occurring seed K-mers : %d",MaxOccKMerDepth);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Seeding : %s",SeedMode == eBLZSeedMzIdx ? "minimizer k-mer index" : "suffix array cores");
 	if(MinPathScore == 0)
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Minimum path score : Auto");
 	else
@@ -579,6 +600,21 @@ if (!argerrors)
 	if(szExperimentName[0] != '\0')
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"This processing reference: %s",szExperimentName);
 
+	switch(SfxLoadMode) {
+		case eSfxLoadRead:
+			pszDescr = "read into process memory";
+			break;
+		case eSfxLoadMmap:
+			pszDescr = "memory mapped";
+			break;
+		case eSfxLoadMmapWillNeed:
+			pszDescr = "memory mapped with readahead";
+			break;
+		case eSfxLoadMmapPopulate:
+			pszDescr = "memory mapped and prefetched";
+			break;
+		}
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"suffix array loading : %s",pszDescr);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"number of threads : %d",NumThreads);
 
 	if(gExperimentID > 0)
@@ -601,6 +637,7 @@ if (!argerrors)
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(CoreDelta),"coredelta",&CoreDelta);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID, ePTInt32, (int)sizeof(MaxInsertLen), "maxinsertlen", &MaxInsertLen);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(MaxOccKMerDepth),"maxocckmerdepth",&MaxOccKMerDepth);
+		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(SeedMode),"seedidx",&SeedMode);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(MinPathScore),"minpathscore",&MinPathScore);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(QueryLenAlignedPct),"querylendpct",&QueryLenAlignedPct);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(MaxPathsToReport),"maxpathstoreport",&MaxPathsToReport);
@@ -618,15 +655,15 @@ if (!argerrors)
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTText,(int)strlen(szExperimentDescr),"experimentdescr",szExperimentDescr);
 		}
 
-	sprintf(szBlitzParams,"mode: %d sensitivity: %d mismatchscore: %d exactmatchscore: %d gapopenscore: %d alignstrand: %d corelen: %d coredelta: %d maxinsertlen: %d maxocckmerdepth: %d minpathscore: %d querylendpct: %d maxpathstoreport: %d",
-							PMode, Sensitivity, MismatchScore, ExactMatchScore, GapOpenScore,AlignStrand,CoreLen,CoreDelta, MaxInsertLen,MaxOccKMerDepth,MinPathScore,QueryLenAlignedPct,MaxPathsToReport);
+	sprintf(szBlitzParams,"mode: %d sensitivity: %d mismatchscore: %d exactmatchscore: %d gapopenscore: %d alignstrand: %d corelen: %d coredelta: %d maxinsertlen: %d maxocckmerdepth: %d minpathscore: %d querylendpct: %d maxpathstoreport: %d seedidx: %d",
+							PMode, Sensitivity, MismatchScore, ExactMatchScore, GapOpenScore,AlignStrand,CoreLen,CoreDelta, MaxInsertLen,MaxOccKMerDepth,MinPathScore,QueryLenAlignedPct,MaxPathsToReport,SeedMode);
 
 #ifdef _WIN32
 	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
 #endif
 	gStopWatch.Start();
 	Rslt = Process((etBLZPMode)PMode, SampleNthRawRead,szExperimentName,szExperimentDescr,szBlitzParams, FiltMinLen,FiltMaxLen,KMerDist,(etBLZSensitivity)Sensitivity,(eALStrand)AlignStrand,MismatchScore,ExactMatchScore,GapOpenScore,CoreLen, CoreDelta, MaxInsertLen,
-							MaxOccKMerDepth, MinPathScore,QueryLenAlignedPct,MaxPathsToReport,(etBLZRsltsFomat)FMode,szInputFile,szInputFilePE2,szTargFile,szRsltsFile,NumThreads);
+							MaxOccKMerDepth, MinPathScore,QueryLenAlignedPct,MaxPathsToReport,(etBLZRsltsFomat)FMode,szInputFile,szInputFilePE2,szTargFile,szRsltsFile,NumThreads,(etBLZSeedMode)SeedMode);
 	Rslt = Rslt >=0 ? 0 : 1;
 	if(gExperimentID > 0)
 		{
@@ -675,7 +712,8 @@ Process(etBLZPMode PMode,				// processing mode
 	char* pszInputFilePE2,			// name of input file containing PE2 query sequences (only applies if output format is SAM)
 	char* pszSfxFile,				// target as suffix array
 	char* pszOutFile,				// where to write alignments
-	int NumThreads)					// number of worker threads to use
+	int NumThreads,					// number of worker threads to use
+	etBLZSeedMode SeedMode)			// seed from suffix array cores or minimizer index
 {
 	int Rslt;
 	CBlitz* pBlitzer; 
@@ -686,7 +724,7 @@ Process(etBLZPMode PMode,				// processing mode
 		return(eBSFerrObj);
 	}
 	Rslt = pBlitzer->Process((char *)gpszSubProcess->pszName,PMode, SampleNthRawRead, pszExprName, pszExprDescr, pszParams, FiltMinLen, FiltMaxLen, KMerDist, Sensitivity, AlignStrand, MismatchScore, ExactMatchScore, GapOpenScore, CoreLen, CoreDelta, MaxInsertLen, MaxOccKMerDepth,
-		MinPathScore, QueryLenAlignedPct, MaxPathsToReport, RsltsFormat, pszInputFile, pszInputFilePE2, pszSfxFile, pszOutFile, NumThreads);
+		MinPathScore, QueryLenAlignedPct, MaxPathsToReport, RsltsFormat, pszInputFile, pszInputFilePE2, pszSfxFile, pszOutFile, NumThreads, SeedMode);
 	delete pBlitzer;
 	return(Rslt);
 }
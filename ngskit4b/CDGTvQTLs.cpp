@@ -1193,86 +1193,25 @@ CDGTvQTLs::LoadPBAFile(char* pszFile,	// load chromosome metadata and PBA data f
 	bool bChromMetaOnly)  // load chrom metadata (chrom name,length, file offset at which chrom PBAs start) but don't actually load the chromosome PBAs
 {
 	int Rslt;
-	int Version;
-	char szExperimentID[100];
-	char szRefAssemblyID[100];
-	char szReadsetID[100];
+	int32_t ChromIdx;
 	uint32_t PrevChromMetadataIdx;
 	uint32_t ChromID;
 	uint32_t ReadsetID;
 	tsCHReadsetMetadata* pReadsetMetadata;
 	tsCHChromMetadata* pChromMetadata;
 	tsCHChromMetadata* pPrevChromMetadata;
-	int64_t FileOfsPBA;
-	uint8_t* pBuff;
-	int scanlen;
-	int NumTags;
+	tsPBAChrom* pPBAChrom;
+	CPBAfile PBAFile;
 
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "Loading '%s' file", pszFile);
-#ifdef _WIN32
-	m_hInFile = open(pszFile, O_READSEQ);		// file access is normally sequential..
-#else
-	m_hInFile = open64(pszFile, O_READSEQ);		// file access is normally sequential..
-#endif
-	if (m_hInFile == -1)							// check if file open succeeded
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to open input file '%s' : %s", pszFile, strerror(errno));
-		return(eBSFerrOpnFile);
-	}
-
-	// attempt to load the readset metadata 
-	m_InNumBuffered = 0;
-	m_InNumProcessed = 0;
-	if ((FillInBuffer(500, min(m_AllocInBuff, 500u)) == 0) || m_InNumBuffered < 9) // 500 will cover the maximally sized header
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to read at least a partial header from input file '%s'", pszFile);
-		return(eBSFerrOpnFile);
-	}
-
-
-	// check file type is PBA
-// check file type is PBA
-	if (strncmp((char*)m_pInBuffer, "Type:PbA", 8))
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists, unable to parse file type header tag as being a packed base allele file", pszFile);
-		return(eBSFerrOpnFile);
-	}
-	// file type in header expected to be followed by a new line, not carriage return then a new line!
-	if (m_pInBuffer[8] != '\n' && m_pInBuffer[9] != 'V')
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists, file type header tag is for a PBA type but this tag is incorrectly terminated. Has file been transformed into ascii?", pszFile);
-		return(eBSFerrOpnFile);
-	}
-	m_InNumProcessed = 9;
-
-	if (m_InNumBuffered < 500)
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists, unable to read complete header and initial chromosome metadata, expecting file size >= 500, is it a packed base allele file", pszFile);
-		return(eBSFerrOpnFile);
-	}
-
-	// parse out tagnames and associated values
-	pBuff = &m_pInBuffer[m_InNumProcessed];
-	NumTags = sscanf((char*)pBuff, "Version:%d\nExperimentID:%99[^\n]\nReferenceID:%99[^\n]\nReadsetID:%99[^\n]%n", &Version, szExperimentID, szRefAssemblyID, szReadsetID, &scanlen);
-	if (NumTags != 4 || Version != 1 || szExperimentID[0] == '\0' || szRefAssemblyID[0] == '\0' || szReadsetID[0] == '\0')
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists as a packed base allele file but inconsistencies in header tag values", pszFile);
-		return(eBSFerrOpnFile);
-	}
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "Metadata ExperimentID:%s, ReferenceID:%s, ReadsetID:%s", szExperimentID, szRefAssemblyID, szReadsetID);
+	// header is parsed and chromosome metadata loaded from either the v2 chromosome directory or, for v1 files, by skipping from chromosome to chromosome
+	if ((Rslt = PBAFile.Open(pszFile)) != eBSFSuccess)
+		return(Rslt);
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "Metadata Version:%d, ExperimentID:%s, ReferenceID:%s, ReadsetID:%s", PBAFile.Version(), PBAFile.ExperimentID(), PBAFile.ReferenceID(), PBAFile.ReadsetID());
 
-	m_InNumProcessed += scanlen + 1;		// header tags were '\n' terminated except for final which was '\0' terminated
-
-	m_InFileOfs = m_InNumProcessed;         // 1st chromosome starts immediately following the header metadata
-	if (_lseeki64(m_hInFile, m_InFileOfs, SEEK_SET) != m_InFileOfs)
+	if ((ReadsetID = AddReadset(PBAFile.ReadsetID(), ReadsetType)) == 0)
 	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists as a packed base allele file but unable to seek past header metadata", pszFile);
-		return(eBSFerrOpnFile);
-	}
-
-	if ((ReadsetID = AddReadset(szReadsetID, ReadsetType)) == 0)
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' duplicates the ReadsetID '%s' of a previously loaded readset", pszFile, szReadsetID);
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' duplicates the ReadsetID '%s' of a previously loaded readset", pszFile, PBAFile.ReadsetID());
 		return(eBSFerrOpnFile);
 	}
 
@@ -1281,47 +1220,27 @@ CDGTvQTLs::LoadPBAFile(char* pszFile,	// load chromosome metadata and PBA data f
 	pReadsetMetadata->ReadsetType = ReadsetType;
 	pReadsetMetadata->NumChroms = 0;
 	strcpy(pReadsetMetadata->szFileName, pszFile);
-	strcpy(pReadsetMetadata->szExperimentID, szExperimentID);
-	strcpy(pReadsetMetadata->szRefAssemblyID, szRefAssemblyID);
+	strcpy(pReadsetMetadata->szExperimentID, PBAFile.ExperimentID());
+	strcpy(pReadsetMetadata->szRefAssemblyID, PBAFile.ReferenceID());
 	pReadsetMetadata->ReadsetID = ReadsetID;
 	pReadsetMetadata->StartChromID = 0;
 	pReadsetMetadata->StartChromMetadataIdx = 0;
-	pReadsetMetadata->NxtFileChromOfs = m_InFileOfs;
-
-	int ChromNameLen;
-	char* pszChromName;
-	int32_t ChromLen;
+	pReadsetMetadata->NxtFileChromOfs = PBAFile.EndFileOfs();
 
 	// iterate over all chromosomes
-	m_InNumProcessed = 0;
-	m_InNumBuffered = 0;
 	PrevChromMetadataIdx = 0;
-	while (FillInBuffer((uint32_t)110, 110) == 110) // reading chromosome metadata
-	{
-		pBuff = &m_pInBuffer[m_InNumProcessed++];
-		ChromNameLen = (int)*pBuff++;
-		pszChromName = (char*)pBuff;
-		pBuff += (int64_t)1 + ChromNameLen;
-		ChromLen = *(int32_t*)pBuff;
-		FileOfsPBA = pReadsetMetadata->NxtFileChromOfs + ChromNameLen + 6;
-		pReadsetMetadata->NxtFileChromOfs += (int64_t)ChromNameLen + 6 + ChromLen;
+	for (ChromIdx = 0; ChromIdx < PBAFile.NumChroms(); ChromIdx++)
+	{
+		pPBAChrom = PBAFile.Chrom(ChromIdx);
 		// check if this chromosome is to be retained for further processing
-		if (!AcceptThisChromName(pszChromName))
-		{
-			// not accepting this chromosome
-			m_InFileOfs = pReadsetMetadata->NxtFileChromOfs;         // skip over curent chrom's PBAs to start of next chromosome
-			if ((pReadsetMetadata->NxtFileChromOfs = _lseeki64(m_hInFile, m_InFileOfs, SEEK_SET)) != m_InFileOfs)
-				break;
-			m_InNumProcessed = 0;
-			m_InNumBuffered = 0;
+		if (!AcceptThisChromName(pPBAChrom->szChromName))
 			continue;
-		}
 
 		// before accepting chrom then ensure that it's PBA length matches the BED chromosome sizes
-		ChromID = AddChrom(pszChromName);
-		if (ChromLen != m_ChromSizes[ChromID - 1])
+		ChromID = AddChrom(pPBAChrom->szChromName);
+		if (pPBAChrom->ChromLen != m_ChromSizes[ChromID - 1])
 		{
-			gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' with readset '%s' has chromosome '%s' size mismatch - expected size was %d, actual size %d", pszFile, szReadsetID, pszChromName, m_ChromSizes[ChromID - 1], ChromLen);
+			gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' with readset '%s' has chromosome '%s' size mismatch - expected size was %d, actual size %d", pszFile, PBAFile.ReadsetID(), pPBAChrom->szChromName, m_ChromSizes[ChromID - 1], pPBAChrom->ChromLen);
 			return(eBSFerrChrom);
 		}
 
@@ -1344,40 +1263,28 @@ CDGTvQTLs::LoadPBAFile(char* pszFile,	// load chromosome metadata and PBA data f
 		pChromMetadata->ChromID = ChromID;
 		pChromMetadata->ChromMetadataIdx = m_UsedNumChromMetadata;
 		pChromMetadata->NxtChromMetadataIdx = 0;
-		pChromMetadata->ChromLen = ChromLen;
+		pChromMetadata->ChromLen = pPBAChrom->ChromLen;
 		pChromMetadata->ReadsetID = ReadsetID;
 		pChromMetadata->HGBinID = 0;
-		pChromMetadata->FileOfsPBA = FileOfsPBA;
+		pChromMetadata->FileOfsPBA = pPBAChrom->FileOfsPBA;
 		pChromMetadata->pPBAs = nullptr;
 		if (bChromMetaOnly) // loading chrom metadata only without actually loading the chromosome PBAs?
-		{
-			m_InFileOfs = pReadsetMetadata->NxtFileChromOfs;         // skip over curent chrom's PBAs to start of next chromosome
-			if ((pReadsetMetadata->NxtFileChromOfs = _lseeki64(m_hInFile, m_InFileOfs, SEEK_SET)) != m_InFileOfs)
-				break;
-			m_InNumProcessed = 0;
-			m_InNumBuffered = 0;
 			continue;
-		}
-		// loading PBAs
-		pChromMetadata->pPBAs = AllocPBAs(ChromLen);
-		m_InNumProcessed += ChromNameLen + 5;
-		FillInBuffer((uint32_t)ChromLen, ChromLen);
-		pBuff = &m_pInBuffer[m_InNumProcessed];
 
+		// loading PBAs, v2 files are memory mapped with only those pages modified by validation or trimming being copied
+		if ((pChromMetadata->pPBAs = PBAFile.LoadChromPBAs(ChromIdx)) == nullptr)
+			return(eBSFerrFileAccess);
 
-		memcpy(pChromMetadata->pPBAs, pBuff, ChromLen);
-		m_InNumProcessed += ChromLen;
 		//	validate PBA allele composition, earlier releases were retaining very low allele proportions so validating and in-place replacing these as being non-alignments
-		int NumErrs = ValidatePBAs(ChromLen, pChromMetadata->pPBAs, true, true);
+		ValidatePBAs(pChromMetadata->ChromLen, pChromMetadata->pPBAs, true, true);
 		//
 		if (ReadsetType == 0)
-			TrimPBAs(m_FndrTrim5, m_FndrTrim3, ChromLen, pChromMetadata->pPBAs);
+			TrimPBAs(m_FndrTrim5, m_FndrTrim3, pChromMetadata->ChromLen, pChromMetadata->pPBAs);
 		else // treating controls as if progeny when trimming
-			TrimPBAs(m_ProgTrim5, m_ProgTrim3, ChromLen, pChromMetadata->pPBAs);
+			TrimPBAs(m_ProgTrim5, m_ProgTrim3, pChromMetadata->ChromLen, pChromMetadata->pPBAs);
 	}
 
-	close(m_hInFile);
-	m_hInFile = -1;
+	PBAFile.Reset();
 	return((int32_t)ReadsetID);
 }
 
@@ -1406,13 +1313,9 @@ uint8_t*  // returned PBA or nullptr if unable to load PBAs for requested sample
 CDGTvQTLs::LoadSampleChromPBAs(int32_t SampleID,   // Sample identifier
 	int32_t ChromID)    // chrom identifier specifying which PBAs is to be loaded from SampleID file
 {
-	int hInFile;
 	char* pszChrom;
-	int64_t ChromSeekOfs;
 	tsCHChromMetadata* pChromMetadata;
 	tsCHReadsetMetadata* pReadsetMetadata;
-	int32_t NumRead;
-	int32_t NumLoaded;
 
 	// returned pointer to chromosome metadata
 	if ((pChromMetadata = LocateChromMetadataFor(SampleID, ChromID)) == nullptr)
@@ -1431,52 +1334,15 @@ CDGTvQTLs::LoadSampleChromPBAs(int32_t SampleID,   // Sample identifier
 		pChromMetadata->pPBAs = nullptr;
 	}
 
-	// need to actually load from file
+	// need to actually load from file, v2 files are memory mapped so only the pages for this chromosome will be read
 	pReadsetMetadata = &m_Readsets[SampleID - 1];
-#ifdef _WIN32
-	hInFile = open(pReadsetMetadata->szFileName, O_READSEQ);		// file access is normally sequential..
-#else
-	hInFile = open64(pReadsetMetadata->szFileName, O_READSEQ);		// file access is normally sequential..
-#endif
-	if (hInFile == -1)							// check if file open succeeded
+	if ((pChromMetadata->pPBAs = CPBAfile::LoadPBAs(pReadsetMetadata->szFileName, pChromMetadata->FileOfsPBA, pChromMetadata->ChromLen)) == nullptr)
 	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "LoadSampleChromPBA: Unable to open input file '%s' : %s", pReadsetMetadata->szFileName, strerror(errno));
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "LoadSampleChromPBAs: Unable to load chromosome '%s' PBAs from file '%s'", pszChrom, pReadsetMetadata->szFileName);
 		return(nullptr);
 	}
-	if ((ChromSeekOfs = _lseeki64(hInFile, pChromMetadata->FileOfsPBA, SEEK_SET)) != pChromMetadata->FileOfsPBA)
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' opened, _lseek() to file offset %zd failed for chrom '%s', returned %zd, error: '%s'",
-			pReadsetMetadata->szFileName, pChromMetadata->FileOfsPBA, ChromSeekOfs, pszChrom, strerror(errno));
-		close(hInFile);
-		hInFile = -1;
-		return(nullptr);
-	}
-	pChromMetadata->pPBAs = AllocPBAs(pChromMetadata->ChromLen);
-	// attempt to load Chromosomes PBAs from file
-	NumLoaded = 0;
-	do {
-		if ((NumRead = read(hInFile, &pChromMetadata->pPBAs[NumLoaded], pChromMetadata->ChromLen - NumLoaded)) < 0)
-		{
-			gDiagnostics.DiagOut(eDLFatal, gszProcName, "Error %s attempting to read chromosome '%s' from file '%s'", strerror(errno), pszChrom, pReadsetMetadata->szFileName);
-			close(hInFile);
-			hInFile = -1;
-			if (pChromMetadata->pPBAs == nullptr)
-				return(nullptr);
-#ifdef _WIN32
-			free(pChromMetadata->pPBAs);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
-#else
-			if (pChromMetadata->pPBAs != MAP_FAILED)
-				munmap(pChromMetadata->pPBAs, pChromMetadata->ChromLen);
-#endif
-			pChromMetadata->pPBAs = nullptr;
-			return(nullptr);
-		}
-		NumLoaded += NumRead;
-	} while (NumRead > 0 && NumLoaded < pChromMetadata->ChromLen);
-	close(hInFile);
-	hInFile = -1;
 	//	validate PBA allele composition, earlier releases of 'kalign' were retaining very low allele proportions so validating and in-place replacing these as being non-alignments
-	int NumErrs = ValidatePBAs(pChromMetadata->ChromLen, pChromMetadata->pPBAs, true, true);
+	ValidatePBAs(pChromMetadata->ChromLen, pChromMetadata->pPBAs, true, true);
 	//
 	if (pReadsetMetadata->ReadsetType == 0)
 		TrimPBAs(m_FndrTrim5, m_FndrTrim3, pChromMetadata->ChromLen, pChromMetadata->pPBAs);
@@ -1770,6 +1770,7 @@ int Rslt;
 int NumFiles;
 int TotNumFiles;
 size_t memreq;
+CRunPhase Phase;				// run profile phases
 
 Reset();
 
@@ -2006,6 +2007,7 @@ if((m_pInBuffer = new uint8_t[cInBuffSize]) == nullptr)
 m_AllocInBuff = cInBuffSize;
 m_InNumBuffered = 0;
 
+Phase.Begin("load_founders");
 gDiagnostics.DiagOut(eDLInfo, gszProcName, "Process: Loading metadata for founder pool ...");
 Rslt = eBSFSuccess;		// assume success!
 CSimpleGlob glob(SG_GLOB_FULLSORT);
@@ -2074,6 +2076,7 @@ m_NumProgenies = 0;
 m_CurProgenyReadsetID = 0;
 if (m_PMode == eMCSHRefsVsRefs)
 	{
+	Phase.Begin("homozygosity_scores");
 	if ((Rslt = GenPBAsHomozygosityScores(m_GrpHapBinSize, m_NumFounders, 0, pszOutFile)) < eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Process: Failed processing progeny vs founder PBA files");
@@ -2088,7 +2091,7 @@ if (m_PMode == eMCSHRefsVsRefs)
 if(m_PMode == eMCSHSrcVsRefs)
 	{
 	// individually process each progeny against the founder panel
-
+	Phase.Begin("load_progenies");
 	for(Idx = 0; Idx < NumProgenyInputFiles; Idx++)
 		{
 		glob.Init();
@@ -2127,6 +2130,7 @@ if(m_PMode == eMCSHSrcVsRefs)
 			}
 		}
 
+	Phase.Begin("homozygosity_scores");
 	if ((Rslt = GenPBAsHomozygosityScores(m_GrpHapBinSize, m_NumFounders, m_NumProgenies, pszOutFile)) < eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Process: Failed processing progeny vs founder PBA files");
@@ -2155,6 +2159,7 @@ if(!(m_PMode == eMCSHAllelicHapsGrps || m_PMode == eMCSHCoverageHapsGrps || m_PM
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "Completed loading control PBA file");
 		}
 
+	Phase.Begin("allele_stacks");
 	if((Rslt = GenAlleleStacks(m_NumFounders)) < 1)
 		{
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "Process: No allele stacks generated");
@@ -2167,6 +2172,7 @@ if(!(m_PMode == eMCSHAllelicHapsGrps || m_PMode == eMCSHCoverageHapsGrps || m_PM
 	ReportAnchorsAsCSV(pszOutFile);
 
 	// next is to individually process each progeny PBAs against the founder panel allele stacks
+	Phase.Begin("progenies");
 	TotNumFiles = 0;
 	m_CurProgenyReadsetID = 0;
 	for(Idx = 0; Idx < NumProgenyInputFiles; Idx++)
@@ -2213,6 +2219,7 @@ if(!(m_PMode == eMCSHAllelicHapsGrps || m_PMode == eMCSHCoverageHapsGrps || m_PM
 		}
 
 	// sort progeny allele stack overlaps by readset.chrom.loci ascending
+	Phase.Begin("impute_report");
 	m_mtqsort.SetMaxThreads(m_NumThreads);
 
 	if(m_PMode != eMCSHDefault) // requested to report raw matrix?
@@ -2309,6 +2316,7 @@ else // else (eMCSHAllelicHapsGrps or eMCSHCoverageHapsGrps or eMCSHDGTHapsGrps
 				}
 			}
 		}
+	Phase.Begin("haplotype_groups");
 	if((Rslt = GenFounderHaps(m_NumFounders)) < eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "Process: Failed generating haplotype groupings");
@@ -3430,65 +3438,45 @@ return(eBSFSuccess);
 
 
 
-#ifdef _WIN32
-unsigned __stdcall WorkerAlignSelfPBAsInstance(void* pThreadPars)
-#else
-void* WorkerAlignSelfPBAsInstance(void* pThreadPars)
-#endif
+// work pool items are source PBAs, each scored against all founder PBAs using the worker's scoring instance
+static int
+AlignSelfPBAsChunk(void* pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
 {
-	int Rslt;
-	tsCHWorkerSelfScoreInstance* pPars = (tsCHWorkerSelfScoreInstance*)pThreadPars;			// makes it easier not having to deal with casts!
-	CCallHaplotypes* pWorkerInstance = (CCallHaplotypes*)pPars->pThis;
-
-	Rslt = pWorkerInstance->AlignSelfPBAsThread(pPars);
-	pPars->Rslt = Rslt;
-#ifdef _WIN32
-	_endthreadex(0);
-	return(eBSFSuccess);
-#else
-	pthread_exit(&pPars->Rslt);
-#endif
+int Rslt;
+int64_t Idx;
+tsCHWorkerSelfScoreInstance* pPars;
+pPars = &((tsCHWorkerSelfScoreInstance*)pCtx)[WorkerIdx];
+for(Idx = StartIdx; Idx < EndIdx; Idx++)
+	{
+	if((Rslt = ((CCallHaplotypes*)pPars->pThis)->AlignSelfPBAsSrc(pPars,(int32_t)Idx + 1)) < 0)
+		{
+		pPars->Rslt = Rslt;
+		return(Rslt);
+		}
+	}
+return(eBSFSuccess);
 }
 
 int 
 CCallHaplotypes::AlignSelfPBAs(int32_t NumRefPBAs,int32_t NumSrcPBAs, int32_t ChromID, int32_t ChromLen, int32_t BinsThisChrom, int32_t MaxBinSize, tsCHChromScores *pChromScores,uint8_t *pFndrPBAs[],int MaxThreads)
 {
-int Rslt = -1;
+int Rslt = eBSFSuccess;
 tsCHWorkerSelfScoreInstance CHWorkerSelfScoreInstances[cMaxPBAWorkerThreads];
 int NumThreads;
 tsCHWorkerSelfScoreInstance *pThreadPar;
 int32_t ThreadIdx;
+int32_t MaxNumSrcs;
+CWorkPool *pWorkPool;
 
-#ifndef _WIN32
-// increase the default thread stack to at least cWorkThreadStackSize
-size_t defaultStackSize;
-pthread_attr_t threadattr;
-pthread_attr_init(&threadattr);
-pthread_attr_getstacksize(&threadattr, &defaultStackSize);
-if (defaultStackSize < (size_t)cWorkThreadStackSize)
-	{
-	if ((Rslt = pthread_attr_setstacksize(&threadattr, (size_t)cWorkThreadStackSize)) != 0)
-		{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "AlignSelfPBAs: pthread_attr_setstacksize(%d) failed, default was %zd", cWorkThreadStackSize, defaultStackSize);
-		return(eBSFerrInternal);
-		}
-	}
-#endif
-
-NumThreads = min(NumSrcPBAs > 0 ? NumSrcPBAs : NumRefPBAs, MaxThreads);
-m_CurSelfID = 0;
-m_NumWorkerInsts = 0;
-m_CompletedWorkerInsts = 0;
-m_ExpNumWorkerInsts = NumThreads;
+MaxNumSrcs = NumSrcPBAs > 0 ? NumSrcPBAs : NumRefPBAs; // if no sources then sources are same as references so indexes will be identical
+NumThreads = min(MaxNumSrcs, MaxThreads);
+if(MaxBinSize < 1 || MaxBinSize > ChromLen)
+	MaxBinSize = ChromLen;
+m_ReqTerminate = 0;
 pThreadPar = CHWorkerSelfScoreInstances;
 for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThreadPar++)
 	{
 	memset(pThreadPar, 0, sizeof(tsCHWorkerSelfScoreInstance));
-#ifdef _WIN32
-	pThreadPar->threadHandle = nullptr;
-#else
-	pThreadPar->threadID = 0;
-#endif
 	pThreadPar->NumRefPBAs = NumRefPBAs;
 	pThreadPar->NumSrcPBAs = NumSrcPBAs;
 	pThreadPar->ChromID = ChromID;
@@ -3499,54 +3487,17 @@ for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThreadPar++)
 	pThreadPar->pFndrPBAs = pFndrPBAs;
 	pThreadPar->ThreadIdx = ThreadIdx;
 	pThreadPar->pThis = this;
-#ifdef _WIN32
-	pThreadPar->threadHandle = (HANDLE)_beginthreadex(nullptr, cWorkThreadStackSize, WorkerAlignSelfPBAsInstance, pThreadPar, 0, &pThreadPar->threadID);
-#else
-	pThreadPar->threadRslt = pthread_create(&pThreadPar->threadID, &threadattr, WorkerAlignSelfPBAsInstance, pThreadPar);
-#endif
 	}
 
-// allow threads time to all startup
-// check if all threads did actually startup; if they did so then m_NumWorkerInsts will have been incremented to NumInstances
-int MaxWait = cMaxWaitThreadsStartup;		// allowing at most cMaxWaitThreadsStartup secs for all threads to startup, polling every second
-int StartedInstances;
-do {
-#ifdef WIN32
-	Sleep(1000);
-#else
-	sleep(1);
-#endif
-	AcquireSerialise();
-	StartedInstances = m_NumWorkerInsts;
-	ReleaseSerialise();
-	MaxWait -= 1;
-} while (StartedInstances != NumThreads && MaxWait > 0);
-
-if(StartedInstances == NumThreads)				// all started up?
-	while(WaitWorkerThreadStatus(1000) != 0);	// returns 0 if all threads started and completed processing, 1 if all threads started but some yet to complete within WaitSecs, 2 if not all threads have started within WaitSecs
+// each source is a separate work item, sources vary in PBA coverage so workers completing sparser sources steal sources from other workers
+if((pWorkPool = CWorkPool::Shared(MaxThreads)) != nullptr)
+	pWorkPool->ParallelFor(MaxNumSrcs,1,AlignSelfPBAsChunk,CHWorkerSelfScoreInstances,0,nullptr,nullptr,nullptr,NumThreads);
+else
+	AlignSelfPBAsChunk(CHWorkerSelfScoreInstances,0,MaxNumSrcs,0);
 
 pThreadPar = CHWorkerSelfScoreInstances;
 for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThreadPar++)
 	{
-#ifdef _WIN32
-	if(pThreadPar->threadHandle == nullptr)
-		continue;
-	while (WAIT_TIMEOUT == WaitForSingleObject(pThreadPar->threadHandle, 1000))
-		{
-		}
-	CloseHandle(pThreadPar->threadHandle);
-	pThreadPar->threadHandle = nullptr;
-#else
-	struct timespec ts;
-	int JoinRlt;
-	clock_gettime(CLOCK_REALTIME, &ts);
-	ts.tv_sec += 1;
-	while ((JoinRlt = pthread_timedjoin_np(pThreadPar->threadID, nullptr, &ts)) != 0)
-		{
-		ts.tv_sec += 1;
-		}
-
-#endif
 	if (pThreadPar->Rslt != eBSFSuccess)
 		Rslt = pThreadPar->Rslt;
 	}
@@ -3554,148 +3505,83 @@ return(Rslt);
 }
 
 
-// thread for scoring an instance of a source PBAs (termed as Self) against all founder PBAs
+// score a single source PBA (termed as Self) against all founder PBAs
 int
-CCallHaplotypes::AlignSelfPBAsThread(tsCHWorkerSelfScoreInstance* pPar)
+CCallHaplotypes::AlignSelfPBAsSrc(tsCHWorkerSelfScoreInstance* pPar,	// scoring instance parameters
+								int32_t SrcID)							// score this source, 1..number of sources
 {
-int Rslt;
 int BinID;
-int EndBinLoci;
-int32_t SrcID;
+int32_t BinSize;
 int32_t RefID;
 int32_t Loci;
-uint8_t SrcPBA;
-uint8_t RefPBA;
 uint8_t* pSrcPBA;
-uint8_t* pSrcLoci;
-uint8_t* pRefLoci;
+uint8_t* pRefPBA;
 uint32_t ReqTerminate;
 int32_t SrcPBAsIdx;
-int32_t MaxNumSrcs;
 tsCHChromScores* pChromScore;
+tsPBAMatchCnts MatchCnts;
 
-// one more thread instance has started
+// check if requested to early terminate
 AcquireSerialise();
-m_NumWorkerInsts++;
+ReqTerminate = m_ReqTerminate;
 ReleaseSerialise();
+if (ReqTerminate)
+	return(-1);
 
-SrcPBAsIdx = pPar->NumSrcPBAs > 0 ? pPar->NumRefPBAs : 0;		// PBAs layout is such that references start at index 0, followed by sources at index NumRefPBAs, if All vs All
-MaxNumSrcs = pPar->NumSrcPBAs > 0 ? pPar->NumSrcPBAs : pPar->NumRefPBAs; // sources are same as references so indexes will be identical
-if(pPar->MaxBinSize > pPar->ChromLen)
-	pPar->MaxBinSize = pPar->ChromLen;
+SrcPBAsIdx = (pPar->NumSrcPBAs > 0 ? pPar->NumRefPBAs : 0) + SrcID - 1;		// PBAs layout is such that references start at index 0, followed by sources at index NumRefPBAs, if All vs All
 
-// iterating over each unprocessed (by either this or another thread) source
-for (SrcID = 1; SrcID <= MaxNumSrcs; SrcID++, SrcPBAsIdx++)
+// iterate over each of the the references and score the current source relative to these references
+for (RefID = 1; RefID <= pPar->NumRefPBAs; RefID++)
 	{
-	// check if requested to early terminate
-	AcquireSerialise();
-	ReqTerminate = m_ReqTerminate;
-	ReleaseSerialise();
-	if (ReqTerminate)
-		break;
-
-	// only process a source if no other thread already started to process that source
-	AcquireFastSerialise();
-	if (SrcID <= m_CurSelfID)	// ensuring source is unprocessed 
-		{
-		ReleaseFastSerialise();
-		continue;				// too late, another thread is processing or completed this source!
-		}
-	m_CurSelfID = SrcID;		// let other threads know this SrcID is now being processed
-	ReleaseFastSerialise();
+	// starting from first bin at loci 0 on the source
+	pChromScore = &pPar->pChromScores[(pPar->NumRefPBAs * pPar->BinsThisChrom * (SrcID - 1)) + ((RefID - 1) * pPar->BinsThisChrom)];
 
-	// iterate over each of the the references and score the current source relative to these references
-	for (RefID = 1; RefID <= pPar->NumRefPBAs; RefID++)
+	if(pPar->pFndrPBAs[SrcPBAsIdx] == nullptr || pPar->pFndrPBAs[RefID - 1] == nullptr) // explicitly handle these cases, some sample chromosomes will have no PBAs. 
 		{
-		// starting from first bin at loci 0 on the source
-		pChromScore = &pPar->pChromScores[(pPar->NumRefPBAs * pPar->BinsThisChrom * (SrcID - 1)) + ((RefID - 1) * pPar->BinsThisChrom)];
-
-		if(pPar->pFndrPBAs[SrcPBAsIdx] == nullptr || pPar->pFndrPBAs[RefID - 1] == nullptr) // explicitly handle these cases, some sample chromosomes will have no PBAs. 
+		for(BinID = 1, Loci = 0; BinID <= pPar->BinsThisChrom && Loci < pPar->ChromLen; BinID++, Loci += pPar->MaxBinSize,pChromScore++)
 			{
-			for(BinID = 1, Loci = 0; BinID <= pPar->BinsThisChrom && Loci < pPar->ChromLen; BinID++, Loci += pPar->MaxBinSize,pChromScore++)
-				{
-				memset(pChromScore, 0, sizeof(tsCHChromScores));
-				pChromScore->ChromID = pPar->ChromID;
-				pChromScore->SrcID = SrcID;
-				pChromScore->RefID = RefID;
-				pChromScore->BinID = BinID;
-				pChromScore->BinLoci = Loci;
-				pChromScore->BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
-				pChromScore->ExactScore = 0.0;
-				pChromScore->PartialScore = 0.0;
-				pChromScore->BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
-				}
-			continue;
+			memset(pChromScore, 0, sizeof(tsCHChromScores));
+			pChromScore->ChromID = pPar->ChromID;
+			pChromScore->SrcID = SrcID;
+			pChromScore->RefID = RefID;
+			pChromScore->BinID = BinID;
+			pChromScore->BinLoci = Loci;
+			pChromScore->BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
+			pChromScore->ExactScore = 0.0;
+			pChromScore->PartialScore = 0.0;
+			pChromScore->BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
 			}
+		continue;
+		}
 
-		pSrcPBA = pPar->pFndrPBAs[SrcPBAsIdx]; // already handled cases of nullptr; unlikely but possible if sample has no PBAs on current chromosome
-		pSrcLoci = pSrcPBA;
-		pRefLoci = pPar->pFndrPBAs[RefID - 1];
-		EndBinLoci = pPar->MaxBinSize - 1;
-		BinID = 1;
-		for (Loci = 0; Loci < pPar->ChromLen && BinID <= pPar->BinsThisChrom; Loci++)
-			{
-			if (Loci == 0 || Loci > EndBinLoci)			// initial bin or starting a new bin
-				{
-				if(Loci > 0)		// Loci > 0 if starting a new bin
-					{
-					// score just processed bin before starting on new bin
-					if(pChromScore->AlignLen > 0)
-						{
-						// fixed down weighting of 0.5 applied to partial matchings or a match where one allele matched but there was a non-ref allele also present
-						pChromScore->PartialScore = (double)(pChromScore->NumExactMatches + (pChromScore->NumPartialMatches + pChromScore->NumNonRefAlleles) / 2) / pChromScore->AlignLen;
-						// only scoring exact matches
-						pChromScore->ExactScore = (double)pChromScore->NumExactMatches / pChromScore->AlignLen;
-						}
-					else
-						{
-						pChromScore->ExactScore = 0.0;
-						pChromScore->PartialScore = 0.0;
-						}
-
-					pChromScore++;
-					EndBinLoci += pPar->MaxBinSize;
-					BinID++;
-					}
-				memset(pChromScore,0,sizeof(tsCHChromScores));
-				pChromScore->ChromID = pPar->ChromID;
-				pChromScore->SrcID = SrcID;
-				pChromScore->RefID = RefID;
-				pChromScore->BinID = BinID;
-				pChromScore->BinLoci = Loci;
-				pChromScore->BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
-				}
-
-			SrcPBA = *pSrcLoci++;
-			RefPBA = *pRefLoci++;
-			if (RefPBA == 0 || SrcPBA == 0) // both source and reference must have coverage at Loci, if not then iterate to next loci
-				continue;
-
-			// enabling partial matching on the basis that fragments are being sequenced. In a diploid both haplotypes at a given loci may not be present after sequencing, especially where there is low coverage - WGS skim reads - or  GBS reads
-			// when evaluating same material GBS against WGS then about 40% of the WGS bialleles are present as monoalleles in the GBS 
-			if (SrcPBA == RefPBA)	// alleles exactly matching?
-				{
-				pChromScore->NumExactMatches++;
-				if (RefPBA == 0xf0 || RefPBA == 0xcc || RefPBA == 0xc3 || RefPBA == 0x3c || RefPBA == 0x33 || RefPBA == 0x0f)
-					pChromScore->NumBiallelicExactMatches++;
-				}
-			else
-				if (SrcPBA & RefPBA) // at least one of the reference alleles present?
-					{
-					if (~RefPBA & SrcPBA)
-						pChromScore->NumNonRefAlleles++;
-					else
-						pChromScore->NumPartialMatches++;
-					}
-			pChromScore->AlignLen++;
-			}
-		// last bin still requires scoring
+	pSrcPBA = pPar->pFndrPBAs[SrcPBAsIdx]; // already handled cases of nullptr; unlikely but possible if sample has no PBAs on current chromosome
+	pRefPBA = pPar->pFndrPBAs[RefID - 1];
+	for(BinID = 1, Loci = 0; BinID <= pPar->BinsThisChrom && Loci < pPar->ChromLen; BinID++, Loci += BinSize, pChromScore++)
+		{
+		BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
+		memset(pChromScore,0,sizeof(tsCHChromScores));
+		pChromScore->ChromID = pPar->ChromID;
+		pChromScore->SrcID = SrcID;
+		pChromScore->RefID = RefID;
+		pChromScore->BinID = BinID;
+		pChromScore->BinLoci = Loci;
+		pChromScore->BinSize = BinSize;
+
+		// both source and reference must have coverage at a loci for that loci to be scored
+		// enabling partial matching on the basis that fragments are being sequenced. In a diploid both haplotypes at a given loci may not be present after sequencing, especially where there is low coverage - WGS skim reads - or  GBS reads
+		// when evaluating same material GBS against WGS then about 40% of the WGS bialleles are present as monoalleles in the GBS 
+		memset(&MatchCnts,0,sizeof(MatchCnts));
+		CPBAcmp::MatchCnts(&pSrcPBA[Loci],&pRefPBA[Loci],BinSize,&MatchCnts);
+		pChromScore->AlignLen = MatchCnts.AlignLen;
+		pChromScore->NumExactMatches = MatchCnts.NumExactMatches;
+		pChromScore->NumBiallelicExactMatches = MatchCnts.NumBiallelicExactMatches;
+		pChromScore->NumPartialMatches = MatchCnts.NumPartialMatches;
+		pChromScore->NumNonRefAlleles = MatchCnts.NumNonRefAlleles;
 		if (pChromScore->AlignLen > 0)
 			{
 			// fixed down weighting of 0.5 applied to partial matchings or a match where one allele matched but there was a non-ref allele also present
 			pChromScore->PartialScore = (double)(pChromScore->NumExactMatches + (pChromScore->NumPartialMatches + pChromScore->NumNonRefAlleles) / 2) / pChromScore->AlignLen;
-
-				// only scoring exact matches
+			// only scoring exact matches
 			pChromScore->ExactScore = (double)pChromScore->NumExactMatches / pChromScore->AlignLen;
 			}
 		else
@@ -3705,14 +3591,7 @@ for (SrcID = 1; SrcID <= MaxNumSrcs; SrcID++, SrcPBAsIdx++)
 			}
 		}
 	}
-if (SrcID <= MaxNumSrcs)
-	Rslt = -1;
-else
-	Rslt = 0;
-AcquireSerialise();
-m_CompletedWorkerInsts++;
-ReleaseSerialise();
-return(Rslt);
+return(0);
 }
 
 
@@ -3833,19 +3712,12 @@ for (ChromIdx = 0; ChromIdx < pFndrMetadata->NumChroms && CurChromMetadataIdx !=
 	// load all PBAs (both references and source PBAs) for current chrom
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenPBAsHomozygosityScores: Loading chromosome PBAs for '%s' from %d PBAs", pszChrom, NumRefPBAs + NumSrcPBAs);
 	int WorkerThreadStatus;
-	WorkerThreadStatus = StartWorkerLoadChromPBAThreads(m_NumThreads, 1, (NumRefPBAs + NumSrcPBAs), CurChromID, true);
+	WorkerThreadStatus = LoadChromPBAs(m_NumThreads, 1, (NumRefPBAs + NumSrcPBAs), CurChromID, true);
 	if (WorkerThreadStatus < 0)
 		{
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenPBAsHomozygosityScores: Errors loading chromosome PBAs for '%s' from %d PBAs ....", pszChrom, NumRefPBAs + NumSrcPBAs);
 		return(WorkerThreadStatus);
 		}
-
-	while (WorkerThreadStatus > 0)
-		{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenPBAsHomozygosityScores: Continuing to load chromosome PBAs for '%s' from %d PBAs ....", pszChrom, NumRefPBAs + NumSrcPBAs);
-		WorkerThreadStatus = WaitWorkerThreadStatus(60);
-		}
-	TerminateLoadChromPBAsThreads(60);
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenPBAsHomozygosityScores: Completed loading of chromosome PBAs for '%s' from %d PBAs", pszChrom, NumRefPBAs + NumSrcPBAs);
 
 	// checking that all PBAs do have current chrom sequences
@@ -3939,45 +3811,43 @@ return(eBSFSuccess);
 }
 
 
+// work pool items are source PBAs, each scored against all founder PBAs using KMer size subsequences and the worker's scoring instance
+static int
+AlignSelfPBAsKMerChunk(void* pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+int Rslt;
+int64_t Idx;
+tsCHWorkerSelfScoreInstance* pPars;
+pPars = &((tsCHWorkerSelfScoreInstance*)pCtx)[WorkerIdx];
+for(Idx = StartIdx; Idx < EndIdx; Idx++)
+	{
+	if((Rslt = ((CCallHaplotypes*)pPars->pThis)->AlignSelfPBAsKMerSrc(pPars,(int32_t)Idx + 1)) < 0)
+		{
+		pPars->Rslt = Rslt;
+		return(Rslt);
+		}
+	}
+return(eBSFSuccess);
+}
+
 int
 CCallHaplotypes::AlignSelfPBAsKMer(int32_t NumRefPBAs, int32_t KMerSize, int32_t ChromID, int32_t ChromLen, int32_t BinsThisChrom, int32_t MaxBinSize, tsCHChromScores* pChromScores, uint8_t* pFndrPBAs[], int MaxThreads)
 {
-	int Rslt = -1;
+	int Rslt = eBSFSuccess;
 	tsCHWorkerSelfScoreInstance CHWorkerSelfScoreInstances[cMaxPBAWorkerThreads];
 	int NumThreads;
 	tsCHWorkerSelfScoreInstance* pThreadPar;
 	int32_t ThreadIdx;
-
-#ifndef _WIN32
-	// increase the default thread stack to at least cWorkThreadStackSize
-	size_t defaultStackSize;
-	pthread_attr_t threadattr;
-	pthread_attr_init(&threadattr);
-	pthread_attr_getstacksize(&threadattr, &defaultStackSize);
-	if (defaultStackSize < (size_t)cWorkThreadStackSize)
-	{
-		if ((Rslt = pthread_attr_setstacksize(&threadattr, (size_t)cWorkThreadStackSize)) != 0)
-		{
-			gDiagnostics.DiagOut(eDLFatal, gszProcName, "AlignSelfPBAs: pthread_attr_setstacksize(%d) failed, default was %zd", cWorkThreadStackSize, defaultStackSize);
-			return(eBSFerrInternal);
-		}
-	}
-#endif
+	CWorkPool *pWorkPool;
 
 	NumThreads = min(NumRefPBAs, MaxThreads);
-	m_CurSelfID = 0;
-	m_NumWorkerInsts = 0;
-	m_CompletedWorkerInsts = 0;
-	m_ExpNumWorkerInsts = NumThreads;
+	if (MaxBinSize < 1 || MaxBinSize > ChromLen)
+		MaxBinSize = ChromLen;
+	m_ReqTerminate = 0;
 	pThreadPar = CHWorkerSelfScoreInstances;
 	for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThreadPar++)
 	{
 		memset(pThreadPar, 0, sizeof(tsCHWorkerSelfScoreInstance));
-#ifdef _WIN32
-		pThreadPar->threadHandle = nullptr;
-#else
-		pThreadPar->threadID = 0;
-#endif
 		pThreadPar->NumRefPBAs = NumRefPBAs;
 		pThreadPar->NumSrcPBAs = 0;
 		pThreadPar->ChromID = ChromID;
@@ -3988,54 +3858,17 @@ CCallHaplotypes::AlignSelfPBAsKMer(int32_t NumRefPBAs, int32_t KMerSize, int32_t
 		pThreadPar->pFndrPBAs = pFndrPBAs;
 		pThreadPar->ThreadIdx = ThreadIdx;
 		pThreadPar->pThis = this;
-#ifdef _WIN32
-		pThreadPar->threadHandle = (HANDLE)_beginthreadex(nullptr, cWorkThreadStackSize, WorkerAlignSelfPBAsInstance, pThreadPar, 0, &pThreadPar->threadID);
-#else
-		pThreadPar->threadRslt = pthread_create(&pThreadPar->threadID, &threadattr, WorkerAlignSelfPBAsInstance, pThreadPar);
-#endif
 	}
 
-	// allow threads time to all startup
-	// check if all threads did actually startup; if they did so then m_NumWorkerInsts will have been incremented to NumInstances
-	int MaxWait = cMaxWaitThreadsStartup;		// allowing at most cMaxWaitThreadsStartup secs for all threads to startup, polling every second
-	int StartedInstances;
-	do {
-#ifdef WIN32
-		Sleep(1000);
-#else
-		sleep(1);
-#endif
-		AcquireSerialise();
-		StartedInstances = m_NumWorkerInsts;
-		ReleaseSerialise();
-		MaxWait -= 1;
-	} while (StartedInstances != NumThreads && MaxWait > 0);
-
-	if (StartedInstances == NumThreads)				// all started up?
-		while (WaitWorkerThreadStatus(1000) != 0);	// returns 0 if all threads started and completed processing, 1 if all threads started but some yet to complete within WaitSecs, 2 if not all threads have started within WaitSecs
+	// each source, sources are the references, is a separate work item
+	if ((pWorkPool = CWorkPool::Shared(MaxThreads)) != nullptr)
+		pWorkPool->ParallelFor(NumRefPBAs, 1, AlignSelfPBAsKMerChunk, CHWorkerSelfScoreInstances, 0, nullptr, nullptr, nullptr, NumThreads);
+	else
+		AlignSelfPBAsKMerChunk(CHWorkerSelfScoreInstances, 0, NumRefPBAs, 0);
 
 	pThreadPar = CHWorkerSelfScoreInstances;
 	for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThreadPar++)
 	{
-#ifdef _WIN32
-		if (pThreadPar->threadHandle == nullptr)
-			continue;
-		while (WAIT_TIMEOUT == WaitForSingleObject(pThreadPar->threadHandle, 1000))
-		{
-		}
-		CloseHandle(pThreadPar->threadHandle);
-		pThreadPar->threadHandle = nullptr;
-#else
-		struct timespec ts;
-		int JoinRlt;
-		clock_gettime(CLOCK_REALTIME, &ts);
-		ts.tv_sec += 1;
-		while ((JoinRlt = pthread_timedjoin_np(pThreadPar->threadID, nullptr, &ts)) != 0)
-		{
-			ts.tv_sec += 1;
-		}
-
-#endif
 		if (pThreadPar->Rslt != eBSFSuccess)
 			Rslt = pThreadPar->Rslt;
 	}
@@ -4043,147 +3876,82 @@ CCallHaplotypes::AlignSelfPBAsKMer(int32_t NumRefPBAs, int32_t KMerSize, int32_t
 }
 
 
-// thread for scoring an instance of a source PBAs (termed as Self) against all founder PBAs using KMer size subsequences
+// score a single source PBA (termed as Self) against all founder PBAs using KMer size subsequences
 int
-CCallHaplotypes::AlignSelfPBAsKMerThread(tsCHWorkerSelfScoreInstance* pPar)
+CCallHaplotypes::AlignSelfPBAsKMerSrc(tsCHWorkerSelfScoreInstance* pPar,	// scoring instance parameters
+									int32_t SrcID)							// score this source, 1..number of sources
 {
-	int Rslt;
 	int BinID;
-	int EndBinLoci;
-	int32_t SrcID;
+	int32_t BinSize;
 	int32_t RefID;
 	int32_t Loci;
-	uint8_t SrcPBA;
-	uint8_t RefPBA;
 	uint8_t* pSrcPBA;
-	uint8_t* pSrcLoci;
-	uint8_t* pRefLoci;
+	uint8_t* pRefPBA;
 	uint32_t ReqTerminate;
 	int32_t SrcPBAsIdx;
-	int32_t MaxNumSrcs;
 	tsCHChromScores* pChromScore;
-
-	// one more thread instance has started
+	tsPBAMatchCnts MatchCnts;
+	
+	// check if requested to early terminate
 	AcquireSerialise();
-	m_NumWorkerInsts++;
+	ReqTerminate = m_ReqTerminate;
 	ReleaseSerialise();
-
-	SrcPBAsIdx = pPar->NumSrcPBAs > 0 ? pPar->NumRefPBAs : 0;		// PBAs layout is such that references start at index 0, followed by sources at index NumRefPBAs, if All vs All
-	MaxNumSrcs = pPar->NumSrcPBAs > 0 ? pPar->NumSrcPBAs : pPar->NumRefPBAs; // sources are same as references so indexes will be identical
-	if (pPar->MaxBinSize > pPar->ChromLen)
-		pPar->MaxBinSize = pPar->ChromLen;
-
-	// iterating over each unprocessed (by either this or another thread) source
-	for (SrcID = 1; SrcID <= MaxNumSrcs; SrcID++, SrcPBAsIdx++)
+	if (ReqTerminate)
+		return(-1);
+	
+	SrcPBAsIdx = (pPar->NumSrcPBAs > 0 ? pPar->NumRefPBAs : 0) + SrcID - 1;		// PBAs layout is such that references start at index 0, followed by sources at index NumRefPBAs, if All vs All
+	
+	// iterate over each of the the references and score the current source relative to these references
+	for (RefID = 1; RefID <= pPar->NumRefPBAs; RefID++)
 	{
-		// check if requested to early terminate
-		AcquireSerialise();
-		ReqTerminate = m_ReqTerminate;
-		ReleaseSerialise();
-		if (ReqTerminate)
-			break;
-
-		// only process a source if no other thread already started to process that source
-		AcquireFastSerialise();
-		if (SrcID <= m_CurSelfID)	// ensuring source is unprocessed 
-		{
-			ReleaseFastSerialise();
-			continue;				// too late, another thread is processing or completed this source!
-		}
-		m_CurSelfID = SrcID;		// let other threads know this SrcID is now being processed
-		ReleaseFastSerialise();
+		// starting from first bin at loci 0 on the source
+		pChromScore = &pPar->pChromScores[(pPar->NumRefPBAs * pPar->BinsThisChrom * (SrcID - 1)) + ((RefID - 1) * pPar->BinsThisChrom)];
 
-		// iterate over each of the the references and score the current source relative to these references
-		for (RefID = 1; RefID <= pPar->NumRefPBAs; RefID++)
+		if (pPar->pFndrPBAs[SrcPBAsIdx] == nullptr || pPar->pFndrPBAs[RefID - 1] == nullptr) // explicitly handle these cases, some sample chromosomes will have no PBAs. 
 		{
-			// starting from first bin at loci 0 on the source
-			pChromScore = &pPar->pChromScores[(pPar->NumRefPBAs * pPar->BinsThisChrom * (SrcID - 1)) + ((RefID - 1) * pPar->BinsThisChrom)];
-
-			if (pPar->pFndrPBAs[SrcPBAsIdx] == nullptr || pPar->pFndrPBAs[RefID - 1] == nullptr) // explicitly handle these cases, some sample chromosomes will have no PBAs. 
+			for (BinID = 1, Loci = 0; BinID <= pPar->BinsThisChrom && Loci < pPar->ChromLen; BinID++, Loci += pPar->MaxBinSize, pChromScore++)
 			{
-				for (BinID = 1, Loci = 0; BinID <= pPar->BinsThisChrom && Loci < pPar->ChromLen; BinID++, Loci += pPar->MaxBinSize, pChromScore++)
-				{
-					memset(pChromScore, 0, sizeof(tsCHChromScores));
-					pChromScore->ChromID = pPar->ChromID;
-					pChromScore->SrcID = SrcID;
-					pChromScore->RefID = RefID;
-					pChromScore->BinID = BinID;
-					pChromScore->BinLoci = Loci;
-					pChromScore->BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
-					pChromScore->ExactScore = 0.0;
-					pChromScore->PartialScore = 0.0;
-					pChromScore->BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
-				}
-				continue;
+				memset(pChromScore, 0, sizeof(tsCHChromScores));
+				pChromScore->ChromID = pPar->ChromID;
+				pChromScore->SrcID = SrcID;
+				pChromScore->RefID = RefID;
+				pChromScore->BinID = BinID;
+				pChromScore->BinLoci = Loci;
+				pChromScore->BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
+				pChromScore->ExactScore = 0.0;
+				pChromScore->PartialScore = 0.0;
+				pChromScore->BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
 			}
+			continue;
+		}
 
-			pSrcPBA = pPar->pFndrPBAs[SrcPBAsIdx]; // already handled cases of nullptr; unlikely but possible if sample has no PBAs on current chromosome
-			pSrcLoci = pSrcPBA;
-			pRefLoci = pPar->pFndrPBAs[RefID - 1];
-			EndBinLoci = pPar->MaxBinSize - 1;
-			BinID = 1;
-			for (Loci = 0; Loci < pPar->ChromLen && BinID <= pPar->BinsThisChrom; Loci++)
-			{
-				if (Loci == 0 || Loci > EndBinLoci)			// initial bin or starting a new bin
-				{
-					if (Loci > 0)		// Loci > 0 if starting a new bin
-					{
-						// score just processed bin before starting on new bin
-						if (pChromScore->AlignLen > 0)
-						{
-							// fixed down weighting of 0.5 applied to partial matchings or a match where one allele matched but there was a non-ref allele also present
-							pChromScore->PartialScore = (double)(pChromScore->NumExactMatches + (pChromScore->NumPartialMatches + pChromScore->NumNonRefAlleles) / 2) / pChromScore->AlignLen;
-							// only scoring exact matches
-							pChromScore->ExactScore = (double)pChromScore->NumExactMatches / pChromScore->AlignLen;
-						}
-						else
-						{
-							pChromScore->ExactScore = 0.0;
-							pChromScore->PartialScore = 0.0;
-						}
-
-						pChromScore++;
-						EndBinLoci += pPar->MaxBinSize;
-						BinID++;
-					}
-					memset(pChromScore, 0, sizeof(tsCHChromScores));
-					pChromScore->ChromID = pPar->ChromID;
-					pChromScore->SrcID = SrcID;
-					pChromScore->RefID = RefID;
-					pChromScore->BinID = BinID;
-					pChromScore->BinLoci = Loci;
-					pChromScore->BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
-				}
-
-				SrcPBA = *pSrcLoci++;
-				RefPBA = *pRefLoci++;
-				if (RefPBA == 0 || SrcPBA == 0) // both source and reference must have coverage at Loci, if not then iterate to next loci
-					continue;
-
-				// enabling partial matching on the basis that fragments are being sequenced. In a diploid both haplotypes at a given loci may not be present after sequencing, especially where there is low coverage - WGS skim reads - or  GBS reads
-				// when evaluating same material GBS against WGS then about 40% of the WGS bialleles are present as monoalleles in the GBS 
-				if (SrcPBA == RefPBA)	// alleles exactly matching?
-				{
-					pChromScore->NumExactMatches++;
-					if (RefPBA == 0xf0 || RefPBA == 0xcc || RefPBA == 0xc3 || RefPBA == 0x3c || RefPBA == 0x33 || RefPBA == 0x0f)
-						pChromScore->NumBiallelicExactMatches++;
-				}
-				else
-					if (SrcPBA & RefPBA) // at least one of the reference alleles present?
-					{
-						if (~RefPBA & SrcPBA)
-							pChromScore->NumNonRefAlleles++;
-						else
-							pChromScore->NumPartialMatches++;
-					}
-				pChromScore->AlignLen++;
-			}
-			// last bin still requires scoring
+		pSrcPBA = pPar->pFndrPBAs[SrcPBAsIdx]; // already handled cases of nullptr; unlikely but possible if sample has no PBAs on current chromosome
+		pRefPBA = pPar->pFndrPBAs[RefID - 1];
+		for(BinID = 1, Loci = 0; BinID <= pPar->BinsThisChrom && Loci < pPar->ChromLen; BinID++, Loci += BinSize, pChromScore++)
+		{
+			BinSize = (pPar->ChromLen - Loci) > pPar->MaxBinSize ? pPar->MaxBinSize : pPar->ChromLen - Loci;
+			memset(pChromScore,0,sizeof(tsCHChromScores));
+			pChromScore->ChromID = pPar->ChromID;
+			pChromScore->SrcID = SrcID;
+			pChromScore->RefID = RefID;
+			pChromScore->BinID = BinID;
+			pChromScore->BinLoci = Loci;
+			pChromScore->BinSize = BinSize;
+
+			// both source and reference must have coverage at a loci for that loci to be scored
+			// enabling partial matching on the basis that fragments are being sequenced. In a diploid both haplotypes at a given loci may not be present after sequencing, especially where there is low coverage - WGS skim reads - or  GBS reads
+			// when evaluating same material GBS against WGS then about 40% of the WGS bialleles are present as monoalleles in the GBS 
+			memset(&MatchCnts,0,sizeof(MatchCnts));
+			CPBAcmp::MatchCnts(&pSrcPBA[Loci],&pRefPBA[Loci],BinSize,&MatchCnts);
+			pChromScore->AlignLen = MatchCnts.AlignLen;
+			pChromScore->NumExactMatches = MatchCnts.NumExactMatches;
+			pChromScore->NumBiallelicExactMatches = MatchCnts.NumBiallelicExactMatches;
+			pChromScore->NumPartialMatches = MatchCnts.NumPartialMatches;
+			pChromScore->NumNonRefAlleles = MatchCnts.NumNonRefAlleles;
 			if (pChromScore->AlignLen > 0)
 			{
 				// fixed down weighting of 0.5 applied to partial matchings or a match where one allele matched but there was a non-ref allele also present
 				pChromScore->PartialScore = (double)(pChromScore->NumExactMatches + (pChromScore->NumPartialMatches + pChromScore->NumNonRefAlleles) / 2) / pChromScore->AlignLen;
-
 				// only scoring exact matches
 				pChromScore->ExactScore = (double)pChromScore->NumExactMatches / pChromScore->AlignLen;
 			}
@@ -4194,14 +3962,7 @@ CCallHaplotypes::AlignSelfPBAsKMerThread(tsCHWorkerSelfScoreInstance* pPar)
 			}
 		}
 	}
-	if (SrcID <= MaxNumSrcs)
-		Rslt = -1;
-	else
-		Rslt = 0;
-	AcquireSerialise();
-	m_CompletedWorkerInsts++;
-	ReleaseSerialise();
-	return(Rslt);
+	return(0);
 }
 
 
@@ -4346,20 +4107,14 @@ for (ChromID = 1; ChromID <= m_NumChromNames; ChromID++)
 	char* pszChrom = LocateChrom(ChromID);
 
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenKMerGrpHammings: Beginning to load PBAs for %s chromosome for KMer processing .... ", pszChrom);
-	int WorkerThreadStatus = StartWorkerLoadChromPBAThreads(m_NumThreads, 1, m_NumFounders, ChromID, true);
+	int WorkerThreadStatus = LoadChromPBAs(m_NumThreads, 1, m_NumFounders, ChromID, true);
 	if (WorkerThreadStatus < 0)
 		{
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenKMerGrpHammings: Errors loading PBAs for %s chromosome for KMer processing .... ", pszChrom);
 		delete[]ppPBAs;
 		return(WorkerThreadStatus);
 		}
-	while (WorkerThreadStatus > 0)
-		{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenKMerGrpHammings: Continuing to load chromosome PBAs for %s .... ", pszChrom);
-		WorkerThreadStatus = WaitWorkerThreadStatus(60);
-		}
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenKMerGrpHammings: Completed loading chromosome PBAs for %s for KMer processing", pszChrom);
-	TerminateLoadChromPBAsThreads(60);
 
 	for (SampleID = 1; SampleID <= m_NumFounders; SampleID++)
 		{
@@ -4412,20 +4167,14 @@ for (ChromID = 1; ChromID <= m_NumChromNames; ChromID++)
 	char* pszChrom = LocateChrom(ChromID);
 
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenKMerGrpHammings: Beginning to load PBAs for %s chromosome for KMer instance copy number searching .... ", pszChrom);
-	int WorkerThreadStatus = StartWorkerLoadChromPBAThreads(m_NumThreads, 1, m_NumFounders, ChromID, true);
+	int WorkerThreadStatus = LoadChromPBAs(m_NumThreads, 1, m_NumFounders, ChromID, true);
 	if (WorkerThreadStatus < 0)
 	{
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenKMerGrpHammings: Errors loading PBAs for %s chromosome for KMer instance copy number searching .... ", pszChrom);
 		delete[]ppPBAs;
 		return(WorkerThreadStatus);
 	}
-	while (WorkerThreadStatus > 0)
-	{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenKMerGrpHammings: Continuing to load chromosome PBAs for %s .... ", pszChrom);
-		WorkerThreadStatus = WaitWorkerThreadStatus(60);
-	}
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "GenKMerGrpHammings: Completed loading chromosome PBAs for %s for  KMer instance searching", pszChrom);
-	TerminateLoadChromPBAsThreads(60);
 
 	for (SampleID = 1; SampleID <= m_NumFounders; SampleID++)
 		{
@@ -5149,6 +4898,7 @@ do{
 		return(0);
 		}
 	m_InNumBuffered += (uint32_t)NumRead;
+	CRunProfile::Count(eRPCBytesRead,NumRead);
 	}
 while(NumRead > 0 && m_InNumBuffered < MinRequired);
 m_InFileOfs = _lseeki64(m_hInFile,0,SEEK_CUR);             // record file offset at which next file read will start from
@@ -5161,85 +4911,25 @@ CCallHaplotypes::LoadPBAFile(char* pszFile,	// load chromosome metadata and PBA
 							 bool bChromMetaOnly)  // load chrom metadata (chrom name,length, file offset at which chrom PBAs start) but don't actually load the chromosome PBAs
 {
 int Rslt;
-int Version;
-char szExperimentID[100];
-char szRefAssemblyID[100];
-char szReadsetID[100];
+int32_t ChromIdx;
 uint32_t PrevChromMetadataIdx;
 uint32_t ChromID;
 uint32_t ReadsetID;
 tsCHReadsetMetadata *pReadsetMetadata;
 tsCHChromMetadata *pChromMetadata;
 tsCHChromMetadata *pPrevChromMetadata;
-int64_t FileOfsPBA;
-uint8_t* pBuff;
-int scanlen;
-int NumTags;
+tsPBAChrom *pPBAChrom;
+CPBAfile PBAFile;
 
 gDiagnostics.DiagOut(eDLInfo, gszProcName, "Loading '%s' file",pszFile);
-#ifdef _WIN32
-m_hInFile = open(pszFile, O_READSEQ);		// file access is normally sequential..
-#else
-m_hInFile = open64(pszFile, O_READSEQ);		// file access is normally sequential..
-#endif
-if(m_hInFile == -1)							// check if file open succeeded
-	{
-	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to open input file '%s' : %s", pszFile, strerror(errno));
-	return(eBSFerrOpnFile);
-	}
-
-// attempt to load the readset metadata 
-m_InNumBuffered = 0;
-m_InNumProcessed = 0;
-if((FillInBuffer(500,min(m_AllocInBuff,500u)) == 0) || m_InNumBuffered < 9) // 500 will cover the maximally sized header
-	{
-	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to read at least a partial header from input file '%s'", pszFile);
-	return(eBSFerrOpnFile);
-	}
-
-
-// check file type is PBA
-if(strncmp((char *)m_pInBuffer,"Type:PbA",8))
-	{
-	gDiagnostics.DiagOut (eDLFatal, gszProcName, "Input file '%s' exists, unable to parse file type header tag as being a packed base allele file",pszFile);
-	return(eBSFerrOpnFile);
-	}
-// file type in header expected to be followed by a new line, not carriage return then a new line!
-if(m_pInBuffer[8] != '\n' && m_pInBuffer[9] != 'V')
-	{
-	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists, file type header tag is for a PBA type but this tag is incorrectly terminated. Has file been transformed into ascii?", pszFile);
-	return(eBSFerrOpnFile);
-	}
-m_InNumProcessed = 9;
-
-if(m_InNumBuffered < 500)
-	{
-	gDiagnostics.DiagOut (eDLFatal, gszProcName, "Input file '%s' exists, unable to read complete header and initial chromosome metadata, expecting file size >= 500, is it a packed base allele file",pszFile);
-	return(eBSFerrOpnFile);
-	}
-
-// parse out tagnames and associated values
-pBuff = &m_pInBuffer[m_InNumProcessed];
-NumTags=sscanf((char *)pBuff,"Version:%d\nExperimentID:%99[^\n]\nReferenceID:%99[^\n]\nReadsetID:%99[^\n]%n",&Version,szExperimentID,szRefAssemblyID,szReadsetID,&scanlen);
-if(NumTags != 4 || Version != 1 || szExperimentID[0] == '\0' || szRefAssemblyID[0] == '\0' || szReadsetID[0] == '\0')
-	{
-	gDiagnostics.DiagOut (eDLFatal, gszProcName, "Input file '%s' exists as a packed base allele file but inconsistencies in header tag values",pszFile);
-	return(eBSFerrOpnFile);
-	}
-gDiagnostics.DiagOut(eDLInfo, gszProcName, "Metadata ExperimentID:%s, ReferenceID:%s, ReadsetID:%s",szExperimentID,szRefAssemblyID,szReadsetID);
-
-m_InNumProcessed += scanlen + 1;		// header tags were '\n' terminated except for final which was '\0' terminated
-
-m_InFileOfs = m_InNumProcessed;         // 1st chromosome starts immediately following the header metadata
-if(_lseeki64(m_hInFile, m_InFileOfs, SEEK_SET) != m_InFileOfs)
-	{
-	gDiagnostics.DiagOut (eDLFatal, gszProcName, "Input file '%s' exists as a packed base allele file but unable to seek past header metadata",pszFile);
-	return(eBSFerrOpnFile);
-	}
+// header is parsed and chromosome metadata loaded from either the v2 chromosome directory or, for v1 files, by skipping from chromosome to chromosome
+if((Rslt = PBAFile.Open(pszFile)) != eBSFSuccess)
+	return(Rslt);
+gDiagnostics.DiagOut(eDLInfo, gszProcName, "Metadata Version:%d, ExperimentID:%s, ReferenceID:%s, ReadsetID:%s",PBAFile.Version(),PBAFile.ExperimentID(),PBAFile.ReferenceID(),PBAFile.ReadsetID());
 
-if((ReadsetID = AddReadset(szReadsetID, ReadsetType))==0)
+if((ReadsetID = AddReadset(PBAFile.ReadsetID(), ReadsetType))==0)
 	{
-	gDiagnostics.DiagOut (eDLFatal, gszProcName, "Input file '%s' duplicates the ReadsetID '%s' of a previously loaded readset",pszFile,szReadsetID);
+	gDiagnostics.DiagOut (eDLFatal, gszProcName, "Input file '%s' duplicates the ReadsetID '%s' of a previously loaded readset",pszFile,PBAFile.ReadsetID());
 	return(eBSFerrOpnFile);
 	}
 
@@ -5248,47 +4938,27 @@ memset(pReadsetMetadata,0,sizeof(*pReadsetMetadata));
 pReadsetMetadata->ReadsetType = ReadsetType;
 pReadsetMetadata->NumChroms = 0;
 strcpy(pReadsetMetadata->szFileName, pszFile);
-strcpy(pReadsetMetadata->szExperimentID,szExperimentID);
-strcpy(pReadsetMetadata->szRefAssemblyID,szRefAssemblyID);
+strcpy(pReadsetMetadata->szExperimentID,PBAFile.ExperimentID());
+strcpy(pReadsetMetadata->szRefAssemblyID,PBAFile.ReferenceID());
 pReadsetMetadata->ReadsetID = ReadsetID;
 pReadsetMetadata->StartChromID = 0;
 pReadsetMetadata->StartChromMetadataIdx = 0;
-pReadsetMetadata->NxtFileChromOfs = m_InFileOfs;
-
-int ChromNameLen;
-char *pszChromName;
-int32_t ChromLen;
+pReadsetMetadata->NxtFileChromOfs = PBAFile.EndFileOfs();
 
 // iterate over all chromosomes
-m_InNumProcessed = 0;
-m_InNumBuffered = 0;
 PrevChromMetadataIdx = 0;
-while(FillInBuffer((uint32_t)110,110)==110) // reading chromosome metadata
-	{
-	pBuff = &m_pInBuffer[m_InNumProcessed++];
-	ChromNameLen = (int)*pBuff++;
-	pszChromName = (char *)pBuff;
-	pBuff += (int64_t)1+ChromNameLen;
-	ChromLen = *(int32_t *)pBuff;
-	FileOfsPBA = pReadsetMetadata->NxtFileChromOfs + ChromNameLen + 6;
-	pReadsetMetadata->NxtFileChromOfs += (int64_t)ChromNameLen + 6 + ChromLen;
+for(ChromIdx = 0; ChromIdx < PBAFile.NumChroms(); ChromIdx++)
+	{
+	pPBAChrom = PBAFile.Chrom(ChromIdx);
 	// check if this chromosome is to be retained for further processing
-	if(!AcceptThisChromName(pszChromName))
-		{
-		// not accepting this chromosome
-		m_InFileOfs = pReadsetMetadata->NxtFileChromOfs;         // skip over curent chrom's PBAs to start of next chromosome
-		if((pReadsetMetadata->NxtFileChromOfs = _lseeki64(m_hInFile, m_InFileOfs, SEEK_SET)) != m_InFileOfs)
-			break;
-		m_InNumProcessed = 0;
-		m_InNumBuffered = 0;
+	if(!AcceptThisChromName(pPBAChrom->szChromName))
 		continue;
-		}
 
 		// before accepting chrom then ensure that it's PBA length matches the BED chromosome sizes
-	ChromID = AddChrom(pszChromName);
-	if (ChromLen != m_ChromSizes[ChromID - 1])
+	ChromID = AddChrom(pPBAChrom->szChromName);
+	if (pPBAChrom->ChromLen != m_ChromSizes[ChromID - 1])
 		{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' with readset '%s' has chromosome '%s' size mismatch - expected size was %d, actual size %d", pszFile, szReadsetID, pszChromName, m_ChromSizes[ChromID - 1], ChromLen);
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' with readset '%s' has chromosome '%s' size mismatch - expected size was %d, actual size %d", pszFile, PBAFile.ReadsetID(), pPBAChrom->szChromName, m_ChromSizes[ChromID - 1], pPBAChrom->ChromLen);
 		return(eBSFerrChrom);
 		}
 
@@ -5311,40 +4981,27 @@ while(FillInBuffer((uint32_t)110,110)==110) // reading chromosome metadata
 	pChromMetadata->ChromID = ChromID;
 	pChromMetadata->ChromMetadataIdx = m_UsedNumChromMetadata;
 	pChromMetadata->NxtChromMetadataIdx = 0;
-	pChromMetadata->ChromLen = ChromLen;
+	pChromMetadata->ChromLen = pPBAChrom->ChromLen;
 	pChromMetadata->ReadsetID = ReadsetID;
 	pChromMetadata->HGBinID = 0;
-	pChromMetadata->FileOfsPBA = FileOfsPBA;
+	pChromMetadata->FileOfsPBA = pPBAChrom->FileOfsPBA;
 	pChromMetadata->pPBAs = nullptr;
 	if(bChromMetaOnly) // loading chrom metadata only without actually loading the chromosome PBAs?
-		{
-		m_InFileOfs = pReadsetMetadata->NxtFileChromOfs;         // skip over curent chrom's PBAs to start of next chromosome
-		if((pReadsetMetadata->NxtFileChromOfs = _lseeki64(m_hInFile, m_InFileOfs, SEEK_SET)) != m_InFileOfs)
-			break;
-		m_InNumProcessed = 0;
-		m_InNumBuffered = 0;
 		continue;
-		}
-	// loading PBAs
-	pChromMetadata->pPBAs = AllocPBAs(ChromLen);
-	m_InNumProcessed += ChromNameLen + 5;
-	FillInBuffer((uint32_t)ChromLen,ChromLen);
-	pBuff = &m_pInBuffer[m_InNumProcessed];
 
-
-	memcpy(pChromMetadata->pPBAs, pBuff, ChromLen);
-	m_InNumProcessed += ChromLen;
+	// loading PBAs, v2 files are memory mapped with only those pages modified by validation or trimming being copied
+	if((pChromMetadata->pPBAs = PBAFile.LoadChromPBAs(ChromIdx)) == nullptr)
+		return(eBSFerrFileAccess);
 	//	validate PBA allele composition, earlier releases were retaining very low allele proportions so validating and in-place replacing these as being non-alignments
-	int NumErrs = ValidatePBAs(ChromLen,pChromMetadata->pPBAs,true,true);
+	ValidatePBAs(pChromMetadata->ChromLen,pChromMetadata->pPBAs,true,true);
 	//
 	if(ReadsetType == 0)
-		TrimPBAs(m_FndrTrim5, m_FndrTrim3, ChromLen,pChromMetadata->pPBAs);
+		TrimPBAs(m_FndrTrim5, m_FndrTrim3, pChromMetadata->ChromLen,pChromMetadata->pPBAs);
 	else // treating controls as if progeny when trimming
-		TrimPBAs(m_ProgTrim5, m_ProgTrim3, ChromLen, pChromMetadata->pPBAs);
+		TrimPBAs(m_ProgTrim5, m_ProgTrim3, pChromMetadata->ChromLen, pChromMetadata->pPBAs);
 	}
 
-close(m_hInFile);
-m_hInFile = -1;
+PBAFile.Reset();
 return((int32_t)ReadsetID);
 }
 
@@ -5373,13 +5030,9 @@ uint8_t *  // returned PBA or nullptr if unable to load PBAs for requested sampl
 CCallHaplotypes::LoadSampleChromPBAs(int32_t SampleID,   // Sample identifier
 				   int32_t ChromID)    // chrom identifier specifying which PBAs is to be loaded from SampleID file
 {
-int hInFile;
 char* pszChrom;
-int64_t ChromSeekOfs;
 tsCHChromMetadata* pChromMetadata;
 tsCHReadsetMetadata *pReadsetMetadata;
-int32_t NumRead;
-int32_t NumLoaded;
 
 // returned pointer to chromosome metadata
 if((pChromMetadata = LocateChromMetadataFor(SampleID, ChromID)) == nullptr)
@@ -5397,57 +5050,19 @@ if(pChromMetadata->pPBAs != nullptr) // PBAs may already have been loaded for th
 #endif
 	pChromMetadata->pPBAs = nullptr;
 	}
-
-if(m_PMode == eMCSHCoverageHapsGrps)
-	return(LoadPBAChromCoverage(SampleID, ChromID));
-
-// need to actually load from file
-pReadsetMetadata = &m_Readsets[SampleID-1];
-#ifdef _WIN32
-hInFile = open(pReadsetMetadata->szFileName, O_READSEQ);		// file access is normally sequential..
-#else
-hInFile = open64(pReadsetMetadata->szFileName, O_READSEQ);		// file access is normally sequential..
-#endif
-if(hInFile == -1)							// check if file open succeeded
-	{
-	gDiagnostics.DiagOut(eDLFatal, gszProcName, "LoadSampleChromPBA: Unable to open input file '%s' : %s", pReadsetMetadata->szFileName, strerror(errno));
-	return(nullptr);
-	}
-if((ChromSeekOfs = _lseeki64(hInFile, pChromMetadata->FileOfsPBA, SEEK_SET)) != pChromMetadata->FileOfsPBA)
-	{
-	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' opened, _lseek() to file offset %zd failed for chrom '%s', returned %zd, error: '%s'",
-										pReadsetMetadata->szFileName, pChromMetadata->FileOfsPBA, ChromSeekOfs, pszChrom, strerror(errno));
-	close(hInFile);
-	hInFile = -1;
-	return(nullptr);
-	}
-pChromMetadata->pPBAs = AllocPBAs(pChromMetadata->ChromLen);
-// attempt to load Chromosomes PBAs from file
-NumLoaded = 0;
-do{
-	if((NumRead = read(hInFile, &pChromMetadata->pPBAs[NumLoaded], pChromMetadata->ChromLen - NumLoaded)) < 0)
-		{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Error %s attempting to read chromosome '%s' from file '%s'", strerror(errno),pszChrom,pReadsetMetadata->szFileName);
-		close(hInFile);
-		hInFile = -1;
-		if(pChromMetadata->pPBAs == nullptr) 
-			return(nullptr);
-#ifdef _WIN32
-		free(pChromMetadata->pPBAs);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
-#else
-		if(pChromMetadata->pPBAs != MAP_FAILED)
-			munmap(pChromMetadata->pPBAs, pChromMetadata->ChromLen);
-#endif
-		pChromMetadata->pPBAs = nullptr;
-		return(nullptr);
-		}
-	NumLoaded += NumRead;
-	}
-while(NumRead > 0 && NumLoaded < pChromMetadata->ChromLen);
-close(hInFile);
-hInFile = -1;
+
+if(m_PMode == eMCSHCoverageHapsGrps)
+	return(LoadPBAChromCoverage(SampleID, ChromID));
+
+// need to actually load from file, v2 files are memory mapped so only the pages for this chromosome will be read
+pReadsetMetadata = &m_Readsets[SampleID-1];
+if((pChromMetadata->pPBAs = CPBAfile::LoadPBAs(pReadsetMetadata->szFileName, pChromMetadata->FileOfsPBA, pChromMetadata->ChromLen)) == nullptr)
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "LoadSampleChromPBAs: Unable to load chromosome '%s' PBAs from file '%s'", pszChrom, pReadsetMetadata->szFileName);
+	return(nullptr);
+	}
 //	validate PBA allele composition, earlier releases of 'kalign' were retaining very low allele proportions so validating and in-place replacing these as being non-alignments
-int NumErrs = ValidatePBAs(pChromMetadata->ChromLen,pChromMetadata->pPBAs,true,true);
+ValidatePBAs(pChromMetadata->ChromLen,pChromMetadata->pPBAs,true,true);
 //
 if(pReadsetMetadata->ReadsetType == 0)
 	TrimPBAs(m_FndrTrim5, m_FndrTrim3, pChromMetadata->ChromLen,pChromMetadata->pPBAs);
@@ -7174,378 +6789,155 @@ return(m_UsedAlleleStacks);
 }
 
 
-#ifdef _WIN32
-unsigned __stdcall WorkerLoadChromPBAInstance(void * pThreadPars)
-#else
-void * WorkerLoadChromPBAInstance(void * pThreadPars)
-#endif
+// work pool item for loading chromosome PBAs, one sample per item
+static int
+LoadChromPBAsChunk(void* pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
 {
-int Rslt;
-tsCHWorkerLoadChromPBAsInstance *pPars = (tsCHWorkerLoadChromPBAsInstance *)pThreadPars;			// makes it easier not having to deal with casts!
-CCallHaplotypes *pWorkerInstance = (CCallHaplotypes *)pPars->pThis;
-
-Rslt = pWorkerInstance->ProcWorkerLoadChromPBAThread(pPars);
-pPars->Rslt = Rslt;
-#ifdef _WIN32
-_endthreadex(0);
-return(eBSFSuccess);
-#else
-pthread_exit(&pPars->Rslt);
-#endif
+tsCHWorkerLoadChromPBAsInstance* pPars = (tsCHWorkerLoadChromPBAsInstance*)pCtx;
+return(((CCallHaplotypes*)pPars->pThis)->LoadSampleRangeChromPBAs(pPars, pPars->StartSampleID + (int32_t)StartIdx, pPars->StartSampleID + (int32_t)EndIdx - 1));
 }
 
-
-#ifdef _WIN32
-unsigned __stdcall WorkerPBAInstance(void * pThreadPars)
-#else
-void *WorkerPBAInstance(void * pThreadPars)
-#endif
+// work pool items are work queue elements, or haplotype grouping bins, processed by the pool worker's instance
+static int
+ProcWorkerChunk(void* pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
 {
 int Rslt;
-tsCHWorkerInstance *pPars = (tsCHWorkerInstance *)pThreadPars;			// makes it easier not having to deal with casts!
-CCallHaplotypes *pWorkerInstance = (CCallHaplotypes *)pPars->pThis;
-
-Rslt = pWorkerInstance->ProcWorkerThread(pPars);
-pPars->Rslt = Rslt;
-#ifdef _WIN32
-_endthreadex(0);
+int64_t Idx;
+tsCHWorkerInstance* pPars;
+pPars = &((tsCHWorkerInstance*)pCtx)[WorkerIdx];
+for(Idx = StartIdx; Idx < EndIdx; Idx++)
+	{
+	if((Rslt = ((CCallHaplotypes*)pPars->pThis)->ProcWorkItem(pPars,(int32_t)Idx)) < eBSFSuccess)
+		{
+		pPars->Rslt = Rslt;
+		return(Rslt);
+		}
+	}
 return(eBSFSuccess);
-#else
-pthread_exit(&pPars->Rslt);
-#endif
 }
 
-// initialise and start pool of worker threads to concurrently load chromosome PBAs
-int				// returns 0 if all threads have started processing, 1 if all threads started and some have completed processing, 2 if not all have started
-CCallHaplotypes::StartWorkerLoadChromPBAThreads(int32_t NumThreads,		// there are this many threads in pool
+// concurrently load chromosome PBAs
+int				// returns < 0 if errors, eBSFSuccess if all samples were processed
+CCallHaplotypes::LoadChromPBAs(int32_t NumThreads,		// use at most this many work pool threads
 										int32_t StartSampleID,				// processing to start from this sample identifer
 										int32_t EndSampleID,				// ending with this sample identifier inclusive
 										int32_t ChromID,					// loading PBAs for this chromosome
 										bool bNormAlleles)					// normalise alleles such that individual alleles can be compared without regard to the proportional coverage (0x22 -> 0x33 as an example)
 {
-int Rslt = eBSFSuccess;
-int32_t FromSampleID;
-int32_t NumSamples;
-int32_t SamplesThisThread;
-int32_t ThreadIdx;
-tsCHWorkerLoadChromPBAsInstance *pThreadPar;
-
-#ifndef _WIN32
-// increase the default thread stack to at least cWorkThreadStackSize
-size_t defaultStackSize;
-pthread_attr_t threadattr;
-pthread_attr_init(&threadattr);
-pthread_attr_getstacksize(&threadattr, &defaultStackSize);
-if (defaultStackSize < (size_t)cWorkThreadStackSize)
-	{
-	if ((Rslt = pthread_attr_setstacksize(&threadattr, (size_t)cWorkThreadStackSize)) != 0)
-		{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "StartWorkerLoadChromPBAThreads: pthread_attr_setstacksize(%d) failed, default was %zd", cWorkThreadStackSize, defaultStackSize);
-		return(eBSFerrInternal);
-		}
-	}
-#endif
-
-
-NumSamples = 1 + EndSampleID - StartSampleID;
-NumThreads = min(NumSamples, NumThreads);
-FromSampleID = StartSampleID;
-m_NumWorkerInsts = 0;
-m_ExpNumWorkerInsts = NumThreads;
-m_CompletedWorkerInsts = 0;
+int Rslt;
+tsCHWorkerLoadChromPBAsInstance LoadPars;
+CWorkPool *pWorkPool;
+
+memset(&LoadPars,0,sizeof(tsCHWorkerLoadChromPBAsInstance));
+LoadPars.pThis = this;
+LoadPars.StartSampleID = StartSampleID;
+LoadPars.EndSampleID = EndSampleID;
+LoadPars.ChromID = ChromID;
+LoadPars.bNormAlleles = bNormAlleles;
 m_ReqTerminate = 0;
-pThreadPar = m_WorkerLoadChromPBAInstances;
-for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThreadPar++)
-	{
-	memset(pThreadPar,0,sizeof(tsCHWorkerLoadChromPBAsInstance));
-	pThreadPar->bNormAlleles = bNormAlleles;
-	pThreadPar->ChromID = ChromID;
-	SamplesThisThread = NumSamples / (1 + NumThreads - ThreadIdx);
-	NumSamples -= SamplesThisThread;
-	pThreadPar->StartSampleID = FromSampleID;
-	pThreadPar->EndSampleID = SamplesThisThread - 1 + FromSampleID;
-	FromSampleID = pThreadPar->EndSampleID + 1;
-
-	pThreadPar->ThreadIdx = ThreadIdx;
-	pThreadPar->pThis = this;
-#ifdef _WIN32
-	pThreadPar->threadHandle = (HANDLE)_beginthreadex(nullptr, cWorkThreadStackSize, WorkerLoadChromPBAInstance, pThreadPar, 0, &pThreadPar->threadID);
-#else
-	pThreadPar->threadRslt = pthread_create(&pThreadPar->threadID, &threadattr, WorkerLoadChromPBAInstance, pThreadPar);
-#endif
-	}
 
-// allow threads time to all startup
-Rslt = WaitWorkerThreadStatus(cMaxWaitThreadsStartup);	// waiting untill all threads have started (some may have completed!)
-if (Rslt == 2)
-	{
-	gDiagnostics.DiagOut(eDLFatal, gszProcName, "StartWorkerThreads: All %d expected threads did not register as started within allowed %d seconds", NumThreads, cMaxWaitThreadsStartup);
-	Rslt = TerminateWorkerThreads();
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "StartWorkerThreads: TerminateWorkThreads(60) returned %d", Rslt);
-	return(eBSFerrInternal);
-	}
+// samples vary in PBA size so each sample is a separate work item, workers which complete smaller samples steal remaining samples from workers still loading larger samples
+if((pWorkPool = CWorkPool::Shared(NumThreads)) != nullptr)
+	Rslt = pWorkPool->ParallelFor(1 + EndSampleID - StartSampleID,1,LoadChromPBAsChunk,&LoadPars,60,"Continuing to load chromosome PBAs ....",nullptr,nullptr,NumThreads);
+else
+	Rslt = LoadSampleRangeChromPBAs(&LoadPars,StartSampleID,EndSampleID);
 return(Rslt);
 }
 
-
-// initialise and start pool of worker threads
-int
-CCallHaplotypes::StartWorkerThreads(int32_t NumThreads,		// there are this many threads in pool
-									int32_t NumChroms)			// processing this number of chromosomes
+// run worker instances on the shared work pool
+int				// returns < 0 if errors, eBSFSuccess if all workers completed processing
+CCallHaplotypes::RunWorkerThreads(int32_t NumThreads,		// run this many worker instances
+									WorkPoolProgressFunc pProgressFunc,	// called every 60 seconds whilst workers are still processing
+									void *pProgressCtx)		// passed into pProgressFunc
 {
 int Rslt = eBSFSuccess;
-int32_t StartQuerySeqIdx;
 int32_t ThreadIdx;
+int32_t BinIdx;
+int32_t ChromID;
+int32_t NumItems;
 tsCHWorkerInstance *pThreadPar;
+CWorkPool *pWorkPool;
 
-#ifndef _WIN32
-// increase the default thread stack to at least cWorkThreadStackSize
-size_t defaultStackSize;
-pthread_attr_t threadattr;
-pthread_attr_init(&threadattr);
-pthread_attr_getstacksize(&threadattr, &defaultStackSize);
-if (defaultStackSize < (size_t)cWorkThreadStackSize)
+m_ReqTerminate = 0;
+if(m_PMode < eMCSHAllelicHapsGrps) // each work queue element is a work item
+	{
+	m_StartWorkItemIdx = m_NumQueueElsProcessed;
+	NumItems = m_TotWorkQueueEls - m_NumQueueElsProcessed;
+	}
+else // a single work queue element for the chromosome, each haplotype grouping bin on that chromosome is a work item
 	{
-	if((Rslt=pthread_attr_setstacksize(&threadattr, (size_t)cWorkThreadStackSize))!=0)
+	ChromID = m_pWorkQueueEls[0].ChromID;
+	m_StartWorkItemIdx = m_UsedHGBinSpecs;
+	NumItems = 0;
+	for(BinIdx = m_ProccessingHGAllocID; BinIdx < m_UsedHGBinSpecs; BinIdx++)
 		{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "StartWorkerThreads: pthread_attr_setstacksize(%d) failed, default was %zd", cWorkThreadStackSize, defaultStackSize);
-		return(eBSFerrInternal);
+		if(m_pHGBinSpecs[BinIdx].ChromID != ChromID)
+			continue;
+		if(m_StartWorkItemIdx == m_UsedHGBinSpecs)
+			m_StartWorkItemIdx = BinIdx;
+		NumItems = 1 + BinIdx - m_StartWorkItemIdx;
 		}
 	}
-#endif
 
-StartQuerySeqIdx = 0;
-m_NumWorkerInsts = 0;
-m_CompletedWorkerInsts = 0;
-m_ExpNumWorkerInsts = NumThreads;
-m_ReqTerminate = 0;
 pThreadPar = m_WorkerInstances;
 for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThreadPar++)
 	{
 	memset(pThreadPar,0,sizeof(tsCHWorkerInstance));
 	pThreadPar->ThreadIdx = ThreadIdx;
 	pThreadPar->pThis = this;
-#ifdef _WIN32
-	pThreadPar->threadHandle = (HANDLE)_beginthreadex(nullptr, cWorkThreadStackSize, WorkerPBAInstance, pThreadPar, 0, &pThreadPar->threadID);
-#else
-	pThreadPar->threadRslt = pthread_create(&pThreadPar->threadID, &threadattr, WorkerPBAInstance, pThreadPar);
-#endif
 	}
 
-// allow threads time to all startup
-Rslt = WaitWorkerThreadStatus(cMaxWaitThreadsStartup);	// waiting untill all threads have started (some may have completed!)
-if(Rslt == 2)
-	{
-	gDiagnostics.DiagOut(eDLFatal, gszProcName, "StartWorkerThreads: All %d expected threads did not register as started within allowed %d seconds", NumThreads, cMaxWaitThreadsStartup);
-	Rslt=TerminateWorkerThreads();
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "StartWorkerThreads: TerminateWorkThreads(60) returned %d", Rslt);
-	return(eBSFerrInternal);
-	}
- return(Rslt);
-}
-
-// stop all threads in worker pool
-int	// returns number of threads forced to terminate
-CCallHaplotypes::TerminateWorkerThreads(int WaitSecs)				// allow at most this many seconds before force terminating worker pool threads
-{
-int NumForceTerminated;
-uint32_t Idx;
-uint32_t NumWorkerInsts;
-uint32_t ExpNumWorkerInsts;
-uint32_t CompletedWorkerInsts;
-tsCHWorkerInstance *pThreadPar;
-time_t Then;
-time_t Now;
-
-AcquireSerialise();
-NumWorkerInsts = m_NumWorkerInsts;
-ExpNumWorkerInsts = m_ExpNumWorkerInsts;
-CompletedWorkerInsts = m_CompletedWorkerInsts;
-ReleaseSerialise();
-if(ExpNumWorkerInsts == 0)
+// processing time varies widely between work items so items are submitted individually, workers completing their items steal from workers still processing
+if(NumItems > 0)
 	{
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "TerminateWorkerThreads: No worker threads to terminate");
-	pThreadPar = m_WorkerInstances;
-	AcquireSerialise();
-	for (Idx = 0; Idx < ExpNumWorkerInsts; Idx++, pThreadPar += 1)
-		memset(pThreadPar, 0, sizeof(tsCHWorkerInstance));
-	m_NumWorkerInsts = 0;
-	m_ExpNumWorkerInsts = 0;
-	m_CompletedWorkerInsts = 0;
-	m_ReqTerminate = 0;
-	ReleaseSerialise();
-	return(0);
+	if((pWorkPool = CWorkPool::Shared(NumThreads)) != nullptr)
+		pWorkPool->ParallelFor(NumItems,1,ProcWorkerChunk,m_WorkerInstances,60,nullptr,pProgressFunc,pProgressCtx,NumThreads);
+	else
+		ProcWorkerChunk(m_WorkerInstances,0,NumItems,0);
 	}
 
-// request all worker threads to self terminate
-AcquireSerialise();
-m_ReqTerminate = 1;
-ReleaseSerialise();
-if (CompletedWorkerInsts < ExpNumWorkerInsts)
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "TerminateWorkerThreads: Requesting %u worker threads to terminate", ExpNumWorkerInsts - CompletedWorkerInsts);
-Then = time(nullptr) + WaitSecs;
-NumForceTerminated = 0;
 pThreadPar = m_WorkerInstances;
-for(Idx = 0; Idx < ExpNumWorkerInsts; Idx++, pThreadPar += 1)
+for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThreadPar++)
 	{
-	Now = time(nullptr);
-	if(Now >= Then)
-		Now = 1;
-	else
-		Now = Then - Now;
-
-#ifdef WIN32
-	if(pThreadPar->threadHandle != nullptr)
-		{
-		if(WAIT_TIMEOUT == WaitForSingleObject(pThreadPar->threadHandle, (uint32_t)Now * 1000))
-			{
-			NumForceTerminated += 1;
-			gDiagnostics.DiagOut(eDLInfo, gszProcName, "TerminateWorkerThreads: Force terminating thread %u, WaitForSingleObject() returned WAIT_TIMEOUT", pThreadPar->ThreadIdx);
-			TerminateThread(pThreadPar->threadHandle,0);
-			}
-		pThreadPar->threadHandle = nullptr;
-		}
-#else
-	if(pThreadPar->threadID != 0)
-		{
-		struct timespec ts;
-		int JoinRlt;
-		void *pExitRslt;
-		clock_gettime(CLOCK_REALTIME, &ts);
-		ts.tv_sec += Now;
-		if ((JoinRlt = pthread_timedjoin_np(pThreadPar->threadID, &pExitRslt, &ts)) != 0)
-			{
-			gDiagnostics.DiagOut(eDLInfo, gszProcName, "TerminateWorkerThreads: Force terminating thread %u, pthread_timedjoin_np() returned %d",pThreadPar->ThreadIdx,JoinRlt);
-			NumForceTerminated += 1;
-			pthread_cancel(pThreadPar->threadID);	
-			pthread_join(pThreadPar->threadID, nullptr);
-			}
-		pThreadPar->threadID = 0;
-		}
-#endif
+	if(pThreadPar->Rslt < eBSFSuccess)
+		Rslt = pThreadPar->Rslt;
 	}
-
-pThreadPar = m_WorkerInstances;
-AcquireSerialise();
-for(Idx = 0; Idx < ExpNumWorkerInsts; Idx++, pThreadPar += 1)
-	memset(pThreadPar,0,sizeof(tsCHWorkerInstance));
-m_NumWorkerInsts = 0;
-m_ExpNumWorkerInsts = 0;
-m_CompletedWorkerInsts = 0;
-m_ReqTerminate = 0;
-ReleaseSerialise();
-return(NumForceTerminated);
+return(Rslt);
 }
 
-// stop all threads in worker load chromosome PBAs thread pool
-int
-CCallHaplotypes::TerminateLoadChromPBAsThreads(int WaitSecs)				// allow at most this many seconds before force terminating worker pool threads
+void
+CCallHaplotypes::AlleleStacksProgress(void *pProgressCtx)		// called every 60 seconds whilst allele stacks are still being generated
 {
-int NumForceTerminated;
-uint32_t Idx;
-uint32_t NumWorkerInsts;
-uint32_t ExpNumWorkerInsts;
-uint32_t CompletedWorkerInsts;
-tsCHWorkerLoadChromPBAsInstance* pThreadPar;
-time_t Then;
-time_t Now;
-
-AcquireSerialise();
-NumWorkerInsts = m_NumWorkerInsts;
-ExpNumWorkerInsts = m_ExpNumWorkerInsts;
-CompletedWorkerInsts = m_CompletedWorkerInsts;
-ReleaseSerialise();
-if (ExpNumWorkerInsts == 0)
-	{
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "TerminateLoadChromPBAsThreads: No worker threads to terminate");
-	pThreadPar = m_WorkerLoadChromPBAInstances;
-	AcquireSerialise();
-	for (Idx = 0; Idx < ExpNumWorkerInsts; Idx++, pThreadPar += 1)
-		memset(pThreadPar, 0, sizeof(tsCHWorkerLoadChromPBAsInstance));
-	m_NumWorkerInsts = 0;
-	m_ExpNumWorkerInsts = 0;
-	m_CompletedWorkerInsts = 0;
-	m_ReqTerminate = 0;
-	ReleaseSerialise();
-	return(0);
-	}
-
-// request all worker threads to self terminate
-AcquireSerialise();
-m_ReqTerminate = 1;
-ReleaseSerialise();
-if(NumWorkerInsts != CompletedWorkerInsts)
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "TerminateLoadChromPBAsThreads: Requesting %u worker threads to terminate", NumWorkerInsts);
-Then = time(nullptr) + WaitSecs;
-NumForceTerminated = 0;
-pThreadPar = m_WorkerLoadChromPBAInstances;
-for (Idx = 0; Idx < ExpNumWorkerInsts; Idx++, pThreadPar += 1)
-	{
-	Now = time(nullptr);
-	if (Now >= Then)
-		Now = 1;
-	else
-		Now = Then - Now;
-
-#ifdef WIN32
-	if (pThreadPar->threadHandle != nullptr)
-		{
-		if (WAIT_TIMEOUT == WaitForSingleObject(pThreadPar->threadHandle, (uint32_t)Now * 1000))
-			{
-			NumForceTerminated += 1;
-			TerminateThread(pThreadPar->threadHandle, 0);
-			}
-		pThreadPar->threadHandle = nullptr;
-		}
-#else
-	if (pThreadPar->threadID != 0)
-		{
-		struct timespec ts;
-		int JoinRlt;
-		void* pExitRslt;
-		clock_gettime(CLOCK_REALTIME, &ts);
-		ts.tv_sec += Now;
-		if ((JoinRlt = pthread_timedjoin_np(pThreadPar->threadID, &pExitRslt, &ts)) != 0)
-			{
-			gDiagnostics.DiagOut(eDLInfo, gszProcName, "TerminateLoadChromPBAsThreads: Force terminating thread %u, pthread_timedjoin_np() returned %d", pThreadPar->ThreadIdx, JoinRlt);
-			NumForceTerminated += 1;
-			pthread_cancel(pThreadPar->threadID);
-			pthread_join(pThreadPar->threadID, nullptr);
-			}
-		pThreadPar->threadID = 0;
-		}
-#endif
-	}
+tsCHWorkerProgress *pProgress = (tsCHWorkerProgress *)pProgressCtx;
+gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignAlleleStacks: Generating allele stacks for chromosome %s .... ", pProgress->pszChrom);
+}
 
-pThreadPar = m_WorkerLoadChromPBAInstances;
-AcquireSerialise();
-for (Idx = 0; Idx < ExpNumWorkerInsts; Idx++, pThreadPar += 1)
-	memset(pThreadPar, 0, sizeof(tsCHWorkerLoadChromPBAsInstance));
-m_NumWorkerInsts = 0;
-m_ExpNumWorkerInsts = 0;
-m_CompletedWorkerInsts = 0;
-m_ReqTerminate = 0;
-ReleaseSerialise();
-return(NumForceTerminated);
+void
+CCallHaplotypes::HapGroupingsProgress(void *pProgressCtx)		// called every 60 seconds whilst haplotype groupings are still being generated
+{
+int32_t LatestAllocID;
+tsCHWorkerProgress *pProgress = (tsCHWorkerProgress *)pProgressCtx;
+CCallHaplotypes *pThis = pProgress->pThis;
+pThis->AcquireFastSerialise();
+LatestAllocID = pThis->m_ProccessingHGAllocID;
+pThis->ReleaseFastSerialise();
+gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Generating haplotype groupings on chromosome '%s' ... %0.3f%% of total haplotype grouping specification bins processed", pProgress->pszChrom, (LatestAllocID * 100.0) / pThis->m_UsedHGBinSpecs);
 }
 
-// Using threads to concurrently load chromosome PBAs
+// load chromosome PBAs for a range of samples
 // ChromID is specified and range of sample identifiers
 int
-CCallHaplotypes::ProcWorkerLoadChromPBAThread(tsCHWorkerLoadChromPBAsInstance* pThreadPar)	// worker thread parameters
+CCallHaplotypes::LoadSampleRangeChromPBAs(tsCHWorkerLoadChromPBAsInstance* pPars,	// chromosome and allele normalisation
+								int32_t StartSampleID,	// load PBAs for samples starting from this sample identifier
+								int32_t EndSampleID)	// ending with this sample identifier inclusive
 {
-int Rslt;
 uint8_t PBA;
 uint8_t* pPBAs;
 int32_t Ofs;
 int32_t CurSampleID;
 uint32_t ReqTerminate;
-// one more thread instance has started
-AcquireSerialise();
-m_NumWorkerInsts++;
-ReleaseSerialise();
 
-for(CurSampleID = pThreadPar->StartSampleID; CurSampleID <= pThreadPar->EndSampleID; CurSampleID++)
+for(CurSampleID = StartSampleID; CurSampleID <= EndSampleID; CurSampleID++)
 	{
 	// check if requested to terminate
 	AcquireSerialise();
@@ -7556,12 +6948,12 @@ for(CurSampleID = pThreadPar->StartSampleID; CurSampleID <= pThreadPar->EndSampl
 
 	// it is possible for a chromosome to be missing in a PBA if no reads were aligned to that chromosome
 	// if so then continue loading from remaining samples
-	if((pPBAs = LoadSampleChromPBAs(CurSampleID, pThreadPar->ChromID)) == nullptr)
+	if((pPBAs = LoadSampleChromPBAs(CurSampleID, pPars->ChromID)) == nullptr)
 		continue;
 
-	if(pThreadPar->bNormAlleles)
+	if(pPars->bNormAlleles)
 		{
-		tsCHChromMetadata *pChromMetadata = LocateChromMetadataFor(CurSampleID, pThreadPar->ChromID);
+		tsCHChromMetadata *pChromMetadata = LocateChromMetadataFor(CurSampleID, pPars->ChromID);
 		for (Ofs = 0; Ofs < pChromMetadata->ChromLen; Ofs++, pPBAs++)
 			{
 			if ((PBA = *pPBAs) == 0)
@@ -7579,104 +6971,55 @@ for(CurSampleID = pThreadPar->StartSampleID; CurSampleID <= pThreadPar->EndSampl
 		}
 		}
 	}
-if(CurSampleID <= pThreadPar->EndSampleID)
-	Rslt = -1;
-else
-	Rslt = eBSFSuccess;
-AcquireSerialise();
-m_CompletedWorkerInsts++;
-ReleaseSerialise();
-return(Rslt);
+return(CurSampleID <= EndSampleID ? -1 : eBSFSuccess);
 }
 
 int
-CCallHaplotypes::ProcWorkerThread(tsCHWorkerInstance *pThreadPar)	// worker thread parameters
+CCallHaplotypes::ProcWorkItem(tsCHWorkerInstance *pThreadPar,	// worker instance parameters
+								int32_t ItemIdx)		// process this work item, a work queue element or a haplotype grouping bin, relative to m_StartWorkItemIdx
 {
 int Rslt;
-int CurAllocID;
-uint32_t NumQueueElsProcessed;
 tsCHWorkQueueEl *pWorkQueueEl;
+tsHGBinSpec* pCurBinSpec;
 uint32_t ReqTerminate;
-// this thread has started, one more worker thread
-AcquireSerialise();
-m_NumWorkerInsts++;
-ReleaseSerialise();
-NumQueueElsProcessed = 0;
-pWorkQueueEl = nullptr;
-CurAllocID = m_ProccessingHGAllocID;
-Rslt = eBSFSuccess;
-while(Rslt >= eBSFSuccess) {
-	// check if requested to terminate
-	AcquireSerialise();
-	ReqTerminate = m_ReqTerminate;
-	ReleaseSerialise();
-	if(ReqTerminate)
-		{
-		Rslt = -1;
-		break;
-		}
-	if(m_PMode < eMCSHAllelicHapsGrps) 
-		{
-		AcquireSerialise();
-    	NumQueueElsProcessed = 	m_NumQueueElsProcessed; // multiple work queue elements to be processed, each thread is processing one of these work elements
-	    if(NumQueueElsProcessed == m_TotWorkQueueEls)
-		    {
-			ReleaseSerialise();
-			break;
-			}
-		m_NumQueueElsProcessed++;
-		ReleaseSerialise();
-		pWorkQueueEl = &m_pWorkQueueEls[NumQueueElsProcessed];
-		Rslt = GenChromAlleleStacks(pWorkQueueEl->ChromID, pWorkQueueEl->ChromLen, pWorkQueueEl->StartLoci, pWorkQueueEl->MaxNumLoci, pWorkQueueEl->NumFndrs, pWorkQueueEl->pFounderPBAs, pWorkQueueEl->pMskPBA);
-		}
-	else // a single work queue element per chromosome - and just one chromosome to be processed, so just one work queue element! threads iterate over haplotype grouping bins for that chromosome
-		{
-		tsHGBinSpec* pCurBinSpec;
-		pWorkQueueEl = &m_pWorkQueueEls[0]; // remember, just a single work queue element ...
-		if((pCurBinSpec = IterateHGBinSpecs(CurAllocID,pWorkQueueEl->ChromID)) == nullptr)
-			break;
-		CurAllocID = pCurBinSpec->AllocID;
-		Rslt = GenHaplotypeGroups(pCurBinSpec,pWorkQueueEl->NumFndrs, pWorkQueueEl->pFounderPBAs, pWorkQueueEl->ChromLen);
-		AcquireFastSerialise();
-		pCurBinSpec->ProcState |= 0x07; // bin processing state  - 0x00 if unprocessed, 0x01 if currently being processing, 0x03 if processing completed but referenced chromosome not located, 0x07 if processing successfully completed
-		ReleaseFastSerialise();
-		}
-	}
 
+// check if requested to terminate
 AcquireSerialise();
-m_CompletedWorkerInsts++;
+ReqTerminate = m_ReqTerminate;
 ReleaseSerialise();
-return(Rslt);
-}
-
-int				// returns 0 if all threads started and completed processing, 1 if all threads started but some yet to complete within WaitSecs, 2 if not all threads have started within WaitSecs
-CCallHaplotypes::WaitWorkerThreadStatus(int WaitSecs)	// // wait at most this many seconds for all threads to start and complete processing before reporting on worker thread status
-{
-int64_t WaitMS;
-if(WaitSecs < 1)
-	WaitSecs = 1;
-WaitMS = (int64_t)WaitSecs * 1000;
+if(ReqTerminate)
+	return(-1);
 
-uint32_t CompletedInstances;
-uint32_t NumWorkerInsts;
-uint32_t ExpNumWorkerInsts;
-do {
-	CUtility::SleepMillisecs(500);		// poll every 0.5 secs, restricting poll frequency
+if(m_PMode < eMCSHAllelicHapsGrps)	// multiple work queue elements to be processed, each item is one of these work elements
+	{
+	pWorkQueueEl = &m_pWorkQueueEls[m_StartWorkItemIdx + ItemIdx];
+	Rslt = GenChromAlleleStacks(pWorkQueueEl->ChromID, pWorkQueueEl->ChromLen, pWorkQueueEl->StartLoci, pWorkQueueEl->MaxNumLoci, pWorkQueueEl->NumFndrs, pWorkQueueEl->pFounderPBAs, pWorkQueueEl->pMskPBA);
 	AcquireSerialise();
-	CompletedInstances = m_CompletedWorkerInsts;
-	NumWorkerInsts = m_NumWorkerInsts;
-	ExpNumWorkerInsts = m_ExpNumWorkerInsts;
+	m_NumQueueElsProcessed++;
 	ReleaseSerialise();
-	WaitMS -= 500;
+	return(Rslt);
 	}
-while(ExpNumWorkerInsts > 0 &&		// surely must be some workers expected!
-	 CompletedInstances < ExpNumWorkerInsts	 && // have all workers completed 
-	 WaitMS > 0);					// within wait period (WaitSecs)
 
-return((NumWorkerInsts == ExpNumWorkerInsts && CompletedInstances == ExpNumWorkerInsts) ? 0 : (NumWorkerInsts == ExpNumWorkerInsts ? 1 : 2));
+// a single work queue element per chromosome - and just one chromosome to be processed, so just one work queue element! each item is a haplotype grouping bin for that chromosome
+pWorkQueueEl = &m_pWorkQueueEls[0];
+pCurBinSpec = &m_pHGBinSpecs[m_StartWorkItemIdx + ItemIdx];
+AcquireFastSerialise();
+if(pCurBinSpec->ChromID != pWorkQueueEl->ChromID || (pCurBinSpec->ProcState & 0x07)) // bins are unordered so may be on another chromosome, or may already have been processed
+	{
+	ReleaseFastSerialise();
+	return(eBSFSuccess);
+	}
+pCurBinSpec->ProcState |= 0x01; // bin now allocated for processing
+if(pCurBinSpec->AllocID > m_ProccessingHGAllocID)
+	m_ProccessingHGAllocID = pCurBinSpec->AllocID; // marks last bin accepted for processing, will be used to initialise processing for next chromosome
+ReleaseFastSerialise();
+Rslt = GenHaplotypeGroups(pCurBinSpec,pWorkQueueEl->NumFndrs, pWorkQueueEl->pFounderPBAs, pWorkQueueEl->ChromLen);
+AcquireFastSerialise();
+pCurBinSpec->ProcState |= 0x07; // bin processing state  - 0x00 if unprocessed, 0x01 if currently being processing, 0x03 if processing completed but referenced chromosome not located, 0x07 if processing successfully completed
+ReleaseFastSerialise();
+return(Rslt);
 }
 
-
 int				// < 0 if errors, otherwise success
 CCallHaplotypes::GenChromAlleleStacks(int32_t ChromID,	// processing is for this chromosome
 										  int32_t ChromSize,		// chromosome is this size
@@ -7703,6 +7046,20 @@ uint32_t DivAlleles;
 uint32_t LociFounders;
 uint8_t FndrBaseAllele;
 tsBitsVect Fndrs2Proc;
+int32_t LastFndrIdx;
+int32_t BlockLoci;
+int32_t BlockLen;
+int32_t NumWords;
+int32_t WordIdx;
+int32_t Bit;
+uint64_t CandLoci;
+uint64_t LociValid[cASMaskBlockLoci/64];
+uint64_t FndrNone[cASMaskBlockLoci/64];
+uint64_t FndrDirac[cASMaskBlockLoci/64];
+uint64_t FndrAlleles[4][cASMaskBlockLoci/64];
+uint64_t AlleleOnce[4][cASMaskBlockLoci/64];
+uint64_t AlleleTwice[4][cASMaskBlockLoci/64];
+uint64_t *pFndrAlleles[4] = {FndrAlleles[0],FndrAlleles[1],FndrAlleles[2],FndrAlleles[3]};
 
 if(NumFndrs < 1 || NumFndrs > cMaxFounderReadsets)
 	return(-1);
@@ -7710,10 +7067,12 @@ if(NumFndrs < 1 || NumFndrs > cMaxFounderReadsets)
 // check that at least 1 founder actually has a PBAs
 memset(&Fndrs2Proc, 0, sizeof(Fndrs2Proc));
 NumFndrs2Proc = 0;
+LastFndrIdx = -1;
 for(FounderIdx = 0; FounderIdx < NumFndrs; FounderIdx++)
 	{
 	if(!(m_Fndrs2Proc[FounderIdx] & 0x01))		// not interested as founder not marked for scoring?
 		continue;
+	LastFndrIdx = FounderIdx;
 	if((pFndrLoci = pFounderPBAs[FounderIdx]) == nullptr)	// can't score if no PBA for this founder
 		continue;
 	BitsVectSet(NumFndrs2Proc, Fndrs2Proc);
@@ -7732,77 +7091,127 @@ memcpy(&AlleleStack.ProcFndrs, &Fndrs2Proc, sizeof(tsBitsVect));
 
 bFndrAllele = false;
 NumAlleleStacks = 0;
-for(AlleleLoci = Loci; AlleleLoci < EndLoci; AlleleLoci++)
-	{
-	if(pMskPBA != nullptr && pMskPBA[AlleleLoci] == 0)	// skipping over any loci in control which has no PBA
-		continue;
+if(pFounderPBAs[LastFndrIdx] == nullptr)		// loci are only accepted if the last founder marked for processing has an allele
+	return(0);
 
-// build stack of alleles containing founder alleles at AlleleLoci
-// to be accepted as a founder allele stack then each founder must have a dirac allele unique to that founder only
-// progeny can then use founder allele stacks to inform as to the lineage  
-	AlleleStack.Loci = AlleleLoci;
-	memset(AlleleStack.NumAlleleFndrs, 0, sizeof(AlleleStack.NumAlleleFndrs));
-	memset(AlleleStack.Alleles, 0, sizeof(AlleleStack.Alleles));
-	LociFounders = 0;
-	PrevAlleleIdx = 0;
+// loci are processed in blocks, bit-sliced masks over each block identifying those loci which will be accepted as allele stacks
+// a loci is accepted if each founder processed has a single dirac allele, or no allele if not m_bAllFndrsLociAligned, the last founder processed has a dirac allele, and at least one allele is unique to a single founder
+for(BlockLoci = Loci; BlockLoci < EndLoci; BlockLoci += BlockLen)
+	{
+	BlockLen = min(EndLoci - BlockLoci, cASMaskBlockLoci);
+	NumWords = (BlockLen + 63) / 64;
+	memset(LociValid, 0xff, sizeof(uint64_t) * NumWords);
+	if(BlockLen % 64)
+		LociValid[NumWords - 1] = ((uint64_t)1 << (BlockLen % 64)) - 1;
+	memset(AlleleOnce, 0, sizeof(AlleleOnce));
+	memset(AlleleTwice, 0, sizeof(AlleleTwice));
+	if(pMskPBA != nullptr)		// skipping over any loci in control which has no PBA
+		{
+		CPBAcmp::AlleleMasks(&pMskPBA[BlockLoci], BlockLen, FndrNone, nullptr, nullptr);
+		for(WordIdx = 0; WordIdx < NumWords; WordIdx++)
+			LociValid[WordIdx] &= ~FndrNone[WordIdx];
+		}
 	for(FndrIdx = 0; FndrIdx < NumFndrs; FndrIdx++)
 		{
-		if(!(m_Fndrs2Proc[FndrIdx] & 0x01))	// skip this founder?
+		if(!(m_Fndrs2Proc[FndrIdx] & 0x01) || pFounderPBAs[FndrIdx] == nullptr)
 			continue;
-		bFndrAllele = false;
-		if(pFounderPBAs[FndrIdx] == nullptr)
+		CPBAcmp::AlleleMasks(&pFounderPBAs[FndrIdx][BlockLoci], BlockLen, FndrNone, FndrDirac, pFndrAlleles);
+		CandLoci = 0;
+		for(WordIdx = 0; WordIdx < NumWords; WordIdx++)
 			{
-			continue;
+			if(FndrIdx == LastFndrIdx || m_bAllFndrsLociAligned)
+				LociValid[WordIdx] &= FndrDirac[WordIdx];
+			else
+				LociValid[WordIdx] &= FndrDirac[WordIdx] | FndrNone[WordIdx];
+			for(AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
+				{
+				AlleleTwice[AlleleIdx][WordIdx] |= AlleleOnce[AlleleIdx][WordIdx] & FndrAlleles[AlleleIdx][WordIdx];
+				AlleleOnce[AlleleIdx][WordIdx] |= FndrAlleles[AlleleIdx][WordIdx];
+				}
+			CandLoci |= LociValid[WordIdx];
 			}
+		if(CandLoci == 0)			// no loci in this block can be accepted
+			break;
+		}
 
-		pFndrLoci = pFounderPBAs[FndrIdx] + AlleleLoci;
-		if(*pFndrLoci == 0)					
+	for(WordIdx = 0; WordIdx < NumWords; WordIdx++)
+		{
+		CandLoci = LociValid[WordIdx] & ((AlleleOnce[0][WordIdx] & ~AlleleTwice[0][WordIdx]) | (AlleleOnce[1][WordIdx] & ~AlleleTwice[1][WordIdx]) |
+										 (AlleleOnce[2][WordIdx] & ~AlleleTwice[2][WordIdx]) | (AlleleOnce[3][WordIdx] & ~AlleleTwice[3][WordIdx]));
+		for(Bit = 0; CandLoci != 0; Bit++, CandLoci >>= 1)
 			{
-			if(m_bAllFndrsLociAligned)           // all founders must have alignment alleles at the AlleleLoci
+			if(!(CandLoci & 0x01))
+				continue;
+			AlleleLoci = BlockLoci + (WordIdx * 64) + Bit;
+
+			// build stack of alleles containing founder alleles at AlleleLoci
+			// to be accepted as a founder allele stack then each founder must have a dirac allele unique to that founder only
+			// progeny can then use founder allele stacks to inform as to the lineage  
+			AlleleStack.Loci = AlleleLoci;
+			memset(AlleleStack.NumAlleleFndrs, 0, sizeof(AlleleStack.NumAlleleFndrs));
+			memset(AlleleStack.Alleles, 0, sizeof(AlleleStack.Alleles));
+			LociFounders = 0;
+			PrevAlleleIdx = 0;
+			for(FndrIdx = 0; FndrIdx < NumFndrs; FndrIdx++)
 				{
+				if(!(m_Fndrs2Proc[FndrIdx] & 0x01))	// skip this founder?
+					continue;
 				bFndrAllele = false;
-				break;							// founder has no allele - can't have had an alignment to reference at AlleleLoci
-				}
-			continue;                          // next founder may have an alignment
-			}
+				if(pFounderPBAs[FndrIdx] == nullptr)
+					{
+					continue;
+					}
 
-		AlleleMsk = 0x03;					// differentiation is at the allele level
-		for(AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++, AlleleMsk <<= 2)
-			{
-			FndrBaseAllele = (*pFndrLoci & AlleleMsk) >> (AlleleIdx * 2);
+				pFndrLoci = pFounderPBAs[FndrIdx] + AlleleLoci;
+				if(*pFndrLoci == 0)					
+					{
+					if(m_bAllFndrsLociAligned)           // all founders must have alignment alleles at the AlleleLoci
+						{
+						bFndrAllele = false;
+						break;							// founder has no allele - can't have had an alignment to reference at AlleleLoci
+						}
+					continue;                          // next founder may have an alignment
+					}
 
-			if(FndrBaseAllele <= 2)		// no allele, with founders then only interest is in diracs
-				continue;				// try next allele
+				AlleleMsk = 0x03;					// differentiation is at the allele level
+				for(AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++, AlleleMsk <<= 2)
+					{
+					FndrBaseAllele = (*pFndrLoci & AlleleMsk) >> (AlleleIdx * 2);
 
-			if(bFndrAllele)				// founders must have a single unique allele
-				{
-				bFndrAllele = false;
-				break;
-				}
-			bFndrAllele = true;			// accepting this founder as having at least one allele, if more alleles then founder loci treated as having no alleles
-			AlleleStack.NumAlleleFndrs[AlleleIdx]++;
-			BitsVectSet(FndrIdx, AlleleStack.Alleles[AlleleIdx]);
-			}
+					if(FndrBaseAllele <= 2)		// no allele, with founders then only interest is in diracs
+						continue;				// try next allele
 
-		if(!bFndrAllele)				// if no alleles of required level for this founder then don't bother with other founders
-			break;
-		}
+					if(bFndrAllele)				// founders must have a single unique allele
+						{
+						bFndrAllele = false;
+						break;
+						}
+					bFndrAllele = true;			// accepting this founder as having at least one allele, if more alleles then founder loci treated as having no alleles
+					AlleleStack.NumAlleleFndrs[AlleleIdx]++;
+					BitsVectSet(FndrIdx, AlleleStack.Alleles[AlleleIdx]);
+					}
 
-	if(!bFndrAllele)				// if no alleles then process next loci
-		continue;
+				if(!bFndrAllele)				// if no alleles of required level for this founder then don't bother with other founders
+					break;
+				}
 
-		// is there diversity in alleles between all founders - need diversity in order to differentiate founder alleles in progeny
-	for(DivAlleles = AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
-		{
-		if(AlleleStack.NumAlleleFndrs[AlleleIdx] == 1)
-			DivAlleles++;
-		}
+			if(!bFndrAllele)				// if no alleles then process next loci
+				continue;
 
-	if(DivAlleles < 1) 				// must be at least one founder unique relative to others to be informative...
-		continue;
+			// is there diversity in alleles between all founders - need diversity in order to differentiate founder alleles in progeny
+			for(DivAlleles = AlleleIdx = 0; AlleleIdx < 4; AlleleIdx++)
+				{
+				if(AlleleStack.NumAlleleFndrs[AlleleIdx] == 1)
+					DivAlleles++;
+				}
 
-	AddAlleleStack(&AlleleStack);
-	NumAlleleStacks++;
+			if(DivAlleles < 1) 				// must be at least one founder unique relative to others to be informative...
+				continue;
+
+			AddAlleleStack(&AlleleStack);
+			NumAlleleStacks++;
+			}
+		}
 	}
 return(NumAlleleStacks);
 }
@@ -7827,9 +7236,9 @@ uint8_t MaxFreqAllele;
 
 pConsensusPLoci = pConsensusPBAs;
 EndLoci = Loci + NumLoci;
+memset(AlleleFreq,0,sizeof(AlleleFreq));
 for(AlleleLoci = Loci; AlleleLoci < EndLoci; AlleleLoci++, pConsensusPLoci++)
 	{
-	memset(AlleleFreq,0,sizeof(AlleleFreq));
 	MaxFreqAllele = 0;
 	for(FndrIdx = 0; FndrIdx < NumFndrs; FndrIdx++)
 		{
@@ -7839,16 +7248,12 @@ for(AlleleLoci = Loci; AlleleLoci < EndLoci; AlleleLoci++, pConsensusPLoci++)
 			MaxFreqAllele = *pFndrLoci;
 		}
 	*pConsensusPLoci = MaxFreqAllele;
+	for(FndrIdx = 0; FndrIdx < NumFndrs; FndrIdx++)	// only need to reset the frequencies of alleles at this loci
+		AlleleFreq[pFounderPBAs[FndrIdx][AlleleLoci]] = 0;
 	}
 NumNonConsensus = 0;
 for (FndrIdx = 0; FndrIdx < NumFndrs; FndrIdx++)
-	{
-	pConsensusPLoci = pConsensusPBAs;
-	pFndrLoci = pFounderPBAs[FndrIdx] + Loci;
-	for(AlleleLoci = 0; AlleleLoci < NumLoci; AlleleLoci++, pFndrLoci++, pConsensusPLoci++)
-		if (*pFndrLoci != *pConsensusPLoci)
-			NumNonConsensus++;
-	}
+	NumNonConsensus += CPBAcmp::NumDiffs(pFounderPBAs[FndrIdx] + Loci, pConsensusPBAs, NumLoci);
 return(NumNonConsensus);
 }
 
@@ -8169,20 +7574,14 @@ for(ChromID = 1; ChromID <= m_NumChromNames; ChromID++)
 	char* pszChrom = LocateChrom(ChromID);
 
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "ProcessGrpLociDGTs: Begining to load PBAs for %s chromosome for DGT processing .... ", pszChrom);
-	int WorkerThreadStatus = StartWorkerLoadChromPBAThreads(m_NumThreads, 1, m_NumFounders, ChromID);
+	int WorkerThreadStatus = LoadChromPBAs(m_NumThreads, 1, m_NumFounders, ChromID);
 	if (WorkerThreadStatus < 0)
 		{
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "ProcessGrpLociDGTs: Errors loading PBAs for %s chromosome for DGT processing .... ", pszChrom);
 		delete []ppPBAs;
 		return(WorkerThreadStatus);
 		}
-	while (WorkerThreadStatus > 0)
-		{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "ProcessGrpLociDGTs: Continuing to load chromosome PBAs for %s .... ", pszChrom);
-		WorkerThreadStatus = WaitWorkerThreadStatus(60);
-		}
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "ProcessGrpLociDGTs: Completed loading chromosome PBAs for %s for DGT processing", pszChrom);
-	TerminateLoadChromPBAsThreads(60);
 
 	for(SampleID = 1; SampleID <= m_NumFounders; SampleID++)
 		{
@@ -9622,6 +9021,7 @@ int32_t MaximalChromLen;
 uint32_t NumUnits;			// NumUnits is the total number of work units to be distributed over available threads for processing an individual chromosome
 uint32_t UnitSize;
 int WorkerThreadStatus;
+tsCHWorkerProgress WorkerProgress;
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"AlignAlleleStacks: Starting to generate allele stacks over %d founders ",NumFndrs);
 if(m_pWorkQueueEls != nullptr)				// ensuring only one work queue exists
 	delete []m_pWorkQueueEls;
@@ -9677,19 +9077,13 @@ for(ChromIdx = 0; ChromIdx < pReadsetMetadata->NumChroms && CurChromMetadataIdx
 	pszChrom = LocateChrom(CurChromID);
 
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Loading chromosome PBAs for '%s' over %d founders", pszChrom, m_NumFounders);
-	WorkerThreadStatus = StartWorkerLoadChromPBAThreads(m_NumThreads, 1, m_NumFounders, CurChromID);
+	WorkerThreadStatus = LoadChromPBAs(m_NumThreads, 1, m_NumFounders, CurChromID);
 	if (WorkerThreadStatus < 0)
 		{
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Errors loading PBAs for %s chromosome", pszChrom);
 		delete[]ppPBAs;
 		return(WorkerThreadStatus);
 		}
-	while (WorkerThreadStatus > 0)
-		{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Continuing to load chromosome PBAs for %s .... ", pszChrom);
-		WorkerThreadStatus = WaitWorkerThreadStatus(60);
-		}
-	TerminateLoadChromPBAsThreads(60);
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Completed loading chromosome PBAs for %s", pszChrom);
 
 	for(FounderID = 1; FounderID <= m_NumFounders; FounderID++)
@@ -9749,7 +9143,9 @@ for(ChromIdx = 0; ChromIdx < pReadsetMetadata->NumChroms && CurChromMetadataIdx
 		StartLoci += UnitSize;
 		}
 
-	WorkerThreadStatus = StartWorkerThreads(m_NumThreads, 1);
+	WorkerProgress.pThis = this;
+	WorkerProgress.pszChrom = pszChrom;
+	WorkerThreadStatus = RunWorkerThreads(m_NumThreads, AlleleStacksProgress, &WorkerProgress);
 	if (WorkerThreadStatus < 0)
 		{
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignAlleleStacks: Errors generating allele stacks");
@@ -9757,14 +9153,7 @@ for(ChromIdx = 0; ChromIdx < pReadsetMetadata->NumChroms && CurChromMetadataIdx
 			delete[]ppPBAs;
 		return(WorkerThreadStatus);
 		}
-	while (WorkerThreadStatus > 0)
-		{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignAlleleStacks: Generating allele stacks for chromosome %s .... ", pszChrom);
-		WorkerThreadStatus = WaitWorkerThreadStatus(60);
-		}
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignAlleleStacks: Completed generating allele stacks for chromosome %s", pszChrom);
-	WorkerThreadStatus=TerminateWorkerThreads(60);
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignAlleleStacks: TerminateWorkThreads(60) returned %d", WorkerThreadStatus);
 	}
 
 if(CurChromID > 0)
@@ -9805,6 +9194,7 @@ uint8_t *pMskPBA;
 int32_t ChromIdx;
 uint32_t NumUnits;			// NumUnits is the total number of work units to be distributed over available threads for processing chromosomes
 bool bInitHGBinSpecs;
+tsCHWorkerProgress WorkerProgress;
 
 
 pReadsetMetadata = &m_Readsets[0];		// founders were loaded first so 1st founder will be here
@@ -9896,19 +9286,13 @@ for(ChromIdx = 0; ChromIdx < pReadsetMetadata->NumChroms && CurChromMetadataIdx
 	// load this chromosome PBAs from all founders, all founders must have PBAs for this chromosome otherwise chromosome will be skipped
 
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Loading %s on '%s' for %d founders", m_PMode == eMCSHCoverageHapsGrps ? "WIGs" : "PBAs", pszChrom, NumFndrs);
-	int WorkerThreadStatus = StartWorkerLoadChromPBAThreads(m_NumThreads, 1, NumFndrs, CurChromID);
+	int WorkerThreadStatus = LoadChromPBAs(m_NumThreads, 1, NumFndrs, CurChromID);
 	if (WorkerThreadStatus < 0)
 		{
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Errors loading %s for %s chromosome", m_PMode == eMCSHCoverageHapsGrps ? "WIGs" : "PBAs", pszChrom);
 		delete[]ppPBAs;
 		return(WorkerThreadStatus);
 		}
-	while (WorkerThreadStatus > 0)
-		{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Continuing to load chromosome PBAs for %s .... ", pszChrom);
-		WorkerThreadStatus = WaitWorkerThreadStatus(60);
-		}
-	TerminateLoadChromPBAsThreads(60);
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Completed loading chromosome PBAs for %s", pszChrom);
 
 	for(FounderID = 1; FounderID <= NumFndrs; FounderID++)
@@ -9942,7 +9326,9 @@ for(ChromIdx = 0; ChromIdx < pReadsetMetadata->NumChroms && CurChromMetadataIdx
 	m_TotWorkQueueEls = 1;
 
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"AlignFounderHaps: Starting to generate haplotype groupings on '%s' for %d founders ",pszChrom,NumFndrs);
-	WorkerThreadStatus = StartWorkerThreads(m_NumThreads, 1);
+	WorkerProgress.pThis = this;
+	WorkerProgress.pszChrom = pszChrom;
+	WorkerThreadStatus = RunWorkerThreads(m_NumThreads, HapGroupingsProgress, &WorkerProgress);
 	if (WorkerThreadStatus < 0)
 		{
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Errors Generating haplotype groupings on chrom '%s'", pszChrom);
@@ -9955,19 +9341,7 @@ for(ChromIdx = 0; ChromIdx < pReadsetMetadata->NumChroms && CurChromMetadataIdx
 			}
 		return(WorkerThreadStatus);
 		}
-	int WaitSecs = 60; // initially wait 1 minute before reporting progress, but increment by 1 minute up to a max of 5 minutes to avoid swamping the logs with progress messages
-	while (WorkerThreadStatus > 0)
-		{
-		WorkerThreadStatus = WaitWorkerThreadStatus(60);
-		WaitSecs = min(WaitSecs += 60, 300);
-		AcquireFastSerialise();
-		int32_t LatestAllocID = m_ProccessingHGAllocID;
-		ReleaseFastSerialise();
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Generating haplotype groupings on chromosome '%s' ... %0.3f%% of total haplotype grouping specification bins processed", pszChrom, (LatestAllocID * 100.0) / m_UsedHGBinSpecs);
-		}
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Completed generating all haplotype groupings on chromosome %s", pszChrom);
-	WorkerThreadStatus = TerminateWorkerThreads(60);
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: TerminateWorkThreads(60) returned %d", WorkerThreadStatus);
 	}
 
 gDiagnostics.DiagOut(eDLInfo, gszProcName, "AlignFounderHaps: Completed generating haplotype groupings over all chromosomes");
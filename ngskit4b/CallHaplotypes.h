@@ -8,6 +8,7 @@ const int32_t cMaxProgenyFileSpecs = 500;			// can specify a max of this number
 
 const int32_t cMaxFounderReadsets = 2000;			// after input wildcard expansion then can accept at most this max number of founder readsets
 const int32_t cMaxProgenyReadsets = 10000;			// after input wildcard expansion then can specify at most this max number of progeny readsets
+const int32_t cASMaskBlockLoci = 4096;				// allele stacks are identified using bit-sliced founder allele masks over blocks of this many loci, must be a multiple of 64
 
 const int32_t cMaxFilterPBAsScoresNames = 100;		// can only accept at most this number of PBAs names when filtering scores file
 
@@ -80,9 +81,6 @@ const int32_t cDfltMaxUnprunedRefs = 4;				// targeting pruning down to no more
 const size_t cInitialAllocKMerSeqs = 0x01ffffff;	// initially allocate for KMer group sequences in this sized allocation - m_pGrpKMerSeqs
 const size_t cReallocKMerSeqs = 0x0ffffff;			// if needing to extend KMer group sequences then realloc by this - m_pGrpKMerSeqs 
 
-const int cMaxWaitThreadsStartup = 120;				// allowing all threads to initialise and report starting up within this many seconds = m_NumWorkerInsts == m_ExpNumWorkerInsts
-const int cWorkThreadStackSize = 0x01ffff;			// threads created with stacks this size - no recursive functions so an overkill, but who knows, memory is cheap!
-
 const int cMaxBitVectBits = 64*128;					// able to process bit vectors containing at most this many bits, must be a multiple of 64 as bits are packed into 64bit words
 const int cBitVectWords = cMaxBitVectBits/64;		// each bit vector comprises this many 64bit words as an array of words
 
@@ -318,29 +316,14 @@ uint8_t *pMskPBA;				// pts to optional chromosome masking PBA, scoring only for
 } tsCHWorkQueueEl;
 
 typedef struct TAG_sCHWorkerInstance {
-	int ThreadIdx;					// uniquely identifies this thread
+	int ThreadIdx;					// uniquely identifies this worker
 	void *pThis;					// will be initialised to pt to class instance
-#ifdef _WIN32
-	HANDLE threadHandle;			// handle as returned by _beginthreadex()
-	uint32_t threadID;				// identifier as set by _beginthreadex()
-#else
-	int threadRslt;					// result as returned by pthread_create ()
-	pthread_t threadID;				// identifier as set by pthread_create ()
-#endif
 	int Rslt;						// processing result
 } tsCHWorkerInstance;
 
 typedef struct TAG_sCHWorkerLoadChromPBAsInstance {
-	int ThreadIdx;					// uniquely identifies this thread
 	void *pThis;					// will be initialised to pt to class instance
-#ifdef _WIN32
-	HANDLE threadHandle;			// handle as returned by _beginthreadex()
-	uint32_t threadID;				// identifier as set by _beginthreadex()
-#else
-	int threadRslt;					// result as returned by pthread_create ()
-	pthread_t threadID;				// identifier as set by pthread_create ()
-#endif
-	int32_t StartSampleID;         // processing to start from this sample identifer
+	int32_t StartSampleID;         // samples, StartSampleID..EndSampleID inclusive, are submitted as work pool items
 	int32_t EndSampleID;           // ending with this sample identifier inclusive
 	int32_t ChromID;               // loading PBAs for this chromosome
 	bool bNormAlleles;				// true to normalise alleles such that individual alleles can be compared without regard to the proportional coverage (0x22 -> 0x33 as an example)
@@ -348,15 +331,8 @@ typedef struct TAG_sCHWorkerLoadChromPBAsInstance {
 } tsCHWorkerLoadChromPBAsInstance;
 
 typedef struct TAG_sCHWorkerSelfScoreInstance {
-	int ThreadIdx;					// uniquely identifies this thread
+	int ThreadIdx;					// uniquely identifies this worker
 	void* pThis;					// will be initialised to pt to class instance
-#ifdef _WIN32
-	HANDLE threadHandle;			// handle as returned by _beginthreadex()
-	uint32_t threadID;				// identifier as set by _beginthreadex()
-#else
-	int threadRslt;					// result as returned by pthread_create ()
-	pthread_t threadID;				// identifier as set by pthread_create ()
-#endif
 	int32_t NumRefPBAs;				// number of reference PBAs against which row PBAs are to be aligned
 	int32_t NumSrcPBAs;				// number of src PBAs to align against the reference PBAs
 	int32_t ChromID;				// scoring this chromosome
@@ -368,6 +344,11 @@ typedef struct TAG_sCHWorkerSelfScoreInstance {
 	int Rslt;						// processing result
 } tsCHWorkerSelfScoreInstance;
 
+typedef struct TAG_sCHWorkerProgress {
+	class CCallHaplotypes *pThis;	// class instance
+	char *pszChrom;					// workers are processing this chromosome
+} tsCHWorkerProgress;
+
 #pragma pack()
 
 class CCallHaplotypes
@@ -457,6 +438,7 @@ class CCallHaplotypes
 	size_t m_AllocdAlleleStacksMem;				// current mem allocation size for m_pAlleleStacks
 	tsAlleleStack *m_pAlleleStacks;				// allocated to hold founder allele stacks
 	int32_t m_ProccessingHGAllocID;					// most recent allocated bin undergoing processing - processing may be incomplete
+	int32_t m_StartWorkItemIdx;					// work items submitted to the work pool are relative to this work queue element or haplotype grouping bin index
 	int32_t m_UsedHGBinSpecs;					// number of actually used haplotype grouping bins
 	int32_t m_AllocdHGBinSpecs;					// number of allocated haplotype grouping bins
 	size_t m_AllocdHGBinSpecsMem;				// current mem allocation size for m_pHGBinSpecs
@@ -470,7 +452,6 @@ class CCallHaplotypes
 	tsASBin* m_pASBins;					// allocated to hold alelle score bins
 
 
-	int m_CurSelfID;							// currently the highest self PBAs being aligned by any thread 
 
 	uint32_t m_UsedKMerLoci;					// number of actually used KMerLoci
 	uint32_t m_AllocdKMerLoci;					// number of allocated KMerLoci
@@ -545,7 +526,6 @@ class CCallHaplotypes
 #endif
 
 	tsCHWorkerInstance m_WorkerInstances[cMaxPBAWorkerThreads];	// to hold all worker instance thread parameters
-	tsCHWorkerLoadChromPBAsInstance m_WorkerLoadChromPBAInstances[cMaxPBAWorkerThreads];	// to hold all worker instance thread parameters for loading chromosome PBAs
 
 	CBEDfile* m_pBedFile;						// BED file containing reference assembly chromosome names and sizes
 	CUtility m_RegExprs;						// regular expression processing
@@ -574,27 +554,21 @@ class CCallHaplotypes
 
 	int AlignSelfPBAsKMer(int32_t NumRefPBAs, int32_t KMerSize, int32_t ChromID, int32_t ChromLen, int32_t BinsThisChrom, int32_t MaxBinSize, tsCHChromScores* pChromScores, uint8_t* pFndrPBAs[], int MaxThreads);
 
-	// initialise and start pool of worker threads
-	int					// returns < 0 if errors, 0 if all threads have started processing, 1 if all threads started and some have completed processing, 2 if not all have started
-		StartWorkerThreads(int32_t NumThreads,		// there are this many threads in pool
-							int32_t NumChroms);		// processing this number of chromosomes
-
-	int // returns 0 if all threads have started processing, 1 if all threads started and some have completed processing, 2 if not all have started
-		StartWorkerLoadChromPBAThreads(int32_t NumThreads,		// there are this many threads in pool
-										int32_t StartSampleID,	// processing to start from this sample identifer
-										int32_t EndSampleID,	// ending with this sample identifier inclusive
-										int32_t ChromID,		// loading PBAs for this chromosome
-										bool bNormAlleles = false);	// normalise alleles such that individual alleles can be compared for presence without regard to differences in proportional coverage (0x22 -> 0x33 as an example)
-
-	int		// returns 0 if all threads started and completed processing, 1 if all threads started but some yet to complete, 2 if not all threads have started 
-		WaitWorkerThreadStatus(int WaitSecs);			// wait at most this many seconds for all threads to start and complete processing before reporting on worker thread status
-
-	int	// returns number of threads forced to terminate
-		TerminateWorkerThreads(int WaitSecs = 120);	// allow at most this many seconds before force terminating threads
-
-		// stop all threads in worker load chromosome PBAs thread pool
-	int	// returns number of threads forced to terminate
-		TerminateLoadChromPBAsThreads(int WaitSecs); // allow at most this many seconds before force terminating worker pool threads
+	// run NumThreads worker instances on the shared work pool, each dequeues work queue elements or haplotype grouping bins until all have been processed
+	int					// returns < 0 if errors, eBSFSuccess if all workers completed processing
+		RunWorkerThreads(int32_t NumThreads,		// run this many worker instances
+						WorkPoolProgressFunc pProgressFunc,	// called every 60 seconds whilst workers are still processing
+						void *pProgressCtx);		// passed into pProgressFunc
+	static void AlleleStacksProgress(void *pProgressCtx);	// progress whilst generating allele stacks, pProgressCtx pts to a tsCHWorkerProgress
+	static void HapGroupingsProgress(void *pProgressCtx);	// progress whilst generating haplotype groupings, pProgressCtx pts to a tsCHWorkerProgress
+
+	// concurrently load chromosome PBAs, each sample is a work pool item so workers loading smaller PBAs steal samples from those loading larger
+	int		// returns < 0 if errors, eBSFSuccess if all samples were processed
+		LoadChromPBAs(int32_t NumThreads,		// use at most this many work pool threads
+						int32_t StartSampleID,	// processing to start from this sample identifer
+						int32_t EndSampleID,	// ending with this sample identifier inclusive
+						int32_t ChromID,		// loading PBAs for this chromosome
+						bool bNormAlleles = false);	// normalise alleles such that individual alleles can be compared for presence without regard to differences in proportional coverage (0x22 -> 0x33 as an example)
 
 	tsHGBinSpec*								// returned haplotype grouping bin specification, returns nullptr if all bins on chromosome have been iterated
 		IterateHGBinSpecs(int32_t PrevBinID,	// previously iterated bin identifier, to start from 1st bin then pass 0 as the bin identifier 
@@ -1046,11 +1020,14 @@ public:
 			char **ppszExcludeChroms,		// array of exclude chromosome regular expressions
 			int NumThreads);				// number of worker threads to use
 
-	int ProcWorkerThread(tsCHWorkerInstance* pThreadPar);	// worker thread parameters
-	int ProcWorkerLoadChromPBAThread(tsCHWorkerLoadChromPBAsInstance* pThreadPar);	// worker thread parameters
-	int AlignSelfPBAsThread(tsCHWorkerSelfScoreInstance* pPar);	// worker thread parameters
-	// thread for scoring an instance of a source PBAs (termed as Self) against all founder PBAs using KMer size subsequences
-	int AlignSelfPBAsKMerThread(tsCHWorkerSelfScoreInstance* pPar);
+	int ProcWorkItem(tsCHWorkerInstance* pThreadPar,	// worker instance parameters
+					int32_t ItemIdx);		// process this work item, a work queue element or a haplotype grouping bin, relative to m_StartWorkItemIdx
+	int LoadSampleRangeChromPBAs(tsCHWorkerLoadChromPBAsInstance* pPars,	// chromosome and allele normalisation
+								int32_t StartSampleID,	// load PBAs for samples starting from this sample identifier
+								int32_t EndSampleID);	// ending with this sample identifier inclusive
+	int AlignSelfPBAsSrc(tsCHWorkerSelfScoreInstance* pPar,int32_t SrcID);	// score source SrcID (termed as Self) against all founder PBAs
+	// score source SrcID (termed as Self) against all founder PBAs using KMer size subsequences
+	int AlignSelfPBAsKMerSrc(tsCHWorkerSelfScoreInstance* pPar,int32_t SrcID);
 
 };
 
@@ -40,7 +40,8 @@ int Process(int NumIncludeChroms,		// number of retained chromosomes regular exp
 	int NumExcludeChroms,		// number of chromosome expressions to explicitly exclude
 	char **ppszExcludeChroms,	// array of exclude chromosome regular expressions
 	char *pszInFile,			// input file containing alignments to be filtered
-	char *pszOutFile);			// write filtered alignments to this output file)
+	char *pszOutFile,			// write filtered alignments to this output file)
+	int NumThreads);			// BGZF compress/inflate using this many threads
 
 int TrimREQuotes(char *pszTxt);
 
@@ -65,6 +66,8 @@ int Idx;
 int ReLen;
 
 int PMode;				// processing mode
+int NumThreads;			// number of threads (0 defaults to number of CPUs)
+int NumberOfProcessors;	// number of installed CPUs
 int NumIncludeChroms;
 char *pszIncludeChroms[cMaxIncludeChroms];
 int NumExcludeChroms;
@@ -88,6 +91,7 @@ struct arg_str  *excludechroms = arg_strn("Z","chromexclude","<string>",0,cMaxEx
 struct arg_str  *includechroms = arg_strn("z","chromeinclude","<string>",0,cMaxIncludeChroms,"regular expressions defining chromosomes to explicitly include if not already excluded");
 struct arg_file *infile = arg_file1("i","in","<file>",			"input alignments file to be filtered (SAM/BAM) file");
 struct arg_file *outfile = arg_file1("o","output","<file>",		"write accepted alignments to this (SAM/BAM) file");
+struct arg_int *threads = arg_int0("T","threads","<int>",		"number of processing threads 0..128 (defaults to 0 which sets threads to number of CPU cores)");
 struct arg_file *summrslts = arg_file0("q","sumrslts","<file>",		"Output results summary to this SQLite3 database file");
 struct arg_str *experimentname = arg_str0("w","experimentname","<str>",		"experiment name SQLite3 database file");
 struct arg_str *experimentdescr = arg_str0("W","experimentdescr","<str>",	"experiment description SQLite3 database file");
@@ -96,7 +100,7 @@ struct arg_end *end = arg_end(200);
 
 void *argtable[] = {help,version,FileLogLevel,LogFile,
 					summrslts,experimentname,experimentdescr,
-					pmode,excludechroms,includechroms,infile,outfile,
+					pmode,excludechroms,includechroms,infile,outfile,threads,
 					end};
 
 char **pAllArgs;
@@ -234,6 +238,23 @@ if (!argerrors)
 		exit(1);
 		}
 
+#ifdef _WIN32
+	SYSTEM_INFO SystemInfo;
+	GetSystemInfo(&SystemInfo);
+	NumberOfProcessors = SystemInfo.dwNumberOfProcessors;
+#else
+	NumberOfProcessors = sysconf(_SC_NPROCESSORS_CONF);
+#endif
+	int MaxAllowedThreads = min(cMaxWorkerThreads,NumberOfProcessors);	// limit to be at most cMaxWorkerThreads
+	if((NumThreads = threads->count ? threads->ival[0] : MaxAllowedThreads)==0)
+		NumThreads = MaxAllowedThreads;
+	if(NumThreads < 0 || NumThreads > MaxAllowedThreads)
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Number of threads '-T%d' specified was outside of range %d..%d",NumThreads,1,MaxAllowedThreads);
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Defaulting number of threads to %d",MaxAllowedThreads);
+		NumThreads = MaxAllowedThreads;
+		}
+
 	NumIncludeChroms = includechroms->count;
 	for(Idx=0;Idx < includechroms->count; Idx++)
 		{
@@ -283,6 +304,8 @@ if (!argerrors)
 
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Output accepted alignments to file: '%s'",szOutFile);
 
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"number of threads : %d",NumThreads);
+
 	if(szExperimentName[0] != '\0')
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"This processing reference: %s",szExperimentName);
 
@@ -290,7 +313,7 @@ if (!argerrors)
 	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
 #endif
 	gStopWatch.Start();
-	Rslt = Process(NumIncludeChroms,pszIncludeChroms,NumExcludeChroms,pszExcludeChroms,szInFile,szOutFile);
+	Rslt = Process(NumIncludeChroms,pszIncludeChroms,NumExcludeChroms,pszExcludeChroms,szInFile,szOutFile,NumThreads);
 	Rslt = Rslt >=0 ? 0 : 1;
 	if(gExperimentID > 0)
 		{
@@ -335,10 +358,11 @@ int Process(int NumIncludeChroms,		// number of retained chromosomes regular exp
 	int NumExcludeChroms,				// number of chromosome expressions to explicitly exclude
 	char **ppszExcludeChroms,			// array of exclude chromosome regular expressions
 	char *pszInFile,					// input file containing alignments to be filtered
-	char *pszOutFile)					// write filtered alignments to this output file
+	char *pszOutFile,					// write filtered alignments to this output file
+	int NumThreads)						// BGZF compress/inflate using this many threads
 {
 CFilterSAMAlignments FilterSAMAlignments;
-return(FilterSAMAlignments.FilterSAMbyChrom(NumIncludeChroms,ppszIncludeChroms,NumExcludeChroms,ppszExcludeChroms,pszInFile,pszOutFile));
+return(FilterSAMAlignments.FilterSAMbyChrom(NumIncludeChroms,ppszIncludeChroms,NumExcludeChroms,ppszExcludeChroms,pszInFile,pszOutFile,NumThreads));
 }
 
 CFilterSAMAlignments::CFilterSAMAlignments()
@@ -443,7 +467,8 @@ CFilterSAMAlignments::FilterSAMbyChrom(int NumIncludeChroms,		// number of retai
 	int NumExcludeChroms,		// number of chromosome expressions to explicitly exclude
 	char **ppszExcludeChroms,	// array of exclude chromosome regular expressions
 	char *pszInFile,			// input file containing alignments to be filtered
-	char *pszOutFile)			// write filtered alignments to this output file
+	char *pszOutFile,			// write filtered alignments to this output file
+	int NumThreads)				// BGZF compress/inflate using this many threads
 {
 teBSFrsltCodes Rslt;
 
@@ -499,7 +524,7 @@ if((m_pInBAMfile = new CSAMfile) == nullptr)
 	return(eBSFerrInternal);
 	}
 
-if((Rslt = (teBSFrsltCodes)m_pInBAMfile->Open(pszInFile)) != eBSFSuccess)
+if((Rslt = (teBSFrsltCodes)m_pInBAMfile->Open(pszInFile,NumThreads)) != eBSFSuccess)
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"RemapSAMLocii: Unable to open SAM/BAM format file %s",pszInFile);
 	delete m_pInBAMfile;
@@ -532,7 +557,7 @@ switch(SAMFormat) {
 		break;
 	}
 
-if((Rslt = (teBSFrsltCodes)m_pOutBAMfile->Create(FileType,pszOutFile,6,(char *)kit4bversion)) < eBSFSuccess) // defaulting to compression level 6 if compressed BAM 
+if((Rslt = (teBSFrsltCodes)m_pOutBAMfile->Create(FileType,pszOutFile,6,(char *)kit4bversion,NumThreads)) < eBSFSuccess) // defaulting to compression level 6 if compressed BAM 
 	{
 	delete m_pInBAMfile;
 	m_pInBAMfile = nullptr;
@@ -65,6 +65,7 @@ public:
 		int NumExcludeChroms,		// number of chromosome expressions to explicitly exclude
 		char **ppszExcludeChroms,	// array of exclude chromosome regular expressions
 		char *pszInFile,			// input file containing alignments to be filtered
-		char *pszOutFile);			// write filtered alignments to this output file
+		char *pszOutFile,			// write filtered alignments to this output file
+		int NumThreads = 1);		// BGZF compress/inflate using this many threads
 };
 
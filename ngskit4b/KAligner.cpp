@@ -120,6 +120,7 @@ CKAligner::Align(etPMode PMode,			// processing mode
 		teSAMFormat SAMFormat,			// if SAM output format then could be SAM or BAM compressed dependent on the file extension used
 		int SitePrefsOfs,				// offset read start sites when processing  octamer preferencing, range -100..100
 		int NumThreads,					// number of worker threads to use
+		int StreamMemMB,				// if > 0 then streaming alignment with loaded reads bounded by this memory budget (MB)
 		char *pszTrackTitle,			// track title if output format is UCSC BED
 		int NumPE1InputFiles,			// number of input PE1 or single ended file specs
 		char *pszPE1InputFiles[],		// names of input files (wildcards allowed unless processing paired ends) containing raw reads
@@ -149,6 +150,7 @@ int BuffOfs = 0;
 int SeqIdx = 0;
 char szPEInsertDistFile[_MAX_PATH];
 char szOutBAIFile[_MAX_PATH];
+CRunPhase Phase;						// run profile phases
 Init(); 
 
 m_bPackedBaseAlleles = (FMode == eFMPBA) ? true : false;
@@ -272,6 +274,44 @@ m_SitePrefsOfs = SitePrefsOfs;			// offset read start sites when processing  oct
 
 m_MaxRptSAMSeqsThres = MaxRptSAMSeqsThres;
 
+// streaming alignment is only supported when alignments are reported as SAM/BAM and no processing phases require all reads to be concurrently in memory
+// SNP and marker calling, alignment stats and site preferences are accumulated over sequential passes through the merged locus ordered runs so are supported,
+// but phases which require random access to reads overlapping a loci, or iteration in an order other than locus order, are not (experimental DiSNPs and TriSNPs are not generated)
+// user must explicitly choose between streaming and these processing phases, streaming is never silently disabled
+if(StreamMemMB > 0)
+	{
+	const char *pszNoStream = nullptr;
+	if(!(FMode == eFMsam || FMode == eFMsamAll))
+		pszNoStream = "non-SAM/BAM output format";
+	if(MLMode > eMLrand)
+		pszNoStream = "multiloci processing other than random";
+	if(PCRartefactWinLen >= 0)
+		pszNoStream = "PCR artefact reduction";
+	if(SpliceJunctLen > 0)
+		pszNoStream = "splice junction processing";
+	if(microInDelLen > 0)
+		pszNoStream = "microInDel processing";
+	if(m_bReportChimerics)
+		pszNoStream = "chimeric reporting";
+	if(MinSNPreads > 0 && m_bXCSVFrameShifts)
+		pszNoStream = "extended SNP CSV codon frame shifts";
+	if(bPEInsertLenDist)
+		pszNoStream = "per sequence PE insert length distributions";
+	if(pszNoStream != nullptr)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Streaming alignment (--streammem) can not be combined with %s as all reads would be required to be concurrently in memory",pszNoStream);
+		Reset(false);
+		return(eBSFerrParams);
+		}
+	else
+		{
+		m_bStreamReads = true;
+		m_StreamMemBudget = (size_t)StreamMemMB * 0x0100000;
+		m_StreamChunkMem = (m_StreamMemBudget / 8) * 7;
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Streaming alignment with reads loaded and aligned in chunks of at most %zdMB",m_StreamChunkMem / 0x0100000);
+		}
+	}
+
 if(CreateMutexes()!=eBSFSuccess)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Failed to create thread synchronisation mutexes");
@@ -280,6 +320,7 @@ if(CreateMutexes()!=eBSFSuccess)
 	}
 
 m_mtqsort.SetMaxThreads(NumThreads);
+m_MTRadixSort.SetMaxThreads(NumThreads);
 
 // load contaminants if user has specified a contaminant sequence file
 if(pszContamFile != nullptr && pszContamFile[0] != '\0')
@@ -332,6 +373,7 @@ if(pszPriorityRegionFile != nullptr && pszPriorityRegionFile[0] != '\0')
 
 
 // open bioseq file containing suffix array for targeted assembly to align reads against
+Phase.Begin("load_index");
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Loading suffix array file '%s'", pszSfxFile);
 if((m_pSfxArray = new CSfxArray()) == nullptr)
 	{
@@ -497,17 +539,155 @@ if((Rslt=CreateOrTruncResultFiles())!=eBSFSuccess)
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Creating/truncating result files completed");
 m_CurReadsSortMode = eRSMReadID;			// reads were loaded and assigned ascending read identifiers so that is their initial sort order
 
-// locate all read matches
-gDiagnostics.DiagOut(eDLInfo,gszProcName,"Aligning in %s...",bSOLiD ? "colorspace" : "basespace");
-gDiagnostics.DiagOut(eDLInfo,gszProcName,"Aligning for %s cored matches...",bBisulfite ? "bisulfite" : "normal");
+// locate all read matches, when streaming then reads are aligned in chunks and subsequent reporting iterates over the merged chunks
+Phase.Begin("align");
+if(m_bStreamReads)
+	Rslt = StreamAlignReads(MinEditDist,PCRPrimerCorrect,MinFlankExacts,NumIncludeChroms,NumExcludeChroms);
+else
+	Rslt = ProcessLoadedReads(MinEditDist,PCRartefactWinLen,PCRPrimerCorrect,MinFlankExacts,NumIncludeChroms,NumExcludeChroms);
+if(Rslt < eBSFSuccess)
+	{
+	Reset(false);
+	return(Rslt);
+	}
 
-Rslt = LocateCoredApprox(MinEditDist,m_InitalAlignSubs);
+// user interested in the nonaligned?
+Phase.Begin("report");
+if(m_hNoneAlignFile != -1 || m_gzNoneAlignFile != nullptr)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of non-aligned reads started..");
+	if((Rslt=ReportNoneAligned())<eBSFSuccess)
+		{
+		Reset(false);
+		return(Rslt);
+		}
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of non-aligned reads completed");
+	}
 
-if(Rslt < eBSFSuccess)
+// user interested in the multialigned?
+// these only include those reads which would otherwise have been accepted but aligned to multiple loci
+if(m_hMultiAlignFile != -1 || m_gzMultiAlignFile != nullptr)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of multialigned reads started..");
+	if((Rslt=ReportMultiAlign()) < eBSFSuccess)
+		{
+		Reset(false);
+		return(Rslt);
+		}
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of multialigned reads completed");
+	}
+
+// all processing to accept alignments completed, can now report basic stats
+if((Rslt=ReportAlignStats()) < eBSFSuccess)
 	{
 	Reset(false);
 	return(Rslt);
 	}
+
+Rslt = eBSFSuccess;
+if(!m_bPackedBaseAlleles)
+	{
+	if(m_NARAccepted && m_hSitePrefsFile != -1)
+		ProcessSiteProbabilites(m_SitePrefsOfs);
+
+	// now time to write out the read hits
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of aligned result set started...");
+	if(FMode >= eFMsam)
+		{
+		if(m_hJctOutFile != -1 || m_hIndOutFile != -1)	// even though SAM for read alignments, splice and indels are reported as BED format
+			{
+			Rslt = WriteReadHits(PEproc == ePEdefault ? false : true);
+			if(Rslt < eBSFSuccess)
+				{
+				Reset(false);
+				return(Rslt);
+				}
+			}
+		Rslt = WriteBAMReadHits(FMode,SAMFormat,PEproc == ePEdefault ? false : true,6);	// default to compression level 6
+		}
+	else
+		Rslt = WriteReadHits(PEproc == ePEdefault ? false : true);
+
+	if(Rslt >= eBSFSuccess && m_bStreamMerge && m_StreamMergeRslt < eBSFSuccess)	// errors whilst merging spilled runs
+		Rslt = m_StreamMergeRslt;
+	if(Rslt < eBSFSuccess)
+		{
+		Reset(false);
+		return(Rslt);
+		}
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of aligned result set completed");
+
+	if(m_bPEInsertLenDist && m_NARAccepted)
+		ReportPEInsertLenDist();
+
+	if(Rslt >= eBSFSuccess && m_NARAccepted && m_hStatsFile > 0 && m_MaxAlignLen > 0)
+		Rslt = WriteBasicCountStats();
+
+	if(Rslt >= eBSFSuccess && m_NARAccepted && m_hStatsFile > 0 && m_MaxAlignLen > 0)
+		Rslt = ReportTargHitCnts();
+
+	if(Rslt >= eBSFSuccess  && m_NARAccepted && m_hSitePrefsFile > 0)
+		Rslt = WriteSitePrefs();
+
+	m_TotNumSNPs = 0;
+	if(Rslt >= eBSFSuccess && m_NARAccepted && MinSNPreads > 0 && m_hSNPfile != -1)
+		{
+		bool bMarkers;
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processing for SNPs and writing out SNPs to file '%s",m_pszSNPRsltsFile);
+		if(m_hMarkerFile != -1)
+			{
+			gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processing for Markers and writing out marker sequences to file '%s",m_pszMarkerFile);
+			bMarkers = true;
+			}
+		else
+			bMarkers = false;
+		Phase.Begin("snps");
+		Rslt = ProcessSNPs();			// track title if output format is to be UCSC BED, will have '_SNPs' appended
+		if(Rslt >= eBSFSuccess)
+			{
+			if(bMarkers)
+				gDiagnostics.DiagOut(eDLInfo,gszProcName,"Marker processing completed with %d marker sequences writtten to file '%s",m_MarkerID,m_pszMarkerFile);
+			gDiagnostics.DiagOut(eDLInfo,gszProcName,"SNP processing completed with %d putative SNPs discovered",m_TotNumSNPs);
+			gDiagnostics.DiagOut(eDLInfo,gszProcName,"There are %zd aligned loci bases which are covered by %zd read bases with mean coverage of %1.2f",m_LociBasesCovered,m_LociBasesCoverage,m_LociBasesCoverage/(double)m_LociBasesCovered);
+			}
+		}
+
+	if(gProcessingID != 0)
+		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"SNPs",ePTInt32,sizeof(m_TotNumSNPs),"Cnt",&m_TotNumSNPs);
+	}
+else
+	{
+	Phase.Begin("gen_pba");
+	Rslt = ProcessSNPs();
+	}
+Phase.End();
+Reset(Rslt >= eBSFSuccess ? true : false);
+return(Rslt);
+}
+
+// ProcessLoadedReads
+// Aligns all loaded reads then applies the post-alignment processing phases (PE association, constraints, PCR primer correction, flank trimming and filtering)
+// When streaming then called once for each chunk of loaded reads
+int
+CKAligner::ProcessLoadedReads(int MinEditDist,	// any matches must have at least this edit distance to the next best match
+				int PCRartefactWinLen,		// if >= 0 then window size to use when attempting to reduce the number of  PCR differential amplification artefacts
+				int PCRPrimerCorrect,		// correct substitutions in 5' 12bp until overall sub rate within MaxSubs
+				int MinFlankExacts,			// trim matched reads on 5' and 3' flanks until at least this number of exactly matching bases in flanks
+				int NumIncludeChroms,		// number of chromosome regular expressions to include
+				int NumExcludeChroms)		// number of chromosome expressions to exclude
+{
+int Rslt;
+CRunPhase Phase("align_cores");			// run profile phases, nested within the alignment phase
+
+// locate all read matches
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Aligning in %s...",m_bIsSOLiD ? "colorspace" : "basespace");
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Aligning for %s cored matches...",m_bBisulfite ? "bisulfite" : "normal");
+
+Rslt = LocateCoredApprox(MinEditDist,m_InitalAlignSubs);
+Phase.End();
+
+if(Rslt < eBSFSuccess)
+	return(Rslt);
 	
 if(m_bReportChimerics)
 	{
@@ -518,11 +698,13 @@ if(m_bReportChimerics)
 	}
 
 // if autodetermining max subs that were allowed from actual reads then let user know what the average read length was
-size_t TotReadsLen = 0;
+// when streaming then read lengths are accumulated over all chunks and only reported after the final chunk has been aligned
+bool bFinalChunk = !m_bStreamReads || !m_bStreamChunkLoaded;
+size_t TotReadsLen = m_StreamTotReadsLen;
 tsReadHit *pReadHit;
 int AvReadsLen;
-int MinReadsLen = -1;
-int MaxReadsLen = 0;
+int MinReadsLen = m_StreamBaseReads > 0 ? m_MinReadsLen : -1;
+int MaxReadsLen = m_StreamBaseReads > 0 ? m_MaxReadsLen : 0;
 pReadHit = m_pReadHits;
 for(uint32_t RIdx = 0; RIdx < m_NumReadsLoaded; RIdx++)
 	{
@@ -533,42 +715,51 @@ for(uint32_t RIdx = 0; RIdx < m_NumReadsLoaded; RIdx++)
 		MaxReadsLen = pReadHit->ReadLen;
 	pReadHit = (tsReadHit *)((uint8_t *)pReadHit + sizeof(tsReadHit) + pReadHit->ReadLen + pReadHit->DescrLen);
 	}
-AvReadsLen = (int)(TotReadsLen/m_NumReadsLoaded);
-gDiagnostics.DiagOut(eDLInfo,gszProcName,"Average length of all reads was: %d (min: %d, max: %d)",AvReadsLen,MinReadsLen,MaxReadsLen);
+m_StreamTotReadsLen = TotReadsLen;
+AvReadsLen = (int)(TotReadsLen/max((uint32_t)1,m_StreamBaseReads + m_NumReadsLoaded));
 m_MaxReadsLen = MaxReadsLen;
 m_MinReadsLen = MinReadsLen;
 m_AvReadsLen = AvReadsLen;
-if(gProcessingID > 0)
-	{
-	gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"ReadLen",ePTInt32,sizeof(AvReadsLen),"MeanLen",&AvReadsLen);
-	gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"ReadLen",ePTInt32,sizeof(MinReadsLen),"MinLen",&MinReadsLen);
-	gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"ReadLen",ePTInt32,sizeof(MaxReadsLen),"MaxLen",&MaxReadsLen);
-	}
-
-if(m_InitalAlignSubs != 0)
+if(bFinalChunk)
 	{
-	int MeanSubs;
-	int MinSubs;
-	int MaxSubs;
-	MeanSubs = max(1,(AvReadsLen * m_InitalAlignSubs)/100);
-	MinSubs = max(1,(MinReadsLen * m_InitalAlignSubs)/100);
-	MaxSubs = max(1,(MaxReadsLen * m_InitalAlignSubs)/100);
-
-	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Typical allowed aligner induced substitutions was: %d (min: %d, max: %d)", MeanSubs, MinSubs, MaxSubs);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Average length of all reads was: %d (min: %d, max: %d)",AvReadsLen,MinReadsLen,MaxReadsLen);
 	if(gProcessingID > 0)
 		{
-		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"AllowedSubs",ePTInt32,sizeof(MeanSubs),"MeanSubs",&MeanSubs);
-		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"AllowedSubs",ePTInt32,sizeof(MinSubs),"MinSubs",&MinSubs);
-		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"AllowedSubs",ePTInt32,sizeof(MaxSubs),"MaxSubs",&MaxSubs);
+		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"ReadLen",ePTInt32,sizeof(AvReadsLen),"MeanLen",&AvReadsLen);
+		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"ReadLen",ePTInt32,sizeof(MinReadsLen),"MinLen",&MinReadsLen);
+		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"ReadLen",ePTInt32,sizeof(MaxReadsLen),"MaxLen",&MaxReadsLen);
 		}
-	}
-else
-	if(gProcessingID > 0)
-		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"AllowedSubs",ePTInt32,sizeof(MaxSubs),"MeanSubs",&m_InitalAlignSubs);
+
+	if(m_InitalAlignSubs != 0)
+		{
+		int MeanSubs;
+		int MinSubs;
+		int MaxSubs;
+		MeanSubs = max(1,(AvReadsLen * m_InitalAlignSubs)/100);
+		MinSubs = max(1,(MinReadsLen * m_InitalAlignSubs)/100);
+		MaxSubs = max(1,(MaxReadsLen * m_InitalAlignSubs)/100);
+
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Typical allowed aligner induced substitutions was: %d (min: %d, max: %d)", MeanSubs, MinSubs, MaxSubs);
+		if(gProcessingID > 0)
+			{
+			gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"AllowedSubs",ePTInt32,sizeof(MeanSubs),"MeanSubs",&MeanSubs);
+			gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"AllowedSubs",ePTInt32,sizeof(MinSubs),"MinSubs",&MinSubs);
+			gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"AllowedSubs",ePTInt32,sizeof(MaxSubs),"MaxSubs",&MaxSubs);
+			}
+		}
+	else
+		if(gProcessingID > 0)
+			gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"AllowedSubs",ePTInt32,sizeof(m_InitalAlignSubs),"MeanSubs",&m_InitalAlignSubs);
  
-gDiagnostics.DiagOut(eDLInfo,gszProcName,"Provisionally accepted %d aligned reads (%d uniquely, %d aligning to multiloci) aligning to a total of %d loci", m_TotAcceptedAsAligned,m_TotAcceptedAsUniqueAligned,m_TotAcceptedAsMultiAligned,m_TotLociAligned);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Provisionally accepted %d aligned reads (%d uniquely, %d aligning to multiloci) aligning to a total of %d loci", m_TotAcceptedAsAligned,m_TotAcceptedAsUniqueAligned,m_TotAcceptedAsMultiAligned,m_TotLociAligned);
+	}
 
-m_OrigNumReadsLoaded = m_NumReadsLoaded;		// make a copy of actual number of reads loaded as if m_MLMode >= eMLall then will be overwritten with number of multialigned loci 
+if(m_bStreamReads && m_NumReadsLoaded == 0)	// final chunk when streaming may not contain any reads
+	{
+	m_OrigNumReadsLoaded = m_StreamBaseReads;
+	return(eBSFSuccess);
+	}
+m_OrigNumReadsLoaded = m_StreamBaseReads + m_NumReadsLoaded;		// make a copy of actual number of reads loaded as if m_MLMode >= eMLall then will be overwritten with number of multialigned loci 
 if(m_MLMode >= eMLall)		// a little involved as need to reuse m_pReadHits ptrs so sorting and reporting of multi-SAM hits will be same as if normal processing...
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Treating accepted %d multialigned reads as uniquely aligned %d source reads in subsequent processing",m_TotAcceptedAsMultiAligned,m_TotLociAligned - m_TotAcceptedAsUniqueAligned);
@@ -586,6 +777,7 @@ if(m_MLMode >= eMLall)		// a little involved as need to reuse m_pReadHits ptrs s
 	m_pMultiAll = nullptr;
 	m_AllocdReadHitsMem = m_AllocMultiAllMem;
 	m_UsedReadHitsMem = m_NxtMultiAllOfs;
+	m_LoadedReadsOfs = m_NxtMultiAllOfs;
 	m_NumReadsLoaded = m_NumMultiAll;
 	m_FinalReadID = m_NumMultiAll;
 	m_AllocMultiAllMem = 0;
@@ -601,41 +793,35 @@ if(m_MLMode >= eMLall)		// a little involved as need to reuse m_pReadHits ptrs s
 	}
 
 // if PE processing then try assign partners within insert size constraints
-if(PEproc != ePEdefault)
+if(m_PEproc != ePEdefault)
 	{
+	Phase.Begin("paired_ends");
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Paired end association and partner alignment processing started..");
-	if((Rslt=ProcessPairedEnds(PEproc,MinEditDist,PairMinLen,PairMaxLen,bPairStrand,m_InitalAlignSubs)) < eBSFSuccess)
-		{
-		Reset(false);
+	if((Rslt=ProcessPairedEnds(m_PEproc,MinEditDist,m_PairMinLen,m_PairMaxLen,m_bPairStrand,m_InitalAlignSubs)) < eBSFSuccess)
 		return(Rslt);
-		}
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Paired end association and partner alignment processing completed..");
 	}
 
 // try and assign multimatch read loci?
 // only applies if SE processing and non-random assignment of a single multiloci loci
-if(PEproc == ePEdefault && m_MLMode > eMLrand && m_MLMode != eMLall)
+if(m_PEproc == ePEdefault && m_MLMode > eMLrand && m_MLMode != eMLall)
 	{
+	Phase.Begin("multialign");
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Multialignment processing started..");
 	if((Rslt = AssignMultiMatches()) < eBSFSuccess)
-		{
-		Reset(false);
 		return(Rslt);
-		}
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Multialignment processing completed");
 	}
 
-IdentifyConstraintViolations(PEproc != ePEdefault);
+Phase.Begin("post_align");
+IdentifyConstraintViolations(m_PEproc != ePEdefault);
 
 // if requested then attempt to reduce the number of  PCR differential amplification artefacts (reads stacking to same loci)
-if(PEproc == ePEdefault && PCRartefactWinLen >= 0)
+if(m_PEproc == ePEdefault && PCRartefactWinLen >= 0)
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processing to reduce PCR differential amplification artefacts processing started..");
 	if((Rslt=ReducePCRduplicates(PCRartefactWinLen)) < eBSFSuccess)
-		{
-		Reset(false);
 		return(Rslt);
-		}
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"PCR differential amplification artefacts processing completed");
 	}
 
@@ -643,10 +829,7 @@ if(PCRPrimerCorrect > 0)
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"PCR 5' Primer correction processing started..");
 	if((Rslt=PCR5PrimerCorrect(m_MaxSubs)) < eBSFSuccess)
-		{
-		Reset(false);
 		return(Rslt);
-		}
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"PCR 5' Primer correction processing completed");
 	}
 
@@ -654,193 +837,73 @@ if(MinFlankExacts > 0) // autotrim aligned reads flanks?
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Autotrim aligned read flank processing started..");
 	if((Rslt=AutoTrimFlanks(MinFlankExacts)) < eBSFSuccess)
-		{
-		Reset(false);
 		return(Rslt);
-		}
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Autotrim aligned read flank processing completed");
 	}
 
 // if splice junctions being processed then check for orphans and remove these
-if(PEproc == ePEdefault && SpliceJunctLen > 0)
+if(m_PEproc == ePEdefault && m_SpliceJunctLen > 0)
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Removal of orphan splice junction processing started..");
-	if((Rslt=RemoveOrphanSpliceJuncts(SpliceJunctLen)) < eBSFSuccess)
-		{
-		Reset(false);
+	if((Rslt=RemoveOrphanSpliceJuncts(m_SpliceJunctLen)) < eBSFSuccess)
 		return(Rslt);
-		}
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Removal of orphan splice junction processing completed");
 	}
 
 // if processing for microInDels then need to check for orphans and remove these
-if(PEproc == ePEdefault && microInDelLen > 0)
+if(m_PEproc == ePEdefault && m_microInDelLen > 0)
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Removal of orphan microInDels processing started..");
-	if((Rslt=RemoveOrphanMicroInDels(microInDelLen)) < eBSFSuccess)
-		{
-		Reset(false);
+	if((Rslt=RemoveOrphanMicroInDels(m_microInDelLen)) < eBSFSuccess)
 		return(Rslt);
-		}
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Removal of orphan microInDels processing completed");
 	}
 
-BuffLen = 0;
-BuffOfs = 0;
-SeqIdx;
-
 // now apply any chromosome filtering that user has specified
 if(NumExcludeChroms || NumIncludeChroms)
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Filtering aligned reads by chromosome started..");
 	if((Rslt=FiltByChroms())<eBSFSuccess)
-		{
-		Reset(false);
 		return(Rslt);
-		}
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Filtering aligned reads by chromosome completed");
 	}
 
 // apply priority region filtering if requested
 if(m_pPriorityRegionBED != nullptr && m_bFiltPriorityRegions)
 	FiltByPriorityRegions();
+return(eBSFSuccess);
+}
 
-// user interested in the nonaligned?
-if(m_hNoneAlignFile != -1 || m_gzNoneAlignFile != nullptr)
-	{
-	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of non-aligned reads started..");
-	if((Rslt=ReportNoneAligned())<eBSFSuccess)
-		{
-		Reset(false);
-		return(Rslt);
-		}
-	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of non-aligned reads completed");
-	}
-
-// user interested in the multialigned?
-// these only include those reads which would otherwise have been accepted but aligned to multiple loci
-if(m_hMultiAlignFile != -1 || m_gzMultiAlignFile != nullptr)
-	{
-	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of multialigned reads started..");
-	if((Rslt=ReportMultiAlign()) < eBSFSuccess)
-		{
-		Reset(false);
-		return(Rslt);
-		}
-	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of multialigned reads completed");
-	}
+void
+CKAligner::Init(void)
+{
+m_hInFile = -1;
+m_hOutFile = -1;
 
-// all processing to accept alignments completed, can now report basic stats
-if((Rslt=ReportAlignStats()) < eBSFSuccess)
-	{
-	Reset(false);
-	return(Rslt);
-	}
+m_hBAIFile = -1;
 
-Rslt = eBSFSuccess;
-if(!m_bPackedBaseAlleles)
-	{
-	if(m_NARAccepted && m_hSitePrefsFile != -1)
-		ProcessSiteProbabilites(m_SitePrefsOfs);
-
-	// now time to write out the read hits
-	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of aligned result set started...");
-	if(FMode >= eFMsam)
-		{
-		if(m_hJctOutFile != -1 || m_hIndOutFile != -1)	// even though SAM for read alignments, splice and indels are reported as BED format
-			{
-			Rslt = WriteReadHits(PEproc == ePEdefault ? false : true);
-			if(Rslt < eBSFSuccess)
-				{
-				Reset(false);
-				return(Rslt);
-				}
-			}
-		Rslt = WriteBAMReadHits(FMode,SAMFormat,PEproc == ePEdefault ? false : true,6);	// default to compression level 6
-		}
-	else
-		Rslt = WriteReadHits(PEproc == ePEdefault ? false : true);
-
-	if(Rslt < eBSFSuccess)
-		{
-		Reset(false);
-		return(Rslt);
-		}
-	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Reporting of aligned result set completed");
-
-	if(m_bPEInsertLenDist && m_NARAccepted)
-		ReportPEInsertLenDist();
-
-	if(Rslt >= eBSFSuccess && m_NARAccepted && m_hStatsFile > 0 && m_MaxAlignLen > 0)
-		Rslt = WriteBasicCountStats();
-
-	if(Rslt >= eBSFSuccess && m_NARAccepted && m_hStatsFile > 0 && m_MaxAlignLen > 0)
-		Rslt = ReportTargHitCnts();
-
-	if(Rslt >= eBSFSuccess  && m_NARAccepted && m_hSitePrefsFile > 0)
-		Rslt = WriteSitePrefs();
-
-	m_TotNumSNPs = 0;
-	if(Rslt >= eBSFSuccess && m_NARAccepted && MinSNPreads > 0 && m_hSNPfile != -1)
-		{
-		bool bMarkers;
-		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processing for SNPs and writing out SNPs to file '%s",m_pszSNPRsltsFile);
-		if(m_hMarkerFile != -1)
-			{
-			gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processing for Markers and writing out marker sequences to file '%s",m_pszMarkerFile);
-			bMarkers = true;
-			}
-		else
-			bMarkers = false;
-		Rslt = ProcessSNPs();			// track title if output format is to be UCSC BED, will have '_SNPs' appended
-		if(Rslt >= eBSFSuccess)
-			{
-			if(bMarkers)
-				gDiagnostics.DiagOut(eDLInfo,gszProcName,"Marker processing completed with %d marker sequences writtten to file '%s",m_MarkerID,m_pszMarkerFile);
-			gDiagnostics.DiagOut(eDLInfo,gszProcName,"SNP processing completed with %d putative SNPs discovered",m_TotNumSNPs);
-			gDiagnostics.DiagOut(eDLInfo,gszProcName,"There are %zd aligned loci bases which are covered by %zd read bases with mean coverage of %1.2f",m_LociBasesCovered,m_LociBasesCoverage,m_LociBasesCoverage/(double)m_LociBasesCovered);
-			}
-		}
-
-	if(gProcessingID != 0)
-		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"SNPs",ePTInt32,sizeof(AvReadsLen),"Cnt",&m_TotNumSNPs);
-	}
-else
-	Rslt = ProcessSNPs();
-Reset(Rslt >= eBSFSuccess ? true : false);
-return(Rslt);
-}
-
-void
-CKAligner::Init(void)
-{
-m_hInFile = -1;
-m_hOutFile = -1;
-
-m_hBAIFile = -1;
-
-m_hIndOutFile = -1;
-m_hJctOutFile = -1;
-m_hStatsFile = -1;
-m_hInsertLensFile = -1;
-m_hSitePrefsFile = -1;
-m_hNoneAlignFile = -1;
-m_hMultiAlignFile = -1;
-m_hSNPfile = -1;
-m_hDiSNPfile = -1;
-m_hTriSNPfile = -1;
-m_hMarkerFile = -1;	
-m_hSNPCentsfile = -1;
-m_hWIGSpansFile = -1;
-m_hPackedBaseAllelesFile = -1;
-m_bPackedBaseAlleles = false;
-m_gzOutFile = nullptr;
-m_gzIndOutFile = nullptr;
-m_gzJctOutFile = nullptr;
-m_gzNoneAlignFile = nullptr;
-m_gzMultiAlignFile = nullptr;
-m_gzSNPfile = nullptr;
-m_gzSNPCentsfile = nullptr;
+m_hIndOutFile = -1;
+m_hJctOutFile = -1;
+m_hStatsFile = -1;
+m_hInsertLensFile = -1;
+m_hSitePrefsFile = -1;
+m_hNoneAlignFile = -1;
+m_hMultiAlignFile = -1;
+m_hSNPfile = -1;
+m_hDiSNPfile = -1;
+m_hTriSNPfile = -1;
+m_hMarkerFile = -1;	
+m_hSNPCentsfile = -1;
+m_hWIGSpansFile = -1;
+m_pPBAFile = nullptr;
+m_bPackedBaseAlleles = false;
+m_gzOutFile = nullptr;
+m_gzIndOutFile = nullptr;
+m_gzJctOutFile = nullptr;
+m_gzNoneAlignFile = nullptr;
+m_gzMultiAlignFile = nullptr;
+m_gzSNPfile = nullptr;
+m_gzSNPCentsfile = nullptr;
 
 m_bgzOutFile = false;
 m_bgzNoneAlignFile = false;
@@ -888,6 +951,7 @@ m_PerThreadAllocdIdentNodes = 0;
 m_AllocdReadHitsMem = 0;
 m_UsedReadHitsMem = 0;
 m_NumReadsLoaded = 0;
+m_LoadedReadsOfs = 0;
 m_UsedReadHitsMem = 0;
 m_FinalReadID = 0;
 m_NumDescrReads = 0;
@@ -954,6 +1018,31 @@ m_ThreadCoredApproxRslt = 0;
 m_bXCSVFrameShifts = false;
 m_AllocPackedBaseAllelesMem = 0;
 m_NumPackedBaseAlleles = 0;
+m_bStreamReads = false;
+m_bStreamChunkLoaded = false;
+m_bStreamMerge = false;
+m_StreamMergeRslt = eBSFSuccess;
+m_StreamMemBudget = 0;
+m_StreamChunkMem = 0;
+m_StreamBaseReads = 0;
+m_StreamTotReadsLen = 0;
+m_szStreamSpillFile[0] = '\0';
+m_hStreamSpillFile = -1;
+m_StreamSpillOfs = 0;
+m_pStreamSpillBuff = nullptr;
+m_StreamSpillBuffIdx = 0;
+m_StreamMaxRecLen = 0;
+m_NumStreamRuns = 0;
+m_AllocdStreamRuns = 0;
+m_pStreamRuns = nullptr;
+m_StreamRunBuffSize = 0;
+m_StreamHeapLen = 0;
+m_pStreamHeap = nullptr;
+m_pStreamSlots[0] = nullptr;
+m_pStreamSlots[1] = nullptr;
+m_StreamSlot = 0;
+m_pStreamPrevCur = nullptr;
+m_pStreamPrevNxt = nullptr;
 
 #ifdef _WIN32
 m_hThreadLoadReads = nullptr;
@@ -1128,16 +1217,11 @@ if(m_hWIGSpansFile != -1)
 	m_hWIGSpansFile = -1;
 	}
 
-if(m_hPackedBaseAllelesFile != -1)
+if(m_pPBAFile != nullptr)
 	{
-	if(bSync)
-#ifdef _WIN32
-		_commit(m_hPackedBaseAllelesFile);
-#else
-		fsync(m_hPackedBaseAllelesFile);
-#endif
-	close(m_hPackedBaseAllelesFile);
-	m_hPackedBaseAllelesFile = -1;
+	m_pPBAFile->CloseCreate(bSync);			// chromosome directory is written for those chromosomes already written
+	delete m_pPBAFile;
+	m_pPBAFile = nullptr;
 	}
 
 if(m_hMarkerFile != -1)
@@ -1263,6 +1347,8 @@ if(m_pReadHits != nullptr)
 	m_pReadHits = nullptr;
 	}
 
+ResetStream();
+
 if(m_pMultiAll != nullptr)
 	{
 #ifdef _WIN32
@@ -1728,8 +1814,11 @@ if((Rslt=SortReadHits(eRSMHitMatch,false)) < eBSFSuccess)
 	return(Rslt);
 	}
 
-m_ElimPlusTrimed = 0;
-m_ElimMinusTrimed = 0;
+if(m_StreamBaseReads == 0)	// when streaming then counts accumulate over all chunks
+	{
+	m_ElimPlusTrimed = 0;
+	m_ElimMinusTrimed = 0;
+	}
 if(MinFlankExacts > 0)	// do  3' and 5' autotrim? Note that currently can't trim multiseg hits
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Starting 5' and 3' flank sequence autotrim processing...");
@@ -1907,7 +1996,7 @@ if(MinFlankExacts > 0)	// do  3' and 5' autotrim? Note that currently can't trim
 		return(Rslt);
 		}
 
-	if(gProcessingID)
+	if(gProcessingID && (!m_bStreamReads || !m_bStreamChunkLoaded))
 		{
 		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"Filtering",ePTInt32,sizeof(m_ElimPlusTrimed),"5' trimmed",&m_ElimPlusTrimed);
 		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"Filtering",ePTInt32,sizeof(m_ElimMinusTrimed),"3' trimmed",&m_ElimMinusTrimed);
@@ -2917,23 +3006,18 @@ if(SeqFragLen > PairMaxLen)
 return(SeqFragLen);
 }
 
-#ifdef _WIN32
-unsigned __stdcall KProcessPairedEndsThread(void * pThreadPars)
-#else
-void *KProcessPairedEndsThread(void * pThreadPars)
-#endif
+// called by work pool threads to process the chunk of pairs StartIdx..EndIdx-1, results are accumulated into the calling worker's parameters
+static int
+KProcessPairedEndsChunk(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
 {
 	int Rslt;
-	tsPEThreadPars *pPars = (tsPEThreadPars *)pThreadPars;			// makes it easier not having to deal with casts!
+	tsPEThreadPars *pPars = &((tsPEThreadPars *)pCtx)[WorkerIdx];
 	CKAligner *pKAligner = (CKAligner *)pPars->pThis;
+	pPars->StartPairIdx = (uint32_t)StartIdx;
+	pPars->NumPairsToProcess = (uint32_t)(EndIdx - StartIdx);
 	Rslt = pKAligner->ProcessPairedEnds(pPars);
 	pPars->Rslt = Rslt;
-#ifdef _WIN32
-	_endthreadex(0);
-	return(eBSFSuccess);
-#else
-pthread_exit(&pPars->Rslt);
-#endif
+	return(Rslt);
 }
 
 //ProcessPairedEnds
@@ -2968,91 +3052,65 @@ SortReadHits(eRSMPairReadID,false,true);
 
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Starting to associate Paired End reads to be within insert size range ...");
 
-if(m_pLenDist != nullptr)
-	{
-	delete []m_pLenDist;
-	m_pLenDist = nullptr;
-	}
-if((m_pLenDist = new int[cPairMaxLen+1])==nullptr)
+if(m_StreamBaseReads == 0)	// when streaming then insert length distributions accumulate over all chunks
 	{
-	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to allocate %d bytes memory for paired read sequence length distributions",
-								(int)sizeof(int) * (cPairMaxLen+1));
-	Reset(false);
-	return(eBSFerrMem);
+	if(m_pLenDist != nullptr)
+		{
+		delete []m_pLenDist;
+		m_pLenDist = nullptr;
+		}
+	if((m_pLenDist = new int[cPairMaxLen+1])==nullptr)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to allocate %d bytes memory for paired read sequence length distributions",
+									(int)sizeof(int) * (cPairMaxLen+1));
+		Reset(false);
+		return(eBSFerrMem);
+		}
+	memset(m_pLenDist,0,sizeof(int) * (cPairMaxLen+1));
 	}
-memset(m_pLenDist,0,sizeof(int) * (cPairMaxLen+1));
 
 time_t Started = time(0);
 uint32_t PrevPairReadIdx = 0;
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processed putative 0 pairs, accepted 0");
 
-// split number of pairs to be processed amongst number of worker threads
-
-
+// pairs are submitted to the shared work pool in chunks, workers steal chunks from each other so that no thread is left idle
+// whilst others are still processing pairs which required costly orphan recovery
 int ThreadIdx;
 int NumThreadsUsed;
+CWorkPool *pWorkPool;
 tsPEThreadPars WorkerThreads[cMaxWorkerThreads];
 memset(WorkerThreads, 0, sizeof(WorkerThreads));
-uint32_t NumPairsThisThread;
-PairReadIdx = 0;
-NumThreadsUsed = 0;
-for (ThreadIdx = 0; ThreadIdx < m_NumThreads; ThreadIdx++, NumThreadsUsed += 1)
+if((pWorkPool = CWorkPool::Shared(m_NumThreads)) == nullptr)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to start work pool threads");
+	Reset(false);
+	return(eBSFerrInternal);
+	}
+NumThreadsUsed = pWorkPool->JobWorkers(m_NumThreads);
+for (ThreadIdx = 0; ThreadIdx < NumThreadsUsed; ThreadIdx++)
 	{
 	WorkerThreads[ThreadIdx].ThreadIdx = ThreadIdx + 1;
 	WorkerThreads[ThreadIdx].pThis = this;
 	WorkerThreads[ThreadIdx].bPairStrand = bPairStrand;
 	WorkerThreads[ThreadIdx].MaxSubs = MaxSubs;
 	WorkerThreads[ThreadIdx].MinEditDist = MinEditDist;
-	WorkerThreads[ThreadIdx].StartPairIdx = PairReadIdx;
-	NumPairsThisThread = ((m_NumReadsLoaded / 2)- PairReadIdx) / (m_NumThreads - ThreadIdx);
-	WorkerThreads[ThreadIdx].NumPairsToProcess = NumPairsThisThread;
-	PairReadIdx += NumPairsThisThread;
 	WorkerThreads[ThreadIdx].PairMaxLen = PairMaxLen;
 	WorkerThreads[ThreadIdx].PairMinLen = PairMinLen;
 	WorkerThreads[ThreadIdx].PEproc = PEproc;
-#ifdef _WIN32
-	WorkerThreads[ThreadIdx].threadHandle = (HANDLE)_beginthreadex(nullptr, 0x0fffff, KProcessPairedEndsThread, &WorkerThreads[ThreadIdx], 0, &WorkerThreads[ThreadIdx].threadID);
-#else
-	WorkerThreads[ThreadIdx].threadRslt = pthread_create(&WorkerThreads[ThreadIdx].threadID, nullptr, KProcessPairedEndsThread, &WorkerThreads[ThreadIdx]);
-#endif
-	if((WorkerThreads[ThreadIdx].StartPairIdx + WorkerThreads[ThreadIdx].NumPairsToProcess) == m_NumReadsLoaded / 2)
-		{
-		NumThreadsUsed = ThreadIdx + 1;
-		break;
-		}
 	}
 
-// allow threads a few seconds to startup
-#ifdef _WIN32
-Sleep(5000);
-#else
-sleep(5);
-#endif
-
 uint32_t ReportProgressSecs;
 ReportProgressSecs = 60;
 
-// wait for all threads to have completed
-for (ThreadIdx = 0; ThreadIdx < NumThreadsUsed; ThreadIdx++)
+if((Rslt = pWorkPool->ParallelFor(m_NumReadsLoaded / 2, 0, KProcessPairedEndsChunk, WorkerThreads, ReportProgressSecs, "Still associating Paired Ends ...", nullptr, nullptr, NumThreadsUsed)) < eBSFSuccess)
 	{
-#ifdef _WIN32
-	while (WAIT_TIMEOUT == WaitForSingleObject(WorkerThreads[ThreadIdx].threadHandle, (DWORD)ReportProgressSecs * 1000))
-		{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "Progress: Still associating Paired Ends ...");
-		}
-	CloseHandle(WorkerThreads[ThreadIdx].threadHandle);
-#else
-	struct timespec ts;
-	int JoinRlt;
-	clock_gettime(CLOCK_REALTIME, &ts);
-	ts.tv_sec += ReportProgressSecs;
-	while ((JoinRlt = pthread_timedjoin_np(WorkerThreads[ThreadIdx].threadID, nullptr, &ts)) != 0)
-		{
-		gDiagnostics.DiagOut(eDLInfo, gszProcName, "Progress: Still associating Paired Ends ...");
-		ts.tv_sec += ReportProgressSecs;
-		}
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Errors whilst associating Paired Ends");
+	Reset(false);
+	return(Rslt);
+	}
 
-#endif
+for (ThreadIdx = 0; ThreadIdx < NumThreadsUsed; ThreadIdx++)
+	{
 	AcceptedNumPaired += WorkerThreads[ThreadIdx].AcceptedNumPaired;
 	PartnerPaired += WorkerThreads[ThreadIdx].PartnerPaired;
 	PartnerUnpaired += WorkerThreads[ThreadIdx].PartnerUnpaired;
@@ -3583,14 +3641,15 @@ CKAligner::ProcessPairedEnds(tsPEThreadPars *pPars)	   // paired reads parameter
 			AcceptedNumSE += 1;
 		}
 	}
-pPars->UnalignedPairs = UnalignedPairs;
-pPars->AcceptedNumPaired = AcceptedNumPaired;
-pPars->AcceptedNumSE = AcceptedNumSE;
-pPars->PartnerPaired = PartnerPaired;
-pPars->PartnerUnpaired = PartnerUnpaired;
-pPars->NumFilteredByChrom = NumFilteredByChrom;
-pPars->UnderLenPairs = UnderLenPairs;
-pPars->OverLenPairs = OverLenPairs;
+// worker may be processing multiple chunks so accumulate
+pPars->UnalignedPairs += UnalignedPairs;
+pPars->AcceptedNumPaired += AcceptedNumPaired;
+pPars->AcceptedNumSE += AcceptedNumSE;
+pPars->PartnerPaired += PartnerPaired;
+pPars->PartnerUnpaired += PartnerUnpaired;
+pPars->NumFilteredByChrom += NumFilteredByChrom;
+pPars->UnderLenPairs += UnderLenPairs;
+pPars->OverLenPairs += OverLenPairs;
 pPars->Rslt = 0;
 return(0);
 }
@@ -3641,7 +3700,7 @@ if((Rslt=SortReadHits(eRSMHitMatch,false)) < eBSFSuccess)
 	Reset(false);
 	return(Rslt);
 	}
-while((pReadHit = IterReads(pReadHit))!=nullptr)
+while((pReadHit = IterSortedReads(pReadHit))!=nullptr)
 	{
 	switch(pReadHit->NAR) {
 		case eNARUnaligned:				// read has yet to be aligned
@@ -3779,7 +3838,7 @@ if(gProcessingID > 0)
 	{
 	uint32_t Cricks;
 	Cricks = NumUniques-NumPlusHits;
-	if(m_MLMode >= eMLall)
+	if(m_MLMode >= eMLall || m_bStreamReads)
 		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"Alignments",ePTUint32,sizeof(m_OrigNumReadsLoaded),"NumLoaded",&m_OrigNumReadsLoaded);
 	else
 		gSQLiteSummaries.AddResult(gExperimentID, gProcessingID,(char *)"Alignments",ePTUint32,sizeof(m_NumReadsLoaded),"NumLoaded",&m_NumReadsLoaded);
@@ -4322,17 +4381,18 @@ int LineLen;
 
 if(m_bPackedBaseAlleles)
 	{
-#ifdef _WIN32
-	m_hPackedBaseAllelesFile = open(m_pszOutFile,( O_WRONLY | _O_BINARY | _O_SEQUENTIAL | _O_CREAT | _O_TRUNC),(_S_IREAD | _S_IWRITE) );
-#else
-	if((m_hPackedBaseAllelesFile = open(m_pszOutFile,O_WRONLY | O_CREAT,S_IREAD | S_IWRITE))!=-1)
-		if(ftruncate(m_hPackedBaseAllelesFile,0)!=0)
-			{
-			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to truncate loci base classification binary output file  %s - %s",m_pszOutFile,strerror(errno));
-			return(eBSFerrCreateFile);
-			}
-#endif
-	if(m_hPackedBaseAllelesFile < 0)
+	// PBA files are generated as version 2, with space reserved for a chromosome directory which can hold all targeted chromosomes
+	int ChromID;
+	int32_t MaxDirLen;
+	char szChromName[128];
+	MaxDirLen = 0;
+	for(ChromID = 1; ChromID <= m_pSfxArray->GetNumEntries(); ChromID++)
+		{
+		m_pSfxArray->GetIdentName(ChromID,sizeof(szChromName),szChromName);
+		MaxDirLen += CPBAfile::DirEntryLen(szChromName);
+		}
+	if((m_pPBAFile = new CPBAfile) == nullptr ||
+		m_pPBAFile->Create(m_pszOutFile,m_szExperimentName,m_szTargSpecies,m_pszTrackTitle,MaxDirLen) != eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Process: unable to create/truncate loci base classification binary output file '%s'",m_pszOutFile);
 		return(eBSFerrCreateFile);
@@ -4552,6 +4612,12 @@ if(m_pszSNPRsltsFile != nullptr && m_pszSNPRsltsFile[0] != '\0' && m_MinSNPreads
 #ifdef _DISNPS_
 	CUtility::AppendFileNameSuffix(m_szDiSNPFile, m_pszSNPRsltsFile, (char*)".disnp.csv",'.');
 	CUtility::AppendFileNameSuffix(m_szTriSNPFile, m_pszSNPRsltsFile, (char*)".trisnp.csv", '.');
+	if(m_bStreamReads)	// experimental DiSNPs and TriSNPs require random access to the reads overlapping each SNP pair, streamed reads are only available in a sequential locus ordered pass
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Process: streaming alignment, DiSNP and TriSNP files '%s' and '%s' will not be generated",m_szDiSNPFile,m_szTriSNPFile);
+		m_szDiSNPFile[0] = '\0';
+		m_szTriSNPFile[0] = '\0';
+		}
 
 	if(m_szDiSNPFile[0] != '\0')
 		{
@@ -4785,7 +4851,7 @@ pthread_exit(&pPars->Rslt);
 int
 CKAligner::InitiateLoadingReads(void)
 {
-tsLoadReadsThreadPars ThreadPars;
+tsLoadReadsThreadPars &ThreadPars = m_LoadReadsThreadPars;
 memset(&ThreadPars, 0, sizeof(ThreadPars));
 // initiate loading the reads
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Loading reads from file...");
@@ -4814,14 +4880,7 @@ if (ThreadRslt != 0)
 	}
 #endif
 
-// allow a few seconds for threads to actually startup
-#ifdef _WIN32
-Sleep(2000);
-#else
-sleep(2);
-#endif
-
-// wait a few additional seconds, if major problems with loading reads then these should show up very quickly
+// wait a second, if major problems with loading reads then these should show up very quickly
 #ifdef _WIN32
 if(WaitForSingleObject(m_hThreadLoadReads, 1000) != WAIT_TIMEOUT)
 	{
@@ -5763,9 +5822,14 @@ switch(SAMFormat) {
 	case etSAMFBAM:				// output as BAM compressed with bgzf
 		FileType = eSFTBAM_BAI;
 		break;
+	default:
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"WriteBAMReadHits: Unsupported SAM/BAM output format %d",(int)SAMFormat);
+		delete pBAMalign;
+		delete pSAMfile;
+		return(eBSFerrParams);
 	}
 
-if((Rslt = pSAMfile->Create(FileType,m_pszOutFile,ComprLev,(char *)kit4bversion)) < eBSFSuccess)
+if((Rslt = pSAMfile->Create(FileType,m_pszOutFile,ComprLev,(char *)kit4bversion,m_NumThreads)) < eBSFSuccess)
 	{
 	delete pBAMalign;
 	delete pSAMfile;
@@ -5786,15 +5850,19 @@ bRptAllChroms = m_MaxRptSAMSeqsThres >= NumChroms ? true : false;
 
 // identify chroms to be reported
 // only reporting those which have accepted alignments unless reporting all chromosomes even if not all have alignments
-while((pReadHit = IterSortedReads(pReadHit))!=nullptr)
+// when streaming then chroms were marked as each chunk was spilled
+if(!m_bStreamMerge)
 	{
-	if(pReadHit->NAR == eNARAccepted)
+	while((pReadHit = IterSortedReads(pReadHit))!=nullptr)
 		{
-		if(CurChromID == 0 || CurChromID != pReadHit->HitLoci.Hit.Seg[0].ChromID)
+		if(pReadHit->NAR == eNARAccepted)
 			{
-			CurChromID = pReadHit->HitLoci.Hit.Seg[0].ChromID;
-			if(CurChromID > 0)
-				m_pSfxArray->SetResetIdentFlags(CurChromID,0x01,0x00);
+			if(CurChromID == 0 || CurChromID != pReadHit->HitLoci.Hit.Seg[0].ChromID)
+				{
+				CurChromID = pReadHit->HitLoci.Hit.Seg[0].ChromID;
+				if(CurChromID > 0)
+					m_pSfxArray->SetResetIdentFlags(CurChromID,0x01,0x00);
+				}
 			}
 		}
 	}
@@ -6864,23 +6932,60 @@ return(eBSFSuccess);
 }
 
 
+// AddMultiHit
+// Alignments are appended to the calling thread's arena without serialisation, the arena is merged into m_pMultiAll when full
+// and when the thread has completed processing its reads
 int
-CKAligner::AddMultiHit(tsReadHit *pReadHit)
+CKAligner::AddMultiHit(tsThreadMatchPars *pPars,	// thread buffering the alignment
+				tsReadHit *pReadHit)			// alignment to buffer
 {
-int NumMultiHits;
-int CopyLen;
+int Rslt;
 size_t HitLen;
+
+HitLen = sizeof(tsReadHit) + pReadHit->ReadLen + pReadHit->DescrLen;
+if(pPars->pMultiAll == nullptr)
+	{
+	if((pPars->pMultiAll = (uint8_t *)malloc(cThreadMultiAllArena)) == nullptr)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"AddMultiHit: Memory allocation of %zd bytes - %s",cThreadMultiAllArena,strerror(errno));
+		return(eBSFerrMem);
+		}
+	pPars->MultiAllOfs = 0;
+	pPars->NumMultiAll = 0;
+	}
+else
+	if(pPars->MultiAllOfs + HitLen > cThreadMultiAllArena)
+		{
+		if((Rslt = MergeThreadMultiAll(pPars)) < eBSFSuccess)
+			return(Rslt);
+		}
+
+memcpy(&pPars->pMultiAll[pPars->MultiAllOfs],pReadHit,HitLen);
+pPars->MultiAllOfs += HitLen;
+pPars->NumMultiAll += 1;
+return((int)pPars->NumMultiAll);
+}
+
+// MergeThreadMultiAll
+// Merge thread buffered alignments into m_pMultiAll, ReadIDs are assigned as alignments are merged
+int
+CKAligner::MergeThreadMultiAll(tsThreadMatchPars *pPars)
+{
+uint32_t HitIdx;
+size_t memreq;
 tsReadHit *pMultiHit;
 
-HitLen = sizeof(tsReadHit) + pReadHit->ReadLen + pReadHit->DescrLen; 
+if(pPars->pMultiAll == nullptr || pPars->NumMultiAll == 0)
+	return(eBSFSuccess);
+
 #ifdef _WIN32
-DWORD WaitRslt = WaitForSingleObject(m_hMtxMultiMatches,INFINITE);
+WaitForSingleObject(m_hMtxMultiMatches,INFINITE);
 #else
 pthread_mutex_lock(&m_hMtxMultiMatches);
 #endif
-if(m_NxtMultiAllOfs + (2 * HitLen) >= m_AllocMultiAllMem)
+if(m_NxtMultiAllOfs + pPars->MultiAllOfs >= m_AllocMultiAllMem)
 	{
-	size_t memreq = m_AllocMultiAllMem + (cAllocMultihits * HitLen);
+	memreq = m_AllocMultiAllMem + max(pPars->MultiAllOfs,(size_t)cAllocMultihits * (pPars->MultiAllOfs / pPars->NumMultiAll));
 #ifdef _WIN32
 	pMultiHit = (tsReadHit *) realloc(m_pMultiAll,memreq);
 #else
@@ -6891,9 +6996,9 @@ if(m_NxtMultiAllOfs + (2 * HitLen) >= m_AllocMultiAllMem)
 	if(pMultiHit == nullptr)
 		{
 #ifdef _WIN32
-ReleaseMutex(m_hMtxMultiMatches);
+		ReleaseMutex(m_hMtxMultiMatches);
 #else
-pthread_mutex_unlock(&m_hMtxMultiMatches);
+		pthread_mutex_unlock(&m_hMtxMultiMatches);
 #endif
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"AddMultiHit: Memory re-allocation to %zd bytes - %s",memreq,strerror(errno));
 		return(eBSFerrMem);
@@ -6902,20 +7007,43 @@ pthread_mutex_unlock(&m_hMtxMultiMatches);
 	m_AllocMultiAllMem = memreq;
 	}
 pMultiHit = (tsReadHit *)((uint8_t *)m_pMultiAll + m_NxtMultiAllOfs);
-
-CopyLen = sizeof(tsReadHit) + pReadHit->DescrLen + pReadHit->ReadLen;
-memcpy(pMultiHit,pReadHit,CopyLen);
-
-m_NxtMultiAllOfs += CopyLen;
-m_NumMultiAll += 1;
-pMultiHit->ReadID = m_NumMultiAll;
-NumMultiHits = m_NumMultiAll;
+memcpy(pMultiHit,pPars->pMultiAll,pPars->MultiAllOfs);
+m_NxtMultiAllOfs += pPars->MultiAllOfs;
+for(HitIdx = 0; HitIdx < pPars->NumMultiAll; HitIdx++)
+	{
+	pMultiHit->ReadID = ++m_NumMultiAll;
+	pMultiHit = (tsReadHit *)((uint8_t *)pMultiHit + sizeof(tsReadHit) + pMultiHit->ReadLen + pMultiHit->DescrLen);
+	}
 #ifdef _WIN32
 ReleaseMutex(m_hMtxMultiMatches);
 #else
 pthread_mutex_unlock(&m_hMtxMultiMatches);
 #endif
-return((int)NumMultiHits);
+pPars->MultiAllOfs = 0;
+pPars->NumMultiAll = 0;
+return(eBSFSuccess);
+}
+
+// MergeThreadHits
+// Merge any remaining thread buffered alignments and multihit reads, thread buffers are then freed
+int
+CKAligner::MergeThreadHits(tsThreadMatchPars *pPars)
+{
+int Rslt;
+int MHRslt;
+Rslt = MergeThreadMultiAll(pPars);
+MHRslt = MergeThreadMHReads(pPars);
+if(pPars->pMultiAll != nullptr)
+	{
+	free(pPars->pMultiAll);
+	pPars->pMultiAll = nullptr;
+	}
+if(pPars->pMHReads != nullptr)
+	{
+	free(pPars->pMHReads);
+	pPars->pMHReads = nullptr;
+	}
+return(Rslt < eBSFSuccess ? Rslt : MHRslt);
 }
 
 int				// normally NumHits, but will be actual number of hits if unable to accept any of the loci hit because of chromosome filtering
@@ -6982,7 +7110,7 @@ for(int HitIdx = 0; HitIdx < NumHits; HitIdx++,pHit++)
 	else
 		pMultiHit->HitLoci.FlagSegs = 0;
 
-	if((Rslt = AddMultiHit(pMultiHit)) < eBSFSuccess)
+	if((Rslt = AddMultiHit(pThreadPars,pMultiHit)) < eBSFSuccess)
 		return(Rslt);
 	}
 
@@ -7217,15 +7345,9 @@ else
 			}
 #endif
 		m_AllocPackedBaseAllelesMem = memreq;
-
-		// as this the first chromosome being called then generate header
-		// This header contains a series of '\n' separated tagname:values 
-		// Following the header are a variable number of chromosomes
-		m_NumPackedBaseAlleles = sprintf((char *)m_pPackedBaseAlleles,"Type:%s\nVersion:1\nExperimentID:%s\nReferenceID:%s\nReadsetID:%s","PbA",m_szExperimentName,m_szTargSpecies,m_pszTrackTitle);
-		m_NumPackedBaseAlleles+=1;	
 		}
 	else
-		{	// initial allocation and header not required
+		{	// initial allocation not required
 			// but need to allocate additional memory for this new chrom?
 		if (((size_t)m_pChromSNPs->ChromLen + 0x0ffff) > m_AllocPackedBaseAllelesMem) 
 			{
@@ -7246,17 +7368,11 @@ else
 			m_pPackedBaseAlleles = pPackedBaseAlleles;
 			m_AllocPackedBaseAllelesMem = memreq;
 			}
-		m_NumPackedBaseAlleles = 0;	// no header
 		}
 	
-	pPackedBaseAlleles = &m_pPackedBaseAlleles[m_NumPackedBaseAlleles];
-
-	*pPackedBaseAlleles = (uint8_t)strlen(szChromName);
-	strcpy((char *)&pPackedBaseAlleles[1],szChromName);
-	pPackedBaseAlleles += 2 + *pPackedBaseAlleles;
-	*(uint32_t *)pPackedBaseAlleles = m_pChromSNPs->ChromLen;
-	pPackedBaseAlleles += 4;
-	m_NumPackedBaseAlleles = (uint32_t)(pPackedBaseAlleles - m_pPackedBaseAlleles);
+	// chromosome name and PBA count are recorded in the PBA file chromosome directory so only the PBAs are buffered
+	pPackedBaseAlleles = m_pPackedBaseAlleles;
+	m_NumPackedBaseAlleles = 0;
 	pSNP = &m_pChromSNPs->Cnts[0];
 	InitialiseWIGSpan();
 	for (Loci = 0; Loci < m_pChromSNPs->ChromLen; Loci++, pSNP++,pPackedBaseAlleles++,m_NumPackedBaseAlleles++)
@@ -7301,17 +7417,11 @@ else
 		*pPackedBaseAlleles = PackedBaseAlleles;
 		}
 	CompleteWIGSpan(true);
-	if(m_hPackedBaseAllelesFile != -1)
+	if(m_pPBAFile != nullptr)
 		{
-		if(m_NumPackedBaseAlleles > 0)
-			{
-			if(!CUtility::RetryWrites(m_hPackedBaseAllelesFile, m_pPackedBaseAlleles, m_NumPackedBaseAlleles))
-				{
-				gDiagnostics.DiagOut(eDLInfo,gszProcName,"RetryWrites() error");
-				return(eBSFerrWrite);
-				}
-			m_NumPackedBaseAlleles = 0;
-			}
+		if((Rslt = m_pPBAFile->WriteChromPBAs(szChromName,(int32_t)m_NumPackedBaseAlleles,m_pPackedBaseAlleles)) != eBSFSuccess)
+			return(Rslt);
+		m_NumPackedBaseAlleles = 0;
 		}
 	return(eBSFSuccess);
 	}	// completed PBA processing
@@ -8682,15 +8792,13 @@ if(m_hSNPCentsfile != -1)
 	}
 else
 	{
-	if(m_hPackedBaseAllelesFile != -1)
+	if(m_pPBAFile != nullptr)
 		{
-#ifdef _WIN32
-		_commit(m_hPackedBaseAllelesFile);
-#else
-		fsync(m_hPackedBaseAllelesFile);
-#endif
-		close(m_hPackedBaseAllelesFile);
-		m_hPackedBaseAllelesFile = -1;
+		Rslt = m_pPBAFile->CloseCreate(true);
+		delete m_pPBAFile;
+		m_pPBAFile = nullptr;
+		if(Rslt != eBSFSuccess)
+			return(Rslt);
 		}
 	}
 
@@ -9052,6 +9160,7 @@ m_AllocdReadHitsMem = memreq;
 m_UsedReadHitsMem = 0;
 m_FinalReadID = 0;
 m_NumReadsLoaded = 0;
+m_LoadedReadsOfs = 0;
 m_NumDescrReads = 0;
 ReleaseExclusiveLock();
 
@@ -9145,12 +9254,7 @@ while((RdLen = read(m_hInFile,&pReadBuff[BuffLen],cRdsBuffAlloc - BuffLen)) > 0)
 		// processing threads are only updated with actual number of loaded reads every 100000 reads so as
 		// to minimise disruption to the actual aligner threads which will also be serialised through m_hMtxIterReads
 		if(m_NumDescrReads > 0 && !(m_NumDescrReads % 100000))
-			{
-			AcquireSerialise();
-			m_FinalReadID = m_NumDescrReads;
-			m_NumReadsLoaded = m_NumDescrReads;
-			ReleaseSerialise();
-			}
+			PublishLoadedReads(m_UsedReadHitsMem);
 		}
 	BuffLen -= BuffOfs;
 	if(BuffLen)
@@ -9160,12 +9264,7 @@ delete []pReadBuff;
 close(m_hInFile);
 m_hInFile = -1;
 if(m_NumDescrReads != m_NumReadsLoaded)
-	{
-	AcquireSerialise();
-	m_FinalReadID = m_NumDescrReads;
-	m_NumReadsLoaded = m_NumDescrReads;
-	ReleaseSerialise();
-	}
+	PublishLoadedReads(m_UsedReadHitsMem);
 return(m_NumDescrReads);
 }
 
@@ -9429,13 +9528,6 @@ for(ThreadIdx = 0; ThreadIdx < m_NumThreads; ThreadIdx++, pWorkerThread++)
 #endif
 	}
 
-// allow threads a few seconds to startup
-#ifdef _WIN32
-	Sleep(5000);
-#else
-	sleep(5);
-#endif
-
 uint32_t ReportProgressSecs;
 ReportProgressSecs = 60;
 if(m_SampleNthRawRead > 1)
@@ -9508,8 +9600,9 @@ for(ThreadIdx = 0; ThreadIdx < m_NumThreads; ThreadIdx++, pWorkerThread++)
 
 
 // pickup the read loader thread, if the reads processing threads all finished then the loader thread should also have finished
+// unless streaming and the loader is waiting for the current chunk to be processed
 #ifdef _WIN32
-if(m_hThreadLoadReads != nullptr)
+if(m_hThreadLoadReads != nullptr && !m_bStreamChunkLoaded)
 	{
 	while(WAIT_TIMEOUT == WaitForSingleObject(m_hThreadLoadReads, 5000))
 		{
@@ -9519,7 +9612,7 @@ if(m_hThreadLoadReads != nullptr)
 	m_hThreadLoadReads = nullptr;
 	}
 #else
-if(m_ThreadLoadReadsID != 0)
+if(m_ThreadLoadReadsID != 0 && !m_bStreamChunkLoaded)
 	{
 	struct timespec ts;
 	int JoinRlt;
@@ -9535,7 +9628,7 @@ if(m_ThreadLoadReadsID != 0)
 #endif
 
 // Checking here that the reads were all loaded w/o any major dramas!
-if(m_ThreadLoadReadsRslt < 0 || m_ThreadCoredApproxRslt < 0)
+if((!m_bStreamChunkLoaded && m_ThreadLoadReadsRslt < 0) || m_ThreadCoredApproxRslt < 0)
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: Early terminated");
 	Reset(false);
@@ -10017,7 +10110,7 @@ switch (HitRslt) {
 				}
 			
 			if(m_PEproc == ePEdefault)
-				if ((Rslt = AddMHitReads(LowHitInstances, &pPars->HitReads[pPars->HitReadsOfs])) < 0)		// pts to array of hit loci
+				if ((Rslt = AddMHitReads(pPars, LowHitInstances, &pPars->HitReads[pPars->HitReadsOfs])) < 0)		// pts to array of hit loci
 					break;
 			pPars->HitReadsOfs = HitIdx;
 			}
@@ -10166,6 +10259,7 @@ while(ThreadedIterReads(pReadsHitBlock))
 		if(PE1HitRslt == eHRFatalError)
 			{
 			ReleaseSharedLock();
+			MergeThreadHits(pPars);
 			free(pReadsHitBlock);
 			return(-1);
 			}
@@ -10179,6 +10273,7 @@ while(ThreadedIterReads(pReadsHitBlock))
 			if (PE2HitRslt == eHRFatalError)
 				{
 				ReleaseSharedLock();
+				MergeThreadHits(pPars);
 				free(pReadsHitBlock);
 				return(-1);
 				}
@@ -10241,6 +10336,15 @@ while(ThreadedIterReads(pReadsHitBlock))
 		}
 	}
 ReleaseSharedLock();
+
+// merge this thread's buffered multiloci alignments and multihit reads, only serialised once per buffer instead of once per read
+if((Rslt = MergeThreadHits(pPars)) < eBSFSuccess)
+	{
+	free(pReadsHitBlock);
+	return(Rslt);
+	}
+
+CRunProfile::Count(eRPCReadsAligned,pPars->NumAcceptedAsAligned);
 AcquireSerialise();
 m_NumSloughedNs += pPars->NumSloughedNs;
 m_TotNonAligned += pPars->NumNonAligned;
@@ -10251,223 +10355,849 @@ m_TotLociAligned += pPars->NumLociAligned;
 m_TotNotAcceptedDelta += pPars->NumNotAcceptedDelta;
 m_TotAcceptedHitInsts += pPars->NumAcceptedHitInsts;
 
-if(m_MLMode != eMLall)
-	{
-	int Idx;
-	for(Idx = 0; Idx < MaxML; Idx++)
-		m_MultiHitDist[Idx] += pPars->MultiHitDist[Idx];
+if(m_MLMode != eMLall)
+	{
+	int Idx;
+	for(Idx = 0; Idx < MaxML; Idx++)
+		m_MultiHitDist[Idx] += pPars->MultiHitDist[Idx];
+	}
+free(pReadsHitBlock);
+ReleaseSerialise();
+return(1);
+}
+
+// LocateRead
+tsReadHit *
+CKAligner::LocateRead(uint32_t ReadID) // Locate read with requested ReadID
+{
+int Rslt;
+tsReadHit *pProbe;
+int Lo,Mid,Hi;	// search limits
+
+if(m_ppReadHitsIdx == nullptr || m_AllocdReadHitsIdx < m_NumReadsLoaded)
+	return(nullptr);
+
+Lo = 0;
+Hi = m_NumReadsLoaded-1;
+while(Hi >= Lo) {
+	Mid = (Hi + Lo)/2;
+	pProbe = m_ppReadHitsIdx[Mid];
+	Rslt = pProbe->ReadID - ReadID;
+	if(Rslt > 0)
+		{
+		Hi = Mid - 1;
+		continue;
+		}
+	if(Rslt < 0)
+		{
+		Lo = Mid + 1;
+		continue;
+		}
+	return(pProbe);
+	}
+return(nullptr);
+}
+
+
+// AddMHitReads
+// Multihit reads are appended to the calling thread's buffer without serialisation, the buffer is merged into m_pMultiHits when full
+// and when the thread has completed processing its reads
+int
+CKAligner::AddMHitReads(tsThreadMatchPars *pPars,	// thread buffering the multimatches
+		uint32_t NumHits,	// number of multimatches loci in pHits
+		tsReadHit *pHits)		// pts to array of hit loci
+{
+int Rslt;
+// ensure actually processing multihits
+if(m_MLMode <= eMLrand)
+	return(0);					// silently slough these hits
+
+if(pPars->pMHReads == nullptr)
+	{
+	if((pPars->pMHReads = (tsReadHit *)malloc(sizeof(tsReadHit) * cThreadMHReads)) == nullptr)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"AddMHitReads: Memory allocation of %zd bytes - %s",sizeof(tsReadHit) * cThreadMHReads,strerror(errno));
+		return(eBSFerrMem);
+		}
+	pPars->NumMHReads = 0;
+	}
+else
+	if((pPars->NumMHReads + NumHits) > cThreadMHReads)
+		{
+		if((Rslt = MergeThreadMHReads(pPars)) < eBSFSuccess)
+			return(Rslt);
+		}
+
+memcpy(&pPars->pMHReads[pPars->NumMHReads],pHits,sizeof(tsReadHit) * NumHits);
+pPars->NumMHReads += NumHits;
+if(NumHits == 1)
+	pPars->NumUniqueMHReads += 1;
+else
+	pPars->NumProvMHAligned += 1;
+return((int)NumHits);
+}
+
+// MergeThreadMHReads
+// Merge thread buffered multihit reads into m_pMultiHits
+int
+CKAligner::MergeThreadMHReads(tsThreadMatchPars *pPars)
+{
+size_t memreq;
+tsReadHit *pDstHits;
+
+if(pPars->pMHReads == nullptr || pPars->NumMHReads == 0)
+	return(eBSFSuccess);
+
+AcquireSerialiseMH();
+
+if((m_AllocdMultiHits - m_NumMultiHits) < (pPars->NumMHReads+1000))	// need to realloc? -- added 1000 to provide a little safety margin
+	{
+	memreq = (m_AllocdMultiHits + cAllocMultihits) * sizeof(tsReadHit);
+#ifdef _WIN32
+	pDstHits = (tsReadHit *) realloc(m_pMultiHits,memreq);
+#else
+	pDstHits = (tsReadHit *)mremap(m_pMultiHits,m_AllocdMultiHitsMem,memreq,MREMAP_MAYMOVE);
+	if(pDstHits == MAP_FAILED)
+		pDstHits = nullptr;
+#endif
+	if(pDstHits == nullptr)
+		{
+		ReleaseSerialiseMH();
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"AddMHitReads: Memory re-allocation to %zd bytes - %s",memreq,strerror(errno));
+		return(eBSFerrMem);
+		}
+	m_pMultiHits = pDstHits;
+	m_AllocdMultiHitsMem = memreq;
+	m_AllocdMultiHits += cAllocMultihits;
+	}
+pDstHits = &m_pMultiHits[m_NumMultiHits];
+memcpy(pDstHits,pPars->pMHReads,sizeof(tsReadHit) * pPars->NumMHReads);
+m_NumMultiHits += pPars->NumMHReads;
+m_NumUniqueMultiHits += pPars->NumUniqueMHReads;
+m_NumProvMultiAligned += pPars->NumProvMHAligned;
+ReleaseSerialiseMH();
+pPars->NumMHReads = 0;
+pPars->NumUniqueMHReads = 0;
+pPars->NumProvMHAligned = 0;
+return(eBSFSuccess);
+}
+
+
+// ResetThreadedIterReads
+void
+CKAligner::ResetThreadedIterReads(void) // must be called by master thread prior to worker threads calling ThreadedIterReads()
+{
+m_NumReadsProc = 0;
+m_NxtReadProcOfs = 0;
+m_ProcessingStartSecs = gStopWatch.ReadUSecs();
+}
+
+
+uint32_t		// Returns the number of reads thus far loaded and processed for alignment
+CKAligner::ApproxNumReadsProcessed(uint32_t *pNumProcessed,uint32_t *pNumLoaded)
+{
+uint32_t NumReadsProc;
+AcquireSerialise();
+NumReadsProc = m_NumReadsProc;
+if(pNumProcessed != nullptr)
+	*pNumProcessed = NumReadsProc;
+if(pNumLoaded != nullptr)
+	*pNumLoaded = m_NumReadsLoaded;
+ReleaseSerialise();
+return(NumReadsProc);
+}
+
+// PublishLoadedReads
+// Called by the reads loader thread to make reads thus far loaded available to the aligner threads
+void
+CKAligner::PublishLoadedReads(size_t LoadedOfs)	// reads loaded up to m_NumDescrReads end at this byte offset in m_pReadHits
+{
+AcquireSerialise();
+if(m_NumDescrReads > m_FinalReadID)
+	CRunProfile::Count(eRPCReadsLoaded,m_NumDescrReads - m_FinalReadID);
+m_FinalReadID = m_NumDescrReads;
+m_NumReadsLoaded = m_NumDescrReads - m_StreamBaseReads;
+m_LoadedReadsOfs = LoadedOfs;
+ReleaseSerialise();
+}
+
+// ClaimReads
+// Claims a block of contiguous reads starting from m_NxtReadProcOfs
+// The block is determined by the calling thread and then claimed with a compare and swap on m_NxtReadProcOfs, if another thread
+// claimed reads in the interim then the block is redetermined from the updated cursor
+// Caller must hold the shared lock so that m_pReadHits can't be reallocated
+int										// number of reads claimed, 0 if none available
+CKAligner::ClaimReads(tsReadsHitBlock *pRetBlock,	// claimed reads returned in this block
+				uint32_t MaxReads2Proc,		// claim at most this many reads
+				size_t LoadedReadsOfs)		// reads loaded up to this byte offset are available to be claimed
+{
+uint32_t NumReads;
+size_t CurOfs;
+size_t NxtOfs;
+tsReadHit *pCurReadHit;
+
+while(1)
+	{
+	CurOfs = m_NxtReadProcOfs;
+	NxtOfs = CurOfs;
+	NumReads = 0;
+	while(NumReads < MaxReads2Proc && NxtOfs < LoadedReadsOfs)
+		{
+		pCurReadHit = (tsReadHit *)((uint8_t *)m_pReadHits + NxtOfs);
+		pRetBlock->pReadHits[NumReads++] = pCurReadHit;
+		NxtOfs += sizeof(tsReadHit) + pCurReadHit->ReadLen + pCurReadHit->DescrLen;
+		}
+	if(NumReads == 0)
+		break;
+#ifdef _WIN32
+	if(InterlockedCompareExchange64((volatile LONG64 *)&m_NxtReadProcOfs,(LONG64)NxtOfs,(LONG64)CurOfs) == (LONG64)CurOfs)
+		{
+		InterlockedExchangeAdd((volatile LONG *)&m_NumReadsProc,(LONG)NumReads);
+		break;
+		}
+#else
+	if(__sync_bool_compare_and_swap(&m_NxtReadProcOfs,CurOfs,NxtOfs))
+		{
+		__sync_fetch_and_add(&m_NumReadsProc,NumReads);
+		break;
+		}
+#endif
+	}
+pRetBlock->NumReads = NumReads;
+return((int)NumReads);
+}
+
+// ThreadedIterReads
+// Iterates over all reads
+// Whilst reads are still being loaded then threads are gated through m_hMtxIterReads as the loader may need exclusive access to reallocate m_pReadHits,
+// once all reads have been loaded then blocks of reads are claimed without serialisation
+// Caller must hold the shared lock on entry, the shared lock is held on return
+bool	// returns false if no more reads avail for processing by calling thread
+CKAligner::ThreadedIterReads(tsReadsHitBlock *pRetBlock)
+{
+bool bAllReadsLoaded;
+uint32_t NumReadsLoaded;
+uint32_t NumReadsProc;
+uint32_t NumReadsLeft;
+uint32_t MaxReads2Proc;
+uint32_t AdjReadsPerBlock;
+size_t LoadedReadsOfs;
+pRetBlock->NumReads = 0;
+
+AdjReadsPerBlock = cMaxReadsPerBlock;
+if(m_SampleNthRawRead > 1)
+	AdjReadsPerBlock = min((uint32_t)100,AdjReadsPerBlock/m_SampleNthRawRead);
+
+while(1) {
+	// m_bAllReadsLoaded is set whilst loader holds the exclusive lock so is stable whilst the shared lock is held
+	if(!(bAllReadsLoaded = m_bAllReadsLoaded))
+		{
+		ReleaseSharedLock();
+		while(1) {
+			AcquireSerialise();
+			AcquireSharedLock();
+			if(m_bAllReadsLoaded || ((m_NumReadsLoaded - m_NumReadsProc) >= (uint32_t)min(AdjReadsPerBlock,(uint32_t)pRetBlock->MaxReads)) || m_ThreadCoredApproxRslt < 0)
+				break;
+
+			ReleaseSharedLock();
+			ReleaseSerialise();
+#ifdef _WIN32
+			Sleep(2000);			// must have caught up to the reads loader, allow it some breathing space to parse and load some more reads...
+#else
+			sleep(2);
+#endif
+			}
+		bAllReadsLoaded = m_bAllReadsLoaded;
+		NumReadsLoaded = m_NumReadsLoaded;
+		LoadedReadsOfs = m_LoadedReadsOfs;
+		ReleaseSerialise();
+		}
+	else
+		{
+		NumReadsLoaded = m_NumReadsLoaded;
+		LoadedReadsOfs = m_LoadedReadsOfs;
+		}
+
+	if(m_pReadHits == nullptr ||
+		m_ThreadCoredApproxRslt < 0 ||
+		(bAllReadsLoaded && (m_LoadReadsRslt != eBSFSuccess || NumReadsLoaded == 0)))
+		break;
+
+	// adjust MaxReads2Proc according to the number of reads remaining and threads still processing these reads
+	// idea is to maximise the number of threads still processing when most reads have been processed so that
+	// the last thread processing doesn't end up with a large block of reads needing lengthly processing
+	NumReadsProc = m_NumReadsProc;
+	NumReadsLeft = NumReadsLoaded > NumReadsProc ? NumReadsLoaded - NumReadsProc : 0;
+	if(NumReadsLeft < AdjReadsPerBlock/4)	// if < cMaxReadsPerBlock/4 yet to be processed then give it all to the one thread
+		MaxReads2Proc = AdjReadsPerBlock/4;
+	else
+		{
+		MaxReads2Proc = min((uint32_t)pRetBlock->MaxReads,10 + (NumReadsLeft / (uint32_t)m_NumThreads));
+		// assume PE processing so ensure MaxReads2Proc is a multiple of 2
+		MaxReads2Proc &= ~0x01;
+		}
+	MaxReads2Proc = min(MaxReads2Proc,(uint32_t)pRetBlock->MaxReads);
+
+	if(ClaimReads(pRetBlock,MaxReads2Proc,LoadedReadsOfs) > 0)
+		return(true);
+	if(bAllReadsLoaded)				// if all reads have been loaded and all processed then time to move onto next processing phase
+		break;
+	}
+
+pRetBlock->NumReads = 0;
+pRetBlock->pReadHits[0] = nullptr;
+return(false);
+}
+
+
+// IterReads
+// use to iterate over reads returning ptr to next read following the current read
+// Reads need not be sorted
+// To start from first read then pass in nullptr as pCurReadHit
+// Returns nullptr if all read hits have been iterated
+tsReadHit *
+CKAligner::IterReads(tsReadHit *pCurReadHit) // to start from first read then pass in nullptr as pCurReadHit
+{
+tsReadHit *pNxtReadHit = nullptr;
+if(pCurReadHit == nullptr)
+	pNxtReadHit = m_pReadHits;
+else
+	if(pCurReadHit->ReadID != m_FinalReadID)
+		pNxtReadHit = (tsReadHit *)((uint8_t *)pCurReadHit + sizeof(tsReadHit) + pCurReadHit->ReadLen + pCurReadHit->DescrLen);
+return(pNxtReadHit);
+}
+
+// IterSortedReads
+// use to iterate over sorted reads returning ptr to next read following the current read
+// To start from first read then pass in nullptr as pCurReadHit
+// Returns nullptr if all read hits have been iterated
+tsReadHit *
+CKAligner::IterSortedReads(tsReadHit *pCurReadHit)
+{
+tsReadHit *pNxtReadHit = nullptr;
+if(m_bStreamMerge)
+	return(IterMergedReads(pCurReadHit));
+if(pCurReadHit == nullptr)
+	pNxtReadHit = m_ppReadHitsIdx[0];
+else
+	if(pCurReadHit->ReadHitIdx < m_NumReadsLoaded)
+		pNxtReadHit = m_ppReadHitsIdx[pCurReadHit->ReadHitIdx];
+return(pNxtReadHit);
+}
+
+// StreamAlignReads
+// Streaming alignment, bounds memory required for holding reads by loading and aligning reads in chunks of at most m_StreamChunkMem bytes
+// Each aligned chunk is spilled as a run of reads sorted by eRSMHitMatch into a temp file, following the final chunk IterSortedReads() will
+// iterate over all reads in eRSMHitMatch order by merging the spilled runs
+int
+CKAligner::StreamAlignReads(int MinEditDist,	// any matches must have at least this edit distance to the next best match
+				int PCRPrimerCorrect,		// correct substitutions in 5' 12bp until overall sub rate within MaxSubs
+				int MinFlankExacts,			// trim matched reads on 5' and 3' flanks until at least this number of exactly matching bases in flanks
+				int NumIncludeChroms,		// number of chromosome regular expressions to include
+				int NumExcludeChroms)		// number of chromosome expressions to exclude
+{
+int Rslt;
+int ChunkID;
+bool bMoreChunks;
+
+sprintf(m_szStreamSpillFile,"%s.spill.tmp",m_pszOutFile);
+#ifdef _WIN32
+m_hStreamSpillFile = open(m_szStreamSpillFile,( _O_RDWR | _O_BINARY | _O_CREAT | _O_TRUNC),(_S_IREAD | _S_IWRITE) );
+#else
+if((m_hStreamSpillFile = open(m_szStreamSpillFile,O_RDWR | O_CREAT,S_IREAD | S_IWRITE))!=-1)
+	if(ftruncate(m_hStreamSpillFile,0)!=0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to truncate spill file %s - %s",m_szStreamSpillFile,strerror(errno));
+		close(m_hStreamSpillFile);
+		m_hStreamSpillFile = -1;
+		}
+#endif
+if(m_hStreamSpillFile < 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"StreamAlignReads: unable to create/truncate spill file '%s'",m_szStreamSpillFile);
+	Rslt = eBSFerrCreateFile;
+	}
+else
+	{
+	if((m_pStreamSpillBuff = new uint8_t [cStreamSpillBuffSize]) == nullptr)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"StreamAlignReads: unable to allocate memory for spill buffer");
+		Rslt = eBSFerrMem;
+		}
+	else
+		Rslt = eBSFSuccess;
+	}
+m_StreamSpillOfs = 0;
+m_StreamSpillBuffIdx = 0;
+m_StreamMaxRecLen = 0;
+
+ChunkID = 0;
+bMoreChunks = Rslt >= eBSFSuccess;
+while(bMoreChunks)
+	{
+	ChunkID += 1;
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Streaming: aligning reads in chunk %d...",ChunkID);
+	if((Rslt = ProcessLoadedReads(MinEditDist,-1,PCRPrimerCorrect,MinFlankExacts,NumIncludeChroms,NumExcludeChroms)) < eBSFSuccess)
+		break;
+	if((Rslt = SpillStreamRun()) < eBSFSuccess)
+		break;
+	bMoreChunks = m_bStreamChunkLoaded;	// reads loader is waiting to continue loading if more chunks
+	if(bMoreChunks)
+		ResumeStreamLoading();
+	}
+
+if(Rslt >= eBSFSuccess)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Streaming: %d chunks containing %u reads were aligned and spilled as sorted runs",ChunkID,m_OrigNumReadsLoaded);
+	return(StartStreamMerge());
+	}
+
+// reads loader thread may still be waiting on a chunk to be processed, require it to self-terminate
+m_TermBackgoundThreads = 1;
+#ifdef _WIN32
+if(m_hThreadLoadReads != nullptr)
+	{
+	while(WAIT_TIMEOUT == WaitForSingleObject(m_hThreadLoadReads, 5000))
+		{
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: waiting for reads load thread to terminate");
+		}
+	CloseHandle(m_hThreadLoadReads);
+	m_hThreadLoadReads = nullptr;
+	}
+#else
+if(m_ThreadLoadReadsID != 0)
+	{
+	struct timespec ts;
+	int JoinRlt;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += 5;
+	while((JoinRlt = pthread_timedjoin_np(m_ThreadLoadReadsID, nullptr, &ts)) != 0)
+		{
+		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress: waiting for reads load thread to terminate");
+		ts.tv_sec += 60;
+		}
+	m_ThreadLoadReadsID = 0;
+	}
+#endif
+return(Rslt);
+}
+
+// StreamChunkLoaded
+// Called by the reads loader thread when the current chunk of reads has been loaded
+// Aligner threads see this chunk as being all reads, loader thread then waits until the chunk has been aligned and spilled
+int
+CKAligner::StreamChunkLoaded(void)
+{
+bool bChunkLoaded;
+PublishLoadedReads(m_DataBuffOfs);
+AcquireExclusiveLock();
+m_bStreamChunkLoaded = true;
+m_bAllReadsLoaded = true;
+ReleaseExclusiveLock();
+do {
+	CUtility::SleepMillisecs(100);
+	if(m_TermBackgoundThreads)
+		return(eBSFerrInternal);
+	AcquireSerialise();
+	bChunkLoaded = m_bStreamChunkLoaded;
+	ReleaseSerialise();
 	}
-free(pReadsHitBlock);
-ReleaseSerialise();
-return(1);
+while(bChunkLoaded);
+return(eBSFSuccess);
 }
 
-// LocateRead
-tsReadHit *
-CKAligner::LocateRead(uint32_t ReadID) // Locate read with requested ReadID
+// ResumeStreamLoading
+// Called by main thread after the current chunk has been spilled, reads loader thread can continue loading into an emptied m_pReadHits
+void
+CKAligner::ResumeStreamLoading(void)
+{
+AcquireExclusiveLock();		// also serialises with the loader thread polling m_bStreamChunkLoaded
+m_StreamBaseReads = m_NumDescrReads;
+m_NumReadsLoaded = 0;
+m_LoadedReadsOfs = 0;
+m_DataBuffOfs = 0;
+m_PrevSizeOf = 0;
+m_CurReadsSortMode = eRSMReadID;
+m_bAllReadsLoaded = false;
+m_bStreamChunkLoaded = false;
+ReleaseExclusiveLock();
+}
+
+// SpillStreamRun
+// Sorts the current chunk of reads by eRSMHitMatch and appends the sorted reads as a run to the spill file
+// Paired reads are spilled as a single record containing both reads so partners remain adjacent
+int
+CKAligner::SpillStreamRun(void)
 {
 int Rslt;
-tsReadHit *pProbe;
-int Lo,Mid,Hi;	// search limits
+uint32_t Idx;
+uint32_t RecLen;
+uint32_t KeyOfs;
+uint32_t ReadSize;
+uint32_t PartnerSize;
+uint8_t *pRead;
+tsReadHit *pReadHit;
+tsReadHit *pPartner;
+tsStreamRecHdr RecHdr;
+tsStreamRun *pRun;
 
-if(m_ppReadHitsIdx == nullptr || m_AllocdReadHitsIdx < m_NumReadsLoaded)
-	return(nullptr);
+if((Rslt = SortReadHits(eRSMHitMatch,false)) < eBSFSuccess)
+	return(Rslt);
 
-Lo = 0;
-Hi = m_NumReadsLoaded-1;
-while(Hi >= Lo) {
-	Mid = (Hi + Lo)/2;
-	pProbe = m_ppReadHitsIdx[Mid];
-	Rslt = pProbe->ReadID - ReadID;
-	if(Rslt > 0)
+if(m_pStreamRuns == nullptr || m_NumStreamRuns == m_AllocdStreamRuns)
+	{
+	tsStreamRun *pRuns;
+	if((pRuns = new tsStreamRun [m_AllocdStreamRuns + cAllocStreamRuns]) == nullptr)
 		{
-		Hi = Mid - 1;
-		continue;
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"SpillStreamRun: unable to allocate memory for %d runs",m_AllocdStreamRuns + cAllocStreamRuns);
+		return(eBSFerrMem);
 		}
-	if(Rslt < 0)
+	if(m_pStreamRuns != nullptr)
 		{
-		Lo = Mid + 1;
-		continue;
+		memcpy(pRuns,m_pStreamRuns,sizeof(tsStreamRun) * m_NumStreamRuns);
+		delete []m_pStreamRuns;
 		}
-	return(pProbe);
+	m_pStreamRuns = pRuns;
+	m_AllocdStreamRuns += cAllocStreamRuns;
 	}
-return(nullptr);
-}
+pRun = &m_pStreamRuns[m_NumStreamRuns];
+memset(pRun,0,sizeof(tsStreamRun));
+pRun->StartOfs = m_StreamSpillOfs + m_StreamSpillBuffIdx;
+
+for(Idx = 0; Idx < m_NumReadsLoaded; Idx++)
+	{
+	pReadHit = m_ppReadHitsIdx[Idx];
+	ReadSize = (uint32_t)sizeof(tsReadHit) + pReadHit->ReadLen + pReadHit->DescrLen;
+	pPartner = nullptr;
+	PartnerSize = 0;
+	KeyOfs = 0;
+	pRead = (uint8_t *)pReadHit;
+	if(m_PEproc != ePEdefault)
+		{
+		if(pReadHit->PairReadID & 0x80000000)	// PE2, partner PE1 immediately precedes
+			{
+			pPartner = (tsReadHit *)((uint8_t *)pReadHit - pReadHit->PrevSizeOf);
+			PartnerSize = pReadHit->PrevSizeOf;
+			KeyOfs = PartnerSize;
+			pRead = (uint8_t *)pPartner;
+			}
+		else									// PE1, partner PE2 immediately follows
+			{
+			pPartner = (tsReadHit *)((uint8_t *)pReadHit + ReadSize);
+			PartnerSize = (uint32_t)sizeof(tsReadHit) + pPartner->ReadLen + pPartner->DescrLen;
+			}
+		}
+	RecLen = (uint32_t)sizeof(tsStreamRecHdr) + ReadSize + PartnerSize;
+	if(RecLen > m_StreamMaxRecLen)
+		m_StreamMaxRecLen = RecLen;
+	if((m_StreamSpillBuffIdx + RecLen) > cStreamSpillBuffSize)
+		if((Rslt = FlushStreamSpill()) < eBSFSuccess)
+			return(Rslt);
+	RecHdr.RecLen = RecLen;
+	RecHdr.KeyOfs = KeyOfs;
+	memcpy(&m_pStreamSpillBuff[m_StreamSpillBuffIdx],&RecHdr,sizeof(tsStreamRecHdr));
+	memcpy(&m_pStreamSpillBuff[m_StreamSpillBuffIdx + sizeof(tsStreamRecHdr)],pRead,ReadSize + PartnerSize);
+	m_StreamSpillBuffIdx += RecLen;
 
+	// reads will no longer be in memory when reporting so mark chroms with accepted alignments for the SAM/BAM header now
+	if(pReadHit->NAR == eNARAccepted && pReadHit->HitLoci.Hit.Seg[0].ChromID > 0)
+		m_pSfxArray->SetResetIdentFlags(pReadHit->HitLoci.Hit.Seg[0].ChromID,0x01,0x00);
+	}
+if((Rslt = FlushStreamSpill()) < eBSFSuccess)
+	return(Rslt);
+pRun->EndOfs = m_StreamSpillOfs;
+m_NumStreamRuns += 1;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Streaming: spilled run %d containing %u reads (%lld bytes)",m_NumStreamRuns,m_NumReadsLoaded,(long long)(pRun->EndOfs - pRun->StartOfs));
+return(eBSFSuccess);
+}
 
+// FlushStreamSpill
+// Write any buffered records to the spill file
 int
-CKAligner::AddMHitReads(uint32_t NumHits,	// number of multimatches loci in pHits
-		tsReadHit *pHits)		// pts to array of hit loci
+CKAligner::FlushStreamSpill(void)
 {
-size_t memreq;
-tsReadHit *pDstHits;
-// ensure actually processing multihits
-if(m_MLMode <= eMLrand)
-	return(0);					// silently slough these hits
+if(m_StreamSpillBuffIdx == 0)
+	return(eBSFSuccess);
+if(!CUtility::RetryWrites(m_hStreamSpillFile,m_pStreamSpillBuff,m_StreamSpillBuffIdx))
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"FlushStreamSpill: write to spill file '%s' failed - %s",m_szStreamSpillFile,strerror(errno));
+	return(eBSFerrFileAccess);
+	}
+m_StreamSpillOfs += m_StreamSpillBuffIdx;
+m_StreamSpillBuffIdx = 0;
+return(eBSFSuccess);
+}
 
-AcquireSerialiseMH();
+// StartStreamMerge
+// All runs have been spilled, releases memory used for holding the last chunk of reads and allocates the per run buffers
+// Subsequent calls to IterSortedReads() will merge reads from the spilled runs
+int
+CKAligner::StartStreamMerge(void)
+{
+int RunIdx;
+size_t BuffSize;
 
-if((m_AllocdMultiHits - m_NumMultiHits) < (NumHits+1000))	// need to realloc? -- added 1000 to provide a little safety margin
+if(m_pReadHits != nullptr)
 	{
-	memreq = (m_AllocdMultiHits + cAllocMultihits) * sizeof(tsReadHit);
 #ifdef _WIN32
-	pDstHits = (tsReadHit *) realloc(m_pMultiHits,memreq);
+	free(m_pReadHits);
 #else
-	pDstHits = (tsReadHit *)mremap(m_pMultiHits,m_AllocdMultiHitsMem,memreq,MREMAP_MAYMOVE);
-	if(pDstHits == MAP_FAILED)
-		pDstHits = nullptr;
+	if(m_pReadHits != MAP_FAILED)
+		munmap(m_pReadHits,m_AllocdReadHitsMem);
 #endif
-	if(pDstHits == nullptr)
+	m_pReadHits = nullptr;
+	m_AllocdReadHitsMem = 0;
+	}
+if(m_ppReadHitsIdx != nullptr)
+	{
+	delete []m_ppReadHitsIdx;
+	m_ppReadHitsIdx = nullptr;
+	m_AllocdReadHitsIdx = 0;
+	}
+if(m_pStreamSpillBuff != nullptr)
+	{
+	delete []m_pStreamSpillBuff;
+	m_pStreamSpillBuff = nullptr;
+	}
+
+// split half of the memory budget between the run buffers, each buffer must be able to hold at least 2 of the longest records
+BuffSize = m_StreamMemBudget / 2 / max(1,m_NumStreamRuns);
+if(BuffSize < (size_t)cMinStreamRunBuffSize)
+	BuffSize = cMinStreamRunBuffSize;
+else
+	if(BuffSize > (size_t)cMaxStreamRunBuffSize)
+		BuffSize = cMaxStreamRunBuffSize;
+if(BuffSize < (size_t)m_StreamMaxRecLen * 2)
+	BuffSize = (size_t)m_StreamMaxRecLen * 2;
+m_StreamRunBuffSize = (uint32_t)BuffSize;
+
+for(RunIdx = 0; RunIdx < m_NumStreamRuns; RunIdx++)
+	{
+	if((m_pStreamRuns[RunIdx].pBuff = new uint8_t [m_StreamRunBuffSize]) == nullptr)
 		{
-		ReleaseSerialiseMH();
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"AddMHitReads: Memory re-allocation to %zd bytes - %s",memreq,strerror(errno));
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"StartStreamMerge: unable to allocate memory for run buffers");
 		return(eBSFerrMem);
 		}
-	m_pMultiHits = pDstHits;
-	m_AllocdMultiHitsMem = memreq;
-	m_AllocdMultiHits += cAllocMultihits;
+	m_pStreamRuns[RunIdx].BuffLen = 0;
+	m_pStreamRuns[RunIdx].BuffIdx = 0;
 	}
-pDstHits = &m_pMultiHits[m_NumMultiHits];
-memmove(pDstHits,pHits,sizeof(tsReadHit) * NumHits);
-m_NumMultiHits += NumHits;
-if(NumHits == 1)
-	m_NumUniqueMultiHits += 1;
-else
-	m_NumProvMultiAligned += 1;
-ReleaseSerialiseMH();
-return((int)NumHits);
+if((m_pStreamHeap = new int [max(1,m_NumStreamRuns)]) == nullptr ||
+	(m_pStreamSlots[0] = new uint8_t [max((uint32_t)sizeof(tsStreamRecHdr),m_StreamMaxRecLen)]) == nullptr ||
+	(m_pStreamSlots[1] = new uint8_t [max((uint32_t)sizeof(tsStreamRecHdr),m_StreamMaxRecLen)]) == nullptr)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"StartStreamMerge: unable to allocate memory for merging runs");
+	return(eBSFerrMem);
+	}
+m_StreamHeapLen = 0;
+m_StreamSlot = 0;
+m_pStreamPrevCur = nullptr;
+m_pStreamPrevNxt = nullptr;
+m_StreamMergeRslt = eBSFSuccess;
+m_bStreamMerge = true;
+m_CurReadsSortMode = eRSMHitMatch;
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Streaming: merging %d sorted runs with %u byte run buffers",m_NumStreamRuns,m_StreamRunBuffSize);
+return(eBSFSuccess);
 }
 
-
-// ResetThreadedIterReads
+// ResetStream
+// Close and delete spill file, free all memory allocated for streaming
 void
-CKAligner::ResetThreadedIterReads(void) // must be called by master thread prior to worker threads calling ThreadedIterReads()
-{
-m_NumReadsProc = 0;
-m_NxtReadProcOfs = 0;
-m_ProcessingStartSecs = gStopWatch.ReadUSecs();
-}
-
-
-uint32_t		// Returns the number of reads thus far loaded and processed for alignment
-CKAligner::ApproxNumReadsProcessed(uint32_t *pNumProcessed,uint32_t *pNumLoaded)
+CKAligner::ResetStream(void)
 {
-uint32_t NumReadsProc;
-AcquireSerialise();
-NumReadsProc = m_NumReadsProc;
-if(pNumProcessed != nullptr)
-	*pNumProcessed = NumReadsProc;
-if(pNumLoaded != nullptr)
-	*pNumLoaded = m_NumReadsLoaded;
-ReleaseSerialise();
-return(NumReadsProc);
+int RunIdx;
+if(m_hStreamSpillFile != -1)
+	{
+	close(m_hStreamSpillFile);
+	m_hStreamSpillFile = -1;
+	}
+if(m_szStreamSpillFile[0] != '\0')
+	{
+	remove(m_szStreamSpillFile);
+	m_szStreamSpillFile[0] = '\0';
+	}
+if(m_pStreamRuns != nullptr)
+	{
+	for(RunIdx = 0; RunIdx < m_NumStreamRuns; RunIdx++)
+		if(m_pStreamRuns[RunIdx].pBuff != nullptr)
+			delete []m_pStreamRuns[RunIdx].pBuff;
+	delete []m_pStreamRuns;
+	m_pStreamRuns = nullptr;
+	}
+if(m_pStreamSpillBuff != nullptr)
+	{
+	delete []m_pStreamSpillBuff;
+	m_pStreamSpillBuff = nullptr;
+	}
+if(m_pStreamHeap != nullptr)
+	{
+	delete []m_pStreamHeap;
+	m_pStreamHeap = nullptr;
+	}
+if(m_pStreamSlots[0] != nullptr)
+	{
+	delete []m_pStreamSlots[0];
+	m_pStreamSlots[0] = nullptr;
+	}
+if(m_pStreamSlots[1] != nullptr)
+	{
+	delete []m_pStreamSlots[1];
+	m_pStreamSlots[1] = nullptr;
+	}
+m_bStreamReads = false;
+m_bStreamChunkLoaded = false;
+m_bStreamMerge = false;
+m_StreamMergeRslt = eBSFSuccess;
+m_StreamMemBudget = 0;
+m_StreamChunkMem = 0;
+m_StreamBaseReads = 0;
+m_StreamTotReadsLen = 0;
+m_StreamSpillOfs = 0;
+m_StreamSpillBuffIdx = 0;
+m_StreamMaxRecLen = 0;
+m_NumStreamRuns = 0;
+m_AllocdStreamRuns = 0;
+m_StreamRunBuffSize = 0;
+m_StreamHeapLen = 0;
+m_StreamSlot = 0;
+m_pStreamPrevCur = nullptr;
+m_pStreamPrevNxt = nullptr;
 }
 
-// ThreadedIterReads
-// Iterates over all reads
-// The body of this function is serialised
-bool	// returns false if no more reads avail for processing by calling thread
-CKAligner::ThreadedIterReads(tsReadsHitBlock *pRetBlock)
+// StreamRunRec
+// Returns ptr to current record in run, refilling the run buffer from the spill file if the record is not fully buffered
+// Returns nullptr if all records in run have been merged or on errors (m_StreamMergeRslt will then be set)
+tsStreamRecHdr *
+CKAligner::StreamRunRec(tsStreamRun *pRun)
 {
-uint32_t NumReadsLeft;
-uint32_t MaxReads2Proc;
-uint32_t AdjReadsPerBlock;
-tsReadHit *pCurReadHit;
-pRetBlock->NumReads = 0;
-
-AdjReadsPerBlock = cMaxReadsPerBlock;
-if(m_SampleNthRawRead > 1)
-	AdjReadsPerBlock = min((uint32_t)100,AdjReadsPerBlock/m_SampleNthRawRead);
-
-ReleaseSharedLock();
-while(1) {
-	AcquireSerialise();
-	AcquireSharedLock();
-	if(m_bAllReadsLoaded || ((m_NumReadsLoaded - m_NumReadsProc) >= (uint32_t)min(AdjReadsPerBlock,(uint32_t)pRetBlock->MaxReads)) || m_ThreadCoredApproxRslt < 0)
-		break;
+tsStreamRecHdr *pRec;
+uint32_t Remaining;
+int ReadLen;
 
-	ReleaseSharedLock();
-	ReleaseSerialise();
-#ifdef _WIN32
-	Sleep(2000);			// must have caught up to the reads loader, allow it some breathing space to parse and load some more reads...
-#else
-	sleep(2);
-#endif
+Remaining = pRun->BuffLen - pRun->BuffIdx;
+if(Remaining >= sizeof(tsStreamRecHdr))
+	{
+	pRec = (tsStreamRecHdr *)&pRun->pBuff[pRun->BuffIdx];
+	if(pRec->RecLen <= Remaining)
+		return(pRec);
 	}
-
-if(m_pReadHits == nullptr ||
-	m_ThreadCoredApproxRslt < 0 ||
-	(m_bAllReadsLoaded && (m_LoadReadsRslt != eBSFSuccess)) ||
-	m_bAllReadsLoaded && (m_NumReadsLoaded == 0 || m_NumReadsProc == m_NumReadsLoaded)) // if all reads have been loaded and all processed then time to move onto next processing phase
+if(pRun->NxtOfs >= pRun->EndOfs)
 	{
-	pRetBlock->NumReads = 0;
-	pRetBlock->pReadHits[0] = nullptr;
-	ReleaseSerialise();
-	return(false);
+	if(Remaining == 0)
+		return(nullptr);
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"StreamRunRec: truncated record in spill file '%s'",m_szStreamSpillFile);
+	m_StreamMergeRslt = eBSFerrFileAccess;
+	return(nullptr);
 	}
-
-// adjust pRetBlock->MaxReads according to the number of reads remaining and threads still processing these reads
-// idea is to maximise the number of threads still processing when most reads have been processed so that
-// the last thread processing doesn't end up with a large block of reads needing lengthly processing
-NumReadsLeft = m_NumReadsLoaded - m_NumReadsProc;
-if(NumReadsLeft < AdjReadsPerBlock/4)	// if < cMaxReadsPerBlock/4 yet to be processed then give it all to the one thread
-	MaxReads2Proc = NumReadsLeft;
-else
+if(Remaining > 0)
+	memmove(pRun->pBuff,&pRun->pBuff[pRun->BuffIdx],Remaining);
+pRun->BuffIdx = 0;
+pRun->BuffLen = Remaining;
+ReadLen = (int)min((int64_t)(m_StreamRunBuffSize - Remaining),pRun->EndOfs - pRun->NxtOfs);
+if(_lseeki64(m_hStreamSpillFile,pRun->NxtOfs,SEEK_SET) != pRun->NxtOfs ||
+	read(m_hStreamSpillFile,&pRun->pBuff[Remaining],ReadLen) != ReadLen)
 	{
-	MaxReads2Proc = min((uint32_t)pRetBlock->MaxReads,10 + (NumReadsLeft / (uint32_t)m_NumThreads));
-	// assume PE processing so ensure MaxReads2Proc is a multiple of 2
-	MaxReads2Proc &= ~0x01;
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"StreamRunRec: read from spill file '%s' failed - %s",m_szStreamSpillFile,strerror(errno));
+	m_StreamMergeRslt = eBSFerrFileAccess;
+	return(nullptr);
 	}
-MaxReads2Proc = min(MaxReads2Proc,NumReadsLeft);
-if(!m_NumReadsProc)
-	m_NxtReadProcOfs = 0;
-pCurReadHit = (tsReadHit *)((uint8_t *)m_pReadHits + m_NxtReadProcOfs);
-
-while(MaxReads2Proc)
+pRun->NxtOfs += ReadLen;
+pRun->BuffLen += ReadLen;
+pRec = (tsStreamRecHdr *)pRun->pBuff;
+if(pRun->BuffLen < sizeof(tsStreamRecHdr) || pRec->RecLen > pRun->BuffLen)
 	{
-	pRetBlock->pReadHits[pRetBlock->NumReads++] = pCurReadHit;
-	pCurReadHit = (tsReadHit *)((uint8_t *)pCurReadHit + sizeof(tsReadHit) + pCurReadHit->ReadLen + pCurReadHit->DescrLen);
-	MaxReads2Proc -= 1;
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"StreamRunRec: inconsistent record in spill file '%s'",m_szStreamSpillFile);
+	m_StreamMergeRslt = eBSFerrFileAccess;
+	return(nullptr);
 	}
-
-m_NumReadsProc += pRetBlock->NumReads;
-m_NxtReadProcOfs = (size_t)((uint8_t *)pCurReadHit - (uint8_t *)m_pReadHits);
-
-ReleaseSerialise();
-return(true);
+return(pRec);
 }
 
+// StreamRunLess
+// Returns true if the current read in RunA sorts before the current read in RunB, ties are resolved by run order
+bool
+CKAligner::StreamRunLess(int RunA, int RunB)
+{
+int Cmp;
+tsStreamRecHdr *pRecA = (tsStreamRecHdr *)&m_pStreamRuns[RunA].pBuff[m_pStreamRuns[RunA].BuffIdx];
+tsStreamRecHdr *pRecB = (tsStreamRecHdr *)&m_pStreamRuns[RunB].pBuff[m_pStreamRuns[RunB].BuffIdx];
+tsReadHit *pReadA = (tsReadHit *)((uint8_t *)pRecA + sizeof(tsStreamRecHdr) + pRecA->KeyOfs);
+tsReadHit *pReadB = (tsReadHit *)((uint8_t *)pRecB + sizeof(tsStreamRecHdr) + pRecB->KeyOfs);
+if((Cmp = SortHitMatch(&pReadA,&pReadB)) != 0)
+	return(Cmp < 0);
+return(RunA < RunB);
+}
 
-// IterReads
-// use to iterate over reads returning ptr to next read following the current read
-// Reads need not be sorted
-// To start from first read then pass in nullptr as pCurReadHit
-// Returns nullptr if all read hits have been iterated
-tsReadHit *
-CKAligner::IterReads(tsReadHit *pCurReadHit) // to start from first read then pass in nullptr as pCurReadHit
+// StreamHeapDown
+// Restore min-heap ordering of m_pStreamHeap from HeapIdx
+void
+CKAligner::StreamHeapDown(int HeapIdx)
 {
-tsReadHit *pNxtReadHit = nullptr;
-if(pCurReadHit == nullptr)
-	pNxtReadHit = m_pReadHits;
-else
-	if(pCurReadHit->ReadID != m_FinalReadID)
-		pNxtReadHit = (tsReadHit *)((uint8_t *)pCurReadHit + sizeof(tsReadHit) + pCurReadHit->ReadLen + pCurReadHit->DescrLen);
-return(pNxtReadHit);
+int ChildIdx;
+int RunIdx = m_pStreamHeap[HeapIdx];
+while((ChildIdx = (HeapIdx * 2) + 1) < m_StreamHeapLen)
+	{
+	if((ChildIdx + 1) < m_StreamHeapLen && StreamRunLess(m_pStreamHeap[ChildIdx + 1],m_pStreamHeap[ChildIdx]))
+		ChildIdx += 1;
+	if(!StreamRunLess(m_pStreamHeap[ChildIdx],RunIdx))
+		break;
+	m_pStreamHeap[HeapIdx] = m_pStreamHeap[ChildIdx];
+	HeapIdx = ChildIdx;
+	}
+m_pStreamHeap[HeapIdx] = RunIdx;
 }
 
-// IterSortedReads
-// use to iterate over sorted reads returning ptr to next read following the current read
-// To start from first read then pass in nullptr as pCurReadHit
-// Returns nullptr if all read hits have been iterated
+// IterMergedReads
+// Iterates over reads merged from the spilled runs in eRSMHitMatch order
+// Returned reads are copied alternately into one of two slots so the read passed in as pCurReadHit remains valid
+// If called again with the same pCurReadHit, as when looking ahead, then the previously returned read is returned
 tsReadHit *
-CKAligner::IterSortedReads(tsReadHit *pCurReadHit)
+CKAligner::IterMergedReads(tsReadHit *pCurReadHit) // to start from first read then pass in nullptr as pCurReadHit
 {
-tsReadHit *pNxtReadHit = nullptr;
-if(pCurReadHit == nullptr)
-	pNxtReadHit = m_ppReadHitsIdx[0];
+int RunIdx;
+int HeapIdx;
+tsStreamRun *pRun;
+tsStreamRecHdr *pRec;
+uint8_t *pSlot;
+tsReadHit *pNxtReadHit;
+
+if(pCurReadHit == nullptr)		// restarting from first read
+	{
+	m_StreamHeapLen = 0;
+	for(RunIdx = 0; RunIdx < m_NumStreamRuns; RunIdx++)
+		{
+		pRun = &m_pStreamRuns[RunIdx];
+		pRun->NxtOfs = pRun->StartOfs;
+		pRun->BuffLen = 0;
+		pRun->BuffIdx = 0;
+		if(StreamRunRec(pRun) != nullptr)
+			m_pStreamHeap[m_StreamHeapLen++] = RunIdx;
+		}
+	for(HeapIdx = (m_StreamHeapLen / 2) - 1; HeapIdx >= 0; HeapIdx--)
+		StreamHeapDown(HeapIdx);
+	}
 else
-	if(pCurReadHit->ReadHitIdx < m_NumReadsLoaded)
-		pNxtReadHit = m_ppReadHitsIdx[pCurReadHit->ReadHitIdx];
+	if(pCurReadHit == m_pStreamPrevCur)
+		return(m_pStreamPrevNxt);
+
+if(m_StreamMergeRslt < eBSFSuccess || m_StreamHeapLen == 0)
+	pNxtReadHit = nullptr;
+else
+	{
+	pRun = &m_pStreamRuns[m_pStreamHeap[0]];
+	pRec = (tsStreamRecHdr *)&pRun->pBuff[pRun->BuffIdx];
+	m_StreamSlot ^= 0x01;
+	pSlot = m_pStreamSlots[m_StreamSlot];
+	memcpy(pSlot,pRec,pRec->RecLen);
+	pRun->BuffIdx += pRec->RecLen;
+	if(StreamRunRec(pRun) == nullptr)		// run completely merged
+		m_pStreamHeap[0] = m_pStreamHeap[--m_StreamHeapLen];
+	if(m_StreamHeapLen > 1)
+		StreamHeapDown(0);
+	pRec = (tsStreamRecHdr *)pSlot;
+	pNxtReadHit = (tsReadHit *)(pSlot + sizeof(tsStreamRecHdr) + pRec->KeyOfs);
+	}
+m_pStreamPrevCur = pCurReadHit;
+m_pStreamPrevNxt = pNxtReadHit;
 return(pNxtReadHit);
 }
 
@@ -10821,6 +11551,14 @@ CKAligner::SortReadHits(etReadsSortMode SortMode,		// sort mode required
 tsReadHit *pReadHit;
 uint32_t Idx;
 
+if(m_bStreamMerge)		// when merging spilled runs then reads can only be iterated in the order the runs were sorted
+	{
+	if(SortMode == eRSMHitMatch)
+		return(eBSFSuccess);
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"SortReadHits: streamed reads can only be iterated in eRSMHitMatch order");
+	return(eBSFerrInternal);
+	}
+
 if(!bForce && SortMode == m_CurReadsSortMode && m_ppReadHitsIdx != nullptr && m_AllocdReadHitsIdx >= m_NumReadsLoaded)
 	return(eBSFSuccess);					// if already in requested mode
 
@@ -10859,15 +11597,20 @@ else
 		}
 	}
 
+// radix sorting needs working memory, if unable to allocate then fall back to qsort
 switch(SortMode) {
 	case eRSMReadID:
-		m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortReadIDs);
+		if(m_MTRadixSort.Sort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),RadixKeyReadID) < eBSFSuccess)
+			m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortReadIDs);
 		break;
 	case eRSMPairReadID:
-		m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortPairReadIDs);
+		if(m_MTRadixSort.Sort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),RadixKeyPairReadID) < eBSFSuccess)
+			m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortPairReadIDs);
 		break;
-	case eRSMHitMatch:
-		m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortHitMatch);
+	case eRSMHitMatch:			// radix sort is stable so sort on least significant key first
+		if(m_MTRadixSort.Sort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),RadixKeyHitMatchLoci) < eBSFSuccess ||
+			m_MTRadixSort.Sort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),RadixKeyHitMatch) < eBSFSuccess)
+			m_mtqsort.qsort(m_ppReadHitsIdx,m_NumReadsLoaded,sizeof(tsReadHit *),SortHitMatch);
 		break;
 
 	case eRSMPEHitMatch:
@@ -10891,6 +11634,51 @@ return(eBSFSuccess);
 }
 
 
+// RadixKeyReadID
+// Radix sort key for ascending read identifiers
+uint64_t
+CKAligner::RadixKeyReadID(const void *pEl)
+{
+return((*(tsReadHit **)pEl)->ReadID);
+}
+
+// RadixKeyPairReadID
+// Radix sort key for ascending PairReadID identifiers with the 5' read before the 3' read
+uint64_t
+CKAligner::RadixKeyPairReadID(const void *pEl)
+{
+tsReadHit *pReadHit = *(tsReadHit **)pEl;
+return(((uint64_t)(pReadHit->PairReadID & 0x7fffffff) << 1) | (pReadHit->PairReadID >> 31));
+}
+
+// RadixKeyHitMatch
+// Most significant radix sort key for SortHitMatch ordering: NAR in bits 63..58, NumHits as 1,0,2,3.. in bits 57..42, chrom in bits 41..10
+// Chrom is only keyed for reads with a single hit, reads with other than a single hit are ordered only by NAR and NumHits
+uint64_t
+CKAligner::RadixKeyHitMatch(const void *pEl)
+{
+tsReadHit *pReadHit = *(tsReadHit **)pEl;
+uint64_t Key;
+Key = (uint64_t)(pReadHit->NAR & 0x3f) << 58;
+if(pReadHit->NumHits != 1)
+	return(Key | ((uint64_t)(pReadHit->NumHits == 0 ? 1 : (uint16_t)pReadHit->NumHits) << 42));
+return(Key | ((uint64_t)pReadHit->HitLoci.Hit.Seg[0].ChromID << 10));
+}
+
+// RadixKeyHitMatchLoci
+// Least significant radix sort key for SortHitMatch ordering of reads with a single hit: loci in bits 63..32, length in bits 31..16, strand in bits 15..8, LowMMCnt in bits 7..0
+uint64_t
+CKAligner::RadixKeyHitMatchLoci(const void *pEl)
+{
+tsReadHit *pReadHit = *(tsReadHit **)pEl;
+if(pReadHit->NumHits != 1)
+	return(0);
+return(((uint64_t)AdjStartLoci(&pReadHit->HitLoci.Hit.Seg[0]) << 32) |
+		((uint64_t)min(AdjHitLen(&pReadHit->HitLoci.Hit.Seg[0]),(uint32_t)0x0ffff) << 16) |
+		((uint64_t)pReadHit->HitLoci.Hit.Seg[0].Strand << 8) |
+		(uint64_t)(uint8_t)(pReadHit->LowMMCnt + 128));
+}
+
 // SortReadIDs
 // Sort reads by ascending read identifiers
 int
@@ -11384,6 +12172,7 @@ m_FileHdr.Trim3 = m_Trim3;
 m_pReadHits = nullptr;
 m_AllocdReadHitsMem = 0;
 m_NumReadsLoaded = 0;
+m_LoadedReadsOfs = 0;
 m_UsedReadHitsMem = 0;
 m_FinalReadID = 0;
 m_NumDescrReads = 0;
@@ -11487,8 +12276,9 @@ m_FileHdr.NumRds = m_NumDescrReads;
 m_FileHdr.OrigNumReads = m_NumDescrReads;
 m_FileHdr.TotReadsLen = m_DataBuffOfs;
 m_FinalReadID = m_NumDescrReads;
-m_NumReadsLoaded = m_NumDescrReads;
-m_LoadReadsRslt = m_NumReadsLoaded > 0 ? eBSFSuccess : eBSFerrNoEntries;
+m_NumReadsLoaded = m_NumDescrReads - m_StreamBaseReads;
+m_LoadedReadsOfs = m_DataBuffOfs;
+m_LoadReadsRslt = m_NumDescrReads > 0 ? eBSFSuccess : eBSFerrNoEntries;
 m_bAllReadsLoaded = true;
 *pRslt = Rslt;
 ReleaseExclusiveLock();
@@ -11590,13 +12380,12 @@ uint32_t RptDiff = 250000;
 if(m_SampleNthRawRead > 1)
 	RptDiff = 1 + (RptDiff/m_SampleNthRawRead);
   
-if((!bPEProcessing || (bPEProcessing && bIsPairRead)) && m_NumDescrReads > 0 && (m_NumDescrReads - m_NumReadsLoaded) >= RptDiff)
-	{
-	AcquireSerialise();
-	m_FinalReadID = m_NumDescrReads;
-	m_NumReadsLoaded = m_NumDescrReads;
-	ReleaseSerialise();
-	}
+if((!bPEProcessing || (bPEProcessing && bIsPairRead)) && m_NumDescrReads > 0 && (m_NumDescrReads - m_StreamBaseReads - m_NumReadsLoaded) >= RptDiff)
+	PublishLoadedReads(m_DataBuffOfs);
+
+// if streaming and the current chunk is full then wait for the chunk to be aligned and spilled before continuing, paired reads are never split over chunks
+if(m_bStreamReads && (!bPEProcessing || bIsPairRead) && m_DataBuffOfs >= m_StreamChunkMem)
+	return(StreamChunkLoaded());
 return(eBSFSuccess);
 }
 
@@ -11727,7 +12516,7 @@ if(bIsPairReads)
 uint32_t PairReadID;
 
 PairReadID = (m_NumDescrReads/2) + 1;				// if bIsPairReads then start paired reads identifiers from this value and increment after each read processed
-if((Rslt=(teBSFrsltCodes)PE1Fasta.Open(pszPE1File,true))!=eBSFSuccess)
+if((Rslt=(teBSFrsltCodes)PE1Fasta.Open(pszPE1File,true,cMaxStageBuffSize,m_NumThreads))!=eBSFSuccess)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Load: Unable to open '%s' [%s] %s",pszPE1File,PE1Fasta.ErrText((teBSFrsltCodes)Rslt),PE1Fasta.GetErrMsg());
 	return(Rslt);
@@ -11753,7 +12542,7 @@ bIsFastq = PE1Fasta.IsFastq();
 
 if(bIsPairReads)	
 	{
-	if((Rslt=(teBSFrsltCodes)PE2Fasta.Open(pszPE2File,true))!=eBSFSuccess)
+	if((Rslt=(teBSFrsltCodes)PE2Fasta.Open(pszPE2File,true,cMaxStageBuffSize,m_NumThreads))!=eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Load: Unable to open '%s' [%s] %s",pszPE2File,PE2Fasta.ErrText((teBSFrsltCodes)Rslt),PE2Fasta.GetErrMsg());
 		PE1Fasta.Close();
@@ -12375,10 +13164,7 @@ delete[]pszPE2QualBuff;
 if(m_TermBackgoundThreads != 0)	// need to immediately self-terminate?
 	return(eBSErrSession);
 
-AcquireSerialise();
-m_FinalReadID = m_NumDescrReads;
-m_NumReadsLoaded = m_NumDescrReads;
-ReleaseSerialise();
+PublishLoadedReads(m_DataBuffOfs);
 
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"LoadReads: Total of %1.9d reads parsed and loaded from %s",PE1NumReadsAccepted,pszPE1File);
 if(PE1NumInvalValues > 0)
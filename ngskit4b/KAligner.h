@@ -81,6 +81,8 @@ const int cMaxMultiHits = 500;			// user can specify at most this many multihits
 const int cMaxAllHits = 100000;			// but if reporting all multihit loci then limit is increased to this value
 
 const int cAllocMultihits = 25000000;		// alloc/realloc for multihit loci in this many instance increments
+const size_t cThreadMultiAllArena = 0x01000000;	// each aligner thread buffers up to this many bytes of all multiloci alignments before merging into m_pMultiAll
+const uint32_t cThreadMHReads = 10000;		// each aligner thread buffers up to this many multihit reads before merging into m_pMultiHits
 const int cDfltReadLen = 200;			 // assume reads plus descriptors combined of of this length - not critical as actual read lengths are processed
 const size_t cReadsHitReAlloc = 50000000; // realloc allocation to hold this many read instances
 
@@ -106,6 +108,13 @@ const int cReadHitBuffLen = 0xfffff;		// sets per thread buffer size for holding
 const size_t cDataBuffAlloc = 0x0ffffffff;	// alloc to hold reads in this byte sized increments
 const int cRdsBuffAlloc =   0x07fffff;		// alloc to hold preprocessed reads (for stats) in this byte sized allocation
 
+const int cMinStreamMemMB = 256;			// streaming alignment memory budget must be at least this many MB
+const int cMaxStreamMemMB = 0x0fffffff;		// streaming alignment memory budget can be at most this many MB
+const int cStreamSpillBuffSize = 0x0ffffff;	// sorted runs are written to the spill file through a buffer of this size
+const int cMinStreamRunBuffSize = 0x010000;	// when merging sorted runs each run is read through a buffer of at least this size
+const int cMaxStreamRunBuffSize = 0x0400000;	// and at most this size
+const int cAllocStreamRuns = 256;			// allocate for spilled sorted runs in this many increments
+
 const int cMaxKADescrLen = 128;				// allow for descriptors of upto this length
 
 const unsigned int cMinSeqLen = 15;			// sequences must be at least this length otherwise user is warned and sequence sloughed
@@ -424,6 +433,13 @@ typedef struct TAG_sThreadMatchPars {
 	tsReadHit HitReads[cMaxMultiHits];	// each multihit read treated as if a separate duplicated read as may have been trimmed etc to achieve the match	
 	int MultiHitDist[cMaxMultiHits];	// used to record the multihit distribution
 	tsHitLoci *pMultiHits;				// allocated to hold read multihit loci
+	uint8_t *pMultiAll;					// thread local arena of all multiloci alignments, merged into m_pMultiAll when full and when thread completes
+	size_t MultiAllOfs;					// offset in pMultiAll at which to append next alignment
+	uint32_t NumMultiAll;				// number of alignments in pMultiAll
+	tsReadHit *pMHReads;				// thread local multihit reads, merged into m_pMultiHits when full and when thread completes
+	uint32_t NumMHReads;				// number of multihit reads in pMHReads
+	uint32_t NumUniqueMHReads;			// number of reads added to pMHReads with a single hit
+	uint32_t NumProvMHAligned;			// number of reads added to pMHReads with multiple hits
 } tsThreadMatchPars;
 
 typedef struct TAG_sClusterThreadPars {
@@ -457,28 +473,37 @@ typedef struct TAG_sLoadReadsThreadPars {
 } tsLoadReadsThreadPars;
 
 
+// each chunk of reads, when streaming, is spilled as a run of records sorted by eRSMHitMatch
+// records contain a single read if SE, both reads of the pair if PE so that partner reads are adjacent as when in m_pReadHits
+typedef struct TAG_sStreamRecHdr {
+	uint32_t RecLen;		// record length including this header
+	uint32_t KeyOfs;		// offset, following this header, of the read which was sorted; is non-zero if read is PE2 preceded by PE1 partner
+} tsStreamRecHdr;
+
+typedef struct TAG_sStreamRun {
+	int64_t StartOfs;		// run starts at this offset in spill file
+	int64_t EndOfs;			// run ends immediately before this offset
+	int64_t NxtOfs;			// next offset to read from when refilling pBuff
+	uint8_t *pBuff;			// buffered records from this run
+	uint32_t BuffLen;		// pBuff currently holds this many bytes
+	uint32_t BuffIdx;		// current record starts at this offset in pBuff
+} tsStreamRun;
+
 typedef struct TAG_sReadsHitBlock {
 	int NumReads;			// number of reads for processing in this block
 	int MaxReads;			// block can hold at most this number of reads
 	tsReadHit *pReadHits[cMaxReadsPerBlock]; // reads for processing
 } tsReadsHitBlock;
 
+// one instance per work pool worker, pairs are processed in chunks with outputs accumulated over all chunks processed by that worker
 typedef struct TAG_sPEThreadPars {
-	int ThreadIdx;					// uniquely identifies this thread
+	int ThreadIdx;					// uniquely identifies this worker
 	void *pThis;					// will be initialised to pt to CKAligner instance
 
-#ifdef _WIN32
-	HANDLE threadHandle;			// handle as returned by _beginthreadex()
-	unsigned int threadID;			// identifier as set by _beginthreadex()
-#else
-	int threadRslt;					// result as returned by pthread_create ()
-	pthread_t threadID;				// identifier as set by pthread_create ()
-#endif
-
 	// input parameters
 	etPEproc PEproc; // paired reads alignment processing mode
-	uint32_t StartPairIdx;	// start pair processing from this pair in m_ppReadHitsIdx
-	uint32_t NumPairsToProcess;	// process this number of pairs
+	uint32_t StartPairIdx;	// current chunk starts pair processing from this pair in m_ppReadHitsIdx
+	uint32_t NumPairsToProcess;	// current chunk has this number of pairs
 	int MinEditDist; // accepted alignments must be at least this Hamming away from other putative alignments
 	int PairMinLen;  // only accept paired reads with a combined sequence length of at least this
 	int PairMaxLen;  // only accept paired reads with a combined sequence length of no more than this
@@ -521,6 +546,7 @@ class CKAligner
 {
 	bool m_bPackedBaseAlleles;		// if true then processing is for packed base alleles only, no SNP calling
 	CMTqsort m_mtqsort;				// multi-threaded qsort
+	CMTRadixSort m_MTRadixSort;		// multi-threaded radix sort, reads are sorted on keys extracted once per read rather than compared with a qsort comparison function
 
 	CContaminants *m_pContaminants; // for use when trimming reads containing contaminants
 
@@ -538,10 +564,36 @@ class CKAligner
 	size_t m_AllocdReadHitsMem;		// how many bytes of memory  for reads have been allocated
 	size_t m_UsedReadHitsMem;		// how many bytes of allocated reads memory is currently used
 	uint32_t m_NumReadsLoaded;		// m_pReadHits contains this many reads
+	size_t m_LoadedReadsOfs;		// byte offset in m_pReadHits immediately following the last of the m_NumReadsLoaded reads
 	uint32_t m_OrigNumReadsLoaded;	// if multiloci read alignments being treated as if each was a separate read then this is a copy of m_NumReadsLoaded prior to overwriting with the multiloci read count 
 	uint32_t m_FinalReadID;			// final read identifier loaded as a preprocessed read (tsProcRead)
 	uint32_t m_PrevSizeOf;			// size (uint8_t's) of the previously loaded tsReadHit - allows easy referencing of partner pairs
 
+	bool m_bStreamReads;			// true if reads are being loaded and aligned in chunks bounded by m_StreamChunkMem with each chunk spilled as a sorted run
+	size_t m_StreamMemBudget;		// streaming memory budget in bytes
+	size_t m_StreamChunkMem;		// reads loader completes the current chunk when loaded reads exceed this many bytes
+	volatile bool m_bStreamChunkLoaded;	// set by reads loader when a chunk has been loaded, loader waits until reset by ResumeStreamLoading()
+	uint32_t m_StreamBaseReads;		// number of reads loaded in all chunks prior to the current chunk
+	size_t m_StreamTotReadsLen;		// total length of all reads aligned in all chunks
+	char m_szStreamSpillFile[_MAX_PATH]; // sorted runs are spilled to this temp file
+	int m_hStreamSpillFile;			// opened spill file handle
+	int64_t m_StreamSpillOfs;		// next run will be spilled starting at this file offset
+	uint8_t *m_pStreamSpillBuff;	// buffers writes to spill file
+	uint32_t m_StreamSpillBuffIdx;	// number of bytes currently in m_pStreamSpillBuff
+	uint32_t m_StreamMaxRecLen;		// longest spilled record
+	int m_NumStreamRuns;			// number of spilled runs
+	int m_AllocdStreamRuns;			// m_pStreamRuns allocated to hold this many runs
+	tsStreamRun *m_pStreamRuns;		// spilled runs
+	uint32_t m_StreamRunBuffSize;	// each run is read through a buffer of this size when merging
+	bool m_bStreamMerge;			// true if IterSortedReads() is iterating reads merged from the spilled runs
+	int m_StreamMergeRslt;			// < 0 if errors whilst merging
+	int m_StreamHeapLen;			// number of runs with records still to be merged
+	int *m_pStreamHeap;				// min-heap of run indexes ordered by each run's current record
+	uint8_t *m_pStreamSlots[2];		// merged records are copied alternately into these slots so the previously returned read remains valid
+	int m_StreamSlot;				// slot most recently copied into
+	tsReadHit *m_pStreamPrevCur;	// IterSortedReads() was previously called with this read
+	tsReadHit *m_pStreamPrevNxt;	// and returned this read
+
 	tsReadHit **m_ppReadHitsIdx;	// memory allocated to hold array of ptrs to read hits in m_pReadHits - usually sorted by some critera
 	uint32_t m_AllocdReadHitsIdx;		// how many elements for m_pReadHitsIdx have been allocated
 	etReadsSortMode	m_CurReadsSortMode;	// sort mode last used on m_ppReadHitsIdx
@@ -652,7 +704,7 @@ class CKAligner
 	int m_hDiSNPfile;       // file handle used if DiSNPs are being processed
 	int m_hTriSNPfile;       // file handle used if TriSNPs are being processed
 	int m_hWIGSpansFile;	 // file handle used if coverage segment spans are being processed (WIG format)
-	int m_hPackedBaseAllelesFile;	 // file handle used when loci base classification binary file is being generated
+	CPBAfile *m_pPBAFile;	 // used when loci base classification (PBA) binary file is being generated
 	int m_hSNPCentsfile;	// file handle used if SNP centroids are being processed
 
 	gzFile m_gzOutFile;			// results output when compressing the output as gzip
@@ -762,9 +814,9 @@ class CKAligner
 
 	CUtility m_RegExprs;            // regular expression processing
 
-	uint32_t m_NumReadsProc;		// number of reads thus far processed - note this is total reads handed out to processing threads
+	volatile uint32_t m_NumReadsProc;		// number of reads thus far processed - note this is total reads handed out to processing threads
 								// and should be treated as a guide only
-	size_t m_NxtReadProcOfs;	// byte offset into m_pReadHits of next read to be processed
+	volatile size_t m_NxtReadProcOfs;	// byte offset into m_pReadHits of next read to be processed, threads claim blocks of reads by CAS on this cursor
 
 	bool m_bBisulfite;			// true if bisulfite methylation patterning processing
 	bool m_bIsSOLiD;			// true if SOLiD or colorspace processing
@@ -779,6 +831,7 @@ class CKAligner
 	uint8_t m_TermBackgoundThreads; // if non-zero then all background threads are to immediately terminate processing
 
 	int m_ThreadLoadReadsRslt;
+	tsLoadReadsThreadPars m_LoadReadsThreadPars;	// reads loader thread parameters, must outlive InitiateLoadingReads() as loader thread continues loading (streaming waits between chunks)
 
 	uint32_t m_CurClusterFrom;
 
@@ -971,7 +1024,12 @@ class CKAligner
 
 	int AssignMultiMatches(void); // false to cluster with uniques, true to cluster with multimatches
 
-	int AddMultiHit(tsReadHit *pReadHit);
+	int AddMultiHit(tsThreadMatchPars *pPars,	// thread buffering the alignment
+				tsReadHit *pReadHit);			// alignment to buffer
+
+	int MergeThreadMultiAll(tsThreadMatchPars *pPars);	// merge thread buffered all multiloci alignments into m_pMultiAll
+	int MergeThreadMHReads(tsThreadMatchPars *pPars);	// merge thread buffered multihit reads into m_pMultiHits
+	int MergeThreadHits(tsThreadMatchPars *pPars);		// merge all thread buffered hits and free thread buffers
 
 	int AddEntry(bool bPEProcessing,	// true if entries are from a PE dataset, false if SE dataset
 			bool bIsPairRead,		// true if this is the paired read PE2
@@ -1011,9 +1069,41 @@ class CKAligner
 
 	tsReadHit *LocateRead(uint32_t ReadID);	 // Locate read with requested ReadID
 
-	int AddMHitReads(uint32_t NumHits,		// number of multimatches loci in pHits
+	int AddMHitReads(tsThreadMatchPars *pPars,	// thread buffering the multimatches
+		uint32_t NumHits,		// number of multimatches loci in pHits
 		tsReadHit *pHits);					// pts to array of hit loci
 
+	void PublishLoadedReads(size_t LoadedOfs);	// make reads loaded up to m_NumDescrReads, ending at byte offset LoadedOfs, available to aligner threads
+
+	int ProcessLoadedReads(int MinEditDist,	// any matches must have at least this edit distance to the next best match
+				int PCRartefactWinLen,		// if >= 0 then window size to use when attempting to reduce the number of  PCR differential amplification artefacts
+				int PCRPrimerCorrect,		// correct substitutions in 5' 12bp until overall sub rate within MaxSubs
+				int MinFlankExacts,			// trim matched reads on 5' and 3' flanks until at least this number of exactly matching bases in flanks
+				int NumIncludeChroms,		// number of chromosome regular expressions to include
+				int NumExcludeChroms);		// number of chromosome expressions to exclude
+
+	// streaming alignment - reads are loaded, aligned and spilled as sorted runs in chunks, sorted reads are then iterated by merging the runs
+	int StreamAlignReads(int MinEditDist,	// any matches must have at least this edit distance to the next best match
+				int PCRPrimerCorrect,		// correct substitutions in 5' 12bp until overall sub rate within MaxSubs
+				int MinFlankExacts,			// trim matched reads on 5' and 3' flanks until at least this number of exactly matching bases in flanks
+				int NumIncludeChroms,		// number of chromosome regular expressions to include
+				int NumExcludeChroms);		// number of chromosome expressions to exclude
+	int StreamChunkLoaded(void);		// called by reads loader when current chunk loaded, returns after chunk has been processed
+	void ResumeStreamLoading(void);		// called by main thread after current chunk spilled, reads loader can continue loading into an emptied m_pReadHits
+	int SpillStreamRun(void);			// spill current chunk of reads as a run sorted by eRSMHitMatch
+	int FlushStreamSpill(void);			// write any buffered spill records to spill file
+	int StartStreamMerge(void);			// all runs spilled, subsequent IterSortedReads() will merge runs
+	void ResetStream(void);				// close and delete spill file, free all streaming allocations
+	tsStreamRecHdr *StreamRunRec(tsStreamRun *pRun);	// current record in run, refilling run buffer as may be required, nullptr if run completed
+	bool StreamRunLess(int RunA, int RunB);	// true if current read in RunA sorts before current read in RunB
+	void StreamHeapDown(int HeapIdx);	// restore heap ordering from HeapIdx
+	tsReadHit *IterMergedReads(tsReadHit *pCurReadHit);	// iterate over reads merged from the sorted runs, to start from first read then pass in nullptr as pCurReadHit
+
+	int										// number of reads claimed, 0 if none available
+		ClaimReads(tsReadsHitBlock *pRetBlock,	// claimed reads returned in this block
+				uint32_t MaxReads2Proc,		// claim at most this many reads
+				size_t LoadedReadsOfs);		// reads loaded up to this byte offset are available to be claimed
+
 	int SortReadHits(etReadsSortMode SortMode,		// sort mode required
 				bool bSeqSorted = false,			// used to optimise eRSMSeq processing, if it is known that reads are already sorted in sequence order (loaded from pre-processed .rds file)
 				bool bForce = false);				// if true then force sort
@@ -1065,6 +1155,12 @@ class CKAligner
 					uint32_t *pMatchUntil);		// until this inclusive index
 
 
+	// radix sort keys, giving the same ordering as the corresponding qsort comparison functions
+	static uint64_t RadixKeyReadID(const void *pEl);
+	static uint64_t RadixKeyPairReadID(const void *pEl);
+	static uint64_t RadixKeyHitMatch(const void *pEl);		// most significant: NAR, NumHits (1,0,2,3..), chrom
+	static uint64_t RadixKeyHitMatchLoci(const void *pEl);	// least significant: loci, len, strand, LowMMCnt
+
 	static int SortReadIDs(const void *arg1, const void *arg2);
 	static int SortPairReadIDs(const void *arg1, const void *arg2);
 	static int SortPEHitMatch(const void *arg1, const void *arg2);
@@ -1141,6 +1237,7 @@ public:
 				teSAMFormat SAMFormat,			// if SAM output format then could be SAM, BAM or BAM compressed dependent on the file extension used
 				int SitePrefsOfs,				// offset read start sites when processing  octamer preferencing, range -100..100
 				int NumThreads,					// number of worker threads to use
+				int StreamMemMB,				// if > 0 then streaming alignment with loaded reads bounded by this memory budget (MB)
 				char *pszTrackTitle,			// track title if output format is UCSC BED
 				int NumPE1InputFiles,			// number of input PE1 or single ended file specs
 				char *pszPE1InputFiles[],		// names of input files (wildcards allowed unless processing paired ends) containing raw reads
@@ -84,6 +84,7 @@ KProcess(etPMode PMode,					// processing mode
 		teSAMFormat SAMFormat,			// if SAM output format then could be SAM, BAM or BAM compressed dependent on the file extension used
 		int SitePrefsOfs,				// offset read start sites when processing  octamer preferencing, range -100..100
 		int NumThreads,					// number of worker threads to use
+		int StreamMemMB,				// if > 0 then streaming alignment with loaded reads bounded by this memory budget (MB)
 		char *pszTrackTitle,			// track title if output format is UCSC BED
 		int NumPE1InputFiles,			// number of input PE1 or single ended file specs
 		char *pszPE1InputFiles[],		// names of input files (wildcards allowed unless processing paired ends) containing raw reads
@@ -137,6 +138,8 @@ teSAMFormat SAMFormat;		// if SAM output format then could be either SAM or BAM
 
 int NumberOfProcessors;		// number of installed CPUs
 int NumThreads;				// number of threads (0 defaults to number of CPUs)
+int SfxLoadMode;				// suffix array load mode: 0 - read into process memory, 1 - memory mapped, 2 - memory mapped with readahead, 3 - memory mapped and prefetched
+int StreamMemMB;			// if > 0 then streaming alignment with loaded reads bounded by this memory budget (MB)
 int Quality;				// quality scoring for fastq sequence files
 int MinEditDist;			// any matches must have at least this edit distance to the next best match
 int MaxSubs;				// maximum number of substitutions allowed per 100bp of read length
@@ -296,6 +299,8 @@ struct arg_int *minacceptreadlen = arg_int0("l","minacceptreadlen","<int>",		"af
 struct arg_int *maxacceptreadlen = arg_int0("L","maxacceptreadlen","<int>",		"after any end trimming only accept read for further processing if read is at no longer than this length (default is 500bp, range minacceptreadlen..2000)");
 
 struct arg_int* threads = arg_int0("T", "threads", "<int>", "number of processing threads 0..128 (defaults to 0 which sets threads to number of CPU cores)");
+struct arg_int* sfxmmap = arg_int0(NULL, "sfxmmap", "<int>", "suffix array loading: 0 - read into process memory, 1 - memory map shared with other processes, 2 - memory map with readahead, 3 - memory map and prefetch all (default 0)");
+struct arg_int* streammem = arg_int0(NULL, "streammem", "<int>", "streaming alignment: load and align reads in chunks bounded by this memory budget in MB, spilling sorted runs to temp files, SAM/BAM output only and not with PCR, splice, microInDel, chimeric, extended SNP codon frame shift or per sequence PE insert length processing (default 0 for all reads in memory, minimum 256)");
 
 struct arg_file *summrslts = arg_file0("q","sumrslts","<file>",		"Output results summary to this SQLite3 database file");
 struct arg_str *experimentname = arg_str0("w","experimentname","<str>",		"experiment name");
@@ -308,7 +313,7 @@ void *argtable[] = {help,version,FileLogLevel,LogFile,
 					pmode,samplenthrawread,alignstrand,minchimericlen,chimericrpt,pecircularised,peinsertlendist,microindellen,splicejunctlen,solid,pcrartefactwinlen,qual,mlmode,trim5,trim3,minacceptreadlen,maxacceptreadlen,maxmlmatches,rptsamseqsthres,clampmaxmulti,bisulfite,
 					mineditdist,maxsubs,maxns,minflankexacts,pcrprimercorrect,minsnpreads,markerlen,markerpolythres,qvalue,snpnonrefpcnt,format,title,priorityregionfile,nofiltpriority,bestmatches,
 					pe1inputfiles,peproc,pairminlen,pairmaxlen,pairstrand,pe2inputfiles,sfxfile,snpfile,centroidfile,
-					outfile,nonealignfile,multialignfile,statsfile,siteprefsfile,siteprefsofs,lociconstraintsfile,contamsfile,ExcludeChroms,IncludeChroms,threads,
+					outfile,nonealignfile,multialignfile,statsfile,siteprefsfile,siteprefsofs,lociconstraintsfile,contamsfile,ExcludeChroms,IncludeChroms,threads,sfxmmap,streammem,
 					end};
 
 char **pAllArgs;
@@ -846,6 +851,21 @@ if (!argerrors)
 		NumThreads = MaxAllowedThreads;
 		}
 
+	SfxLoadMode = sfxmmap->count ? sfxmmap->ival[0] : (int)eSfxLoadRead;
+	if(SfxLoadMode < (int)eSfxLoadRead || SfxLoadMode >= (int)eSfxLoadPlaceholder)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Suffix array load mode '--sfxmmap=%d' specified outside of range %d..%d\n",SfxLoadMode,(int)eSfxLoadRead,(int)eSfxLoadPlaceholder-1);
+		exit(1);
+		}
+	CSfxArray::SetDfltLoadMode((etSfxLoadMode)SfxLoadMode);
+
+	StreamMemMB = streammem->count ? streammem->ival[0] : 0;
+	if(StreamMemMB != 0 && (StreamMemMB < cMinStreamMemMB || StreamMemMB > cMaxStreamMemMB))
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Streaming memory budget '--streammem=%d' specified outside of range %d..%d\n",StreamMemMB,cMinStreamMemMB,cMaxStreamMemMB);
+		exit(1);
+		}
+
 	strcpy(szTargFile,sfxfile->filename[0]);
 	CUtility::TrimQuotedWhitespcExtd(szTargFile);
 	strcpy(szRsltsFile,outfile->filename[0]);
@@ -1357,6 +1377,25 @@ if (!argerrors)
 	if(szExperimentName[0] != '\0')
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"This processing reference: %s",szExperimentName);
 
+	switch(SfxLoadMode) {
+		case eSfxLoadRead:
+			pszDescr = "read into process memory";
+			break;
+		case eSfxLoadMmap:
+			pszDescr = "memory mapped";
+			break;
+		case eSfxLoadMmapWillNeed:
+			pszDescr = "memory mapped with readahead";
+			break;
+		case eSfxLoadMmapPopulate:
+			pszDescr = "memory mapped and prefetched";
+			break;
+		}
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"suffix array loading : %s",pszDescr);
+	if(StreamMemMB > 0)
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"streaming alignment memory budget : %dMB",StreamMemMB);
+	else
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"streaming alignment : no, all reads in memory");
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"number of threads : %d",NumThreads);
 
 	if(gExperimentID > 0)
@@ -1436,6 +1475,7 @@ if (!argerrors)
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTText,(int)strlen(szContamFile),"contamsfile",szContamFile);
 
 		
+		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(StreamMemMB),"streammem",&StreamMemMB);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(NumThreads),"threads",&NumThreads);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,(int)sizeof(NumberOfProcessors),"cpus",&NumberOfProcessors);
 
@@ -1454,7 +1494,7 @@ if (!argerrors)
 					MinSNPreads,QValue,SNPNonRefPcnt,MarkerLen,MarkerPolyThres,PCRartefactWinLen,(etMLMode)MLMode,
 					MaxMLmatches,bClampMaxMLmatches,bLocateBestMatches,
 					MaxNs,MinEditDist,MaxSubs,Trim5,Trim3,MinAcceptReadLen,MaxAcceptReadLen,MinFlankExacts,PCRPrimerCorrect, MaxRptSAMSeqsThres,
-					(etFMode)FMode,SAMFormat,SitePrefsOfs,NumThreads,szTrackTitle,
+					(etFMode)FMode,SAMFormat,SitePrefsOfs,NumThreads,StreamMemMB,szTrackTitle,
 					NumPE1InputFiles,pszPE1InputFiles,NumPE2InputFiles,pszPE2InputFiles,szPriorityRegionFile,bFiltPriorityRegions,szRsltsFile, szSNPFile, szMarkerFile, szSNPCentroidFile, szTargFile,
 					szStatsFile,szMultiAlignFile,szNoneAlignFile,szSitePrefsFile,szLociConstraintsFile,szContamFile,NumIncludeChroms,pszIncludeChroms,NumExcludeChroms,pszExcludeChroms);
 	Rslt = Rslt >=0 ? 0 : 1;
@@ -1514,6 +1554,7 @@ bool bBisulfite;			// if true then process for bisulfite methylation patterning
 int PCRartefactWinLen;		// if >= 0 then window size to use when attempting to reduce the number of  PCR differential amplification artefacts (reads stacking to same loci)
 int NumberOfProcessors;		// number of installed CPUs
 int NumThreads;				// number of threads (0 defaults to number of CPUs)
+int SfxLoadMode;				// suffix array load mode: 0 - read into process memory, 1 - memory mapped, 2 - memory mapped with readahead, 3 - memory mapped and prefetched
 int Quality;				// quality scoring for fastq sequence files
 int MinEditDist;			// any matches must have at least this edit distance to the next best match
 int MaxSubs;				// maximum number of substitutions allowed per 100bp of read length
@@ -1613,6 +1654,7 @@ struct arg_int *minacceptreadlen = arg_int0("l","minacceptreadlen","<int>",		"af
 struct arg_int *maxacceptreadlen = arg_int0("L","maxacceptreadlen","<int>",		"after any end trimming only accept read for further processing if read is at no longer than this length (default is 500bp, range minacceptreadlen..2000)");
 
 struct arg_int* threads = arg_int0("T", "threads", "<int>", "number of processing threads 0..128 (defaults to 0 which sets threads to number of CPU cores)");
+struct arg_int* sfxmmap = arg_int0(NULL, "sfxmmap", "<int>", "suffix array loading: 0 - read into process memory, 1 - memory map shared with other processes, 2 - memory map with readahead, 3 - memory map and prefetch all (default 0)");
 
 struct arg_str *experimentid = arg_str1("w","experimentid","<str>",		"experiment identifier");
 struct arg_str *readsetid = arg_str1("W","readsetid","<str>",			"readset identifier");
@@ -1624,7 +1666,7 @@ void *argtable[] = {help,version,FileLogLevel,LogFile,
 					pmode,samplenthrawread,alignstrand,minchimericlen,chimericrpt,solid,pcrartefactwinlen,qual,mlmode,trim5,trim3,minacceptreadlen,maxacceptreadlen,maxmlmatches,clampmaxmulti,bisulfite,
 					mineditdist,maxsubs,maxns,minflankexacts,pcrprimercorrect,title,
 					pe1inputfiles,peproc,pairminlen,pairmaxlen,pairstrand,pe2inputfiles,sfxfile,
-					outfile,contamsfile,ExcludeChroms,IncludeChroms,threads,
+					outfile,contamsfile,ExcludeChroms,IncludeChroms,threads,sfxmmap,
 					end};
 
 char **pAllArgs;
@@ -2015,6 +2057,14 @@ if (!argerrors)
 		NumThreads = MaxAllowedThreads;
 		}
 
+	SfxLoadMode = sfxmmap->count ? sfxmmap->ival[0] : (int)eSfxLoadRead;
+	if(SfxLoadMode < (int)eSfxLoadRead || SfxLoadMode >= (int)eSfxLoadPlaceholder)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Suffix array load mode '--sfxmmap=%d' specified outside of range %d..%d\n",SfxLoadMode,(int)eSfxLoadRead,(int)eSfxLoadPlaceholder-1);
+		exit(1);
+		}
+	CSfxArray::SetDfltLoadMode((etSfxLoadMode)SfxLoadMode);
+
 	strcpy(szTargFile,sfxfile->filename[0]);
 	CUtility::TrimQuotedWhitespcExtd(szTargFile);
 	strcpy(szRsltsFile,outfile->filename[0]);
@@ -2239,6 +2289,21 @@ if (!argerrors)
 	for(Idx = 0; Idx < NumExcludeChroms; Idx++)
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"reg expressions defining chroms to exclude: '%s'",pszExcludeChroms[Idx]);
 
+	switch(SfxLoadMode) {
+		case eSfxLoadRead:
+			pszDescr = "read into process memory";
+			break;
+		case eSfxLoadMmap:
+			pszDescr = "memory mapped";
+			break;
+		case eSfxLoadMmapWillNeed:
+			pszDescr = "memory mapped with readahead";
+			break;
+		case eSfxLoadMmapPopulate:
+			pszDescr = "memory mapped and prefetched";
+			break;
+		}
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"suffix array loading : %s",pszDescr);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"number of threads : %d",NumThreads);
 
 
@@ -2251,7 +2316,7 @@ if (!argerrors)
 					0,0.0,0,0,0,PCRartefactWinLen,(etMLMode)MLMode,
 					MaxMLmatches,bClampMaxMLmatches,false,
 					MaxNs,MinEditDist,MaxSubs,Trim5,Trim3,MinAcceptReadLen,MaxAcceptReadLen,MinFlankExacts,PCRPrimerCorrect, 0,
-					eFMPBA,etSAMFformat,0,NumThreads,szReadsetID,
+					eFMPBA,etSAMFformat,0,NumThreads,0,szReadsetID,
 					NumPE1InputFiles,pszPE1InputFiles,NumPE2InputFiles,pszPE2InputFiles,szEmpty,false,szRsltsFile, szEmpty, szEmpty, szEmpty, szTargFile,
 					szEmpty,szEmpty,szEmpty,szEmpty,szEmpty,szContamFile,NumIncludeChroms,pszIncludeChroms,NumExcludeChroms,pszExcludeChroms);
 	Rslt = Rslt >=0 ? 0 : 1;
@@ -2326,6 +2391,7 @@ KProcess(etPMode PMode,					// processing mode
 		teSAMFormat SAMFormat,			// if SAM output format then could be SAM, BAM or BAM compressed dependent on the file extension used
 		int SitePrefsOfs,				// offset read start sites when processing  octamer preferencing, range -100..100
 		int NumThreads,					// number of worker threads to use
+		int StreamMemMB,				// if > 0 then streaming alignment with loaded reads bounded by this memory budget (MB)
 		char *pszTrackTitle,			// track title if output format is UCSC BED
 		int NumPE1InputFiles,			// number of input PE1 or single ended file specs
 		char *pszPE1InputFiles[],		// names of input files (wildcards allowed unless processing paired ends) containing raw reads
@@ -2399,6 +2465,7 @@ Rslt = pKAligner->Align(PMode,			// processing mode
 			SAMFormat,					// if SAM output format then could be SAM, BAM or BAM compressed dependent on the file extension used
 			SitePrefsOfs,				// offset read start sites when processing  octamer preferencing, range -100..100
 			NumThreads,					// number of worker threads to use
+			StreamMemMB,				// if > 0 then streaming alignment with loaded reads bounded by this memory budget (MB)
 			pszTrackTitle,				// track title if output format is UCSC BED
 			NumPE1InputFiles,			// number of input PE1 or single ended file specs
 			pszPE1InputFiles,			// names of input files (wildcards allowed unless processing paired ends) containing raw reads
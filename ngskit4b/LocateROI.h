@@ -182,6 +182,7 @@ class CLocateROI
 				   char FiltStrand,				// only interested in distances to nearest feature which is on this strand
 				   int ROIChromID,				// ROI is on this chromosome
 				   char *pszROIChrom,			// ROI chrom name
+				   CBEDSweep *pSweep,			// sweeping features on ROI chromosome
 				   tsROI *pROI);
 
 	int 
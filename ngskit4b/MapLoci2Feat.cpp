@@ -49,6 +49,11 @@ m_pChromRegionCnts = nullptr;
 m_pBiobed = nullptr;
 m_pHypers = nullptr;
 m_pFeatCntDists = nullptr;
+m_pSweepElQueries = nullptr;
+m_pSweepQueries = nullptr;
+m_pSweepElOrder = nullptr;
+m_pSweepChromIdxs = nullptr;
+m_pSweepTasks = nullptr;
 MLFReset();
 }
 
@@ -92,6 +97,7 @@ CMapLoci2Feat::MLFReset(void)
 		delete m_pChromRegionCnts;
 		m_pChromRegionCnts = nullptr;
 	}
+	SweepReset();
 
 	m_MLFPMode = ePMdefault;
 	m_StrandProc = eStrandDflt;
@@ -102,6 +108,427 @@ CMapLoci2Feat::MLFReset(void)
 	m_NumSplitEls = 0;
 	m_bFeatinsts = false;
 	m_bOneCntRead = false;
+	m_NumThreads = 1;
+}
+
+int
+CMapLoci2Feat::SweepInit(void)
+{
+	int NumBatchEls;
+	SweepReset();
+	NumBatchEls = (int)min((uint32_t)cMLFSweepBatchEls, max(m_NumEls, (uint32_t)1));
+	m_AllocSweepTasks = m_pBiobed->GetNumChromosomes() + (NumBatchEls / cMLFSweepTaskEls) + 1;
+	if ((m_pSweepElQueries = new int[NumBatchEls]) == nullptr ||
+		(m_pSweepQueries = new tsMLFSweepQuery[NumBatchEls]) == nullptr ||
+		(m_pSweepElOrder = new tsMLFSweepQuery[NumBatchEls]) == nullptr ||
+		(m_pSweepChromIdxs = new int[m_pBiobed->GetNumChromosomes() + 2]) == nullptr ||
+		(m_pSweepTasks = new tsMLFSweepTask[m_AllocSweepTasks]) == nullptr)
+	{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to allocate memory for annotating batches of %d elements", NumBatchEls);
+		SweepReset();
+		return(eBSFerrMem);
+	}
+	memset(m_pSweepTasks, 0, sizeof(tsMLFSweepTask) * m_AllocSweepTasks);
+	return(eBSFSuccess);
+}
+
+void
+CMapLoci2Feat::SweepReset(void)
+{
+	int TaskIdx;
+	if (m_pSweepTasks != nullptr)
+	{
+		for (TaskIdx = 0; TaskIdx < m_AllocSweepTasks; TaskIdx++)
+			if (m_pSweepTasks[TaskIdx].pHits != nullptr)
+				delete[]m_pSweepTasks[TaskIdx].pHits;
+		delete[]m_pSweepTasks;
+		m_pSweepTasks = nullptr;
+	}
+	if (m_pSweepElQueries != nullptr)
+	{
+		delete[]m_pSweepElQueries;
+		m_pSweepElQueries = nullptr;
+	}
+	if (m_pSweepQueries != nullptr)
+	{
+		delete[]m_pSweepQueries;
+		m_pSweepQueries = nullptr;
+	}
+	if (m_pSweepElOrder != nullptr)
+	{
+		delete[]m_pSweepElOrder;
+		m_pSweepElOrder = nullptr;
+	}
+	if (m_pSweepChromIdxs != nullptr)
+	{
+		delete[]m_pSweepChromIdxs;
+		m_pSweepChromIdxs = nullptr;
+	}
+	m_AllocSweepTasks = 0;
+	m_NumSweepTasks = 0;
+	m_NumSweepQueries = 0;
+}
+
+// LocateBEDChromID
+// Returns BED chromosome identifier for element chromosome name
+int
+CMapLoci2Feat::LocateBEDChromID(char *pszChrom)
+{
+	int ChromID;
+
+	// some old datasets may be referencing ChrM as mitochondria, or ChrC as chloroplast
+	// so need to check for these
+	if (!stricmp(pszChrom, "chloroplast"))
+		pszChrom = (char *)"ChrC";
+	else
+		if (!stricmp(pszChrom, "mitochondria"))
+			pszChrom = (char *)"ChrM";
+
+	ChromID = m_pBiobed->LocateChromIDbyName(pszChrom);
+	if (ChromID == eBSFerrChrom)
+	{
+		if (!stricmp(pszChrom, "ChrM"))
+			ChromID = m_pBiobed->LocateChromIDbyName((char *)"mitochondria");
+		else
+			if (!stricmp(pszChrom, "ChrC"))
+				ChromID = m_pBiobed->LocateChromIDbyName((char *)"chloroplast");
+	}
+	return(ChromID < 1 ? eBSFerrChrom : ChromID);
+}
+
+// SweepBatch
+// Generates the sweep queries, with core loci dependent on processing mode, for a batch of elements
+// Queries are ordered by chromosome, retaining element ordering within each chromosome, and then partitioned into sweep tasks
+int
+CMapLoci2Feat::SweepBatch(uint32_t BatchElID,	// partition batch of elements starting with this element
+						  int NumBatchEls)		// and containing this many elements into per chromosome sweep tasks
+{
+	uint32_t ElID;
+	int NumBEDChroms;
+	int PrevChromID;
+	int ChromID;
+	int QueryIdx;
+	int ChromIdx;
+	int NumChromQueries;
+	char Strand;
+	char *pszChrom;
+	tsHyperElement *pEl;
+	tsMLFSweepQuery *pQuery;
+	tsMLFSweepTask *pTask;
+
+	NumBEDChroms = m_pBiobed->GetNumChromosomes();
+	memset(m_pSweepChromIdxs, 0, sizeof(int) * (NumBEDChroms + 2));
+	m_NumSweepQueries = 0;
+	m_NumSweepTasks = 0;
+	PrevChromID = -1;
+	ChromID = eBSFerrChrom;
+	for (ElID = BatchElID; ElID < BatchElID + NumBatchEls; ElID++)
+	{
+		pEl = m_pHypers->GetElement(ElID);
+		if (pEl == nullptr)
+		{
+			gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to get details for element: %d", ElID);
+			return(eBSFerrInternal);
+		}
+
+		// if only associating the actual start loci, and if a split element then need to process first if element on '+' and last if element on '-' strand
+		if (m_MLFPMode == ePMstarts && pEl->SplitElement == 1 &&
+			((pEl->PlusStrand == 1 && pEl->SplitFirst != 1) || (pEl->PlusStrand == 0 && pEl->SplitLast != 1)))
+		{
+			m_pSweepElQueries[ElID - BatchElID] = cMLFSweepSkipEl;
+			continue;
+		}
+
+		if (PrevChromID != pEl->ChromID)
+		{
+			pszChrom = m_pHypers->GetChrom(pEl->ChromID);
+			if (pszChrom == nullptr || pszChrom[0] == '\0')
+			{
+				gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to get chrom text for element: %d ChromID: %d", ElID, pEl->ChromID);
+				return(eBSFerrInternal);
+			}
+			ChromID = LocateBEDChromID(pszChrom);
+			PrevChromID = pEl->ChromID;
+		}
+		if (ChromID == eBSFerrChrom)
+		{
+			m_pSweepElQueries[ElID - BatchElID] = cMLFSweepMissingChrom;
+			continue;
+		}
+
+		pQuery = &m_pSweepElOrder[m_NumSweepQueries];
+		memset(pQuery, 0, sizeof(tsMLFSweepQuery));
+		pQuery->ElID = ElID;
+		pQuery->ChromID = ChromID;
+		pQuery->CoreStart = pEl->StartLoci;
+		pQuery->CoreEnd = pEl->StartLoci + pEl->Len - 1;
+		Strand = pEl->PlusStrand ? '+' : '-';
+		switch (m_MLFPMode)
+		{
+			case ePMdefault:
+				break;
+
+			case ePMstarts:
+				if (Strand == '+')
+					pQuery->CoreEnd = pQuery->CoreStart;
+				else
+					pQuery->CoreStart = pQuery->CoreEnd;
+				break;
+
+			case ePMdyad:
+				if (Strand == '+')
+				{
+					pQuery->CoreStart += 73;
+					pQuery->CoreEnd = pQuery->CoreStart;
+				}
+				else
+				{
+					pQuery->CoreEnd -= 73;
+					if (pQuery->CoreEnd < 0)
+						pQuery->CoreEnd = 0;
+					pQuery->CoreStart = pQuery->CoreEnd;
+				}
+				break;
+
+			default:
+				break;
+		}
+
+		switch (m_StrandProc)
+		{
+			case eStrandDflt:
+				pQuery->Strand = '*';
+				break;
+			case eStrandSense:
+				pQuery->Strand = Strand;
+				break;
+			case eStrandAnti:
+				pQuery->Strand = Strand == '+' ? '-' : '+';
+				break;
+			default:
+				pQuery->Strand = '*';
+				break;
+		}
+		m_pSweepChromIdxs[ChromID] += 1;
+		m_pSweepElQueries[ElID - BatchElID] = m_NumSweepQueries++;
+	}
+
+	// order queries by chromosome
+	QueryIdx = 0;
+	for (ChromIdx = 1; ChromIdx <= NumBEDChroms; ChromIdx++)
+	{
+		NumChromQueries = m_pSweepChromIdxs[ChromIdx];
+		m_pSweepChromIdxs[ChromIdx] = QueryIdx;
+		QueryIdx += NumChromQueries;
+	}
+	pQuery = m_pSweepElOrder;
+	for (QueryIdx = 0; QueryIdx < m_NumSweepQueries; QueryIdx++, pQuery++)
+		m_pSweepQueries[m_pSweepChromIdxs[pQuery->ChromID]++] = *pQuery;
+
+	// partition into tasks, each containing queries on a single chromosome
+	pTask = nullptr;
+	pQuery = m_pSweepQueries;
+	for (QueryIdx = 0; QueryIdx < m_NumSweepQueries; QueryIdx++, pQuery++)
+	{
+		if (pTask == nullptr || pTask->NumQueries == cMLFSweepTaskEls || pQuery->ChromID != m_pSweepQueries[pTask->QueryIdx].ChromID)
+		{
+			pTask = &m_pSweepTasks[m_NumSweepTasks++];
+			pTask->QueryIdx = QueryIdx;
+			pTask->NumQueries = 0;
+			pTask->NumHits = 0;
+		}
+		pTask->NumQueries += 1;
+	}
+	return(eBSFSuccess);
+}
+
+// SortSweepQueries
+// Used to sort sweep queries ascending by core start loci
+static int
+SortSweepQueries(const void *arg1, const void *arg2)
+{
+	tsMLFSweepQuery *pEl1 = (tsMLFSweepQuery *)arg1;
+	tsMLFSweepQuery *pEl2 = (tsMLFSweepQuery *)arg2;
+	if (pEl1->CoreStart < pEl2->CoreStart)
+		return(-1);
+	if (pEl1->CoreStart > pEl2->CoreStart)
+		return(1);
+	if (pEl1->ElID < pEl2->ElID)
+		return(-1);
+	if (pEl1->ElID > pEl2->ElID)
+		return(1);
+	return(0);
+}
+
+// SweepTask
+// Annotates the task queries by merge sweeping the queries, in core start order, against the features on the task chromosome
+// Annotations are equivalent to those from CBEDfile::GetFeatureBits(), GetSpliceSiteBits(), LocateFeatureAfter() and LocateFeatureBefore() but
+// without per query binary searches, and as the sweep applies the strand filtering then CBEDfile::SetStrand() is never required
+int
+CMapLoci2Feat::SweepTask(int TaskIdx)
+{
+	int Rslt;
+	int QueryIdx;
+	int Idx;
+	int NumOverlaps;
+	int *pFeatIDs;
+	int FeatID;
+	int FeatStart;
+	int FeatEnd;
+	int Features;
+	int ElFeatures;
+	int WinStart;
+	int WinEnd;
+	int NxtFeatID;
+	int NxtFeatStart;
+	int PrvFeatID;
+	int PrvFeatEnd;
+	char PrvFeatStrand;
+	bool bUpDnstream;
+	tsMLFSweepHit *pHit;
+	tsMLFSweepHit *pTmpHits;
+	tsMLFSweepQuery *pQuery;
+	tsMLFSweepTask *pTask;
+	CBEDSweep Sweep;
+
+	pTask = &m_pSweepTasks[TaskIdx];
+	pQuery = &m_pSweepQueries[pTask->QueryIdx];
+	pTask->NumHits = 0;
+
+	// queries are in element order and elements will usually have been sorted by loci
+	for (QueryIdx = 1; QueryIdx < pTask->NumQueries; QueryIdx++)
+		if (pQuery[QueryIdx].CoreStart < pQuery[QueryIdx - 1].CoreStart)
+			break;
+	if (QueryIdx < pTask->NumQueries)
+		qsort(pQuery, pTask->NumQueries, sizeof(tsMLFSweepQuery), SortSweepQueries);
+
+	if ((Rslt = Sweep.Init(m_pBiobed, pQuery->ChromID)) != eBSFSuccess)
+		return(Rslt);
+
+	// feature bits for all features at a locus include up/dnstream of features within the regulatory region length of the core
+	bUpDnstream = !m_bFeatinsts && m_RegRegionLen > 0;
+	for (QueryIdx = 0; QueryIdx < pTask->NumQueries; QueryIdx++, pQuery++)
+	{
+		pQuery->TaskIdx = TaskIdx;
+		pQuery->HitsIdx = pTask->NumHits;
+		pQuery->NumHits = 0;
+		pQuery->FeatID = 0;
+		pQuery->Features = 0;
+		if (bUpDnstream)
+		{
+			WinStart = max(0, pQuery->CoreStart - m_RegRegionLen);
+			WinEnd = pQuery->CoreEnd + m_RegRegionLen;
+		}
+		else
+		{
+			WinStart = pQuery->CoreStart;
+			WinEnd = pQuery->CoreEnd;
+		}
+		if ((NumOverlaps = Sweep.Overlaps(WinStart, WinEnd, pQuery->Strand)) < 0)
+			return(NumOverlaps);
+		pFeatIDs = Sweep.OverlapIDs();
+
+		if ((pTask->NumHits + NumOverlaps) > pTask->AllocHits)
+		{
+			if ((pTmpHits = new tsMLFSweepHit[pTask->NumHits + NumOverlaps + cMLFAllocSweepHits]) == nullptr)
+				return(eBSFerrMem);
+			if (pTask->pHits != nullptr)
+			{
+				memcpy(pTmpHits, pTask->pHits, sizeof(tsMLFSweepHit) * pTask->NumHits);
+				delete[]pTask->pHits;
+			}
+			pTask->pHits = pTmpHits;
+			pTask->AllocHits = pTask->NumHits + NumOverlaps + cMLFAllocSweepHits;
+		}
+
+		ElFeatures = 0;
+		pHit = &pTask->pHits[pTask->NumHits];
+		for (Idx = 0; Idx < NumOverlaps; Idx++)
+		{
+			FeatID = pFeatIDs[Idx];
+			if (m_bFeatinsts)
+			{
+				Features = m_pBiobed->GetFeatureOverlaps(cRegionFeatBits, FeatID, pQuery->CoreStart, pQuery->CoreEnd, m_RegRegionLen);
+				Features |= m_pBiobed->GetFeatureBitsSpliceOverlaps(FeatID, pQuery->CoreStart, pQuery->CoreEnd, cMinSpliceOverlap);
+			}
+			else
+			{
+				ElFeatures |= m_pBiobed->GetFeatureOverlaps(cRegionFeatBits, FeatID, pQuery->CoreStart, pQuery->CoreEnd, m_RegRegionLen);
+				if (bUpDnstream)		// only features overlapping the core are counted
+				{
+					m_pBiobed->GetFeature(FeatID, nullptr, nullptr, &FeatStart, &FeatEnd);
+					if (FeatStart > pQuery->CoreEnd || FeatEnd < pQuery->CoreStart)
+						continue;
+				}
+				ElFeatures |= m_pBiobed->GetFeatureBitsSpliceOverlaps(FeatID, pQuery->CoreStart, pQuery->CoreEnd, cMinSpliceOverlap);
+				Features = 0;
+			}
+			pHit->FeatID = FeatID;
+			pHit->Features = Features;
+			pHit += 1;
+			pQuery->NumHits += 1;
+		}
+		pTask->NumHits += pQuery->NumHits;
+
+		if (pQuery->NumHits)
+		{
+			if (!m_bFeatinsts)		// all overlapped features are counted with the feature bits for all features at the core locus
+			{
+				pHit = &pTask->pHits[pQuery->HitsIdx];
+				for (Idx = 0; Idx < pQuery->NumHits; Idx++, pHit++)
+					pHit->Features = ElFeatures;
+			}
+			continue;
+		}
+
+		// not overlapping or not contained in any feature so locate nearest feature up/dnstream
+		NxtFeatID = Sweep.FeatureAfter(pQuery->CoreEnd, pQuery->Strand);
+		if (NxtFeatID > 0)
+			m_pBiobed->GetFeature(NxtFeatID, nullptr, nullptr, &NxtFeatStart);
+
+		// as with CBEDfile::LocateFeatureBefore() the preceding feature is located irrespective of strand, and not located if core starts at 0
+		PrvFeatID = pQuery->CoreStart > 0 ? Sweep.FeatureBefore(pQuery->CoreStart) : 0;
+		if (PrvFeatID > 0)
+			m_pBiobed->GetFeature(PrvFeatID, nullptr, nullptr, nullptr, &PrvFeatEnd, nullptr, &PrvFeatStrand);
+
+		if (NxtFeatID < 1)
+			FeatID = PrvFeatID;
+		else
+		{
+			if (PrvFeatID < 1)
+				FeatID = NxtFeatID;
+			else
+			{
+				if ((NxtFeatStart - pQuery->CoreEnd) < (pQuery->CoreStart - PrvFeatEnd))
+					FeatID = NxtFeatID;
+				else
+					FeatID = PrvFeatID;
+			}
+		}
+		pQuery->FeatID = FeatID;
+
+		if (m_bFeatinsts)
+		{
+			if (FeatID > 0 && (FeatID == NxtFeatID || pQuery->Strand == '*' || pQuery->Strand == PrvFeatStrand))
+				pQuery->Features = m_pBiobed->GetFeatureOverlaps(cRegionFeatBits, FeatID, pQuery->CoreStart, pQuery->CoreEnd, m_RegRegionLen);
+		}
+		else
+			pQuery->Features = ElFeatures;
+	}
+	return(eBSFSuccess);
+}
+
+// MLFSweepTaskFunc
+// Work pool processing function, items are sweep task indexes
+static int
+MLFSweepTaskFunc(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+	int Rslt;
+	CMapLoci2Feat *pThis = (CMapLoci2Feat *)pCtx;
+	for (; StartIdx < EndIdx; StartIdx++)
+		if ((Rslt = pThis->SweepTask((int)StartIdx)) < eBSFSuccess)
+			return(Rslt);
+	return(eBSFSuccess);
 }
 
 // MapLoci2Features
@@ -129,19 +556,19 @@ CMapLoci2Feat::MapLoci2Features(char *pszRsltsFile)
 	int Len;
 	int Features;
 	int AccumFeatures;
-	int NumFeatsOverlap;
 	int FeatMsk;
 	int FeatIdx;
 	uint32_t ElID;
+	uint32_t BatchElID;
+	int NumBatchEls;
+	int QueryIdx;
+	int HitIdx;
 	int FeatID;
-	int NxtFeatID;
-	int NxtFeatStart;
-	int NxtFeatEnd;
-	int PrvFeatID;
-	int PrvFeatStart;
-	int PrvFeatEnd;
 	int RelScale;
 	int NumMissingChroms;
+	CWorkPool *pWorkPool;
+	tsMLFSweepQuery *pQuery;
+	tsMLFSweepHit *pHit;
 
 	int PrevStartChromID = -1;
 	int	PrevStartLoci = -1;
@@ -149,8 +576,6 @@ CMapLoci2Feat::MapLoci2Features(char *pszRsltsFile)
 	bool bStartUniqLoci = true;
 
 	int MaxChromID;
-	int CoreStartLoci;
-	int CoreEndLoci;
 	int TotNumFeatures;
 	tsFeatCntDist *pCurFeatCntDist;		// to hold currently being processed feature count distribution
 	tsHyperElement *pEl;
@@ -236,320 +661,209 @@ CMapLoci2Feat::MapLoci2Features(char *pszRsltsFile)
 		}
 	}
 
+	if ((Rslt = SweepInit()) != eBSFSuccess)
+	{
+		MLFReset();
+		return(Rslt);
+	}
+	if ((pWorkPool = CWorkPool::Shared(m_NumThreads)) == nullptr)
+	{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to start work pool threads");
+		MLFReset();
+		return(eBSFerrInternal);
+	}
+
 	NumMissingChroms = 0;
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "Associating (from %d) element %9.9d", m_NumEls, 1);
-	// Note: alignments will have been sorted ascending by chrom, start loci
-	for (ElID = 1; ElID <= m_NumEls; ElID++)
+	// Elements are processed in batches; each batch is first partitioned into per chromosome sweep tasks which are annotated in parallel by merge
+	// sweeping the loci ordered elements against the features, then the annotations are accumulated in element order so that the
+	// results - including accumulated relative abundances - are identical to those from processing the elements serially
+	ElID = 1;
+	for (BatchElID = 1; BatchElID <= m_NumEls; BatchElID += NumBatchEls)
 	{
-		AccumFeatures = 0;
-		if (!(ElID % 100000))
-			printf("\b\b\b\b\b\b\b\b\b%9.9d", ElID);
-		pEl = m_pHypers->GetElement(ElID);
-		if (pEl == nullptr)
+		NumBatchEls = (int)min((uint32_t)cMLFSweepBatchEls, m_NumEls - BatchElID + 1);
+		if ((Rslt = SweepBatch(BatchElID, NumBatchEls)) != eBSFSuccess)
 		{
-			gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to get details for element: %d", ElID);
 			MLFReset();
-			return(eBSFerrInternal);
+			return(Rslt);
 		}
-
-		// if only associating the actual start loci, and if a split element then need to process first if element on '+' and last if element on '-' strand
-		if (m_MLFPMode == ePMstarts && pEl->SplitElement == 1)
+		if ((Rslt = pWorkPool->ParallelFor(m_NumSweepTasks, 1, MLFSweepTaskFunc, this, 0, nullptr, nullptr, nullptr, m_NumThreads)) < eBSFSuccess)
 		{
-			if (pEl->PlusStrand == 1 && pEl->SplitFirst != 1)
-				continue;
-			if (pEl->PlusStrand == 0 && pEl->SplitLast != 1)
-				continue;
-		}
-
-		if (pszChrom == nullptr || PrevChromID != pEl->ChromID)
-		{
-			pszChrom = m_pHypers->GetChrom(pEl->ChromID);
-			if (pszChrom == nullptr || pszChrom[0] == '\0')
-			{
-				gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to get chrom text for element: %d ChromID: %d", ElID, pEl->ChromID);
-				MLFReset();
-				return(eBSFerrInternal);
-			}
-
-			// some old datasets may be referencing ChrM as mitochondria, or ChrC as chloroplast
-			// so need to check for these
-			if (!stricmp(pszChrom, "chloroplast"))
-				pszChrom = (char *)"ChrC";
-			else
-				if (!stricmp(pszChrom, "mitochondria"))
-					pszChrom = (char *)"ChrM";
-			PrevChromID = pEl->ChromID;
-			PrevStartChromID = -1;
-			PrevStartLoci = -1;
-			PrevStrand = '*';
-			bStartUniqLoci = true;
+			gDiagnostics.DiagOut(eDLFatal, gszProcName, "Errors whilst associating elements with features");
+			MLFReset();
+			return(Rslt);
 		}
+		// sweep tasks may have reordered their queries
+		for (QueryIdx = 0; QueryIdx < m_NumSweepQueries; QueryIdx++)
+			m_pSweepElQueries[m_pSweepQueries[QueryIdx].ElID - BatchElID] = QueryIdx;
 
-		if (pszElType == nullptr || PrevElTypeID != pEl->ElTypeID)
+		for (ElID = BatchElID; ElID < BatchElID + NumBatchEls; ElID++)
 		{
-			pszElType = m_pHypers->GetType(pEl->ElTypeID);
-			PrevElTypeID = pEl->ElTypeID;
-		}
+			AccumFeatures = 0;
+			if (!(ElID % 100000))
+				printf("\b\b\b\b\b\b\b\b\b%9.9d", ElID);
+			pEl = m_pHypers->GetElement(ElID);
+
+			// if only associating the actual start loci, and if a split element then need to process first if element on '+' and last if element on '-' strand
+			QueryIdx = m_pSweepElQueries[ElID - BatchElID];
+			if (QueryIdx == cMLFSweepSkipEl)
+				continue;
 
-		if (pszRefSpecies == nullptr || PrevRefSpeciesID != pEl->RefSpeciesID)
-		{
-			pszRefSpecies = m_pHypers->GetRefSpecies(pEl->RefSpeciesID);
-			PrevRefSpeciesID = pEl->RefSpeciesID;
-		}
+			if (pszChrom == nullptr || PrevChromID != pEl->ChromID)
+			{
+				pszChrom = m_pHypers->GetChrom(pEl->ChromID);
 
-		if (pszRelSpecies == nullptr || PrevRelSpeciesID != pEl->RelSpeciesID)
-		{
-			pszRelSpecies = m_pHypers->GetRelSpecies(pEl->RelSpeciesID);
-			PrevRelSpeciesID = pEl->RelSpeciesID;
-		}
+				// some old datasets may be referencing ChrM as mitochondria, or ChrC as chloroplast
+				// so need to check for these
+				if (!stricmp(pszChrom, "chloroplast"))
+					pszChrom = (char *)"ChrC";
+				else
+					if (!stricmp(pszChrom, "mitochondria"))
+						pszChrom = (char *)"ChrM";
+				PrevChromID = pEl->ChromID;
+				PrevStartChromID = -1;
+				PrevStartLoci = -1;
+				PrevStrand = '*';
+				bStartUniqLoci = true;
+			}
 
+			if (pszElType == nullptr || PrevElTypeID != pEl->ElTypeID)
+			{
+				pszElType = m_pHypers->GetType(pEl->ElTypeID);
+				PrevElTypeID = pEl->ElTypeID;
+			}
 
-		StartLoci = pEl->StartLoci;
-		EndLoci = pEl->StartLoci + pEl->Len - 1;
+			if (pszRefSpecies == nullptr || PrevRefSpeciesID != pEl->RefSpeciesID)
+			{
+				pszRefSpecies = m_pHypers->GetRefSpecies(pEl->RefSpeciesID);
+				PrevRefSpeciesID = pEl->RefSpeciesID;
+			}
 
-		Len = pEl->Len;
-		Strand = pEl->PlusStrand ? '+' : '-';
+			if (pszRelSpecies == nullptr || PrevRelSpeciesID != pEl->RelSpeciesID)
+			{
+				pszRelSpecies = m_pHypers->GetRelSpecies(pEl->RelSpeciesID);
+				PrevRelSpeciesID = pEl->RelSpeciesID;
+			}
 
-		if (PrevStartChromID != pEl->ChromID || StartLoci != PrevStartLoci || Strand != PrevStrand) // not processed this loci previously?
-		{
-			PrevStartChromID = pEl->ChromID;
-			PrevStartLoci = StartLoci;
-			PrevStrand = Strand;
-			bStartUniqLoci = true;
-		}
-		else
-			bStartUniqLoci = false;
+			StartLoci = pEl->StartLoci;
+			EndLoci = pEl->StartLoci + pEl->Len - 1;
 
-		SrcID = pEl->SrcID;
-		Features = pEl->Features;
-		RelScale = pEl->RelScale;
-		switch (m_StrandProc)
-		{
-			case eStrandDflt:
-				break;
-			case eStrandSense:
-				m_pBiobed->SetStrand(Strand);
-				break;
-			case eStrandAnti:
-				m_pBiobed->SetStrand(Strand == '+' ? '-' : '+');
-				break;
-		}
-		FeatID = 0;
+			Len = pEl->Len;
+			Strand = pEl->PlusStrand ? '+' : '-';
 
-		if (m_pBiobed != nullptr)
-		{
-			Rslt = ChromID = m_pBiobed->LocateChromIDbyName(pszChrom);
-			if (Rslt == eBSFerrChrom)
+			if (PrevStartChromID != pEl->ChromID || StartLoci != PrevStartLoci || Strand != PrevStrand) // not processed this loci previously?
 			{
-				// some old datasets may be referencing ChrM as mitochondria, or ChrC as chloroplast
-				// so need to check for these
-				if (!stricmp(pszChrom, "ChrM"))
-					Rslt = ChromID = m_pBiobed->LocateChromIDbyName((char *)"mitochondria");
-				else
-					if (!stricmp(pszChrom, "ChrC"))
-						Rslt = ChromID = m_pBiobed->LocateChromIDbyName((char *)"chloroplast");
+				PrevStartChromID = pEl->ChromID;
+				PrevStartLoci = StartLoci;
+				PrevStrand = Strand;
+				bStartUniqLoci = true;
 			}
+			else
+				bStartUniqLoci = false;
 
-			if (Rslt == eBSFerrChrom)
+			SrcID = pEl->SrcID;
+			RelScale = pEl->RelScale;
+
+			if (QueryIdx == cMLFSweepMissingChrom)
 			{
 				if (NumMissingChroms++ < 10)
 					gDiagnostics.DiagOut(eDLInfo, gszProcName, "Unable to locate chromosome %s in BED file", pszChrom);
 				if (NumMissingChroms == 10)
 					gDiagnostics.DiagOut(eDLInfo, gszProcName, "Not reporting any additional missing chromosomes");
-				Rslt = 0;
 				continue;
 			}
 
-			if (Rslt > 0)
-			{
-				if (MaxChromID < ChromID)
-					MaxChromID = ChromID;
-
-				CoreStartLoci = StartLoci;
-				CoreEndLoci = EndLoci;
-
-				switch (m_MLFPMode)
-				{
-					case ePMdefault:
-						break;
-
-					case ePMstarts:
-						if (Strand == '+')
-							CoreEndLoci = CoreStartLoci;
-						else
-							CoreStartLoci = CoreEndLoci;
-						break;
-
-					case ePMdyad:
-						if (Strand == '+')
-						{
-							CoreStartLoci += 73;
-							CoreEndLoci = CoreStartLoci;
-						}
-						else
-						{
-							CoreEndLoci -= 73;
-							if (CoreEndLoci < 0)
-								CoreEndLoci = 0;
-							CoreStartLoci = CoreEndLoci;
-						}
-						break;
-				}
+			pQuery = &m_pSweepQueries[QueryIdx];
+			ChromID = pQuery->ChromID;
+			if (MaxChromID < ChromID)
+				MaxChromID = ChromID;
 
-				// see if overlapping any features
-				AccumFeatures = 0;
-				NumFeatsOverlap = 0;
-				do
+			if (pQuery->NumHits > 0)	// overlapping features
+			{
+				pHit = &m_pSweepTasks[pQuery->TaskIdx].pHits[pQuery->HitsIdx];
+				for (HitIdx = 0; HitIdx < pQuery->NumHits; HitIdx++, pHit++)
 				{
-					FeatID = m_pBiobed->LocateFeatureIDinRangeOnChrom(ChromID,	// feature is on which chromosome
-																	  CoreStartLoci,						// feature must end on or after Start
-																	  CoreEndLoci,						// and start on or before End 
-																	  NumFeatsOverlap + 1);				// Ith instance to return (1..n)
-
-					if (FeatID > 0 && m_pFeatCntDists != nullptr)
+					FeatID = pHit->FeatID;
+					Features = pHit->Features;
+					if (m_bOneCntRead)
 					{
-						if (m_bFeatinsts)
-						{
-							Features = m_pBiobed->GetFeatureOverlaps(cRegionFeatBits, FeatID, CoreStartLoci, CoreEndLoci, m_RegRegionLen);
-							Features |= m_pBiobed->GetFeatureBitsSpliceOverlaps(FeatID, CoreStartLoci, CoreEndLoci, cMinSpliceOverlap);
-						}
-						else
-						{
-							Features = m_pBiobed->GetFeatureBits(ChromID,			// feature is on which chromosome
-																 CoreStartLoci,							// feature must end on or after Start
-																 CoreEndLoci,							// and start on or before End
-																 cRegionFeatBits,
-																 m_RegRegionLen);
-
-							Features |= m_pBiobed->GetSpliceSiteBits(ChromID, CoreStartLoci, CoreEndLoci, cMinSpliceOverlap);
-						}
-
-						if (m_bOneCntRead)
-						{
-							for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1)
-								if (Features & FeatMsk)
-								{
-									Features = FeatMsk;
-									break;
-								}
-						}
-						AccumFeatures |= Features;
-						pCurFeatCntDist = &m_pFeatCntDists[FeatID - 1];
 						for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1)
 							if (Features & FeatMsk)
-								pCurFeatCntDist->RegionCnts[FeatIdx] += 1;
-
-						// only accumulate relative abundance for reads in exons
-						if (Features & (cFeatBitCDS | cFeatBit5UTR | cFeatBit3UTR))
-						{
-							pCurFeatCntDist->RelAbundance += 999.0 / (double)max(1, RelScale);
-							if (bStartUniqLoci)
-								pCurFeatCntDist->UniqueReadLociHits += 1;
-						}
+							{
+								Features = FeatMsk;
+								break;
+							}
+					}
+					AccumFeatures |= Features;
+					pCurFeatCntDist = &m_pFeatCntDists[FeatID - 1];
+					for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1)
+						if (Features & FeatMsk)
+							pCurFeatCntDist->RegionCnts[FeatIdx] += 1;
+
+					// only accumulate relative abundance for reads in exons
+					if (Features & (cFeatBitCDS | cFeatBit5UTR | cFeatBit3UTR))
+					{
+						pCurFeatCntDist->RelAbundance += 999.0 / (double)max(1, RelScale);
+						if (bStartUniqLoci)
+							pCurFeatCntDist->UniqueReadLociHits += 1;
 					}
-					if (FeatID > 0)
-						NumFeatsOverlap += 1;
 				}
-				while (FeatID > 0);
-
-				if (!NumFeatsOverlap) // if not overlapping or not contained in any feature then locate nearest feature up/dnstream
+			}
+			else    // not overlapping or not contained in any feature so nearest feature up/dnstream
+			{
+				FeatID = pQuery->FeatID;
+				AccumFeatures = pQuery->Features;
+				if (m_bOneCntRead)
 				{
-					// find feature starting after core end loci
-					NxtFeatID = m_pBiobed->LocateFeatureAfter(ChromID,	// feature is on this chromosome
-															  CoreEndLoci);					         // feature starts on or immediately after this offset
-					if (NxtFeatID > 0)
-						m_pBiobed->GetFeature(NxtFeatID,		// feature instance identifier
-											  nullptr,							// where to return feature name
-											  nullptr,							// where to return chromosome name
-											  &NxtFeatStart,					// where to return feature start on chromosome (0..n) 
-											  &NxtFeatEnd);					// where to return feature end on chromosome
-
-																			// find feature ending before or at core start loci
-					PrvFeatID = m_pBiobed->LocateFeatureBefore(ChromID,	// feature is on this chromosome
-															   CoreStartLoci);			// feature ends on or immediately before this offset
-					if (PrvFeatID > 0)
-						m_pBiobed->GetFeature(PrvFeatID,		// feature instance identifier
-											  nullptr,	// where to return feature name
-											  nullptr,	// where to return chromosome name
-											  &PrvFeatStart,		// where to return feature start on chromosome (0..n) 
-											  &PrvFeatEnd);		// where to return feature end on chromosome
-
-					if (NxtFeatID < 1)
-						FeatID = PrvFeatID;
-					else
-					{
-						if (PrvFeatID < 1)
-							FeatID = NxtFeatID;
-						else
+					for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1)
+						if (AccumFeatures & FeatMsk)
 						{
-							if ((NxtFeatStart - CoreEndLoci) < (CoreStartLoci - PrvFeatEnd))
-								FeatID = NxtFeatID;
-							else
-								FeatID = PrvFeatID;
+							AccumFeatures = FeatMsk;
+							break;
 						}
-					}
+				}
+				if (AccumFeatures && FeatID > 0)
+				{
+					pCurFeatCntDist = &m_pFeatCntDists[FeatID - 1];
 
+					for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1)
+						if (AccumFeatures & FeatMsk)
+							pCurFeatCntDist->RegionCnts[FeatIdx] += 1;
+				}
+			}
 
-					if (m_bFeatinsts)
-						AccumFeatures = m_pBiobed->GetFeatureOverlaps(cRegionFeatBits, FeatID, CoreStartLoci, CoreEndLoci, m_RegRegionLen);
-					else
-						AccumFeatures = m_pBiobed->GetFeatureBits(ChromID,			// feature is on which chromosome
-																  CoreStartLoci,							// feature must end on or after Start
-																  CoreEndLoci,							// and start on or before End
-																  cRegionFeatBits,
-																  m_RegRegionLen);
+			if (m_hRsltFile != -1)
+				BuffIdx += sprintf(&szLineBuff[BuffIdx], "%d,\"%s\",\"%s\",\"%s\",%d,%d,%d,\"%c\",%d,%d\n",
+								   SrcID, pszElType, pszRefSpecies, pszChrom, StartLoci, EndLoci, Len, Strand, AccumFeatures, RelScale);
 
-					if (m_bOneCntRead)
-					{
-						for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1)
-							if (AccumFeatures & FeatMsk)
-							{
-								AccumFeatures = FeatMsk;
-								break;
-							}
-					}
-					if (AccumFeatures && FeatID > 0 && m_pFeatCntDists != nullptr)
+			if (m_bOneCntRead)
+			{
+				for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1)
+					if (AccumFeatures & FeatMsk)
 					{
-						pCurFeatCntDist = &m_pFeatCntDists[FeatID - 1];
-
-						for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1)
-							if (AccumFeatures & FeatMsk)
-								pCurFeatCntDist->RegionCnts[FeatIdx] += 1;
+						AccumFeatures = FeatMsk;
+						break;
 					}
-				}
 			}
-		}
-
-		if (m_hRsltFile != -1)
-			BuffIdx += sprintf(&szLineBuff[BuffIdx], "%d,\"%s\",\"%s\",\"%s\",%d,%d,%d,\"%c\",%d,%d\n",
-							   SrcID, pszElType, pszRefSpecies, pszChrom, StartLoci, EndLoci, Len, Strand, AccumFeatures, RelScale);
 
-		if (m_bOneCntRead)
-		{
-			for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1)
-				if (AccumFeatures & FeatMsk)
+			if (!AccumFeatures)
+				m_pChromRegionCnts[ChromID - 1].Intergenic += 1;
+			else
 				{
-					AccumFeatures = FeatMsk;
-					break;
+				pChromRegionCnts = (int *)&m_pChromRegionCnts[ChromID - 1];
+				for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1, pChromRegionCnts+=1)
+					if (AccumFeatures & FeatMsk)
+						*pChromRegionCnts += 1;
 				}
-		}
 
-		if (!AccumFeatures)
-			m_pChromRegionCnts[ChromID - 1].Intergenic += 1;
-		else
+			if (m_hRsltFile != -1 && ((size_t)(BuffIdx + 1000) > sizeof(szLineBuff)))
 			{
-			pChromRegionCnts = (int *)&m_pChromRegionCnts[ChromID - 1];
-			for (FeatMsk = 0x01, FeatIdx = 0; FeatIdx < 8; FeatIdx++, FeatMsk <<= 1, pChromRegionCnts+=1)
-				if (AccumFeatures & FeatMsk)
-					*pChromRegionCnts += 1;
+				CUtility::RetryWrites(m_hRsltFile, szLineBuff, BuffIdx);
+				BuffIdx = 0;
 			}
-
-		if (m_hRsltFile != -1 && ((BuffIdx + 1000) > sizeof(szLineBuff)))
-		{
-			CUtility::RetryWrites(m_hRsltFile, szLineBuff, BuffIdx);
-			BuffIdx = 0;
 		}
 	}
+	SweepReset();
 	printf("\b\b\b\b\b\b\b\b\b%9.9d", ElID - 1);
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "All elements (%d) now associated", ElID - 1);
 	if (NumMissingChroms > 0)
@@ -947,7 +1261,8 @@ CMapLoci2Feat::MLFProcess(etMLFPMode PMode,				// processing mode
 						  int RegRegionLen,			// regulatory region length
 						  int MinLength,				// minimum element length
 						  int MaxLength,				// maximum element length
-						  int JoinOverlap)			// deduping join overlap
+						  int JoinOverlap,			// deduping join overlap
+						  int NumThreads)			// number of worker threads to use when annotating elements
 {
 	int Rslt;
 	char *pszChrom;
@@ -962,6 +1277,7 @@ CMapLoci2Feat::MLFProcess(etMLFPMode PMode,				// processing mode
 	m_RegRegionLen = RegRegionLen;
 	m_bFeatinsts = bFeatinsts;
 	m_bOneCntRead = bOneCntRead;
+	m_NumThreads = NumThreads;
 
 	if ((m_pHypers = new CHyperEls) == nullptr)
 	{
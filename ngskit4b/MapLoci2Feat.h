@@ -19,6 +19,12 @@ const int cMaxJoinOverlap = 100;		// max allowed join overlap
 
 const int cMaxLengthRange = 1000000;	// maximal element length
 
+const int cMLFSweepBatchEls = 0x0100000;	// elements are annotated in batches of at most this many elements
+const int cMLFSweepTaskEls = 0x04000;		// batches are partitioned into per chromosome sweep tasks of at most this many elements
+const int cMLFAllocSweepHits = 0x010000;	// sweep task feature hits are allocated in increments of this many hits
+const int cMLFSweepSkipEl = -1;				// element not annotated as not the start loci of a split element
+const int cMLFSweepMissingChrom = -2;		// element not annotated as its chromosome is not in the BED file
+
 										// processing modes
 typedef enum TAG_eMLFPMode
 {
@@ -83,6 +89,36 @@ typedef struct TAG_sChromRegionCnts
 
 #pragma pack()
 
+// element loci to be annotated by a merge sweep over the features on the element's chromosome
+typedef struct TAG_sMLFSweepQuery
+{
+	uint32_t ElID;						// element identifier
+	int ChromID;						// element is on this BED chromosome
+	int CoreStart;						// annotating features overlapping element core starting at this loci
+	int CoreEnd;						// and ending at this loci
+	int TaskIdx;						// annotated by this sweep task
+	int HitsIdx;						// overlapped feature hits start at this index in the task hits
+	int NumHits;						// number of overlapped feature hits
+	int FeatID;							// if no features overlapped then the nearest feature, 0 if none
+	int Features;						// if no features overlapped then the feature bits
+	char Strand;						// features must be on this strand, '*' if either strand
+} tsMLFSweepQuery;
+
+typedef struct TAG_sMLFSweepHit
+{
+	int FeatID;							// overlapped feature
+	int Features;						// feature bits to be accumulated against this feature
+} tsMLFSweepHit;
+
+typedef struct TAG_sMLFSweepTask
+{
+	int QueryIdx;						// index in m_pSweepQueries of first query to be annotated
+	int NumQueries;						// number of queries, all on same chromosome, to be annotated
+	int NumHits;						// number of overlapped feature hits in pHits
+	int AllocHits;						// pHits allocated to hold this many hits
+	tsMLFSweepHit *pHits;				// overlapped feature hits for all queries in this task
+} tsMLFSweepTask;
+
 class CMapLoci2Feat
 {
 	int m_AllocdChromRegionCnts;				// m_pChromRegionCnts allocated for this many chroms
@@ -105,12 +141,29 @@ class CMapLoci2Feat
 
 	int m_hFeatRsltFile;
 
+	int m_NumThreads;					// number of worker threads to use when annotating elements
+	int *m_pSweepElQueries;				// for each element in current batch the index of its sweep query, < 0 if element not annotated
+	tsMLFSweepQuery *m_pSweepQueries;	// sweep queries for current batch ordered by chromosome
+	tsMLFSweepQuery *m_pSweepElOrder;	// sweep queries for current batch in element order
+	int m_NumSweepQueries;				// number of sweep queries in current batch
+	int *m_pSweepChromIdxs;				// used when ordering sweep queries by chromosome
+	int m_NumSweepTasks;				// number of sweep tasks in current batch
+	int m_AllocSweepTasks;				// m_pSweepTasks allocated to hold this many tasks
+	tsMLFSweepTask *m_pSweepTasks;		// sweep tasks
+
+	int SweepInit(void);				// allocate sweep batch memory
+	void SweepReset(void);				// release sweep batch memory
+	int SweepBatch(uint32_t BatchElID,	// partition batch of elements starting with this element
+				int NumBatchEls);		// and containing this many elements into per chromosome sweep tasks
+	int LocateBEDChromID(char *pszChrom);	// returns BED chromosome identifier for element chromosome name, eBSFerrChrom if not located
+
 public:
 	CMapLoci2Feat();
 	~CMapLoci2Feat();
 
 	void MLFReset(void);
 	int MapLoci2Features(char *pszRsltsFile);
+	int SweepTask(int TaskIdx);			// annotate sweep task queries, called by work pool threads
 	bool IsSameFeature(char *pszFeatA, char *pszFeatB);
 	bool			// true if suffix was trimmed
 		TrimNameIso(char *pszName); // Inplace remove any name isoform suffix of the form '.[0-99]'
@@ -134,7 +187,8 @@ public:
 								  int RegRegionLen,			// regulatory region length
 								  int MinLength,				// minimum element length
 								  int MaxLength,				// maximum element length
-								  int JoinOverlap);			// deduping join overlap
+								  int JoinOverlap,			// deduping join overlap
+								  int NumThreads);			// number of worker threads to use when annotating elements
 
 };
 
@@ -280,6 +280,7 @@ CMarkerKMers::LocKMers(etPMode PMode,			// processing mode - defaults to 0
 		  int SuffixLen,				// cultivar specific suffix length
 		  int MinWithPrefix,			// minimum number of cultivars required to have the shared prefix
 		  int MaxHomozygotic,			// only report prefixes if K-Mer suffixes are homozygotic between a maximum of this many cultivars, if 1 then no other cultivars
+		  int ExtMemMB,					// if > 0 then count K-mers in partitions spilled to temp files bounded by this memory budget in MB
 		  char *pszSfxPseudoGenome,		// contains pregenerated suffix over psuedochromosomes for each cultivar
 		  char *pszMarkerFile,			// output potential markers to this file
 		  int NumThreads)				// max number of threads allowed
@@ -301,6 +302,12 @@ m_PrefixLen = PrefixLen;
 m_SuffixLen = SuffixLen;
 m_MinWithPrefix = MinWithPrefix;
 m_MaxHomozygotic = MaxHomozygotic;
+m_ExtMemMB = ExtMemMB;
+if(m_ExtMemMB > 0 && m_SuffixLen > 0 && m_MaxHomozygotic > 0)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"Homozygotic suffix checking requires suffix array iteration, external K-mer counting will not be used");
+	m_ExtMemMB = 0;
+	}
 m_PutMarkerSize = (int)sizeof(tsPutMarker) + m_PrefixLen - 1;
 
 m_NumThreads = NumThreads;
@@ -349,6 +356,11 @@ if((m_pSfxArray = new CSfxArray)==nullptr)
 	return(eBSFerrObj);
 	}
 
+#ifndef _WIN32
+// external counting only accesses the sequences so map the suffix block, suffix array pages are then never loaded
+if(m_ExtMemMB > 0)
+	m_pSfxArray->SetLoadMode(eSfxLoadMmap);
+#endif
 if((Rslt = m_pSfxArray->Open(pszSfxPseudoGenome))!=eBSFSuccess)
 	{
 	while(m_pSfxArray->NumErrMsgs())
@@ -438,76 +450,91 @@ if(m_hOutFile < 0)
 	return(eBSFerrCreateFile);
 	}
 
-// initialise and startup K-mer processing worker threads
-tsKMerThreadPars WorkerThreads[cMaxWorkerThreads];			// allow for max possible user configured number of threads
-int ThreadIdx;
-memset(WorkerThreads,0,sizeof(WorkerThreads));
-int NumActiveThreads;
-int64_t StartSfxIdx;
-int64_t EndSfxIdx;
-
-// partition the processing over multiple threads
-StartSfxIdx = 0;
-for(NumActiveThreads = 0; NumActiveThreads < m_NumThreads; NumActiveThreads++)
+if(m_ExtMemMB > 0)
 	{
-	if((Rslt = m_pSfxArray->GenKMerCultThreadRange(PrefixLen,NumActiveThreads+1,m_NumThreads,StartSfxIdx,&EndSfxIdx))<1)
-		break;
-	WorkerThreads[NumActiveThreads].StartSfxIdx = StartSfxIdx;
-	WorkerThreads[NumActiveThreads].EndSfxIdx = EndSfxIdx;
-	StartSfxIdx = EndSfxIdx + 1;
+	CExtKMerCounts ExtKMerCounts;
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Process: External K-mer counting with memory budget of %dMB",m_ExtMemMB);
+	if((NumPutativePrefixKMers = ExtKMerCounts.GenKMerCultsCnts(m_pSfxArray,m_PMode == ePMNSenseKMers ? true : false,m_PrefixLen,m_SuffixLen,m_MinWithPrefix,
+												m_ExtMemMB,m_szMarkerFile,m_NumThreads,this,MarkersCallback)) < 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Process: external K-mer counting failed");
+		Reset();
+		return((int)NumPutativePrefixKMers);
+		}
 	}
-if(Rslt < 0)
+else
 	{
-	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Process: unable to partition processing between threads");
-	Reset();
-	return(Rslt);
-	}
+	// initialise and startup K-mer processing worker threads
+	tsKMerThreadPars WorkerThreads[cMaxWorkerThreads];			// allow for max possible user configured number of threads
+	int ThreadIdx;
+	memset(WorkerThreads,0,sizeof(WorkerThreads));
+	int NumActiveThreads;
+	int64_t StartSfxIdx;
+	int64_t EndSfxIdx;
+
+	// partition the processing over multiple threads
+	StartSfxIdx = 0;
+	for(NumActiveThreads = 0; NumActiveThreads < m_NumThreads; NumActiveThreads++)
+		{
+		if((Rslt = m_pSfxArray->GenKMerCultThreadRange(PrefixLen,NumActiveThreads+1,m_NumThreads,StartSfxIdx,&EndSfxIdx))<1)
+			break;
+		WorkerThreads[NumActiveThreads].StartSfxIdx = StartSfxIdx;
+		WorkerThreads[NumActiveThreads].EndSfxIdx = EndSfxIdx;
+		StartSfxIdx = EndSfxIdx + 1;
+		}
+	if(Rslt < 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Process: unable to partition processing between threads");
+		Reset();
+		return(Rslt);
+		}
 
-gDiagnostics.DiagOut(eDLInfo,gszProcName,"Process: Partitioning processing between %d threads",NumActiveThreads);
-for(ThreadIdx = 0; ThreadIdx < NumActiveThreads; ThreadIdx++)
-	{
-	WorkerThreads[ThreadIdx].ThreadIdx = ThreadIdx + 1;
-	WorkerThreads[ThreadIdx].pThis = this;
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Process: Partitioning processing between %d threads",NumActiveThreads);
+	for(ThreadIdx = 0; ThreadIdx < NumActiveThreads; ThreadIdx++)
+		{
+		WorkerThreads[ThreadIdx].ThreadIdx = ThreadIdx + 1;
+		WorkerThreads[ThreadIdx].pThis = this;
 #ifdef _WIN32
-	WorkerThreads[ThreadIdx].threadHandle = (HANDLE)_beginthreadex(nullptr,0x0fffff,KMerThreadStart,&WorkerThreads[ThreadIdx],0,&WorkerThreads[ThreadIdx].threadID);
+		WorkerThreads[ThreadIdx].threadHandle = (HANDLE)_beginthreadex(nullptr,0x0fffff,KMerThreadStart,&WorkerThreads[ThreadIdx],0,&WorkerThreads[ThreadIdx].threadID);
 #else
-	WorkerThreads[ThreadIdx].threadRslt =	pthread_create (&WorkerThreads[ThreadIdx].threadID , nullptr , KMerThreadStart , &WorkerThreads[ThreadIdx] );
+		WorkerThreads[ThreadIdx].threadRslt =	pthread_create (&WorkerThreads[ThreadIdx].threadID , nullptr , KMerThreadStart , &WorkerThreads[ThreadIdx] );
 #endif
-	}
+		}
 
-// allow threads a few seconds to startup
+	// allow threads a few seconds to startup
 #ifdef _WIN32
-	Sleep(10000);
+		Sleep(10000);
 #else
-	sleep(10);
+		sleep(10);
 #endif
 
-// let user know that this K-mer processing process is working hard...
-NumPutativePrefixKMers = GetKMerProcProgress(&TotSenseCnts,&TotAntisenseCnts);
-gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress - putative prefix K-Mers: %zd",NumPutativePrefixKMers);
+	// let user know that this K-mer processing process is working hard...
+	NumPutativePrefixKMers = GetKMerProcProgress(&TotSenseCnts,&TotAntisenseCnts);
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress - putative prefix K-Mers: %zd",NumPutativePrefixKMers);
 
-// wait for all threads to have completed
-for(ThreadIdx = 0; ThreadIdx < NumActiveThreads; ThreadIdx++)
-	{
-#ifdef _WIN32
-	while(WAIT_TIMEOUT == WaitForSingleObject( WorkerThreads[ThreadIdx].threadHandle, 60000 * 10))
+	// wait for all threads to have completed
+	for(ThreadIdx = 0; ThreadIdx < NumActiveThreads; ThreadIdx++)
 		{
-		NumPutativePrefixKMers = GetKMerProcProgress(&TotSenseCnts,&TotAntisenseCnts);
-		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress - putative prefix K-Mers: %zd",NumPutativePrefixKMers);
-		}
-	CloseHandle( WorkerThreads[ThreadIdx].threadHandle);
+#ifdef _WIN32
+		while(WAIT_TIMEOUT == WaitForSingleObject( WorkerThreads[ThreadIdx].threadHandle, 60000 * 10))
+			{
+			NumPutativePrefixKMers = GetKMerProcProgress(&TotSenseCnts,&TotAntisenseCnts);
+			gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress - putative prefix K-Mers: %zd",NumPutativePrefixKMers);
+			}
+		CloseHandle( WorkerThreads[ThreadIdx].threadHandle);
 #else
-	struct timespec ts;
-	int JoinRlt;
-	clock_gettime(CLOCK_REALTIME, &ts);
-	ts.tv_sec += 60 * 10;
-	while((JoinRlt = pthread_timedjoin_np(WorkerThreads[ThreadIdx].threadID, nullptr, &ts)) != 0)
-		{
-		NumPutativePrefixKMers = GetKMerProcProgress(&TotSenseCnts,&TotAntisenseCnts);
-		gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress - putative prefix K-Mers: %zd",NumPutativePrefixKMers);
-		ts.tv_sec += 60;
-		}
+		struct timespec ts;
+		int JoinRlt;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += 60 * 10;
+		while((JoinRlt = pthread_timedjoin_np(WorkerThreads[ThreadIdx].threadID, nullptr, &ts)) != 0)
+			{
+			NumPutativePrefixKMers = GetKMerProcProgress(&TotSenseCnts,&TotAntisenseCnts);
+			gDiagnostics.DiagOut(eDLInfo,gszProcName,"Progress - putative prefix K-Mers: %zd",NumPutativePrefixKMers);
+			ts.tv_sec += 60;
+			}
 #endif
+		}
 	}
 
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Completed - putative prefix K-Mers: %zd",m_NumPutMarkers);
@@ -89,6 +89,7 @@ class CMarkerKMers
 	int m_SuffixLen;				// K-mer suffix length
 	int m_MinWithPrefix;			// minimum number of cultivars required to have the shared prefix
 	int m_MaxHomozygotic;			// only report prefixes if K-Mer suffixes are homozygotic between a maximum of this many cultivars, if 0 then no homozygotic check
+	int m_ExtMemMB;					// if > 0 then K-mers are counted by CExtKMerCounts within this memory budget in MB rather than by iterating the suffix array
 	int m_NumThreads;				// number of worker threads requested
 
 	uint32_t m_NumPrefixKMers;		// current total number of accepted unique prefixed KMers
@@ -172,6 +173,7 @@ public:
 		  int SuffixLen,				// cultivar specific suffix length
 		  int MinWithPrefix,			// minimum number of cultivars required to have the shared prefix
 		  int MaxHomozygotic,			// only report prefixes if K-Mer suffixes are homozygotic between a maximum of this many cultivars, if 0 then no homozygotic check
+		  int ExtMemMB,					// if > 0 then count K-mers in partitions spilled to temp files bounded by this memory budget in MB
 		  char *pszSfxPseudoGenome,		// contains pregenerated suffix over psuedochromosomes for each cultivar
 		  char *pszMarkerFile,			// output potential markers to this file
 		  int NumThreads);				// max number of threads allowed
@@ -57,6 +57,7 @@ ProcessReadsetDist(etRSDMode PMode,				// processing mode; default is for indepe
 				int MinContamLen,				// accept contaminant overlaps if overlap at least this many bases 
 				int ReqMaxDupSeeds,				// requested to sample for this many duplicate seeds
 				int MinPhredScore,				// only accept reads for duplicate and KMer processing if mean Phred score is at least this threshold 
+				int SampleNth,					// sample every Nth read, or read pair, for analysis
 				int NumThreads,					// number of worker threads to use
 				bool bAffinity,					// thread to core affinity
 				int NumPE1InputFiles,			// number of PE1 input files
@@ -97,6 +98,7 @@ int KMerCCC;				// concordance correlation coefficient measure KMer length
 int MaxContamSubRate;		// max allowed contamimant substitution rate (bases per 25bp of contaminant overlap, 1st 15bp of overlap no subs allowed)
 int MinContamLen;			// accept contaminant overlaps if overlap at least this many bases 
 int MinPhredScore;			// only accept reads for duplicate and KMer processing if mean Phred score is at least this threshold 
+int SampleNth;				// sample every Nth read, or read pair, for analysis
 
 int NumberOfProcessors;		// number of installed CPUs
 int NumThreads;				// number of threads (0 defaults to number of CPUs)
@@ -130,6 +132,8 @@ struct arg_int *trim3 = arg_int0("Y", "trim3", "<int>", "trim this number of bas
 
 struct arg_int *minphredscore = arg_int0("p", "minphred", "<int>", "only accept reads for duplicate and KMer processing if mean Phred score is at least this threshold (default 0 to ignore, range 10..40)");
 
+struct arg_int *samplenthrawread = arg_int0("#", "samplenthrawread", "<int>", "sample every Nth raw read or read pair for analysis, proportions are reported with 95% confidence bounds (default 1, range 1..10000)");
+
 struct arg_int *maxkmerlen = arg_int0("k", "maxkmerlen", "<int>", "maximum K-Mer length processing (default is 6, range 3..12)");
 struct arg_int *kmerccc = arg_int0("K", "kmerccc", "<int>", "concordance correlation coefficient measure KMer length (default is 6, range 1..maxkmerlen)");
 
@@ -151,7 +155,7 @@ struct arg_str *experimentdescr = arg_str0("W", "experimentdescr", "<str>", "exp
 struct arg_end *end = arg_end(200);
 
 void *argtable[] = { help, version, FileLogLevel, LogFile,
-	pmode, strand, trim5, trim3,maxkmerlen,kmerccc, reqmaxdupseeds,minphredscore, maxcontamsubrate,mincontamlen,contaminantfile, inpe1files, inpe2files, outfile, // outhtmlfile,
+	pmode, strand, trim5, trim3,maxkmerlen,kmerccc, reqmaxdupseeds,minphredscore, samplenthrawread, maxcontamsubrate,mincontamlen,contaminantfile, inpe1files, inpe2files, outfile, // outhtmlfile,
 	summrslts, experimentname, experimentdescr,
 	threads,
 	end };
@@ -322,6 +326,13 @@ if (!argerrors)
 		exit(1);
 		}
 
+	SampleNth = samplenthrawread->count ? samplenthrawread->ival[0] : 1;
+	if (SampleNth < 1 || SampleNth > cMaxRSSampleNth)
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Error: Sample every Nth read '-#%d' specified outside of range 1..%d\n", SampleNth, cMaxRSSampleNth);
+		exit(1);
+		}
+
 	KMerCCC = kmerccc->count ? kmerccc->ival[0] : min(6,MaxKMerLen);
 	if (KMerCCC < 1 || KMerCCC > MaxKMerLen)
 		{
@@ -515,6 +526,9 @@ if (!argerrors)
 	gDiagnostics.DiagOutMsgOnly(eDLInfo, "Max number of duplicate seed reads : %d", ReqMaxDupSeeds);
 
 	gDiagnostics.DiagOutMsgOnly(eDLInfo, "Min Phred threshold score for duplicate and K-mer distributions : %d", MinPhredScore);
+
+	if(SampleNth > 1)
+		gDiagnostics.DiagOutMsgOnly(eDLInfo, "Sampling every : %d reads", SampleNth);
 	
 
 	gDiagnostics.DiagOutMsgOnly(eDLInfo, "trim 5' ends raw reads by : %d", Trim5);
@@ -567,6 +581,7 @@ if (!argerrors)
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID, ePTInt32, (int)sizeof(Trim3), "trim3", &Trim3);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID, ePTInt32, (int)sizeof(MaxKMerLen), "maxkmerlen", &MaxKMerLen);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID, ePTInt32, (int)sizeof(MinPhredScore), "minphredscore", &MinPhredScore);
+		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID, ePTInt32, (int)sizeof(SampleNth), "samplenthrawread", &SampleNth);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID, ePTInt32, (int)sizeof(KMerCCC), "kmerccc", &KMerCCC);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID, ePTInt32, sizeof(NumPE1InputFiles), "NumPE1InputFiles", &NumPE1InputFiles);
 		for (Idx = 0; Idx < NumPE1InputFiles; Idx++)
@@ -612,6 +627,7 @@ if (!argerrors)
 							  MinContamLen,				// accept contaminant overlaps if overlap at least this many bases 
 							  ReqMaxDupSeeds,			// requested to sample for this many duplicate seeds and off target alignments
 							  MinPhredScore,			// only accept reads for duplicate and KMer processing if their mean Phred score is at least this threshold 
+							  SampleNth,				// sample every Nth read, or read pair, for analysis
 							  NumThreads,				// number of worker threads to use
 							  bAffinity,				// thread to core affinity
 							  NumPE1InputFiles,			// number of PE1 input files
@@ -676,6 +692,7 @@ Rslt = pReadStats->ProcessReadsetDist(pPars->PMode,			// processing mode; eRSDin
 						pPars->MinContamLen,				// accept contaminant overlaps if overlap at least this many bases 
 						pPars->ReqMaxDupSeeds,				// requested to sample this many reads for duplicates and off target alignments
 						pPars->MinPhredScore,				// only accept reads for duplicate and KMer processing if their mean Phred score is at least this threshold
+						pPars->SampleNth,					// sample every Nth read, or read pair, for analysis
 						pPars->NumThreads,					// number of worker threads to use
 						pPars->bAffinity,					// thread to core affinity
 						pPars->NumPE1InputFiles,			// number of PE1 input files
@@ -707,6 +724,7 @@ ProcessReadsetDist(etRSDMode PMode,					// processing mode; eRSDindependent or e
 					int MinContamLen,				// accept contaminant overlaps if overlap at least this many bases 
 					int ReqMaxDupSeeds,				// requested to sample for this many duplicate seeds and off target alignments
 					int MinPhredScore,				// only accept reads for duplicate and KMer processing if their mean Phred score is at least this threshold 
+					int SampleNth,					// sample every Nth read, or read pair, for analysis
 					int NumThreads,					// number of worker threads to use
 					bool bAffinity,					// thread to core affinity
 					int NumPE1InputFiles,			// number of PE1 input files
@@ -751,6 +769,7 @@ if(PMode == eRSDpooled || NumPE1InputFiles == 1) 			// if pooling all input read
 						MinContamLen,				// accept contaminant overlaps if overlap at least this many bases 
 						ReqMaxDupSeeds,				// requested to sample this many reads for duplicates and off target alignments
 						MinPhredScore,				// only accept reads for duplicate and KMer processing if their mean Phred score is at least this threshold
+						SampleNth,					// sample every Nth read, or read pair, for analysis
 						NumThreads,					// number of worker threads to use
 						bAffinity,					// thread to core affinity
 						NumPE1InputFiles,			// number of PE1 input files
@@ -812,6 +831,7 @@ else
 		pCurNGSQCThread->MinContamLen = MinContamLen;
 		pCurNGSQCThread->ReqMaxDupSeeds = ReqMaxDupSeeds;
 		pCurNGSQCThread->MinPhredScore = MinPhredScore;
+		pCurNGSQCThread->SampleNth = SampleNth;
 		pCurNGSQCThread->NumThreads = 1;
 		pCurNGSQCThread->bAffinity = bAffinity;
 		pCurNGSQCThread->NumPE1InputFiles = 1;
@@ -931,6 +951,9 @@ m_PMode = eRSDindependent;
 m_bStrand = false;
 m_ReqMaxDupSeeds = 0;
 m_ActMaxDupSeeds = 0;
+m_SampleNth = 1;
+m_bShardKMerCnts = false;
+m_MaxShardKMerCntsMem = 0;
 m_NumThreads = 1;
 m_bAffinity = false;
 m_NumPE1InputFiles = 0;
@@ -1139,8 +1162,10 @@ void *ThreadedNGSQC(void * pThreadPars)
 
 
 
+// contaminants are loaded before any thread is started and are thereafter read only, hit counts are accumulated into the calling thread's own counts
 int				// <0 if errors, 0 if no matches, >0 at least one contaminant sequence overlapping
-CReadStats::LocateContaminentMatch(int SeqLen,			// targ sequence is of this length
+CReadStats::LocateContaminentMatch(tsThreadNGSQCPars *pThread, // thread specific processing state and context
+								int SeqLen,				// targ sequence is of this length
 								etSeqBase *pSeq,		// target sequence	
 								bool bPE2)				// false if processing SE/PE1 read, true if PE2	
 {
@@ -1150,17 +1175,241 @@ if(m_pContaminates == nullptr)
 
 if(!bPE2)
 	{
-	if((Rslt = m_pContaminates->MatchContaminants(eAOF5PE1Targ,m_MaxContamSubRate,m_MinContamLen,SeqLen,pSeq))==0)
-		Rslt = m_pContaminates->MatchContaminants(eAOF3PE1Targ,m_MaxContamSubRate,m_MinContamLen,SeqLen,pSeq);
+	if((Rslt = m_pContaminates->MatchContaminants(eAOF5PE1Targ,m_MaxContamSubRate,m_MinContamLen,SeqLen,pSeq,pThread->pContamHitCnts))==0)
+		Rslt = m_pContaminates->MatchContaminants(eAOF3PE1Targ,m_MaxContamSubRate,m_MinContamLen,SeqLen,pSeq,pThread->pContamHitCnts);
 	}
 else
 	{
-	if((Rslt = m_pContaminates->MatchContaminants(eAOF5PE2Targ,m_MaxContamSubRate,m_MinContamLen,SeqLen,pSeq))==0)
-		Rslt = m_pContaminates->MatchContaminants(eAOF3PE2Targ,m_MaxContamSubRate,m_MinContamLen,SeqLen,pSeq);
+	if((Rslt = m_pContaminates->MatchContaminants(eAOF5PE2Targ,m_MaxContamSubRate,m_MinContamLen,SeqLen,pSeq,pThread->pContamHitCnts))==0)
+		Rslt = m_pContaminates->MatchContaminants(eAOF3PE2Targ,m_MaxContamSubRate,m_MinContamLen,SeqLen,pSeq,pThread->pContamHitCnts);
 	}
 return(Rslt);
 }
 
+// normal approximation of 95% binomial confidence bounds on sampled proportion, as a percentage
+static double
+SampledPropBounds(uint64_t NumHits,		// number of sampled hits
+				uint64_t NumSampled)	// out of this many samples
+{
+double Prop;
+if(NumSampled == 0)
+	return(0.0);
+Prop = (double)NumHits / NumSampled;
+return(100.0 * 1.96 * sqrt((Prop * (1.0 - Prop)) / NumSampled));
+}
+
+int
+CReadStats::AllocShard(tsThreadNGSQCPars *pThread,	// allocate thread's distribution shard
+					int MaxReadLen)					// for reads of up to this length
+{
+pThread->ShardAllocdReadLen = 0;
+pThread->ShardMinReadLen = 0;
+pThread->ShardMaxReadLen = 0;
+pThread->pShardBaseNs = nullptr;
+pThread->pShardScores = nullptr;
+pThread->AllocdShardKMerCntsMem = 0;
+pThread->bShardKMerCnts = m_bShardKMerCnts;
+pThread->pShardKMerCnts = nullptr;
+pThread->pContamHitCnts = nullptr;
+memset(pThread->ShardProbNoReadErrDist,0,sizeof(pThread->ShardProbNoReadErrDist));
+memset(pThread->ShardReadLenDist,0,sizeof(pThread->ShardReadLenDist));
+pThread->NumChkdPE1ContamHits = 0;
+pThread->NumPE1ContamHits = 0;
+pThread->NumChkdPE2ContamHits = 0;
+pThread->NumPE2ContamHits = 0;
+pThread->NumPresented = 0;
+pThread->NumAnalysed = 0;
+
+if(m_pContaminates != nullptr && (pThread->pContamHitCnts = m_pContaminates->AllocHitCnts()) == nullptr)
+	return(eBSFerrMem);
+return(GrowShard(pThread,MaxReadLen));
+}
+
+int
+CReadStats::GrowShard(tsThreadNGSQCPars *pThread,	// grow thread's distribution shard
+					int MaxReadLen)					// to hold reads of up to this length
+{
+int Rslt;
+uint32_t *pAllocd;
+size_t memreq;
+
+if(MaxReadLen > (int)cMaxRSSeqLen)
+	MaxReadLen = cMaxRSSeqLen;
+if(MaxReadLen <= pThread->ShardAllocdReadLen)
+	return(eBSFSuccess);
+
+if((pAllocd = (uint32_t *)realloc(pThread->pShardBaseNs,sizeof(uint32_t) * MaxReadLen)) == nullptr)
+	return(eBSFerrMem);
+memset(&pAllocd[pThread->ShardAllocdReadLen],0,sizeof(uint32_t) * (MaxReadLen - pThread->ShardAllocdReadLen));
+pThread->pShardBaseNs = pAllocd;
+
+if((pAllocd = (uint32_t *)realloc(pThread->pShardScores,sizeof(uint32_t) * MaxReadLen * 42)) == nullptr)			// Phred scores can range from 0 to 41 inclusive
+	return(eBSFerrMem);
+memset(&pAllocd[pThread->ShardAllocdReadLen * 42],0,sizeof(uint32_t) * (MaxReadLen - pThread->ShardAllocdReadLen) * 42);
+pThread->pShardScores = pAllocd;
+
+if(pThread->bShardKMerCnts)
+	{
+	memreq = (size_t)m_KMerCntsEls * MaxReadLen * sizeof(uint32_t);
+	if(memreq > m_MaxShardKMerCntsMem)		// growing would exceed this thread's share of the shard memory budget
+		{
+		if((Rslt = SpillShardKMerCnts(pThread)) < eBSFSuccess)
+			return(Rslt);
+		}
+	else
+		{
+		if((pAllocd = (uint32_t *)realloc(pThread->pShardKMerCnts,memreq)) == nullptr)
+			return(eBSFerrMem);
+		memset((uint8_t *)pAllocd + pThread->AllocdShardKMerCntsMem,0,memreq - pThread->AllocdShardKMerCntsMem);
+		pThread->pShardKMerCnts = pAllocd;
+		pThread->AllocdShardKMerCntsMem = memreq;
+		}
+	}
+pThread->ShardAllocdReadLen = MaxReadLen;
+return(eBSFSuccess);
+}
+
+void
+CReadStats::FreeShard(tsThreadNGSQCPars *pThread)	// free thread's distribution shard
+{
+if(pThread->pShardBaseNs != nullptr)
+	{
+	free(pThread->pShardBaseNs);		// was allocated with realloc
+	pThread->pShardBaseNs = nullptr;
+	}
+if(pThread->pShardScores != nullptr)
+	{
+	free(pThread->pShardScores);
+	pThread->pShardScores = nullptr;
+	}
+if(pThread->pShardKMerCnts != nullptr)
+	{
+	free(pThread->pShardKMerCnts);
+	pThread->pShardKMerCnts = nullptr;
+	}
+if(pThread->pContamHitCnts != nullptr)
+	{
+	CContaminants::FreeHitCnts(pThread->pContamHitCnts);
+	pThread->pContamHitCnts = nullptr;
+	}
+pThread->AllocdShardKMerCntsMem = 0;
+pThread->ShardAllocdReadLen = 0;
+}
+
+int
+CReadStats::MergeShard(tsThreadNGSQCPars *pThread)	// merge thread's distribution shard into the instance distributions
+{
+int Rslt;
+int Idx;
+int NumEls;
+uint32_t *pSrc;
+uint32_t *pDst;
+
+if(pThread->ShardMaxReadLen > 0)
+	{
+	if(pThread->ShardMaxReadLen > m_MaxReadLen)
+		m_MaxReadLen = pThread->ShardMaxReadLen;
+	if(m_MinReadLen == 0 || m_MinReadLen > pThread->ShardMinReadLen)
+		m_MinReadLen = pThread->ShardMinReadLen;
+	}
+for(Idx = 0; Idx < (int)cMaxRSSeqLen + 2; Idx++)
+	m_ReadLenDist[Idx] += pThread->ShardReadLenDist[Idx];
+for(Idx = 0; Idx < 100; Idx++)
+	m_ProbNoReadErrDist[Idx] += pThread->ShardProbNoReadErrDist[Idx];
+
+NumEls = pThread->ShardMaxReadLen;	// only offsets up to the maximum read length accumulated can be non-zero
+pSrc = pThread->pShardBaseNs;
+pDst = m_pBaseNs;
+for(Idx = 0; Idx < NumEls; Idx++)
+	*pDst++ += *pSrc++;
+pSrc = pThread->pShardScores;
+pDst = m_pScores;
+for(Idx = 0; Idx < NumEls * 42; Idx++)
+	*pDst++ += *pSrc++;
+
+if(pThread->pShardKMerCnts != nullptr && NumEls > 0)
+	{
+	if(NumEls > m_AllocdMaxReadLen && (Rslt = ReallocKMerCnts(NumEls)) < eBSFSuccess)
+		return(Rslt);
+	pSrc = pThread->pShardKMerCnts;
+	pDst = m_pKMerCnts;
+	for(size_t ElIdx = 0; ElIdx < (size_t)m_KMerCntsEls * NumEls; ElIdx++)
+		*pDst++ += *pSrc++;
+	}
+
+m_NumChkdPE1ContamHits += pThread->NumChkdPE1ContamHits;
+m_NumPE1ContamHits += pThread->NumPE1ContamHits;
+m_NumChkdPE2ContamHits += pThread->NumChkdPE2ContamHits;
+m_NumPE2ContamHits += pThread->NumPE2ContamHits;
+if(m_pContaminates != nullptr && pThread->pContamHitCnts != nullptr)
+	m_pContaminates->MergeHitCnts(pThread->pContamHitCnts);
+return(eBSFSuccess);
+}
+
+int
+CReadStats::SpillShardKMerCnts(tsThreadNGSQCPars *pThread)	// merge thread's K-mer count shard into m_pKMerCnts, free the shard, and serialise the thread's further K-mer counts
+{
+int Rslt;
+int NumEls;
+uint32_t *pSrc;
+uint32_t *pDst;
+
+Rslt = eBSFSuccess;
+NumEls = pThread->ShardMaxReadLen;	// only offsets up to the maximum read length accumulated can be non-zero
+if(pThread->pShardKMerCnts != nullptr)
+	{
+	if(NumEls > 0)
+		{
+		AcquireSerialiseKMers();
+		if(NumEls > m_AllocdMaxReadLen)
+			Rslt = ReallocKMerCnts(NumEls);
+		if(Rslt >= eBSFSuccess)
+			{
+			pSrc = pThread->pShardKMerCnts;
+			pDst = m_pKMerCnts;
+			for(size_t ElIdx = 0; ElIdx < (size_t)m_KMerCntsEls * NumEls; ElIdx++)
+				*pDst++ += *pSrc++;
+			}
+		ReleaseSerialiseKMers();
+		}
+	free(pThread->pShardKMerCnts);		// was allocated with realloc
+	pThread->pShardKMerCnts = nullptr;
+	}
+pThread->AllocdShardKMerCntsMem = 0;
+pThread->bShardKMerCnts = false;
+return(Rslt);
+}
+
+int
+CReadStats::ReallocKMerCnts(int MaxReadLen)		// realloc m_pKMerCnts to hold counts for reads of up to this length
+{
+uint32_t *pAllocd;
+int AllocdMaxReadLen;
+size_t memreq;
+if(MaxReadLen <= m_AllocdMaxReadLen)
+	return(eBSFSuccess);
+AllocdMaxReadLen = (MaxReadLen * 120) / 100;
+memreq = (size_t)m_KMerCntsEls * AllocdMaxReadLen * sizeof(uint32_t);
+gDiagnostics.DiagOut(eDLInfo, gszProcName, "ReallocKMerCnts: Memory re-allocation to %zd bytes", (int64_t)memreq);
+#ifdef _WIN32
+pAllocd = (uint32_t *)realloc(m_pKMerCnts, memreq);
+#else
+pAllocd = (uint32_t *)mremap(m_pKMerCnts,m_AllocdKMerCntsMem,memreq,MREMAP_MAYMOVE);
+if(pAllocd == MAP_FAILED)
+	pAllocd = nullptr;
+#endif
+if(pAllocd == nullptr)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"ReallocKMerCnts: Memory re-allocation to %zd bytes - %s", (int64_t)memreq,strerror(errno));
+	return(eBSFerrMem);
+	}
+memset((uint8_t *)pAllocd + m_AllocdKMerCntsMem,0,memreq - m_AllocdKMerCntsMem);
+m_pKMerCnts = pAllocd;
+m_AllocdKMerCntsMem = memreq;
+m_AllocdMaxReadLen = AllocdMaxReadLen;
+return(eBSFSuccess);
+}
+
 int
 CReadStats::ProcessReadsetDist(etRSDMode PMode,		// processing mode; eRSDindependent or eRSDpooled
 					int ProcessingID,				// processing instance identifier, used if processing eRSDindependent to identify output file instances 
@@ -1173,6 +1422,7 @@ CReadStats::ProcessReadsetDist(etRSDMode PMode,		// processing mode; eRSDindepen
 					int MinContamLen,				// accept contaminant overlaps if overlap at least this many bases 
 					int ReqMaxDupSeeds,				// requested to sample for this many duplicate seeds
 					int MinPhredScore,				// only accept reads for duplicate and KMer processing if their mean Phred score is at least this threshold
+					int SampleNth,					// sample every Nth read, or read pair, for analysis
 					int NumThreads,					// number of worker threads to use
 					bool bAffinity,					// thread to core affinity
 					int NumPE1InputFiles,			// number of PE1 input files
@@ -1346,6 +1596,7 @@ if (m_bPEProc)
 
 m_ReqMaxDupSeeds = ReqMaxDupSeeds;
 m_MinMeanPhredScore = MinPhredScore;
+m_SampleNth = SampleNth < 1 ? 1 : SampleNth;
 
 // single pass over input readsets is required
 CSimpleGlob glob(SG_GLOB_FULLSORT);
@@ -1544,6 +1795,9 @@ if (m_pKMerCnts == MAP_FAILED)
 #endif
 m_AllocdKMerCntsMem = memreq;
 memset(m_pKMerCnts,0,memreq);
+// if too large for each worker thread to have it's own shard within the shard memory budget then K-mer counts are serialised into m_pKMerCnts
+m_MaxShardKMerCntsMem = cMaxRSKMerShardsMem / max(1,min(NumThreads,m_NumPE1InFiles));	// files are processed one per thread so never more shards than files
+m_bShardKMerCnts = memreq <= m_MaxShardKMerCntsMem ? true : false;
 
 m_AllocdSampledSeqWrds = ((sizeof(tsSampledSeq)+3) / 4) + (((m_EstPE1MeanReadLen + m_EstPE2MeanReadLen + 5) + 15) / 16);	// 2bits per base and 16 bases per 32bit word, also allowing additional 5 bases as lengths are estimated	
 m_AllocdSampledSeqWrds *= ReqMaxDupSeeds;
@@ -1586,12 +1840,28 @@ if ((pThreads = new tsThreadNGSQCPars[NumThreads]) == nullptr)
 	}
 memset(pThreads,0,sizeof(tsThreadNGSQCPars) * NumThreads);
 int ThreadIdx;
+pThread = pThreads;
+for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThread++)
+	{
+	if((Rslt = AllocShard(pThread,m_AllocdMaxReadLen)) < eBSFSuccess)
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "ProcessReadsetDist: (Instance %d) Memory allocation for thread distribution shards failed",ProcessingID);
+		pThread = pThreads;
+		for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThread++)
+			FreeShard(pThread);
+		delete [] pThreads;
+		Reset();
+		return(Rslt);
+		}
+	}
+
 pThread = pThreads;
 for (ThreadIdx = 1; ThreadIdx <= NumThreads; ThreadIdx++, pThread++)
 	{
 	pThread->ThreadIdx = ThreadIdx;
 	pThread->pThis = this;
 	pThread->ProcessingID = ProcessingID;
+	pThread->NumInflateThreads = max(1,m_NumThreads / NumThreads);	// share any threads surplus to the number of input files
 
 #ifdef _WIN32
 	pThread->threadHandle = (HANDLE)_beginthreadex(nullptr, 0x0fffff, ThreadedNGSQC, pThread, 0, &pThread->threadID);
@@ -1627,6 +1897,18 @@ for (ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++, pThread++)
 
 DeleteMutexes();
 
+// all threads have completed so their distribution shards can now be merged without serialisation
+pThread = pThreads;
+for (ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++, pThread++)
+	{
+	if(!m_bTerminate && (Rslt = MergeShard(pThread)) < eBSFSuccess)
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "ProcessReadsetDist: (Instance %d) Unable to merge thread distribution shards",ProcessingID);
+		m_bTerminate = true;
+		}
+	FreeShard(pThread);
+	}
+
 if (m_bTerminate)		// early termination because of some problem?
 	{
 	delete [] pThreads;
@@ -1642,6 +1924,8 @@ int64_t TotNumPEReads;
 int64_t NotProcNs;
 int64_t NotProcQS;
 int64_t NotProcUL;
+int64_t NumPresented;
+int64_t NumAnalysed;
 
 
 TotNumSEReads = 0;
@@ -1649,11 +1933,15 @@ TotNumPEReads = 0;
 NotProcNs = 0;
 NotProcQS = 0;
 NotProcUL = 0;
+NumPresented = 0;
+NumAnalysed = 0;
 
 for (ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++, pThread++)
 	{
 	TotNumSEReads += pThread->TotNumSEReads;
 	TotNumPEReads += pThread->TotNumPEReads;
+	NumPresented += pThread->NumPresented;
+	NumAnalysed += pThread->NumAnalysed;
 
 	NotProcNs += pThread->SeqCharacteristics.NotProcNs;
 	NotProcQS += pThread->SeqCharacteristics.NotProcQS;
@@ -1665,6 +1953,8 @@ if (!m_bPEProc)
 else
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d) Total of %zu reads, %zu PE pairs processed", ProcessingID, TotNumSEReads, TotNumPEReads);
 
+if(m_SampleNth > 1)
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d) Sampling every %d %s, %zd of %zd were sampled for analysis", ProcessingID, m_SampleNth, m_bPEProc ? "read pairs" : "reads", NumAnalysed, NumPresented);
 gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d) Total of %zu reads not accepted for processing as they were underlength", ProcessingID, NotProcUL);
 
 gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d) Total of %lu reads used as seed duplicates", ProcessingID, m_ActMaxDupSeeds);
@@ -1715,11 +2005,22 @@ if (m_pSampledSeqs != nullptr)
 	}
 
 // log 1..10 duplicate instance counts
-for (Idx = 0; Idx < 10; Idx++)
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d)  %d: %2.2f", ProcessingID, Idx + 1, (100.0 * DupDist10[Idx]) / TotalDupReads);
+// if sampling then proportions are estimates, reported with their normal approximation 95% binomial confidence bounds
+if(m_SampleNth > 1)
+	{
+	for (Idx = 0; Idx < 10; Idx++)
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d)  %d: %2.2f +/- %2.2f", ProcessingID, Idx + 1, (100.0 * DupDist10[Idx]) / TotalDupReads, SampledPropBounds(DupDist10[Idx],TotalDupReads));
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d) Contaminants PE1 Checked: %u Contaminated: %u Percentage: %1.4f +/- %1.4f", ProcessingID,m_NumChkdPE1ContamHits,m_NumPE1ContamHits,m_NumChkdPE1ContamHits ? (m_NumPE1ContamHits*100.0)/m_NumChkdPE1ContamHits : 0.0,SampledPropBounds(m_NumPE1ContamHits,m_NumChkdPE1ContamHits));
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d) Contaminants PE2 Checked: %u Contaminated: %u Percentage: %1.4f +/- %1.4f", ProcessingID,m_NumChkdPE2ContamHits,m_NumPE2ContamHits,m_NumChkdPE2ContamHits ? (m_NumPE2ContamHits*100.0)/m_NumChkdPE2ContamHits : 0.0,SampledPropBounds(m_NumPE2ContamHits,m_NumChkdPE2ContamHits));
+	}
+else
+	{
+	for (Idx = 0; Idx < 10; Idx++)
+		gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d)  %d: %2.2f", ProcessingID, Idx + 1, (100.0 * DupDist10[Idx]) / TotalDupReads);
 
-gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d) Contaminants PE1 Checked: %u Contaminated: %u Percentage: %1.4f", ProcessingID,m_NumChkdPE1ContamHits,m_NumPE1ContamHits,m_NumChkdPE1ContamHits ? (m_NumPE1ContamHits*100.0)/m_NumChkdPE1ContamHits : 0.0);
-gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d) Contaminants PE2 Checked: %u Contaminated: %u Percentage: %1.4f", ProcessingID,m_NumChkdPE2ContamHits,m_NumPE2ContamHits,m_NumChkdPE2ContamHits ? (m_NumPE2ContamHits*100.0)/m_NumChkdPE2ContamHits : 0.0);
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d) Contaminants PE1 Checked: %u Contaminated: %u Percentage: %1.4f", ProcessingID,m_NumChkdPE1ContamHits,m_NumPE1ContamHits,m_NumChkdPE1ContamHits ? (m_NumPE1ContamHits*100.0)/m_NumChkdPE1ContamHits : 0.0);
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "(Instance %d) Contaminants PE2 Checked: %u Contaminated: %u Percentage: %1.4f", ProcessingID,m_NumChkdPE2ContamHits,m_NumPE2ContamHits,m_NumChkdPE2ContamHits ? (m_NumPE2ContamHits*100.0)/m_NumChkdPE2ContamHits : 0.0);
+	}
 
 CBKPLPlot *pPlots;
 if((pPlots = new CBKPLPlot)==nullptr)
@@ -2634,7 +2935,7 @@ if(m_bPEProc == false)
 
 if(bIsSAMfile)
 	{
-	if((Rslt = (teBSFrsltCodes)SAMfile.Open(pPE1File->szFileName)) != eBSFSuccess)
+	if((Rslt = (teBSFrsltCodes)SAMfile.Open(pPE1File->szFileName,pThread->NumInflateThreads)) != eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLFatal, gszProcName, "(Instance %d) Thread %d: Unable to open '%s' [%s] %s", pThread->ProcessingID, pThread->ThreadIdx, pPE1File->szFileName, FastaPE1.ErrText((teBSFrsltCodes)Rslt), FastaPE1.GetErrMsg());
 		return(Rslt);
@@ -2642,7 +2943,7 @@ if(bIsSAMfile)
 	}
 else
 	{
-	if ((Rslt = (teBSFrsltCodes)FastaPE1.Open(pPE1File->szFileName, true, cDfltStageBuffSize)) != eBSFSuccess)
+	if ((Rslt = (teBSFrsltCodes)FastaPE1.Open(pPE1File->szFileName, true, cDfltStageBuffSize, pThread->NumInflateThreads)) != eBSFSuccess)
 		{
 		gDiagnostics.DiagOut(eDLFatal, gszProcName, "(Instance %d) Thread %d: Unable to open '%s' [%s] %s", pThread->ProcessingID, pThread->ThreadIdx, pPE1File->szFileName, FastaPE1.ErrText((teBSFrsltCodes)Rslt), FastaPE1.GetErrMsg());
 		return(Rslt);
@@ -2657,7 +2958,7 @@ else
 
 	if (m_bPEProc)
 		{
-		if ((Rslt = (teBSFrsltCodes)FastaPE2.Open(pPE2File->szFileName, true, cDfltStageBuffSize)) != eBSFSuccess)
+		if ((Rslt = (teBSFrsltCodes)FastaPE2.Open(pPE2File->szFileName, true, cDfltStageBuffSize, pThread->NumInflateThreads)) != eBSFSuccess)
 			{
 			gDiagnostics.DiagOut(eDLFatal, gszProcName, "(Instance %d) Thread %d: Unable to open '%s' [%s] %s", pThread->ProcessingID, pThread->ThreadIdx, pPE2File->szFileName, FastaPE2.ErrText((teBSFrsltCodes)Rslt), FastaPE2.GetErrMsg());
 			FastaPE1.Close();
@@ -3336,7 +3637,7 @@ if(ReadLen > cMaxRSSeqLen)					// silently truncate if overlength
 else
 	bTrunc = false;
 
-// scores are parsed into a local copy then when sequence completely parsed then the local copy is updated into the global scores within a single serialisation lock
+// scores are parsed into a local copy then when sequence completely parsed then the local copy is updated into the thread's own distribution shard
 MinScore = 0;
 ProbNoReadErr = 1.0;
 SumBaseScores = 0;
@@ -3388,30 +3689,33 @@ for (SeqOfs = 0; SeqOfs < ReadLen; SeqOfs++, pSeq++, pNs++, pScore++,pQScores++)
 	}
 MeanReadScore = SumBaseScores /  ReadLen;
 
-pScores = m_pScores;
+if(ReadLen > pThread->ShardAllocdReadLen && GrowShard(pThread,(ReadLen * 120) / 100) < eBSFSuccess)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Thread %d: Memory re-allocation for distribution shard - %s",pThread->ThreadIdx,strerror(errno));
+	return(eBSFerrMem);
+	}
+pScores = pThread->pShardScores;
 pScore = Scores;
 pNs = Ns;
-pBaseNs = m_pBaseNs;
-AcquireSerialiseScores();
+pBaseNs = pThread->pShardBaseNs;
 for (SeqOfs = 0; SeqOfs < ReadLen; SeqOfs++, pScore++, pBaseNs++, pNs++, pScores += 42)
 	{
 	pScores[*pScore] += 1;
 	*pBaseNs += *pNs;
 	}
-if(ReadLen > m_MaxReadLen)
-	m_MaxReadLen = ReadLen;
-if(m_MinReadLen == 0 || m_MinReadLen > ReadLen)
-	m_MinReadLen = ReadLen;
-m_ReadLenDist[ReadLen] += 1;
+if(ReadLen > pThread->ShardMaxReadLen)
+	pThread->ShardMaxReadLen = ReadLen;
+if(pThread->ShardMinReadLen == 0 || pThread->ShardMinReadLen > ReadLen)
+	pThread->ShardMinReadLen = ReadLen;
+pThread->ShardReadLenDist[ReadLen] += 1;
 if(bTrunc)
-	m_ReadLenDist[cMaxRSSeqLen+1] += 1;
+	pThread->ShardReadLenDist[cMaxRSSeqLen+1] += 1;
 
 int ProbNoReadErrBinIdx;
 ProbNoReadErrBinIdx = (int)(ProbNoReadErr * 100);
 if(ProbNoReadErrBinIdx > 99)
 	ProbNoReadErrBinIdx = 99;
-m_ProbNoReadErrDist[ProbNoReadErrBinIdx] += 1;
-ReleaseSerialiseScores();
+pThread->ShardProbNoReadErrDist[ProbNoReadErrBinIdx] += 1;
 return(MinScore);
 }
 
@@ -3428,6 +3732,7 @@ uint32_t PackedKMerMsk;
 uint32_t KMerMsk;
 int KMerLen;
 int KmerCntsOfs;
+uint32_t *pKMerCnts;
 uint32_t *pKMerCntsSeqOfs;
 uint32_t KMerOfs;
 uint32_t KMerLenOfs;
@@ -3473,29 +3778,25 @@ for (SeqOfs = 0; SeqOfs < (ReadLen + m_MaxKMerLen); SeqOfs++, pSeq++)
 	KMerOfs += m_KMerCntsEls;	
 	}
 
-AcquireSerialiseKMers();
-// ensure allocation for KMerCnts is sufficent for read lengths
-if(ReadLen > m_AllocdMaxReadLen)
+// if sharded then counts are accumulated into the thread's own shard without serialisation
+// growing the shard may instead switch this thread to serialised counts if the shard would exceed the thread's share of the shard memory budget
+if(pThread->bShardKMerCnts && ReadLen > pThread->ShardAllocdReadLen && GrowShard(pThread,(ReadLen * 120) / 100) < eBSFSuccess)
 	{
-	uint32_t *pAllocd;
-	m_AllocdMaxReadLen = (ReadLen * 120) / 100;
-	size_t memreq = m_KMerCntsEls * m_AllocdMaxReadLen * sizeof(uint32_t);
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "AddReadInst: Memory re-allocation to %d bytes", memreq);
-#ifdef _WIN32
-	pAllocd = (uint32_t *)realloc(m_pKMerCnts, memreq);
-#else
-	pAllocd = (uint32_t *)mremap(m_pKMerCnts,m_AllocdKMerCntsMem,memreq,MREMAP_MAYMOVE);
-	if(pAllocd == MAP_FAILED)
-		pAllocd = nullptr;
-#endif
-	if(pAllocd == nullptr)
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Thread %d: Memory re-allocation for K-mer distribution shard - %s",pThread->ThreadIdx,strerror(errno));
+	return(eBSFerrMem);
+	}
+if(pThread->bShardKMerCnts)
+	pKMerCnts = pThread->pShardKMerCnts;
+else
+	{
+	AcquireSerialiseKMers();
+	// ensure allocation for KMerCnts is sufficent for read lengths
+	if(ReadLen > m_AllocdMaxReadLen && ReallocKMerCnts(ReadLen) < eBSFSuccess)
 		{
-		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Thread %d: Memory re-allocation to %d bytes - %s",pThread->ThreadIdx, memreq,strerror(errno));
-		ReleaseSerialise();
+		ReleaseSerialiseKMers();
 		return(eBSFerrMem);
 		}
-	m_pKMerCnts = pAllocd;
-	m_AllocdKMerCntsMem = memreq;
+	pKMerCnts = m_pKMerCnts;
 	}
 
 pKMerCntsSeqOfs = pThread->KMerCntOfs;
@@ -3503,9 +3804,10 @@ for(SeqOfs = 0; SeqOfs < ReadLen; SeqOfs++)
 	{
 	for(KMerLen = 0; KMerLen < m_MaxKMerLen; KMerLen++,pKMerCntsSeqOfs++)
 		if(SeqOfs + KMerLen < ReadLen)					// sloughing cnts for k-mers which would have extended out past the end of reads
-			m_pKMerCnts[*pKMerCntsSeqOfs] += 1;		
+			pKMerCnts[*pKMerCntsSeqOfs] += 1;		
 	}	
-ReleaseSerialiseKMers();
+if(!pThread->bShardKMerCnts)
+	ReleaseSerialiseKMers();
 return(0);
 }
 
@@ -3596,6 +3898,17 @@ uint8_t *pScore;
 bool bPE1Contaminated;
 bool bPE2Contaminated;
 
+// if sampling then only every Nth read, or read pair, is analysed, the remainder are only counted
+pThread->NumPresented += 1;
+if(m_SampleNth > 1 && ((pThread->NumPresented - 1) % m_SampleNth) != 0)
+	{
+	pPE1File->SeqCharacteristics.NumReads += 1;
+	if (m_bPEProc)
+		pPE2File->SeqCharacteristics.NumReads += 1;
+	return(eBSFSuccess);
+	}
+pThread->NumAnalysed += 1;
+
 // remove any flags which may be present in the sequences
 if(PE1ReadLen > 0 && pPE1RawRead != nullptr)
 	{
@@ -3651,9 +3964,10 @@ if (m_Trim3)
 	}
 
 // accumulate quality score counts
-AccumQScores(pThread,pPE1File->QSSchema,PE1ReadLen,pPE1RawRead,pPE1QScores);
-if(m_bPEProc)
-	AccumQScores(pThread,pPE2File->QSSchema,PE2ReadLen,pPE2RawRead,pPE2QScores);
+if(AccumQScores(pThread,pPE1File->QSSchema,PE1ReadLen,pPE1RawRead,pPE1QScores) == eBSFerrMem)
+	return(eBSFerrMem);
+if(m_bPEProc && AccumQScores(pThread,pPE2File->QSSchema,PE2ReadLen,pPE2RawRead,pPE2QScores) == eBSFerrMem)
+	return(eBSFerrMem);
 
 // use this read as a sample?
 // will only sample reads which have no bases less than a Phred score of 10 and a mean thred score at least m_MinMeanPhredScore, and which also contain no 'N' indeterminates
@@ -3760,31 +4074,30 @@ if (NumInsts < 0)
 
 if (NumInsts >= 1)
 	{
-	AccumKMers(pThread,PE1ReadLen, pPE1RawRead);
-	if (m_bPEProc)
-		AccumKMers(pThread,PE2ReadLen, pPE2RawRead);
-	if(LocateContaminentMatch(PE1ReadLen,pPE1RawRead, false))
+	if(AccumKMers(pThread,PE1ReadLen, pPE1RawRead) == eBSFerrMem)
+		return(eBSFerrMem);
+	if (m_bPEProc && AccumKMers(pThread,PE2ReadLen, pPE2RawRead) == eBSFerrMem)
+		return(eBSFerrMem);
+	if(LocateContaminentMatch(pThread,PE1ReadLen,pPE1RawRead, false))
 		bPE1Contaminated = true;
 	else
 		bPE1Contaminated = false;
 	if (m_bPEProc)
 		{
-		if(LocateContaminentMatch(PE2ReadLen,pPE2RawRead, true))
+		if(LocateContaminentMatch(pThread,PE2ReadLen,pPE2RawRead, true))
 			bPE2Contaminated = true;
 		else
 			bPE2Contaminated = false;
 		}
-	AcquireSerialise();
-	m_NumChkdPE1ContamHits += 1;
+	pThread->NumChkdPE1ContamHits += 1;
 	if(bPE1Contaminated)
-		m_NumPE1ContamHits += 1;
+		pThread->NumPE1ContamHits += 1;
 	if (m_bPEProc)
 		{
-		m_NumChkdPE2ContamHits += 1;
+		pThread->NumChkdPE2ContamHits += 1;
 		if(bPE2Contaminated)
-			m_NumPE2ContamHits += 1;
+			pThread->NumPE2ContamHits += 1;
 		}
-	ReleaseSerialise();
 	}
 
 if(NumInsts == 1)
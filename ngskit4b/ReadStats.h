@@ -50,6 +50,9 @@ const uint32_t cHashMask =       0x0fffff;			// hashing is over 10 bases
 const uint32_t cMaxHashArrayEntries = (cHashMask + 1);        // alloc hash array to hold this many entries, must be at least 1 + maximal sized sized hash
 const uint32_t cReallocPackedWrds = (((cMaxRSSeqLen+3)/4) * 1000);	// if needing to realloc memory for holding packed sampled reads then realloc this many additional words 
 
+const size_t cMaxRSKMerShardsMem = 0x40000000;		// per thread K-mer count shards are used if all shards together would initially require no more than this memory, otherwise K-mer counts are serialised into a single shared table
+const int cMaxRSSampleNth = 10000;					// can sample every Nth read, or read pair, with N at most this
+
 // processing mode enumerations
 typedef enum TAG_eRSDMode
 	{
@@ -111,6 +114,7 @@ typedef struct TAG_sThreadNGSQCPars {
 #endif
 	int Rslt;						// returned result code
 	int ProcessingID;				// processing instance identifier, used if processing eRSDindependent to identify output file instances
+	int NumInflateThreads;			// compressed input files opened by this thread are inflated using this many threads
 	int PE1RawReadLen;				// current length of read being buffered in PE1RawReadsBuff
 	uint8_t PE1RawReadsBuff[cMaxRSSeqLen + 16];		// holds PE1 raw read sequence (16 is for a small safety margin!)
 	int PE2RawReadLen;				// current length of read being buffered in PE2RawReadsBuff
@@ -124,6 +128,27 @@ typedef struct TAG_sThreadNGSQCPars {
 	int64_t TotNumSEReads;			// total number of SE reads processed by this thread
 	int64_t TotNumPEReads;			// total number of PE reads processed by this thread
 	tsSeqCharacteristics SeqCharacteristics; // sequence characteristics for all reads processed by this thread
+
+	int64_t NumPresented;			// number of reads, or read pairs, presented to this thread for sampling
+	int64_t NumAnalysed;			// number of sampled reads, or read pairs, analysed by this thread
+
+	// distributions are accumulated by each thread into it's own shard, shards are merged once all threads have completed
+	int ShardAllocdReadLen;			// shard distributions are currently allocated for reads of up to this length
+	int ShardMinReadLen;			// minimum length read accumulated into this shard
+	int ShardMaxReadLen;			// maximum length read accumulated into this shard
+	uint32_t *pShardBaseNs;			// indeterminate base counts at each read offset
+	uint32_t *pShardScores;			// Phred score counts at each read offset, 42 counts per offset
+	size_t AllocdShardKMerCntsMem;	// memory allocated for pShardKMerCnts
+	bool bShardKMerCnts;			// true if this thread's K-mer counts are accumulated into pShardKMerCnts, false if serialised into m_pKMerCnts
+	uint32_t *pShardKMerCnts;		// K-mer counts at each read offset, nullptr if K-mer counts are instead serialised into m_pKMerCnts
+	uint64_t ShardProbNoReadErrDist[100];	// probabilities of read being error free distributions
+	uint32_t ShardReadLenDist[cMaxRSSeqLen+2];	// read length distributions
+	uint32_t NumChkdPE1ContamHits;	// number of PE1 sequences checked for contaminant hits
+	uint32_t NumPE1ContamHits;		// number of PE1 sequences with contaminate hits
+	uint32_t NumChkdPE2ContamHits;	// number of PE2 sequences checked for contaminant hits
+	uint32_t NumPE2ContamHits;		// number of PE2 sequences with contaminate hits
+	tsContamHitCnts *pContamHitCnts;	// contaminant hit counts for this thread
+
 	uint32_t KMerCntOfs[cMaxRSSeqLen * cMaxKMerLen];  // each thread buffers offsets into m_pKMerCnts[] untill all K-mers in a read have been identified then updates m_pKMerCnts as an atomic block 
 } tsThreadNGSQCPars;
 
@@ -149,6 +174,7 @@ typedef struct TAG_sThreadIndependentNGSQCPars {
 	int MinContamLen;				// accept contaminant overlaps if overlap at least this many bases 
 	int ReqMaxDupSeeds;				// requested to sample for this many duplicate seeds and off target alignments
 	int  MinPhredScore;				// only accept reads for duplicate and KMer processing if their minimum Phred score is at least this threshold
+	int SampleNth;					// sample every Nth read, or read pair, for analysis
 	int NumThreads;					// number of worker threads to use
 	bool bAffinity;					// thread to core affinity
 	int NumPE1InputFiles;			// number of PE1 input files
@@ -211,6 +237,9 @@ class CReadStats
 	int m_ReqMaxDupSeeds;		// requested to sample for this many duplicate seeds and off target alignments
 	int	m_ActMaxDupSeeds;		// actually sampled for this many duplicate seeds and off target alignments
 	int m_MinMeanPhredScore;	// only accept reads for duplicate and KMer processing if their mean Phred score is at least this threshold
+	int m_SampleNth;			// sample every Nth read, or read pair, for analysis
+	bool m_bShardKMerCnts;		// true if K-mer counts are accumulated into per thread shards
+	size_t m_MaxShardKMerCntsMem;	// each thread's share of cMaxRSKMerShardsMem, a thread whose shard would grow past this serialises any further K-mer counts into m_pKMerCnts
 	int m_NumThreads;			// number of worker threads to use
 	bool m_bAffinity;			// thread to core affinity
 	int m_NumPE1InputFiles;		// number of PE1 input files
@@ -284,6 +313,15 @@ class CReadStats
 	void ReleaseLock(bool bExclusive = false);
 
 
+	int AllocShard(tsThreadNGSQCPars *pThread,	// allocate thread's distribution shard
+					int MaxReadLen);				// for reads of up to this length
+	int GrowShard(tsThreadNGSQCPars *pThread,	// grow thread's distribution shard
+					int MaxReadLen);				// to hold reads of up to this length
+	void FreeShard(tsThreadNGSQCPars *pThread);	// free thread's distribution shard
+	int MergeShard(tsThreadNGSQCPars *pThread);	// merge thread's distribution shard into the instance distributions
+	int ReallocKMerCnts(int MaxReadLen);		// realloc m_pKMerCnts to hold counts for reads of up to this length
+	int SpillShardKMerCnts(tsThreadNGSQCPars *pThread);	// merge thread's K-mer count shard into m_pKMerCnts, free the shard, and serialise the thread's further K-mer counts
+
 	int
 		LoadContamiantsFile(char *pszFile);	// loads contamiants fasta file into memory resident m_pContamSfx
 
@@ -297,7 +335,8 @@ class CReadStats
 		AddContamHash(uint32_t Hash, int SeqOf, int ContamSeq);
 
 	int				// <0 if errors, 0 if no matches, >0 at least one contaminant sequence overlapping
-		LocateContaminentMatch(int SeqLen,				// targ sequence is of this length
+		LocateContaminentMatch(tsThreadNGSQCPars *pThread, // thread specific processing state and context
+								int SeqLen,				// targ sequence is of this length
 								etSeqBase *pSeq,		// target sequence		
 								bool bPE2 = false);		// false if processing SE/PE1 read, true if PE2
 
@@ -362,6 +401,7 @@ public:
 					int MinContamLen,				// accept contaminant overlaps if overlap at least this many bases 
 					int ReqMaxDupSeeds,				// requested to sample for this many duplicate seeds and off target alignments
 					int  MinPhredScore,				// only accept reads for duplicate and KMer processing if their minimum Phred score is at least this threshold
+					int SampleNth,					// sample every Nth read, or read pair, for analysis
 					int NumThreads,					// number of worker threads to use
 					bool bAffinity,					// thread to core affinity
 					int NumPE1InputFiles,			// number of PE1 input files
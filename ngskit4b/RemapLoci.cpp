@@ -40,7 +40,8 @@ RemapLociProcess(int PMode,			// processing mode
 				 int FType,			// alignment file type
 				char *pszInAlignFile,	// alignment file with loci to be remapped
 				char *pszInBEDFile,     // BED file containing loci remapping
-				char *pszRemappedFile);	// write remapped alignments to this file
+				char *pszRemappedFile,	// write remapped alignments to this file
+				int NumThreads);		// if SAM/BAM then BGZF compress/inflate using this many threads
 
 #ifdef _WIN32
 int RemapLoci(int argc, char* argv[])
@@ -62,6 +63,8 @@ int Rslt;
 
 int PMode;				// processing mode
 int FType;					// expected input element file type - auto, CSV, BED or SAM/BAM
+int NumThreads;				// number of threads (0 defaults to number of CPUs)
+int NumberOfProcessors;		// number of installed CPUs
 
 char szInLociFile[_MAX_PATH];	// input element loci from this file
 char szInBEDFile[_MAX_PATH];	// input bed file containing gene features
@@ -83,6 +86,7 @@ struct arg_int *ftype = arg_int0("t","filetype","<int>",		"input element file fo
 struct arg_file *InLociFile = arg_file1("i","inloci","<file>",	"input alignments file with loci to be remapped (BED, SAM/BAM) file");
 struct arg_file *InBEDFile = arg_file1("I","inbed","<file>",	"input BED file containing remapping loci");
 struct arg_file *RemappedFile = arg_file1("o","output","<file>", "write remapped alignments to this file, same format as input alignment file");
+struct arg_int *threads = arg_int0("T","threads","<int>",		"number of processing threads 0..128 (defaults to 0 which sets threads to number of CPU cores)");
 struct arg_file *summrslts = arg_file0("q","sumrslts","<file>",		"Output results summary to this SQLite3 database file");
 struct arg_str *experimentname = arg_str0("w","experimentname","<str>",		"experiment name SQLite3 database file");
 struct arg_str *experimentdescr = arg_str0("W","experimentdescr","<str>",	"experiment description SQLite3 database file");
@@ -91,7 +95,7 @@ struct arg_end *end = arg_end(200);
 
 void *argtable[] = {help,version,FileLogLevel,LogFile,
 					summrslts,experimentname,experimentdescr,
-					pmode,ftype,InLociFile,InBEDFile,RemappedFile,
+					pmode,ftype,InLociFile,InBEDFile,RemappedFile,threads,
 					end};
 
 char **pAllArgs;
@@ -242,6 +246,23 @@ if (!argerrors)
 		exit(1);
 		}
 
+#ifdef _WIN32
+	SYSTEM_INFO SystemInfo;
+	GetSystemInfo(&SystemInfo);
+	NumberOfProcessors = SystemInfo.dwNumberOfProcessors;
+#else
+	NumberOfProcessors = sysconf(_SC_NPROCESSORS_CONF);
+#endif
+	int MaxAllowedThreads = min(cMaxWorkerThreads,NumberOfProcessors);	// limit to be at most cMaxWorkerThreads
+	if((NumThreads = threads->count ? threads->ival[0] : MaxAllowedThreads)==0)
+		NumThreads = MaxAllowedThreads;
+	if(NumThreads < 0 || NumThreads > MaxAllowedThreads)
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Number of threads '-T%d' specified was outside of range %d..%d",NumThreads,1,MaxAllowedThreads);
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Defaulting number of threads to %d",MaxAllowedThreads);
+		NumThreads = MaxAllowedThreads;
+		}
+
 	if(InBEDFile->count)
 		{
 		strncpy(szInBEDFile,InBEDFile->filename[0],_MAX_PATH);
@@ -292,6 +313,8 @@ if (!argerrors)
 
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Input BED remapping locii file: '%s'",szInBEDFile);
 
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"number of threads : %d",NumThreads);
+
 	if(szExperimentName[0] != '\0')
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"This processing reference: %s",szExperimentName);
 
@@ -299,7 +322,7 @@ if (!argerrors)
 	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
 #endif
 	gStopWatch.Start();
-	Rslt = RemapLociProcess(PMode,FType,szInLociFile,szInBEDFile,szRemappedFile);
+	Rslt = RemapLociProcess(PMode,FType,szInLociFile,szInBEDFile,szRemappedFile,NumThreads);
 	Rslt = Rslt >=0 ? 0 : 1;
 	if(gExperimentID > 0)
 		{
@@ -326,10 +349,11 @@ RemapLociProcess(int PMode,			// processing mode
 				 int FType,			// alignment file type
 				char *pszInAlignFile,	// alignment file with loci to be remapped
 				char *pszInBEDFile,     // BED file containing loci remapping
-				char *pszRemappedFile)	// write remapped alignments to this file
+				char *pszRemappedFile,	// write remapped alignments to this file
+				int NumThreads)			// if SAM/BAM then BGZF compress/inflate using this many threads
 {
 CRemapLoci Remapper;
-return(Remapper.RemapLocii(PMode,FType,pszInAlignFile,pszInBEDFile,pszRemappedFile));
+return(Remapper.RemapLocii(PMode,FType,pszInAlignFile,pszInBEDFile,pszRemappedFile,NumThreads));
 }
 
 CRemapLoci::CRemapLoci()
@@ -339,6 +363,7 @@ m_pInBAMfile = nullptr;
 m_pOutBAMfile = nullptr;
 m_pszOutBuff = nullptr;
 m_hOutFile = -1;
+m_NumThreads = 1;
 }
 
 
@@ -395,12 +420,14 @@ CRemapLoci::RemapLocii(int PMode,			// processing mode
 				 int FType,			// alignment file type
 				char *pszInAlignFile,	// alignment file with loci to be remapped
 				char *pszInBEDFile,     // BED file containing loci remapping
-				char *pszRemappedFile)	// write remapped alignments to this file
+				char *pszRemappedFile,	// write remapped alignments to this file
+				int NumThreads)			// if SAM/BAM then BGZF compress/inflate using this many threads
 {
 int Rslt;
 etClassifyFileType FileType;
 
 Reset();
+m_NumThreads = NumThreads;
 
 // load remapping locii BED file
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Loading BED file containing loci remapping '%s'",pszInBEDFile);
@@ -670,7 +697,7 @@ if((m_pInBAMfile = new CSAMfile) == nullptr)
 	return(eBSFerrInternal);
 	}
 
-if((Rslt = (teBSFrsltCodes)m_pInBAMfile->Open(pszInAlignFile)) != eBSFSuccess)
+if((Rslt = (teBSFrsltCodes)m_pInBAMfile->Open(pszInAlignFile,m_NumThreads)) != eBSFSuccess)
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"RemapSAMLocii: Unable to open SAM/BAM format file %s",pszInAlignFile);
 	delete m_pInBAMfile;
@@ -703,7 +730,7 @@ switch(SAMFormat) {
 		break;
 	}
 
-if((Rslt = (teBSFrsltCodes)m_pOutBAMfile->Create(FileType,pszRemappedFile,6,(char *)kit4bversion)) < eBSFSuccess) // defaulting to compression level 6 if compressed BAM 
+if((Rslt = (teBSFrsltCodes)m_pOutBAMfile->Create(FileType,pszRemappedFile,6,(char *)kit4bversion,m_NumThreads)) < eBSFSuccess) // defaulting to compression level 6 if compressed BAM 
 	{
 	delete m_pInBAMfile;
 	m_pInBAMfile = nullptr;
@@ -33,6 +33,7 @@ class CRemapLoci
 	CBEDfile *m_pMappingBED;			// BED containing remapping locii
 
 
+	int m_NumThreads;					// if SAM/BAM then BGZF compress/inflate using this many threads
 	int m_hOutFile;						// output file handle for BED 
 	int m_OutBuffIdx;					// current index into m_pszOutBuff at which to next write output formated for BED 
 	int m_AllocOutBuff;				    // output buffer allocated to hold this many chars
@@ -53,7 +54,8 @@ public:
 					 int FType,				// alignment file type
 					char *pszInAlignFile,	// alignment file with loci to be remapped
 					char *pszInBEDFile,     // BED file containing loci remapping
-					char *pszRemappedFile);	// write remapped alignments to this file
+					char *pszRemappedFile,	// write remapped alignments to this file
+					int NumThreads = 1);	// if SAM/BAM then BGZF compress/inflate using this many threads
 
 	int
 	RemapBEDLocii(char *pszInAlignFile,		// BED alignment file with loci to be remapped
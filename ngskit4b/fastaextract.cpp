@@ -723,9 +723,10 @@ while((Rslt = SeqLen = Fasta.ReadSequence(&m_pSeqBuff[m_SeqBuffLen],(int)min(Ava
 				char szFeatName[cMaxGeneNameLen + 1];
 				int FeatStart;
 				int FeatEnd;
-				int NthFeature = 0;
 				int CurFeatID = 0;
-				while ((CurFeatID = m_pBedFile->LocateFeatureIDinRangeOnChrom(CurChromID, 0, (int)m_SeqBuffLen, ++NthFeature)) > 0)
+				tsBEDOverlapCursor Cursor;
+				m_pBedFile->InitOverlapCursor(&Cursor, CurChromID, 0, (int)m_SeqBuffLen);
+				while ((CurFeatID = m_pBedFile->NextOverlap(&Cursor)) > 0)
 					{
 					Rslt = m_pBedFile->GetFeature(CurFeatID, szFeatName, szFeatChrom, &FeatStart, &FeatEnd);
 					WriteSeqFile(XSense, szFeatName, FeatEnd-FeatStart+1, &m_pSeqBuff[FeatStart]);
@@ -814,9 +815,10 @@ if(bExtract && m_SeqBuffLen)					// was previous sequence to be extracted?
 		char szFeatName[cMaxGeneNameLen + 1];
 		int FeatStart;
 		int FeatEnd;
-		int NthFeature = 0;
 		int CurFeatID = 0;
-		while ((CurFeatID = m_pBedFile->LocateFeatureIDinRangeOnChrom(CurChromID, 0, (int)m_SeqBuffLen, ++NthFeature)) > 0)
+		tsBEDOverlapCursor Cursor;
+		m_pBedFile->InitOverlapCursor(&Cursor, CurChromID, 0, (int)m_SeqBuffLen);
+		while ((CurFeatID = m_pBedFile->NextOverlap(&Cursor)) > 0)
 			{
 			Rslt = m_pBedFile->GetFeature(CurFeatID, szFeatName, szFeatChrom, &FeatStart, &FeatEnd);
 			WriteSeqFile(XSense, szFeatName, FeatEnd - FeatStart + 1, &m_pSeqBuff[FeatStart]);
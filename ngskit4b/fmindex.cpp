@@ -0,0 +1,481 @@
+/*
+This toolkit is a source base clone of 'BioKanga' release 4.4.2 (https://github.com/csiro-crop-informatics/biokanga) and contains
+significant source code changes enabling new functionality and resulting process parameterisation changes. These changes have resulted in
+incompatibility with 'BioKanga'.
+
+Because of the potential for confusion by users unaware of functionality and process parameterisation changes then the modified source base
+and resultant compiled executables have been renamed to 'kit4b' - K-mer Informed Toolkit for Bioinformatics.
+The renaming will force users of the 'BioKanga' toolkit to examine scripting which is dependent on existing 'BioKanga'
+parameterisations so as to make appropriate changes if wishing to utilise 'kit4b' parameterisations and functionality.
+
+'kit4b' is being released under the Opensource Software License Agreement (GPLv3)
+'kit4b' is Copyright (c) 2019, 2020
+Please contact Dr Stuart Stephen < stuartjs@g3web.com > if you have any questions regarding 'kit4b'.
+
+*/
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include "../libkit4b/commhdrs.h"
+#else
+#include <sys/mman.h>
+#include <pthread.h>
+#include "../libkit4b/commhdrs.h"
+#endif
+
+#include "ngskit4b.h"
+
+const int cDfltFMIVerifySamples = 10000;	// default number of sampled text windows checked when verifying an index
+const int cMaxFMIVerifySamples = 10000000;	// allow at most this many sampled text windows
+const int cDfltFMIVerifyLen = 32;			// default sampled text window length
+const int cMinFMIVerifyLen = 8;				// minimum sampled text window length
+const int cMaxFMIVerifyLen = 1000;			// maximum sampled text window length
+
+// processing modes
+typedef enum TAG_eFMIPMode {
+	eFMIPMcreate,					// create FM index over the contents of the input file
+	eFMIPMverify,					// verify count, locate, batched locate and extract round trip sampled input file windows through a previously created index
+	eFMIPMplaceholder				// used to set the enumeration range
+	} etFMIPMode;
+
+int
+ProcessFMIndex(etFMIPMode PMode,	// processing mode
+		char *pszInFile,			// index is over the contents of this file
+		char *pszIndexFile,			// index file to create or verify, CFMIndex appends cszFMIExt
+		int NumSamples,				// verification checks this many sampled windows
+		int SampleLen,				// each sampled window is this length
+		int RandSeed,				// seed sampled window positions with this
+		int NumThreads);			// index creation uses at most this many threads
+
+
+#ifdef _WIN32
+int fmindex(int argc, char* argv[])
+{
+// determine my process name
+_splitpath(argv[0],nullptr,nullptr,gszProcName,nullptr);
+#else
+int
+fmindex(int argc, char** argv)
+{
+// determine my process name
+CUtility::splitpath((char *)argv[0],nullptr,gszProcName);
+#endif
+int iScreenLogLevel;		// level of screen diagnostics
+int iFileLogLevel;			// level of file diagnostics
+char szLogFile[_MAX_PATH];	// write diagnostics to this file
+
+int Rslt;
+etFMIPMode PMode;				// processing mode
+int NumSamples;					// verification checks this many sampled windows
+int SampleLen;					// each sampled window is this length
+int RandSeed;					// seed sampled window positions with this
+int NumberOfProcessors;			// number of installed CPUs
+int NumThreads;					// number of threads (0 defaults to number of CPUs)
+
+char szInFile[_MAX_PATH];		// index is over the contents of this file
+char szIndexFile[_MAX_PATH];	// index file name, CFMIndex appends cszFMIExt
+
+
+// command line args
+struct arg_lit  *help    = arg_lit0("h","help",                 "print this help and exit");
+struct arg_lit  *version = arg_lit0("v","version,ver",			"print version information and exit");
+struct arg_int *FileLogLevel=arg_int0("f", "FileLogLevel",		"<int>","Level of diagnostics written to screen and logfile 0=fatal,1=errors,2=info,3=diagnostics,4=debug");
+struct arg_file *LogFile = arg_file0("F","log","<file>",		"diagnostics log file");
+
+struct arg_int *pmode = arg_int0("m","mode","<int>",		    "Processing mode:  0 - create FM index, 1 - verify FM index against the file it was created from");
+struct arg_file *infile = arg_file1("i","in","<file>",			"index over contents of this file");
+struct arg_file *indexfile = arg_file0("o","index","<file>",	"FM index file name, '.fmi' will be appended (defaults to input file name)");
+struct arg_int *numsamples = arg_int0("n","samples","<int>",	"verify: number of sampled windows to check (default 10000, range 1..10000000)");
+struct arg_int *samplelen = arg_int0("l","samplelen","<int>",	"verify: sampled window length (default 32, range 8..1000)");
+struct arg_int *randseed = arg_int0("s","randseed","<int>",		"verify: random seed for sampled window positions (default 1)");
+struct arg_int *threads = arg_int0("T","threads","<int>",		"number of processing threads 0..64 (defaults to 0 which sets threads to number of CPU cores)");
+struct arg_end *end = arg_end(20);
+
+void *argtable[] = {help,version,FileLogLevel,LogFile,
+					pmode,infile,indexfile,numsamples,samplelen,randseed,threads,
+					end};
+char **pAllArgs;
+int argerrors;
+argerrors = CUtility::arg_parsefromfile(argc,(char **)argv,&pAllArgs);
+if(argerrors >= 0)
+	argerrors = arg_parse(argerrors,pAllArgs,argtable);
+
+/* special case: '--help' takes precedence over error reporting */
+if (help->count > 0)
+        {
+		printf("\n%s %s %s, Version %s\nOptions ---\n", gszProcName, gpszSubProcess->pszName, gpszSubProcess->pszFullDescr, kit4bversion);
+        arg_print_syntax(stdout,argtable,"\n");
+        arg_print_glossary(stdout,argtable,"  %-25s %s\n");
+		printf("\nNote: Parameters can be entered into a parameter file, one parameter per line.");
+		printf("\n      To invoke this parameter file then precede its name with '@'");
+		printf("\n      e.g. %s @myparams.txt\n",gszProcName);
+		printf("\nPlease report any issues regarding usage of %s to https://github.com/kit4b/kit4b/issues\n\n",gszProcName);
+		exit(1);
+        }
+
+    /* special case: '--version' takes precedence error reporting */
+if (version->count > 0)
+        {
+		printf("\n%s Version %s\n",gszProcName,kit4bversion);
+		exit(1);
+        }
+
+if (!argerrors)
+	{
+	if(FileLogLevel->count && !LogFile->count)
+		{
+		printf("\nError: FileLogLevel '-f%d' specified but no logfile '-F<logfile>\n'",FileLogLevel->ival[0]);
+		exit(1);
+		}
+
+	iScreenLogLevel = iFileLogLevel = FileLogLevel->count ? FileLogLevel->ival[0] : eDLInfo;
+	if(iFileLogLevel < eDLNone || iFileLogLevel > eDLDebug)
+		{
+		printf("\nError: FileLogLevel '-l%d' specified outside of range %d..%d\n",iFileLogLevel,eDLNone,eDLDebug);
+		exit(1);
+		}
+
+	if(LogFile->count)
+		{
+		strncpy(szLogFile,LogFile->filename[0],_MAX_PATH);
+		szLogFile[_MAX_PATH-1] = '\0';
+		}
+	else
+		{
+		iFileLogLevel = eDLNone;
+		szLogFile[0] = '\0';
+		}
+
+	// now that log parameters have been parsed then initialise diagnostics log system
+	if(!gDiagnostics.Open(szLogFile,(etDiagLevel)iScreenLogLevel,(etDiagLevel)iFileLogLevel,true))
+		{
+		printf("\nError: Unable to start diagnostics subsystem\n");
+		if(szLogFile[0] != '\0')
+			printf(" Most likely cause is that logfile '%s' can't be opened/created\n",szLogFile);
+		exit(1);
+		}
+
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Version: %s",kit4bversion);
+
+	PMode = (etFMIPMode)(pmode->count ? pmode->ival[0] : eFMIPMcreate);
+	if(PMode < eFMIPMcreate || PMode >= eFMIPMplaceholder)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Processing mode '-m%d' specified outside of range %d..%d\n",PMode,eFMIPMcreate,(int)eFMIPMplaceholder-1);
+		exit(1);
+		}
+
+	strncpy(szInFile,infile->filename[0],_MAX_PATH);
+	szInFile[_MAX_PATH-1] = '\0';
+	CUtility::TrimQuotedWhitespcExtd(szInFile);
+	if(szInFile[0] == '\0')
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: After removal of whitespace, no input file specified with '-i<file>' option\n");
+		exit(1);
+		}
+
+	if(indexfile->count)
+		{
+		strncpy(szIndexFile,indexfile->filename[0],_MAX_PATH);
+		szIndexFile[_MAX_PATH-1] = '\0';
+		CUtility::TrimQuotedWhitespcExtd(szIndexFile);
+		}
+	else
+		szIndexFile[0] = '\0';
+	if(szIndexFile[0] == '\0')
+		strcpy(szIndexFile,szInFile);
+
+	NumSamples = 0;
+	SampleLen = 0;
+	RandSeed = 1;
+	if(PMode == eFMIPMverify)
+		{
+		NumSamples = numsamples->count ? numsamples->ival[0] : cDfltFMIVerifySamples;
+		if(NumSamples < 1 || NumSamples > cMaxFMIVerifySamples)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Number of sampled windows '-n%d' specified outside of range 1..%d\n",NumSamples,cMaxFMIVerifySamples);
+			exit(1);
+			}
+		SampleLen = samplelen->count ? samplelen->ival[0] : cDfltFMIVerifyLen;
+		if(SampleLen < cMinFMIVerifyLen || SampleLen > cMaxFMIVerifyLen)
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Sampled window length '-l%d' specified outside of range %d..%d\n",SampleLen,cMinFMIVerifyLen,cMaxFMIVerifyLen);
+			exit(1);
+			}
+		RandSeed = randseed->count ? randseed->ival[0] : 1;
+		}
+
+#ifdef _WIN32
+	SYSTEM_INFO SystemInfo;
+	GetSystemInfo(&SystemInfo);
+	NumberOfProcessors = SystemInfo.dwNumberOfProcessors;
+#else
+	NumberOfProcessors = sysconf(_SC_NPROCESSORS_CONF);
+#endif
+	int MaxAllowedThreads = min(cMaxFMIThreads,NumberOfProcessors);	// limit to be at most cMaxFMIThreads
+	if((NumThreads = threads->count ? threads->ival[0] : MaxAllowedThreads)==0)
+		NumThreads = MaxAllowedThreads;
+	if(NumThreads < 0 || NumThreads > MaxAllowedThreads)
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Number of threads '-T%d' specified was outside of range %d..%d",NumThreads,1,MaxAllowedThreads);
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Defaulting number of threads to %d",MaxAllowedThreads);
+		NumThreads = MaxAllowedThreads;
+		}
+
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Processing parameters:");
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Processing mode: %s",PMode == eFMIPMcreate ? "create FM index" : "verify FM index");
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Input file: '%s'",szInFile);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"FM index file: '%s%s'",szIndexFile,cszFMIExt);
+	if(PMode == eFMIPMverify)
+		{
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Number of sampled windows: %d",NumSamples);
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Sampled window length: %d",SampleLen);
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Random seed: %d",RandSeed);
+		}
+	else
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"number of threads : %d",NumThreads);
+
+#ifdef _WIN32
+	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
+#endif
+	// processing here...
+	gStopWatch.Start();
+	Rslt = ProcessFMIndex(PMode,szInFile,szIndexFile,NumSamples,SampleLen,RandSeed,NumThreads);
+
+	gStopWatch.Stop();
+	Rslt = Rslt >=0 ? 0 : 1;
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Exit code: %d Total processing time: %s",Rslt,gStopWatch.Read());
+	exit(Rslt);
+	}
+else
+	{
+	printf("\n%s Create or verify FM index, Version %s\n",gszProcName,kit4bversion);
+	arg_print_errors(stdout,end,gszProcName);
+	arg_print_syntax(stdout,argtable,"\nUse '-h' to view option and parameter usage\n");
+	exit(1);
+	}
+return 0;
+}
+
+// VerifyFMIndex
+// Windows sampled from the input file must be returned by extract() at their sampled offsets, must be counted at least once,
+// and must have their sampled offset returned by both locate() and locate_batch()
+// Windows are read directly from the input file so that verification of indexes over texts larger than 4GB does not need the text to be loaded
+int
+VerifyFMIndex(CFMIndex *pFMIndex,	// index loaded from pszIndexFile
+		char *pszInFile,			// index was created over the contents of this file
+		int NumSamples,				// check this many sampled windows
+		int SampleLen,				// each sampled window is this length
+		int RandSeed)				// seed sampled window positions with this
+{
+int Rslt;
+int SampleIdx;
+int NumFailed;
+uint64_t TextLen;
+uint64_t FileLen;
+uint64_t NumOccs;
+uint64_t OccIdx;
+uint64_t SnippetLen;
+uint64_t MaxOfs;
+uint64_t *pOccs;
+uint64_t *pOfss;
+uint8_t *pSnippet;
+uint8_t *pSamples;
+uint8_t **ppPatterns;
+uint32_t *pLengths;
+uint64_t **ppBatchOccs;
+uint64_t *pBatchNumOccs;
+FILE *pInFile;
+CRandomMersenne *pRandom;
+
+if((Rslt = pFMIndex->get_length(&TextLen)) < 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to get FM index text length: %s",pFMIndex->GetErrText(Rslt));
+	return(eBSFerrInternal);
+	}
+
+if((pInFile = fopen(pszInFile,"rb")) == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to open input file '%s' - %s",pszInFile,strerror(errno));
+	return(eBSFerrOpnFile);
+	}
+#ifdef _WIN32
+_fseeki64(pInFile,0,SEEK_END);
+FileLen = (uint64_t)_ftelli64(pInFile);
+#else
+fseeko64(pInFile,0,SEEK_END);
+FileLen = (uint64_t)ftello64(pInFile);
+#endif
+if(FileLen != TextLen)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"FM index text length %llu differs from input file '%s' length %llu",(unsigned long long)TextLen,pszInFile,(unsigned long long)FileLen);
+	fclose(pInFile);
+	return(eBSFerrInternal);
+	}
+if(TextLen < (uint64_t)SampleLen * 2)	// extracting the complete text is a different code path, ensure windows are always partial
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Input file '%s' length %llu is too short to sample windows of length %d",pszInFile,(unsigned long long)TextLen,SampleLen);
+	fclose(pInFile);
+	return(eBSFerrInternal);
+	}
+
+pSamples = new uint8_t [(size_t)NumSamples * SampleLen];
+pOfss = new uint64_t [NumSamples];
+ppPatterns = new uint8_t * [NumSamples];
+pLengths = new uint32_t [NumSamples];
+pRandom = new CRandomMersenne(RandSeed);
+
+// sample windows, the last window is forced to end at the final text position so that the largest offsets are always checked
+MaxOfs = TextLen - SampleLen;
+for(SampleIdx = 0; SampleIdx < NumSamples; SampleIdx++)
+	{
+	if(SampleIdx == NumSamples - 1)
+		pOfss[SampleIdx] = MaxOfs;
+	else
+		pOfss[SampleIdx] = (((uint64_t)pRandom->BRandom() << 32) | (uint64_t)pRandom->BRandom()) % (MaxOfs + 1);
+	ppPatterns[SampleIdx] = &pSamples[(size_t)SampleIdx * SampleLen];
+	pLengths[SampleIdx] = (uint32_t)SampleLen;
+#ifdef _WIN32
+	_fseeki64(pInFile,(int64_t)pOfss[SampleIdx],SEEK_SET);
+#else
+	fseeko64(pInFile,(int64_t)pOfss[SampleIdx],SEEK_SET);
+#endif
+	if(fread(ppPatterns[SampleIdx],1,SampleLen,pInFile) != (size_t)SampleLen)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to read input file '%s' at offset %llu",pszInFile,(unsigned long long)pOfss[SampleIdx]);
+		fclose(pInFile);
+		delete pRandom;
+		delete []pLengths;
+		delete []ppPatterns;
+		delete []pOfss;
+		delete []pSamples;
+		return(eBSFerrRead);
+		}
+	}
+fclose(pInFile);
+delete pRandom;
+
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Verifying extract, count and locate of %d windows sampled from text of length %llu",NumSamples,(unsigned long long)TextLen);
+NumFailed = 0;
+for(SampleIdx = 0; SampleIdx < NumSamples; SampleIdx++)
+	{
+	pSnippet = NULL;
+	SnippetLen = 0;
+	Rslt = pFMIndex->extract(pOfss[SampleIdx],pOfss[SampleIdx] + SampleLen - 1,&pSnippet,&SnippetLen);
+	if(Rslt < 0 || SnippetLen != (uint64_t)SampleLen || memcmp(pSnippet,ppPatterns[SampleIdx],SampleLen))
+		{
+		if(NumFailed++ < 10)
+			gDiagnostics.DiagOut(eDLWarn,gszProcName,"extract() mismatch for window at offset %llu",(unsigned long long)pOfss[SampleIdx]);
+		}
+	if(pSnippet != NULL)
+		delete []pSnippet;
+
+	NumOccs = 0;
+	if((Rslt = pFMIndex->count(ppPatterns[SampleIdx],(uint32_t)SampleLen,&NumOccs)) < 0 || NumOccs == 0)
+		{
+		if(NumFailed++ < 10)
+			gDiagnostics.DiagOut(eDLWarn,gszProcName,"count() returned no occurrences for window at offset %llu",(unsigned long long)pOfss[SampleIdx]);
+		}
+
+	pOccs = NULL;
+	NumOccs = 0;
+	Rslt = pFMIndex->locate(ppPatterns[SampleIdx],(uint32_t)SampleLen,&pOccs,&NumOccs);
+	for(OccIdx = 0; Rslt >= 0 && OccIdx < NumOccs; OccIdx++)
+		if(pOccs[OccIdx] == pOfss[SampleIdx])
+			break;
+	if(Rslt < 0 || OccIdx == NumOccs)
+		{
+		if(NumFailed++ < 10)
+			gDiagnostics.DiagOut(eDLWarn,gszProcName,"locate() did not return offset %llu",(unsigned long long)pOfss[SampleIdx]);
+		}
+	if(pOccs != NULL)
+		delete []pOccs;
+	}
+
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Verifying batched locate of %d windows",NumSamples);
+if((Rslt = pFMIndex->locate_batch((uint32_t)NumSamples,ppPatterns,pLengths,&ppBatchOccs,&pBatchNumOccs)) < 0)
+	{
+	gDiagnostics.DiagOut(eDLWarn,gszProcName,"locate_batch() failed: %s",pFMIndex->GetErrText(Rslt));
+	NumFailed++;
+	}
+else
+	{
+	for(SampleIdx = 0; SampleIdx < NumSamples; SampleIdx++)
+		{
+		for(OccIdx = 0; OccIdx < pBatchNumOccs[SampleIdx]; OccIdx++)
+			if(ppBatchOccs[SampleIdx][OccIdx] == pOfss[SampleIdx])
+				break;
+		if(OccIdx == pBatchNumOccs[SampleIdx])
+			{
+			if(NumFailed++ < 10)
+				gDiagnostics.DiagOut(eDLWarn,gszProcName,"locate_batch() did not return offset %llu",(unsigned long long)pOfss[SampleIdx]);
+			}
+		}
+	pFMIndex->free_batch((uint32_t)NumSamples,ppBatchOccs,pBatchNumOccs);
+	}
+
+delete []pLengths;
+delete []ppPatterns;
+delete []pOfss;
+delete []pSamples;
+
+if(NumFailed)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"FM index verification failed with %d errors",NumFailed);
+	return(eBSFerrInternal);
+	}
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"FM index verification completed, all %d sampled windows round tripped",NumSamples);
+return(eBSFSuccess);
+}
+
+int
+ProcessFMIndex(etFMIPMode PMode,	// processing mode
+		char *pszInFile,			// index is over the contents of this file
+		char *pszIndexFile,			// index file to create or verify, CFMIndex appends cszFMIExt
+		int NumSamples,				// verification checks this many sampled windows
+		int SampleLen,				// each sampled window is this length
+		int RandSeed,				// seed sampled window positions with this
+		int NumThreads)				// index creation uses at most this many threads
+{
+int Rslt;
+uint64_t TextLen;
+uint64_t IndexLen;
+CFMIndex *pFMIndex;
+
+if((pFMIndex = new CFMIndex) == NULL)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to instantiate CFMIndex");
+	return(eBSFerrObj);
+	}
+
+if(PMode == eFMIPMcreate)
+	{
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Creating FM index over '%s' into '%s%s'",pszInFile,pszIndexFile,cszFMIExt);
+	pFMIndex->SetNumThreads(NumThreads);
+	if((Rslt = pFMIndex->CreateIndex(pszInFile,pszIndexFile,&TextLen,&IndexLen)) < 0)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to create FM index: %s",pFMIndex->GetErrText(Rslt));
+		delete pFMIndex;
+		return(eBSFerrInternal);
+		}
+	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Created FM index of length %llu over text of length %llu",(unsigned long long)IndexLen,(unsigned long long)TextLen);
+	delete pFMIndex;
+	return(eBSFSuccess);
+	}
+
+gDiagnostics.DiagOut(eDLInfo,gszProcName,"Loading FM index '%s%s'",pszIndexFile,cszFMIExt);
+if((Rslt = pFMIndex->load_index(pszIndexFile)) < 0)
+	{
+	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to load FM index '%s%s': %s",pszIndexFile,cszFMIExt,pFMIndex->GetErrText(Rslt));
+	delete pFMIndex;
+	return(eBSFerrInternal);
+	}
+Rslt = VerifyFMIndex(pFMIndex,pszInFile,NumSamples,SampleLen,RandSeed);
+pFMIndex->free_index();
+delete pFMIndex;
+return(Rslt);
+}
@@ -41,8 +41,51 @@ Original 'BioKanga' copyright notice has been retained and immediately follows t
 
 #ifdef _WIN32
 #pragma intrinsic(_InterlockedCompareExchange)
+#include <intrin.h>
 #endif
 
+// packed base comparisons are made over whole tSeqWrd4s by XORing words, mismatching bases are then counted or located with popcount and count leading zeros
+static inline int
+SeqWrd4PopCnt(tSeqWrd4 SeqWrd)			// returns number of set bits
+{
+#ifdef _WIN32
+return((int)__popcnt(SeqWrd));
+#else
+return(__builtin_popcount(SeqWrd));
+#endif
+}
+
+static inline int
+SeqWrd4Clz(tSeqWrd4 SeqWrd)				// returns number of leading zero bits, SeqWrd must be non-zero
+{
+#ifdef _WIN32
+unsigned long BitIdx;
+_BitScanReverse(&BitIdx,SeqWrd);
+return(31 - (int)BitIdx);
+#else
+return(__builtin_clz(SeqWrd));
+#endif
+}
+
+static inline tSeqWrd4
+SeqWrd4Bases(tSeqWrd4 *pSeq,			// returns NumBases (1..15) bases starting at base Shf (0..14) in the word ptd at by pSeq
+			int Shf,
+			int NumBases)				// as a full tSeqWrd4 with first base in bits 29..28 and any unused trailing base slots as 0
+{
+uint64_t SeqWrds;
+SeqWrds = (uint64_t)(*pSeq & cSeqWrd4Msk) << 30;
+if((Shf + NumBases) > 15)				// only touch the following word if bases are actually required from it
+	SeqWrds |= pSeq[1] & cSeqWrd4Msk;
+return((tSeqWrd4)((SeqWrds << (2 * Shf)) >> 30) & cSeqWrd4Msk & ~((((tSeqWrd4)1) << (30 - (2 * NumBases))) - 1));
+}
+
+static inline tSeqWrd4
+SeqWrd4BaseRangeMsk(int FirstBase,		// returns mismatch flag mask covering bases FirstBase..EndBase-1 (0..15) in a tSeqWrd4
+					int EndBase)
+{
+return(0x15555555 & ((((tSeqWrd4)1) << (30 - (2 * FirstBase))) - 1) & ~((((tSeqWrd4)1) << (30 - (2 * EndBase))) - 1));
+}
+
 static uint8_t *m_xpConcatSeqs;	// to hold all concatenated packed sequences
 static int SeqWrdBytes;			// sequence packing used in m_xpConcatSeqs
 
@@ -7384,6 +7427,9 @@ CKit4bdna::CmpPackedSeqs(tSeqWrd4 *pProbeSeq,	// Seq1 (probe) packed sequence
 {
 int NumSeq1Bases;
 int NumSeq2Bases;
+int CmpBases;
+int DiffBase;
+tSeqWrd4 Diffs;
 if(!MaxCmpLen || pProbeSeq == nullptr || pTargSeq == nullptr)
 	return(0);
 
@@ -7459,21 +7505,17 @@ if(SeqWrd2 > cSeqWrd4Msk)
 else
 	NumSeq2Bases = 15;
 
-BaseMsk = 0x30000000;
-do
+// locate first mismatching base, compare is over at least the first base and limited to the bases in the shorter word
+CmpBases = max(1,min(NumSeq1Bases,NumSeq2Bases));
+if((Diffs = (SeqWrd1 ^ SeqWrd2) & cSeqWrd4Msk) != 0 && (DiffBase = (SeqWrd4Clz(Diffs) - 2) / 2) < CmpBases)
 	{
-	if((SeqWrd1 & BaseMsk) < (SeqWrd2 & BaseMsk))
-		return(-1);
-	if((SeqWrd1 & BaseMsk) > (SeqWrd2 & BaseMsk))
-		return(1);
-	MaxCmpLen -= 1;
-	if(!MaxCmpLen)
+	if(DiffBase >= MaxCmpLen)
 		return(0);
-	BaseMsk >>= 2;
-	NumSeq1Bases -= 1;
-	NumSeq2Bases -= 1;
+	BaseMsk = 0x30000000 >> (2 * DiffBase);
+	return((SeqWrd1 & BaseMsk) < (SeqWrd2 & BaseMsk) ? -1 : 1);
 	}
-while(NumSeq1Bases > 0 && NumSeq2Bases > 0);
+if(MaxCmpLen <= CmpBases)
+	return(0);
 
 if(NumSeq1Bases < NumSeq2Bases)
 	return(-1);
@@ -7594,6 +7636,7 @@ int NumSeq1Bases;
 int NumSeq2Bases;
 int MaxPartialCmpBases;
 int OverlapLen;
+tSeqWrd4 Diffs;
 if(pSeqA == nullptr || pSeqB == nullptr)
 	return(0);
 
@@ -7659,17 +7702,13 @@ while(!((SeqWrd1 = *pSeq1++) & cSeqWrd4MSWHdr || (SeqWrd2 = *pSeq2++) & cSeqWrd4
 	else
 		NumSeq2Bases = 15;
 
-	// do a minimal number of base compares 
-	MaxPartialCmpBases = min(NumSeq1Bases,NumSeq2Bases);
-	BaseMsk = 0x30000000;
-	while(MaxPartialCmpBases--) {
-		if((SeqWrd1 & BaseMsk) != (SeqWrd2 & BaseMsk)) 
-			break;
-		OverlapLen += 1;				// still matching base for base
-		if(MaxLen && (OverlapLen >= MaxLen))
-				return(OverlapLen);
-		BaseMsk >>= 2;
-		}
+	// bases match up to the first mismatching base, or the end of the shorter word
+	MaxPartialCmpBases = max(0,min(NumSeq1Bases,NumSeq2Bases));
+	if((Diffs = (SeqWrd1 ^ SeqWrd2) & cSeqWrd4Msk) != 0)
+		MaxPartialCmpBases = min(MaxPartialCmpBases,(SeqWrd4Clz(Diffs) - 2) / 2);
+	OverlapLen += MaxPartialCmpBases;
+	if(MaxLen && (OverlapLen >= MaxLen))
+		return(MaxLen);
 	break;
 	}
 
@@ -7690,15 +7729,8 @@ CKit4bdna::IsMatched(int ReqMatchLen,		// required match length
 {
 int Max3End12Subs;
 int	KbpLen;
-tSeqWrd4 *pStartSeq1;
-tSeqWrd4 *pStartSeq2;
-tSeqWrd4 CurSeq1Wrd;
-tSeqWrd4 CurSeq2Wrd;
 int AllowNumSubs;
 int NumMMs;
-int Num5MMs;
-int Num3MMs;
-int NumBasesChkd;
 
 // some sanity checks
 if(ReqMatchLen < 16 || (Seq1Ofs + ReqMatchLen) > Seq1Len || (Seq2Ofs + ReqMatchLen) > Seq2Len || 
@@ -7734,55 +7766,80 @@ while(*pSeq2 & cSeqWrd4MSWHdr)
 	pSeq2 += 1;
 	}
 
-// fetch and rotate into the MSbits the initial base
-pStartSeq1 = &pSeq1[Seq1Ofs/15];
-CurSeq1Wrd = *pStartSeq1++;
-CurSeq1Wrd <<= 2 * (Seq1Ofs % 15); 
-Seq1Ofs += 1;
-
-pStartSeq2 = &pSeq2[Seq2Ofs/15];
-CurSeq2Wrd = *pStartSeq2++;
-CurSeq2Wrd <<= 2 * (Seq2Ofs % 15);
-Seq2Ofs += 1;
+if(!MatchPackedSeqs(ReqMatchLen,Seq1Ofs,pSeq1,Seq2Ofs,pSeq2,MaxEnd12Subs,Max3End12Subs,AllowNumSubs,&NumMMs))
+	return(false);
+if(pNumSubs != nullptr)
+	*pNumSubs = NumMMs;
+return(true);
+}
 
-NumBasesChkd = 0;
-NumMMs = 0;
-Num5MMs = 0;
-Num3MMs = 0;
-for(NumBasesChkd = 0; NumBasesChkd < ReqMatchLen; NumBasesChkd+=1, Seq1Ofs+=1, Seq2Ofs+=1)
-	{
-	if((CurSeq1Wrd & 0x030000000) != (CurSeq2Wrd  & 0x030000000))
+tSeqWrd4							// returns mismatch flags between two full tSeqWrd4s, bit 2*(14-N) is set if base N differs
+CKit4bdna::SeqWrd4Diffs(tSeqWrd4 SeqWrd1,	// compare bases in this packed word
+				tSeqWrd4 SeqWrd2)			// against bases in this packed word
+{
+tSeqWrd4 Diffs;
+Diffs = SeqWrd1 ^ SeqWrd2;
+return((Diffs | (Diffs >> 1)) & 0x15555555);
+}
+
+// MatchPackedSeqs compares 15 bases at a time, the substitution limits are checked after each 15 bases so
+// a compare is terminated as soon as any limit is exceeded
+bool								// true if substitutions between Seq1 and Seq2 over MatchLen are within the allowed limits
+CKit4bdna::MatchPackedSeqs(int MatchLen,	// compare over this many bases
+			int Seq1Ofs,					// base offset in Seq1 at which to start compare
+			tSeqWrd4 *pSeq1,				// sequence 1, any header words already skipped
+			int Seq2Ofs,					// base offset in Seq2 at which to start compare
+			tSeqWrd4 *pSeq2,				// sequence 2, any header words already skipped
+			int MaxEnd12Subs,				// if non-zero then substitutions in initial 12bp (5') are counted separately and limited to this many
+			int Max3End12Subs,				// and substitutions in the final 12bp (3') are limited to this many
+			int MaxSubs,					// all other substitutions are limited to this many
+			int *pNumSubs)					// returned total number of substitutions if within limits
+{
+int CurOfs;
+int WrdBases;
+int Seq1Shf;
+int Seq2Shf;
+int End5Ofs;
+int Start3Ofs;
+int NumSubs;
+int Num5EndSubs;
+int Num3EndSubs;
+tSeqWrd4 Diffs;
+
+// stepping by 15 bases steps by exactly one tSeqWrd4 so the base shift within words remains constant over the compare
+pSeq1 += Seq1Ofs / 15;
+Seq1Shf = Seq1Ofs % 15;
+pSeq2 += Seq2Ofs / 15;
+Seq2Shf = Seq2Ofs % 15;
+
+// 5' end subs are counted over bases 0..End5Ofs-1, 3' end subs over bases Start3Ofs..MatchLen-1
+End5Ofs = MaxEnd12Subs ? min(12,MatchLen) : 0;
+Start3Ofs = MaxEnd12Subs ? max(End5Ofs,MatchLen - 12) : MatchLen;
+NumSubs = 0;
+Num5EndSubs = 0;
+Num3EndSubs = 0;
+for(CurOfs = 0; CurOfs < MatchLen; CurOfs += 15, pSeq1++, pSeq2++)
+	{
+	WrdBases = min(15,MatchLen - CurOfs);
+	if(!(Diffs = SeqWrd4Diffs(SeqWrd4Bases(pSeq1,Seq1Shf,WrdBases),SeqWrd4Bases(pSeq2,Seq2Shf,WrdBases))))
+		continue;
+	if(CurOfs >= End5Ofs && (CurOfs + 15) <= Start3Ofs)	// all bases are outside of the 5' and 3' ends
+		NumSubs += SeqWrd4PopCnt(Diffs);
+	else
 		{
-		if(MaxEnd12Subs && (NumBasesChkd < 12 || NumBasesChkd >= (ReqMatchLen - 12)))
-			{
-			if(NumBasesChkd < 12)
-				{
-				if(++Num5MMs > MaxEnd12Subs)
-					break;
-				}
-			else
-				{
-				if(++Num3MMs > Max3End12Subs)
-					break;
-				}
-			}
-		else
-			if(++NumMMs > AllowNumSubs)
-				break;
+		if(CurOfs < End5Ofs)
+			Num5EndSubs += SeqWrd4PopCnt(Diffs & SeqWrd4BaseRangeMsk(0,min(15,End5Ofs - CurOfs)));
+		if((CurOfs + WrdBases) > Start3Ofs)
+			Num3EndSubs += SeqWrd4PopCnt(Diffs & SeqWrd4BaseRangeMsk(max(0,Start3Ofs - CurOfs),15));
+		if(CurOfs < Start3Ofs && (CurOfs + 15) > End5Ofs)
+			NumSubs += SeqWrd4PopCnt(Diffs & SeqWrd4BaseRangeMsk(max(0,End5Ofs - CurOfs),min(15,Start3Ofs - CurOfs)));
 		}
-
-	if(!(Seq1Ofs%15))
-		CurSeq1Wrd = *pStartSeq1++;
-	else
-		CurSeq1Wrd <<= 2;
-	if(!(Seq2Ofs%15))
-		CurSeq2Wrd = *pStartSeq2++;
-	else
-		CurSeq2Wrd <<= 2;
+	if(Num5EndSubs > MaxEnd12Subs || Num3EndSubs > Max3End12Subs || NumSubs > MaxSubs)
+		return(false);
 	}
-if(pNumSubs != nullptr && NumBasesChkd == ReqMatchLen)
-	*pNumSubs = NumMMs + Num5MMs + Num3MMs;
-return(NumBasesChkd == ReqMatchLen);
+if(pNumSubs != nullptr)
+	*pNumSubs = Num5EndSubs + Num3EndSubs + NumSubs;
+return(true);
 }
 
 // GetOverlapAB will process for overlaps in which SeqA (SeqB), completely or 5' overlaps, SeqB (SeqA)
@@ -7800,8 +7857,6 @@ CKit4bdna::GetOverlapAB(int MinOverlap,		// seq1 and seqB must overlap by at lea
 {
 int CurNumSubs;
 int Max3End12Subs;
-int Cur5EndSubs;
-int Cur3EndSubs;
 int ABNumSubs;
 int SeqALeft;
 int ABMaxOverlapLen;
@@ -7811,20 +7866,10 @@ int SeqBLeft;
 int BAMaxOverlapLen;
 
 int FirstSeqAOfs;
-int CurSeqAOfs;
-int CurSeqBOfs;
-tSeqWrd4 CurSeqABase;
-tSeqWrd4 CurSeqBBase;
 tSeqWrd4 *pStartSeqA;
-tSeqWrd4 *pCurSeqA;
-tSeqWrd4 *pCurSeqB;
 
 tSeqWrd4 FirstSeqAWrd;
 tSeqWrd4 FirstSeqBWrd;
-tSeqWrd4 CurSeqAWrd;
-tSeqWrd4 CurSeqBWrd;
-tSeqWrd4 FirstSeqABase;
-tSeqWrd4 FirstSeqBBase;
 
 int KbpLen;
 int CurMaxKbpNumSubs;
@@ -7860,36 +7905,22 @@ while(*pSeqB & cSeqWrd4MSWHdr)
 pStartSeqA = pSeqA;
 
 // initally look for overlaps of SeqA onto SeqB; then look for overlap of SeqB onto SeqA and choose the maximal with minimum subs as a tiebreaker
-CurNumSubs = 0;
-Cur5EndSubs = 0;
-Cur3EndSubs = 0;
-CurSeqAOfs = 0;
 
 ABNumSubs = 0;
 SeqALeft = 0;
 ABMaxOverlapLen = 0;
-FirstSeqBWrd = *pSeqB;
-FirstSeqBBase = FirstSeqBWrd & 0x30000000; 
+FirstSeqBWrd = SeqWrd4Bases(pSeqB,0,12);		// initial 12 bases of SeqB are compared with SeqA at each putative overlap so most putative overlaps are rejected without a full compare
 for(FirstSeqAOfs = 0; FirstSeqAOfs <= (SeqALen - MinOverlap); FirstSeqAOfs++)
 	{
-	if(!(FirstSeqAOfs % 15))
-		FirstSeqAWrd = *pSeqA++ & cSeqWrd4Msk;
-	else
-		FirstSeqAWrd <<= 2;
-	if((FirstSeqABase = (FirstSeqAWrd & 0x30000000)) != FirstSeqBBase && !(MaxEnd12Subs || MaxSubsPerK)) // if mismatches when no subs allowed then try next SeqA base
+	if(FirstSeqAOfs > 0 && !(FirstSeqAOfs % 15))
+		pSeqA++;
+	FirstSeqAWrd = SeqWrd4Bases(pSeqA,FirstSeqAOfs % 15,12);
+	if(FirstSeqAWrd != FirstSeqBWrd && !(MaxEnd12Subs || MaxSubsPerK)) // if mismatches when no subs allowed then try next SeqA base
+		{
+		ABMaxOverlapLen = 0;
 		continue;
+		}
 
-	CurNumSubs = 0;
-	Cur5EndSubs = 0;
-	Cur3EndSubs = 0;
-	CurSeqAWrd = FirstSeqAWrd;
-	CurSeqBWrd = FirstSeqBWrd;
-	CurSeqABase = FirstSeqABase;
-	CurSeqBBase = FirstSeqBBase;
-	CurSeqAOfs = FirstSeqAOfs;
-
-	pCurSeqA = pSeqA;
-	pCurSeqB = pSeqB;
 	ABMaxOverlapLen = min(SeqALen - FirstSeqAOfs,SeqBLen);	// current max overlap possible of A onto B
 	Max3End12Subs = MaxEnd12Subs;
 	
@@ -7904,46 +7935,14 @@ for(FirstSeqAOfs = 0; FirstSeqAOfs <= (SeqALen - MinOverlap); FirstSeqAOfs++)
 			Max3End12Subs = max(1,(MaxEnd12Subs * (ABMaxOverlapLen - 11)) / 12);
 		}
 
-	for(CurSeqBOfs = 0; CurSeqBOfs < ABMaxOverlapLen; CurSeqBOfs++)
+	if((FirstSeqAWrd != FirstSeqBWrd) && SeqWrd4PopCnt(SeqWrd4Diffs(FirstSeqAWrd,FirstSeqBWrd)) > (MaxEnd12Subs ? MaxEnd12Subs : CurMaxKbpNumSubs))
 		{
-		if(CurSeqBOfs > 0)
-			{
-			if(!(++CurSeqAOfs % 15))
-				CurSeqAWrd = *pCurSeqA++ & cSeqWrd4Msk;
-			else
-				CurSeqAWrd <<= 2;
-			CurSeqABase = CurSeqAWrd & 0x30000000;
-			}
-
-		if(!(CurSeqBOfs % 15))
-			CurSeqBWrd = *pCurSeqB++ & cSeqWrd4Msk;
-		else
-			CurSeqBWrd <<= 2;
-		CurSeqBBase = CurSeqBWrd & 0x30000000;
-
-		if(CurSeqABase != CurSeqBBase)
-			{
-			if(MaxEnd12Subs)
-				{
-				if(CurSeqBOfs < 12)
-					Cur5EndSubs += 1;
-				else
-					{
-					if(CurSeqBOfs < (ABMaxOverlapLen - 12))
-						CurNumSubs += 1;
-					else
-						Cur3EndSubs += 1;
-					}
-				}
-			else
-				CurNumSubs += 1;
-			if(Cur5EndSubs > MaxEnd12Subs || Cur3EndSubs > Max3End12Subs || CurNumSubs > CurMaxKbpNumSubs)
-				break;
-			}
+		ABMaxOverlapLen = 0;
+		continue;
 		}
-	if(CurSeqBOfs == ABMaxOverlapLen)
+
+	if(MatchPackedSeqs(ABMaxOverlapLen,FirstSeqAOfs,pStartSeqA,0,pSeqB,MaxEnd12Subs,Max3End12Subs,CurMaxKbpNumSubs,&ABNumSubs))
 		{
-		ABNumSubs = Cur5EndSubs + Cur3EndSubs + CurNumSubs;
 		SeqALeft = FirstSeqAOfs;
 		break;
 		}
@@ -7971,36 +7970,23 @@ CurNumSubs = SeqALen;
 SeqALen = SeqBLen;
 pSeqB = pStartSeqA;
 SeqBLen = CurNumSubs;
+pStartSeqA = pSeqA;
 
-CurNumSubs = 0;
-Cur5EndSubs = 0;
-Cur3EndSubs = 0;
-CurSeqAOfs = 0;
 BANumSubs = 0;
 SeqBLeft = 0;
 BAMaxOverlapLen = 0;
-FirstSeqBWrd = *pSeqB;
-FirstSeqBBase = FirstSeqBWrd & 0x30000000; 
+FirstSeqBWrd = SeqWrd4Bases(pSeqB,0,12);		// initial 12 bases of SeqB are compared with SeqA at each putative overlap so most putative overlaps are rejected without a full compare
 for(FirstSeqAOfs = 0; FirstSeqAOfs <= (SeqALen - MinOverlap); FirstSeqAOfs++)
 	{
-	if(!(FirstSeqAOfs % 15))
-		FirstSeqAWrd = *pSeqA++ & cSeqWrd4Msk;
-	else
-		FirstSeqAWrd <<= 2;
-	if((FirstSeqABase = (FirstSeqAWrd & 0x30000000)) != FirstSeqBBase && !(MaxEnd12Subs || MaxSubsPerK)) // if mismatches when no subs allowed then try next SeqA base
+	if(FirstSeqAOfs > 0 && !(FirstSeqAOfs % 15))
+		pSeqA++;
+	FirstSeqAWrd = SeqWrd4Bases(pSeqA,FirstSeqAOfs % 15,12);
+	if(FirstSeqAWrd != FirstSeqBWrd && !(MaxEnd12Subs || MaxSubsPerK)) // if mismatches when no subs allowed then try next SeqA base
+		{
+		BAMaxOverlapLen = 0;
 		continue;
+		}
 
-	CurNumSubs = 0;
-	Cur5EndSubs = 0;
-	Cur3EndSubs = 0;
-	CurSeqAWrd = FirstSeqAWrd;
-	CurSeqBWrd = FirstSeqBWrd;
-	CurSeqABase = FirstSeqABase;
-	CurSeqBBase = FirstSeqBBase;
-	CurSeqAOfs = FirstSeqAOfs;
-
-	pCurSeqA = pSeqA;
-	pCurSeqB = pSeqB;
 	BAMaxOverlapLen = min(SeqALen - FirstSeqAOfs,SeqBLen);	// sequences were exchanged so actually current max overlap possible of B onto A
 	Max3End12Subs = MaxEnd12Subs;
 	
@@ -8015,46 +8001,14 @@ for(FirstSeqAOfs = 0; FirstSeqAOfs <= (SeqALen - MinOverlap); FirstSeqAOfs++)
 			Max3End12Subs = max(1,(MaxEnd12Subs * (BAMaxOverlapLen - 11)) / 12);
 		}
 
-	for(CurSeqBOfs = 0; CurSeqBOfs < BAMaxOverlapLen; CurSeqBOfs++)
+	if((FirstSeqAWrd != FirstSeqBWrd) && SeqWrd4PopCnt(SeqWrd4Diffs(FirstSeqAWrd,FirstSeqBWrd)) > (MaxEnd12Subs ? MaxEnd12Subs : CurMaxKbpNumSubs))
 		{
-		if(CurSeqBOfs > 0)
-			{
-			if(!(++CurSeqAOfs % 15))
-				CurSeqAWrd = *pCurSeqA++ & cSeqWrd4Msk;
-			else
-				CurSeqAWrd <<= 2;
-			CurSeqABase = CurSeqAWrd & 0x30000000;
-			}
-
-		if(!(CurSeqBOfs % 15))
-			CurSeqBWrd = *pCurSeqB++ & cSeqWrd4Msk;
-		else
-			CurSeqBWrd <<= 2;
-		CurSeqBBase = CurSeqBWrd & 0x30000000;
-
-		if(CurSeqABase != CurSeqBBase)
-			{
-			if(MaxEnd12Subs)
-				{
-				if(CurSeqBOfs < 12)
-					Cur5EndSubs += 1;
-				else
-					{
-					if(CurSeqBOfs < (BAMaxOverlapLen - 12))
-						CurNumSubs += 1;
-					else
-						Cur3EndSubs += 1;
-					}
-				}
-			else
-				CurNumSubs += 1;
-			if(Cur5EndSubs > MaxEnd12Subs || Cur3EndSubs > Max3End12Subs || CurNumSubs > CurMaxKbpNumSubs)
-				break;
-			}
+		BAMaxOverlapLen = 0;
+		continue;
 		}
-	if(CurSeqBOfs == BAMaxOverlapLen)
+
+	if(MatchPackedSeqs(BAMaxOverlapLen,FirstSeqAOfs,pStartSeqA,0,pSeqB,MaxEnd12Subs,Max3End12Subs,CurMaxKbpNumSubs,&BANumSubs))
 		{
-		BANumSubs = Cur5EndSubs + Cur3EndSubs + CurNumSubs;
 		SeqBLeft = FirstSeqAOfs;
 		break;
 		}
@@ -695,6 +695,21 @@ friend class CPacBio;					// CPacBio requires access to all members of this clas
 			int MaxEnd12Subs,				// allow at the initial 12bp of the 5' or 3' of match to have this many base mismatches in addition to the overall allowed MaxSubs (expected to be in range 0..6) 
 			int *pNumSubs);					// total number of substitutions actually required
 
+	static tSeqWrd4							// returns mismatch flags between two full tSeqWrd4s, bit 2*(14-N) is set if base N differs
+		SeqWrd4Diffs(tSeqWrd4 SeqWrd1,		// compare bases in this packed word
+				tSeqWrd4 SeqWrd2);			// against bases in this packed word
+
+	static bool								// true if substitutions between Seq1 and Seq2 over MatchLen are within the allowed limits
+		MatchPackedSeqs(int MatchLen,		// compare over this many bases
+			int Seq1Ofs,					// base offset in Seq1 at which to start compare
+			tSeqWrd4 *pSeq1,				// sequence 1, any header words already skipped
+			int Seq2Ofs,					// base offset in Seq2 at which to start compare
+			tSeqWrd4 *pSeq2,				// sequence 2, any header words already skipped
+			int MaxEnd12Subs,				// if non-zero then substitutions in initial 12bp (5') are counted separately and limited to this many
+			int Max3End12Subs,				// and substitutions in the final 12bp (3') are limited to this many
+			int MaxSubs,					// all other substitutions are limited to this many
+			int *pNumSubs);					// returned total number of substitutions if within limits
+
 	etSeqBase								// returns a single base at Ofs 0..N relative to the SeqWrd ptd at by pSeq
 			GetBase(int Ofs,				// offset of base to return
 				tSeqWrd4 *pSeq);				// Seq1 (probe) packed sequence containing bases
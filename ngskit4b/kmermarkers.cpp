@@ -49,6 +49,7 @@ KmerMarkers(etPMode PMode,				// processing mode - defaults to 0
 		  int SuffixLen,				// cultivar specific suffix length
 		  int MinWithPrefix,			// minimum number of cultivars required to have the shared prefix
 		  int MaxHomozygotic,			// only report prefixes if K-Mer suffixes are homozygotic between a maximum of this many cultivars, if 0 then no homozygotic check
+		  int ExtMemMB,					// if > 0 then count K-mers in partitions spilled to temp files bounded by this memory budget in MB
 		  char *pszSfxPseudoGenome,		// contains pregenerated suffix over psuedochromosomes for each cultivar
 		  char *pszMarkerFile,			// output potential markers to this file
 		  int NumThreads);				// max number of threads allowed
@@ -79,6 +80,7 @@ int PrefixLen;				// K-mer prefix length
 int SuffixLen;				// K-mer suffix length
 int MinWithPrefix;			// report on K-mers with prefixes shared between at least this many cultivars
 int MaxHomozygotic;			// only report prefixes if all K-Mer suffixes are homozygotic between a maximum of this many cultivars, if 0 then no homozygotic check
+int ExtMemMB;				// if > 0 then count K-mers in partitions spilled to temp files bounded by this memory budget in MB
 
 char szSfxPseudoGenome[_MAX_PATH];		// contains assembly + suffix array over all psuedo-chromosomes for all cultivars
 char szMarkerFile[_MAX_PATH];			// output potential markers to this file
@@ -98,6 +100,7 @@ struct arg_int *kmerlen = arg_int0("k","kmer","<int>",			"K-mers of this length
 struct arg_int *prefixlen = arg_int0("p","prefixlen","<int>",	"K-mer prefix sequences of this length (defaults to K-mer length specified");
 struct arg_int *minwithprefix = arg_int0("s","minshared","<int>","Inter-cultivar shared prefix sequences must be present in this many cultivars (0 default all)");
 struct arg_int *maxhomozygotic = arg_int0("S","maxhomozygotic","<int>","Only report prefix if all suffixes are homozygotic between at most this many different cultivars, if 0 then no check, default 1");
+struct arg_int *extmem = arg_int0(NULL,"extmem","<int>",		"external K-mer counting: count K-mers in minimizer partitions spilled to temp files bounded by this memory budget in MB (default 0 for suffix array iteration, minimum 256)");
 struct arg_file *infile = arg_file1("i","in","<file>",		    "Use this suffix indexed pseudo-chromosomes file");
 struct arg_file *outfile = arg_file1("o","markers","<file>",	"Output accepted marker K-mer sequences to this multifasta file");
 struct arg_int *numthreads = arg_int0("T","threads","<int>",		"number of processing threads 0..128 (defaults to 0 which sets threads to number of CPU cores)");
@@ -109,7 +112,7 @@ struct arg_end *end = arg_end(200);
 
 void *argtable[] = {help,version,FileLogLevel,LogFile,
 					summrslts,experimentname,experimentdescr,
-					pmode,kmerlen,prefixlen,minwithprefix,maxhomozygotic,infile,outfile,
+					pmode,kmerlen,prefixlen,minwithprefix,maxhomozygotic,extmem,infile,outfile,
 					numthreads,
 					end};
 
@@ -308,6 +311,13 @@ if (!argerrors)
 	else
 		MaxHomozygotic = 0;
 
+	ExtMemMB = extmem->count ? extmem->ival[0] : 0;
+	if(ExtMemMB != 0 && ExtMemMB < cMinExtKMerMemMB)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: External K-mer counting memory budget '--extmem %d' must be either 0 or at least %d",ExtMemMB,cMinExtKMerMemMB);
+		return(1);
+		}
+
 	strcpy(szSfxPseudoGenome,infile->filename[0]);
 	CUtility::TrimQuotedWhitespcExtd(szSfxPseudoGenome);
 	if(strlen(szSfxPseudoGenome) < 1)
@@ -353,6 +363,11 @@ if (!argerrors)
 			gDiagnostics.DiagOutMsgOnly(eDLInfo,"Maximum number of cultivars with homozygotic suffixes: 'Not checked'");
 		}
 
+	if(ExtMemMB)
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"External K-mer counting memory budget: %dMB",ExtMemMB);
+	else
+		gDiagnostics.DiagOutMsgOnly(eDLInfo,"External K-mer counting memory budget: 'Not used'");
+
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Input indexed pseudo-genome file: '%s'",szSfxPseudoGenome);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Write marker K-mers to file: '%s'",szMarkerFile);
 
@@ -374,6 +389,7 @@ if (!argerrors)
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(SuffixLen),"suffixlen",&SuffixLen);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(MinWithPrefix),"minwithprefix",&MinWithPrefix);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(MaxHomozygotic),"maxhomozygotic",&MaxHomozygotic);
+		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(ExtMemMB),"extmem",&ExtMemMB);
 
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(NumThreads),"threads",&NumThreads);
 		ParamID = gSQLiteSummaries.AddParameter(gExperimentID, gProcessingID,ePTInt32,sizeof(NumberOfProcessors),"cpus",&NumberOfProcessors);
@@ -391,7 +407,7 @@ if (!argerrors)
 	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
 #endif
 	gStopWatch.Start();
-	Rslt = KmerMarkers((etPMode)PMode,KMerLen,PrefixLen,SuffixLen,MinWithPrefix,MaxHomozygotic,szSfxPseudoGenome,szMarkerFile,NumThreads);
+	Rslt = KmerMarkers((etPMode)PMode,KMerLen,PrefixLen,SuffixLen,MinWithPrefix,MaxHomozygotic,ExtMemMB,szSfxPseudoGenome,szMarkerFile,NumThreads);
 	Rslt = Rslt >=0 ? 0 : 1;
 	if(gExperimentID > 0)
 		{
@@ -420,6 +436,7 @@ KmerMarkers(etPMode PMode,				// processing mode - defaults to 0
 		  int SuffixLen,				// cultivar specific suffix length
 		  int MinWithPrefix,			// minimum number of cultivars required to have the shared prefix
 		  int MaxHomozygotic,			// only report prefixes if K-Mer suffixes are homozygotic between a maximum of this many cultivars, if 0  then no check
+		  int ExtMemMB,					// if > 0 then count K-mers in partitions spilled to temp files bounded by this memory budget in MB
 		  char *pszSfxPseudoGenome,		// contains pregenerated suffix over psuedochromosomes for each cultivar
 		  char *pszMarkerFile,			// output potential markers to this file
 		  int NumThreads)				// max number of threads allowed
@@ -427,7 +444,7 @@ KmerMarkers(etPMode PMode,				// processing mode - defaults to 0
 int Rslt;
 CMarkerKMers Markers;
 
-Rslt = Markers.LocKMers(PMode,KMerLen,PrefixLen,SuffixLen,MinWithPrefix,MaxHomozygotic,pszSfxPseudoGenome,pszMarkerFile,NumThreads);
+Rslt = Markers.LocKMers(PMode,KMerLen,PrefixLen,SuffixLen,MinWithPrefix,MaxHomozygotic,ExtMemMB,pszSfxPseudoGenome,pszMarkerFile,NumThreads);
 
 Markers.Reset();
 return(Rslt);
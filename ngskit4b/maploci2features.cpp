@@ -49,7 +49,8 @@ int MLFProcess(etMLFPMode PMode,		// processing mode
 			int RegRegionLen,			// regulatory region length
 			int MinLength,				// minimum element length
 			int MaxLength,				// maximum element length
-			int JoinOverlap);			// deduping join overlap
+			int JoinOverlap,			// deduping join overlap
+			int NumThreads);			// number of worker threads to use when annotating elements
 
 char *CSVFormat2Text(teCSVFormat Format);
 
@@ -79,6 +80,8 @@ int iRegLen;				// up/down stream regulatory region length
 int iMinLength;
 int iMaxLength;
 int iJoinOverlap;
+int NumberOfProcessors;		// number of installed CPUs
+int NumThreads;				// number of threads (0 defaults to number of CPUs)
 bool bDedupe;				// if true then dedupe input elements
 bool bFeatinsts;			// if true then associate to individual features
 bool bOneCntRead;			// true if one count per read rule to be applied (functional regions are prioritised with CDS as the highest) 
@@ -120,6 +123,7 @@ struct arg_int  *MaxLength = arg_int0("L","maxlength","<int>",   "maximum elemen
 struct arg_int  *JoinOverlap = arg_int0("j","joinoverlap","<int>","joins cores which only differ by this many bases in start loci (default 0)");
 struct arg_lit  *featinsts    = arg_lit0("z","featinsts",        "associate to individual features");
 struct arg_lit  *onecntread   = arg_lit0("y","onecntread",       "prioritise functional regions so that there is only one count per read");
+struct arg_int *threads = arg_int0("T","threads","<int>",		"number of processing threads 0..128 (defaults to 0 which sets threads to number of CPU cores)");
 struct arg_file *summrslts = arg_file0("q","sumrslts","<file>",		"Output results summary to this SQLite3 database file");
 struct arg_str *experimentname = arg_str0("w","experimentname","<str>",		"experiment name SQLite3 database file");
 struct arg_str *experimentdescr = arg_str0("W","experimentdescr","<str>",	"experiment description SQLite3 database file");
@@ -129,7 +133,7 @@ struct arg_end *end = arg_end(200);
 void *argtable[] = {help,version,FileLogLevel,LogFile,
 					summrslts,experimentname,experimentdescr,
 					pmode,dedupe,ftype,featinsts,isoformrprt,onecntread,strandproc,CSVFormat,InLociFile,InBEDFile,RsltsFile,featrsltsfile,summrsltsfile,RegLen,
-					MinLength,MaxLength,JoinOverlap,
+					MinLength,MaxLength,JoinOverlap,threads,
 					end};
 
 char **pAllArgs;
@@ -266,6 +270,24 @@ if (!argerrors)
 		printf("\nError: Processing mode '-m%d' specified outside of range %d..%d",PMode,0,(int)ePMplaceholder-1);
 		exit(1);
 		}
+
+#ifdef _WIN32
+	SYSTEM_INFO SystemInfo;
+	GetSystemInfo(&SystemInfo);
+	NumberOfProcessors = SystemInfo.dwNumberOfProcessors;
+#else
+	NumberOfProcessors = sysconf(_SC_NPROCESSORS_CONF);
+#endif
+	int MaxAllowedThreads = min(cMaxWorkerThreads,NumberOfProcessors);	// limit to be at most cMaxWorkerThreads
+	if((NumThreads = threads->count ? threads->ival[0] : MaxAllowedThreads)==0)
+		NumThreads = MaxAllowedThreads;
+	if(NumThreads < 0 || NumThreads > MaxAllowedThreads)
+		{
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Number of threads '-T%d' specified was outside of range %d..%d",NumThreads,1,MaxAllowedThreads);
+		gDiagnostics.DiagOut(eDLWarn,gszProcName,"Warning: Defaulting number of threads to %d",MaxAllowedThreads);
+		NumThreads = MaxAllowedThreads;
+		}
+
 	bDedupe = dedupe->count ? true : false;
 	bFeatinsts = featinsts->count ? true : false;
 	bOneCntRead = onecntread->count ? true : false;
@@ -463,6 +485,7 @@ if (!argerrors)
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Minimum element length: %d",iMinLength);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Maximum element length: %d",iMaxLength);
 	gDiagnostics.DiagOutMsgOnly(eDLInfo,"Join overlap: %d",iJoinOverlap);
+	gDiagnostics.DiagOutMsgOnly(eDLInfo,"number of threads : %d",NumThreads);
 
 	if(szExperimentName[0] != '\0')
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"This processing reference: %s",szExperimentName);
@@ -471,7 +494,7 @@ if (!argerrors)
 	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
 #endif
 	gStopWatch.Start();
-	Rslt = MLFProcess((etMLFPMode)PMode,bDedupe,bFeatinsts,bOneCntRead,IsoformRprt,StrandProc,FType,(teCSVFormat)iCSVFormat,szInLociFile,szInBEDFile,szRsltsFile,szFeatRsltsFile,szSummRsltsFile,iRegLen,iMinLength,iMaxLength,iJoinOverlap);
+	Rslt = MLFProcess((etMLFPMode)PMode,bDedupe,bFeatinsts,bOneCntRead,IsoformRprt,StrandProc,FType,(teCSVFormat)iCSVFormat,szInLociFile,szInBEDFile,szRsltsFile,szFeatRsltsFile,szSummRsltsFile,iRegLen,iMinLength,iMaxLength,iJoinOverlap,NumThreads);
 	Rslt = Rslt >=0 ? 0 : 1;
 	if(gExperimentID > 0)
 		{
@@ -524,7 +547,8 @@ int MLFProcess(etMLFPMode PMode,				// processing mode
 			   int RegRegionLen,			// regulatory region length
 			   int MinLength,				// minimum element length
 			   int MaxLength,				// maximum element length
-			   int JoinOverlap)			// deduping join overlap
+			   int JoinOverlap,			// deduping join overlap
+			   int NumThreads)			// number of worker threads to use when annotating elements
 {
 int Rslt;
 CMapLoci2Feat *pMapLoci2Feat;
@@ -534,7 +558,7 @@ if((pMapLoci2Feat = new CMapLoci2Feat) == nullptr)
 	return(eBSFerrObj);
 	}
 Rslt = pMapLoci2Feat->MLFProcess(PMode, bDedupe, bFeatinsts, bOneCntRead, IsoformRprt, StrandProc, Ftype, CSVFormat, pszInLociFile, pszInBEDFile, pszRsltsFile,
-						  pszFeatRsltsFile, pszSummRsltsFile, RegRegionLen, MinLength, MaxLength, JoinOverlap);
+						  pszFeatRsltsFile, pszSummRsltsFile, RegRegionLen, MinLength, MaxLength, JoinOverlap, NumThreads);
 delete pMapLoci2Feat;
 return(Rslt);
 }
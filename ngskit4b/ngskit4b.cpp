@@ -84,6 +84,7 @@ extern int gengoassoc(int argc, char* argv[]);
 extern int gengoterms(int argc, char* argv[]);
 extern int hammings(int argc, char* argv[]);
 extern int fasta2bed(int argc,char *argv[]);
+extern int fmindex(int argc,char *argv[]);
 extern int BenchmarkAligners(int argc, char* argv[]);
 extern int SNPs2pgSNPs(int argc, char* argv[]);
 extern int LocHap2Bed(int argc, char *argv[]);
@@ -174,6 +175,7 @@ tsSubProcess SubProcesses[] = {
 	{"gengoterms","gengoterms","Generate biogoterms pre-indexed GO terms",gengoterms},
 	{"hammings","Hamming Distances","Generate hamming distances for K-mer over sequences",hammings},
 	{"fasta2bed","Fasta to BED","Generate BED file from fasta containing sequence names and lengths",fasta2bed},
+	{"fmindex","FM Index","Create FM index over file contents, or verify an FM index against the file it was created from",fmindex},
 	{"genbioseq","Fasta to bioseq","Generate bioseq format file from fasta",genbioseq},
 	{"pangenome","pangenome prefix","Process pangenome fasta or SAM for prefixes",pangenome},
 	{"seghaplotypes","pangenome haplotype segmentate","Segmentate pangenome haplotypes",seghaplotypes},
@@ -311,7 +313,12 @@ for(Idx = 1; Idx < argc; Idx++)
 		break;
 	}
 if(SubProcID > 0)
+	{
+	CRunProfile::EnableFromEnv(gszProcName,(char *)SubProcesses[SubProcID-1].pszName);	// profiling if requested through the environment
 	Rslt = ExecSubProcess(SubProcID,argc,(char **)argv);
+	CRunProfile::Report();
+	CWorkPool::ReleaseShared();		// subprocesses may have started the shared work pool threads
+	}
 else
 	{
 	GiveHelpSubProcesses((char *)cpszProcOverview);
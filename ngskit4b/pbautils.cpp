@@ -85,7 +85,7 @@ struct arg_lit* version = arg_lit0("v", "version,ver", "print version informatio
 struct arg_int* FileLogLevel = arg_int0("f", "FileLogLevel", "<int>", "Level of diagnostics written to screen and logfile 0=fatal,1=errors,2=info,3=diagnostics,4=debug");
 struct arg_file* LogFile = arg_file0("F", "log", "<file>", "diagnostics log file");
 
-struct arg_int* pmode = arg_int0("m", "mode", "<int>", "processing mode: 0 PBA to Fasta, 1 Fasta to PBA, 2 concordance over PBA samples, 3 concordance over WIG samples, 4 allelic variant VCF, 5 allelic genotype VCF, 6 diplotype only genotype VCF, 7 deletion genotype VCF, 8 segment BED");
+struct arg_int* pmode = arg_int0("m", "mode", "<int>", "processing mode: 0 PBA to Fasta, 1 Fasta to PBA, 2 concordance over PBA samples, 3 concordance over WIG samples, 4 allelic variant VCF, 5 allelic genotype VCF, 6 diplotype only genotype VCF, 7 deletion genotype VCF, 8 segment BED, 9 convert PBA to v2 chromosome indexed format, 10 convert PBA to v1 format");
 struct arg_int* limitpbas = arg_int0("l", "limitpbas", "<int>", " limit number of loaded PBA files to this many. 0: no limits, > 0 sets upper limit (default 0)");
 struct arg_int* pbastrim5 = arg_int0("x", "trim5", "<int>", "trim this many aligned PBAs from 5' end of aligned segments (default 0, range 0..100)");
 struct arg_int* pbastrim3 = arg_int0("X", "trim3", "<int>", "trim this many aligned PBAs from 3' end of aligned segments (default 0, range 0..100)");
@@ -100,7 +100,7 @@ struct arg_str* refassemb = arg_str0("r", "refassemb", "<str>", "reference assem
 struct arg_str* ExcludeChroms = arg_strn("Z", "chromexclude", "<string>", 0, cMaxExcludeChroms, "high priority - regular expressions defining chromosomes to exclude");
 struct arg_str* IncludeChroms = arg_strn("z", "chromeinclude", "<string>", 0, cMaxIncludeChroms, "low priority - regular expressions defining chromosomes to include");
 struct arg_file* infiles = arg_filen("i", "infiles", "<file>", 0, cMaxWildCardFileSpecs, "input file(s), wildcards allowed, limit of 200 filespecs supported");
-struct arg_file* chromfile = arg_file1("c", "chromfile", "<file>", "input BED file containing chromosome names and sizes");
+struct arg_file* chromfile = arg_file0("c", "chromfile", "<file>", "input BED file containing chromosome names and sizes, required for all modes except 9 and 10");
 
 struct arg_file* refassembfile = arg_file0("R", "refassembfile", "<file>", "reference PBA file, required when generating VCF from PBA files");
 struct arg_file* roifile = arg_file0("C", "roifile", "<file>", "BED file containing regions of interest - optional - when generating VCFs from PBA files");
@@ -339,8 +339,12 @@ if(!argerrors)
 		}
 	else
 		{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "No BED file containing chromosome names and sizes specified");
-		exit(1);
+		szChromFile[0] = '\0';
+		if(PMode != ePBAu2PBAv2 && PMode != ePBAu2PBAv1)	// format conversions are over complete PBA files so chromosome sizes not required
+			{
+			gDiagnostics.DiagOut(eDLFatal, gszProcName, "No BED file containing chromosome names and sizes specified");
+			exit(1);
+			}
 		}
 
 	NumIncludeChroms = 0;
@@ -456,6 +460,12 @@ if(!argerrors)
 		case ePBAu2BED:
 			pszDescr = "generate BED containing all transcribed regions";
 			break;
+		case ePBAu2PBAv2:
+			pszDescr = "convert PBA file to version 2 chromosome indexed format";
+			break;
+		case ePBAu2PBAv1:
+			pszDescr = "convert PBA file to version 1 format";
+			break;
 	}
 
 	gDiagnostics.DiagOutMsgOnly(eDLInfo, "PBA utilities : '%s'", pszDescr);
@@ -483,7 +493,8 @@ if(!argerrors)
 
 	if(PMode == ePBAu2AVCF || PMode == ePBAu2GVCF || PMode == ePBAu2DiVCF || PMode == ePBAu2DVCF)
 		gDiagnostics.DiagOutMsgOnly(eDLInfo, "PBA reference assembly : '%s'", szRefAssembFile);
-	gDiagnostics.DiagOutMsgOnly(eDLInfo, "BED containing chromosome names and sizes : '%s'", szChromFile);
+	if(szChromFile[0] != '\0')
+		gDiagnostics.DiagOutMsgOnly(eDLInfo, "BED containing chromosome names and sizes : '%s'", szChromFile);
 	if (PMode == ePBAu2PBA || PMode == ePBAu2WIGConcordance)
 		{
 		gDiagnostics.DiagOutMsgOnly(eDLInfo, "Reference assembly : '%s'", szRefAssemb);
@@ -920,6 +931,22 @@ strcpy(m_szOutFile, pszOutFile);
 if(pszRefAssembFile != nullptr && pszRefAssembFile[0] != '\0')
 	strcpy(m_szRefAssembFile, pszRefAssembFile);
 
+// format conversions are of complete PBA files, all chromosomes are converted without filtering
+if (PMode == ePBAu2PBAv2 || PMode == ePBAu2PBAv1)
+	{
+	CSimpleGlob glob(SG_GLOB_FULLSORT);
+	glob.Init();
+	if (glob.Add(pszInputFiles[0]) < SG_SUCCESS || glob.FileCount() != 1)
+		{
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Process: Unable to glob '%s' input file spec as a single PBA file", pszInputFiles[0]);
+		Reset();
+		return(eBSFerrOpnFile);	// treat as though unable to open file
+		}
+	Rslt = CPBAfile::Convert(glob.File(0), pszOutFile, PMode == ePBAu2PBAv2 ? cPBAFileVersion2 : cPBAFileVersion1);
+	Reset();
+	return(Rslt);
+	}
+
 // compile include/exclude chromosome regexpr if user has specified alignments to be filtered by chrom
 if(Rslt = (m_RegExprs.CompileREs(NumIncludeChroms, pszIncludeChroms,NumExcludeChroms, pszExcludeChroms)) < eBSFSuccess)
 	{
@@ -3788,6 +3815,7 @@ CPBAutils::Fasta2PBA(char *pszExperimentID, // experiment identifier
 	char *pszOutFile)		  // PBA format output file
 {
 	CFasta Fasta;
+	CPBAfile PBAFile;
 	uint8_t* pPackedBaseAlleles;
 	size_t AvailBuffSize;
 	char szChromName[cBSFSourceSize];
@@ -3799,7 +3827,7 @@ CPBAutils::Fasta2PBA(char *pszExperimentID, // experiment identifier
 	int ChromID;
 	uint32_t PBAIdx;
 	uint32_t ChromPBAlen;
-	uint32_t ChromLenIdx;
+	int32_t MaxDirLen;
 	uint32_t ChromIndeterminates;
 	uint32_t NumPBAChroms;
 	size_t AssemblyChromIndeterminates;
@@ -3825,34 +3853,17 @@ CPBAutils::Fasta2PBA(char *pszExperimentID, // experiment identifier
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "Fasta2PBA: Loading Fasta sequences from %s..", pszInFile);
 
 
-#ifdef _WIN32
-	m_hOutFile = open(pszOutFile, (O_WRONLY | _O_BINARY | _O_SEQUENTIAL | _O_CREAT | _O_TRUNC), (_S_IREAD | _S_IWRITE));
-#else
-	if ((m_hOutFile = open64(pszOutFile, O_WRONLY | O_CREAT, S_IREAD | S_IWRITE)) != -1)
-		if (ftruncate(m_hOutFile, 0) != 0)
-		{
-			gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to create/truncate %s - %s", pszOutFile, strerror(errno));
-			Reset();
-			return(eBSFerrCreateFile);
-		}
-#endif
-	if (m_hOutFile < 0)
+	// PBA file is generated as version 2, with space reserved for a chromosome directory which can hold all chromosomes in the chromosome sizes BED file
+	MaxDirLen = 0;
+	for (ChromID = 0; ChromID < m_NumChromNames; ChromID++)
+		MaxDirLen += CPBAfile::DirEntryLen(&m_szChromNames[m_szChromIdx[ChromID]]);
+	if ((Rslt = PBAFile.Create(pszOutFile, pszExperimentID, pszReferenceID, pszReadsetID, MaxDirLen)) != eBSFSuccess)
 		{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "ReportHaplotypesByProgeny: Unable to create/truncate %s - %s", pszOutFile, strerror(errno));
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Fasta2PBA: Unable to create/truncate %s", pszOutFile);
 		Reset();
-		return(eBSFerrCreateFile);
+		return(Rslt);
 		}
 
-	// Write out the PBA header
-	// This header contains a series of '\n' separated tagname:values
-	// Following the header are a variable number of chromosomes and associated sequences
-m_InNumBuffered = sprintf((char*)m_pInBuffer, "Type:%s\nVersion:1\nExperimentID:%s\nReferenceID:%s\nReadsetID:%s", "PbA", pszExperimentID, pszReferenceID, pszReadsetID);
-m_InNumBuffered += 1;
-if (!CUtility::RetryWrites(m_hOutFile, m_pInBuffer, m_InNumBuffered))
-	{
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "RetryWrites() error");
-	return(eBSFerrWrite);
-	}
 m_InNumBuffered = 0;
 bChromSeq = false;
 ChromPBAlen = 0;
@@ -3877,12 +3888,8 @@ while ((Rslt = SeqLen = Fasta.ReadSequence(&m_pInBuffer[m_InNumBuffered], (int)(
 					return(eBSFerrChrom);
 					}
 
-				*(uint32_t*)&m_pInBuffer[ChromLenIdx] = ChromPBAlen;
-				if (!CUtility::RetryWrites(m_hOutFile, m_pInBuffer, m_InNumBuffered))
-					{
-					gDiagnostics.DiagOut(eDLInfo, gszProcName, "RetryWrites() error");
-					return(eBSFerrWrite);
-					}
+				if ((Rslt = PBAFile.WriteChromPBAs(szChromName, (int32_t)ChromPBAlen, m_pInBuffer)) != eBSFSuccess)
+					return(Rslt);
 				gDiagnostics.DiagOut(eDLInfo, gszProcName, "Chrom '%s' is length %d and has %d indeterminate bases", szChromName, ChromPBAlen, ChromIndeterminates);
 				AssembSeqLen += (size_t)ChromPBAlen;
 				AssemblyChromIndeterminates += (size_t)ChromIndeterminates;
@@ -3893,15 +3900,7 @@ while ((Rslt = SeqLen = Fasta.ReadSequence(&m_pInBuffer[m_InNumBuffered], (int)(
 		m_InNumBuffered = 0;
 		Descrlen = Fasta.ReadDescriptor(szDescription, cBSFDescriptionSize);
 		sscanf(szDescription, " %s[ ,]", szChromName);
-		pPackedBaseAlleles = &m_pInBuffer[m_InNumBuffered];
-		*pPackedBaseAlleles = (uint8_t)strlen(szChromName);
-		strcpy((char*)&pPackedBaseAlleles[1], szChromName);
-		pPackedBaseAlleles += 2 + *pPackedBaseAlleles;
-		*(uint32_t*)pPackedBaseAlleles = 0;
-		ChromLenIdx = (uint32_t)(pPackedBaseAlleles - m_pInBuffer);
-		pPackedBaseAlleles += 4;
-		m_InNumBuffered = (uint32_t)(pPackedBaseAlleles - m_pInBuffer);
-		ChromPBAlen = 0;
+		ChromPBAlen = 0;				// chromosome name and PBA count are recorded in the PBA file chromosome directory so only the PBAs are buffered
 		continue;		
 		}
 
@@ -3961,12 +3960,8 @@ if (Rslt == eBSFSuccess && bChromSeq && m_InNumBuffered)
 			return(eBSFerrChrom);
 			}
 
-		*(uint32_t*)&m_pInBuffer[ChromLenIdx] = ChromPBAlen;
-		if (!CUtility::RetryWrites(m_hOutFile, m_pInBuffer, m_InNumBuffered))
-			{
-			gDiagnostics.DiagOut(eDLInfo, gszProcName, "RetryWrites() error");
-			return(eBSFerrWrite);
-			}
+		if ((Rslt = PBAFile.WriteChromPBAs(szChromName, (int32_t)ChromPBAlen, m_pInBuffer)) != eBSFSuccess)
+			return(Rslt);
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "Chrom '%s' is length %d and has %d indeterminate bases", szChromName, ChromPBAlen, ChromIndeterminates);
 		AssembSeqLen += (size_t)ChromPBAlen;
 		AssemblyChromIndeterminates += (size_t)ChromIndeterminates;
@@ -3980,17 +3975,9 @@ else
 	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Fasta2PBA: Processing errors..");
 	return(Rslt);
 	}
-if (m_hOutFile != -1)
-	{
-	// commit output file
-#ifdef _WIN32
-	_commit(m_hOutFile);
-#else
-	fsync(m_hOutFile);
-#endif
-	close(m_hOutFile);
-	m_hOutFile = -1;
-	}
+// write chromosome directory and commit output file
+if ((Rslt = PBAFile.CloseCreate(true)) != eBSFSuccess)
+	return(Rslt);
 gDiagnostics.DiagOut(eDLInfo, gszProcName, "Fasta2PBA: Completed writing to PBA file %s..", pszOutFile);
 return(Rslt);
 }
@@ -4003,85 +3990,25 @@ CPBAutils::LoadPBAFile(char* pszFile,	// load chromosome metadata and PBA data f
 	bool bChromMetaOnly)  // load chrom metadata (chrom name,length, file offset at which chrom PBAs start) but don't actually load the chromosome PBAs
 {
 	int Rslt;
-	int Version;
-	char szExperimentID[100];
-	char szRefAssemblyID[100];
-	char szReadsetID[100];
+	int32_t ChromIdx;
 	uint32_t PrevChromMetadataIdx;
 	uint32_t ChromID;
 	uint32_t ReadsetID;
 	tsPUReadsetMetadata* pReadsetMetadata;
 	tsPUChromMetadata* pChromMetadata;
 	tsPUChromMetadata* pPrevChromMetadata;
-	int64_t FileOfsPBA;
-	uint8_t* pBuff;
-	int scanlen;
-	int NumTags;
+	tsPBAChrom* pPBAChrom;
+	CPBAfile PBAFile;
 
 	gDiagnostics.DiagOut(eDLInfo, gszProcName, "Loading '%s' file", pszFile);
-#ifdef _WIN32
-	m_hInFile = open(pszFile, O_READSEQ);		// file access is normally sequential..
-#else
-	m_hInFile = open64(pszFile, O_READSEQ);		// file access is normally sequential..
-#endif
-	if (m_hInFile == -1)							// check if file open succeeded
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to open input file '%s' : %s", pszFile, strerror(errno));
-		return(eBSFerrOpnFile);
-	}
-
-	// attempt to load the readset metadata 
-	m_InNumBuffered = 0;
-	m_InNumProcessed = 0;
-	if ((FillInBuffer(500u, min(m_AllocInBuff, 500u)) == 0) || m_InNumBuffered < 9) // 500 will cover the maximally sized header
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Unable to read at least a partial header from input file '%s'", pszFile);
-		return(eBSFerrOpnFile);
-	}
-
-
-	// check file type is PBA
-// check file type is PBA
-	if (strncmp((char*)m_pInBuffer, "Type:PbA", 8))
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists, unable to parse file type header tag as being a packed base allele file", pszFile);
-		return(eBSFerrOpnFile);
-	}
-	// file type in header expected to be followed by a new line, not carriage return then a new line!
-	if (m_pInBuffer[8] != '\n' && m_pInBuffer[9] != 'V')
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists, file type header tag is for a PBA type but this tag is incorrectly terminated. Has file been transformed into ascii?", pszFile);
-		return(eBSFerrOpnFile);
-	}
-	m_InNumProcessed = 9;
-	if (m_InNumBuffered < 500)
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists, unable to read complete header and initial chromosome metadata, expecting file size >= 500, is it a packed base allele file", pszFile);
-		return(eBSFerrOpnFile);
-	}
-
-	// parse out tagnames and associated values
-	pBuff = &m_pInBuffer[m_InNumProcessed];
-	NumTags = sscanf((char*)pBuff, "Version:%d\nExperimentID:%99[^\n]\nReferenceID:%99[^\n]\nReadsetID:%99[^\n]%n", &Version, szExperimentID, szRefAssemblyID, szReadsetID, &scanlen);
-	if (NumTags != 4 || Version != 1 || szExperimentID[0] == '\0' || szRefAssemblyID[0] == '\0' || szReadsetID[0] == '\0')
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists as a packed base allele file but inconsistencies in header tag values", pszFile);
-		return(eBSFerrOpnFile);
-	}
-	gDiagnostics.DiagOut(eDLInfo, gszProcName, "Metadata ExperimentID:%s, ReferenceID:%s, ReadsetID:%s", szExperimentID, szRefAssemblyID, szReadsetID);
-
-	m_InNumProcessed += scanlen + 1;		// header tags were '\n' terminated except for final which was '\0' terminated
-
-	m_InFileOfs = m_InNumProcessed;         // 1st chromosome starts immediately following the header metadata
-	if (_lseeki64(m_hInFile, m_InFileOfs, SEEK_SET) != m_InFileOfs)
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' exists as a packed base allele file but unable to seek past header metadata", pszFile);
-		return(eBSFerrOpnFile);
-	}
+	// header is parsed and chromosome metadata loaded from either the v2 chromosome directory or, for v1 files, by skipping from chromosome to chromosome
+	if ((Rslt = PBAFile.Open(pszFile)) != eBSFSuccess)
+		return(Rslt);
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "Metadata Version:%d, ExperimentID:%s, ReferenceID:%s, ReadsetID:%s", PBAFile.Version(), PBAFile.ExperimentID(), PBAFile.ReferenceID(), PBAFile.ReadsetID());
 
-	if ((ReadsetID = AddReadset(szReadsetID, ReadsetType)) == 0)
+	if ((ReadsetID = AddReadset(PBAFile.ReadsetID(), ReadsetType)) == 0)
 	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' duplicates the ReadsetID '%s' of a previously loaded readset", pszFile, szReadsetID);
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' duplicates the ReadsetID '%s' of a previously loaded readset", pszFile, PBAFile.ReadsetID());
 		return(eBSFerrOpnFile);
 	}
 
@@ -4090,48 +4017,27 @@ CPBAutils::LoadPBAFile(char* pszFile,	// load chromosome metadata and PBA data f
 	pReadsetMetadata->ReadsetType = ReadsetType;
 	pReadsetMetadata->NumChroms = 0;
 	strcpy(pReadsetMetadata->szFileName, pszFile);
-	strcpy(pReadsetMetadata->szExperimentID, szExperimentID);
-	strcpy(pReadsetMetadata->szRefAssemblyID, szRefAssemblyID);
+	strcpy(pReadsetMetadata->szExperimentID, PBAFile.ExperimentID());
+	strcpy(pReadsetMetadata->szRefAssemblyID, PBAFile.ReferenceID());
 	pReadsetMetadata->ReadsetID = ReadsetID;
 	pReadsetMetadata->StartChromID = 0;
 	pReadsetMetadata->StartChromMetadataIdx = 0;
-	pReadsetMetadata->NxtFileChromOfs = m_InFileOfs;
-
-	int ChromNameLen;
-	char* pszChromName;
-	uint32_t ChromLen;
+	pReadsetMetadata->NxtFileChromOfs = PBAFile.EndFileOfs();
 
 	// iterate over all chromosomes
-	m_InNumProcessed = 0;
-	m_InNumBuffered = 0;
 	PrevChromMetadataIdx = 0;
-	while (FillInBuffer((uint32_t)110, 110) == 110) // reading chromosome metadata
+	for (ChromIdx = 0; ChromIdx < PBAFile.NumChroms(); ChromIdx++)
 	{
-		pBuff = &m_pInBuffer[m_InNumProcessed++];
-		ChromNameLen = (int)*pBuff++;
-		pszChromName = (char*)pBuff;
-		pBuff += 1 + ChromNameLen;
-		ChromLen = *(int32_t*)pBuff;
-		FileOfsPBA = pReadsetMetadata->NxtFileChromOfs + ChromNameLen + 6;
-		pReadsetMetadata->NxtFileChromOfs += ChromNameLen + 6 + ChromLen;
-		
+		pPBAChrom = PBAFile.Chrom(ChromIdx);
 		// check if this chromosome is to be retained for further processing
-		if (!AcceptThisChromName(pszChromName))
-		{
-			// not accepting this chromosome
-			m_InFileOfs = pReadsetMetadata->NxtFileChromOfs;         // skip over curent chrom's PBAs to start of next chromosome
-			if ((pReadsetMetadata->NxtFileChromOfs = _lseeki64(m_hInFile, m_InFileOfs, SEEK_SET)) != m_InFileOfs)
-				break;
-			m_InNumProcessed = 0;
-			m_InNumBuffered = 0;
+		if (!AcceptThisChromName(pPBAChrom->szChromName))
 			continue;
-		}
 
 		// before accepting chrom then ensure that it's PBA length matches the BED chromosome sizes
-		ChromID = AddChrom(pszChromName);
-		if (ChromLen != m_ChromSizes[ChromID - 1])
+		ChromID = AddChrom(pPBAChrom->szChromName);
+		if ((uint32_t)pPBAChrom->ChromLen != m_ChromSizes[ChromID - 1])
 			{
-			gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' has chromosome '%s' size mismatch - expected size was %u, actual size %u", pszFile, pszChromName, m_ChromSizes[ChromID - 1], ChromLen);
+			gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' has chromosome '%s' size mismatch - expected size was %u, actual size %u", pszFile, pPBAChrom->szChromName, m_ChromSizes[ChromID - 1], pPBAChrom->ChromLen);
 			return(eBSFerrChrom);
 			}
 
@@ -4154,37 +4060,26 @@ CPBAutils::LoadPBAFile(char* pszFile,	// load chromosome metadata and PBA data f
 		pChromMetadata->ChromID = ChromID;
 		pChromMetadata->ChromMetadataIdx = m_UsedNumChromMetadata;
 		pChromMetadata->NxtChromMetadataIdx = 0;
-		pChromMetadata->ChromLen = ChromLen;
+		pChromMetadata->ChromLen = pPBAChrom->ChromLen;
 		pChromMetadata->ReadsetID = ReadsetID;
 		pChromMetadata->HGBinID = 0;
-		pChromMetadata->FileOfsPBA = FileOfsPBA;
+		pChromMetadata->FileOfsPBA = pPBAChrom->FileOfsPBA;
 		pChromMetadata->pPBAs = nullptr;
 		if (bChromMetaOnly) // loading chrom metadata only without actually loading the chromosome PBAs?
-			{
-			m_InFileOfs = pReadsetMetadata->NxtFileChromOfs;         // skip over curent chrom's PBAs to start of next chromosome
-			if ((pReadsetMetadata->NxtFileChromOfs = _lseeki64(m_hInFile, m_InFileOfs, SEEK_SET)) != m_InFileOfs)
-				break;
-			m_InNumProcessed = 0;
-			m_InNumBuffered = 0;
 			continue;
-			}
-		// loading PBAs
-		pChromMetadata->pPBAs = AllocPBAs(ChromLen);
-		m_InNumProcessed += ChromNameLen + 5;
-		FillInBuffer((uint32_t)ChromLen, ChromLen);
-		pBuff = &m_pInBuffer[m_InNumProcessed];
+
+		// loading PBAs, v2 files are memory mapped with only those pages modified by validation or trimming being copied
+		if ((pChromMetadata->pPBAs = PBAFile.LoadChromPBAs(ChromIdx)) == nullptr)
+			return(eBSFerrFileAccess);
 
 		//	validate PBA allele composition, earlier releases were retaining very low allele proportions so validating and in-place replacing these as being non-alignments
-		int NumErrs = ValidatePBAs(ChromLen, pBuff, true, true);
+		ValidatePBAs(pChromMetadata->ChromLen, pChromMetadata->pPBAs, true, true);
 		//
-		memcpy(pChromMetadata->pPBAs, pBuff, ChromLen);
 		if(m_PBAsTrim5 > 0 || m_PBAsTrim3 > 0)		// trimming aligned segment boundaries as these may have higher polyallele rates
-			TrimPBAs(m_PBAsTrim5, m_PBAsTrim3, ChromLen, pChromMetadata->pPBAs);
-		m_InNumProcessed += ChromLen;
-		}
+			TrimPBAs(m_PBAsTrim5, m_PBAsTrim3, pChromMetadata->ChromLen, pChromMetadata->pPBAs);
+	}
 
-	close(m_hInFile);
-	m_hInFile = -1;
+	PBAFile.Reset();
 	return((int32_t)ReadsetID);
 }
 
@@ -4309,13 +4204,9 @@ uint8_t*  // returned PBA or nullptr if unable to load PBAs for requested sample
 CPBAutils::LoadSampleChromPBAs(uint32_t SampleID,   // Sample identifier
 	uint32_t ChromID)    // chrom identifier specifying which PBAs is to be loaded from SampleID file
 {
-	int hInFile;
 	char* pszChrom;
-	int64_t ChromSeekOfs;
 	tsPUChromMetadata* pChromMetadata;
 	tsPUReadsetMetadata* pReadsetMetadata;
-	uint32_t NumRead;
-	uint32_t NumLoaded;
 
 	// returned pointer to chromosome metadata
 	if ((pChromMetadata = LocateChromMetadataFor(SampleID, ChromID)) == nullptr)
@@ -4334,52 +4225,15 @@ CPBAutils::LoadSampleChromPBAs(uint32_t SampleID,   // Sample identifier
 		pChromMetadata->pPBAs = nullptr;
 	}
 
-	// need to actually load from file
+	// need to actually load from file, v2 files are memory mapped so only the pages for this chromosome will be read
 	pReadsetMetadata = &m_Readsets[SampleID - 1];
-#ifdef _WIN32
-	hInFile = open(pReadsetMetadata->szFileName, O_READSEQ);		// file access is normally sequential..
-#else
-	hInFile = open64(pReadsetMetadata->szFileName, O_READSEQ);		// file access is normally sequential..
-#endif
-	if (hInFile == -1)							// check if file open succeeded
-	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "LoadSampleChromPBA: Unable to open input file '%s' : %s", pReadsetMetadata->szFileName, strerror(errno));
-		return(nullptr);
-	}
-	if ((ChromSeekOfs = _lseeki64(hInFile, pChromMetadata->FileOfsPBA, SEEK_SET)) != pChromMetadata->FileOfsPBA)
+	if ((pChromMetadata->pPBAs = CPBAfile::LoadPBAs(pReadsetMetadata->szFileName, pChromMetadata->FileOfsPBA, pChromMetadata->ChromLen)) == nullptr)
 	{
-		gDiagnostics.DiagOut(eDLFatal, gszProcName, "Input file '%s' opened, _lseek() to file offset %zd failed for chrom '%s', returned %zd, error: '%s'",
-			pReadsetMetadata->szFileName, pChromMetadata->FileOfsPBA, ChromSeekOfs, pszChrom, strerror(errno));
-		close(hInFile);
-		hInFile = -1;
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "LoadSampleChromPBAs: Unable to load chromosome '%s' PBAs from file '%s'", pszChrom, pReadsetMetadata->szFileName);
 		return(nullptr);
 	}
-	pChromMetadata->pPBAs = AllocPBAs(pChromMetadata->ChromLen);
-	// attempt to load Chromosomes PBAs from file
-	NumLoaded = 0;
-	do {
-		if ((NumRead = read(hInFile, &pChromMetadata->pPBAs[NumLoaded], pChromMetadata->ChromLen - NumLoaded)) < 0)
-		{
-			gDiagnostics.DiagOut(eDLFatal, gszProcName, "Error %s attempting to read chromosome '%s' from file '%s'", strerror(errno), pszChrom, pReadsetMetadata->szFileName);
-			close(hInFile);
-			hInFile = -1;
-			if (pChromMetadata->pPBAs == nullptr)
-				return(nullptr);
-#ifdef _WIN32
-			free(pChromMetadata->pPBAs);				// was allocated with malloc/realloc, or mmap/mremap, not c++'s new....
-#else
-			if (pChromMetadata->pPBAs != MAP_FAILED)
-				munmap(pChromMetadata->pPBAs, pChromMetadata->ChromLen);
-#endif
-			pChromMetadata->pPBAs = nullptr;
-			return(nullptr);
-		}
-		NumLoaded += NumRead;
-	} while (NumRead > 0 && NumLoaded < pChromMetadata->ChromLen);
-	close(hInFile);
-	hInFile = -1;
 	//	validate PBA allele composition, earlier releases were retaining very low allele proportions so validating and in-place replacing these as being non-alignments
-	int NumErrs = ValidatePBAs(pChromMetadata->ChromLen, pChromMetadata->pPBAs, true, true);
+	ValidatePBAs(pChromMetadata->ChromLen, pChromMetadata->pPBAs, true, true);
 	//
 	if (m_PBAsTrim5 > 0 || m_PBAsTrim3 > 0)		// trimming aligned segment boundaries as these may have higher polyallele rates
 		TrimPBAs(m_PBAsTrim5, m_PBAsTrim3, pChromMetadata->ChromLen, pChromMetadata->pPBAs);
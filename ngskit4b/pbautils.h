@@ -32,6 +32,8 @@ typedef enum TAG_ePBAuMode {
 	ePBAu2DiVCF,			// generate a diplotype only VCF
 	ePBAu2DVCF,				// generate a deletion VCF
 	ePBAu2BED,				// generate BED containing all transcribed regions
+	ePBAu2PBAv2,			// convert PBA file into version 2 format, chromosome directory with PBAs aligned for memory mapping
+	ePBAu2PBAv1,			// convert PBA file into version 1 format
 	ePBAuPlaceholder		// used as a placeholder to mark number of processing modes
 } ePBAuMode;
 
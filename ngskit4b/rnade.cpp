@@ -3022,7 +3022,7 @@ if ((pBAMfile = new CSAMfile) == nullptr)
 	return(eBSFerrInternal);
 
 PrevNow = gStopWatch.ReadUSecs();
-if((Rslt = pBAMfile->Open(pszInFile)) != eBSFSuccess)
+if((Rslt = pBAMfile->Open(pszInFile,m_NumDEThreads)) != eBSFSuccess)
 	{
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"LoadAlignedReadsBAM: Unable to load reads from from '%s'",pszInFile);
 	delete pBAMfile;
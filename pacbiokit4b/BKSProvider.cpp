@@ -37,6 +37,7 @@ Original 'BioKanga' copyright notice has been retained and is as follows.
 #include <pthread.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <netdb.h>
 typedef struct sockaddr_storage SOCKADDR_STORAGE;
 #include "../libkit4b/commhdrs.h"
@@ -44,6 +45,7 @@ typedef struct sockaddr_storage SOCKADDR_STORAGE;
 
 #include "./SSW.h"
 #include "./BKScommon.h"
+#include "./BKSShm.h"
 #include "./BKSProvider.h"
 const char * cDfltServerPort = "43123";		// default server port to connect to if not user specified
 
@@ -77,6 +79,7 @@ m_Ctrl[1].Socket = INVALID_SOCKET;
 #else
 m_Ctrl[0].Socket = -1;
 m_Ctrl[1].Socket = -1;
+m_hEpoll = -1;
 #endif
 
 Reset();
@@ -212,14 +215,14 @@ CBKSProvider::GetJobToProcess(uint32_t *pInstanceID,		// MANDATORY:  service ins
 							uint64_t *pClassInstanceID,	// MANDATORY: returned class instance to apply job to
 							uint32_t *pClassMethodID,			// MANDATORY: returned class method to apply on class instance
 							  uint32_t *pMaxParamsSize,	//  MANDATORY: on input, max sized parameter block accepted, on return then the actual size of the parameter block
-							  uint8_t *pParams,			//  MANDATORY: returned parameter block
+							  uint8_t **ppParams,			//  MANDATORY: returned ptr to parameter block, valid until JobResponse()
 							  uint32_t *pMaxRequestData,	//  MANDATORY: on input the max sized request data block accepted, on return the actual size of the request data block
-							  uint8_t *pRequestData)		//  MANDATORY: returned request data block
+							  uint8_t **ppRequestData)		//  MANDATORY: returned ptr to request data block, valid until JobResponse()
 {
 teBKSPProvState BKSPState;
 uint32_t InstanceID;
 tsReqResp *pInstance;
-if(pInstanceID == NULL || pMaxParamsSize == NULL || pParams == NULL || pMaxRequestData == NULL || pRequestData == NULL)
+if(pInstanceID == NULL || pMaxParamsSize == NULL || ppParams == NULL || pMaxRequestData == NULL || ppRequestData == NULL)
 	return(eBSFerrParams);
 	// check if all threads requested to terminate
 #ifdef WIN32
@@ -257,10 +260,11 @@ for(InstanceID = 1; InstanceID <= m_BKSConnection.NumInstances; InstanceID+=1)
 			return(-2);
 			}
 
-		if(pInstance->ParamSize > 0)
-			memcpy(pParams,pInstance->Data,pInstance->ParamSize);
-		if (pInstance->InDataSize > 0)
-			memcpy(pRequestData, &pInstance->Data[pInstance->ParamSize], pInstance->InDataSize);
+		// parameters and request data are not copied, the worker reads them in place until it's JobResponse() overwrites them with the response
+		*ppParams = pInstance->pData;
+		*ppRequestData = &pInstance->pData[pInstance->ParamSize];
+		*pMaxParamsSize = pInstance->ParamSize;
+		*pMaxRequestData = pInstance->InDataSize;
 		*pClassInstanceID = pInstance->ClassInstanceID;
 		*pClassMethodID = pInstance->ClassMethodID;
 		pInstance->flgReqAvail = 0;
@@ -327,7 +331,7 @@ if(pInstance->InstanceID != InstanceID || pInstance->InstanceIDEx != InstanceIDE
 
 pInstance->ClassInstanceID = ClassInstanceID;
 if(ResponseSize > 0)
-	memcpy(pInstance->Data, pResponseData, ResponseSize);
+	memcpy(pInstance->pData, pResponseData, ResponseSize);
 pInstance->OutDataSize = ResponseSize;
 pInstance->JobRslt = ProcRslt;
 pInstance->flgCpltd = 1;
@@ -367,7 +371,18 @@ if(m_BKSConnection.TxdRxd.Socket != INVALID_SOCKET)
 		close(m_BKSConnection.TxdRxd.Socket);
 		m_BKSConnection.TxdRxd.Socket = -1;
 		}
+	if(m_hEpoll != -1)			// a new epoll instance is created with each connection
+		{
+		close(m_hEpoll);
+		m_hEpoll = -1;
+		}
 #endif
+if(m_BKSConnection.TxdRxd.pShm != NULL)		// any shared memory transport is specific to the connection
+	{
+	delete m_BKSConnection.TxdRxd.pShm;
+	m_BKSConnection.TxdRxd.pShm = NULL;
+	}
+m_BKSConnection.TxdRxd.flgShmActv = 0;
 if(bFreeMem)
 	{
 	if (m_BKSConnection.TxdRxd.pRxdBuff != NULL)
@@ -838,6 +853,24 @@ if (!bCpltdWrite)				// if a request frame has been received then ensure it is f
 			pOfferedService->ProviderVersion = pPriorityRegService->ProviderVersion;
 			pOfferedService->ServiceInsts = PriorityServiceInstances;
 			pOfferedService->ClassInsts = PriorityServiceInstances;
+			pOfferedService->ShmToken = 0;
+			memset(pOfferedService->szShmName,0,sizeof(pOfferedService->szShmName));
+#ifndef WIN32
+				// if server is on this same host then offer a shared memory transport, server may decline and continue with the socket
+			if(m_BKSConnection.TxdRxd.pShm == NULL && CBKSShm::IsColocated(m_BKSConnection.TxdRxd.Socket))
+				{
+				m_BKSConnection.TxdRxd.pShm = new CBKSShm;
+				if(!m_BKSConnection.TxdRxd.pShm->Create(&pOfferedService->ShmToken,cBKSShmNameLen,pOfferedService->szShmName,
+														PriorityServiceInstances,max(m_BKSConnection.MaxReqPayloadSize,m_BKSConnection.MaxRespPayloadSize)))
+					{
+					gDiagnostics.DiagOut(eDLInfo, gszProcName, "ProcessSessEstab: unable to create shared memory transport, using socket");
+					delete m_BKSConnection.TxdRxd.pShm;
+					m_BKSConnection.TxdRxd.pShm = NULL;
+					pOfferedService->ShmToken = 0;
+					memset(pOfferedService->szShmName,0,sizeof(pOfferedService->szShmName));
+					}
+				}
+#endif
 			m_BKSConnection.TxdRxd.TotTxd += sizeof(tsBKSOfferedService);
 			if((Diff = (m_BKSConnection.TxdRxd.TotRxd - m_BKSConnection.TxdRxd.CurPacRxd)) > 0)
 				{
@@ -874,6 +907,8 @@ if (!bCpltdWrite)				// if a request frame has been received then ensure it is f
 		pOfferedService->ProviderVersion = 0;
 		pOfferedService->ServiceInsts = 0;
 		pOfferedService->ClassInsts = 0;
+		pOfferedService->ShmToken = 0;
+		memset(pOfferedService->szShmName,0,sizeof(pOfferedService->szShmName));
 		m_BKSConnection.TxdRxd.TotTxd += sizeof(tsBKSOfferedService);
 		if ((Diff = (m_BKSConnection.TxdRxd.TotRxd - m_BKSConnection.TxdRxd.CurPacRxd)) > 0)
 			{
@@ -920,6 +955,20 @@ if (!bCpltdWrite)				// if a request frame has been received then ensure it is f
 		m_BKSConnection.TxdRxd.CurPacRxd = 0;
 		m_BKSConnection.TxdRxd.flgRxCplt = 0;
 
+		// if server accepted the shared memory transport then all subsequent frames are through the rings, segment name is no longer required as both have it mapped
+		if(pAcceptService->flgShmAccepted && m_BKSConnection.TxdRxd.pShm != NULL)
+			{
+			m_BKSConnection.TxdRxd.pShm->Unlink();
+			m_BKSConnection.TxdRxd.flgShmActv = 1;
+			gDiagnostics.DiagOut(eDLInfo, gszProcName, "ProcessSessEstab: server accepted shared memory transport");
+			}
+		else
+			if(m_BKSConnection.TxdRxd.pShm != NULL)
+				{
+				delete m_BKSConnection.TxdRxd.pShm;
+				m_BKSConnection.TxdRxd.pShm = NULL;
+				}
+
 		// server has accepted offered service, ready to process service requests
 		gDiagnostics.DiagOut(eDLInfo, gszProcName, "ProcessSessEstab: server has accepted offered %d service instances",m_BKSConnection.NumInstances);
 		m_BKSConnection.BKSPState = eBKSPSAcceptedServiceActv;
@@ -957,14 +1006,24 @@ sBKSServResp *pServResp;
 tsReqResp *pInstance;
 uint32_t TxFrameSize;
 uint32_t Diff;
+uint8_t *pShmSlot;
 
 pServReq = (sBKSServReq *)m_BKSConnection.TxdRxd.pRxdBuff;
 
 if(m_BKSConnection.TxdRxd.flgRxCplt == 0 || pServReq->Hdr.FrameType != eBKSHdrReq)
 	return(0);
 
-	// can't handle if all service instances are already committed to processing previous requests
-if (m_BKSConnection.InstancesBusy >= m_BKSConnection.NumInstances)
+	// request payload may be in place in the requester's shared memory slot, slot is identified by the requester's instance in JobIDEx bits 41..49
+pShmSlot = NULL;
+if(pServReq->Hdr.FrameFlags & cBKSFrameFlgShmSlot)
+	{
+	if(m_BKSConnection.TxdRxd.flgShmActv && m_BKSConnection.TxdRxd.pShm != NULL &&
+		((uint64_t)pServReq->ParamSize + pServReq->DataSize) <= m_BKSConnection.TxdRxd.pShm->SlotSize())
+		pShmSlot = m_BKSConnection.TxdRxd.pShm->Slot((uint32_t)((pServReq->JobIDEx >> 41) & 0x01ff));
+	}
+
+	// can't handle if all service instances are already committed to processing previous requests, or if the request payload can't be located
+if (m_BKSConnection.InstancesBusy >= m_BKSConnection.NumInstances || ((pServReq->Hdr.FrameFlags & cBKSFrameFlgShmSlot) && pShmSlot == NULL))
 	{
 		// let requester know all service instances are committed - no room at the Inn 
 	TxFrameSize = sizeof(sBKSServResp);
@@ -1004,10 +1063,19 @@ else  // not all service instances are committed so can accept this request
 			pInstance->ClassMethodID = pServReq->ClassMethodID;
 			pInstance->ParamSize = pServReq->ParamSize;
 			pInstance->InDataSize = pServReq->DataSize;
-			if ((pServReq->DataSize + pServReq->ParamSize) > 0)
-				memcpy(pInstance->Data, pServReq->ParamData, pServReq->DataSize + pServReq->ParamSize);
+			if(pShmSlot != NULL)				// payload is read in place from the requester's slot, and response will be written back into that slot
+				{
+				pInstance->flgShmSlot = 1;
+				pInstance->pData = pShmSlot;
+				}
 			else
-				pInstance->Data[0] = 0;
+				{
+				pInstance->pData = pInstance->Data;
+				if ((pServReq->DataSize + pServReq->ParamSize) > 0)
+					memcpy(pInstance->Data, pServReq->ParamData, pServReq->DataSize + pServReq->ParamSize);
+				else
+					pInstance->Data[0] = 0;
+				}
 			pInstance->flgReqAvail = 1;
 			m_BKSConnection.InstancesReqAvail += 1;
 			m_BKSConnection.InstancesBusy += 1;
@@ -1062,7 +1130,9 @@ if(m_BKSConnection.InstancesCpltd > 0)
 			if((TxFrameID - m_BKSConnection.TxdRxd.RxdRxFrameID) > 4)
 				break;
 
-			TxFrameSize = sizeof(sBKSServResp) - 1 + pInstance->OutDataSize;
+			TxFrameSize = sizeof(sBKSServResp) - 1;
+			if(!pInstance->flgShmSlot)				// response already in place in requester's shared memory slot, otherwise response follows header
+				TxFrameSize += pInstance->OutDataSize;
 			if((m_BKSConnection.TxdRxd.AllocdTxdBuff - m_BKSConnection.TxdRxd.TotTxd) < TxFrameSize)
 				break;
 			pServResp = (sBKSServResp *)&m_BKSConnection.TxdRxd.pTxdBuff[m_BKSConnection.TxdRxd.TotTxd];
@@ -1071,10 +1141,10 @@ if(m_BKSConnection.InstancesCpltd > 0)
 			pServResp->ClassMethodID = pInstance->ClassMethodID;
 			pServResp->JobRslt = pInstance->JobRslt;
 			pServResp->DataSize = pInstance->OutDataSize;
-			if (pInstance->OutDataSize > 0)
+			if (!pInstance->flgShmSlot && pInstance->OutDataSize > 0)
 				memcpy(pServResp->Data, pInstance->Data, pInstance->OutDataSize);
 			pServResp->Hdr.FrameLen = TxFrameSize;
-			pServResp->Hdr.FrameFlags = 0;
+			pServResp->Hdr.FrameFlags = pInstance->flgShmSlot ? cBKSFrameFlgShmSlot : 0;
 			pServResp->Hdr.SessionID = m_BKSConnection.TxdRxd.SessionID;
 			pServResp->Hdr.FrameType = eBKSHdrResp;
 			pServResp->Hdr.RxFrameID = m_BKSConnection.TxdRxd.RxdTxFrameID;
@@ -1613,6 +1683,7 @@ return(true);
 }
 
 
+#ifdef WIN32
 // Set up the three FD sets used with select() with the sockets to be monitored for events
 // returns:
 // 0 if no sockets to be monitored
@@ -1670,6 +1741,54 @@ if (pTxdRxd->Socket != -1 &&
 	}
 return(HiFDs);
 }
+#else
+// On linux the connection and control sockets are monitored with edge triggered epoll, readiness is retained in the
+// sockets tsTxdRxd flags until RxData()/TxData()/RcvCtrl() find that a socket operation would block
+bool
+CBKSProvider::EpollAdd(tsTxdRxd *pTxdRxd)		// start edge triggered monitoring of this socket
+{
+struct epoll_event Event;
+if(m_hEpoll == -1 || pTxdRxd == NULL || pTxdRxd->Socket == -1)
+	return(false);
+memset(&Event,0,sizeof(Event));
+Event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+Event.data.ptr = pTxdRxd;
+return(epoll_ctl(m_hEpoll,EPOLL_CTL_ADD,pTxdRxd->Socket,&Event) == 0 ? true : false);
+}
+
+void
+CBKSProvider::EpollEvents(int NumEvents,		// apply this many events
+					struct epoll_event *pEvents)	// returned by epoll_wait() as sticky readiness flags
+{
+tsTxdRxd *pTxdRxd;
+for(; NumEvents > 0; NumEvents--, pEvents++)
+	{
+	pTxdRxd = (tsTxdRxd *)pEvents->data.ptr;
+	if(pEvents->events & EPOLLERR)
+		pTxdRxd->flgEvExcept = 1;
+	if(pEvents->events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP))	// a hangup is read ready, recv() will then return the closure
+		pTxdRxd->flgEvRead = 1;
+	if(pEvents->events & EPOLLOUT)
+		pTxdRxd->flgEvWrite = 1;
+	if(pTxdRxd->flgShmActv && (pEvents->events & EPOLLIN))	// doorbell could be peer notifying that space is now available in a previously full ring
+		pTxdRxd->flgEvWrite = 1;
+	}
+}
+
+bool					// true if any monitored socket has readiness which can be actioned without waiting on epoll_wait()
+CBKSProvider::EpollPending(void)
+{
+tsTxdRxd *pTxdRxd;
+pTxdRxd = &m_Ctrl[1];
+if(pTxdRxd->Socket != -1 && pTxdRxd->flgErr == 0 && pTxdRxd->flgSelMonRead && pTxdRxd->flgEvRead)
+	return(true);
+pTxdRxd = &m_BKSConnection.TxdRxd;
+if(pTxdRxd->Socket != -1 &&
+	(pTxdRxd->flgEvExcept || (pTxdRxd->flgSelMonRead && pTxdRxd->flgEvRead) || (pTxdRxd->flgSelMonWrite && pTxdRxd->flgEvWrite)))
+	return(true);
+return(false);
+}
+#endif
 
 bool
 CBKSProvider::RxData(tsTxdRxd *pRxd)					// receiving session data
@@ -1775,7 +1894,12 @@ if ((ExpRxdLen + pRxd->TotRxd) > pRxd->AllocdRxdBuff)
 	}
 
 	// now try receiving ...
-RxdLen = recv(pRxd->Socket, (char *)&pRxd->pRxdBuff[pRxd->TotRxd], ExpRxdLen, 0);
+#ifndef WIN32
+if(pRxd->flgShmActv == 1)		// co-located peer, frame bytes are read from shared memory with socket only carrying doorbells
+	RxdLen = pRxd->pShm->Recv(pRxd->Socket, &pRxd->pRxdBuff[pRxd->TotRxd], ExpRxdLen);
+else
+#endif
+	RxdLen = recv(pRxd->Socket, (char *)&pRxd->pRxdBuff[pRxd->TotRxd], ExpRxdLen, 0);
 if (RxdLen == 0)	// 0 if socket was closed by peer
 	{
 	pRxd->flgErr = 1;
@@ -1798,7 +1922,11 @@ if (RxdLen == -1)
 #else
 	err = errno;
 	if (err == EWOULDBLOCK || err == EAGAIN || err == EINTR)
+		{
+		if(err != EINTR)			// socket has been drained, epoll will report when more data becomes available
+			pRxd->flgEvRead = 0;
 		return(true);
+		}
 #endif
 	pRxd->flgErr = 1;
 	pRxd->flgErrReason = 7;      // general socket error 
@@ -1807,6 +1935,8 @@ if (RxdLen == -1)
 	}
 
 	// received at least 1 byte, can now be characterised as being a complete frame?
+if((uint32_t)RxdLen < ExpRxdLen)	// short recv() also means socket has been drained
+	pRxd->flgEvRead = 0;
 pRxd->TotRxd += RxdLen;
 if (pRxd->TotRxd >= sizeof(tsBKSPacHdr))
 	{
@@ -1893,7 +2023,12 @@ CBKSProvider::TxData(tsTxdRxd *pTxd)
 	}
 	pTxd->flgTxCplt = 0;
 	ReqTxLen = pTxd->TotTxd - pTxd->CurTxd;
-	ActTxLen = send(pTxd->Socket, (char *)&pTxd->pTxdBuff[pTxd->CurTxd], ReqTxLen, 0);
+#ifndef WIN32
+	if(pTxd->flgShmActv == 1)		// co-located peer, frame bytes are written into shared memory and peer doorbelled
+		ActTxLen = pTxd->pShm->Send(pTxd->Socket, &pTxd->pTxdBuff[pTxd->CurTxd], ReqTxLen);
+	else
+#endif
+		ActTxLen = send(pTxd->Socket, (char *)&pTxd->pTxdBuff[pTxd->CurTxd], ReqTxLen, 0);
 
 #ifdef WIN32
 	if (ActTxLen == SOCKET_ERROR)
@@ -1914,6 +2049,8 @@ CBKSProvider::TxData(tsTxdRxd *pTxd)
 		if (err == EWOULDBLOCK || err == EAGAIN || err == EINTR)
 			{
 			pTxd->flgSelMonWrite = 1;
+			if(err != EINTR)
+				pTxd->flgEvWrite = 0;
 			return(true);
 			}
 #endif
@@ -1924,7 +2061,7 @@ CBKSProvider::TxData(tsTxdRxd *pTxd)
 	}
 
 	pTxd->CurTxd += ActTxLen;
-	if (pTxd->CurTxd == ReqTxLen)
+	if (pTxd->CurTxd == pTxd->TotTxd)
 		{
 		pTxd->PacTxdAtSecs = time(NULL);
 		pTxd->flgTxCplt = 1;
@@ -1932,7 +2069,11 @@ CBKSProvider::TxData(tsTxdRxd *pTxd)
 		pTxd->TotTxd = 0;
 		}
 	else
+		{
 		pTxd->flgSelMonWrite = 1;
+		if(ActTxLen < ReqTxLen)
+			pTxd->flgEvWrite = 0;		// short send, socket buffer is full and epoll will report when writeable
+		}
 	return true;
 }
 
@@ -2022,7 +2163,10 @@ if (RxdLen == -1)
 #else
 	err = errno;
 	if (err == EWOULDBLOCK || err == EAGAIN || err == EINTR)
+		{
+		pCtrl->flgEvRead = 0;
 		return(0);
+		}
 #endif
 	pCtrl->flgErr = 1;
 	pCtrl->flgErrReason = 7;      // general socket error 
@@ -2161,6 +2305,19 @@ pCtrl->TotTxd = 0;
 return(true);
 }
 
+// socket events as reported by select() on windows, or as sticky epoll readiness flags on linux
+#ifdef WIN32
+#define SockEvExcept(pTxdRxd) FD_ISSET((pTxdRxd)->Socket, &ExceptFDs)
+#define SockEvRead(pTxdRxd) FD_ISSET((pTxdRxd)->Socket, &ReadFDs)
+#define SockEvWrite(pTxdRxd) FD_ISSET((pTxdRxd)->Socket, &WriteFDs)
+#define SockEvClr(Socket,FDs) FD_CLR(Socket, &FDs)
+#else
+#define SockEvExcept(pTxdRxd) ((pTxdRxd)->flgEvExcept == 1)
+#define SockEvRead(pTxdRxd) ((pTxdRxd)->flgSelMonRead == 1 && (pTxdRxd)->flgEvRead == 1)
+#define SockEvWrite(pTxdRxd) ((pTxdRxd)->flgSelMonWrite == 1 && (pTxdRxd)->flgEvWrite == 1)
+#define SockEvClr(Socket,FDs)
+#endif
+
 int				// 1 if timed out attempting to connect to server, 0 if terminated because requested to terminate, -1 if socket level errors
 CBKSProvider::ConnectServer(int MaxConnWait,			// wait for at most this many minutes for connection
 							const char* pszHost,		// connect to this server host/IP address; NULL to use first INET IP local to this machine
@@ -2168,15 +2325,22 @@ CBKSProvider::ConnectServer(int MaxConnWait,			// wait for at most this many min
 {
 int SelectRslt;
 uint32_t NumPendCpltd;
+#ifdef WIN32
 int HiFDs;
+#endif
 bool bRxDataRslt;
 uint32_t Diff;
 time_t CurTimeSecs;
 time_t Then;
 tsBKSType *pType;
-struct timeval SelectTimeout;
 teBKSPProvState PrevBKSPState;
+#ifdef WIN32
+struct timeval SelectTimeout;
 fd_set ReadFDs, WriteFDs, ExceptFDs;
+#else
+int EpollTimeout;
+struct epoll_event EpollEvs[4];
+#endif
 
 AcquireLock(true);
 TerminateConnection(true,false,false);
@@ -2212,6 +2376,16 @@ gDiagnostics.DiagOut(eDLInfo, gszProcName, "ConnectServer: Service control socke
 m_Ctrl[1].flgSelMonExcept = 1;
 m_Ctrl[1].flgSelMonRead = 1;
 
+#ifndef WIN32
+if((m_hEpoll = epoll_create1(EPOLL_CLOEXEC)) == -1 || !EpollAdd(&m_BKSConnection.TxdRxd) || !EpollAdd(&m_Ctrl[1]))
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "ConnectServer: unable to initialise epoll monitoring, error %d", errno);
+	ReleaseLock(true);
+	TerminateConnection(true, true, true);
+	return(-1);
+	}
+#endif
+
 PrevBKSPState = eBKSPSUndefined;
 while (!m_bTermConnectionReq)		// keep processing for rxd/txd data over connection until connection is terminated
 	{
@@ -2280,6 +2454,7 @@ while (!m_bTermConnectionReq)		// keep processing for rxd/txd data over connecti
 	while(NumPendCpltd != 0);
 
 	AcquireLock(true);
+#ifdef WIN32
 	SelectTimeout.tv_sec = 5;
 	SelectTimeout.tv_usec = 0;
 	HiFDs = SetupFDSets(ReadFDs, WriteFDs, ExceptFDs);
@@ -2288,10 +2463,29 @@ while (!m_bTermConnectionReq)		// keep processing for rxd/txd data over connecti
 	AcquireLock(true);
 	if (SelectRslt == 0)			// 0 if timed out with no socket events occurring
 		continue;
+#else
+		// if sockets still have readiness which was not fully actioned in the previous iteration then only poll for additional events
+	EpollTimeout = EpollPending() ? 0 : 5000;
+	ReleaseLock(true);	
+	SelectRslt = epoll_wait(m_hEpoll, EpollEvs, 4, EpollTimeout);
+	AcquireLock(true);
+	if(SelectRslt == -1 && errno == EINTR)
+		SelectRslt = 0;
+	if(SelectRslt >= 0)
+		{
+		EpollEvents(SelectRslt, EpollEvs);
+		if(!EpollPending())			// timed out with no actionable socket events
+			continue;
+		}
+#endif
 
 	if(SelectRslt < 0)				// the select() call has failed? 
 		{
+#ifdef WIN32
 		gDiagnostics.DiagOut(eDLFatal, gszProcName, "AcceptConnections: select() failed, terminating session");
+#else
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "AcceptConnections: epoll_wait() failed, error %d, terminating session", errno);
+#endif
 		m_BKSConnection.BKSPState = eBKSPSAcceptedServiceTerm;
 		ReleaseLock(true);
 		gDiagnostics.DiagOut(eDLFatal, gszProcName, "AcceptConnections: terminating worker threads");
@@ -2322,15 +2516,15 @@ while (!m_bTermConnectionReq)		// keep processing for rxd/txd data over connecti
 
 	// no connection errors
 
-	if (m_Ctrl[1].flgSelMonRead && FD_ISSET(m_Ctrl[1].Socket, &ReadFDs))
+	if (m_Ctrl[1].flgSelMonRead && SockEvRead(&m_Ctrl[1]))
 		{
-		FD_CLR(m_Ctrl[1].Socket, &ReadFDs);
+		SockEvClr(m_Ctrl[1].Socket, ReadFDs);
 		while (1)
 			{     
 			int CtrlMsgLen;
 			uint8_t CtrlMsg[256];
 																																												\
-			if((CtrlMsgLen = RcvCtrl(sizeof(CtrlMsg),CtrlMsg))==0)
+			if((CtrlMsgLen = RcvCtrl(sizeof(CtrlMsg),CtrlMsg))<=0)
 				break;
 
 				// handle this received control payload packet
@@ -2342,7 +2536,7 @@ while (!m_bTermConnectionReq)		// keep processing for rxd/txd data over connecti
 	if(m_BKSConnection.TxdRxd.flgSelMonExcept || m_BKSConnection.TxdRxd.flgSelMonRead || m_BKSConnection.TxdRxd.flgSelMonWrite)
 		{
 			// if an exception on the connected socket then terminate connection
-		if (m_BKSConnection.TxdRxd.flgSelMonExcept && FD_ISSET(m_BKSConnection.TxdRxd.Socket, &ExceptFDs))
+		if (m_BKSConnection.TxdRxd.flgSelMonExcept && SockEvExcept(&m_BKSConnection.TxdRxd))
 			{
 			gDiagnostics.DiagOut(eDLFatal, gszProcName, "AcceptConnections: socket errors, terminating session");
 			m_BKSConnection.BKSPState = eBKSPSAcceptedServiceTerm;
@@ -2354,9 +2548,9 @@ while (!m_bTermConnectionReq)		// keep processing for rxd/txd data over connecti
 			return(-1);
 			}
 
-		if (m_BKSConnection.TxdRxd.flgSelMonRead && FD_ISSET(m_BKSConnection.TxdRxd.Socket, &ReadFDs))
+		if (m_BKSConnection.TxdRxd.flgSelMonRead && SockEvRead(&m_BKSConnection.TxdRxd))
 			{
-			FD_CLR(m_BKSConnection.TxdRxd.Socket, &ReadFDs);
+			SockEvClr(m_BKSConnection.TxdRxd.Socket, ReadFDs);
 			bRxDataRslt = false;
 			while((bRxDataRslt = RxData(&m_BKSConnection.TxdRxd))==true)    // get rxd data
 				{
@@ -2423,7 +2617,7 @@ while (!m_bTermConnectionReq)		// keep processing for rxd/txd data over connecti
 				}
 
 			}
-		if ((m_BKSConnection.TxdRxd.flgSelMonWrite) && FD_ISSET(m_BKSConnection.TxdRxd.Socket, &WriteFDs))
+		if ((m_BKSConnection.TxdRxd.flgSelMonWrite) && SockEvWrite(&m_BKSConnection.TxdRxd))
 			{
 			if (!TxData(&m_BKSConnection.TxdRxd))
 				{
@@ -2437,7 +2631,7 @@ while (!m_bTermConnectionReq)		// keep processing for rxd/txd data over connecti
 				return(-1);
 				}
 
-			FD_CLR(m_BKSConnection.TxdRxd.Socket, &WriteFDs);
+			SockEvClr(m_BKSConnection.TxdRxd.Socket, WriteFDs);
 			if (m_BKSConnection.TxdRxd.flgTxCplt)
 				{
 				if(m_BKSConnection.BKSPState <= eBKSPSWaitAcceptService)
@@ -2502,10 +2696,6 @@ for(ThreadIdx = 0; ThreadIdx < NumInstances; ThreadIdx++,pThreadPar++)
 #else
 	pThreadPar->threadID = 0;
 #endif
-	if((pThreadPar->pReqData = (uint8_t *)malloc(cMaxReqDataSize))==NULL)
-		break;
-	if((pThreadPar->pParamData = (uint8_t *)malloc(cMaxReqParamSize))==NULL)
-		break;
 	if((pThreadPar->pRespData = (uint8_t *)malloc(cMaxRespDataSize))==NULL)
 		break;
 	if((pThreadPar->pszBuffer = (char *)malloc(cMaxMFABuffSize))==NULL)
@@ -2516,10 +2706,6 @@ if(ThreadIdx != NumInstances)
 	pThreadPar = m_WorkerInstances;
 	for(Idx = 0; Idx <= ThreadIdx; Idx++,pThreadPar++)
 		{
-		if(pThreadPar->pReqData != NULL)
-			free(pThreadPar->pReqData);	
-		if(pThreadPar->pParamData != NULL)
-			free(pThreadPar->pParamData);	
 		if(pThreadPar->pRespData != NULL)
 			free(pThreadPar->pRespData);	
 		if(pThreadPar->pszBuffer != NULL)
@@ -2646,10 +2832,6 @@ for(Idx = 0; Idx < StartedInstances; Idx++, pThreadPar += 1)
 pThreadPar = m_WorkerInstances;
 for(Idx = 0; Idx < StartedInstances; Idx++, pThreadPar += 1)
 	{
-	if(pThreadPar->pReqData != NULL)
-		free(pThreadPar->pReqData);
-	if(pThreadPar->pParamData != NULL)
-		free(pThreadPar->pParamData);
 	if(pThreadPar->pRespData != NULL)
 		free(pThreadPar->pRespData);
 	if(pThreadPar->pszBuffer != NULL)
@@ -2917,7 +3099,7 @@ while(JobRslt >= 0)
 		}
 	MaxParamSize = cMaxReqParamSize;
 	MaxRequestData = cMaxReqDataSize;
-	if((JobRslt = GetJobToProcess(&InstanceID,&ClassInstanceID,&ClassMethodID, &MaxParamSize,pThreadPar->pParamData,&MaxRequestData,pThreadPar->pReqData)) > 0)
+	if((JobRslt = GetJobToProcess(&InstanceID,&ClassInstanceID,&ClassMethodID, &MaxParamSize,&pThreadPar->pParamData,&MaxRequestData,&pThreadPar->pReqData)) > 0)
 		{
 		switch((teSWMethod)ClassMethodID) {
 			case eSWMConstruct:				// instantiate new class instance
@@ -3132,6 +3314,82 @@ while(JobRslt >= 0)
 				JobRslt = JobResponse(InstanceID,ClassInstanceID, (uint32_t)iRslt,RespDataOfs, pThreadPar->pRespData);
 				break;
 
+			case eSWMCombinedTargAligns:				// batched eSWMCombinedTargAlign, returns number of targets processed and the alignment results for each of those targets
+				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
+					{
+					uint32_t NumTargs;				// request contains this many targets
+					uint64_t ReqCoverage;			// stop processing targets once accumulated coverage reaches this, 0 if no limit
+					uint64_t CurCoverage;			// coverage accumulated by requester prior to this request
+					int ProbeLen;					// if > 0 then set probe sequence of this length before processing targets
+					etSeqBase *pProbeSeq;			// probe sequence
+					uint32_t TargIdx;
+					tsCombinedTargAlignRet *pAlignRets;
+					ReqDataOfs = UnmarshalReq(sizeof(uint32_t),pThreadPar->pReqData,&NumTargs);
+					ReqDataOfs += UnmarshalReq(sizeof(uint64_t),&pThreadPar->pReqData[ReqDataOfs],&ReqCoverage);
+					ReqDataOfs += UnmarshalReq(sizeof(uint64_t),&pThreadPar->pReqData[ReqDataOfs],&CurCoverage);
+					ReqDataOfs += UnmarshalReq(sizeof(int32_t),&pThreadPar->pReqData[ReqDataOfs],&ProbeLen);
+					iRslt = 0;
+					if(NumTargs == 0 || ((NumTargs * sizeof(tsCombinedTargAlignRet)) + 100) > cMaxRespDataSize)
+						iRslt = -1;
+					else
+						{
+						if(ProbeLen > 0)
+							{
+							ReqDataOfs += UnmarshalReq(ProbeLen,&pThreadPar->pReqData[ReqDataOfs],&pProbeSeq);
+							if(!pClassInstance->pClass->SetProbe(ProbeLen,pProbeSeq))
+								iRslt = -1;
+							}
+						}
+					if(iRslt == 0)
+						{
+						// alignment results are assembled immediately following the marshalling type and length
+						pAlignRets = (tsCombinedTargAlignRet *)&pThreadPar->pRespData[sizeof(uint32_t) + 1];
+						for(TargIdx = 0; TargIdx < NumTargs; TargIdx++)
+							{
+							tsCombinedTargAlignRet *pAlignRet;
+							if(ReqCoverage > 0 && CurCoverage >= ReqCoverage)	// requester would not have processed any more targets
+								break;
+							ReqDataOfs += UnmarshalReq(sizeof(tsCombinedTargAlignPars),&pThreadPar->pReqData[ReqDataOfs],&pCombinedTargAlignPars);
+							ReqDataOfs += UnmarshalReq(pCombinedTargAlignPars->TargSeqLen,&pThreadPar->pReqData[ReqDataOfs],&pTargSeq);
+							pCombinedTargAlignPars->pTargSeq = pTargSeq;
+							pAlignRet = &pAlignRets[TargIdx];
+							memset(pAlignRet,0,sizeof(tsCombinedTargAlignRet));
+#ifdef WIN32
+							InterlockedIncrement(&m_NumSWAlignReqs);
+#else
+							__sync_fetch_and_add(&m_NumSWAlignReqs,1);
+#endif
+							pClassInstance->pClass->CombinedTargAlign(pCombinedTargAlignPars,pAlignRet);
+							if(pAlignRet->ErrRslt != eBSFSuccess || pAlignRet->ProcPhase < 2 || pAlignRet->ProcPhase == 3)	// requester will be terminating processing of the current probe
+								{
+								TargIdx += 1;
+								break;
+								}
+							if(pAlignRet->ProcPhase == 4 && pAlignRet->Flags & 0x08)	// accepted as a multialignment so accumulate coverage as requester does
+								{
+								uint64_t OvlpLen = (uint64_t)(pAlignRet->ProbeAlignLength + pAlignRet->TargAlignLength + 1) / 2;
+								if(pCombinedTargAlignPars->TargFlags & 0x80)
+									CurCoverage += OvlpLen * 3 / 2;
+								else
+									CurCoverage += OvlpLen;
+								}
+							}
+						iRslt = (int)TargIdx;
+						}
+					}
+				else
+					iRslt = -1;
+				if(iRslt > 0)
+					{
+					pThreadPar->pRespData[0] = (uint8_t)eRMIPTVarUint8;
+					*(uint32_t *)&pThreadPar->pRespData[1] = iRslt * sizeof(tsCombinedTargAlignRet);
+					RespDataOfs = sizeof(uint32_t) + 1 + (iRslt * sizeof(tsCombinedTargAlignRet));
+					}
+				else
+					RespDataOfs = 0;
+				JobRslt = JobResponse(InstanceID,ClassInstanceID, (uint32_t)iRslt,RespDataOfs, pThreadPar->pRespData);
+				break;
+
 
 			case eSWMClassifyPath:			// ClassifyPath
 				if((pClassInstance = LocateClassInstance(ClassInstanceID))!=NULL)
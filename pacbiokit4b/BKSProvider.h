@@ -2,13 +2,13 @@
 
 #include "BKScommon.h"
 
-const uint32_t cServiceProviderVersion = 1;			// service provider is at this version
+const uint32_t cServiceProviderVersion = 3;			// service provider is at this version (version 2 added batched SW alignment requests, version 3 shared memory transport)
 const uint32_t cMaxServiceProviderInsts = cMaxServiceInsts;	    // limited to support a maximum of this many service instances
 // when negotiating with potential service requesters then minimal buffer tx/rx buffer sizes are allocated
 const int cMinTxRxBuffSize = (cMaxServiceTypes * sizeof(tsServiceDetail)) + sizeof(tsBKSReqServices) * 3;	// always allocate at least this sized TxdBuff/RxdBuffs - ensures negotiation frames fit!
 
-const int cMaxReqDataSize =  cMaxSWReqPayloadSize;		// each worker thread allocates to process up to this much request data
-const int cMaxReqParamSize = cMaxSWParamLen;			// each worker thread allocates to process up to this much parameterisation data
+const int cMaxReqDataSize =  cMaxSWReqPayloadSize;		// each worker thread accepts up to this much request data
+const int cMaxReqParamSize = cMaxSWParamLen;			// each worker thread accepts up to this much parameterisation data
 const int cMaxRespDataSize = cMaxSWRespPayloadSize;		// each worker thread allocates to return up to this much response data
 const int cMaxMFABuffSize =  cMaxSWMAFBuffSize;			// each worker thread allocates to hold at most this sized MAlignCols2fasta/MAlignCols2MFA alignments plus row descriptor prefixes
 
@@ -24,6 +24,8 @@ typedef enum TAG_eBKSPProvState
 	eBKSPSPlaceHolder
 } teBKSPProvState;
 
+class CBKSShm;
+
 #pragma pack(1)
 typedef struct TAG_sTxdRxd
 {
@@ -36,7 +38,12 @@ typedef struct TAG_sTxdRxd
 	uint16_t flgTxCplt : 1;	// set when complete frame sent
 	uint16_t flgErr : 1;       // set on any unrecoverable error
 	uint16_t flgErrReason : 4;	// holds reason for socket level error flag set
+	uint16_t flgEvRead : 1;	// linux epoll: socket reported as readable and not since drained (edge triggered so sticky until recv() would block)
+	uint16_t flgEvWrite : 1;	// linux epoll: socket reported as writeable and not since filled (sticky until send() would block)
+	uint16_t flgEvExcept : 1;	// linux epoll: socket reported an error or hangup condition
+	uint16_t flgShmActv : 1;	// frames are exchanged through shared memory rings in pShm, socket only carries doorbells
 	socket_t  Socket;		// assumed connected socket
+	CBKSShm *pShm;			// shared memory transport with co-located peer, NULL if frames exchanged over Socket
 	time_t PacRxdAtSecs;	// the time at which a frame was last received, used for determining if session still active
 	time_t PacTxdAtSecs;	// the time at which a frame was last sent, used for keep alive generation
 
@@ -63,10 +70,12 @@ typedef struct TAG_sReqResp {
 	uint32_t flgReqAvail : 1;				// this service instance is available for processing 
 	uint32_t flgProc: 1;					// this service instance is currently being processed
 	uint32_t flgCpltd: 1;					// service processing has completed and resultset can be sent back to service requester
+	uint32_t flgShmSlot: 1;				// request and response payloads are in place in the requester's shared memory slot ptd to by pData
 	uint32_t JobRslt;						// completion result
 	uint32_t ParamSize;					// instance specific parameter size
 	uint32_t InDataSize;					// instance specific input data size
 	uint32_t OutDataSize;					// instance specific result data size
+	uint8_t *pData;						// pts to Data, or if flgShmSlot then to the requester's shared memory slot
 	uint8_t Data[1];						// when service requested then parameters followed by input data, if service response then response result data
 } tsReqResp;
 
@@ -129,8 +138,8 @@ typedef struct TAG_sWorkerInstance {
 	pthread_t threadID;				// identifier as set by pthread_create ()
 #endif
 	int Rslt;						// processing result
-	uint8_t *pReqData;				// malloc'd (cMaxReqDataSize) to hold request data
-	uint8_t *pParamData;              // malloc'd (cMaxReqParamSize) to hold any paramertisations
+	uint8_t *pReqData;				// pts to request data in place in the service instance, valid until JobResponse()
+	uint8_t *pParamData;              // pts to any paramertisations in place in the service instance, valid until JobResponse()
 	uint8_t *pRespData;               // malloc'd (cMaxRespDataSize) to hold response data
 	char *pszBuffer;                // malloc'd )(cMaxMFABuffSize) to hold any textual alignment sequences
 } tsWorkerInstance;
@@ -178,6 +187,9 @@ class CBKSProvider
 	tsClassInstance m_ClassInstances[cMaxClassInsts];		// all possible class instances
 
 	tsTxdRxd m_Ctrl[2];									// Ctrl[0] written to by threads needing to signal select() processing thread, select() processing thread monitors m_Ctrl[1]
+#ifndef _WIN32
+	int m_hEpoll;										// linux: epoll instance monitoring the server connection and control sockets; -1 if not created
+#endif
 
 	teBSFrsltCodes										// cBSFSuccess if no errors and registration process is continued, cBSFSocketErr if any errors and connection has been terminated, eBSFerrMem if unable to allocate memory
 		ProcessSessEstab(bool bCpltdWrite);				// false if frame received, true if frame sent
@@ -238,10 +250,17 @@ class CBKSProvider
 	bool ShutdownConnection(socket_t *pSocket);
 
 
+#ifdef _WIN32
 	int			// returns 0 if no sockets to be monitored with select(), on windows the total number of monitored sockets, on linux the highest socket file descriptor plus 1
 		SetupFDSets(fd_set& ReadFDs,			// select() read available socket descriptor set  
 					fd_set& WriteFDs,			// select() write accepted socket descriptor set
 					fd_set& ExceptFDs);			// select() exceptions descriptor set
+#else
+	bool EpollAdd(tsTxdRxd *pTxdRxd);			// start edge triggered monitoring of this socket, events are returned as sticky readiness flags in pTxdRxd
+	void EpollEvents(int NumEvents,				// apply this many events
+					struct epoll_event *pEvents);	// returned by epoll_wait() as sticky readiness flags
+	bool EpollPending(void);					// true if any monitored socket has readiness which can be actioned without waiting on epoll_wait()
+#endif
 #ifdef WIN32
 	const char *WSAGetLastErrorMessage(const char* pcMessagePrefix,int nErrorID = 0);
 #endif
@@ -315,9 +334,9 @@ public:
 						uint64_t *pClassInstanceID,	// returned class instance to apply job to
 						uint32_t *pClassMethodID,		// returned class method to apply on class instance
 					    uint32_t *pMaxParamsSize,		// on input, max sized parameter block accepted, on return then the actual size of the parameter block
-						uint8_t *pParams,				// returned parameter block
+						uint8_t **ppParams,				// returned ptr to parameter block, valid until JobResponse()
 						uint32_t *pMaxRequestData,	// on input the max sized request data block accepted, on return the actual size of the request data block
-						uint8_t *pRequestData);		// returned request data block
+						uint8_t **ppRequestData);		// returned ptr to request data block, valid until JobResponse()
 
 
 	int			// 0 if response accepted, -1 if job does not exist or parameterisation errors, -3 if session terminating 
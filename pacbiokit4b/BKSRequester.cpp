@@ -25,12 +25,12 @@ Original 'BioKanga' copyright notice has been retained and is as follows.
 #include "stdafx.h"
 
 // Supporting at most this many concurrent TCP sessions between service requester (this server) and all service providers
-// this could be increased to an internally restricted maximum of 511 but there could then be a significant performance throughput degradation
-// because of the use of select() instead of ePoll or derivatives.
+// On windows this could be increased to an internally restricted maximum of 511 but there could then be a significant performance throughput degradation
+// because of the use of select(), on linux sessions are multiplexed with edge triggered epoll and up to 500 sessions are supported.
 #ifdef WIN32
 #define cMaxConcurrentSessions 100
 #else
-#define cMaxConcurrentSessions 100
+#define cMaxConcurrentSessions 500
 #endif
 
 #ifdef HAVE_CONFIG_H
@@ -54,12 +54,14 @@ Original 'BioKanga' copyright notice has been retained and is as follows.
 #include <pthread.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <netdb.h>
 typedef struct sockaddr_storage SOCKADDR_STORAGE;
 #include "../libkit4b/commhdrs.h"
 #endif
 
 #include "./BKScommon.h"
+#include "./BKSShm.h"
 #include "./BKSRequester.h"
 const char * cDfltListenerPort = "43123";		// default server port to listen on if not user specified
 
@@ -108,6 +110,8 @@ m_ListenerSock = INVALID_SOCKET;
 m_Ctrl[0].Socket = -1;
 m_Ctrl[1].Socket = -1;
 m_ListenerSock = -1;
+m_hEpoll = -1;
+m_bListenerRdy = false;
 #endif
 }
 
@@ -488,6 +492,8 @@ for (SessionID = 1; SessionID <= cMaxConcurrentSessions; SessionID += 32, pVect
 		SessionID += 1;
 		Msk <<= 1;
 		}
+	if(SessionID > cMaxConcurrentSessions)		// last vector word may be only partially used
+		return(0);
 	*pByte |= Msk;
 	return(SessionID);
 	}
@@ -522,6 +528,18 @@ return(*pVect & Msk ? true : false);
 }
 
 
+// payloads are in the requester's instance slot of the shared memory arena if session is using the shared memory transport, otherwise following the instance header
+uint8_t *
+CBKSRequester::InstanceData(tsBKSRegSessionEx *pSession,	// session containing
+						 uint32_t InstanceID,				// this service instance (1..MaxInstances)
+						 tsReqRespInst *pReqRespInst)		// with this request/response instance
+{
+uint8_t *pSlot;
+if(pSession->TxdRxd.flgShmActv && pSession->TxdRxd.pShm != NULL && (pSlot = pSession->TxdRxd.pShm->Slot(InstanceID)) != NULL)
+	return(pSlot);
+return(pReqRespInst->Data);
+}
+
 tJobIDEx										// packed job identifier or 0 if range errors
 CBKSRequester::PackIntoJobIDEx(uint32_t ReqID,	// must be in the range 1..16777215 (24bits)
 				uint32_t SessionID,				// service provider session identifier, must be in the range 1..511 (9bits)
@@ -713,6 +731,7 @@ uint32_t JobSessionID;
 uint32_t InstanceID;
 uint64_t *pClassIdentifier;
 uint32_t TypeSessionID;
+uint8_t *pData;
 
 // validate parameters
 if(pJobID == NULL || TypeID <= eBKSPTUndefined || TypeID >= eBKSPTPlaceHolder)
@@ -721,7 +740,8 @@ if(pJobID == NULL || TypeID <= eBKSPTUndefined || TypeID >= eBKSPTPlaceHolder)
 pType= &m_pBKSTypes[TypeID -1];
 if(pType->Detail.BKSPType != TypeID ||
    ParamsSize > pType->Detail.MaxParamLen || (ParamsSize > 0 && pParams == NULL) ||
-   InDataSize >  pType->Detail.MaxQuerySeqLen || (InDataSize > 0 && pInData == NULL))
+   (InDataSize > 0 && pInData == NULL) ||
+   ((uint64_t)sizeof(sBKSServReq) - 1 + ParamsSize + InDataSize) > pType->Detail.MaxReqPayloadSize)	// input data may be a batch of sequences so limit is on the framed request size
 	return(-2);
 
 #ifdef WIN32
@@ -815,7 +835,7 @@ for(InstanceID = 1; InstanceID <= pSession->Session.MaxInstances; InstanceID++)
 	{
 	if(pReqRespInst->ReqID == 0)
 		{	
-		memset(pReqRespInst,0,pType->ReqRespInstSize);
+		memset(pReqRespInst,0,sizeof(tsReqRespInst));			// only the instance header needs clearing, payload is overwritten
 		ReqID = AllocReqID();
 		JobSessionID = pSession->Session.SessionID;
 		TypeSessionID = pSession->Session.TypeSessionID;
@@ -825,10 +845,11 @@ for(InstanceID = 1; InstanceID <= pSession->Session.MaxInstances; InstanceID++)
 		pReqRespInst->ClassMethodID = ClassMethodID;
 		pReqRespInst->ParamSize = ParamsSize;
 		pReqRespInst->InDataSize = InDataSize;
+		pData = InstanceData(pSession,InstanceID,pReqRespInst);		// if shared memory transport then this is the only copy made of the request payload
 		if(ParamsSize > 0)
-			memcpy(pReqRespInst->Data, pParams, ParamsSize);
+			memcpy(pData, pParams, ParamsSize);
 		if(InDataSize > 0)
-			memcpy(&pReqRespInst->Data[ParamsSize], pInData, InDataSize);
+			memcpy(&pData[ParamsSize], pInData, InDataSize);
 		pReqRespInst->FlgReq = 1;
 		pReqRespInst->SubmitAt = (uint32_t)time(NULL);
 		pSession->Session.NumReqs += 1;
@@ -893,11 +914,13 @@ for (Idx = 0; Idx < eBKSPTPlaceHolder-1; Idx++, pType += 1)
 
 			if(pReqRespInst->FlgReq)		// requested to be sent?
 				{
-				FrameLen = sizeof(sBKSServReq) - 1 + pReqRespInst->ParamSize + pReqRespInst->InDataSize;
+				FrameLen = sizeof(sBKSServReq) - 1;
+				if(!pTxdRxd->flgShmActv)				// if shared memory transport then payload is already in place in the instance's slot
+					FrameLen += pReqRespInst->ParamSize + pReqRespInst->InDataSize;
 				if((pTxdRxd->AllocdTxdBuff - pSession->TxdRxd.TotTxd) > (FrameLen + (sizeof(tsBKSPacHdr) * 5))) // always allow spare room for some session control frames
 					{
 					pFrame = (sBKSServReq *)&pTxdRxd->pTxdBuff[pSession->TxdRxd.TotTxd];
-					pFrame->Hdr.FrameFlags = 0;
+					pFrame->Hdr.FrameFlags = pTxdRxd->flgShmActv ? cBKSFrameFlgShmSlot : 0;
 					pFrame->Hdr.FrameLen = FrameLen;
 					pFrame->Hdr.FrameType = eBKSHdrReq;
 					pFrame->Hdr.RxFrameID = pTxdRxd->RxdTxFrameID;
@@ -910,7 +933,7 @@ for (Idx = 0; Idx < eBKSPTPlaceHolder-1; Idx++, pType += 1)
 					pFrame->ClassMethodID = pReqRespInst->ClassMethodID;
 					pFrame->ParamSize = pReqRespInst->ParamSize;
 					pFrame->DataSize = pReqRespInst->InDataSize;
-					if(pReqRespInst->ParamSize > 0 || pReqRespInst->InDataSize > 0)
+					if(!pTxdRxd->flgShmActv && (pReqRespInst->ParamSize > 0 || pReqRespInst->InDataSize > 0))
 						memcpy(pFrame->ParamData,pReqRespInst->Data,pReqRespInst->ParamSize + pReqRespInst->InDataSize);
 					pReqRespInst->FlgReq = 0;
 					pReqRespInst->FlgProc = 1;
@@ -972,6 +995,8 @@ InstanceOfs = pType->ReqRespInstSize * (InstanceID - 1);
 pInstance = (tsReqRespInst *)&pSession->pReqResp[InstanceOfs];
 if(pInstance->JobIDEx != pResponse->JobIDEx || !pInstance->FlgProc)
 	return(-3);
+if((pResponse->Hdr.FrameFlags & cBKSFrameFlgShmSlot) && (!pTxdRxd->flgShmActv || pTxdRxd->pShm == NULL || pResponse->DataSize > pTxdRxd->pShm->SlotSize()))
+	return(-2);
 
 pInstance->CpltdAt = (uint32_t)time(NULL);
 pInstance->JobRslt = pResponse->JobRslt;
@@ -1016,8 +1041,8 @@ else // class instance identifier was 0, if request specified a class identifier
 		
 pInstance->ClassMethodID = pResponse->ClassMethodID;
 pInstance->OutDataSize = pResponse->DataSize;
-if(pResponse->DataSize > 0)
-	memcpy(pInstance->Data,pResponse->Data,pResponse->DataSize);
+if(!(pResponse->Hdr.FrameFlags & cBKSFrameFlgShmSlot) && pResponse->DataSize > 0)	// if flagged then response is already in place in the instance's slot
+	memcpy(InstanceData(pSession,InstanceID,pInstance),pResponse->Data,pResponse->DataSize);
 pInstance->FlgCpltd = 1;
 pSession->Session.NumProcs -= 1;
 pSession->Session.NumCpltd += 1;
@@ -1130,7 +1155,7 @@ if(pReqRespInst->FlgCpltd)		// set if job has completed
 	else
 		CpySize = 0;
 	if(CpySize)
-		memcpy(pOutData,pReqRespInst->Data, CpySize);
+		memcpy(pOutData,InstanceData(pSession,InstanceID,pReqRespInst), CpySize);
 	if(pOutDataSize != NULL)
 		*pOutDataSize = CpySize;
 	if(pJobRslt != NULL)
@@ -1148,7 +1173,7 @@ if(pReqRespInst->FlgCpltd)		// set if job has completed
 		__sync_fetch_and_sub(&m_TotRespsAvail,1);
 #endif
 		pSession->Session.NumBusy -= 1;
-		memset(pReqRespInst,0,pType->ReqRespInstSize);
+		memset(pReqRespInst,0,sizeof(tsReqRespInst));
 		UnallocReqID(ReqID);
 		}
 	ReleaseLock(true);
@@ -1186,6 +1211,8 @@ if(m_pBKSSessEstabs != NULL)
 			free(pSessEstab->TxdRxd.pRxdBuff);
 		if (pSessEstab->TxdRxd.pTxdBuff != NULL)
 			free(pSessEstab->TxdRxd.pTxdBuff);
+		if (pSessEstab->TxdRxd.pShm != NULL)
+			delete pSessEstab->TxdRxd.pShm;
 		memset(pSessEstab,0,sizeof(tsBKSSessEstab));
 		pSessEstab->TxdRxd.Socket = INVALID_SOCKET;
 	#else
@@ -1195,6 +1222,8 @@ if(m_pBKSSessEstabs != NULL)
 			free(pSessEstab->TxdRxd.pRxdBuff);
 		if (pSessEstab->TxdRxd.pTxdBuff != NULL)
 			free(pSessEstab->TxdRxd.pTxdBuff);
+		if (pSessEstab->TxdRxd.pShm != NULL)
+			delete pSessEstab->TxdRxd.pShm;
 		memset(pSessEstab, 0, sizeof(tsBKSSessEstab));
 		pSessEstab->TxdRxd.Socket = -1;
 	#endif
@@ -1242,6 +1271,8 @@ if(m_pBKSTypes != NULL)
 							free(pSession->TxdRxd.pRxdBuff);
 						if (pSession->TxdRxd.pTxdBuff != NULL)
 							free(pSession->TxdRxd.pTxdBuff);
+						if (pSession->TxdRxd.pShm != NULL)
+							delete pSession->TxdRxd.pShm;
 						if(pSession->pReqResp != NULL)
 							free(pSession->pReqResp);
 						pNext = pSession->pNext;
@@ -1295,6 +1326,12 @@ if(m_ListenerSock != -1)
 	close(m_ListenerSock);
 	m_ListenerSock = -1;
 	}
+m_bListenerRdy = false;
+if(m_hEpoll != -1)
+	{
+	close(m_hEpoll);
+	m_hEpoll = -1;
+	}
 #endif
 
 if(m_ppChkPtReqs != NULL)
@@ -1393,7 +1430,11 @@ if (m_NumSessions)
 							free(pSession->TxdRxd.pRxdBuff);
 						if (pSession->TxdRxd.pTxdBuff != NULL)
 							free(pSession->TxdRxd.pTxdBuff);
-
+						if (pSession->TxdRxd.pShm != NULL)
+							{
+							delete pSession->TxdRxd.pShm;
+							pSession->TxdRxd.pShm = NULL;
+							}
 
 						if(pSession->Session.NumCpltd != 0)
 #ifdef WIN32
@@ -1611,6 +1652,24 @@ switch(pSessEstab->SEState) {
 			return(false);
 			}
 
+#ifndef WIN32
+		// provider may be offering a shared memory transport if it determined that it's co-located on this host
+		if(pOfferService->szShmName[0] != '\0' && pSessEstab->TxdRxd.pShm == NULL)
+			{
+			pOfferService->szShmName[cBKSShmNameLen-1] = '\0';
+			pSessEstab->TxdRxd.pShm = new CBKSShm;
+			// each offered service instance requires a payload slot able to hold maximally sized requests and responses
+			if(!pSessEstab->TxdRxd.pShm->Open(pOfferService->szShmName,pOfferService->ShmToken) ||
+				pSessEstab->TxdRxd.pShm->NumSlots() < ServiceInsts ||
+				pSessEstab->TxdRxd.pShm->SlotSize() < max(pBKSType->Detail.MaxReqPayloadSize,pBKSType->Detail.MaxRespPayloadSize))
+				{
+				gDiagnostics.DiagOut(eDLInfo, gszProcName, "ProgressSessEstab with session: %u unable to open offered shared memory transport, using socket", pSessEstab->TxdRxd.SessionID);
+				delete pSessEstab->TxdRxd.pShm;
+				pSessEstab->TxdRxd.pShm = NULL;
+				}
+			}
+#endif
+
 		pSessEstab->TxdRxd.flgRxCplt = 0;
 		if ((Diff = (pSessEstab->TxdRxd.TotRxd - pSessEstab->TxdRxd.CurPacRxd)) > 0)
 			{
@@ -1641,6 +1700,12 @@ switch(pSessEstab->SEState) {
 			pSessEstab->TxdRxd.flgSelMonRead = 0;
 			pSessEstab->TxdRxd.flgSelMonWrite = 1;
 			pAcceptService->BKSPType = eBKSPTUndefined;		// can't accept
+			pAcceptService->flgShmAccepted = 0;
+			if(pSessEstab->TxdRxd.pShm != NULL)
+				{
+				delete pSessEstab->TxdRxd.pShm;
+				pSessEstab->TxdRxd.pShm = NULL;
+				}
 			}
 		else
 			{
@@ -1652,6 +1717,7 @@ switch(pSessEstab->SEState) {
 			pSessEstab->BKSPType = Type;
 			pSessEstab->MaxInstances = ServiceInsts;
 			pSessEstab->MaxClassInstances = ClassInsts;
+			pAcceptService->flgShmAccepted = pSessEstab->TxdRxd.pShm != NULL ? 1 : 0;
 			}
 
 		if (!TxData(&pSessEstab->TxdRxd))
@@ -1674,6 +1740,12 @@ switch(pSessEstab->SEState) {
 			m_NumSessEstabs -= 1;
 			return(true);
 			}
+		// acceptance was sent through the socket, all subsequent frames are through the shared memory rings if accepted
+		if(pSessEstab->TxdRxd.pShm != NULL)
+			{
+			pSessEstab->TxdRxd.flgShmActv = 1;
+			gDiagnostics.DiagOut(eDLInfo, gszProcName, "ProgressSessEstab with session: %u using shared memory transport", pSessEstab->TxdRxd.SessionID);
+			}
 		// now accepting as a full session
 		bRegistered = AcceptFullSession(pSessEstab);
 		if(bRegistered == true)
@@ -1706,6 +1778,8 @@ if((pSession = (tsBKSRegSessionEx *)malloc(sizeof(tsBKSRegSessionEx)))==NULL)
 	return(false);
 memset(pSession,0,sizeof(tsBKSRegSessionEx));
 pSession->TxdRxd = pSessEstab->TxdRxd;
+pSessEstab->TxdRxd.pShm = NULL;				// any shared memory transport is now owned by the full session
+pSessEstab->TxdRxd.flgShmActv = 0;
 #ifdef WIN32
 pSessEstab->TxdRxd.Socket = INVALID_SOCKET;
 #else
@@ -1777,6 +1851,15 @@ pSession->pNext = pType->pFirstSession;
 pType->pFirstSession = pSession;
 m_NumSessions += 1;
 NumSessions = m_NumSessions;
+#ifndef WIN32
+	// socket was registered with epoll whilst being established, events are now to be associated with the full session
+if(!EpollMod(pSession->TxdRxd.Socket,&pSession->TxdRxd))
+	{
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "AcceptFullSession: unable to modify epoll monitoring of session: %u, error %d",pSession->TxdRxd.SessionID, errno);
+	ShutdownConnection(&pSession->TxdRxd.Socket);
+	pSession->Session.BKSPState = eBKSPSRegisteredTerm;		// will be deleted by DeleteAllSessionsInState()
+	}
+#endif
 return(true);
 }
 
@@ -1822,6 +1905,8 @@ else
 		}
 	AllocdTxdBuff = 0;
 	}
+if(pSessEstab->TxdRxd.pShm != NULL)
+	delete pSessEstab->TxdRxd.pShm;
 #ifdef WIN32
 if (pSessEstab->TxdRxd.Socket != INVALID_SOCKET)
 	closesocket(pSessEstab->TxdRxd.Socket);
@@ -1958,6 +2043,16 @@ pSessEstab->TxdRxd.RxdTxFrameID = 0;
 pSessEstab->TxdRxd.SessionID = SessionID;
 pSessEstab->TxdRxd.IPaddress = *pIPaddress;
 pSessEstab->TxdRxd.Socket = Socket;
+#ifndef WIN32
+if(!EpollAdd(Socket,&pSessEstab->TxdRxd))
+	{
+	gDiagnostics.DiagOut(eDLInfo, gszProcName, "StartSessEstab: unable to monitor socket with epoll, error %d", errno);
+	ResetSessEstab(pSessEstab,true);		// closes socket and unallocates the session identifier
+	if(bReused)
+		m_NumSessEstabs -= 1;
+	return(false);
+	}
+#endif
 pSessEstab->StartSecs = Now;
 // send list of required services to provider Session
 PacNegA = (tsBKSReqServices *)pSessEstab->TxdRxd.pTxdBuff;
@@ -2497,6 +2592,21 @@ if(!InitialiseCtrlSocks())
 m_Ctrl[1].flgSelMonExcept = 1;
 m_Ctrl[1].flgSelMonRead = 1;
 
+#ifndef WIN32
+// on linux all sockets are monitored by a single edge triggered epoll instance, sockets are registered once only
+// and are implicitly removed from monitoring when closed
+if(m_hEpoll != -1)
+	close(m_hEpoll);
+m_bListenerRdy = false;
+if((m_hEpoll = epoll_create1(EPOLL_CLOEXEC)) == -1 ||
+	!EpollAdd(m_ListenerSock,&m_ListenerSock) || !EpollAdd(m_Ctrl[1].Socket,&m_Ctrl[1]))
+	{
+	gDiagnostics.DiagOut(eDLFatal, gszProcName, "Initialise: unable to initialise epoll monitoring, error %d", errno);
+	Reset(true);
+	return(-1);
+	}
+#endif
+
 ReleaseLock(true);
 return(eBSFSuccess);
 }
@@ -2765,6 +2875,7 @@ return(true);
 }
 
 
+#ifdef WIN32
 // SetupFDSets 
 // Set up the three FD sets used with select() with the sockets to be monitored for events
 // returns:
@@ -2895,6 +3006,113 @@ for (TypeIdx = 0; TypeIdx < eBKSPTPlaceHolder-1; TypeIdx++, pType += 1)
 	}
 return(HiFD);
 }
+#else
+// On linux sockets are monitored with edge triggered epoll instead of select()
+// Each socket is registered once, monitoring for both read and write readiness, with events returned as sticky readiness flags in the
+// associated tsTxdRxd. These flags are only reset by RxData()/TxData()/RcvCtrl() when a socket operation would block, so there is no
+// per iteration rebuilding of descriptor sets and the cost of each epoll_wait() is proportional to the number of sockets with activity
+bool
+CBKSRequester::EpollAdd(socket_t Socket,	// start edge triggered monitoring of this socket
+					void *pEvPtr)			// returned with events, either a tsTxdRxd or &m_ListenerSock
+{
+struct epoll_event Event;
+if(m_hEpoll == -1 || Socket == -1 || pEvPtr == NULL)
+	return(false);
+memset(&Event,0,sizeof(Event));
+Event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+Event.data.ptr = pEvPtr;
+return(epoll_ctl(m_hEpoll,EPOLL_CTL_ADD,Socket,&Event) == 0 ? true : false);
+}
+
+bool
+CBKSRequester::EpollMod(socket_t Socket,	// socket already being monitored
+					void *pEvPtr)			// events now to be returned with this ptr
+{
+struct epoll_event Event;
+if(m_hEpoll == -1 || Socket == -1 || pEvPtr == NULL)
+	return(false);
+memset(&Event,0,sizeof(Event));
+Event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+Event.data.ptr = pEvPtr;
+return(epoll_ctl(m_hEpoll,EPOLL_CTL_MOD,Socket,&Event) == 0 ? true : false);
+}
+
+bool										// false if an error was reported on the listening socket
+CBKSRequester::EpollEvents(int NumEvents,	// apply this many events
+					struct epoll_event *pEvents)	// returned by epoll_wait() as sticky readiness flags
+{
+bool bListenerOK;
+tsTxdRxd *pTxdRxd;
+bListenerOK = true;
+for(; NumEvents > 0; NumEvents--, pEvents++)
+	{
+	if(pEvents->data.ptr == (void *)&m_ListenerSock)
+		{
+		if(pEvents->events & EPOLLERR)
+			bListenerOK = false;
+		if(pEvents->events & EPOLLIN)
+			m_bListenerRdy = true;
+		continue;
+		}
+	pTxdRxd = (tsTxdRxd *)pEvents->data.ptr;
+	if(pEvents->events & EPOLLERR)
+		pTxdRxd->flgEvExcept = 1;
+	if(pEvents->events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP))	// a hangup is read ready, recv() will then return the closure
+		pTxdRxd->flgEvRead = 1;
+	if(pEvents->events & EPOLLOUT)
+		pTxdRxd->flgEvWrite = 1;
+	if(pTxdRxd->flgShmActv && (pEvents->events & EPOLLIN))	// doorbell could be peer notifying that space is now available in a previously full ring
+		pTxdRxd->flgEvWrite = 1;
+	}
+return(bListenerOK);
+}
+
+bool					// true if any monitored socket has readiness which can be actioned without waiting on epoll_wait()
+CBKSRequester::EpollPending(void)
+{
+int TypeIdx;
+uint32_t Idx;
+tsTxdRxd *pTxdRxd;
+tsBKSType *pType;
+tsBKSRegSessionEx *pSessionEx;
+tsBKSSessEstab *pSessEstab;
+
+if(m_bListenerRdy)
+	return(true);
+pTxdRxd = &m_Ctrl[1];
+if(pTxdRxd->Socket != -1 && pTxdRxd->flgErr == 0 && pTxdRxd->flgSelMonRead && pTxdRxd->flgEvRead)
+	return(true);
+
+if(m_NumSessEstabs && (pSessEstab = m_pBKSSessEstabs) != NULL)
+	{
+	for(Idx = 0; Idx < cMaxSessEstab; Idx++, pSessEstab++)
+		{
+		pTxdRxd = &pSessEstab->TxdRxd;
+		if(pSessEstab->SEState == eSESnone || pTxdRxd->Socket == -1)
+			continue;
+		if(pTxdRxd->flgEvExcept || (pTxdRxd->flgSelMonRead && pTxdRxd->flgEvRead) || (pTxdRxd->flgSelMonWrite && pTxdRxd->flgEvWrite))
+			return(true);
+		}
+	}
+
+if((pType = m_pBKSTypes) == NULL)
+	return(false);
+for(TypeIdx = 0; TypeIdx < eBKSPTPlaceHolder - 1; TypeIdx++, pType++)
+	{
+	if(pType->Detail.BKSPType == eBKSPTUndefined || pType->NumSessions == 0)
+		continue;
+	for(pSessionEx = pType->pFirstSession; pSessionEx != NULL; pSessionEx = pSessionEx->pNext)
+		{
+		pTxdRxd = &pSessionEx->TxdRxd;
+		if(pTxdRxd->Socket == -1 || pSessionEx->Session.BKSPState == eBKSPSRegisteredTerm)
+			continue;
+		if(pTxdRxd->flgEvExcept || (pTxdRxd->flgSelMonRead && pTxdRxd->flgEvRead) || (pTxdRxd->flgSelMonWrite && pTxdRxd->flgEvWrite))
+			return(true);
+		}
+	}
+return(false);
+}
+#endif
 
 bool
 CBKSRequester::RxData(tsTxdRxd *pRxd)					// receiving session data
@@ -2999,7 +3217,12 @@ if ((ExpRxdLen + pRxd->TotRxd) > pRxd->AllocdRxdBuff)
 	}
 
 	// now try receiving ...
-RxdLen = recv(pRxd->Socket, (char *)&pRxd->pRxdBuff[pRxd->TotRxd], ExpRxdLen, 0);
+#ifndef WIN32
+if(pRxd->flgShmActv == 1)		// co-located peer, frame bytes are read from shared memory with socket only carrying doorbells
+	RxdLen = pRxd->pShm->Recv(pRxd->Socket, &pRxd->pRxdBuff[pRxd->TotRxd], ExpRxdLen);
+else
+#endif
+	RxdLen = recv(pRxd->Socket, (char *)&pRxd->pRxdBuff[pRxd->TotRxd], ExpRxdLen, 0);
 if (RxdLen == 0)	// 0 if socket was closed by peer
 	{
 	pRxd->flgErr = 1;
@@ -3022,7 +3245,11 @@ if (RxdLen == -1)
 #else
 	err = errno;
 	if (err == EWOULDBLOCK || err == EAGAIN || err == EINTR)
+		{
+		if(err != EINTR)			// socket has been drained, epoll will report when more data becomes available
+			pRxd->flgEvRead = 0;
 		return(true);
+		}
 #endif
 	pRxd->flgErr = 1;
 	pRxd->flgErrReason = 7;      // general socket error 
@@ -3031,6 +3258,8 @@ if (RxdLen == -1)
 	}
 
 	// received at least 1 byte, can now be characterised as being a complete frame?
+if((uint32_t)RxdLen < ExpRxdLen)	// short recv() also means socket has been drained
+	pRxd->flgEvRead = 0;
 pRxd->TotRxd += RxdLen;
 if (pRxd->TotRxd >= sizeof(tsBKSPacHdr))
 	{
@@ -3116,7 +3345,12 @@ CBKSRequester::TxData(tsTxdRxd *pTxd)
 	}
 	pTxd->flgTxCplt = 0;
 	ReqTxLen = pTxd->TotTxd - pTxd->CurTxd;
-	ActTxLen = send(pTxd->Socket, (char *)&pTxd->pTxdBuff[pTxd->CurTxd], ReqTxLen, 0);
+#ifndef WIN32
+	if(pTxd->flgShmActv == 1)		// co-located peer, frame bytes are written into shared memory and peer doorbelled
+		ActTxLen = pTxd->pShm->Send(pTxd->Socket, &pTxd->pTxdBuff[pTxd->CurTxd], ReqTxLen);
+	else
+#endif
+		ActTxLen = send(pTxd->Socket, (char *)&pTxd->pTxdBuff[pTxd->CurTxd], ReqTxLen, 0);
 
 #ifdef WIN32
 	if (ActTxLen == SOCKET_ERROR)
@@ -3137,6 +3371,8 @@ CBKSRequester::TxData(tsTxdRxd *pTxd)
 		if (err == EWOULDBLOCK || err == EAGAIN || err == EINTR)
 			{
 			pTxd->flgSelMonWrite = 1;
+			if(err != EINTR)
+				pTxd->flgEvWrite = 0;
 			return(true);
 			}
 #endif
@@ -3147,7 +3383,7 @@ CBKSRequester::TxData(tsTxdRxd *pTxd)
 	}
 
 	pTxd->CurTxd += ActTxLen;
-	if (pTxd->CurTxd == ReqTxLen)
+	if (pTxd->CurTxd == pTxd->TotTxd)
 		{
 		pTxd->PacTxdAtSecs = time(NULL);
 		pTxd->flgTxCplt = 1;
@@ -3155,7 +3391,11 @@ CBKSRequester::TxData(tsTxdRxd *pTxd)
 		pTxd->TotTxd = 0;
 		}
 	else
+		{
 		pTxd->flgSelMonWrite = 1;
+		if(ActTxLen < ReqTxLen)
+			pTxd->flgEvWrite = 0;		// short send, socket buffer is full and epoll will report when writeable
+		}
 	return true;
 }
 
@@ -3246,7 +3486,10 @@ if (RxdLen == -1)
 #else
 	err = errno;
 	if (err == EWOULDBLOCK || err == EAGAIN || err == EINTR)
+		{
+		pCtrl->flgEvRead = 0;
 		return(0);
+		}
 #endif
 	pCtrl->flgErr = 1;
 	pCtrl->flgErrReason = 7;      // general socket error 
@@ -3385,6 +3628,19 @@ pCtrl->TotTxd = 0;
 return(true);
 }
 
+// socket events as reported by select() on windows, or as sticky epoll readiness flags on linux
+#ifdef WIN32
+#define SockEvExcept(pTxdRxd) FD_ISSET((pTxdRxd)->Socket, &ExceptFDs)
+#define SockEvRead(pTxdRxd) FD_ISSET((pTxdRxd)->Socket, &ReadFDs)
+#define SockEvWrite(pTxdRxd) FD_ISSET((pTxdRxd)->Socket, &WriteFDs)
+#define SockEvClr(Socket,FDs) FD_CLR(Socket, &FDs)
+#else
+#define SockEvExcept(pTxdRxd) ((pTxdRxd)->flgEvExcept == 1)
+#define SockEvRead(pTxdRxd) ((pTxdRxd)->flgSelMonRead == 1 && (pTxdRxd)->flgEvRead == 1)
+#define SockEvWrite(pTxdRxd) ((pTxdRxd)->flgSelMonWrite == 1 && (pTxdRxd)->flgEvWrite == 1)
+#define SockEvClr(Socket,FDs)
+#endif
+
 int 
 CBKSRequester::AcceptConnections(void)	// start accepting connections
 {
@@ -3394,8 +3650,14 @@ time_t CurTimeSecs;
 tsBKSType *pType;
 tsBKSRegSessionEx *pSessionEx;
 int TypeIdx;
+#ifdef WIN32
 struct timeval SelectTimeout;
 fd_set ReadFDs, WriteFDs, ExceptFDs;
+#else
+bool bListenerOK;
+int EpollTimeout;
+struct epoll_event EpollEvs[cMaxEpollEvents];
+#endif
 socket_t AcceptedSock;
 struct sockaddr_storage SockPeerAddr;
 char szPeerHost[100];
@@ -3453,11 +3715,6 @@ while (1)
 			else
 				{
 				m_NumSessEstabs += 1;
-				
-#ifndef WIN32
-				if (HiFDS <= pSessEstab->TxdRxd.Socket)
-					HiFDS = pSessEstab->TxdRxd.Socket + 1;
-#endif
 				}
 			}
 		}
@@ -3532,6 +3789,7 @@ while (1)
 	AcquireLock(true);
 
  	SendRequestFrames();
+#ifdef WIN32
 	SelectTimeout.tv_sec = 5;
 	SelectTimeout.tv_usec = 0;
 	HiFDS = SetupFDSets(ReadFDs, WriteFDs, ExceptFDs);
@@ -3540,19 +3798,40 @@ while (1)
 	AcquireLock(true);
 	if(SelectRslt == 0)			// 0 if simply timed out with no socket events occurring
 		continue;
+#else
+		// if sockets still have readiness which was not fully actioned in the previous iteration then only poll for additional events
+	EpollTimeout = EpollPending() ? 0 : 5000;
+	ReleaseLock(true);
+	SelectRslt = epoll_wait(m_hEpoll, EpollEvs, cMaxEpollEvents, EpollTimeout);
+	AcquireLock(true);
+	if(SelectRslt == -1 && errno == EINTR)
+		SelectRslt = 0;
+	if(SelectRslt >= 0)
+		{
+		bListenerOK = EpollEvents(SelectRslt, EpollEvs);
+		if(bListenerOK && !EpollPending())			// simply timed out with no actionable socket events
+			continue;
+		SelectRslt += 1;
+		}
+#endif
 	if (SelectRslt > 0)
 		{
 		// at least one monitored socket event has occurred
         // event could be on the listener socket (new Session connection), session negotiation, or an established session
+#ifdef WIN32
 		if (FD_ISSET(m_ListenerSock, &ReadFDs))
+#else
+		if (bListenerOK && m_bListenerRdy)
+#endif
 			{
 			SockPeerAddrSize = (int)sizeof(SockPeerAddr);
 			AcceptedSock = accept(m_ListenerSock,(sockaddr*)&SockPeerAddr, &SockPeerAddrSize); // note that accept() errors are silently sloughed
 #ifdef WIN32
 			if (AcceptedSock != INVALID_SOCKET)
 #else
+			if(AcceptedSock == -1)			// no more pending connections, epoll will report when there are further connections to accept
+				m_bListenerRdy = false;
 			if (AcceptedSock != -1)
-
 #endif
 				{
 									// report the connections peer address
@@ -3591,7 +3870,11 @@ while (1)
 					}
 				}
 			}
+#ifdef WIN32
 		else if (FD_ISSET(m_ListenerSock, &ExceptFDs))   // can't ignore errors on the listening socket, these are fatal!
+#else
+		else if (!bListenerOK)							// can't ignore errors on the listening socket, these are fatal!
+#endif
 			{
 			int err;
 #ifdef WIN32
@@ -3607,18 +3890,18 @@ while (1)
 			}
 
 		// check for control socket event
-		if(FD_ISSET(m_Ctrl[1].Socket,&ExceptFDs))
+		if(SockEvExcept(&m_Ctrl[1]))
 			{
 			}
-		if (m_Ctrl[1].flgSelMonRead && FD_ISSET(m_Ctrl[1].Socket, &ReadFDs))
+		if (m_Ctrl[1].flgSelMonRead && SockEvRead(&m_Ctrl[1]))
 			{
-			FD_CLR(m_Ctrl[1].Socket, &ReadFDs);
+			SockEvClr(m_Ctrl[1].Socket, ReadFDs);
 			while (1)
 				{     
 				int CtrlMsgLen;
 				uint8_t CtrlMsg[256];
                                                                                                                                                                                     \
-				if((CtrlMsgLen = RcvCtrl(sizeof(CtrlMsg),CtrlMsg))==0)
+				if((CtrlMsgLen = RcvCtrl(sizeof(CtrlMsg),CtrlMsg))<=0)
 					break;
 
 					// handle this received control payload packet
@@ -3639,7 +3922,7 @@ while (1)
 				if (pSessEstab->SEState == eSESnone)
 					continue;
 				bOK = true;
-				if (FD_ISSET(pSessEstab->TxdRxd.Socket, &ExceptFDs))		// if any exception then immediately terminate connection
+				if (SockEvExcept(&pSessEstab->TxdRxd))		// if any exception then immediately terminate connection
 					{
 					gDiagnostics.DiagOut(eDLInfo, gszProcName, "AcceptConnections: terminating due to socket exception with session : %u", pSessEstab->TxdRxd.SessionID);
 					ResetSessEstab(pSessEstab);
@@ -3649,10 +3932,10 @@ while (1)
 					}
 				else
 					{
-					if (FD_ISSET(pSessEstab->TxdRxd.Socket, &ReadFDs))
+					if (SockEvRead(&pSessEstab->TxdRxd))
 						{
 						bOK = RxData(&pSessEstab->TxdRxd);
-						FD_CLR(pSessEstab->TxdRxd.Socket, &ReadFDs);
+						SockEvClr(pSessEstab->TxdRxd.Socket, ReadFDs);
 						if(bOK && pSessEstab->TxdRxd.flgRxCplt == 1)
 							{
 							bool bProgressSessEstab;
@@ -3663,10 +3946,10 @@ while (1)
 					if (m_NumSessEstabs == 0)
 						break;
 
-					if (FD_ISSET(pSessEstab->TxdRxd.Socket, &WriteFDs))
+					if (SockEvWrite(&pSessEstab->TxdRxd))
 						{
 						bOK = TxData(&pSessEstab->TxdRxd);
-						FD_CLR(pSessEstab->TxdRxd.Socket, &WriteFDs);
+						SockEvClr(pSessEstab->TxdRxd.Socket, WriteFDs);
 						if (bOK && pSessEstab->TxdRxd.flgTxCplt == 1)
 							{
 							bool bProgressSessEstab;
@@ -3705,17 +3988,17 @@ while (1)
 						const char* pcErrorType = 0;
 
 							// See if this socket's flag is set in any of the FD sets.
-						if (pSessionEx->TxdRxd.flgSelMonExcept && FD_ISSET(pSessionEx->TxdRxd.Socket, &ExceptFDs))
+						if (pSessionEx->TxdRxd.flgSelMonExcept && SockEvExcept(&pSessionEx->TxdRxd))
 							{
 							bOK = false;
 							pcErrorType = "General socket error";
-							FD_CLR(pSessionEx->TxdRxd.Socket, &ExceptFDs);
+							SockEvClr(pSessionEx->TxdRxd.Socket, ExceptFDs);
 							}
 						else
 							{
-							if (pSessionEx->TxdRxd.flgSelMonRead && FD_ISSET(pSessionEx->TxdRxd.Socket, &ReadFDs))
+							if (pSessionEx->TxdRxd.flgSelMonRead && SockEvRead(&pSessionEx->TxdRxd))
 								{
-								FD_CLR(pSessionEx->TxdRxd.Socket, &ReadFDs);
+								SockEvClr(pSessionEx->TxdRxd.Socket, ReadFDs);
 
 								while((bOK = RxData(&pSessionEx->TxdRxd))==true)
 									{                                                                                                                                                                                         \
@@ -3744,10 +4027,10 @@ while (1)
 									}
 
 								}
-							if (bOK && (pSessionEx->TxdRxd.flgSelMonWrite && FD_ISSET(pSessionEx->TxdRxd.Socket, &WriteFDs)))
+							if (bOK && (pSessionEx->TxdRxd.flgSelMonWrite && SockEvWrite(&pSessionEx->TxdRxd)))
 								{
 								bOK = TxData(&pSessionEx->TxdRxd);
-								FD_CLR(pSessionEx->TxdRxd.Socket, &WriteFDs);
+								SockEvClr(pSessionEx->TxdRxd.Socket, WriteFDs);
 								}
 							}
 
@@ -3774,7 +4057,11 @@ while (1)
 		}
 	else
 		{
+#ifdef WIN32
 		gDiagnostics.DiagOut(eDLFatal, gszProcName, "AcceptConnections: select() failed");
+#else
+		gDiagnostics.DiagOut(eDLFatal, gszProcName, "AcceptConnections: epoll_wait() failed, error %d", errno);
+#endif
 		ReleaseLock(true);
 		Reset(true);
 		return(-1);
@@ -31,6 +31,8 @@ typedef enum TAG_eSessEstabState
 } teSessEstabState;
 
 
+class CBKSShm;
+
 #pragma pack(1)
 
 typedef int64_t tJobIDEx;			// >0 extended job identifier; 0 if none assigned, <0 if errors
@@ -46,7 +48,12 @@ typedef struct TAG_sTxdRxd
 	uint16_t flgTxCplt : 1;	// set when complete frame sent
 	uint16_t flgErr : 1;       // set on any unrecoverable error
 	uint16_t flgErrReason : 4;	// holds reason for socket level error flag set
+	uint16_t flgEvRead : 1;	// linux epoll: socket reported as readable and not since drained (edge triggered so sticky until recv() would block)
+	uint16_t flgEvWrite : 1;	// linux epoll: socket reported as writeable and not since filled (sticky until send() would block)
+	uint16_t flgEvExcept : 1;	// linux epoll: socket reported an error or hangup condition
+	uint16_t flgShmActv : 1;	// frames are exchanged through shared memory rings in pShm, socket only carries doorbells
 	socket_t  Socket;		// assumed connected socket
+	CBKSShm *pShm;			// shared memory transport with co-located peer, NULL if frames exchanged over Socket
 	time_t PacRxdAtSecs;	// the time at which a frame was last received, used for determining if session still active
 	time_t PacTxdAtSecs;	// the time at which a frame was last sent, used for keep alive generation
 
@@ -232,6 +239,11 @@ class CBKSRequester
 
 	tsTxdRxd m_Ctrl[2];									// Ctrl[0] written to by threads needing to signal select() processing thread, select() processing thread monitors m_Ctrl[1]
 
+#ifndef _WIN32
+	int m_hEpoll;										// linux: epoll instance monitoring the listener, control and all session sockets; -1 if not created
+	bool m_bListenerRdy;								// linux: listener reported as having connections to accept, cleared when accept() would block
+#endif
+
 	uint32_t												// returned request identifier or 0 if all identifiers have already been allocated
 			AllocReqID(void);							// returns next available unused request identifier and sets that identifier in m_ReqIDVect[] as now allocated
 
@@ -336,11 +348,26 @@ class CBKSRequester
 
 	bool ShutdownConnection(socket_t *pSocket);
 
+#ifdef _WIN32
 	int			// returns 0 if no sockets to be monitored with select(), on windows the total number of monitored sockets, on linux the highest socket file descriptor plus 1
 		SetupFDSets(fd_set& ReadFDs,			// select() read available socket descriptor set  
 					fd_set& WriteFDs,			// select() write accepted socket descriptor set
 					fd_set& ExceptFDs);			// select() exceptions descriptor set
+#else
+	bool EpollAdd(socket_t Socket,				// start edge triggered monitoring of this socket
+					void *pEvPtr);				// returned with events, either a tsTxdRxd or &m_ListenerSock
+	bool EpollMod(socket_t Socket,				// socket already being monitored
+					void *pEvPtr);				// events now to be returned with this ptr
+	bool EpollEvents(int NumEvents,				// apply this many events, returns false if an error was reported on the listening socket
+					struct epoll_event *pEvents);	// returned by epoll_wait() as sticky readiness flags
+	bool EpollPending(void);					// true if any monitored socket has readiness which can be actioned without waiting on epoll_wait()
+#endif
+
 
+	uint8_t *													// returns ptr to where the instance's request and response payloads are located
+			InstanceData(tsBKSRegSessionEx *pSession,					// session containing
+						 uint32_t InstanceID,							// this service instance (1..MaxInstances)
+						 tsReqRespInst *pReqRespInst);					// with this request/response instance
 
 	tJobIDEx										// packed job identifier or 0 if range errors
 				PackIntoJobIDEx(uint32_t ReqID,							// must be in the range 1..16777215 (24bits)
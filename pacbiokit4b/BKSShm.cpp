@@ -0,0 +1,428 @@
+/*
+This toolkit is a source base clone of 'PacBioKanga' release 4.4.2 (https://github.com/csiro-crop-informatics/biokanga) and contains
+significant source code changes enabling new functionality and resulting process parameterisation changes. These changes have resulted in
+incompatibility with 'PacBioKanga'.
+
+Because of the potential for confusion by users unaware of functionality and process parameterisation changes then the modified source base
+and resultant compiled executables have been renamed to 'kit4bpacbio' - K-mer Informed Toolkit for Bioinformatics with PacBio.
+The renaming will force users of the 'PacBioKanga' toolkit to examine scripting which is dependent on existing 'PacBioKanga'
+parameterisations so as to make appropriate changes if wishing to utilise 'kit4bpacbio' parameterisations and functionality.
+
+'kit4pacbio' is being released under the Opensource Software License Agreement (GPLv3)
+'kit4pacbio' is Copyright (c) 2019, 2020, Dr Stuart Stephen
+Please contact Dr Stuart Stephen < stuartjs@g3bio.com > if you have any questions regarding 'kit4b'.
+*/
+
+#include "stdafx.h"
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if _WIN32
+#include <process.h>
+#include "../libkit4b/commhdrs.h"
+#include <WinSock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include "../libkit4b/commhdrs.h"
+#endif
+
+#include "./BKScommon.h"
+#include "./BKSShm.h"
+
+#ifndef _WIN32
+static volatile uint32_t gBKSShmSegCnt = 0;	// used to uniquely name segments created by this process
+#endif
+
+CBKSShm::CBKSShm(void)
+{
+m_pHdr = NULL;
+m_bCreator = false;
+m_szName[0] = '\0';
+Reset();
+}
+
+CBKSShm::~CBKSShm(void)
+{
+Reset();
+}
+
+void
+CBKSShm::Reset(void)
+{
+#ifndef _WIN32
+if(m_pHdr != NULL)
+	{
+	munmap(m_pHdr,m_MapSize);
+	m_pHdr = NULL;
+	}
+if(m_bCreator && !m_bUnlinked && m_szName[0] != '\0')
+	shm_unlink(m_szName);
+#endif
+m_szName[0] = '\0';
+m_bCreator = false;
+m_bUnlinked = false;
+m_MapSize = 0;
+m_pHdr = NULL;
+m_pTxRing = NULL;
+m_pTxData = NULL;
+m_pRxRing = NULL;
+m_pRxData = NULL;
+m_pSlots = NULL;
+m_NumSlots = 0;
+m_SlotSize = 0;
+}
+
+// sessions are co-located if both socket endpoints share the same address, or if the peer is connecting over loopback
+bool
+CBKSShm::IsColocated(socket_t Socket)
+{
+#ifdef _WIN32
+return(false);
+#else
+struct sockaddr_storage LocalAddr;
+struct sockaddr_storage PeerAddr;
+socklen_t AddrLen;
+
+AddrLen = sizeof(LocalAddr);
+if(getsockname(Socket,(struct sockaddr *)&LocalAddr,&AddrLen) != 0)
+	return(false);
+AddrLen = sizeof(PeerAddr);
+if(getpeername(Socket,(struct sockaddr *)&PeerAddr,&AddrLen) != 0)
+	return(false);
+if(LocalAddr.ss_family != PeerAddr.ss_family)
+	return(false);
+switch(PeerAddr.ss_family) {
+	case AF_INET:
+		{
+		struct sockaddr_in *pLocal = (struct sockaddr_in *)&LocalAddr;
+		struct sockaddr_in *pPeer = (struct sockaddr_in *)&PeerAddr;
+		if((ntohl(pPeer->sin_addr.s_addr) >> 24) == 127)
+			return(true);
+		return(pLocal->sin_addr.s_addr == pPeer->sin_addr.s_addr ? true : false);
+		}
+
+	case AF_INET6:
+		{
+		struct sockaddr_in6 *pLocal = (struct sockaddr_in6 *)&LocalAddr;
+		struct sockaddr_in6 *pPeer = (struct sockaddr_in6 *)&PeerAddr;
+		if(IN6_IS_ADDR_LOOPBACK(&pPeer->sin6_addr))
+			return(true);
+		return(memcmp(&pLocal->sin6_addr,&pPeer->sin6_addr,sizeof(struct in6_addr)) == 0 ? true : false);
+		}
+
+	default:
+		break;
+	}
+return(false);
+#endif
+}
+
+bool
+CBKSShm::Create(uint64_t *pToken,		// returned random token to be passed to peer along with segment name
+			   int NameLen,				// pszName can hold at most this many chars including terminating '\0'
+			   char *pszName,			// returned segment name
+			   uint32_t NumSlots,		// arena to hold this many payload slots, one for each service instance
+			   uint32_t SlotSize)		// each slot to hold a payload of at least this size
+{
+#ifdef _WIN32
+return(false);
+#else
+int hShm;
+int hRand;
+uint64_t Token;
+void *pMap;
+struct statvfs ShmStat;
+
+Reset();
+if(pToken == NULL || pszName == NULL || NameLen < cBKSShmNameLen || NumSlots == 0 || SlotSize == 0 || SlotSize > 0x7fffffff)
+	return(false);
+SlotSize = (SlotSize + cBKSShmSlotAlign - 1) & ~(cBKSShmSlotAlign - 1);
+
+snprintf(m_szName,sizeof(m_szName),"/kit4bbks.%d.%u",(int)getpid(),__sync_fetch_and_add(&gBKSShmSegCnt,1));
+if((hShm = shm_open(m_szName,O_CREAT | O_EXCL | O_RDWR,0600)) == -1)
+	{
+	m_szName[0] = '\0';
+	return(false);
+	}
+m_bCreator = true;
+m_MapSize = (size_t)cBKSShmHdrSize + ((size_t)cBKSShmRingSize * 2) + ((size_t)NumSlots * SlotSize);
+
+// segment pages are only allocated when first touched, a segment larger than the free space in the shm filesystem would SIGBUS when the arena fills
+if(fstatvfs(hShm,&ShmStat) != 0 || ((size_t)ShmStat.f_bavail * ShmStat.f_frsize) < m_MapSize ||
+	ftruncate(hShm,m_MapSize) != 0 ||
+	(pMap = mmap(NULL,m_MapSize,PROT_READ | PROT_WRITE,MAP_SHARED,hShm,0)) == MAP_FAILED)
+	{
+	close(hShm);
+	Reset();
+	return(false);
+	}
+close(hShm);
+m_pHdr = (tsBKSShmHdr *)pMap;
+
+// token guards against a remote requester coincidentally mapping a same named segment on it's own host
+Token = 0;
+if((hRand = open("/dev/urandom",O_RDONLY)) != -1)
+	{
+	if(read(hRand,&Token,sizeof(Token)) != sizeof(Token))
+		Token = 0;
+	close(hRand);
+	}
+Token ^= ((uint64_t)time(NULL) << 32) ^ ((uint64_t)getpid() << 16) ^ (uint64_t)(size_t)pMap;
+
+memset(m_pHdr,0,cBKSShmHdrSize);
+m_pHdr->Token = Token;
+m_pHdr->RingSize = cBKSShmRingSize;
+m_pHdr->CreatorPID = (uint32_t)getpid();
+m_pHdr->NumSlots = NumSlots;
+m_pHdr->SlotSize = SlotSize;
+m_pHdr->Version = cBKSShmVersion;
+__sync_synchronize();
+m_pHdr->Magic = cBKSShmMagic;
+
+m_pTxRing = &m_pHdr->Rings[0];
+m_pRxRing = &m_pHdr->Rings[1];
+m_pTxData = (uint8_t *)pMap + cBKSShmHdrSize;
+m_pRxData = m_pTxData + cBKSShmRingSize;
+m_pSlots = m_pRxData + cBKSShmRingSize;
+m_NumSlots = NumSlots;
+m_SlotSize = SlotSize;
+*pToken = Token;
+strcpy(pszName,m_szName);
+return(true);
+#endif
+}
+
+bool
+CBKSShm::Open(char *pszName,		// segment name as offered by peer
+			 uint64_t Token)		// and token as offered by peer
+{
+#ifdef _WIN32
+return(false);
+#else
+int hShm;
+struct stat SegStat;
+void *pMap;
+
+Reset();
+if(pszName == NULL || pszName[0] != '/' || strnlen(pszName,cBKSShmNameLen) == cBKSShmNameLen)
+	return(false);
+if((hShm = shm_open(pszName,O_RDWR,0)) == -1)
+	return(false);
+if(fstat(hShm,&SegStat) != 0 || (size_t)SegStat.st_size <= (size_t)cBKSShmHdrSize + ((size_t)cBKSShmRingSize * 2))
+	{
+	close(hShm);
+	return(false);
+	}
+m_MapSize = (size_t)SegStat.st_size;
+if((pMap = mmap(NULL,m_MapSize,PROT_READ | PROT_WRITE,MAP_SHARED,hShm,0)) == MAP_FAILED)
+	{
+	close(hShm);
+	m_MapSize = 0;
+	return(false);
+	}
+close(hShm);
+m_pHdr = (tsBKSShmHdr *)pMap;
+if(m_pHdr->Magic != cBKSShmMagic || m_pHdr->Version != cBKSShmVersion ||
+	m_pHdr->RingSize != cBKSShmRingSize || m_pHdr->Token != Token ||
+	m_pHdr->NumSlots == 0 || m_pHdr->SlotSize == 0 || (m_pHdr->SlotSize & (cBKSShmSlotAlign - 1)) != 0 ||
+	m_MapSize != (size_t)cBKSShmHdrSize + ((size_t)cBKSShmRingSize * 2) + ((size_t)m_pHdr->NumSlots * m_pHdr->SlotSize))
+	{
+	Reset();
+	return(false);
+	}
+strcpy(m_szName,pszName);
+m_pTxRing = &m_pHdr->Rings[1];
+m_pRxRing = &m_pHdr->Rings[0];
+m_pRxData = (uint8_t *)pMap + cBKSShmHdrSize;
+m_pTxData = m_pRxData + cBKSShmRingSize;
+m_pSlots = m_pTxData + cBKSShmRingSize;
+m_NumSlots = m_pHdr->NumSlots;
+m_SlotSize = m_pHdr->SlotSize;
+return(true);
+#endif
+}
+
+void
+CBKSShm::Unlink(void)
+{
+#ifndef _WIN32
+if(m_bCreator && !m_bUnlinked && m_szName[0] != '\0')
+	shm_unlink(m_szName);
+#endif
+m_bUnlinked = true;
+}
+
+void
+CBKSShm::Doorbell(socket_t Socket)
+{
+#ifndef _WIN32
+uint8_t Bell = 0;
+// if the doorbell can't be sent because socket buffer is full then peer already has doorbells pending
+send(Socket,&Bell,1,MSG_DONTWAIT | MSG_NOSIGNAL);
+#endif
+}
+
+int
+CBKSShm::Send(socket_t Socket,			// doorbell peer on this socket
+			 uint8_t *pData,			// write from this buffer
+			 int Len)					// at most this many bytes
+{
+#ifdef _WIN32
+return(-1);
+#else
+uint64_t Head;
+uint64_t Tail;
+uint32_t Free;
+uint32_t Ofs;
+uint32_t Chunk;
+int Written;
+
+if(m_pHdr == NULL || pData == NULL || Len <= 0)
+	{
+	errno = EINVAL;
+	return(-1);
+	}
+
+Written = 0;
+while(Written < Len)
+	{
+	Head = m_pTxRing->Head;
+	Tail = m_pTxRing->Tail;
+	__sync_synchronize();				// consumer must have finished reading before ring space is reused
+	Free = cBKSShmRingSize - (uint32_t)(Head - Tail);
+	if(Free == 0)
+		{
+		// let consumer know a doorbell is wanted once it has read, then recheck in case consumer read before seeing the request
+		m_pTxRing->flgWriterWaiting = 1;
+		__sync_synchronize();
+		if(m_pTxRing->Tail != Tail)
+			continue;
+		break;
+		}
+	Chunk = min(Free,(uint32_t)(Len - Written));
+	Ofs = (uint32_t)(Head & (cBKSShmRingSize - 1));
+	if(Ofs + Chunk > cBKSShmRingSize)
+		{
+		memcpy(&m_pTxData[Ofs],&pData[Written],cBKSShmRingSize - Ofs);
+		memcpy(m_pTxData,&pData[Written + cBKSShmRingSize - Ofs],Chunk - (cBKSShmRingSize - Ofs));
+		}
+	else
+		memcpy(&m_pTxData[Ofs],&pData[Written],Chunk);
+	__sync_synchronize();				// data must be visible before consumer sees the updated head
+	m_pTxRing->Head = Head + Chunk;
+	Written += Chunk;
+	}
+
+if(Written == 0)
+	{
+	errno = EAGAIN;
+	return(-1);
+	}
+Doorbell(Socket);
+return(Written);
+#endif
+}
+
+int
+CBKSShm::Recv(socket_t Socket,			// drain any doorbells from peer on this socket
+			 uint8_t *pData,			// read into this buffer
+			 int Len)					// at most this many bytes
+{
+#ifdef _WIN32
+return(-1);
+#else
+uint8_t Bells[256];
+int BellsLen;
+uint64_t Head;
+uint64_t Tail;
+uint32_t Avail;
+uint32_t Ofs;
+uint32_t Chunk;
+
+if(m_pHdr == NULL || pData == NULL || Len <= 0)
+	{
+	errno = EINVAL;
+	return(-1);
+	}
+
+// doorbells are drained before reading the ring, any subsequent ring writes will be followed by a fresh doorbell
+do {
+	BellsLen = (int)recv(Socket,Bells,sizeof(Bells),MSG_DONTWAIT);
+	if(BellsLen == 0)				// socket closed by peer
+		return(0);
+	if(BellsLen == -1)
+		{
+		if(errno == EINTR)
+			continue;
+		if(errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+		return(-1);
+		}
+	}
+while(BellsLen == sizeof(Bells));
+
+Tail = m_pRxRing->Tail;
+Head = m_pRxRing->Head;
+__sync_synchronize();					// producer data must be visible before being read
+if((Avail = (uint32_t)(Head - Tail)) == 0)
+	{
+	errno = EAGAIN;
+	return(-1);
+	}
+Chunk = min(Avail,(uint32_t)Len);
+Ofs = (uint32_t)(Tail & (cBKSShmRingSize - 1));
+if(Ofs + Chunk > cBKSShmRingSize)
+	{
+	memcpy(pData,&m_pRxData[Ofs],cBKSShmRingSize - Ofs);
+	memcpy(&pData[cBKSShmRingSize - Ofs],m_pRxData,Chunk - (cBKSShmRingSize - Ofs));
+	}
+else
+	memcpy(pData,&m_pRxData[Ofs],Chunk);
+__sync_synchronize();					// finished reading before producer can reuse the space
+m_pRxRing->Tail = Tail + Chunk;
+__sync_synchronize();
+if(m_pRxRing->flgWriterWaiting)			// producer had found the ring full
+	{
+	m_pRxRing->flgWriterWaiting = 0;
+	Doorbell(Socket);
+	}
+return((int)Chunk);
+#endif
+}
+
+bool
+CBKSShm::RxPending(void)
+{
+if(m_pHdr == NULL)
+	return(false);
+return(m_pRxRing->Head != m_pRxRing->Tail ? true : false);
+}
+
+uint32_t
+CBKSShm::NumSlots(void)
+{
+return(m_NumSlots);
+}
+
+uint32_t
+CBKSShm::SlotSize(void)
+{
+return(m_SlotSize);
+}
+
+uint8_t *
+CBKSShm::Slot(uint32_t SlotID)			// slot identifiers are the requester's service instance identifiers, 1..NumSlots
+{
+if(m_pSlots == NULL || SlotID == 0 || SlotID > m_NumSlots)
+	return(NULL);
+return(&m_pSlots[(size_t)(SlotID - 1) * m_SlotSize]);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+// Shared memory transport between a service requester and a co-located (same host) service provider
+// Provider creates a shared memory segment containing a pair of single producer/single consumer byte rings, one for each direction, followed
+// by an arena of payload slots, one slot for each offered service instance, and offers the segment name plus a random token in it's
+// eBKSHdrOfferedService frame. If the requester is able to map the named segment, and the token matches, then the requester accepts the shared
+// memory transport in it's eBKSHdrAcceptService frame and from then on all frames are exchanged through the rings.
+// Request parameters and sequences are written by the requester directly into the slot of the requester's service instance and the request
+// frame only carries the header, the provider's worker reads the probe and target sequences in place from the slot and writes it's response
+// back into that same slot. A slot is owned by the requester from job submission until the request frame is sent, by the provider until it's
+// response frame is sent, and then again by the requester until the response has been retrieved.
+// The session socket is retained and only carries single byte doorbells notifying the peer that a ring has been
+// written to, or that space has become available in a previously full ring, so epoll/select and connection loss detection are unchanged
+// Currently only supported on linux, on windows the provider never offers a shared memory transport
+
+const uint32_t cBKSShmMagic = 0x6b534b42;			// shared memory segment header magic ('BKSk')
+const uint32_t cBKSShmVersion = 2;					// shared memory segment layout version, version 2 added the payload slot arena
+const uint32_t cBKSShmRingSize = 0x0100000;			// each direction ring can buffer at most this many bytes (1MB), must be a power of 2, rings only carry frame headers and control frames
+const uint32_t cBKSShmHdrSize = 0x01000;			// ring data starts at this offset into segment
+const uint32_t cBKSShmSlotAlign = 0x01000;			// slot sizes are rounded up to a multiple of this many bytes so slots are page aligned
+
+#pragma pack(8)
+typedef struct TAG_sBKSShmRing {
+	volatile uint64_t Head;					// total number of bytes written into ring by producer
+	uint8_t Pad1[56];						// producer and consumer indexes are on separate cache lines
+	volatile uint64_t Tail;					// total number of bytes read from ring by consumer
+	volatile uint32_t flgWriterWaiting;		// set by producer if ring was full, consumer to send a doorbell after next read
+	uint8_t Pad2[52];
+} tsBKSShmRing;
+
+typedef struct TAG_sBKSShmHdr {
+	uint32_t Magic;							// always cBKSShmMagic
+	uint32_t Version;						// segment layout version, cBKSShmVersion
+	uint64_t Token;							// random token which must match that offered by provider
+	uint32_t RingSize;						// size of each ring
+	uint32_t CreatorPID;					// process identifier of segment creator
+	uint32_t NumSlots;						// arena following the rings contains this many payload slots
+	uint32_t SlotSize;						// each payload slot is this size in bytes
+	uint8_t Pad[32];
+	tsBKSShmRing Rings[2];					// Rings[0] is creator (provider) to opener (requester), Rings[1] is opener to creator
+} tsBKSShmHdr;
+#pragma pack()
+
+class CBKSShm
+{
+	char m_szName[cBKSShmNameLen];			// segment name
+	bool m_bCreator;						// true if this instance created the segment
+	bool m_bUnlinked;						// true if segment name has been removed
+	size_t m_MapSize;						// mapped segment size
+	tsBKSShmHdr *m_pHdr;					// mapped segment
+	tsBKSShmRing *m_pTxRing;				// writing into this ring
+	uint8_t *m_pTxData;						// ring data
+	tsBKSShmRing *m_pRxRing;				// reading from this ring
+	uint8_t *m_pRxData;						// ring data
+	uint8_t *m_pSlots;						// payload slot arena
+	uint32_t m_NumSlots;					// arena contains this many slots
+	uint32_t m_SlotSize;					// each slot is this size
+
+	void Doorbell(socket_t Socket);			// notify peer of ring activity
+
+public:
+	CBKSShm(void);
+	~CBKSShm(void);
+
+	void Reset(void);						// unmap segment, and if creator then remove segment name if not already removed
+
+	static bool IsColocated(socket_t Socket);	// returns true if connected socket peer is on this host
+
+	bool											// true if segment created and mapped
+		Create(uint64_t *pToken,					// returned random token to be passed to peer along with segment name
+			   int NameLen,							// pszName can hold at most this many chars including terminating '\0'
+			   char *pszName,						// returned segment name
+			   uint32_t NumSlots,					// arena to hold this many payload slots, one for each service instance
+			   uint32_t SlotSize);					// each slot to hold a payload of at least this size
+
+	bool											// true if segment mapped and token matched
+		Open(char *pszName,							// segment name as offered by peer
+			 uint64_t Token);						// and token as offered by peer
+
+	void Unlink(void);						// remove segment name once both peers have mapped the segment
+
+	int										// bytes written into ring, -1 if ring full (errno set to EAGAIN) or socket errors
+		Send(socket_t Socket,				// doorbell peer on this socket
+			 uint8_t *pData,				// write from this buffer
+			 int Len);						// at most this many bytes
+
+	int										// bytes read from ring, 0 if socket was closed by peer, -1 if ring empty (errno set to EAGAIN) or socket errors
+		Recv(socket_t Socket,				// drain any doorbells from peer on this socket
+			 uint8_t *pData,				// read into this buffer
+			 int Len);						// at most this many bytes
+
+	bool RxPending(void);					// returns true if unread bytes remain in the receive ring
+
+	uint32_t NumSlots(void);				// number of payload slots in arena
+	uint32_t SlotSize(void);				// size of each payload slot
+	uint8_t *Slot(uint32_t SlotID);			// returns ptr to payload slot SlotID (1..NumSlots), NULL if SlotID out of range
+};
@@ -1,7 +1,11 @@
 #pragma once
 
 #ifndef cMaxConcurrentSessions
+#ifdef _WIN32
 #define cMaxConcurrentSessions 100			// on windows, by default a max of 64 sockets are supported in FD_SET/FD_CLR and select(), 2 covers the listening and control sockets
+#else
+#define cMaxConcurrentSessions 500			// on linux sessions are multiplexed with edge triggered epoll, internally restricted to a maximum of 511
+#endif
 #endif	
 
 #ifdef _WIN32
@@ -10,8 +14,12 @@
 #define socket_t int
 #endif
 
-const uint32_t cMinProviderVersion = 1;			// service provider versions must be at least this software version
-const uint32_t cMaxProviderVersion = 1;			// service provider version must be no more than this software version
+const uint32_t cMinProviderVersion = 3;			// service provider versions must be at least this software version (version 2 added batched SW alignment requests, version 3 shared memory transport)
+const uint32_t cMaxProviderVersion = 3;			// service provider version must be no more than this software version
+
+const int cMaxEpollEvents = 128;				// on linux, at most this many socket events are returned by each epoll_wait()
+const int cBKSShmNameLen = 64;					// co-located provider shared memory segment names, including terminating '\0', are at most this length
+const uint8_t cBKSFrameFlgShmSlot = 0x01;		// request or response payload is in place in the requester instance's shared memory slot, frame carries only the header
 
 const uint32_t cMaxHostNameLen = 80;			   // host names will be truncated to this maximal length
 const uint32_t cMaxServiceNameLen = 80;		   // service names will be truncated to this maximal length
@@ -94,7 +102,7 @@ typedef struct TAG_sBKSPacHdr {
 	uint32_t SessionID;				// server assigned and is uniquely identifying this session between service requester and provider, will be in the range 1..131071
 	uint8_t TxFrameID;				// senders frame header identifier, monotonically incremented starting from 1 to 127 with wraparound back to 1
 	uint8_t RxFrameID;				// senders last received and processed frame header identifier from current session peer, 0 if yet to receive any
-	uint8_t FrameFlags;				// frame header flags, currently unused
+	uint8_t FrameFlags;				// frame header flags, cBKSFrameFlgShmSlot
 	uint8_t FrameType;				// one of teBKSHdrType header types, specifies the payload type
 } tsBKSPacHdr;
  
@@ -134,6 +142,8 @@ typedef struct TAG_sBKSOfferedService
 	uint32_t ClassInsts;					// with this many instantiated class instances
 	uint32_t Costing;						// provision of instances has an associated cost - provider may be a low resourced node so cost may be high 
 	uint32_t ProviderVersion;				// service provider software is at this version
+	uint64_t ShmToken;					// token to be matched in shared memory segment header
+	char szShmName[cBKSShmNameLen];		// if provider is co-located then shared memory segment offered as transport, '\0' if none offered
 	} tsBKSOfferedService;
 
 // in final negotiation phase server sends acceptance packet (eBKSHdrAcceptService) or rejection packet (eBKSHdrRejectService) 
@@ -141,6 +151,7 @@ typedef struct TAG_sBKSAcceptService
 	{
 		tsBKSPacHdr Hdr;				// frame header (eBKSHdrAcceptService or eBKSHdrRejectService)
 		teBKSPType BKSPType;			// confirmation of service type being accepted, or eBKSPTUndefined if offered type rejected
+		uint8_t flgShmAccepted;			// 1 if offered shared memory transport accepted and all subsequent frames are to be exchanged through it
 		} tsBKSAcceptService;
 
 
@@ -39,6 +39,12 @@ Original 'BioKanga' copyright notice has been retained and is as follows.
 #include "SSW.h"
 #include "MAConsensus.h"
 
+// work pool thread function, context is the CMAConsensus instance
+static int MAConsensusCols(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CMAConsensus *)pCtx)->ConsensusCols(StartIdx, EndIdx, WorkerIdx));
+}
+
 
 CMAConsensus::CMAConsensus()
 {
@@ -290,61 +296,51 @@ return(eBSFSuccess);
 
 // generate multiple alignment consensus from multialignment columns at m_pMACols
 // writes consensus base back into m_pMACols
+// consensus for each column is independent of all other columns, and of column ordering, so the allocated columns are simply partitioned by
+// column range over the work pool rather than following the per reference sequence column linkages
+int
+CMAConsensus::GenMultialignConcensus(int NumThreads)	// use at most this many threads
+{
+CWorkPool *pWorkPool;
+
+if(!m_bStartedMultiAlignments || m_MACurCols == 0)
+	return(0);
+
+if(NumThreads > 1 && m_MACurCols > (uint64_t)cMAConsChunkCols && (pWorkPool = CWorkPool::Shared(NumThreads)) != NULL)
+	return(pWorkPool->ParallelFor((int64_t)m_MACurCols,cMAConsChunkCols,MAConsensusCols,this,60,"Progress: generating multialignment consensus",NULL,NULL,NumThreads));
+
+return(ConsensusCols(0,(int64_t)m_MACurCols,0));
+}
+
+// generate consensus for columns m_pMACols[StartIdx..EndIdx-1]
+// simply choosing the most abundant base as being the consensus, if equally abundant then the lowest indexed base is chosen
 int
-CMAConsensus::GenMultialignConcensus(void)
+CMAConsensus::ConsensusCols(int64_t StartIdx,		// starting from this column index
+							int64_t EndIdx,			// until immediately before this column index
+							int WorkerIdx)			// processing by this worker
 {
-int BaseCnts[eBaseInDel+1];
-int AbundIdxs[eBaseInDel+1];
-int *pCnts;
-int *pNxtCnts;
-int XAbundIdxs;
-int TotBaseCnts;
+uint32_t MaxBaseCnt;
 uint32_t *pBaseCnts;
 int BaseIdx;
+int AbundIdx;
 tsMAlignConCol *pCol;
 
-if(!m_bStartedMultiAlignments)
-	return(0);
-
-pCol = (tsMAlignConCol *)m_pMACols;
-do
+pCol = &m_pMACols[StartIdx];
+for(; StartIdx < EndIdx; StartIdx++, pCol++)
 	{
-	memset(BaseCnts,0,sizeof(BaseCnts));
-	TotBaseCnts = 0;
 	pBaseCnts = pCol->BaseCnts;
-	for(BaseIdx = 0; BaseIdx <= eBaseInDel; BaseIdx++,pBaseCnts++)
+	AbundIdx = 0;
+	MaxBaseCnt = *pBaseCnts++;
+	for(BaseIdx = 1; BaseIdx <= eBaseInDel; BaseIdx++,pBaseCnts++)
 		{
-		BaseCnts[BaseIdx] = *pBaseCnts;
-		TotBaseCnts += *pBaseCnts;
-		}
-
-	// order base counts by counts descending
-	for(BaseIdx = 0; BaseIdx <= eBaseInDel; BaseIdx++)
-		AbundIdxs[BaseIdx] = BaseIdx;
-	do {
-		XAbundIdxs = -1;
-		for(BaseIdx = 0; BaseIdx < eBaseInDel; BaseIdx++)
+		if(*pBaseCnts > MaxBaseCnt)
 			{
-			pCnts = &BaseCnts[AbundIdxs[BaseIdx]];
-			pNxtCnts = &BaseCnts[AbundIdxs[BaseIdx+1]];
-			if(*pCnts < *pNxtCnts)
-				{
-				XAbundIdxs = AbundIdxs[BaseIdx];
-				AbundIdxs[BaseIdx] = AbundIdxs[BaseIdx+1];
-				AbundIdxs[BaseIdx+1] = XAbundIdxs; 
-				}
+			MaxBaseCnt = *pBaseCnts;
+			AbundIdx = BaseIdx;
 			}
 		}
-	while(XAbundIdxs != -1);
-
-	// simply choosing the most abundant base (could be equally abundant!) as being the consensus
-	pCol->ConsBase = AbundIdxs[0] < eBaseInDel ? AbundIdxs[0] : eBaseUndef;
-	if(pCol->NxtColIdx == 0)
-		pCol = NULL;
-	else
-		pCol = &m_pMACols[pCol->NxtColIdx - 1];
+	pCol->ConsBase = AbundIdx < eBaseInDel ? AbundIdx : eBaseUndef;
 	}
-while(pCol != NULL);
 return(eBSFSuccess);
 }
 
@@ -376,7 +372,7 @@ if(m_MACurCols + 10 >= m_AllocMACols)			// need to extend previously allocated c
 		return(NULL);
 		}
 	m_pMACols = (tsMAlignConCol *)pAllocd;
-	memset(&m_pMACols[m_AllocMAColsSize],0,memreq - m_AllocMAColsSize);
+	memset((uint8_t *)m_pMACols + m_AllocMAColsSize,0,memreq - m_AllocMAColsSize);
 	m_AllocMACols = AllocMACols;
 	m_AllocMAColsSize = memreq;
 	}
@@ -5,6 +5,7 @@ const uint32_t cMaxNumRefSeqs = 0x0ffffff;		// can process up to this many refer
 const uint64_t cMaxTotRefSeqLens = 0x07ffffffff;	// which total in length to no more than this many bases (28Gbp)
 const uint32_t cMinRefSeqLen = 100;				// only accepting individual reference sequences of at least this length (100bp)
 const uint32_t cMaxRefSeqLen = 0x00fffffff;		// only accepting individual reference sequences no longer than this length (256Mbp)
+const int64_t cMAConsChunkCols = 0x010000;		// when generating consensus in parallel then columns are partitioned into chunks of this many columns
 
 #pragma pack(1)
 
@@ -74,7 +75,7 @@ public:
 					  uint32_t NumMAAlignOps,			// number of alignment operators
 					   tMAOp *pMAAlignOps);			// alignment operators
 
-	int	GenMultialignConcensus(void);          // generate multiple alignment consensus over all multialignment columns at m_pMACols
+	int	GenMultialignConcensus(int NumThreads = 1);	// generate multiple alignment consensus over all multialignment columns at m_pMACols using at most this many threads
 
 	int											// number of bases in consensus 
 		GetConsensus(uint32_t RefSeqID);			// for this reference sequence identifier
@@ -85,5 +86,7 @@ public:
 						uint32_t RefLen,			// return at most this many bases
 						etSeqBase *pRetBases);  // where to return bases
 
+	// work pool processing, public only so accessible to the pool thread function
+	int ConsensusCols(int64_t StartIdx, int64_t EndIdx, int WorkerIdx);	// generate consensus for columns m_pMACols[StartIdx..EndIdx-1]
 };
 
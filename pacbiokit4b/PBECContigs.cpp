@@ -1413,7 +1413,7 @@ else
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Initiating error correction ...");
 Rslt = InitiateECContigs(NumThreads);
 gDiagnostics.DiagOut(eDLInfo,gszProcName,"Completed error correction");
-m_pMAConsensus->GenMultialignConcensus();
+m_pMAConsensus->GenMultialignConcensus(NumThreads);
 
 if(m_hErrCorFile != -1)
 	{
@@ -1428,7 +1428,6 @@ if(m_hErrCorFile != -1)
 	AllocdConsensusSeqSize = 0;
 	LineBuffIdx = 0;
 	pConsensusSeq = NULL;
-	m_pMAConsensus->GenMultialignConcensus();
 	pCurPBScaffNode = m_pPBScaffNodes;
 	for(CurNodeID = 1; CurNodeID <= NumTargSeqs; CurNodeID++,pCurPBScaffNode++)
 		{
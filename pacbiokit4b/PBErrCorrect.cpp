@@ -22,13 +22,13 @@ Original 'BioKanga' copyright notice has been retained and is as follows.
  */
 #include "stdafx.h"
 // Supporting at most this many concurrent TCP sessions between service requester (this server) and all service providers
-// this could be increased to an internally restricted maximum of 511 but there could then be a significant performance throughput degradation
-// because of the use of select() instead of ePoll or derivatives.
+// On windows this could be increased to an internally restricted maximum of 511 but there could then be a significant performance throughput degradation
+// because of the use of select(), on linux sessions are multiplexed with edge triggered epoll and up to 500 sessions are supported.
 // It is essential that there is consistency between the various source files in the cMaxConcurrentSessions value
 #ifdef WIN32
 #define cMaxConcurrentSessions 100                     // limit to less than 511
 #else
-#define cMaxConcurrentSessions 100
+#define cMaxConcurrentSessions 500
 #endif
 
 #ifdef HAVE_CONFIG_H
@@ -84,6 +84,8 @@ ProcPacBioErrCorrect(etPBPMode PMode,		// processing mode
 		int MaxSeedCoreDepth,		// only further process a seed core if there are no more than this number of matching cores in all targeted sequences
 		int MinSeedCoreLen,			// use seed cores of this length when identifying putative overlapping scaffold sequences
 		int MinNumSeedCores,        // require at least this many seed cores between overlapping scaffold sequences
+		int MinMzShared,			// if > 0 then prefilter putative overlaps with minimizer sketch, requiring at least this many shared diagonally consistent minimizers
+		int SWBandWidth,			// if > 0 then SW alignments are banded to this many bp either side of the core hit diagonals
 		int SWMatchScore,			// score for matching bases (0..50)
 		int SWMismatchPenalty,		// mismatch penalty (-50..0)
 		int SWGapOpenPenalty,		// gap opening penalty (-50..0)
@@ -135,6 +137,8 @@ bool bSenseOnlyOvlps;		// process for sense only overlaps (default is for sense/
 int FiltMinHomoLen;			// filter PacBio reads for homopolymer runs >= this length (0 to disable filtering) 
 int MinSeedCoreLen;			// use seed cores of this length when identifying putative overlapping sequences
 int MinNumSeedCores;        // require at least this many seed cores between overlapping sequences before attempting SW
+int MinMzShared;			// if > 0 then prefilter putative overlaps with minimizer sketch, requiring at least this many shared diagonally consistent minimizers
+int SWBandWidth;			// if > 0 then SW alignments are banded to this many bp either side of the core hit diagonals
 int DeltaCoreOfs;			// offset by this many bp the core windows of coreSeqLen along the probe sequence when checking for overlaps
 int MaxSeedCoreDepth;		// only further process a seed core if there are no more than this number of matching cores in all targeted sequences
 
@@ -214,6 +218,8 @@ struct arg_int *minfilthomolen = arg_int0("H","minfilthomolen","<int>",			"filte
 
 struct arg_int *minseedcorelen = arg_int0("c","seedcorelen","<int>",			"use seed cores of this length when identifying putative overlapping sequences (default 16, range 12 to 50)");
 struct arg_int *minseedcores = arg_int0("C","minseedcores","<int>",				"require at least this many accepted seed cores between overlapping sequences to use SW (default 20, range 1 to 50)");
+struct arg_int *mzsketch = arg_int0(NULL,"mzsketch","<int>",					"prefilter putative overlaps with a minimizer sketch, requiring at least this many shared minimizers on a consistent diagonal band (default 0 to disable, range 2 to 1000)");
+struct arg_int *swband = arg_int0(NULL,"swband","<int>",						"band SW alignments to this many bp either side of the core hit diagonals (default 0 to disable, range 50 to 5000)");
 
 struct arg_int *deltacoreofs = arg_int0("d","deltacoreofs","<int>",				"offset cores (default 2, range 1 to 25)");
 struct arg_int *maxcoredepth = arg_int0("D","maxcoredepth","<int>",				"explore cores of less than this maximum depth (default 5000, range 1000 to 50000)");
@@ -251,7 +257,7 @@ struct arg_str *experimentdescr = arg_str0("W","experimentdescr","<str>",	"exper
 struct arg_end *end = arg_end(200);
 
 void *argtable[] = {help,version,FileLogLevel,LogFile,
-					pmode,rmihost,rmiservice,maxnonrmi,maxrmi,minfilthomolen,senseonlyovlps,minseedcorelen,minseedcores,deltacoreofs,maxcoredepth,
+					pmode,rmihost,rmiservice,maxnonrmi,maxrmi,minfilthomolen,senseonlyovlps,minseedcorelen,minseedcores,mzsketch,swband,deltacoreofs,maxcoredepth,
 					matchscore,mismatchpenalty,gapopenpenalty,gapextnpenalty,progextnpenaltylen,
 					transcriptomelens, minpbseqlen,maxpbseqlen,minpbseqovl,minhcseqlen,minhcseqovl,hcrelweighting,minconcscore,minerrcorrectlen,maxartefactdev,
 					summrslts,pacbiofiles,hiconffiles,experimentname,experimentdescr,
@@ -403,6 +409,8 @@ if (!argerrors)
 	bSenseOnlyOvlps = false;
 	MinSeedCoreLen = cDfltSeedCoreLen;
 	MinNumSeedCores = cDfltNumSeedCores;
+	MinMzShared = 0;
+	SWBandWidth = 0;
 	DeltaCoreOfs = cDfltDeltaCoreOfs;
 	MaxSeedCoreDepth = cDfltMaxSeedCoreDepth;
 	SWMatchScore = cDfltSWMatchScore;
@@ -499,6 +507,20 @@ if (!argerrors)
 			return(1);
 			}
 
+		MinMzShared = mzsketch->count ? mzsketch->ival[0] : 0;
+		if(MinMzShared != 0 && (MinMzShared < cMinMzSketchShared || MinMzShared > cMaxMzSketchShared))
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Minimizer sketch shared minimizers '--mzsketch=%d' must be either 0 to disable or in range %d..%d",MinMzShared,cMinMzSketchShared,cMaxMzSketchShared);
+			return(1);
+			}
+
+		SWBandWidth = swband->count ? swband->ival[0] : 0;
+		if(SWBandWidth != 0 && (SWBandWidth < cSSWMinBandWidth || SWBandWidth > cSSWMaxBandWidth))
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: SW alignment band width '--swband=%d' must be either 0 to disable or in range %d..%d",SWBandWidth,cSSWMinBandWidth,cSSWMaxBandWidth);
+			return(1);
+			}
+
 		if(PMode == ePBPMErrCorrect)		
 			DeltaCoreOfs = deltacoreofs->count ? deltacoreofs->ival[0] : cDfltDeltaCoreOfs;
 		else
@@ -842,6 +864,20 @@ if (!argerrors)
 			return(1);
 			}
 
+		MinMzShared = mzsketch->count ? mzsketch->ival[0] : 0;
+		if(MinMzShared != 0 && (MinMzShared < cMinMzSketchShared || MinMzShared > cMaxMzSketchShared))
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: Minimizer sketch shared minimizers '--mzsketch=%d' must be either 0 to disable or in range %d..%d",MinMzShared,cMinMzSketchShared,cMaxMzSketchShared);
+			return(1);
+			}
+
+		SWBandWidth = swband->count ? swband->ival[0] : 0;
+		if(SWBandWidth != 0 && (SWBandWidth < cSSWMinBandWidth || SWBandWidth > cSSWMaxBandWidth))
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"Error: SW alignment band width '--swband=%d' must be either 0 to disable or in range %d..%d",SWBandWidth,cSSWMinBandWidth,cSSWMaxBandWidth);
+			return(1);
+			}
+
 		DeltaCoreOfs = deltacoreofs->count ? deltacoreofs->ival[0] : 10;
 		if(DeltaCoreOfs < 1 || DeltaCoreOfs > cMaxDeltaCoreOfs)
 			{
@@ -1109,6 +1145,14 @@ if (!argerrors)
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Overlap processing: '%s'",bSenseOnlyOvlps ? "Sense only" : "Sense and antisense");
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Use seed cores of this length when identifying putative overlapping sequences: %dbp",MinSeedCoreLen);
 		gDiagnostics.DiagOutMsgOnly(eDLInfo,"Require at least this many seed cores between overlapping sequences: %d",MinNumSeedCores);
+		if(MinMzShared > 0)
+			gDiagnostics.DiagOutMsgOnly(eDLInfo,"Prefilter putative overlaps with minimizer sketch requiring at least this many shared minimizers: %d",MinMzShared);
+		else
+			gDiagnostics.DiagOutMsgOnly(eDLInfo,"Prefilter putative overlaps with minimizer sketch: No prefiltering");
+		if(SWBandWidth > 0)
+			gDiagnostics.DiagOutMsgOnly(eDLInfo,"Band SW alignments to this many bp either side of the core hit diagonals: %dbp",SWBandWidth);
+		else
+			gDiagnostics.DiagOutMsgOnly(eDLInfo,"Band SW alignments: No banding");
 
 		if(PMode == ePBPMErrCorrect)
 			{
@@ -1221,6 +1265,8 @@ if (!argerrors)
 		ParamID = gSQLiteSummaries.AddParameter(gProcessingID,ePTInt32,(int)sizeof(MinNumSeedCores),"minseedcores",&MinNumSeedCores);
 
 		ParamID = gSQLiteSummaries.AddParameter(gProcessingID,ePTInt32,(int)sizeof(MaxSeedCoreDepth),"maxcoredepth",&MaxSeedCoreDepth);
+		ParamID = gSQLiteSummaries.AddParameter(gProcessingID,ePTInt32,(int)sizeof(MinMzShared),"mzsketch",&MinMzShared);
+		ParamID = gSQLiteSummaries.AddParameter(gProcessingID,ePTInt32,(int)sizeof(SWBandWidth),"swband",&SWBandWidth);
 		ParamID = gSQLiteSummaries.AddParameter(gProcessingID,ePTInt32,(int)sizeof(MinSeedCoreLen),"seedcorelen",&MinSeedCoreLen);
 		ParamID = gSQLiteSummaries.AddParameter(gProcessingID,ePTInt32,(int)sizeof(MinNumSeedCores),"minseedcores",&MinNumSeedCores);
 		ParamID = gSQLiteSummaries.AddParameter(gProcessingID,ePTInt32,(int)sizeof(DeltaCoreOfs),"deltacoreofs",&DeltaCoreOfs);
@@ -1284,7 +1330,7 @@ if (!argerrors)
 	SetPriorityClass(GetCurrentProcess(), BELOW_NORMAL_PRIORITY_CLASS);
 #endif
 	gStopWatch.Start();
-	Rslt = ProcPacBioErrCorrect((etPBPMode)PMode,szHostName,szServiceName,MaxRMI,MaxNonRMI,SampleInRate,SampleAcceptRate,FiltMinHomoLen,bSenseOnlyOvlps,DeltaCoreOfs,MaxSeedCoreDepth,MinSeedCoreLen,MinNumSeedCores,SWMatchScore,-1 * SWMismatchPenalty,-1 * SWGapOpenPenalty,-1 * SWGapExtnPenalty,SWProgExtnPenaltyLen,
+	Rslt = ProcPacBioErrCorrect((etPBPMode)PMode,szHostName,szServiceName,MaxRMI,MaxNonRMI,SampleInRate,SampleAcceptRate,FiltMinHomoLen,bSenseOnlyOvlps,DeltaCoreOfs,MaxSeedCoreDepth,MinSeedCoreLen,MinNumSeedCores,MinMzShared,SWBandWidth,SWMatchScore,-1 * SWMismatchPenalty,-1 * SWGapOpenPenalty,-1 * SWGapExtnPenalty,SWProgExtnPenaltyLen,
 								TranscriptomeLens,NumAdapterSeqs,pszAdapterSeqs,MinPBSeqLen, MaxPBSeqLen,MinPBSeqOverlap,MaxArtefactDev,MinHCSeqLen,MinHCSeqOverlap,HCRelWeighting,MinErrCorrectLen,MinConcScore,
 								NumPacBioFiles,pszPacBioFiles,NumHiConfFiles,pszHiConfFiles,szOutFile,szOutMAFile,szChkPtsFile,NumThreads);
 	Rslt = Rslt >=0 ? 0 : 1;
@@ -1324,6 +1370,8 @@ ProcPacBioErrCorrect(etPBPMode PMode,		// processing mode
 		int MaxSeedCoreDepth,		// only further process a seed core if there are no more than this number of matching cores in all targeted sequences
 		int MinSeedCoreLen,			// use seed cores of this length when identifying putative overlapping scaffold sequences
 		int MinNumSeedCores,        // require at least this many seed cores between overlapping scaffold sequences
+		int MinMzShared,			// if > 0 then prefilter putative overlaps with minimizer sketch, requiring at least this many shared diagonally consistent minimizers
+		int SWBandWidth,			// if > 0 then SW alignments are banded to this many bp either side of the core hit diagonals
 		int SWMatchScore,			// score for matching bases (0..50)
 		int SWMismatchPenalty,		// mismatch penalty (-50..0)
 		int SWGapOpenPenalty,		// gap opening penalty (-50..0)
@@ -1359,7 +1407,7 @@ if((pPBErrCorrect = new CPBErrCorrect)==NULL)
 	return(eBSFerrObj);
 	}
 
-Rslt = pPBErrCorrect->Process(PMode,pszHostName,pszServiceName,MaxRMI,MaxNonRMI,SampleInRate,SampleAcceptRate,FiltMinHomoLen,bSenseOnlyOvlps,DeltaCoreOfs,MaxSeedCoreDepth,MinSeedCoreLen,MinNumSeedCores,SWMatchScore,SWMismatchPenalty,SWGapOpenPenalty,SWGapExtnPenalty,SWProgExtnPenaltyLen,
+Rslt = pPBErrCorrect->Process(PMode,pszHostName,pszServiceName,MaxRMI,MaxNonRMI,SampleInRate,SampleAcceptRate,FiltMinHomoLen,bSenseOnlyOvlps,DeltaCoreOfs,MaxSeedCoreDepth,MinSeedCoreLen,MinNumSeedCores,MinMzShared,SWBandWidth,SWMatchScore,SWMismatchPenalty,SWGapOpenPenalty,SWGapExtnPenalty,SWProgExtnPenaltyLen,
 								TranscriptomeLens,NumAdapterSeqs,pszAdapterSeqs,MinPBSeqLen, MaxPBSeqLen, MinPBSeqOverlap,MaxArtefactDev,MinHCSeqLen,MinHCSeqOverlap,HCRelWeighting,MinErrCorrectLen,MinConcScore,
 								NumPacBioFiles,pszPacBioFiles,NumHiConfFiles,pszHiConfFiles,pszOutFile,pszOutMAFile,pszChkPtsFile,NumThreads);
 delete pPBErrCorrect;
@@ -1369,6 +1417,7 @@ return(Rslt);
 CPBErrCorrect::CPBErrCorrect() // relies on base classes constructors
 {
 m_pSfxArray = NULL;
+m_pMzIdx = NULL;
 m_pPBScaffNodes = NULL;
 m_pMapEntryID2NodeIDs = NULL;
 m_pRequester = NULL;
@@ -1389,6 +1438,11 @@ Reset();
 void
 CPBErrCorrect::Init(void)
 {
+if(m_pMzIdx != NULL)
+	{
+	delete m_pMzIdx;
+	m_pMzIdx = NULL;
+	}
 if(m_pSfxArray != NULL)
 	{
 	delete m_pSfxArray;
@@ -1491,6 +1545,8 @@ m_DeltaCoreOfs = cDfltDeltaCoreOfs;
 m_MaxSeedCoreDepth = cDfltMaxSeedCoreDepth;
 m_MinSeedCoreLen = cDfltSeedCoreLen;
 m_MinNumSeedCores = cDfltNumSeedCores;
+m_MinMzShared = 0;
+m_SWBandWidth = 0;
 
 m_SWMatchScore = cDfltSWMatchScore;
 m_SWMismatchPenalty = cDfltSWMismatchPenalty;	
@@ -2365,11 +2421,12 @@ int
 CPBErrCorrect::GenConsensusFromMAF(int MinErrCorrectLen,		// error corrected sequences must be at least this minimum length
 			 int MinConcScore,			// error corrected sequences trimmed until mean 50bp concensus score is at least this threshold
 			char *pszErrCorFile,		// name of file into which write error corrected sequences
-			char *pszMultiAlignFile)	// name of file containing multiple alignments to process
+			char *pszMultiAlignFile,	// name of file containing multiple alignments to process
+			int NumThreads)				// maximum number of worker threads to use
 {
 int Rslt;
 CSSW SSW;
-Rslt = SSW.GenConsensusFromMAF(MinErrCorrectLen,MinConcScore,pszErrCorFile,pszMultiAlignFile);
+Rslt = SSW.GenConsensusFromMAF(MinErrCorrectLen,MinConcScore,pszErrCorFile,pszMultiAlignFile,NumThreads);
 SSW.Reset();
 return(Rslt);
 }
@@ -2552,6 +2609,8 @@ CPBErrCorrect::Process(etPBPMode PMode,		// processing mode
 		int MaxSeedCoreDepth,		// only further process a seed core if there are no more than this number of matching cores in all targeted sequences
 		int MinSeedCoreLen,			// use seed cores of this length when identifying putative overlapping scaffold sequences
 		int MinNumSeedCores,        // require at least this many seed cores between overlapping scaffold sequences
+		int MinMzShared,			// if > 0 then prefilter putative overlaps with minimizer sketch, requiring at least this many shared diagonally consistent minimizers
+		int SWBandWidth,			// if > 0 then SW alignments are banded to this many bp either side of the core hit diagonals
 		int SWMatchScore,			// score for matching bases (0..50)
 		int SWMismatchPenalty,		// mismatch penalty (-50..0)
 		int SWGapOpenPenalty,		// gap opening penalty (-50..0)
@@ -2641,6 +2700,8 @@ m_DeltaCoreOfs = DeltaCoreOfs;
 m_MaxSeedCoreDepth = MaxSeedCoreDepth;
 m_MinSeedCoreLen = MinSeedCoreLen;
 m_MinNumSeedCores = MinNumSeedCores;
+m_MinMzShared = MinMzShared;
+m_SWBandWidth = SWBandWidth;
 
 m_MinPBSeqLen = MinPBSeqLen;	
 m_MaxPBRdSeqLen = MaxPBSeqLen;
@@ -2672,7 +2733,7 @@ switch(PMode) {
 		break;
 
 	case ePBPMConsensus:
-		Rslt = GenConsensusFromMAF(MinErrCorrectLen,MinConcScore,pszErrCorFile,pszPacBioFiles[0]);
+		Rslt = GenConsensusFromMAF(MinErrCorrectLen,MinConcScore,pszErrCorFile,pszPacBioFiles[0],NumThreads);
 		Reset();
 		return(Rslt);
 
@@ -2875,6 +2936,23 @@ if(MinSeedCoreLen <= cMaxKmerLen)
 	gDiagnostics.DiagOut(eDLInfo,gszProcName,"Initialised for over occurring K-mers");
 	}
 
+// minimizer sketch is sampled with k-mers of the seed core length (clamped to the sketch maximum) over windows of the core offset
+if(m_MinMzShared > 0)
+	{
+	if((m_pMzIdx = new CMinimizerIdx) == NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to instantiate CMinimizerIdx");
+		Reset();
+		return(eBSFerrObj);
+		}
+	if((Rslt = m_pMzIdx->Open(m_pSfxArray,NULL,min(MinSeedCoreLen,cMaxMzIdxKMerLen),max(cMinMzIdxWinLen,min((int)m_DeltaCoreOfs,cMaxMzIdxWinLen)),m_MaxSeedCoreDepth,NumThreads)) != eBSFSuccess)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Failed to build minimizer sketch");
+		Reset();
+		return(Rslt);
+		}
+	}
+
 if((m_pPBScaffNodes = new tsPBEScaffNode [NumTargSeqs + 1]) == NULL)
 	{
 	gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to allocate for %d nodes",NumTargSeqs);
@@ -3325,6 +3403,21 @@ pthread_exit(&pPars->Rslt);
 #endif
 }
 
+// called by work pool threads when overlaps are being identified without RMI, each item is a batch of reads processed using the pool worker's overlap parameters
+static int
+PBErrCorrectChunk(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+tsThreadPBErrCorrect *pPars;
+pPars = &((tsThreadPBErrCorrect *)pCtx)[WorkerIdx];
+pPars->Rslt = ((CPBErrCorrect *)pPars->pThis)->ThreadPBErrCorrect(pPars,(uint32_t)StartIdx,(uint32_t)EndIdx);
+return(pPars->Rslt);
+}
+
+void
+CPBErrCorrect::UpdateProcessStatsProgress(void *pProgressCtx)	// called by the ParallelFor() caller every 30 seconds whilst overlap workers are still processing
+{
+((CPBErrCorrect *)pProgressCtx)->UpdateProcessStats();
+}
 
 int
 CPBErrCorrect::UpdateProcessStats(void)	// determine current CPU utilisation by this process and numbers of commited and uncommited service provider classses
@@ -3462,6 +3555,7 @@ CPBErrCorrect::IdentifySequenceOverlaps(int MaxSeqLen,		// max length sequence t
 tsThreadPBErrCorrect *pThreadPutOvlps;
 int ThreadIdx;
 tsThreadPBErrCorrect *pThreadPar;
+CWorkPool *pWorkPool;
 uint32_t NumCommitedClasses;
 uint32_t NumUncommitedClasses;
 int NumClasses;
@@ -3645,39 +3739,46 @@ for (ThreadIdx = 1; ThreadIdx <= NumOvlpThreads; ThreadIdx++, pThreadPar++)
 	{
 	pThreadPar->ThreadIdx = ThreadIdx;
 	pThreadPar->pThis = this;
-#ifdef _WIN32
-	pThreadPar->threadHandle = (HANDLE)_beginthreadex(NULL, 0x0fffff, PBErrCorrectThread, pThreadPar, 0, &pThreadPar->threadID);
-#else
-	pThreadPar->threadRslt = pthread_create(&pThreadPar->threadID, NULL, PBErrCorrectThread, pThreadPar);
-#endif
 	}
 
-// allow threads 30 seconds to startup
+// compute bound overlapping is run on the shared work pool with batches of reads as work items, read lengths and overlap depths vary widely so workers completing their batches steal from workers still processing
+// RMI workers spend most of their time blocked on service provider responses and there can be many more of these than cores so these have their own threads
+pWorkPool = m_bRMI ? NULL : CWorkPool::Shared(NumOvlpThreads);
+if(pWorkPool != NULL)
+	pWorkPool->ParallelFor(m_NumPBScaffNodes - m_LowestCpltdProcNodeID,cPBErrCorrectReadBatch,PBErrCorrectChunk,pThreadPutOvlps,30,NULL,UpdateProcessStatsProgress,this,NumOvlpThreads);
+else
+	{
+	pThreadPar = pThreadPutOvlps;
+	for (ThreadIdx = 0; ThreadIdx < NumOvlpThreads; ThreadIdx++, pThreadPar++)
+		{
 #ifdef _WIN32
-Sleep(30000);
+		pThreadPar->threadHandle = (HANDLE)_beginthreadex(NULL, 0x0fffff, PBErrCorrectThread, pThreadPar, 0, &pThreadPar->threadID);
 #else
-sleep(30);
+		pThreadPar->threadRslt = pthread_create(&pThreadPar->threadID, NULL, PBErrCorrectThread, pThreadPar);
 #endif
-pThreadPar = pThreadPutOvlps;
-for (ThreadIdx = 0; ThreadIdx < NumOvlpThreads; ThreadIdx++, pThreadPar++)
-	{
-#ifdef _WIN32
-	while (WAIT_TIMEOUT == WaitForSingleObject(pThreadPar->threadHandle, 30000))
+		}
+
+	pThreadPar = pThreadPutOvlps;
+	for (ThreadIdx = 0; ThreadIdx < NumOvlpThreads; ThreadIdx++, pThreadPar++)
 		{
-		UpdateProcessStats();
-		};
-	CloseHandle(pThreadPar->threadHandle);
+#ifdef _WIN32
+		while (WAIT_TIMEOUT == WaitForSingleObject(pThreadPar->threadHandle, 30000))
+			{
+			UpdateProcessStats();
+			};
+		CloseHandle(pThreadPar->threadHandle);
 #else
-	struct timespec ts;
-	int JoinRlt;
-	clock_gettime(CLOCK_REALTIME, &ts);
-	ts.tv_sec += 30;
-	while ((JoinRlt = pthread_timedjoin_np(pThreadPar->threadID, NULL, &ts)) != 0)
-		{
-		UpdateProcessStats();
+		struct timespec ts;
+		int JoinRlt;
+		clock_gettime(CLOCK_REALTIME, &ts);
 		ts.tv_sec += 30;
-		}
+		while ((JoinRlt = pthread_timedjoin_np(pThreadPar->threadID, NULL, &ts)) != 0)
+			{
+			UpdateProcessStats();
+			ts.tv_sec += 30;
+			}
 #endif
+		}
 	}
 
 pThreadPar = pThreadPutOvlps;
@@ -3685,6 +3786,7 @@ for(ThreadIdx = 0; ThreadIdx < NumOvlpThreads; ThreadIdx++,pThreadPar++)
 	{
 	if(pThreadPar->pmtqsort != NULL)
 		delete pThreadPar->pmtqsort;
+	CMinimizerIdx::FreeScratch(&pThreadPar->MzScratch);
 
 	if(pThreadPar->pCoreHits != NULL)
 		{
@@ -3751,8 +3853,12 @@ return(0);
 }
 
 int
-CPBErrCorrect::ThreadPBErrCorrect(tsThreadPBErrCorrect *pThreadPar)
+CPBErrCorrect::ThreadPBErrCorrect(tsThreadPBErrCorrect *pThreadPar,
+								uint32_t StartNodeOfs,	// processing reads starting at this offset following the lowest completed read
+								uint32_t EndNodeOfs)	// up to this offset (exclusive), 0 if processing all remaining reads
 {
+bool bActiveOvlp;
+uint32_t EndNodeID;
 uint32_t AdjOverlapFloat;
 uint32_t CurTargCoreHitCnts;
 tsPBEScaffNode *pTargNode;
@@ -3805,6 +3911,7 @@ uint64_t ClassInstanceID;
 uint32_t ClassMethodID;
 bool bRMIInitialised;
 bool bRMIRslt;
+bool bRMIProbeSet;
 int iRMIRslt;
 bool bNonRMIRslt;
 int iNonRMIRslt;
@@ -3814,9 +3921,11 @@ tsECChkPt CurChkPt;
 tsPBEScaffNode *pCurPBScaffNode;
 uint32_t RMINumUncommitedClasses;
 
-pThreadPar->pSW = NULL;
+if(EndNodeOfs == 0)				// SW instance is retained between batches of reads, launcher deletes it after all batches processed
+	pThreadPar->pSW = NULL;
 pCurPBScaffNode = NULL;
 ClassInstanceID = 0;
+bActiveOvlp = false;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 RMIRestartThread:							// RMI threads with errors detected are restarted from here with a goto!
@@ -3831,26 +3940,33 @@ if(ClassInstanceID != 0)   // non-zero if must have been a RMI SW thread which i
 		pCurPBScaffNode->flgCpltdProc = 0;
 		ReleaseCASLock();
 		}
-	AcquireCASSerialise();
-	if(m_CurActiveRMIThreads > 0)
-		m_CurActiveRMIThreads -= 1;
-	ReleaseCASSerialise();
 	}
 
-if(pThreadPar->pSW != NULL)  // non-NULL if must have been a non-RMI SW thread which is restarting
+if(bActiveOvlp && pThreadPar->pSW != NULL)  // non-NULL if must have been a non-RMI SW thread which is restarting, a SW instance retained from a previous batch of reads is reused
 	{
 	delete pThreadPar->pSW ;
 	pThreadPar->pSW = NULL;
 	pCurPBScaffNode = NULL;
+	}
+
+if(bActiveOvlp)		// restarting so no longer an active overlap thread until readmitted
+	{
 	AcquireCASSerialise();
-	if(m_CurActiveNonRMIThreads > 0)
-		m_CurActiveNonRMIThreads -= 1;
+	if(pThreadPar->bRMI)
+		{
+		if(m_CurActiveRMIThreads > 0)
+			m_CurActiveRMIThreads -= 1;
+		}
+	else
+		if(m_CurActiveNonRMIThreads > 0)
+			m_CurActiveNonRMIThreads -= 1;
 	ReleaseCASSerialise();
 	}
 
 ClassInstanceID = 0;
 ClassMethodID = 0;
 bRMIInitialised = false;
+bActiveOvlp = false;
 pThreadPar->bRMI = false;
  
 // if debugging and only interested in sessions with a specific identifier then set this to the session identifier of interest!!
@@ -3911,10 +4027,12 @@ while(1)
 		}
 	}
 
+bActiveOvlp = true;
 NumInMultiAlignment = 0;
 AdjOverlapFloat = m_OverlapFloat + pThreadPar->CoreSeqLen + 120;
 
-for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNodeID++)
+EndNodeID = EndNodeOfs == 0 ? m_NumPBScaffNodes : min(m_NumPBScaffNodes,LowestCpltdProcNodeID + EndNodeOfs);
+for(CurNodeID = (LowestCpltdProcNodeID + StartNodeOfs + 1); CurNodeID <= EndNodeID; CurNodeID++)
 	{
 	AcquireCASSerialise();				// check if needing to reduce core loading
 	if(pThreadPar->bRMI == false && m_ReduceNonRMIThreads > 0)
@@ -3999,6 +4117,7 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 		uint32_t MaxWinSize;
 		uint32_t RelWinSize;
 		bool bFirstHitNewTargSeq;
+		uint32_t CurFirstCoreHitIdx;
 		uint32_t PrevAcceptedProbeOfs;
 		uint32_t PrevAcceptedTargOfs;
 		uint32_t MaxNoHitGapLen;
@@ -4116,6 +4235,7 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 		CurAProbeEndOfs = 0;
 
 		bFirstHitNewTargSeq = false;
+		CurFirstCoreHitIdx = 0;
 		pCoreHit = pThreadPar->pCoreHits;
 		for(HitIdx = 0; HitIdx < pThreadPar->NumCoreHits; HitIdx++,pCoreHit++)
 			{
@@ -4123,6 +4243,7 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 				{
 				bFirstHitNewTargSeq = true;
 				CurTargSeqID = pCoreHit->TargNodeID;
+				CurFirstCoreHitIdx = HitIdx;
 				CurSEntryIDHits = 0;
 				CurAEntryIDHits = 0;
 				CurSTargStartOfs = 0;
@@ -4231,6 +4352,8 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 					pSummaryCnts->AProbeEndOfs = CurAProbeEndOfs;
 					pSummaryCnts->NumSHits = CurSEntryIDHits;
 					pSummaryCnts->NumAHits = CurAEntryIDHits;
+					pSummaryCnts->FirstCoreHitIdx = CurFirstCoreHitIdx;
+					pSummaryCnts->NumTargCoreHits = HitIdx + 1 - CurFirstCoreHitIdx;
 					pSummaryCnts->flgProbeHCseq = m_pPBScaffNodes[pCoreHit->ProbeNodeID-1].flgHCseq;
 					pSummaryCnts->flgTargHCseq = m_pPBScaffNodes[pCoreHit->TargNodeID-1].flgHCseq;
 					}
@@ -4273,7 +4396,7 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 			if(bNonRMIRslt == true)
 				bNonRMIRslt = pThreadPar->pSW->SetMaxInitiatePathOfs(cDfltMaxOverlapFloat);
 			if(bNonRMIRslt == true)
-				bNonRMIRslt = pThreadPar->pSW->PreAllocMaxTargLen(m_MaxPBSeqLen+100, m_PMode == ePBPMConsensus ? 0 : m_MaxPBSeqLen+100);
+				bNonRMIRslt = pThreadPar->pSW->PreAllocMaxTargLen(m_MaxPBSeqLen+100, (m_PMode == ePBPMConsensus || m_SWBandWidth > 0) ? 0 : m_MaxPBSeqLen+100); // if banded then tracebacks are allocated proportional to the band when first aligning
 			ReleaseCASSerialise();
 			if(bNonRMIRslt == false)
 				goto RMIRestartThread;
@@ -4286,7 +4409,7 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 			if(bRMIRslt != false)
 				bRMIRslt = RMI_SetMaxInitiatePathOfs(pThreadPar,cRMI_SecsTimeout,ClassInstanceID,cDfltMaxOverlapFloat);
 			if(bRMIRslt != false)
-				bRMIRslt = RMI_PreAllocMaxTargLen(pThreadPar,cRMI_SecsTimeout,ClassInstanceID,m_MaxPBSeqLen, m_PMode == ePBPMConsensus ? 0 : m_MaxPBSeqLen);
+				bRMIRslt = RMI_PreAllocMaxTargLen(pThreadPar,cRMI_SecsTimeout,ClassInstanceID,m_MaxPBSeqLen, (m_PMode == ePBPMConsensus || m_SWBandWidth > 0) ? 0 : m_MaxPBSeqLen);
 			if(bRMIRslt == false)
 				goto RMIRestartThread;
 			bRMIInitialised = true;
@@ -4318,221 +4441,272 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 			if(bNonRMIRslt == false)
 				goto RMIRestartThread;
 			}
-		else
-			{
-			bRMIRslt = RMI_SetProbe(pThreadPar,cRMI_SecsTimeout,ClassInstanceID,pCurPBScaffNode->SeqLen,pThreadPar->pProbeSeq);
-			if(bRMIRslt == false)
-				goto RMIRestartThread;
-			}
+		bRMIProbeSet = false;		// RMI probe is set by the provider when processing the first batch of targets
 
 		// iterate over all putative targets and SW these
+		// RMI targets are batched into single requests so as to reduce the number of request/response round trips, the provider processes each batch
+		// in order and stops early if the required coverage is reached, thus the targets processed are exactly those which would be processed unbatched
 		uint64_t ReqSummCoverage;
 		uint64_t CurSummCoverage;
+		uint32_t MaxBatchTargs;
+		uint32_t BatchSeqLen;
+		uint32_t BatchReqLen;
+		uint32_t BatchIdx;
+		uint32_t NumBatchRslts;
+		tsPBEBatchTarg *pBatchTarg;
 
 		ReqSummCoverage = (uint64_t)pCurPBScaffNode->SeqLen * cReqConsensusCoverage;
 		CurSummCoverage = 0;
+		MaxBatchTargs = pThreadPar->bRMI ? cMaxRMIBatchTargs : 1;
 
 		pSummaryCnts = &pThreadPar->TargCoreHitCnts[0];
 		NumInMultiAlignment = 0;
-		for(CurTargCoreHitCnts = 0; CurTargCoreHitCnts < pThreadPar->NumTargCoreHitCnts && CurSummCoverage < ReqSummCoverage; CurTargCoreHitCnts++,pSummaryCnts++)
+		CurTargCoreHitCnts = 0;
+		while(CurTargCoreHitCnts < pThreadPar->NumTargCoreHitCnts && CurSummCoverage < ReqSummCoverage)
 			{
-			if(pSummaryCnts->NumSHits < pThreadPar->MinNumCores && pSummaryCnts->NumAHits < pThreadPar->MinNumCores)
+			// assemble next batch of targets
+			pThreadPar->NumBatchTargs = 0;
+			BatchSeqLen = 0;
+			BatchReqLen = bRMIProbeSet ? 0x0fff : pCurPBScaffNode->SeqLen + 0x0fff;
+			for(; CurTargCoreHitCnts < pThreadPar->NumTargCoreHitCnts && pThreadPar->NumBatchTargs < MaxBatchTargs; CurTargCoreHitCnts++,pSummaryCnts++)
 				{
-				pSummaryCnts->NumSHits = 0;
-				pSummaryCnts->NumAHits = 0;
-				continue;
-				}
-			bTargSense = pSummaryCnts->NumSHits >= pSummaryCnts->NumAHits ? true :  false;
-			pTargNode = &m_pPBScaffNodes[pSummaryCnts->TargNodeID-1];
+				if(pSummaryCnts->NumSHits < pThreadPar->MinNumCores && pSummaryCnts->NumAHits < pThreadPar->MinNumCores)
+					{
+					pSummaryCnts->NumSHits = 0;
+					pSummaryCnts->NumAHits = 0;
+					continue;
+					}
+				bTargSense = pSummaryCnts->NumSHits >= pSummaryCnts->NumAHits ? true :  false;
+				pTargNode = &m_pPBScaffNodes[pSummaryCnts->TargNodeID-1];
 
-			if(m_PMode == ePBMConsolidate && pTargNode->flgCpltdProc == 1)
-				{
-				pSummaryCnts->NumSHits = 0;
-				pSummaryCnts->NumAHits = 0;
-				continue;
-				}
-			if(MinTranscriptOverlapLen == 0)
-				{
-				if(pTargNode->flgHCseq == 1)
-					MinOverlapLen = m_MinHCSeqOverlap;
+				if(m_PMode == ePBMConsolidate && pTargNode->flgCpltdProc == 1)
+					{
+					pSummaryCnts->NumSHits = 0;
+					pSummaryCnts->NumAHits = 0;
+					continue;
+					}
+				if(MinTranscriptOverlapLen == 0)
+					{
+					if(pTargNode->flgHCseq == 1)
+						MinOverlapLen = m_MinHCSeqOverlap;
+					else
+						MinOverlapLen = pThreadPar->MinOverlapLen;
+					}
 				else
-					MinOverlapLen = pThreadPar->MinOverlapLen;
-				}
-			else
-				MinOverlapLen = MinTranscriptOverlapLen;
+					MinOverlapLen = MinTranscriptOverlapLen;
 
+				TargSeqLen = pTargNode->SeqLen; 
+				// batch always contains at least one target, subsequent targets only if the request would remain within the RMI request size limit
+				if(pThreadPar->NumBatchTargs > 0 && (BatchReqLen + TargSeqLen + sizeof(tsCombinedTargAlignPars) + 20) > pThreadPar->RMIReqDataSize)
+					break;
+				if(BatchSeqLen + TargSeqLen + 10 > (uint32_t)pThreadPar->AllocdTargSeqSize)
+					{
+					etSeqBase *pReallocSeq;
+					uint32_t ReallocSize;
+					ReallocSize = ((BatchSeqLen + TargSeqLen) * 150) / 100;
+					pReallocSeq = new etSeqBase [ReallocSize];
+					if(BatchSeqLen > 0)			// retaining any targets already in batch
+						memcpy(pReallocSeq,pThreadPar->pTargSeq,BatchSeqLen);
+					delete pThreadPar->pTargSeq;
+					pThreadPar->pTargSeq = pReallocSeq;
+					pThreadPar->AllocdTargSeqSize = ReallocSize;
+					}
+				m_pSfxArray->GetSeq(pTargNode->EntryID,0,&pThreadPar->pTargSeq[BatchSeqLen],TargSeqLen);
+				if(!bTargSense)
+					CSeqTrans::ReverseComplement(TargSeqLen,&pThreadPar->pTargSeq[BatchSeqLen]);
+				pThreadPar->pTargSeq[BatchSeqLen + TargSeqLen] = eBaseEOS;
+
+				if(TargSeqLen > m_MaxPBSeqLen)
+					gDiagnostics.DiagOut(eDLWarn,gszProcName,"####### Target length of %dbp is longer than expected max length of %dbp #######",
+								TargSeqLen,m_MaxPBSeqLen);
+
+				pBatchTarg = &pThreadPar->BatchTargs[pThreadPar->NumBatchTargs];
+				memset(pBatchTarg,0,sizeof(tsPBEBatchTarg));
+				pBatchTarg->pSummaryCnts = pSummaryCnts;
+				pBatchTarg->pTargNode = pTargNode;
+				pBatchTarg->bTargSense = bTargSense;
+				pBatchTarg->TargSeqOfs = BatchSeqLen;
+				pBatchTarg->AlignPars.PMode = m_PMode;
+				pBatchTarg->AlignPars.NumTargSeqs = pThreadPar->NumTargCoreHitCnts;
+				pBatchTarg->AlignPars.MinOverlapLen = MinOverlapLen;
+				pBatchTarg->AlignPars.MaxOverlapLen = m_PMode == ePBPMConsensus ? 0 : m_MaxPBSeqLen;
+				pBatchTarg->AlignPars.ProbeSeqLen = pCurPBScaffNode->SeqLen;
+				pBatchTarg->AlignPars.TargSeqLen = TargSeqLen;
+				pBatchTarg->AlignPars.OverlapFloat = m_OverlapFloat;
+				pBatchTarg->AlignPars.MaxArtefactDev = m_MaxArtefactDev;
+				pBatchTarg->AlignPars.TargFlags = pSummaryCnts->flgTargHCseq == 1 ? (0x80 | m_HCRelWeighting) : cLCWeightingFactor;
+
+				// restrict the range over which the SW will be processed to that of the overlap +/- m_OverlapFloat
+
+				if(bTargSense)
+					{
+					if(pSummaryCnts->SProbeStartOfs < m_OverlapFloat)
+						pSummaryCnts->SProbeStartOfs = 0;
+					else
+						pSummaryCnts->SProbeStartOfs -= m_OverlapFloat;
+					if(pSummaryCnts->SProbeEndOfs + AdjOverlapFloat >= pCurPBScaffNode->SeqLen)
+						pSummaryCnts->SProbeEndOfs = pCurPBScaffNode->SeqLen - 1;
+					else
+						pSummaryCnts->SProbeEndOfs += AdjOverlapFloat;
+					if(pSummaryCnts->STargStartOfs < m_OverlapFloat)
+						pSummaryCnts->STargStartOfs = 0;
+					else
+						pSummaryCnts->STargStartOfs -= m_OverlapFloat;
+					if(pSummaryCnts->STargEndOfs + AdjOverlapFloat >= TargSeqLen)
+						pSummaryCnts->STargEndOfs = TargSeqLen - 1;
+					else
+						pSummaryCnts->STargEndOfs += AdjOverlapFloat;
 
-			TargSeqLen = pTargNode->SeqLen; 
-			if(TargSeqLen + 10 > (uint32_t)pThreadPar->AllocdTargSeqSize)
-				{
-				delete pThreadPar->pTargSeq;
-				pThreadPar->AllocdTargSeqSize = (TargSeqLen * 150) / 100;
-				pThreadPar->pTargSeq = new etSeqBase [pThreadPar->AllocdTargSeqSize];
-				}
-			m_pSfxArray->GetSeq(pTargNode->EntryID,0,pThreadPar->pTargSeq,TargSeqLen);
-			if(!bTargSense)
-				CSeqTrans::ReverseComplement(TargSeqLen,pThreadPar->pTargSeq);
-			pThreadPar->pTargSeq[TargSeqLen] = eBaseEOS;
-
-			if(TargSeqLen > m_MaxPBSeqLen)
-				gDiagnostics.DiagOut(eDLWarn,gszProcName,"####### Target length of %dbp is longer than expected max length of %dbp #######",
-							TargSeqLen,m_MaxPBSeqLen);
-
-
-			// start combined from here!
-			tsCombinedTargAlignPars CombinedTargAlignPars;
-			tsCombinedTargAlignRet TargAlignRet;
-			memset(&CombinedTargAlignPars,0,sizeof(tsCombinedTargAlignPars));
-			memset(&TargAlignRet,0,sizeof(tsCombinedTargAlignRet));
-			CombinedTargAlignPars.PMode = m_PMode;
-			CombinedTargAlignPars.NumTargSeqs = pThreadPar->NumTargCoreHitCnts;
-			CombinedTargAlignPars.MinOverlapLen = MinOverlapLen;
-			CombinedTargAlignPars.MaxOverlapLen = m_PMode == ePBPMConsensus ? 0 : m_MaxPBSeqLen;
-			CombinedTargAlignPars.ProbeSeqLen = pCurPBScaffNode->SeqLen;
-			CombinedTargAlignPars.TargSeqLen = TargSeqLen;
-			CombinedTargAlignPars.pTargSeq = pThreadPar->pTargSeq;
-			CombinedTargAlignPars.OverlapFloat = m_OverlapFloat;
-			CombinedTargAlignPars.MaxArtefactDev = m_MaxArtefactDev;
-			CombinedTargAlignPars.TargFlags = pSummaryCnts->flgTargHCseq == 1 ? (0x80 | m_HCRelWeighting) : cLCWeightingFactor;
-
-			// restrict the range over which the SW will be processed to that of the overlap +/- m_OverlapFloat
-
-			if(bTargSense)
-				{
-				if(pSummaryCnts->SProbeStartOfs < m_OverlapFloat)
-					pSummaryCnts->SProbeStartOfs = 0;
-				else
-					pSummaryCnts->SProbeStartOfs -= m_OverlapFloat;
-				if(pSummaryCnts->SProbeEndOfs + AdjOverlapFloat >= pCurPBScaffNode->SeqLen)
-					pSummaryCnts->SProbeEndOfs = pCurPBScaffNode->SeqLen - 1;
-				else
-					pSummaryCnts->SProbeEndOfs += AdjOverlapFloat;
-				if(pSummaryCnts->STargStartOfs < m_OverlapFloat)
-					pSummaryCnts->STargStartOfs = 0;
-				else
-					pSummaryCnts->STargStartOfs -= m_OverlapFloat;
-				if(pSummaryCnts->STargEndOfs + AdjOverlapFloat >= TargSeqLen)
-					pSummaryCnts->STargEndOfs = TargSeqLen - 1;
+					pBatchTarg->AlignPars.ProbeStartRelOfs = pSummaryCnts->SProbeStartOfs;
+					pBatchTarg->AlignPars.TargStartRelOfs = pSummaryCnts->STargStartOfs;
+					pBatchTarg->AlignPars.ProbeRelLen = pSummaryCnts->SProbeEndOfs + 1 - pSummaryCnts->SProbeStartOfs;
+					pBatchTarg->AlignPars.TargRelLen = pSummaryCnts->STargEndOfs + 1 - pSummaryCnts->STargStartOfs;
+					}
 				else
-					pSummaryCnts->STargEndOfs += AdjOverlapFloat;
+					{
+					uint32_t Xchg;
+					Xchg = pSummaryCnts->AProbeStartOfs;
+					pSummaryCnts->AProbeStartOfs = pCurPBScaffNode->SeqLen - (pSummaryCnts->AProbeEndOfs + 1);
+					pSummaryCnts->AProbeEndOfs = pCurPBScaffNode->SeqLen - (Xchg + 1);
+					Xchg = pSummaryCnts->ATargStartOfs;
+					pSummaryCnts->ATargStartOfs = TargSeqLen - (pSummaryCnts->ATargEndOfs + 1);
+					pSummaryCnts->ATargEndOfs = TargSeqLen - (Xchg + 1);
+
+					if(pSummaryCnts->AProbeStartOfs < m_OverlapFloat)
+						pSummaryCnts->AProbeStartOfs = 0;
+					else
+						pSummaryCnts->AProbeStartOfs -= m_OverlapFloat;
+					if(pSummaryCnts->AProbeEndOfs + AdjOverlapFloat >= pCurPBScaffNode->SeqLen)
+						pSummaryCnts->AProbeEndOfs = pCurPBScaffNode->SeqLen - 1;
+					else
+						pSummaryCnts->AProbeEndOfs += AdjOverlapFloat;
+					if(pSummaryCnts->ATargStartOfs < m_OverlapFloat)
+						pSummaryCnts->ATargStartOfs = 0;
+					else
+						pSummaryCnts->ATargStartOfs -= m_OverlapFloat;
+					if(pSummaryCnts->ATargEndOfs + AdjOverlapFloat >= TargSeqLen)
+						pSummaryCnts->ATargEndOfs = TargSeqLen - 1;
+					else
+						pSummaryCnts->ATargEndOfs += AdjOverlapFloat;
 
-				CombinedTargAlignPars.ProbeStartRelOfs = pSummaryCnts->SProbeStartOfs;
-				CombinedTargAlignPars.TargStartRelOfs = pSummaryCnts->STargStartOfs;
-				CombinedTargAlignPars.ProbeRelLen = pSummaryCnts->SProbeEndOfs + 1 - pSummaryCnts->SProbeStartOfs;
-				CombinedTargAlignPars.TargRelLen = pSummaryCnts->STargEndOfs + 1 - pSummaryCnts->STargStartOfs;
-				}
-			else
-				{
-				uint32_t Xchg;
-				Xchg = pSummaryCnts->AProbeStartOfs;
-				pSummaryCnts->AProbeStartOfs = pCurPBScaffNode->SeqLen - (pSummaryCnts->AProbeEndOfs + 1);
-				pSummaryCnts->AProbeEndOfs = pCurPBScaffNode->SeqLen - (Xchg + 1);
-				Xchg = pSummaryCnts->ATargStartOfs;
-				pSummaryCnts->ATargStartOfs = TargSeqLen - (pSummaryCnts->ATargEndOfs + 1);
-				pSummaryCnts->ATargEndOfs = TargSeqLen - (Xchg + 1);
-
-				if(pSummaryCnts->AProbeStartOfs < m_OverlapFloat)
-					pSummaryCnts->AProbeStartOfs = 0;
-				else
-					pSummaryCnts->AProbeStartOfs -= m_OverlapFloat;
-				if(pSummaryCnts->AProbeEndOfs + AdjOverlapFloat >= pCurPBScaffNode->SeqLen)
-					pSummaryCnts->AProbeEndOfs = pCurPBScaffNode->SeqLen - 1;
-				else
-					pSummaryCnts->AProbeEndOfs += AdjOverlapFloat;
-				if(pSummaryCnts->ATargStartOfs < m_OverlapFloat)
-					pSummaryCnts->ATargStartOfs = 0;
-				else
-					pSummaryCnts->ATargStartOfs -= m_OverlapFloat;
-				if(pSummaryCnts->ATargEndOfs + AdjOverlapFloat >= TargSeqLen)
-					pSummaryCnts->ATargEndOfs = TargSeqLen - 1;
-				else
-					pSummaryCnts->ATargEndOfs += AdjOverlapFloat;
+					pBatchTarg->AlignPars.ProbeStartRelOfs = pSummaryCnts->AProbeStartOfs;
+					pBatchTarg->AlignPars.TargStartRelOfs = pSummaryCnts->ATargStartOfs;
+					pBatchTarg->AlignPars.ProbeRelLen = pSummaryCnts->AProbeEndOfs + 1 - pSummaryCnts->AProbeStartOfs;
+					pBatchTarg->AlignPars.TargRelLen = pSummaryCnts->ATargEndOfs + 1 - pSummaryCnts->ATargStartOfs;
+					}
 
-				CombinedTargAlignPars.ProbeStartRelOfs = pSummaryCnts->AProbeStartOfs;
-				CombinedTargAlignPars.TargStartRelOfs = pSummaryCnts->ATargStartOfs;
-				CombinedTargAlignPars.ProbeRelLen = pSummaryCnts->AProbeEndOfs + 1 - pSummaryCnts->AProbeStartOfs;
-				CombinedTargAlignPars.TargRelLen = pSummaryCnts->ATargEndOfs + 1 - pSummaryCnts->ATargStartOfs;
-				}
+				if(pBatchTarg->AlignPars.ProbeRelLen < MinOverlapLen || pBatchTarg->AlignPars.TargRelLen < MinOverlapLen)
+					continue;
 
-			if(CombinedTargAlignPars.ProbeRelLen < MinOverlapLen || CombinedTargAlignPars.TargRelLen < MinOverlapLen)
-				continue;
+				if(m_SWBandWidth > 0)		// band the alignment around the chained core hits
+					GenSWAnchors(pThreadPar,pSummaryCnts,bTargSense,pCurPBScaffNode->SeqLen,TargSeqLen,&pBatchTarg->AlignPars);
+
+				pThreadPar->NumBatchTargs += 1;
+				BatchSeqLen += TargSeqLen + 1;
+				BatchReqLen += TargSeqLen + sizeof(tsCombinedTargAlignPars) + 20;
+				}
+			if(pThreadPar->NumBatchTargs == 0)
+				break;
 
+			// batch target sequences could have been reallocated whilst assembling the batch so only now can the ptrs be set
+			pBatchTarg = pThreadPar->BatchTargs;
+			for(BatchIdx = 0; BatchIdx < pThreadPar->NumBatchTargs; BatchIdx++,pBatchTarg++)
+				pBatchTarg->AlignPars.pTargSeq = &pThreadPar->pTargSeq[pBatchTarg->TargSeqOfs];
 
 			if(!pThreadPar->bRMI)
 				{
-				if(!pThreadPar->pSW->CombinedTargAlign(&CombinedTargAlignPars, &TargAlignRet))
-					goto CompletedNodeProcessing;
-				if(TargAlignRet.ErrRslt != eBSFSuccess || TargAlignRet.ProcPhase < 2 || TargAlignRet.ProcPhase == 3)
+				if(!pThreadPar->pSW->CombinedTargAlign(&pThreadPar->BatchTargs[0].AlignPars, &pThreadPar->BatchTargs[0].AlignRet))
 					goto CompletedNodeProcessing;
+				NumBatchRslts = 1;
 				}
 			else
 				{
-				if(!RMI_CombinedTargAlign(pThreadPar,cRMI_AlignSecsTimeout,ClassInstanceID,&CombinedTargAlignPars, &TargAlignRet))
+				iRMIRslt = RMI_CombinedTargAligns(pThreadPar,cRMI_AlignSecsTimeout,ClassInstanceID,m_PMode == ePBMConsolidate ? 0 : ReqSummCoverage,CurSummCoverage,
+										bRMIProbeSet ? 0 : pCurPBScaffNode->SeqLen,pThreadPar->pProbeSeq,pThreadPar->NumBatchTargs,pThreadPar->BatchTargs);
+				if(iRMIRslt < 1)
 					goto RMIRestartThread;
+				bRMIProbeSet = true;
+				NumBatchRslts = (uint32_t)iRMIRslt;
+				}
+
+			pBatchTarg = pThreadPar->BatchTargs;
+			for(BatchIdx = 0; BatchIdx < NumBatchRslts; BatchIdx++,pBatchTarg++)
+				{
+				tsCombinedTargAlignRet TargAlignRet;
+				TargAlignRet = pBatchTarg->AlignRet;
 				if(TargAlignRet.ErrRslt != eBSFSuccess || TargAlignRet.ProcPhase < 2 || TargAlignRet.ProcPhase == 3)
+					{
+					if(!pThreadPar->bRMI)
+						goto CompletedNodeProcessing;
 					goto RMIRestartThread;
-				}
+					}
+				pTargNode = pBatchTarg->pTargNode;
+				bTargSense = pBatchTarg->bTargSense;
+				TargSeqLen = pBatchTarg->AlignPars.TargSeqLen;
 
-			PeakMatchesCell = TargAlignRet.PeakMatchesCell;
-			pPeakMatchesCell = &PeakMatchesCell;
+				PeakMatchesCell = TargAlignRet.PeakMatchesCell;
+				pPeakMatchesCell = &PeakMatchesCell;
 
-			ProvSWchecked += 1;
-			if(TargAlignRet.Flags & 0x02)		// set if alignment classified as an artifact
-				ProvArtefact += 1;
+				ProvSWchecked += 1;
+				if(TargAlignRet.Flags & 0x02)		// set if alignment classified as an artifact
+					ProvArtefact += 1;
 			
-			if(TargAlignRet.ProcPhase == 4)
-				{
-				if(TargAlignRet.Flags & 0x08)		// set if alignment was accepted and added as a multialignment
+				if(TargAlignRet.ProcPhase == 4)
 					{
-					NumInMultiAlignment += 1;
-					if(m_PMode == ePBMConsolidate)
+					if(TargAlignRet.Flags & 0x08)		// set if alignment was accepted and added as a multialignment
 						{
-						pTargNode->flgCpltdProc = 1;
-						CurSummCoverage = 0;
-						}
-					else
-						{
-						uint64_t OvlpLen =  (uint64_t)(TargAlignRet.ProbeAlignLength + TargAlignRet.TargAlignLength + 1) / 2;
-						if(pSummaryCnts->flgTargHCseq == 1)
-							CurSummCoverage += OvlpLen * 3 / 2;  // if alignment was onto a high confidence sequence then less coverage depth required for consensus confidence 
+						NumInMultiAlignment += 1;
+						if(m_PMode == ePBMConsolidate)
+							{
+							pTargNode->flgCpltdProc = 1;
+							CurSummCoverage = 0;
+							}
 						else
-							CurSummCoverage += OvlpLen;
-						}
+							{
+							uint64_t OvlpLen =  (uint64_t)(TargAlignRet.ProbeAlignLength + TargAlignRet.TargAlignLength + 1) / 2;
+							if(pBatchTarg->pSummaryCnts->flgTargHCseq == 1)
+								CurSummCoverage += OvlpLen * 3 / 2;  // if alignment was onto a high confidence sequence then less coverage depth required for consensus confidence 
+							else
+								CurSummCoverage += OvlpLen;
+							}
 
-					if(TargAlignRet.Flags & 0x04)		// set if alignment classified as contained
-						ProvContained += 1;
+						if(TargAlignRet.Flags & 0x04)		// set if alignment classified as contained
+							ProvContained += 1;
 
-					if(TargAlignRet.Flags & 0x01)		// set if alignment was classified as overlapping 
-						ProvOverlapping += 1;
-					ProvOverlapped += 1;
-					}
+						if(TargAlignRet.Flags & 0x01)		// set if alignment was classified as overlapping 
+							ProvOverlapping += 1;
+						ProvOverlapped += 1;
+						}
 
-				if(m_PMode == ePBPMOverlapDetail && m_hErrCorFile != -1)
-					{
-					m_pSfxArray->GetIdentName(pTargNode->EntryID,sizeof(szTargSeqName)-1,szTargSeqName);
-					AcquireCASSerialise();
-					if(m_ScaffLineBuffIdx > (sizeof(m_szScaffLineBuff) - 1000))
+					if(m_PMode == ePBPMOverlapDetail && m_hErrCorFile != -1)
 						{
-						if(!CUtility::RetryWrites(m_hErrCorFile,m_szScaffLineBuff,m_ScaffLineBuffIdx))
+						m_pSfxArray->GetIdentName(pTargNode->EntryID,sizeof(szTargSeqName)-1,szTargSeqName);
+						AcquireCASSerialise();
+						if(m_ScaffLineBuffIdx > (int)(sizeof(m_szScaffLineBuff) - 1000))
 							{
-							gDiagnostics.DiagOut(eDLFatal,gszProcName,"RetryWrites() failed writing %u chars to overlap details file",m_ScaffLineBuffIdx);
-							ReleaseCASSerialise();
-							goto CompletedNodeProcessing;
+							if(!CUtility::RetryWrites(m_hErrCorFile,m_szScaffLineBuff,m_ScaffLineBuffIdx))
+								{
+								gDiagnostics.DiagOut(eDLFatal,gszProcName,"RetryWrites() failed writing %u chars to overlap details file",m_ScaffLineBuffIdx);
+								ReleaseCASSerialise();
+								goto CompletedNodeProcessing;
+								}
+							m_ScaffLineBuffIdx = 0;
 							}
-						m_ScaffLineBuffIdx = 0;
-						}
 
-					m_ScaffLineBuffIdx += sprintf(&m_szScaffLineBuff[m_ScaffLineBuffIdx], "\n%d,%d,\"%s\",%d,\"%s\",%d,\"%c\",\"%c\",%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d",
-														TargAlignRet.Class,pCurPBScaffNode->EntryID,szProbeSeqName,pTargNode->EntryID,szTargSeqName,
-														bTargSense ? pSummaryCnts->NumSHits : pSummaryCnts->NumAHits, 'S', bTargSense ? 'S' : 'A',
-														pCurPBScaffNode->SeqLen,TargSeqLen,
-														TargAlignRet.ProbeAlignLength, TargAlignRet.TargAlignLength, PeakMatchesCell.PeakScore, PeakMatchesCell.CurScore, PeakMatchesCell.NumMatches,
-														PeakMatchesCell.NumExacts, PeakMatchesCell.NumGapsIns, PeakMatchesCell.NumBasesIns, PeakMatchesCell.NumGapsDel, PeakMatchesCell.NumBasesDel, PeakMatchesCell.StartPOfs,
-														PeakMatchesCell.StartTOfs, PeakMatchesCell.EndPOfs, PeakMatchesCell.EndTOfs, PeakMatchesCell.PFirstAnchorStartOfs, PeakMatchesCell.TFirstAnchorStartOfs, PeakMatchesCell.PLastAnchorEndOfs, PeakMatchesCell.TLastAnchorEndOfs);
+						m_ScaffLineBuffIdx += sprintf(&m_szScaffLineBuff[m_ScaffLineBuffIdx], "\n%d,%d,\"%s\",%d,\"%s\",%d,\"%c\",\"%c\",%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d,%1.5d",
+															TargAlignRet.Class,pCurPBScaffNode->EntryID,szProbeSeqName,pTargNode->EntryID,szTargSeqName,
+															bTargSense ? pBatchTarg->pSummaryCnts->NumSHits : pBatchTarg->pSummaryCnts->NumAHits, 'S', bTargSense ? 'S' : 'A',
+															pCurPBScaffNode->SeqLen,TargSeqLen,
+															TargAlignRet.ProbeAlignLength, TargAlignRet.TargAlignLength, PeakMatchesCell.PeakScore, PeakMatchesCell.CurScore, PeakMatchesCell.NumMatches,
+															PeakMatchesCell.NumExacts, PeakMatchesCell.NumGapsIns, PeakMatchesCell.NumBasesIns, PeakMatchesCell.NumGapsDel, PeakMatchesCell.NumBasesDel, PeakMatchesCell.StartPOfs,
+															PeakMatchesCell.StartTOfs, PeakMatchesCell.EndPOfs, PeakMatchesCell.EndTOfs, PeakMatchesCell.PFirstAnchorStartOfs, PeakMatchesCell.TFirstAnchorStartOfs, PeakMatchesCell.PLastAnchorEndOfs, PeakMatchesCell.TLastAnchorEndOfs);
 
-					ReleaseCASSerialise();
+						ReleaseCASSerialise();
+						}
 					}
 				}
+			if(NumBatchRslts < pThreadPar->NumBatchTargs)		// provider stopped early as required coverage was reached
+				break;
 			}
 		}
 
@@ -4768,6 +4942,17 @@ for(CurNodeID = (LowestCpltdProcNodeID+1); CurNodeID <= m_NumPBScaffNodes; CurNo
 
 CompletedNodeProcessing:     // when no more nodes requiring processing then goto is used to branch here for thread cleanup
 AcquireCASSerialise();
+if(bActiveOvlp)		// no longer an active overlap thread, allowing others to become active
+	{
+	if(pThreadPar->bRMI)
+		{
+		if(m_CurActiveRMIThreads > 0)
+			m_CurActiveRMIThreads -= 1;
+		}
+	else
+		if(m_CurActiveNonRMIThreads > 0)
+			m_CurActiveNonRMIThreads -= 1;
+	}
 if((m_PMode == ePBPMErrCorrect  || m_PMode == ePBMConsolidate) && m_hErrCorFile != -1 && pThreadPar->ErrCorBuffIdx > 0)
 	{
 	CUtility::RetryWrites(m_hErrCorFile,pThreadPar->pszErrCorLineBuff,pThreadPar->ErrCorBuffIdx);
@@ -4808,7 +4993,7 @@ if(pThreadPar->bRMI && ClassInstanceID != 0)
 	RMI_delete(pThreadPar,cRMI_SecsTimeout,ClassInstanceID);
 	ClassInstanceID = 0;
 	}
-if(pThreadPar->pSW != NULL)
+if(pThreadPar->pSW != NULL && EndNodeOfs == 0)
 	{
 	delete pThreadPar->pSW;
 	pThreadPar->pSW = NULL;
@@ -4891,6 +5076,78 @@ memset(&pCurCoreHit[1],0,sizeof(tsPBECoreHit));	// ensuring that used cores are
 return(pPars->NumCoreHits);
 }
 
+// GenSWAnchors
+// Chain the clustered core hits onto a target into SW anchors, alignment is then banded around the anchor diagonals
+// Antisense hits were from the revcpl'd probe so are mapped onto the probe vs revcpl'd target orientation in which the alignment is processed
+// Anchors are at least ProbeRelLen/cSSWMaxAnchors apart along the probe, and hits which are not colinear with the previous anchor are not chained
+int					// returns number of anchors in pAlignPars->Anchors
+CPBErrCorrect::GenSWAnchors(tsThreadPBErrCorrect *pPars,	// thread specific
+			   sPBECoreHitCnts *pSummaryCnts,	// chaining clustered core hits onto this target
+			   bool bTargSense,					// true if probe aligning onto sense target
+			   uint32_t ProbeSeqLen,				// probe sequence length
+			   uint32_t TargSeqLen,				// target sequence length
+			   tsCombinedTargAlignPars *pAlignPars)	// anchors and band width returned into these alignment parameters
+{
+uint32_t HitIdx;
+uint32_t NumAnchors;
+uint32_t MinAnchorSep;
+uint32_t ProbeOfs;
+uint32_t TargOfs;
+int64_t DiagDelta;
+tsPBECoreHit *pCoreHit;
+tsSSWAnchor *pAnchor;
+
+pAlignPars->BandWidth = 0;
+pAlignPars->NumAnchors = 0;
+if(m_SWBandWidth == 0 || pSummaryCnts->NumTargCoreHits == 0 || (pSummaryCnts->FirstCoreHitIdx + pSummaryCnts->NumTargCoreHits) > pPars->NumCoreHits)
+	return(0);
+
+MinAnchorSep = 1 + (pAlignPars->ProbeRelLen / cSSWMaxAnchors);
+NumAnchors = 0;
+pAnchor = pAlignPars->Anchors;
+for(HitIdx = 0; HitIdx < pSummaryCnts->NumTargCoreHits && NumAnchors < (uint32_t)cSSWMaxAnchors; HitIdx++)
+	{
+	// hits are ordered by ascending target offset, iterate antisense hits in reverse so mapped offsets are also ascending
+	if(bTargSense)
+		pCoreHit = &pPars->pCoreHits[pSummaryCnts->FirstCoreHitIdx + HitIdx];
+	else
+		pCoreHit = &pPars->pCoreHits[pSummaryCnts->FirstCoreHitIdx + pSummaryCnts->NumTargCoreHits - (HitIdx + 1)];
+	if(pCoreHit->flgClustered != 1 || pCoreHit->flgMulti == 1 || pCoreHit->flgRevCpl != (bTargSense ? 0 : 1))
+		continue;
+	if(bTargSense)
+		{
+		ProbeOfs = pCoreHit->ProbeOfs;
+		TargOfs = pCoreHit->TargOfs;
+		}
+	else
+		{
+		if((pCoreHit->ProbeOfs + pCoreHit->HitLen) > ProbeSeqLen || (pCoreHit->TargOfs + pCoreHit->HitLen) > TargSeqLen)
+			continue;
+		ProbeOfs = ProbeSeqLen - (pCoreHit->ProbeOfs + pCoreHit->HitLen);
+		TargOfs = TargSeqLen - (pCoreHit->TargOfs + pCoreHit->HitLen);
+		}
+	if(NumAnchors > 0)
+		{
+		if(ProbeOfs < (pAnchor[-1].ProbeOfs + MinAnchorSep) || TargOfs <= pAnchor[-1].TargOfs)
+			continue;
+		// diagonal can only have drifted from the previous anchor by the accumulated InDels, allowing for up to 30% InDels
+		DiagDelta = ((int64_t)TargOfs - ProbeOfs) - ((int64_t)pAnchor[-1].TargOfs - pAnchor[-1].ProbeOfs);
+		if(DiagDelta < 0)
+			DiagDelta = -DiagDelta;
+		if(DiagDelta > (int64_t)max(m_SWBandWidth,((ProbeOfs - pAnchor[-1].ProbeOfs) * 30) / 100))
+			continue;
+		}
+	pAnchor->ProbeOfs = ProbeOfs;
+	pAnchor->TargOfs = TargOfs;
+	pAnchor += 1;
+	NumAnchors += 1;
+	}
+if(NumAnchors > 0)
+	pAlignPars->BandWidth = m_SWBandWidth;
+pAlignPars->NumAnchors = NumAnchors;
+return((int)NumAnchors);
+}
+
 
 
 // MapEntryID2NodeID
@@ -4986,8 +5243,25 @@ else
 	}
 
 memset(QualTargs,0,sizeof(QualTargs));
-QualCoreLen = pPars->CoreSeqLen + 5;
-NumQualSeqs = m_pSfxArray->PreQualTargs(pProbeNode->EntryID,pProbeNode->SeqLen,pPars->pProbeSeq, QualCoreLen,(int)pPars->DeltaCoreOfs, TargOvlpLenDiffbp, cMaxQualTargs,QualTargs);
+if(m_pMzIdx != NULL)
+	{
+	// minimizer sketch shortlists targets sharing sufficient diagonally consistent minimizers, only these are explored for suffix array core hits
+	int QualIdx;
+	tsMzIdxCand *pMzCand;
+	NumQualSeqs = m_pMzIdx->LocateCandidates(pPars->pProbeSeq,pProbeNode->SeqLen,pProbeNode->EntryID,MinTargLen,MaxTargLen,pPars->MaxSeedCoreDepth,
+								max((uint32_t)cMinMzSketchDiagBand,(pProbeNode->SeqLen * cMzSketchDiagBandPct) / 100),m_MinMzShared,cMaxQualTargs,&pPars->MzScratch);
+	pMzCand = pPars->MzScratch.pCands;
+	for(QualIdx = 0; QualIdx < NumQualSeqs; QualIdx++, pMzCand++)
+		{
+		QualTargs[QualIdx].TargEntryID = pMzCand->TargSeqID;
+		QualTargs[QualIdx].Hits = (uint8_t)min(pMzCand->NumShared,(uint32_t)0x0ff);
+		}
+	}
+else
+	{
+	QualCoreLen = pPars->CoreSeqLen + 5;
+	NumQualSeqs = m_pSfxArray->PreQualTargs(pProbeNode->EntryID,pProbeNode->SeqLen,pPars->pProbeSeq, QualCoreLen,(int)pPars->DeltaCoreOfs, TargOvlpLenDiffbp, cMaxQualTargs,QualTargs);
+	}
 
 if(NumQualSeqs > 0)
 	{
@@ -5693,6 +5967,87 @@ if(bPeakScoreCell)
 	*pPeakScoreCell = *pCell;
 	}
 return(&pThreadPar->RMIHighScoreCell);
+}
+
+	// batched RMI_CombinedTargAlign, targets are processed by the provider in order until all processed, coverage reaches ReqCoverage, or an alignment fails
+int // -3: timeout waiting for job to complete, -2: parameter errors, -1: class instance no longer exists, 0: currently no available service instance, otherwise number of targets processed
+CPBErrCorrect::RMI_CombinedTargAligns(tsThreadPBErrCorrect *pThreadPar, uint32_t Timeout,  uint64_t ClassInstanceID,
+						uint64_t ReqCoverage,		// provider stops processing targets once accumulated coverage reaches this, 0 if no limit
+						uint64_t CurCoverage,		// coverage accumulated prior to this batch
+						uint32_t ProbeSeqLen,		// if > 0 then set this probe sequence before processing targets
+						etSeqBase *pProbeSeq,		// probe sequence
+						uint32_t NumTargs,			// batch contains this many targets
+						tsPBEBatchTarg *pBatchTargs)	// alignment parameters for each target, returned alignment results
+{
+int Rslt;
+int RespDataOfs;
+uint32_t JobRslt;
+tJobIDEx JobID;
+uint32_t ClassMethodID;
+uint32_t MaxResponseSize;
+uint32_t TargIdx;
+tsCombinedTargAlignRet *pTmpAlignRets;
+tsPBEBatchTarg *pBatchTarg;
+time_t Then;
+time_t Now;
+uint32_t SleepTime;
+
+if(NumTargs == 0 || NumTargs > cMaxRMIBatchTargs || pBatchTargs == NULL)
+	return(-2);
+
+SleepTime = 50;
+Then = time(NULL);
+RespDataOfs = MarshalReq(pThreadPar->pRMIReqData,eRMIPTUint32,&NumTargs,sizeof(uint32_t));
+RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTUint64,&ReqCoverage,sizeof(uint64_t));
+RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTUint64,&CurCoverage,sizeof(uint64_t));
+if(pProbeSeq == NULL)
+	ProbeSeqLen = 0;
+RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTInt32,&ProbeSeqLen,sizeof(int32_t));
+if(ProbeSeqLen > 0)
+	RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTVarUint8,pProbeSeq,ProbeSeqLen);
+pBatchTarg = pBatchTargs;
+for(TargIdx = 0; TargIdx < NumTargs; TargIdx++,pBatchTarg++)
+	{
+	if((RespDataOfs + sizeof(tsCombinedTargAlignPars) + pBatchTarg->AlignPars.TargSeqLen + 100) > pThreadPar->RMIReqDataSize)
+		return(-2);
+	memset(&pBatchTarg->AlignRet,0,sizeof(tsCombinedTargAlignRet));
+	RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTVarUint8,&pBatchTarg->AlignPars,sizeof(tsCombinedTargAlignPars));
+	RespDataOfs += MarshalReq(&pThreadPar->pRMIReqData[RespDataOfs],eRMIPTVarUint8,pBatchTarg->AlignPars.pTargSeq,pBatchTarg->AlignPars.TargSeqLen);
+	}
+while((Rslt = pThreadPar->pRequester->AddJobRequest(&JobID,pThreadPar->ServiceType,ClassInstanceID,eSWMCombinedTargAligns,0,NULL,RespDataOfs,pThreadPar->pRMIReqData))==0)
+	{
+	Now = time(NULL);
+	if((Now - Then) > Timeout)
+		return(-3);
+	CUtility::SleepMillisecs(SleepTime);
+	if(SleepTime < 1000)
+		SleepTime += 50;
+	}
+if(Rslt < 1)		// -2: parameter errors, -1: class instance no longer exists, 0: currently no available service instance 1: if job accepted
+	return(Rslt);
+
+SleepTime = 50;
+MaxResponseSize = pThreadPar->RMIRespDataSize;
+while((Rslt = pThreadPar->pRequester->GetJobResponse(JobID,&ClassInstanceID,&ClassMethodID,&JobRslt,&MaxResponseSize,pThreadPar->pRMIRespData))==0)
+	{
+	Now = time(NULL);
+	if((Now - Then) > Timeout)
+		return(-3);
+	CUtility::SleepMillisecs(SleepTime);
+	if(SleepTime < 1000)
+		SleepTime += 50;
+	}
+if(Rslt < 1 || (int)JobRslt < 1 || JobRslt > NumTargs || MaxResponseSize < (JobRslt * sizeof(tsCombinedTargAlignRet)))
+	return(-2);
+
+pTmpAlignRets = NULL;
+RespDataOfs = UnmarshalResp(JobRslt * sizeof(tsCombinedTargAlignRet),pThreadPar->pRMIRespData,&pTmpAlignRets);
+if(pTmpAlignRets == NULL || RespDataOfs < (int)(JobRslt * sizeof(tsCombinedTargAlignRet)))
+	return(-2);
+pBatchTarg = pBatchTargs;
+for(TargIdx = 0; TargIdx < JobRslt; TargIdx++,pBatchTarg++,pTmpAlignRets++)
+	pBatchTarg->AlignRet = *pTmpAlignRets;
+return((int)JobRslt);
 }
 
       // methods which combines the functionality of SetTarg, SetAlignRange, Align, ClassifyPath, TracebacksToAlignOps, and AddMultiAlignment into a single method 
@@ -5789,6 +6144,7 @@ memset(pRetPeakMatchesCell,0,sizeof(tsSSWCell));
 *pRetbProvContained = false;
 *pRetbAddedMultiAlignment = false;
 
+memset(&AlignPars,0,sizeof(tsCombinedTargAlignPars));
 AlignPars.PMode = PMode;
 AlignPars.NumTargSeqs = NumTargSeqs;
 AlignPars.ProbeSeqLen = ProbeSeqLen;
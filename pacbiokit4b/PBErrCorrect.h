@@ -41,12 +41,15 @@ const int cDfltRMIBufferSize =   cMaxSWMAFBuffSize;			// each worker thread defa
 
 const uint32_t cRMI_SecsTimeout = 180;				// allowing for most RMI SW requests to take at most this many seconds to complete (request plus response)
 const uint32_t cRMI_AlignSecsTimeout = 600;			// allowing for a RMI SW alignment request to take at most this many seconds to complete (request plus response)
+const int cMaxRMIBatchTargs = 32;					// RMI: batching at most this many targets into each SW alignment request
 const uint32_t cRMIThreadsPerCore = 8;				// current guesstimate is that 1 server core can support this many RMI SW threads ( 1 core per Non-RMI SW thread)
                                                     // predicated on assuming that the qualifying of read pairs for SW requires around 20% of per core time, the other 80% is spent on SW
 
 const uint32_t cMinTransInstancesPerSeqLen = 250;		// when transcriptome processing then clamping number of error corrected sequences for any given transcript read length to be no more than this nunber of sequences allowing length differentials of 1%
 const uint32_t cMaxTransInstancesPerSeqLen = 500;	// when transcriptome processing then clamping number of error corrected sequences for any given transcript read length to be no more than this nunber of sequences allowing length differentials of 15%
 													// proportionally increased from cMinTransInstancesPerSeqLen to cMaxTransInstancesPerSeqLen for transcript length differentials in the range 2 to 14%
+const uint32_t cPBErrCorrectReadBatch = 8;			// when overlapping on the shared work pool then each work item is a batch of this many reads
+
 const int cMaxAdapterSeqLen = 50;					// adapter sequence lengths allowed up to this maximum length
 const int cMaxAdapterSeqs = 20;						// allowing for at most this many different adapter sequences for end trimming 
 const char szDflt5Adaptor[] = "aagcagtggtatcaacgcagagtac";	// default 5' adapter sequence if none explicitly specified when transcriptome processing
@@ -54,6 +57,11 @@ const char szDflt3Adaptor[] = "gtactctgcgttgataccactgctt";	// default 3' adapter
 
 const int cMaxBinnedReadLens = 1000;					// allowing for at most this many read length bins
 
+const int cMinMzSketchShared = 2;						// if prefiltering putative overlaps with a minimizer sketch then user can specify requiring down to this many shared minimizers
+const int cMaxMzSketchShared = 1000;					// and up to this many shared minimizers
+const int cMzSketchDiagBandPct = 10;					// shared minimizers are diagonally consistent if within a band of this percentage of the probe length
+const int cMinMzSketchDiagBand = 250;					// with the band being at least this many bp
+
 typedef enum TAG_ePBPMode {								// processing mode
 	ePBPMErrCorrect,									// error correct
 	ePBPMConsensus,										// generate consensus from previously generated multiple alignments
@@ -125,10 +133,21 @@ typedef struct TAG_sPBECoreHitCnts {
 	uint32_t	AProbeEndOfs;			// highest probe offset for any antisense hit onto target
 	uint32_t NumSHits;				// number of hits onto target sequence from sense probe
 	uint32_t NumAHits;				// number of hits onto target sequence from antisense probe
+	uint32_t FirstCoreHitIdx;		// core hits onto target sequence start at this index into pCoreHits
+	uint32_t NumTargCoreHits;		// and there are this many core hits, both sense and antisense, onto target sequence
 	uint8_t flgProbeHCseq:1;          // set if probe was loaded as a high confidence (non-PacBio) sequence
 	uint8_t flgTargHCseq:1;           // set if target was loaded as a high confidence (non-PacBio) sequence
 } sPBECoreHitCnts;
 
+typedef struct TAG_sPBEBatchTarg {
+	sPBECoreHitCnts *pSummaryCnts;	// target summary core hit counts
+	tsPBEScaffNode *pTargNode;		// target node
+	bool bTargSense;				// true if probe aligning onto sense target
+	uint32_t TargSeqOfs;			// target sequence starts at this offset in pTargSeq
+	tsCombinedTargAlignPars AlignPars;	// alignment parameters
+	tsCombinedTargAlignRet AlignRet;	// returned alignment results
+} tsPBEBatchTarg;
+
 typedef struct TAG_sThreadPBErrCorrect {
 	int ThreadIdx;					// uniquely identifies this thread
 	void *pThis;					// will be initialised to pt to class instance
@@ -167,7 +186,11 @@ typedef struct TAG_sThreadPBErrCorrect {
 	etSeqBase *pProbeSeq;			// allocated to hold the current probe sequence
 
 	uint32_t AllocdTargSeqSize;		// current allocation size for buffered target sequence in pTargSeq 	
-	etSeqBase *pTargSeq;			// allocated to hold the current target sequence
+	etSeqBase *pTargSeq;			// allocated to hold the current target sequence, or concatenated batch of target sequences
+	uint32_t NumBatchTargs;			// number of targets in current alignment batch
+	tsPBEBatchTarg BatchTargs[cMaxRMIBatchTargs];	// current alignment batch
+
+	tsMzIdxScratch MzScratch;		// working memory if prefiltering putative overlaps with minimizer sketch
 
 
 	uint32_t AlignErrMem;				// number of times alignments failed because of memory allocation errors
@@ -222,6 +245,8 @@ class CPBErrCorrect
 
 	uint32_t m_MinSeedCoreLen;				// use seed cores of this length when identifying putative overlapping scaffold sequences
 	uint32_t m_MinNumSeedCores;				// require at least this many seed cores between overlapping scaffold sequences
+	uint32_t m_MinMzShared;					// if > 0 then putative overlaps are prefiltered with minimizer sketch requiring at least this many shared minimizers
+	uint32_t m_SWBandWidth;					// if > 0 then SW alignments are banded to this many bp either side of the core hit diagonals
 
 	int m_SWMatchScore;						// SW score for matching bases (0..100)
 	int m_SWMismatchPenalty;				// SW mismatch penalty (-100..0)
@@ -310,6 +335,7 @@ class CPBErrCorrect
 	uint32_t *m_pMapEntryID2NodeIDs;				// used to map from suffix array entry identifiers to the corresponding scaffolding node identifier
 
 	CSfxArray *m_pSfxArray;					// suffix array file (m_szTargFile) is loaded into this
+	CMinimizerIdx *m_pMzIdx;				// if prefiltering putative overlaps then minimizer sketch over m_pSfxArray sequences, read only once built so shared by all threads
 
 	void Init(void);							// initialise state to that immediately following construction
 	void Reset(void);						// reset state
@@ -386,6 +412,14 @@ class CPBErrCorrect
 			   uint32_t HitLen,					// hit was of this length
                tsThreadPBErrCorrect *pPars);	// thread specific
 
+	int					// returns number of anchors in pAlignPars->Anchors
+		GenSWAnchors(tsThreadPBErrCorrect *pPars,	// thread specific
+			   sPBECoreHitCnts *pSummaryCnts,	// chaining clustered core hits onto this target
+			   bool bTargSense,					// true if probe aligning onto sense target
+			   uint32_t ProbeSeqLen,				// probe sequence length
+			   uint32_t TargSeqLen,				// target sequence length
+			   tsCombinedTargAlignPars *pAlignPars);	// anchors and band width returned into these alignment parameters
+
 	uint32_t										// returned tsPBScaffNode node identifier
 		MapEntryID2NodeID(uint32_t EntryID);		// suffix array entry identifier
 
@@ -442,6 +476,7 @@ static int SortCoreHitsDescending(const void *arg1, const void *arg2);
 
 
 	int UpdateProcessStats(void);					// determine  numbers of commited and uncommited service provider classses
+	static void UpdateProcessStatsProgress(void *pProgressCtx);	// work pool progress reporting, pProgressCtx is the CPBErrCorrect instance
 
 	int												// marshaled parameter required this many bytes
 			MarshalReq(uint8_t *pInto,				// marshal into this list
@@ -513,6 +548,15 @@ static int SortCoreHitsDescending(const void *arg1, const void *arg2);
 						tsCombinedTargAlignPars *pAlignPars, // input alignment parameters
 						tsCombinedTargAlignRet *pAlignRet);		// returned alignment results
 
+	int					// -3: timeout waiting for job to complete, -2: parameter errors, -1: class instance no longer exists, 0: currently no available service instance, otherwise number of targets processed
+		RMI_CombinedTargAligns(tsThreadPBErrCorrect *pThreadPar, uint32_t Timeout,  uint64_t ClassInstanceID,
+						uint64_t ReqCoverage,		// provider stops processing targets once accumulated coverage reaches this, 0 if no limit
+						uint64_t CurCoverage,		// coverage accumulated prior to this batch
+						uint32_t ProbeSeqLen,		// if > 0 then set this probe sequence before processing targets
+						etSeqBase *pProbeSeq,		// probe sequence
+						uint32_t NumTargs,			// batch contains this many targets
+						tsPBEBatchTarg *pBatchTargs);	// alignment parameters for each target, returned alignment results
+
 	int					//  -3: timeout waiting for job to complete, -2: parameter errors, -1: class instance no longer exists, 0: currently no available service instance 1: if job accepted and processed
 		RMI_CombinedTargAlign(tsThreadPBErrCorrect *pThreadPar, uint32_t Timeout,  uint64_t ClassInstanceID,
 						uint8_t PMode,              // processing mode: 0 error correct , 1 generate consensus from previously generated multiple alignments, 2  generate overlap detail from previously generated consensus sequences
@@ -587,7 +631,9 @@ public:
 	CPBErrCorrect();
 	~CPBErrCorrect();
 
-	int ThreadPBErrCorrect(tsThreadPBErrCorrect *pThreadPar);
+	int ThreadPBErrCorrect(tsThreadPBErrCorrect *pThreadPar,
+							uint32_t StartNodeOfs = 0,	// processing reads starting at this offset following the lowest completed read
+							uint32_t EndNodeOfs = 0);	// up to this offset (exclusive), 0 if processing all remaining reads
 
 	int
 	Process(etPBPMode PMode,		// processing mode
@@ -603,6 +649,8 @@ public:
 		int MaxSeedCoreDepth,		// only further process a seed core if there are no more than this number of matching cores in all targeted sequences
 		int MinSeedCoreLen,			// use seed cores of this length when identifying putative overlapping scaffold sequences
 		int MinNumSeedCores,        // require at least this many seed cores between overlapping scaffold sequences
+		int MinMzShared,			// if > 0 then prefilter putative overlaps with minimizer sketch, requiring at least this many shared diagonally consistent minimizers
+		int SWBandWidth,			// if > 0 then SW alignments are banded to this many bp either side of the core hit diagonals
 		int SWMatchScore,			// score for matching bases (0..50)
 		int SWMismatchPenalty,		// mismatch penalty (-50..0)
 		int SWGapOpenPenalty,		// gap opening penalty (-50..0)
@@ -633,7 +681,8 @@ public:
 		GenConsensusFromMAF(int MinErrCorrectLen,		// error corrected sequences must be at least this minimum length
 					 int MinConcScore,			// error corrected sequences trimmed until mean 100bp concensus score is at least this threshold
 					char *pszErrCorFile,		// name of file into which write error corrected sequences
-					char *pszMultiAlignFile);	// name of file containing multiple alignments to process
+					char *pszMultiAlignFile,	// name of file containing multiple alignments to process
+					int NumThreads);			// maximum number of worker threads to use
 
 };
 
@@ -31,6 +31,34 @@ Original 'BioKanga' copyright notice has been retained and is as follows.
 
 #include "SSW.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define _SSW_SSE2_ 1
+#endif
+
+// work pool thread function, context is the CSSW instance
+static int SSWMAFConsBlocks(void *pCtx, int64_t StartIdx, int64_t EndIdx, int WorkerIdx)
+{
+return(((CSSW *)pCtx)->MAFConsBlocks(StartIdx, EndIdx, WorkerIdx));
+}
+
+// batch processing thread, generates and writes consensus sequences for a batch of parsed multialignment blocks
+#ifdef _WIN32
+static unsigned __stdcall SSWMAFConsBatchThread(void * pThreadPars)
+#else
+static void *SSWMAFConsBatchThread(void * pThreadPars)
+#endif
+{
+tsMAFConsBatch *pBatch = (tsMAFConsBatch *)pThreadPars;			// makes it easier not having to deal with casts!
+pBatch->Rslt = pBatch->pThis->ProcMAFConsBatch(pBatch);
+#ifdef _WIN32
+_endthreadex(0);
+return(eBSFSuccess);
+#else
+pthread_exit(&pBatch->Rslt);
+#endif
+}
+
 CSSW::CSSW()
 {
 m_pAllocdCells = NULL;
@@ -42,8 +70,10 @@ m_pMAAlignOps = NULL;
 m_pAllWinScores = NULL;
 m_pParsimoniousBuff = NULL;
 m_pszMAFAlignBuff = NULL;
-m_pszConsensusBuff = NULL;
 m_pConsConfSeq = NULL;
+memset(m_MAFConsBatches,0,sizeof(m_MAFConsBatches));
+m_pMAFConsProcBatch = NULL;
+m_pPrefilterBuff = NULL;
 
 m_gzFile = NULL;
 m_hMAFFile = -1;
@@ -118,11 +148,14 @@ if(m_pParsimoniousBuff != NULL)
 if(m_pszMAFAlignBuff != NULL)
 	delete m_pszMAFAlignBuff;
 
-if(m_pszConsensusBuff != NULL)
-	delete m_pszConsensusBuff;
-
 if(m_pConsConfSeq != NULL)
 	delete m_pConsConfSeq;
+
+WaitMAFConsBatch();
+FreeMAFConsBatches();
+
+if(m_pPrefilterBuff != NULL)
+	delete []m_pPrefilterBuff;
 }
 
 void 
@@ -172,17 +205,15 @@ if(m_pMAAlignOps != NULL)
 	m_pMAAlignOps = NULL;
 	}
 
-if(m_pszConsensusBuff != NULL)
-	{
-	delete m_pszConsensusBuff;
-	m_pszConsensusBuff = NULL;
-	}
-
 if(m_pConsConfSeq != NULL)
 	{
 	delete m_pConsConfSeq;
 	m_pConsConfSeq = NULL;
 	}
+WaitMAFConsBatch();
+FreeMAFConsBatches();
+m_MAFConsMinConf = 0;
+m_MAFConsMinLen = 0;
 if(m_pParsimoniousBuff != NULL)
 	{
 	delete m_pParsimoniousBuff;
@@ -195,6 +226,13 @@ if(m_pAllWinScores != NULL)
 	m_pAllWinScores = NULL;
 	}
 
+if(m_pPrefilterBuff != NULL)
+	{
+	delete []m_pPrefilterBuff;
+	m_pPrefilterBuff = NULL;
+	}
+m_PrefilterBuffSize = 0;
+
 if(m_pProbe != NULL)
 	{
 	delete m_pProbe;
@@ -277,6 +315,10 @@ m_ProgPenaliseGapExtn = cSSWDfltProgPenaliseGapExtn;
 m_AnchorLen = cSSWDfltAnchorLen;
 m_MaxInitiatePathOfs = cMaxInitiatePathOfs;
 m_MinNumExactMatches = cMinNumExactMatches;
+m_PrefilterPct = cSSWDfltPrefilterPct;
+m_BandWidth = 0;
+m_BandMaxRowCells = 0;
+m_NumAnchors = 0;
 m_MaxTopNPeakMatches = 0;
 m_NumTopNPeakMatches = 0;
 m_bStartedMultiAlignments = false;
@@ -302,6 +344,59 @@ m_MinNumExactMatches = MinNumExactMatches;
 return(true);
 }
 
+bool 
+CSSW::SetPrefilterPct(int PrefilterPct)		// score-only prefilter threshold as a percentage (0 to disable) of the score for an exactly matching overlap of minimum overlap length
+{
+if(PrefilterPct < 0 || PrefilterPct > cSSWMaxPrefilterPct)
+	return(false);
+m_PrefilterPct = PrefilterPct;
+return(true);
+}
+
+// Banded alignments only process cells within BandWidth either side of the diagonals of a chain of anchors, such as seed core hits, so
+// time and traceback memory are proportional to the probe length times the band rather than to the probe length times the target length
+// Between consecutive anchors the band spans both anchor diagonals, allowing for InDels accumulated between the anchors
+bool 
+CSSW::SetAnchorBand(uint32_t BandWidth,			// subsequent alignments banded to this many bp either side of the anchor diagonals, 0 to disable banding
+					uint32_t NumAnchors,		// number of anchors in chain, 0 to disable banding
+					tsSSWAnchor *pAnchors)		// chain of anchors, ascending probe and target offsets
+{
+uint32_t Idx;
+uint32_t RowCells;
+int64_t DiagDelta;
+tsSSWAnchor *pAnchor;
+
+m_BandWidth = 0;
+m_BandMaxRowCells = 0;
+m_NumAnchors = 0;
+if(BandWidth == 0 || NumAnchors == 0)
+	return(true);
+if(BandWidth < (uint32_t)cSSWMinBandWidth || BandWidth > (uint32_t)cSSWMaxBandWidth || NumAnchors > (uint32_t)cSSWMaxAnchors || pAnchors == NULL)
+	return(false);
+
+RowCells = (BandWidth * 4) + 1;		// before the first or after the last anchor the band can be at most doubled
+pAnchor = pAnchors;
+for(Idx = 0; Idx < NumAnchors; Idx++, pAnchor++)
+	{
+	if(pAnchor->ProbeOfs > cSSWMaxProbeOrTargLen || pAnchor->TargOfs > cSSWMaxProbeOrTargLen)
+		return(false);
+	if(Idx == 0)
+		continue;
+	if(pAnchor->ProbeOfs <= pAnchor[-1].ProbeOfs || pAnchor->TargOfs <= pAnchor[-1].TargOfs)	// chain must be strictly ascending
+		return(false);
+	DiagDelta = ((int64_t)pAnchor->TargOfs - pAnchor->ProbeOfs) - ((int64_t)pAnchor[-1].TargOfs - pAnchor[-1].ProbeOfs);
+	if(DiagDelta < 0)
+		DiagDelta = -DiagDelta;
+	if((DiagDelta + (BandWidth * 2) + 1) > RowCells)
+		RowCells = (uint32_t)(DiagDelta + (BandWidth * 2) + 1);
+	}
+memcpy(m_Anchors,pAnchors,sizeof(tsSSWAnchor) * NumAnchors);
+m_NumAnchors = NumAnchors;
+m_BandWidth = BandWidth;
+m_BandMaxRowCells = RowCells;
+return(true);
+}
+
 bool 
 CSSW::SetTopNPeakMatches(int MaxTopNPeakMatches)		// can process for at most this many peak matches in any probe vs target SW alignment
 {
@@ -418,12 +513,19 @@ bool bProvContained;
 bool bAddedMultiAlignment;
 
 memset(pAlignRet,0,sizeof(tsCombinedTargAlignRet));
+if(!SetAnchorBand(pAlignPars->BandWidth,pAlignPars->NumAnchors,pAlignPars->Anchors))
+	{
+	pAlignRet->ProcPhase = 1;
+	pAlignRet->ErrRslt = eBSFerrParams;
+	return(false);
+	}
 bRslt = CombinedTargAlign(pAlignPars->PMode,pAlignPars->NumTargSeqs,pAlignPars->ProbeSeqLen,pAlignPars->TargFlags,
 								pAlignPars->TargSeqLen,pAlignPars->pTargSeq,
 								pAlignPars->ProbeStartRelOfs,pAlignPars->TargStartRelOfs,pAlignPars->ProbeRelLen,pAlignPars->TargRelLen,
 								pAlignPars->OverlapFloat,pAlignPars->MaxArtefactDev,pAlignPars->MinOverlapLen,pAlignPars->MaxOverlapLen,
 								&RetProcPhase,&ErrRslt,
 								&Class,&PeakMatchesCell,&ProbeAlignLength,&TargAlignLength,&bProvOverlapping,&bProvArtefact,&bProvContained,&bAddedMultiAlignment);
+SetAnchorBand(0);			// band only applies to this target
 pAlignRet->ErrRslt = ErrRslt;
 pAlignRet->ProcPhase = RetProcPhase;
 pAlignRet->Class = Class;
@@ -514,7 +616,7 @@ if((Rslt = SetAlignRange(ProbeStartRelOfs,TargStartRelOfs,ProbeRelLen,TargRelLen
 	return(false);
 	}
 
-pPeakMatchesCell = Align(NULL,MaxOverlapLen);
+pPeakMatchesCell = Align(NULL,MaxOverlapLen,MinOverlapLen);
 
 if(pPeakMatchesCell != NULL && pPeakMatchesCell->NumMatches >= (MinOverlapLen/2) &&
 	pPeakMatchesCell->PFirstAnchorStartOfs > 0 && pPeakMatchesCell->PFirstAnchorStartOfs < pPeakMatchesCell->PLastAnchorEndOfs &&
@@ -696,7 +798,10 @@ if(m_pAllocdCells == NULL || (m_AllocdCells < (MaxTargLen + 5)))  // allowing a
 
 if(MaxOverlapLen > 0)
 	{
-    MaxAllocdTracebacks = min(MaxOverlapLen * (uint64_t)10000, (uint64_t)(0x7fff0000 / 8));
+	if(m_NumAnchors > 0)		// banded alignments only require tracebacks for cells within the band
+		MaxAllocdTracebacks = min(MaxOverlapLen * (uint64_t)min(10000u,m_BandMaxRowCells), (uint64_t)(0x7fff0000 / 8));
+	else
+		MaxAllocdTracebacks = min(MaxOverlapLen * (uint64_t)10000, (uint64_t)(0x7fff0000 / 8));
 
 	if(m_pAllocdTracebacks != NULL && (MaxAllocdTracebacks + 100) >  m_AllocdTracebacks)
 		{
@@ -1004,9 +1109,311 @@ m_TargRelLen = TargRelLen;
 return(eBSFSuccess);
 }
 
+// Score-only striped (Farrar) local alignment used to prefilter probe vs target pairs before the full cell based alignment in Align()
+// The scoring is an upper bound on that which Align() would score for the same path, mismatches are penalised no more than a gap opening, gap extensions
+// are only penalised if Align() would be penalising from the 2nd base in a gap, and paths can only be started within m_MaxInitiatePathOfs.
+// Scores are 16bit and saturate at 0x7fff
+int32_t											// peak score, saturates at 0x7fff, or -1 if errors
+CSSW::PrefilterScore(uint32_t ProbeRelLen,		// score-only local alignment of this probe relative length starting from m_ProbeStartRelOfs
+					uint32_t TargRelLen)			// against this target relative length starting from m_TargStartRelOfs
+{
+const int cNumSyms = 8;						// bases, with cRptMskFlg removed, are in the range 0..7
+const int16_t cDead = -0x8000;				// cells not on a path and from which no new path can be started are set to this score
+uint32_t IdxP;
+uint32_t IdxT;
+uint32_t SegLen;
+uint32_t AllocReq;
+int Sym;
+int MatchScore;
+int MismatchPenalty;
+int GapOpenPenalty;
+int GapExtnPenalty;
+int32_t PeakScore;
+int32_t ColPeakScore;
+uint32_t MaxInitiatePathOfs;
+etSeqBase *pProbe;
+etSeqBase *pTarg;
+etSeqBase TargBase;
+
+if(ProbeRelLen == 0 || TargRelLen == 0)
+	return(-1);
+
+MatchScore = m_MatchScore;
+MismatchPenalty = max(m_MismatchPenalty,m_GapOpenPenalty);	// Align() may reduce the mismatch penalty to that of a gap opening 
+GapOpenPenalty = m_GapOpenPenalty;
+GapExtnPenalty = m_DlyGapExtn <= 2 ? m_GapExtnPenalty : 0;		// gap extension penalties delayed past 2nd base in gap would be underestimated
+MaxInitiatePathOfs = m_MaxInitiatePathOfs == 0 ? 0xffffffff : (uint32_t)m_MaxInitiatePathOfs;
+pProbe = &m_pProbe[m_ProbeStartRelOfs];
+pTarg = &m_pTarg[m_TargStartRelOfs];
+PeakScore = 0;
+
+#ifdef _SSW_SSE2_
+uint32_t SegIdx;
+int Lane;
+int LazyIter;
+__m128i *pProfile;
+__m128i *pHStore;
+__m128i *pHLoad;
+__m128i *pHSwap;
+__m128i *pE;
+__m128i *pFloor;
+__m128i *pCurProfile;
+__m128i vH;
+__m128i vE;
+__m128i vF;
+__m128i vHGap;
+__m128i vMsk;
+__m128i vFloor;
+__m128i vColMax;
+__m128i vZero = _mm_setzero_si128();
+__m128i vDead = _mm_set1_epi16(cDead);
+__m128i vGapOpen = _mm_set1_epi16((int16_t)GapOpenPenalty);
+__m128i vGapExtn = _mm_set1_epi16((int16_t)GapExtnPenalty);
+int16_t *pScore;
+bool bInitRegion;
+
+SegLen = (ProbeRelLen + 7) / 8;
+AllocReq = (uint32_t)((sizeof(__m128i) * SegLen * (cNumSyms + 4)) + sizeof(__m128i));
+if(m_pPrefilterBuff == NULL || m_PrefilterBuffSize < AllocReq)
+	{
+	if(m_pPrefilterBuff != NULL)
+		delete []m_pPrefilterBuff;
+	AllocReq += AllocReq / 4;			// some headroom to reduce number of reallocations as probe lengths vary
+	if((m_pPrefilterBuff = new uint8_t [AllocReq]) == NULL)
+		{
+		m_PrefilterBuffSize = 0;
+		return(-1);
+		}
+	m_PrefilterBuffSize = AllocReq;
+	}
+pProfile = (__m128i *)(((size_t)m_pPrefilterBuff + sizeof(__m128i) - 1) & ~(size_t)(sizeof(__m128i) - 1));
+pHStore = &pProfile[SegLen * cNumSyms];
+pHLoad = &pHStore[SegLen];
+pE = &pHLoad[SegLen];
+pFloor = &pE[SegLen];
+
+// striped query profile over the probe, lane Lane of segment SegIdx is for probe index (Lane * SegLen) + SegIdx
+// also initialising the per cell floor scores to which cells are reset if not on a path, only cells within m_MaxInitiatePathOfs can start new paths
+for(Sym = 0; Sym < cNumSyms; Sym++)
+	{
+	pScore = (int16_t *)&pProfile[Sym * SegLen];
+	for(SegIdx = 0; SegIdx < SegLen; SegIdx++)
+		for(Lane = 0; Lane < 8; Lane++)
+			{
+			IdxP = (Lane * SegLen) + SegIdx;
+			if(IdxP >= ProbeRelLen)
+				*pScore++ = (int16_t)-1000;			// never want paths to extend into padding past end of probe
+			else
+				*pScore++ = (int16_t)((pProbe[IdxP] & ~cRptMskFlg) == Sym ? MatchScore : MismatchPenalty);
+			}
+	}
+pScore = (int16_t *)pFloor;
+for(SegIdx = 0; SegIdx < SegLen; SegIdx++)
+	for(Lane = 0; Lane < 8; Lane++)
+		*pScore++ = (Lane * SegLen) + SegIdx < MaxInitiatePathOfs ? 0 : cDead;
+
+for(SegIdx = 0; SegIdx < SegLen; SegIdx++)
+	{
+	pHStore[SegIdx] = pFloor[SegIdx];
+	pE[SegIdx] = vDead;
+	}
+
+for(IdxT = 0; IdxT < TargRelLen; IdxT++)
+	{
+	TargBase = *pTarg++ & ~cRptMskFlg;
+	pCurProfile = &pProfile[(TargBase & (cNumSyms - 1)) * SegLen];
+	bInitRegion = IdxT < MaxInitiatePathOfs;
+
+	vF = vDead;
+	vColMax = vDead;
+	vH = _mm_slli_si128(pHStore[SegLen - 1],2);	// diagonal for lane 0 is from the last segment of the previous lane
+	vH = _mm_insert_epi16(vH,bInitRegion ? 0 : cDead,0);
+	pHSwap = pHLoad; pHLoad = pHStore; pHStore = pHSwap;
+	for(SegIdx = 0; SegIdx < SegLen; SegIdx++)
+		{
+		vH = _mm_adds_epi16(vH,pCurProfile[SegIdx]);
+		vE = pE[SegIdx];
+		vH = _mm_max_epi16(vH,vE);
+		vH = _mm_max_epi16(vH,vF);
+		vFloor = bInitRegion ? pFloor[SegIdx] : vDead;
+		vMsk = _mm_cmpgt_epi16(vH,vZero);		// paths terminate if scores not above 0
+		vH = _mm_or_si128(_mm_and_si128(vMsk,vH),_mm_andnot_si128(vMsk,vFloor));
+		vColMax = _mm_max_epi16(vColMax,vH);
+		pHStore[SegIdx] = vH;
+
+		vHGap = _mm_adds_epi16(vH,vGapOpen);
+		vE = _mm_max_epi16(_mm_adds_epi16(vE,vGapExtn),vHGap);
+		pE[SegIdx] = vE;
+		vF = _mm_max_epi16(_mm_adds_epi16(vF,vGapExtn),vHGap);
+		vH = pHLoad[SegIdx];
+		}
+
+	// lazy F loop, vertical gaps crossing from one lane into the next
+	for(LazyIter = 0; LazyIter < 8; LazyIter++)
+		{
+		vF = _mm_slli_si128(vF,2);
+		vF = _mm_insert_epi16(vF,cDead,0);
+		for(SegIdx = 0; SegIdx < SegLen; SegIdx++)
+			{
+			vH = _mm_max_epi16(pHStore[SegIdx],vF);
+			vFloor = bInitRegion ? pFloor[SegIdx] : vDead;
+			vMsk = _mm_cmpgt_epi16(vH,vZero);
+			vH = _mm_or_si128(_mm_and_si128(vMsk,vH),_mm_andnot_si128(vMsk,vFloor));
+			vColMax = _mm_max_epi16(vColMax,vH);
+			pHStore[SegIdx] = vH;
+			vHGap = _mm_adds_epi16(vH,vGapOpen);
+			pE[SegIdx] = _mm_max_epi16(pE[SegIdx],vHGap);
+			vF = _mm_adds_epi16(vF,vGapExtn);
+			if(!_mm_movemask_epi8(_mm_cmpgt_epi16(vF,vHGap)))
+				break;
+			}
+		if(SegIdx < SegLen)
+			break;
+		}
+
+	vColMax = _mm_max_epi16(vColMax,_mm_srli_si128(vColMax,8));
+	vColMax = _mm_max_epi16(vColMax,_mm_srli_si128(vColMax,4));
+	vColMax = _mm_max_epi16(vColMax,_mm_srli_si128(vColMax,2));
+	ColPeakScore = (int16_t)_mm_extract_epi16(vColMax,0);
+	if(ColPeakScore > PeakScore)
+		{
+		PeakScore = ColPeakScore;
+		if(PeakScore == 0x07fff)		// saturated, no point in continuing
+			break;
+		}
+	}
+#else
+// no SIMD support so score-only alignment using scalar row scores
+int32_t *pHRow;
+int32_t *pERow;
+int32_t HDiag;
+int32_t HUp;
+int32_t H;
+int32_t E;
+int32_t F;
+int32_t Floor;
+
+AllocReq = (uint32_t)(sizeof(int32_t) * 2 * (ProbeRelLen + 1));
+if(m_pPrefilterBuff == NULL || m_PrefilterBuffSize < AllocReq)
+	{
+	if(m_pPrefilterBuff != NULL)
+		delete []m_pPrefilterBuff;
+	AllocReq += AllocReq / 4;
+	if((m_pPrefilterBuff = new uint8_t [AllocReq]) == NULL)
+		{
+		m_PrefilterBuffSize = 0;
+		return(-1);
+		}
+	m_PrefilterBuffSize = AllocReq;
+	}
+pHRow = (int32_t *)m_pPrefilterBuff;
+pERow = &pHRow[ProbeRelLen + 1];
+for(IdxP = 0; IdxP <= ProbeRelLen; IdxP++)
+	{
+	pHRow[IdxP] = IdxP < MaxInitiatePathOfs ? 0 : cDead;
+	pERow[IdxP] = cDead;
+	}
+for(IdxT = 0; IdxT < TargRelLen; IdxT++)
+	{
+	TargBase = *pTarg++ & ~cRptMskFlg;
+	HDiag = IdxT < MaxInitiatePathOfs ? 0 : cDead;
+	F = cDead;
+	HUp = cDead;
+	for(IdxP = 0; IdxP < ProbeRelLen; IdxP++)
+		{
+		Floor = (IdxT < MaxInitiatePathOfs && IdxP < MaxInitiatePathOfs) ? 0 : cDead;
+		E = pERow[IdxP];
+		H = HDiag + ((pProbe[IdxP] & ~cRptMskFlg) == TargBase ? MatchScore : MismatchPenalty);
+		F = max(F + GapExtnPenalty,HUp + GapOpenPenalty);
+		if(E > H)
+			H = E;
+		if(F > H)
+			H = F;
+		if(H <= 0)
+			H = Floor;
+		HDiag = pHRow[IdxP];
+		pHRow[IdxP] = H;
+		pERow[IdxP] = max(E + GapExtnPenalty,H + GapOpenPenalty);
+		HUp = H;
+		if(H > PeakScore)
+			{
+			PeakScore = min(H,(int32_t)0x07fff);
+		}
+	}
+#endif
+return(PeakScore);
+}
+
+// determine the band of target cells to be processed for a probe row when banded aligning
+// band spans the diagonals of the anchors bracketing the row plus m_BandWidth either side, rows before the first or after the last anchor
+// use that anchor's diagonal with the band widened in proportion to the distance from that anchor so as to allow for accumulated InDels
+void
+CSSW::BandLimits(uint32_t IdxP,				// determine the band for this probe relative row
+				uint32_t TargRelLen,		// clamping to this target relative length
+				uint32_t *pAnchorIdx,		// current anchor, rows are processed in ascending order so anchors are iterated
+				uint32_t *pStartIdxT,		// returned target relative start of band
+				uint32_t *pEndIdxT)			// returned target relative end of band (exclusive)
+{
+uint32_t AnchorIdx;
+int64_t ProbeOfs;
+int64_t DiagLo;
+int64_t DiagHi;
+int64_t BandPad;
+int64_t StartIdxT;
+int64_t EndIdxT;
+tsSSWAnchor *pAnchor;
+
+ProbeOfs = (int64_t)m_ProbeStartRelOfs + IdxP;
+AnchorIdx = *pAnchorIdx;
+while(AnchorIdx < m_NumAnchors && (int64_t)m_Anchors[AnchorIdx].ProbeOfs <= ProbeOfs)
+	AnchorIdx += 1;
+*pAnchorIdx = AnchorIdx;
+
+if(AnchorIdx == 0)						// row is before the first anchor
+	{
+	pAnchor = &m_Anchors[0];
+	DiagLo = DiagHi = (int64_t)pAnchor->TargOfs - pAnchor->ProbeOfs;
+	BandPad = m_BandWidth + min((int64_t)m_BandWidth,(((int64_t)pAnchor->ProbeOfs - ProbeOfs) * cSSWBandDriftPct) / 100);
+	}
+else
+	{
+	if(AnchorIdx == m_NumAnchors)		// row is after the last anchor
+		{
+		pAnchor = &m_Anchors[m_NumAnchors - 1];
+		DiagLo = DiagHi = (int64_t)pAnchor->TargOfs - pAnchor->ProbeOfs;
+		BandPad = m_BandWidth + min((int64_t)m_BandWidth,((ProbeOfs - pAnchor->ProbeOfs) * cSSWBandDriftPct) / 100);
+		}
+	else								// row is bracketed by anchors
+		{
+		pAnchor = &m_Anchors[AnchorIdx - 1];
+		DiagLo = (int64_t)pAnchor->TargOfs - pAnchor->ProbeOfs;
+		DiagHi = (int64_t)pAnchor[1].TargOfs - pAnchor[1].ProbeOfs;
+		if(DiagLo > DiagHi)
+			{
+			int64_t Xchg = DiagLo;
+			DiagLo = DiagHi;
+			DiagHi = Xchg;
+			}
+		BandPad = m_BandWidth;
+		}
+	}
+
+StartIdxT = ProbeOfs + DiagLo - BandPad - m_TargStartRelOfs;
+EndIdxT = ProbeOfs + DiagHi + BandPad + 1 - m_TargStartRelOfs;
+if(StartIdxT < 0)
+	StartIdxT = 0;
+if(EndIdxT > (int64_t)TargRelLen)
+	EndIdxT = TargRelLen;
+if(StartIdxT > EndIdxT)					// band is outside of target range for this row
+	StartIdxT = EndIdxT = max((int64_t)0,min(StartIdxT,(int64_t)TargRelLen));
+*pStartIdxT = (uint32_t)StartIdxT;
+*pEndIdxT = (uint32_t)EndIdxT;
+}
+
 tsSSWCell *								// smith-waterman style local alignment, returns highest accumulated exact matches cell
 CSSW::Align(tsSSWCell *pPeakScoreCell,	// optionally also return conventional peak scoring cell
-				uint32_t MaxOverlapLen)	// process tracebacks for this maximal expected overlap, 0 if no tracebacks required
+				uint32_t MaxOverlapLen,	// process tracebacks for this maximal expected overlap, 0 if no tracebacks required
+				uint32_t MinOverlapLen)	// if non-zero then prefilter with a score-only alignment, full alignment only if prefilter score could be from an overlap of at least this length
 {
 uint32_t IdxP;							// current index into m_Probe[]
 uint32_t IdxT;							// current index into m_Targ[]
@@ -1020,6 +1427,15 @@ uint32_t CurMinIdxT;
 uint32_t CurMaxIdxT;
 uint32_t LastCheckedIdxT;
 
+bool bBanded;
+uint32_t AnchorIdx;
+uint32_t BandStartIdxT;
+uint32_t BandEndIdxT;
+uint32_t PrevBandStartIdxT;
+uint32_t PrevBandEndIdxT;
+uint32_t RowCells;
+uint64_t NumBandCells;
+
 uint32_t TargRelLen;
 uint32_t ProbeRelLen;
 
@@ -1060,6 +1476,7 @@ if(m_ProbeLen < cSSWMinProbeOrTargLen || m_ProbeLen > cSSWMaxProbeOrTargLen ||
 	return(NULL);	
 
 bNoTracebacks = MaxOverlapLen == 0 ? true : false;
+bBanded = (m_NumAnchors > 0 && m_BandWidth > 0) ? true : false;
 
 if(m_ProbeRelLen == 0)
 	ProbeRelLen = m_ProbeLen - m_ProbeStartRelOfs;	
@@ -1080,6 +1497,29 @@ if(m_TargRelLen > m_TargLen || m_ProbeRelLen > m_ProbeLen)
 memset(&m_PeakMatchesCell,0,sizeof(m_PeakMatchesCell));
 memset(&m_PeakScoreCell,0,sizeof(m_PeakScoreCell));
 
+// most probe vs target pairs are not overlapping so prefilter with a score-only alignment, only if the prefilter peak score
+// is at least m_PrefilterPct of that for an exactly matching MinOverlapLen overlap will the full alignment be processed
+// the prefilter only accepts or rejects, the full alignment is over the original extents as the overlap is classified from the
+// peak matches cell which can start before and end after the prefilter's peak score cell
+// banded alignments are not prefiltered, the prefilter would be processing the full probe x target rectangle which the band is avoiding
+if(MinOverlapLen > 0 && m_PrefilterPct > 0 && m_MaxTopNPeakMatches == 0 && !bBanded)
+	{
+	int32_t PrefilterMinScore;
+	int32_t PrefilterPeakScore;
+
+	PrefilterMinScore = (int32_t)min((int64_t)0x07fff, ((int64_t)MinOverlapLen * m_MatchScore * m_PrefilterPct) / 100);
+	if((PrefilterPeakScore = PrefilterScore(ProbeRelLen,TargRelLen)) >= 0) // if errors then fall back to processing the full alignment
+		{
+		CRunProfile::Count(eRPCSWPrefilterCells,(int64_t)ProbeRelLen * TargRelLen);
+		if(PrefilterPeakScore < PrefilterMinScore)
+			{
+			m_UsedCells = 0;
+			m_UsedTracebacks = 0;
+			return(&m_PeakMatchesCell);
+			}
+		}
+	}
+
 // allocating to hold full length even if relative length a lot shorter to reduce number of reallocations which may be subsequently required
 if(((m_AllocdCells + 5 < m_TargLen) || (!bNoTracebacks && m_pAllocdTracebacks == NULL)) &&  
 	!PreAllocMaxTargLen(m_TargLen,MaxOverlapLen))
@@ -1111,26 +1551,36 @@ NumCellsChecked = 0;
 LastCheckedIdxT = m_MaxInitiatePathOfs + 10;
 m_UsedTracebacks = 0;
 NxtMinIdxT = 0;
+AnchorIdx = 0;
+BandStartIdxT = 0;
+BandEndIdxT = TargRelLen;
+PrevBandStartIdxT = 0;
+PrevBandEndIdxT = bBanded ? 0 : TargRelLen;	// when banded then cells outside of the band are maintained as zeroed
+NumBandCells = 0;
 pTraceback = m_pAllocdTracebacks;						// NOTE: NULL if tracebacks not required
 pProbe = &m_pProbe[m_ProbeStartRelOfs];
 for(IdxP = 0; IdxP < ProbeRelLen; IdxP++)
 	{
-	if(m_pAllocdTracebacks != NULL && (m_UsedTracebacks + 10) > (m_AllocdTracebacks - TargRelLen)) // ensure that sufficient memory has been allocated to hold any tracebacks in next sweep over the target
+	if(bBanded)
+		BandLimits(IdxP,TargRelLen,&AnchorIdx,&BandStartIdxT,&BandEndIdxT);
+	RowCells = BandEndIdxT - BandStartIdxT;
+
+	if(m_pAllocdTracebacks != NULL && (m_UsedTracebacks + 10 + RowCells) > m_AllocdTracebacks) // ensure that sufficient memory has been allocated to hold any tracebacks in next sweep over the target
 		{
 		// try to reduce the number of tracebacks
 		ResetTracebackFlags();
 		if(m_PeakMatchesCell.PeakScore > 0)  // peak scoring cell's path may have already terminated so mark that independently of those still in m_pAllocdCells[]
 			MarkTracebackPath(cTrBkFlgRetain,m_PeakMatchesCell.EndPOfs,m_PeakMatchesCell.EndTOfs);
-		pCell = m_pAllocdCells;
-		for(IdxT = 0; IdxT < TargRelLen; IdxT++,pCell++)
+		pCell = &m_pAllocdCells[PrevBandStartIdxT];
+		for(IdxT = PrevBandStartIdxT; IdxT < PrevBandEndIdxT; IdxT++,pCell++)
 			{
 			if(pCell->PeakScore > 0)
 				MarkTracebackPath(cTrBkFlgRetain,pCell->EndPOfs,pCell->EndTOfs);
 			}
 		ReduceTracebacks(cTrBkFlgRetain,cTrBkFlgRetain);
-		if((m_UsedTracebacks + 10) > (m_AllocdTracebacks - TargRelLen))
+		if((m_UsedTracebacks + 10 + RowCells) > m_AllocdTracebacks)
 			{
-			trbsreq = min((m_AllocdTracebacks + (TargRelLen * 6000)), (uint64_t)(0x7fff0000 / 8));
+			trbsreq = min((m_AllocdTracebacks + ((uint64_t)(bBanded ? m_BandMaxRowCells : TargRelLen) * 6000)), (uint64_t)(0x7fff0000 / 8));
 			if(trbsreq <= m_AllocdTracebacks)
 				{
 				gDiagnostics.DiagOut(eDLFatal,gszProcName,"Align: too many traceback cells required");
@@ -1161,11 +1611,29 @@ for(IdxP = 0; IdxP < ProbeRelLen; IdxP++)
 
 	ProbeBase = *pProbe++ & ~cRptMskFlg;
 	StartIdxT = 0;
-	CurMaxIdxT = min(TargRelLen,LastCheckedIdxT+2);
-	CurMinIdxT = NxtMinIdxT;
-	NxtMinIdxT = 0;
 	memset(&LeftCell, 0, sizeof(tsSSWCell));
 	memset(&DiagCell, 0, sizeof(tsSSWCell));
+	if(bBanded)
+		{
+		CurMinIdxT = BandStartIdxT;
+		CurMaxIdxT = BandEndIdxT;
+		if(CurMinIdxT > 0)				// diagonal for the first cell in band is from the previous row
+			LeftCell = m_pAllocdCells[CurMinIdxT - 1];
+		// reset any cells which were in the previous row's band but are outside of the band for this row
+		if(PrevBandStartIdxT < min(CurMinIdxT,PrevBandEndIdxT))
+			memset(&m_pAllocdCells[PrevBandStartIdxT],0,(min(CurMinIdxT,PrevBandEndIdxT) - PrevBandStartIdxT) * sizeof(tsSSWCell));
+		if(max(CurMaxIdxT,PrevBandStartIdxT) < PrevBandEndIdxT)
+			memset(&m_pAllocdCells[max(CurMaxIdxT,PrevBandStartIdxT)],0,(PrevBandEndIdxT - max(CurMaxIdxT,PrevBandStartIdxT)) * sizeof(tsSSWCell));
+		PrevBandStartIdxT = CurMinIdxT;
+		PrevBandEndIdxT = CurMaxIdxT;
+		NumBandCells += RowCells;
+		}
+	else
+		{
+		CurMaxIdxT = min(TargRelLen,LastCheckedIdxT+2);
+		CurMinIdxT = NxtMinIdxT;
+		NxtMinIdxT = 0;
+		}
 	if(CurMinIdxT >= m_AllocdCells || CurMaxIdxT >= m_AllocdCells)
 		{
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Align: Allocated for %u Cells but CurMinIdxT is %u and CurMaxIdxT is %u",m_AllocdCells,CurMinIdxT,CurMaxIdxT);
@@ -1536,6 +2004,7 @@ if(pPeakScoreCell != NULL)
 #endif
 if(m_PeakMatchesCell.PFirstAnchorStartOfs == 0 || (m_PeakMatchesCell.PFirstAnchorStartOfs + 10) > m_PeakMatchesCell.PLastAnchorEndOfs)
 	memset(&m_PeakMatchesCell,0,sizeof(m_PeakMatchesCell));
+CRunProfile::Count(eRPCSWCells,bBanded ? (int64_t)NumBandCells : (int64_t)ProbeRelLen * TargRelLen);
 return(&m_PeakMatchesCell);
 } 
 
@@ -1718,8 +2187,11 @@ return(BuffOfs);
 int    // total number of returned chars in pszBuffer for the textual representation of error corrected consensus sequence (could be multiple consensus sequences)
 CSSW::ConsConfSeq2Seqs(uint32_t ProbeID,	// identifies sequence which was used as the probe when determining the multialignments
 					int MinConf,		// sequence bases averaged over a m_ConfWin window must be of at least this confidence (0..9) with the initial and final bases having at least this confidence
-				  int MinLen)			// and sequence lengths must be of at least this length 
+				  int MinLen,			// and sequence lengths must be of at least this length 
+				  tsConfBase *pConsConfSeq,	// parsed consensus bases and confidence scores, terminated by eBaseEOS
+				  char *pszConsensusBuff)	// write consensus sequences into this buffer, must be sized to hold at least 2x the number of parsed consensus bases plus 200 chars
 {
+int ErrCorSeqID;
 int CurSeqLen;
 int MaxCurSeqLen;
 int LineLen;
@@ -1747,10 +2219,10 @@ LineLen = 0;
 BuffOfs = 0;
 StartBuffOfs = 0;
 BelowMinConfBuffOfs = 0;
-pBuff = m_pszConsensusBuff;
-m_ErrCorSeqID = 0;
+pBuff = pszConsensusBuff;
+ErrCorSeqID = 0;
 
-pCol = (tsConfBase *)m_pConsConfSeq;
+pCol = pConsConfSeq;
 while((Base = pCol->Base) != eBaseEOS)
 	{
 	if(Base <= eBaseN && !(CurSeqLen == 0 && MinConf > (int)pCol->Conf))
@@ -1765,7 +2237,7 @@ while((Base = pCol->Base) != eBaseEOS)
 			BelowMinConfBuffOfs = 0;
 			StartBuffOfs = BuffOfs;							// note where in buffer this potential sequence started in case sequence later needs to be retracted because it is not at least MinLen long
 			NewSeqStartOfs = BuffOfs;
-			pBuff = &m_pszConsensusBuff[BuffOfs];
+			pBuff = &pszConsensusBuff[BuffOfs];
 			}
 
 		switch(Base) {                                      
@@ -1819,26 +2291,26 @@ while((Base = pCol->Base) != eBaseEOS)
 					{
 					CurSeqLen -= BuffOfs - BelowMinConfBuffOfs; 
 					BuffOfs = BelowMinConfBuffOfs;	
-					pBuff = &m_pszConsensusBuff[BuffOfs];
+					pBuff = &pszConsensusBuff[BuffOfs];
 
 					if(CurSeqLen < MinLen)							// if sequence is now not of an acceptable length then slough the sequence 
 						{
 						BuffOfs = StartBuffOfs;
-						pBuff = &m_pszConsensusBuff[BuffOfs];
+						pBuff = &pszConsensusBuff[BuffOfs];
 						}
 					else    // else accepting sequence
 						{
-						m_ErrCorSeqID += 1;
-						if(m_ErrCorSeqID == 1)
-							DescrLen = sprintf(szDescrLine,">ecseq%u_%d %d|%d\n",ProbeID,m_ErrCorSeqID,CurSeqLen,MinConf);
+						ErrCorSeqID += 1;
+						if(ErrCorSeqID == 1)
+							DescrLen = sprintf(szDescrLine,">ecseq%u_%d %d|%d\n",ProbeID,ErrCorSeqID,CurSeqLen,MinConf);
 						else
-							DescrLen = sprintf(szDescrLine,"\n>ecseq%u_%d %d|%d\n",ProbeID,m_ErrCorSeqID,CurSeqLen,MinConf);	
-						pBuff = &m_pszConsensusBuff[NewSeqStartOfs];
+							DescrLen = sprintf(szDescrLine,"\n>ecseq%u_%d %d|%d\n",ProbeID,ErrCorSeqID,CurSeqLen,MinConf);	
+						pBuff = &pszConsensusBuff[NewSeqStartOfs];
 						memmove(pBuff + DescrLen,pBuff,BuffOfs - NewSeqStartOfs);	// make room for an inserted fasta descriptor line
 						memcpy(pBuff,szDescrLine,DescrLen);
 						BuffOfs += DescrLen;
 						NewSeqStartOfs = BuffOfs;
-						pBuff = &m_pszConsensusBuff[BuffOfs];
+						pBuff = &pszConsensusBuff[BuffOfs];
 						}
 					CurSeqLen = 0;
 					ConsIdx = 0;
@@ -1858,25 +2330,25 @@ if(CurSeqLen > 0)
 		BuffOfs = StartBuffOfs;
 	else    // else accepting sequence
 		{
-		m_ErrCorSeqID += 1;
-		if(m_ErrCorSeqID == 1)
-			DescrLen = sprintf(szDescrLine,">ecseq%u_%d %d|%d\n",ProbeID,m_ErrCorSeqID,CurSeqLen,MinConf);
+		ErrCorSeqID += 1;
+		if(ErrCorSeqID == 1)
+			DescrLen = sprintf(szDescrLine,">ecseq%u_%d %d|%d\n",ProbeID,ErrCorSeqID,CurSeqLen,MinConf);
 		else
-			DescrLen = sprintf(szDescrLine,"\n>ecseq%u_%d %d|%d\n",ProbeID,m_ErrCorSeqID,CurSeqLen,MinConf);
-		pBuff = &m_pszConsensusBuff[NewSeqStartOfs];
+			DescrLen = sprintf(szDescrLine,"\n>ecseq%u_%d %d|%d\n",ProbeID,ErrCorSeqID,CurSeqLen,MinConf);
+		pBuff = &pszConsensusBuff[NewSeqStartOfs];
 		memmove(pBuff + DescrLen,pBuff,BuffOfs - NewSeqStartOfs);	// make room for an inserted fasta descriptor line
 		memcpy(pBuff,szDescrLine,DescrLen);
 		BuffOfs += DescrLen;
 		}
 	}
-if(m_ErrCorSeqID)						// ensure that if any sequences were accepted then the last sequence was terminated with a NL
+if(ErrCorSeqID)						// ensure that if any sequences were accepted then the last sequence was terminated with a NL
 	{
-	if(m_pszConsensusBuff[BuffOfs-1] != '\n')
+	if(pszConsensusBuff[BuffOfs-1] != '\n')
 		{
-		m_pszConsensusBuff[BuffOfs] = '\n';
+		pszConsensusBuff[BuffOfs] = '\n';
 		BuffOfs += 1;
 		}
-	m_pszConsensusBuff[BuffOfs] = '\0';
+	pszConsensusBuff[BuffOfs] = '\0';
 	}
 else
 	BuffOfs = 0;
@@ -2127,11 +2599,134 @@ if(State != 0)
 return(0);
 }
 
+// generate consensus sequences for blocks m_pMAFConsProcBatch->pBlocks[StartIdx..EndIdx-1]
+// each block has it's own consensus bases and confidence scores, and it's own region of the batch pszConsSeqs, so blocks can be concurrently processed
+int
+CSSW::MAFConsBlocks(int64_t StartIdx,	// starting from this block
+					int64_t EndIdx,		// until immediately before this block
+					int WorkerIdx)		// processing by this worker
+{
+tsMAFConsBatch *pBatch;
+tsMAFConsBlock *pBlock;
+pBatch = m_pMAFConsProcBatch;
+pBlock = &pBatch->pBlocks[StartIdx];
+for(; StartIdx < EndIdx; StartIdx++, pBlock++)
+	pBlock->ConsSeqLen = ConsConfSeq2Seqs(pBlock->ProbeID,m_MAFConsMinConf,m_MAFConsMinLen,
+										&pBatch->pConfSeqs[pBlock->ConfSeqOfs],&pBatch->pszConsSeqs[pBlock->ConsSeqOfs]);
+return(eBSFSuccess);
+}
+
+// generates consensus sequences for all parsed blocks in batch, distributing blocks over the work pool if more than one thread
+// the generated consensus sequences are then written to m_hConsSeqFile in the same order as the blocks were parsed so output is independent of thread count
+// called on the batch processing thread whilst the main thread continues parsing blocks into the other batch
+int
+CSSW::ProcMAFConsBatch(tsMAFConsBatch *pBatch)	// batch to be processed
+{
+int Rslt;
+uint32_t BlockIdx;
+tsMAFConsBlock *pBlock;
+CWorkPool *pWorkPool;
+
+if(pBatch->NumBlocks == 0)
+	return(eBSFSuccess);
+
+if(pBatch->NumThreads > 1 && pBatch->NumBlocks > 1 && (pWorkPool = CWorkPool::Shared(pBatch->NumThreads)) != NULL)
+	Rslt = pWorkPool->ParallelFor(pBatch->NumBlocks,1,SSWMAFConsBlocks,this,0,NULL,NULL,NULL,pBatch->NumThreads);
+else
+	Rslt = MAFConsBlocks(0,pBatch->NumBlocks,0);
+
+if(Rslt >= eBSFSuccess)
+	{
+	pBlock = pBatch->pBlocks;
+	for(BlockIdx = 0; BlockIdx < pBatch->NumBlocks; BlockIdx++, pBlock++)
+		{
+		if(pBlock->ConsSeqLen > 0 && !CUtility::RetryWrites(m_hConsSeqFile,&pBatch->pszConsSeqs[pBlock->ConsSeqOfs],pBlock->ConsSeqLen))
+			{
+			gDiagnostics.DiagOut(eDLFatal,gszProcName,"ProcMAFConsBatch: Write to consensus sequences file failed - %s",strerror(errno));
+			Rslt = eBSFerrWrite;
+			break;
+			}
+		}
+	}
+return(Rslt);
+}
+
+int		// eBSFSuccess or error as returned from processing of the batch waited on
+CSSW::WaitMAFConsBatch(void)		// wait for completion of any batch currently being processed
+{
+int Rslt;
+tsMAFConsBatch *pBatch;
+
+if((pBatch = m_pMAFConsProcBatch) == NULL)
+	return(eBSFSuccess);
+if(pBatch->bProcessing)
+	{
+#ifdef _WIN32
+	WaitForSingleObject(pBatch->threadHandle, INFINITE);
+	CloseHandle(pBatch->threadHandle);
+#else
+	pthread_join(pBatch->threadID, NULL);
+#endif
+	pBatch->bProcessing = false;
+	}
+Rslt = pBatch->Rslt;
+pBatch->NumBlocks = 0;
+pBatch->NumConfs = 0;
+m_pMAFConsProcBatch = NULL;
+return(Rslt);
+}
+
+int		// eBSFSuccess or error, waits for any batch processing to complete then starts processing of this batch on it's own thread
+CSSW::StartMAFConsBatch(tsMAFConsBatch *pBatch,	// batch to be processed
+						int NumThreads)				// using at most this many threads
+{
+int Rslt;
+if((Rslt = WaitMAFConsBatch()) < eBSFSuccess)
+	return(Rslt);
+if(pBatch->NumBlocks == 0)
+	return(eBSFSuccess);
+
+pBatch->pThis = this;
+pBatch->NumThreads = NumThreads;
+pBatch->Rslt = eBSFSuccess;
+m_pMAFConsProcBatch = pBatch;
+#ifdef _WIN32
+pBatch->threadHandle = (HANDLE)_beginthreadex(NULL, 0x0fffff, SSWMAFConsBatchThread, pBatch, 0, &pBatch->threadID);
+pBatch->bProcessing = pBatch->threadHandle != 0;
+#else
+pBatch->threadRslt = pthread_create(&pBatch->threadID, NULL, SSWMAFConsBatchThread, pBatch);
+pBatch->bProcessing = pBatch->threadRslt == 0;
+#endif
+if(!pBatch->bProcessing)		// unable to start batch processing thread so process on this thread
+	pBatch->Rslt = ProcMAFConsBatch(pBatch);
+return(eBSFSuccess);
+}
+
+void
+CSSW::FreeMAFConsBatches(void)		// release memory allocated to batches, any batch processing thread must have been joined
+{
+int BatchIdx;
+tsMAFConsBatch *pBatch;
+pBatch = m_MAFConsBatches;
+for(BatchIdx = 0; BatchIdx < 2; BatchIdx++, pBatch++)
+	{
+	if(pBatch->pBlocks != NULL)
+		delete []pBatch->pBlocks;
+	if(pBatch->pConfSeqs != NULL)
+		delete []pBatch->pConfSeqs;
+	if(pBatch->pszConsSeqs != NULL)
+		delete []pBatch->pszConsSeqs;
+	memset(pBatch,0,sizeof(tsMAFConsBatch));
+	}
+m_pMAFConsProcBatch = NULL;
+}
+
 int
 CSSW::GenConsensusFromMAF(int MinErrCorrectLen,		// error corrected sequences must be at least this minimum length
 			 int MinConcScore,			// error corrected sequences trimmed until mean m_ConfWin concensus score is at least this threshold
 			char *pszErrCorFile,		// name of file into which write error corrected sequences
-			char *pszMultiAlignFile)	// name of file containing multiple alignments to process
+			char *pszMultiAlignFile,	// name of file containing multiple alignments to process
+			int NumThreads)				// generate consensus sequences for batched multiple alignment blocks using at most this many threads
 {
 int Rslt;
 uint32_t CurProbeID;
@@ -2139,7 +2734,10 @@ int BuffCnt;
 int BuffTopUp;
 bool bCpltdReadMAF;
 uint32_t NumParsedBlocks;
-int ConsSeqLen;
+int BatchRslt;
+int BatchIdx;
+tsMAFConsBatch *pBatch;
+tsMAFConsBlock *pBlock;
 
 m_AllocMAFAlignBuffSize = min((uint32_t)0x7ff00000,cMaxMAFBlockLen * 5u);
 if(m_pszMAFAlignBuff == NULL)
@@ -2155,15 +2753,36 @@ m_MAFAlignBuffIdx = 0;
 m_MAFFileOfs = 0;
 bCpltdReadMAF = false;
 
-if(m_pszConsensusBuff == NULL)
+// two batches are allocated, one is parsed into whilst the other is being processed
+// consensus sequences for a batch are buffered in per block regions of at least 2x the block consensus bases plus 200 chars
+WaitMAFConsBatch();
+pBatch = m_MAFConsBatches;
+for(BatchIdx = 0; BatchIdx < 2; BatchIdx++, pBatch++)
 	{
-	if((m_pszConsensusBuff = new char [cMaxMAFBlockErrCorLen])==NULL)
+	if(pBatch->pBlocks == NULL && (pBatch->pBlocks = new tsMAFConsBlock [cMaxMAFConsBatchBlocks])==NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to allocate memory for multialignment block batching");
+		Reset();
+		return(eBSFerrMem);
+		}
+	if(pBatch->pConfSeqs == NULL && (pBatch->pConfSeqs = new tsConfBase [cMaxMAFConsBatchConfs])==NULL)
+		{
+		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to allocate memory for batched consensus confidence + bases buffering");
+		Reset();
+		return(eBSFerrMem);
+		}
+	if(pBatch->pszConsSeqs == NULL && (pBatch->pszConsSeqs = new char [((size_t)cMaxMAFConsBatchConfs * 2) + ((size_t)cMaxMAFConsBatchBlocks * 200)])==NULL)
 		{
 		gDiagnostics.DiagOut(eDLFatal,gszProcName,"Unable to allocate memory for consensus sequence buffering");
 		Reset();
 		return(eBSFerrMem);
 		}
+	pBatch->NumBlocks = 0;
+	pBatch->NumConfs = 0;
 	}
+pBatch = m_MAFConsBatches;		// initially parsing into the first batch
+m_MAFConsMinConf = MinConcScore;
+m_MAFConsMinLen = MinErrCorrectLen;
 
 if(m_pConsConfSeq == NULL)
 	{
@@ -2293,18 +2912,37 @@ do {
 	if(Rslt == 0)
 		continue;
 
-	// have consensus confidence scores and consensus bases - can now apply new MinConcScore threshold
-	ConsSeqLen =			// total number of returned chars in m_pszConsensusBuff for the textual representation of error corrected consensus sequence (could be multiple consensus sequences)
-		ConsConfSeq2Seqs(CurProbeID,				// identifies sequence which was used as the probe when determining the multialignments
-					     MinConcScore,				// sequence bases averaged over a m_ConfWin window must be of at least this confidence (0..9) with the initial and final bases having at least this confidence
-						 MinErrCorrectLen);			// and sequence lengths must be of at least this length 
-
-	if(ConsSeqLen > 0)
-		CUtility::RetryWrites(m_hConsSeqFile,m_pszConsensusBuff,ConsSeqLen);
+	// have consensus confidence scores and consensus bases - add to batch being parsed into, applying new MinConcScore threshold is deferred until batch is full
+	// full batches are handed to a batch processing thread and parsing continues into the other batch whilst the full batch is processed and written
+	if(pBatch->NumBlocks == cMaxMAFConsBatchBlocks || (pBatch->NumConfs + Rslt + 1) > cMaxMAFConsBatchConfs)
+		{
+		if((BatchRslt = StartMAFConsBatch(pBatch,NumThreads)) < eBSFSuccess)	// Rslt must be retained as it's the number of consensus bases in the block just parsed
+			{
+			Rslt = BatchRslt;
+			break;
+			}
+		pBatch = pBatch == &m_MAFConsBatches[0] ? &m_MAFConsBatches[1] : &m_MAFConsBatches[0];	// StartMAFConsBatch() waited for the other batch to be processed so it's available
+		}
+	pBlock = &pBatch->pBlocks[pBatch->NumBlocks];
+	pBlock->ProbeID = CurProbeID;
+	pBlock->ConfSeqOfs = pBatch->NumConfs;
+	pBlock->ConsSeqOfs = (pBatch->NumConfs * 2) + (pBatch->NumBlocks * 200);
+	pBlock->ConsSeqLen = 0;
+	memcpy(&pBatch->pConfSeqs[pBatch->NumConfs],m_pConsConfSeq,sizeof(tsConfBase) * (Rslt + 1));	// copying the eBaseEOS terminator also
+	pBatch->NumConfs += Rslt + 1;
+	pBatch->NumBlocks += 1;
 	NumParsedBlocks += 1;
 	}
 while(Rslt >= 0);
 
+if(Rslt >= 0)		// process any remaining partial batch
+	Rslt = StartMAFConsBatch(pBatch,NumThreads);
+BatchRslt = WaitMAFConsBatch();		// must always wait for batch processing to complete before consensus sequences file is closed
+if(Rslt >= 0)
+	Rslt = BatchRslt;
+pBatch->NumBlocks = 0;
+pBatch->NumConfs = 0;
+
 if(m_hConsSeqFile != -1)
 	{
 #ifdef _WIN32
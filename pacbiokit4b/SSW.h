@@ -29,11 +29,21 @@ const int cMinNumExactMatches = 100;     // default is only consider a path as b
 
 const int cMaxTopNPeakMatches = 100;     // can process for at most this many peak matches in any probe vs target SW alignment
 
+const int cSSWDfltPrefilterPct = 10;	// default score-only prefilter threshold as a percentage of the score for an exactly matching overlap of minimum overlap length
+const int cSSWMaxPrefilterPct = 100;	// prefilter threshold percentage can be specified up to this maximum
+
+const int cSSWMaxAnchors = 100;			// banded alignments are guided by a chain of at most this many anchors
+const int cSSWMinBandWidth = 50;		// band can be specified as extending down to this many bp either side of the anchor diagonals
+const int cSSWMaxBandWidth = 5000;		// and up to this many bp
+const int cSSWBandDriftPct = 15;		// before the first or after the last anchor the band is widened by this percentage of the distance from that anchor, at most doubling the band
+
 const int cDfltConfWind = 50;			// default confidence window is this length
 const int cMaxConfWindSize = 200;		// allowing confidence window length to be at most this length
 
 const uint32_t cMaxMAFBlockErrCorLen = cSSWMaxProbeOrTargLen/50;	// allowing for error corrected read sequences of up to this length
 const uint32_t cMaxMAFBlockLen = (cMaxMAFBlockErrCorLen * 100);	// allowing for multialignment format block buffering of up to this length
+const uint32_t cMaxMAFConsBatchBlocks = 4096;					// parsed multialignment blocks are batched for parallel consensus sequence generation, at most this many blocks per batch
+const uint32_t cMaxMAFConsBatchConfs = (cMaxMAFBlockErrCorLen * 4);	// and at most this many parsed consensus bases and confidence scores per batch
 
 const int cMaxProbeSWs = 200;							// explore with SW at most this many probe alignments against target sequences
 const int cMaxConsolidateProbeSWs = 10000;				// when processing for transcripts then allow for many more probe alignments
@@ -59,6 +69,7 @@ typedef enum TAG_eSWMethod {
 	eSWMGenMultialignConcensus,	// GenMultialignConcensus
 	eSWMMAlignCols2fasta,		// MAlignCols2fasta
 	eSWMMAlignCols2MFA,			// MAlignCols2MFA
+	eSWMCombinedTargAligns,		// batched eSWMCombinedTargAlign, optionally setting probe, processing multiple targets in a single request until a coverage limit is reached
 	eSWMPlaceHolder,			// used to mark range of methods
 	} teSWMethod;
 
@@ -176,6 +187,32 @@ typedef struct TAG_sConfBase {   // associating consensus base with correspondin
 	uint8_t Conf;		// confidence in base
 } tsConfBase;
 
+typedef struct TAG_sMAFConsBlock {	// parsed multialignment block in a batch of blocks being processed for consensus sequences
+	uint32_t ProbeID;			// block was for this probe sequence
+	uint32_t ConfSeqOfs;		// block consensus bases and confidence scores start at this offset in batch pConfSeqs, terminated by eBaseEOS
+	uint32_t ConsSeqOfs;		// generated consensus sequences start at this offset in batch pszConsSeqs
+	int ConsSeqLen;				// generated consensus sequences total this many chars
+} tsMAFConsBlock;
+
+typedef struct TAG_sMAFConsBatch {	// batch of parsed multialignment blocks, whilst one batch is being processed on it's own thread the next batch is being parsed
+	class CSSW *pThis;			// batch is processed by this instance
+	int NumThreads;				// using at most this many threads
+	int Rslt;					// batch processing result
+	bool bProcessing;			// true if batch processing thread was started and has yet to be joined
+	uint32_t NumBlocks;			// number of parsed blocks in this batch
+	uint32_t NumConfs;			// number of consensus bases and confidence scores, including eBaseEOS terminators, in this batch
+	tsMAFConsBlock *pBlocks;	// allocated to hold cMaxMAFConsBatchBlocks parsed blocks
+	tsConfBase *pConfSeqs;		// allocated to hold cMaxMAFConsBatchConfs consensus bases and confidence scores
+	char *pszConsSeqs;			// allocated to hold generated consensus sequences, each block has a region of 2x it's consensus bases plus 200 chars
+#ifdef _WIN32
+	HANDLE threadHandle;		// handle as returned by _beginthreadex()
+	unsigned int threadID;		// identifier as set by _beginthreadex()
+#else
+	int threadRslt;				// result as returned by pthread_create ()
+	pthread_t threadID;			// identifier as set by pthread_create ()
+#endif
+} tsMAFConsBatch;
+
 
 const int cTraceBackWin = 500;					// maintaining traceback window of this size when attempting to classify paths
 typedef struct TAG_sTraceBackScore {
@@ -183,6 +220,11 @@ typedef struct TAG_sTraceBackScore {
 	int Score;									// was this accumulated score
 } tsTraceBackScore;
 
+typedef struct TAG_sSSWAnchor {
+	uint32_t ProbeOfs;			// anchor at this probe sequence offset
+	uint32_t TargOfs;			// aligning to this target sequence offset
+} tsSSWAnchor;
+
 typedef struct TAG_sCombinedTargAlignPars {
 	uint8_t PMode;				// processing mode: 0 error correct , 1 generate consensus from previously generated multiple alignments, 2  generate overlap detail from previously generated consensus sequences
 	uint32_t NumTargSeqs;			// current probe is putatively overlaying this many targets
@@ -198,6 +240,9 @@ typedef struct TAG_sCombinedTargAlignPars {
 	uint8_t TargFlags;		    // bit 7 set if target loaded as a high confidence sequence, bits 0..3 is weighting factor to apply when generating consensus bases
 	uint32_t TargSeqLen;			// target sequence length
 	etSeqBase *pTargSeq;		// target sequence
+	uint32_t BandWidth;			// if non-zero, and NumAnchors > 0, then alignment is banded to this many bp either side of the anchor diagonals
+	uint32_t NumAnchors;			// number of anchors in Anchors[]
+	tsSSWAnchor Anchors[cSSWMaxAnchors];	// chain of anchors, ascending probe and target offsets, guiding a banded alignment
 } tsCombinedTargAlignPars;
 
 typedef struct TAG_sCombinedTargAlignRet {
@@ -263,6 +308,25 @@ class CSSW
 	size_t m_AllocdMAAlignOpsSize;		// total current allocation size for alignment operators  
 	tMAOp *m_pMAAlignOps;			// remapped from tracebacks the alignment operators used when merging multiple alignments into a consensus sequence
 
+	int m_PrefilterPct;				// if non-zero then score-only prefilter threshold as a percentage of the score for an exactly matching overlap of minimum overlap length
+	uint32_t m_PrefilterBuffSize;	// m_pPrefilterBuff allocated to hold this many bytes
+	uint8_t *m_pPrefilterBuff;		// allocated to hold striped query profile, H and E scores used by the score-only prefilter
+
+	uint32_t m_BandWidth;			// if non-zero, and m_NumAnchors > 0, then Align() only processes cells within this many bp either side of the anchor diagonals
+	uint32_t m_BandMaxRowCells;		// banded probe rows span at most this many target cells
+	uint32_t m_NumAnchors;			// number of anchors in m_Anchors[]
+	tsSSWAnchor m_Anchors[cSSWMaxAnchors];	// chain of anchors guiding banded alignments
+
+	void BandLimits(uint32_t IdxP,				// determine the band for this probe relative row
+					uint32_t TargRelLen,		// clamping to this target relative length
+					uint32_t *pAnchorIdx,		// current anchor, rows are processed in ascending order so anchors are iterated
+					uint32_t *pStartIdxT,		// returned target relative start of band
+					uint32_t *pEndIdxT);		// returned target relative end of band (exclusive)
+
+	int32_t											// peak score, saturates at 0x7fff, or -1 if errors
+		PrefilterScore(uint32_t ProbeRelLen,		// score-only local alignment of this probe relative length starting from m_ProbeStartRelOfs
+					uint32_t TargRelLen);			// against this target relative length starting from m_TargStartRelOfs
+
 	int m_MinNumExactMatches;		// peak matches must contain at least this many exact matches to qualify as a peak match
 	tsSSWCell m_PeakMatchesCell;	// cell identified as path containing highest number of matches 
 	tsSSWCell m_PeakScoreCell;		// cell identified as usual SW peak scoring as conventional in most SW scoring schemes
@@ -301,7 +365,19 @@ class CSSW
 	uint32_t m_AllocMAFAlignBuffSize;	// m_pszMAFAlignBlock allocated to hold this many chars
 	char *m_pszMAFAlignBuff;		// allocated to buffer the MAF alignment blocks whilst parsing
 	tsConfBase *m_pConsConfSeq;		// allocated to hold the parsed consensus bases and consensus confidence scores
-	char *m_pszConsensusBuff;		// allocated to buffer the generated consensus sequence
+	int m_MAFConsMinConf;			// batched blocks consensus sequences must be of at least this confidence
+	int m_MAFConsMinLen;			// and at least this length
+	tsMAFConsBatch m_MAFConsBatches[2];	// double buffered batches, one batch is parsed into whilst the other is being processed
+	tsMAFConsBatch *m_pMAFConsProcBatch;	// batch currently being processed, NULL if none
+
+	void FreeMAFConsBatches(void);			// release memory allocated to batches, any batch processing thread must have been joined
+
+	int		// eBSFSuccess or error, waits for any batch processing to complete then starts processing of this batch on it's own thread
+			StartMAFConsBatch(tsMAFConsBatch *pBatch,	// batch to be processed
+							int NumThreads);			// using at most this many threads
+
+	int		// eBSFSuccess or error as returned from processing of the batch waited on
+			WaitMAFConsBatch(void);			// wait for completion of any batch currently being processed
 
 	int    // parse out the next multialignment block consensus bases and consensus confidence scores into m_pConsConfSeq
 			ParseConsConfSeq(bool bCpltdReadMAF,	// true if m_pConsConfSeq contains all remaining multialignment blocks loaded from file 
@@ -311,7 +387,9 @@ class CSSW
 	int    // total number of returned chars in pszBuffer for the textual representation of error corrected consensus sequence (could be multiple consensus sequences)
 		ConsConfSeq2Seqs(uint32_t ProbeID,	// identifies sequence which was used as the probe when determining the multialignments
 				  int MinConf,				// sequence bases averaged over a 100bp window must be of at least this confidence (0..9) with the initial and final bases having at least this confidence
-				  int MinLen);				// and sequence lengths must be of at least this length 
+				  int MinLen,				// and sequence lengths must be of at least this length 
+				  tsConfBase *pConsConfSeq,	// parsed consensus bases and confidence scores, terminated by eBaseEOS
+				  char *pszConsensusBuff);	// write consensus sequences into this buffer, must be sized to hold at least 2x the number of parsed consensus bases plus 200 chars
 
 	uint64_t	MSBBitMsk(uint64_t BitsSet);			// get bit mask of most significant bit set in BitsSet
 	uint64_t	NSBBitMsk(int Nth,uint64_t BitsSet);	// get bit mask of Nth (1 if MSB) significant bit set in BitsSet
@@ -378,9 +456,16 @@ public:
 						uint32_t m_ProbeRelLen = 0,	// and SW with this probe relative length starting from m_ProbeStartRelOfs - if 0 then until end of probe sequence
 						uint32_t m_TargRelLen = 0);	// and SW with this target relative length starting from m_TargStartRelOfs - if 0 then until end of target sequence
 
+	bool SetPrefilterPct(int PrefilterPct = cSSWDfltPrefilterPct);	// score-only prefilter threshold as a percentage (0 to disable) of the score for an exactly matching overlap of minimum overlap length
+
+	bool SetAnchorBand(uint32_t BandWidth,			// subsequent alignments banded to this many bp either side of the anchor diagonals, 0 to disable banding
+					uint32_t NumAnchors = 0,		// number of anchors in chain, 0 to disable banding
+					tsSSWAnchor *pAnchors = NULL);	// chain of anchors, ascending probe and target offsets
+
 	tsSSWCell *										// smith-waterman style local alignment, returns highest accumulated exact matches scoring cell
 				Align(tsSSWCell *pPeakScoreCell = NULL,	// optionally also return conventional peak scoring cell
-						uint32_t MaxOverlapLen = 0);		// process tracebacks for this maximal expected overlap, 0 if no tracebacks required
+						uint32_t MaxOverlapLen = 0,		// process tracebacks for this maximal expected overlap, 0 if no tracebacks required
+						uint32_t MinOverlapLen = 0);	// if non-zero then prefilter with a score-only alignment, full alignment only if prefilter score could be from an overlap of at least this length
 
 	double											// parsimony of multiple alignment, 0 (min) to 1.0 (max) 
 		ParsimoniousMultialign( int Depth,			// parsimony for this number of bases in each column
@@ -483,7 +568,12 @@ public:
 		GenConsensusFromMAF(int MinErrCorrectLen,	// error corrected sequences must be at least this minimum length
 				 int MinConcScore,			// error corrected sequences trimmed until mean 100bp concensus score is at least this threshold
 				char *pszErrCorFile,		// name of file into which write error corrected sequences
-				char *pszMultiAlignFile);	// name of file containing multiple alignments to process
+				char *pszMultiAlignFile,	// name of file containing multiple alignments to process
+				int NumThreads = 1);		// generate consensus sequences for batched multiple alignment blocks using at most this many threads
+
+	// batch and work pool processing, public only so accessible to the thread functions
+	int ProcMAFConsBatch(tsMAFConsBatch *pBatch);	// generates consensus sequences for all blocks in batch then writes these in parsed order to m_hConsSeqFile
+	int MAFConsBlocks(int64_t StartIdx, int64_t EndIdx, int WorkerIdx);	// generate consensus sequences for blocks m_pMAFConsProcBatch->pBlocks[StartIdx..EndIdx-1]
 
 	int      // total number of returned chars in pszBuffer for the textual representation of the multialignment 
 		MAlignCols2MFA( uint32_t ProbeID,		// identifies sequence which was used as the probe when determining the multialignments
@@ -218,7 +218,12 @@ for(Idx = 1; Idx < argc; Idx++)
 	}
 
 if(SubProcID > 0)
+	{
+	CRunProfile::EnableFromEnv(gszProcName,(char *)SubProcesses[SubProcID-1].pszName);	// profiling if requested through the environment
 	Rslt = ExecSubProcess(SubProcID,argc,(char **)argv);
+	CRunProfile::Report();
+	CWorkPool::ReleaseShared();		// subprocesses may have started the shared work pool threads
+	}
 else
 	{
 	GiveHelpSubProcesses((char *)cpszProcOverview);